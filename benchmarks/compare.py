@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+'''
+    Compare two maix_bench json results and report regressions.
+    Usage: python compare.py base.json new.json [--threshold 10] [--metric p50]
+    Exit code is 1 if any case slower than threshold percent.
+'''
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, "r") as f:
+        data = json.load(f)
+    results = {}
+    for r in data["results"]:
+        results[r["name"]] = r
+    return data, results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare maix_bench results")
+    parser.add_argument("base", help="baseline result json")
+    parser.add_argument("new", help="new result json")
+    parser.add_argument("--threshold", type=float, default=10, help="regression threshold in percent, default 10")
+    parser.add_argument("--metric", default="p50", choices=["min", "mean", "p50", "p90", "p99", "max"], help="metric to compare, default p50")
+    args = parser.parse_args()
+
+    base_info, base = load(args.base)
+    new_info, new = load(args.new)
+    print("base: {} {} {}".format(base_info.get("version"), base_info.get("git_commit"), base_info.get("platform")))
+    print("new : {} {} {}".format(new_info.get("version"), new_info.get("git_commit"), new_info.get("platform")))
+    print("")
+    print("{:<56} {:>14} {:>14} {:>9}".format("case", "base(us)", "new(us)", "change"))
+    regressions = []
+    for name, n in new.items():
+        b = base.get(name)
+        if not b or "skipped" in b or "skipped" in n:
+            continue
+        vb = b[args.metric] / 1000
+        vn = n[args.metric] / 1000
+        change = (vn - vb) / vb * 100 if vb > 0 else 0
+        mark = ""
+        if change > args.threshold:
+            mark = " <-- regression"
+            regressions.append(name)
+        print("{:<56} {:>14.3f} {:>14.3f} {:>8.1f}%{}".format(name, vb, vn, change, mark))
+    missing = [name for name in base if name not in new]
+    if missing:
+        print("")
+        print("cases not in new result: {}".format(", ".join(missing)))
+    print("")
+    if regressions:
+        print("{} regression(s) over {}%".format(len(regressions), args.threshold))
+        sys.exit(1)
+    print("no regression over {}%".format(args.threshold))
+
+
+if __name__ == "__main__":
+    main()
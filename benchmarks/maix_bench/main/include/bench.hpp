@@ -0,0 +1,104 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+namespace bench
+{
+    /**
+     * Benchmark options, parsed from command line
+     */
+    struct Options
+    {
+        int iterations = 30;        // samples per case
+        int warmup = 3;             // not recorded iterations before sampling
+        uint64_t min_sample_ns = 20000; // repeat fast functions in one sample until reach this time
+        std::string filter;         // only run cases which name contains this string
+        std::string out_path;       // json output path, empty means stdout
+        std::string fixtures_dir;   // directory with fixture files, e.g. qrcode.jpg
+        std::string model_path;     // yolo11 model for nn cases
+        bool list = false;          // only list case names
+    };
+
+    /**
+     * One case result, times are nanoseconds per operation
+     */
+    struct Result
+    {
+        std::string name;
+        std::string skipped;        // not empty means case skipped, with reason
+        int iterations = 0;
+        int inner = 1;              // operations per sample
+        double min = 0;
+        double mean = 0;
+        double stddev = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+        uint64_t bytes = 0;         // bytes processed per operation, for throughput
+    };
+
+    class Runner
+    {
+    public:
+        Runner(const Options &opts);
+
+        /**
+         * Measure func, func runs once per operation.
+         * @param name case name, dot separated, e.g. image.resize.1080p_vga
+         * @param func function to measure
+         * @param bytes bytes processed per operation, 0 means no throughput output
+         */
+        void measure(const std::string &name, std::function<void()> func, uint64_t bytes = 0);
+
+        /**
+         * Record a skipped case
+         */
+        void skip(const std::string &name, const std::string &reason);
+
+        /**
+         * Whether case should run according to filter
+         */
+        bool enabled(const std::string &name);
+
+        const Options &options() const { return _opts; }
+        const std::vector<Result> &results() const { return _results; }
+
+        /**
+         * Dump results as json
+         */
+        std::string to_json();
+
+    private:
+        Options _opts;
+        std::vector<Result> _results;
+    };
+
+    uint64_t now_ns();
+
+    /**
+     * Prevent compiler from optimizing away the value
+     */
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // case groups, defined in bench_*.cpp
+    void run_basic(Runner &r);
+    void run_image(Runner &r);
+    void run_find(Runner &r);
+    void run_nn(Runner &r);
+    void run_tracker(Runner &r);
+} // namespace bench
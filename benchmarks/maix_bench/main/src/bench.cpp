@@ -0,0 +1,172 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+namespace bench
+{
+    uint64_t now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    Runner::Runner(const Options &opts)
+        : _opts(opts)
+    {
+    }
+
+    bool Runner::enabled(const std::string &name)
+    {
+        return _opts.filter.empty() || name.find(_opts.filter) != std::string::npos;
+    }
+
+    void Runner::skip(const std::string &name, const std::string &reason)
+    {
+        if (!enabled(name))
+            return;
+        if (_opts.list)
+        {
+            printf("%s (skipped: %s)\n", name.c_str(), reason.c_str());
+            return;
+        }
+        Result res;
+        res.name = name;
+        res.skipped = reason;
+        _results.push_back(res);
+        maix::log::warn("%-48s skipped: %s", name.c_str(), reason.c_str());
+    }
+
+    void Runner::measure(const std::string &name, std::function<void()> func, uint64_t bytes)
+    {
+        if (!enabled(name))
+            return;
+        if (_opts.list)
+        {
+            printf("%s\n", name.c_str());
+            return;
+        }
+        Result res;
+        res.name = name;
+        res.bytes = bytes;
+        try
+        {
+            // warmup, and calibrate inner loop count for fast functions
+            uint64_t t = now_ns();
+            func();
+            uint64_t first = now_ns() - t;
+            for (int i = 1; i < _opts.warmup; ++i)
+                func();
+            if (first < _opts.min_sample_ns)
+                res.inner = (int)std::min<uint64_t>(_opts.min_sample_ns / std::max<uint64_t>(first, 1), 100000);
+
+            std::vector<double> samples;
+            samples.reserve(_opts.iterations);
+            for (int i = 0; i < _opts.iterations; ++i)
+            {
+                t = now_ns();
+                for (int j = 0; j < res.inner; ++j)
+                    func();
+                samples.push_back((now_ns() - t) / (double)res.inner);
+                if (maix::app::need_exit())
+                    break;
+            }
+            if (samples.empty())
+                return;
+            std::sort(samples.begin(), samples.end());
+            auto pct = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)(samples.size() * p))]; };
+            double sum = 0;
+            for (double v : samples)
+                sum += v;
+            res.iterations = samples.size();
+            res.mean = sum / samples.size();
+            double var = 0;
+            for (double v : samples)
+                var += (v - res.mean) * (v - res.mean);
+            res.stddev = std::sqrt(var / samples.size());
+            res.min = samples.front();
+            res.max = samples.back();
+            res.p50 = pct(0.5);
+            res.p90 = pct(0.9);
+            res.p99 = pct(0.99);
+        }
+        catch (const std::exception &e)
+        {
+            skip(name, std::string("exception: ") + e.what());
+            return;
+        }
+        _results.push_back(res);
+        if (bytes)
+            maix::log::info("%-48s p50 %10.3f us, p99 %10.3f us, %8.2f MB/s", name.c_str(), res.p50 / 1000, res.p99 / 1000, bytes / (res.p50 / 1e9) / 1e6);
+        else
+            maix::log::info("%-48s p50 %10.3f us, p99 %10.3f us", name.c_str(), res.p50 / 1000, res.p99 / 1000);
+    }
+
+    static std::string _escape(const std::string &s)
+    {
+        std::string res;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                res.push_back('\\');
+            if ((unsigned char)c < 0x20)
+                continue;
+            res.push_back(c);
+        }
+        return res;
+    }
+
+    std::string Runner::to_json()
+    {
+        const char *platform =
+#if PLATFORM_MAIXCAM2
+            "maixcam2";
+#elif PLATFORM_MAIXCAM
+            "maixcam";
+#else
+            "linux";
+#endif
+        char buf[512];
+        std::string json = "{\n";
+        snprintf(buf, sizeof(buf), "  \"version\": \"%d.%d.%d\",\n  \"git_commit\": \"%s\",\n  \"platform\": \"%s\",\n  \"time\": %llu,\n",
+                 BUILD_VERSION_MAJOR, BUILD_VERSION_MINOR, BUILD_VERSION_MICRO, BUILD_GIT_COMMIT_ID, platform,
+                 (unsigned long long)maix::time::time_s());
+        json += buf;
+        snprintf(buf, sizeof(buf), "  \"unit\": \"ns\",\n  \"iterations\": %d,\n  \"results\": [\n", _opts.iterations);
+        json += buf;
+        for (size_t i = 0; i < _results.size(); ++i)
+        {
+            const Result &r = _results[i];
+            if (!r.skipped.empty())
+            {
+                json += "    {\"name\": \"" + _escape(r.name) + "\", \"skipped\": \"" + _escape(r.skipped) + "\"}";
+            }
+            else
+            {
+                snprintf(buf, sizeof(buf),
+                         "    {\"name\": \"%s\", \"iterations\": %d, \"inner\": %d, \"min\": %.1f, \"mean\": %.1f, \"stddev\": %.1f, "
+                         "\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f",
+                         _escape(r.name).c_str(), r.iterations, r.inner, r.min, r.mean, r.stddev, r.p50, r.p90, r.p99, r.max);
+                json += buf;
+                if (r.bytes)
+                {
+                    snprintf(buf, sizeof(buf), ", \"bytes\": %llu, \"mb_per_s\": %.2f", (unsigned long long)r.bytes, r.bytes / (r.p50 / 1e9) / 1e6);
+                    json += buf;
+                }
+                json += "}";
+            }
+            json += i + 1 < _results.size() ? ",\n" : "\n";
+        }
+        json += "  ]\n}\n";
+        return json;
+    }
+} // namespace bench
@@ -0,0 +1,58 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+
+using namespace maix;
+
+namespace bench
+{
+    static void fill_random(uint8_t *data, size_t len, uint32_t seed)
+    {
+        for (size_t i = 0; i < len; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            data[i] = (uint8_t)(seed >> 16);
+        }
+    }
+
+    void run_basic(Runner &r)
+    {
+        // protocol crc
+        for (size_t len : {64, 4096, 65536})
+        {
+            std::vector<uint8_t> buf(len);
+            fill_random(buf.data(), len, 1);
+            r.measure("protocol.crc16_IBM." + std::to_string(len), [&]() {
+                uint16_t crc = protocol::crc16_IBM(buf.data(), buf.size());
+                do_not_optimize(crc);
+            }, len);
+        }
+
+        // tensor topk, classifier(1000) and llm vocab(151936) sizes
+        for (int n : {1000, 151936})
+        {
+            tensor::Tensor t({n}, tensor::DType::FLOAT32);
+            float *data = (float *)t.data();
+            uint32_t seed = 7;
+            for (int i = 0; i < n; ++i)
+            {
+                seed = seed * 1103515245 + 12345;
+                data[i] = (seed >> 8) / (float)(1 << 24);
+            }
+            for (int k : {5, 50})
+            {
+                r.measure("tensor.topk." + std::to_string(n) + ".k" + std::to_string(k), [&]() {
+                    auto res = t.topk(k);
+                    delete std::get<0>(res);
+                    delete std::get<1>(res);
+                }, n * sizeof(float));
+            }
+        }
+    }
+} // namespace bench
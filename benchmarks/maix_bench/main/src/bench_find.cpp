@@ -0,0 +1,80 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+
+using namespace maix;
+
+namespace bench
+{
+    image::Image *synthetic_rgb(int w, int h);
+
+    /**
+     * Load fixture image from fixtures dir and resize to w x h,
+     * return NULL if fixtures dir not set or file not exists.
+     */
+    static image::Image *load_fixture(Runner &r, const std::string &name, int w, int h)
+    {
+        if (r.options().fixtures_dir.empty())
+            return NULL;
+        std::string path = r.options().fixtures_dir + "/" + name;
+        if (!fs::exists(path))
+            return NULL;
+        image::Image *img = image::load(path, image::Format::FMT_RGB888);
+        if (!img)
+            return NULL;
+        if (img->width() == w && img->height() == h)
+            return img;
+        image::Image *resized = img->resize(w, h, image::Fit::FIT_FILL, image::ResizeMethod::BILINEAR);
+        delete img;
+        return resized;
+    }
+
+    void run_find(Runner &r)
+    {
+        // find_blobs, synthetic image has red and green rectangles
+        image::Image *img_vga = synthetic_rgb(640, 480);
+        std::vector<std::vector<int>> thresholds = {{0, 80, 40, 80, 10, 80}, {0, 80, -120, -10, 0, 30}};
+        r.measure("image.find_blobs.vga.2_thresholds", [&]() {
+            auto blobs = img_vga->find_blobs(thresholds, false, {}, 2, 1, 100, 100);
+            do_not_optimize(blobs.size());
+        }, 640 * 480 * 3);
+        r.measure("image.find_blobs.vga.2_thresholds.merge", [&]() {
+            auto blobs = img_vga->find_blobs(thresholds, false, {}, 2, 1, 100, 100, true);
+            do_not_optimize(blobs.size());
+        }, 640 * 480 * 3);
+        delete img_vga;
+
+        // apriltags, use fixture if provided, else measure the full frame search without tags
+        image::Image *tag_img = load_fixture(r, "apriltag.jpg", 320, 240);
+        std::string tag_case = tag_img ? "image.find_apriltags.qvga.fixture" : "image.find_apriltags.qvga.no_tag";
+        if (!tag_img)
+            tag_img = synthetic_rgb(320, 240);
+        r.measure(tag_case, [&]() {
+            auto tags = tag_img->find_apriltags();
+            do_not_optimize(tags.size());
+        });
+        delete tag_img;
+
+        // qrcodes
+        image::Image *qr_img = load_fixture(r, "qrcode.jpg", 640, 480);
+        std::string qr_case = qr_img ? "image.find_qrcodes.vga.fixture" : "image.find_qrcodes.vga.no_code";
+        if (!qr_img)
+            qr_img = synthetic_rgb(640, 480);
+        r.measure(qr_case + ".zbar", [&]() {
+            auto codes = qr_img->find_qrcodes({}, image::QRCodeDecoderType::QRCODE_DECODER_TYPE_ZBAR);
+            do_not_optimize(codes.size());
+        });
+        r.measure(qr_case + ".quirc", [&]() {
+            auto codes = qr_img->find_qrcodes({}, image::QRCodeDecoderType::QRCODE_DECODER_TYPE_QUIRC);
+            do_not_optimize(codes.size());
+        });
+        delete qr_img;
+    }
+} // namespace bench
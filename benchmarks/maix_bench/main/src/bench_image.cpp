@@ -0,0 +1,125 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+
+using namespace maix;
+
+namespace bench
+{
+    /**
+     * Synthetic RGB888 frame: gradient background, noise and some solid rectangles,
+     * so that resize, jpeg and find_blobs have realistic work to do.
+     */
+    image::Image *synthetic_rgb(int w, int h)
+    {
+        image::Image *img = new image::Image(w, h, image::Format::FMT_RGB888);
+        uint8_t *p = (uint8_t *)img->data();
+        uint32_t seed = 12345;
+        for (int y = 0; y < h; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                seed = seed * 1103515245 + 12345;
+                uint8_t noise = (seed >> 16) & 0x0f;
+                p[0] = (uint8_t)(x * 255 / w) + noise;
+                p[1] = (uint8_t)(y * 255 / h) + noise;
+                p[2] = (uint8_t)((x + y) * 127 / (w + h)) + noise;
+                p += 3;
+            }
+        }
+        int rw = w / 12, rh = h / 10;
+        for (int i = 0; i < 8; ++i)
+        {
+            int x = (i * 2 + 1) * w / 17;
+            int y = (i % 3 + 1) * h / 5;
+            img->draw_rect(x, y, rw, rh, i % 2 ? image::COLOR_RED : image::COLOR_GREEN, -1);
+        }
+        return img;
+    }
+
+    void run_image(Runner &r)
+    {
+        image::Image *img_1080p = synthetic_rgb(1920, 1080);
+        image::Image *img_vga = synthetic_rgb(640, 480);
+        size_t size_1080p = 1920 * 1080 * 3;
+
+        // resize
+        r.measure("image.resize.1080p_to_vga.nearest", [&]() {
+            delete img_1080p->resize(640, 480, image::Fit::FIT_FILL, image::ResizeMethod::NEAREST);
+        }, size_1080p);
+        r.measure("image.resize.1080p_to_vga.bilinear", [&]() {
+            delete img_1080p->resize(640, 480, image::Fit::FIT_FILL, image::ResizeMethod::BILINEAR);
+        }, size_1080p);
+        r.measure("image.resize.1080p_to_320x224.contain", [&]() {
+            delete img_1080p->resize(320, 224, image::Fit::FIT_CONTAIN, image::ResizeMethod::BILINEAR);
+        }, size_1080p);
+
+        // format convert
+        struct
+        {
+            const char *name;
+            image::Format fmt;
+        } fmts[] = {
+            {"grayscale", image::Format::FMT_GRAYSCALE},
+            {"bgr888", image::Format::FMT_BGR888},
+            {"rgba8888", image::Format::FMT_RGBA8888},
+            {"yvu420sp", image::Format::FMT_YVU420SP},
+        };
+        for (auto &f : fmts)
+        {
+            r.measure(std::string("image.to_format.1080p_rgb888_to_") + f.name, [&]() {
+                delete img_1080p->to_format(f.fmt);
+            }, size_1080p);
+        }
+
+        // model input tensor
+        image::Image *img_input = img_1080p->resize(320, 320, image::Fit::FIT_FILL);
+        std::vector<float> mean = {0, 0, 0};
+        std::vector<float> scale = {0.00392156862745098f, 0.00392156862745098f, 0.00392156862745098f};
+        r.measure("image.to_tensor_float32.320x320.chw", [&]() {
+            delete img_input->to_tensor_float32(true, mean, scale);
+        }, 320 * 320 * 3);
+        r.measure("image.to_tensor_float32.320x320.hwc", [&]() {
+            delete img_input->to_tensor_float32(false, mean, scale);
+        }, 320 * 320 * 3);
+        delete img_input;
+
+        // jpeg encode
+        image::Image *jpg = img_vga->to_jpeg(80);
+        if (!jpg)
+        {
+            r.skip("image.to_jpeg.vga.q80", "to_jpeg not supported");
+            r.skip("image.to_jpeg.1080p.q80", "to_jpeg not supported");
+        }
+        else
+        {
+            delete jpg;
+            r.measure("image.to_jpeg.vga.q80", [&]() {
+                delete img_vga->to_jpeg(80);
+            }, 640 * 480 * 3);
+            r.measure("image.to_jpeg.1080p.q80", [&]() {
+                delete img_1080p->to_jpeg(80);
+            }, size_1080p);
+        }
+
+        // draw string, draw on a copy to keep source unchanged
+        image::Image *canvas = img_vga->copy();
+        r.measure("image.draw_string.vga.short", [&]() {
+            canvas->draw_string(10, 10, "fps: 30.0", image::COLOR_WHITE, 1.5);
+        });
+        r.measure("image.draw_string.vga.long", [&]() {
+            canvas->draw_string(10, 100, "person: 0.92, car: 0.81, dog: 0.66, bicycle: 0.50, traffic light: 0.45", image::COLOR_WHITE, 1.0);
+        });
+        delete canvas;
+
+        delete img_vga;
+        delete img_1080p;
+    }
+} // namespace bench
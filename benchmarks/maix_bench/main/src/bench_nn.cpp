@@ -0,0 +1,73 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_nn.hpp"
+#include "maix_nn_yolo11.hpp"
+
+using namespace maix;
+
+namespace bench
+{
+    image::Image *synthetic_rgb(int w, int h);
+
+    // case names, skip and measure must use the same names so compare.py can match them
+    static const char *CASE_POST_PROCESS = "nn.yolo11.post_process.conf0.25";
+    static const char *CASE_POST_PROCESS_LOW_CONF = "nn.yolo11.post_process.conf0.05";
+    static const char *CASE_DETECT = "nn.yolo11.detect";
+
+    void run_nn(Runner &r)
+    {
+        const std::string &model_path = r.options().model_path;
+        if (model_path.empty() || !fs::exists(model_path))
+        {
+            r.skip(CASE_POST_PROCESS, "no model, use --model");
+            r.skip(CASE_POST_PROCESS_LOW_CONF, "no model, use --model");
+            r.skip(CASE_DETECT, "no model, use --model");
+            return;
+        }
+        nn::YOLO11 yolo(model_path, false);
+        image::Size size = yolo.input_size();
+        image::Image *src = NULL;
+        if (!r.options().fixtures_dir.empty() && fs::exists(r.options().fixtures_dir + "/detect.jpg"))
+            src = image::load(r.options().fixtures_dir + "/detect.jpg", yolo.input_format());
+        if (!src)
+        {
+            image::Image *rgb = synthetic_rgb(size.width(), size.height());
+            src = rgb->to_format(yolo.input_format());
+            delete rgb;
+        }
+        image::Image *img = src->resize(size.width(), size.height(), image::Fit::FIT_CONTAIN);
+        delete src;
+
+        // raw outputs for post process only case
+        nn::NN model(model_path, false);
+        tensor::Tensors *outputs = model.forward_image(*img, yolo.mean, yolo.scale, image::Fit::FIT_CONTAIN, true, false, true);
+        if (!outputs)
+        {
+            r.skip(CASE_POST_PROCESS, "forward failed");
+            r.skip(CASE_POST_PROCESS_LOW_CONF, "forward failed");
+        }
+        else
+        {
+            // low conf threshold to make NMS work on many candidates
+            r.measure(CASE_POST_PROCESS, [&]() {
+                delete yolo.post_process(outputs, img->width(), img->height(), 0.25, 0.45);
+            });
+            r.measure(CASE_POST_PROCESS_LOW_CONF, [&]() {
+                delete yolo.post_process(outputs, img->width(), img->height(), 0.05, 0.45);
+            });
+            delete outputs;
+        }
+        r.measure(CASE_DETECT, [&]() {
+            delete yolo.detect(*img);
+        });
+        delete img;
+    }
+} // namespace bench
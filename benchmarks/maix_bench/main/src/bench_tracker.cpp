@@ -0,0 +1,77 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add micro benchmark harness.
+ */
+
+#include "bench.hpp"
+#include "maix_basic.hpp"
+#include "maix_bytetrack.hpp"
+
+using namespace maix;
+
+namespace bench
+{
+    /**
+     * Generate detections of objects moving with constant speed and bouncing in 1920x1080,
+     * with position noise and 5% missed detections.
+     */
+    static std::vector<std::vector<tracker::Object>> gen_frames(int obj_num, int frame_num)
+    {
+        struct Body
+        {
+            float x, y, vx, vy, w, h;
+        };
+        std::vector<Body> bodies(obj_num);
+        uint32_t seed = 42;
+        auto rnd = [&seed]() {
+            seed = seed * 1103515245 + 12345;
+            return ((seed >> 8) & 0xffff) / 65536.0f;
+        };
+        for (auto &b : bodies)
+        {
+            b.w = 20 + rnd() * 60;
+            b.h = 40 + rnd() * 100;
+            b.x = rnd() * (1920 - b.w);
+            b.y = rnd() * (1080 - b.h);
+            b.vx = (rnd() - 0.5f) * 16;
+            b.vy = (rnd() - 0.5f) * 8;
+        }
+        std::vector<std::vector<tracker::Object>> frames(frame_num);
+        for (auto &frame : frames)
+        {
+            for (auto &b : bodies)
+            {
+                b.x += b.vx;
+                b.y += b.vy;
+                if (b.x < 0 || b.x + b.w > 1920)
+                    b.vx = -b.vx;
+                if (b.y < 0 || b.y + b.h > 1080)
+                    b.vy = -b.vy;
+                if (rnd() < 0.05f)
+                    continue;
+                frame.emplace_back((int)(b.x + rnd() * 2), (int)(b.y + rnd() * 2), (int)b.w, (int)b.h, 0, 0.3f + rnd() * 0.7f);
+            }
+        }
+        return frames;
+    }
+
+    void run_tracker(Runner &r)
+    {
+        for (int n : {20, 50, 200})
+        {
+            std::string name = "tracker.ByteTracker.update." + std::to_string(n) + "_objs";
+            if (!r.enabled(name))
+                continue;
+            auto frames = gen_frames(n, 1000);
+            tracker::ByteTracker tracker(30, 0.4, 0.6, 0.8, 20);
+            size_t idx = 0;
+            r.measure(name, [&]() {
+                auto tracks = tracker.update(frames[idx]);
+                do_not_optimize(tracks.size());
+                idx = (idx + 1) % frames.size();
+            });
+        }
+    }
+} // namespace bench
@@ -0,0 +1,89 @@
+
+#include "maix_basic.hpp"
+#include "main.h"
+#include "bench.hpp"
+
+using namespace maix;
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options]\n"
+           "  --iterations N   samples per case, default 30\n"
+           "  --warmup N       warmup runs per case, default 3\n"
+           "  --filter STR     only run cases whose name contains STR\n"
+           "  --out PATH       write json result to PATH, default print to stdout\n"
+           "  --fixtures DIR   fixture images dir, apriltag.jpg, qrcode.jpg, detect.jpg, default assets/fixtures\n"
+           "  --model PATH     yolo11 model(.mud) for nn cases\n"
+           "  --list           list case names only\n", name);
+}
+
+int _main(int argc, char* argv[])
+{
+    bench::Options opts;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--iterations" && has_value)
+            opts.iterations = std::max(1, atoi(argv[++i]));
+        else if (arg == "--warmup" && has_value)
+            opts.warmup = std::max(1, atoi(argv[++i]));
+        else if (arg == "--filter" && has_value)
+            opts.filter = argv[++i];
+        else if (arg == "--out" && has_value)
+            opts.out_path = argv[++i];
+        else if (arg == "--fixtures" && has_value)
+            opts.fixtures_dir = argv[++i];
+        else if (arg == "--model" && has_value)
+            opts.model_path = argv[++i];
+        else if (arg == "--list")
+            opts.list = true;
+        else
+        {
+            usage(argv[0]);
+            return arg == "-h" || arg == "--help" ? 0 : -1;
+        }
+    }
+
+    // fixtures packaged with app
+    if (opts.fixtures_dir.empty() && fs::exists("assets/fixtures"))
+        opts.fixtures_dir = "assets/fixtures";
+
+    bench::Runner runner(opts);
+    bench::run_basic(runner);
+    bench::run_image(runner);
+    bench::run_find(runner);
+    bench::run_tracker(runner);
+    bench::run_nn(runner);
+    if (opts.list)
+        return 0;
+
+    std::string json = runner.to_json();
+    if (opts.out_path.empty())
+    {
+        printf("%s", json.c_str());
+        return 0;
+    }
+    fs::File *f = fs::open(opts.out_path, "w");
+    if (!f)
+    {
+        log::error("open %s failed", opts.out_path.c_str());
+        return -1;
+    }
+    f->write(json.data(), json.size());
+    f->close();
+    delete f;
+    log::info("result saved to %s", opts.out_path.c_str());
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
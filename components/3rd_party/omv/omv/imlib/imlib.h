@@ -1346,6 +1346,8 @@ void imlib_midpoint_pool(image_t *img_i, image_t *img_o, int x_div, int y_div, c
 void imlib_mean_pool(image_t *img_i, image_t *img_o, int x_div, int y_div);
 float imlib_template_match_ds(image_t *image, image_t *t, rectangle_t *r);
 float imlib_template_match_ex(image_t *image, image_t *t, rectangle_t *roi, int step, rectangle_t *r);
+float imlib_template_match_ds_ii(image_t *image, image_t *t, rectangle_t *r, i_image_t *sum);
+float imlib_template_match_ex_ii(image_t *image, image_t *t, rectangle_t *roi, int step, rectangle_t *r, i_image_t *sum, i_image_t *sumsq);
 
 /* Clustering functions */
 array_t *cluster_kmeans(array_t *points, int k, cluster_dist_t dist_func);
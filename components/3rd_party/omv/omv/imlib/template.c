@@ -119,13 +119,21 @@ static float find_block_ncc(image_t *f, image_t *t, i_image_t *sum, int t_mean,
 }
 
 float imlib_template_match_ds(image_t *f, image_t *t, rectangle_t *r) {
-    point_t pts[9];
-
     // Integral images
     i_image_t sum;
     imlib_integral_image_alloc(&sum, f->w, f->h);
     imlib_integral_image(f, &sum);
 
+    float max_xc = imlib_template_match_ds_ii(f, t, r, &sum);
+
+    imlib_integral_image_free(&sum);
+    return max_xc;
+}
+
+// Same as imlib_template_match_ds, but use integral image of f computed by caller, so it can be reused between calls.
+float imlib_template_match_ds_ii(image_t *f, image_t *t, rectangle_t *r, i_image_t *sum) {
+    point_t pts[9];
+
     // Normalized sum of squares of the template
     int t_mean = 0;
     uint32_t t_sumsq = 0;
@@ -163,7 +171,7 @@ float imlib_template_match_ds(image_t *f, image_t *t, rectangle_t *r) {
             if (pts[i].x >= f->w || pts[i].y >= f->h) {
                 continue;
             }
-            float blk_xc = find_block_ncc(f, t, &sum, t_mean, t_sumsq, pts[i].x, pts[i].y);
+            float blk_xc = find_block_ncc(f, t, sum, t_mean, t_sumsq, pts[i].x, pts[i].y);
             if (blk_xc > max_xc) {
                 px = pts[i].x;
                 py = pts[i].y;
@@ -205,8 +213,6 @@ float imlib_template_match_ds(image_t *f, image_t *t, rectangle_t *r) {
         r->h = f->h - cy;
     }
 
-    imlib_integral_image_free(&sum);
-
     //printf("max xc: %f\n", (double) max_xc);
     return max_xc;
 }
@@ -218,9 +224,6 @@ float imlib_template_match_ds(image_t *f, image_t *t, rectangle_t *r) {
  *
  */
 float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step, rectangle_t *r) {
-    int den_b = 0;
-    float corr = 0.0f;
-
     // Integral images
     i_image_t sum;
     i_image_t sumsq;
@@ -231,6 +234,18 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
     imlib_integral_image(f, &sum);
     imlib_integral_image_sq(f, &sumsq);
 
+    float corr = imlib_template_match_ex_ii(f, t, roi, step, r, &sum, &sumsq);
+
+    imlib_integral_image_free(&sum);
+    imlib_integral_image_free(&sumsq);
+    return corr;
+}
+
+// Same as imlib_template_match_ex, but use integral images of f computed by caller, so they can be reused between calls.
+float imlib_template_match_ex_ii(image_t *f, image_t *t, rectangle_t *roi, int step, rectangle_t *r, i_image_t *sum, i_image_t *sumsq) {
+    int den_b = 0;
+    float corr = 0.0f;
+
     // Normalized sum of squares of the template
     int t_mean = 0;
     imlib_image_mean(t, &t_mean, &t_mean, &t_mean);
@@ -244,8 +259,8 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
         for (int u = roi->x; u <= (roi->x + roi->w - t->w); u += step) {
             int num = 0;
             // The mean of the current patch
-            uint32_t f_sum = imlib_integral_lookup(&sum, u, v, t->w, t->h);
-            uint32_t f_sumsq = imlib_integral_lookup(&sumsq, u, v, t->w, t->h);
+            uint32_t f_sum = imlib_integral_lookup(sum, u, v, t->w, t->h);
+            uint32_t f_sumsq = imlib_integral_lookup(sumsq, u, v, t->w, t->h);
             uint32_t f_mean = f_sum / (float) (t->w * t->h);
 
             // Normalized sum of squares of the image
@@ -272,7 +287,5 @@ float imlib_template_match_ex(image_t *f, image_t *t, rectangle_t *roi, int step
         }
     }
 
-    imlib_integral_image_free(&sum);
-    imlib_integral_image_free(&sumsq);
     return corr;
 }
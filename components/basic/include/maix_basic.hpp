@@ -21,7 +21,9 @@
 #include "maix_err.hpp"
 #include "maix_fs.hpp"
 #include "maix_thread.hpp"
+#include "maix_io_reactor.hpp"
 #include "maix_time.hpp"
+#include "maix_trace.hpp"
 #include "maix_tensor.hpp"
 #include "maix_i18n.hpp"
 #include "maix_log.hpp"
@@ -0,0 +1,143 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add epoll I/O reactor, create this file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include "maix_type.hpp"
+#include "maix_err.hpp"
+
+namespace maix::io
+{
+    /**
+     * fd events, same value as epoll events, can be combined by |.
+     * @maixcdk maix.io.Event
+     */
+    enum Event
+    {
+        EVENT_IN = 0x001,  // readable
+        EVENT_PRI = 0x002, // urgent data, e.g. sysfs gpio edge
+        EVENT_OUT = 0x004, // writable
+        EVENT_ERR = 0x008, // error, always reported
+        EVENT_HUP = 0x010, // hang up, always reported
+    };
+
+    /**
+     * fd event callback, args are fd and occurred events(Event bits).
+     */
+    using EventCallback = std::function<void(int, uint32_t)>;
+
+    /**
+     * Reader callback, args are received data and length,
+     * data is in reactor's preallocated buffer and only valid in callback.
+     * len < 0 means EOF or read error, value is -err::Err, fd is removed from reactor after this call.
+     */
+    using ReaderCallback = std::function<void(uint8_t *, int)>;
+
+    /**
+     * One epoll loop thread watches all registered fds(UART, GPIO line events, input devices, sockets, timers),
+     * callbacks are dispatched to a fixed number of worker threads, so many mostly idle devices share a few threads
+     * instead of one thread each.
+     * Callbacks of the same fd never run concurrently and run in event order, callbacks of different fds may run in parallel.
+     * Use Reactor::global() to share one reactor between modules.
+     * @note Don't block long in callbacks, other fds wait for free workers.
+     * @maixcdk maix.io.Reactor
+     */
+    class Reactor
+    {
+    public:
+        /**
+         * Create reactor and start loop thread.
+         * @param workers callback worker thread number, 0 means run callbacks in loop thread directly.
+         * @param name thread name prefix, max 15 characters for Linux.
+         * @throw err::Exception if create epoll or thread failed.
+         * @maixcdk maix.io.Reactor.Reactor
+         */
+        Reactor(int workers = 2, const std::string &name = "reactor");
+
+        /**
+         * Stop loop thread, wait running callbacks finish, close fds created by reactor(timers).
+         * fds added by add() or add_reader() are not closed.
+         */
+        ~Reactor();
+
+        /**
+         * Global shared reactor, created at first call and never destroyed,
+         * so objects destroyed at program exit can still remove their fds safely.
+         * Worker number set by CONFIG_IO_REACTOR_WORKER_NUMBER.
+         * @maixcdk maix.io.Reactor.global
+         */
+        static Reactor &global();
+
+        /**
+         * Watch fd events.
+         * @param fd file descriptor, one fd can only be added once.
+         * @param events Event bits to watch, EVENT_ERR and EVENT_HUP are always watched.
+         * @param callback called when events occurred, level triggered, callback should read or write until not ready,
+         *                 or it will be called again.
+         * @return err::ERR_ARGS if fd invalid or callback empty, err::ERR_BUSY if fd already added, err::ERR_IO if epoll failed.
+         * @maixcdk maix.io.Reactor.add
+         */
+        err::Err add(int fd, uint32_t events, EventCallback callback);
+
+        /**
+         * Change watched events of fd.
+         * @return err::ERR_NOT_FOUND if fd not added.
+         * @maixcdk maix.io.Reactor.modify
+         */
+        err::Err modify(int fd, uint32_t events);
+
+        /**
+         * Stop watching fd, after return callback of this fd is not running and won't be called again,
+         * if called in the callback of this fd itself, return immediately and no more callback after current one.
+         * fd is not closed except timers created by add_timer().
+         * @note Don't call it while holding a lock the callback of this fd needs, it waits running callback to finish.
+         * @return err::ERR_NOT_FOUND if fd not added.
+         * @maixcdk maix.io.Reactor.remove
+         */
+        err::Err remove(int fd);
+
+        /**
+         * Watch readable event of fd and read data to a preallocated buffer, no allocation for each read.
+         * fd is set to non-blocking mode.
+         * @param fd file descriptor, e.g. UART, pipe, socket.
+         * @param buff_size receive buffer size, max data length of one callback.
+         * @param callback called with received data, see ReaderCallback.
+         * @return same as add().
+         * @maixcdk maix.io.Reactor.add_reader
+         */
+        err::Err add_reader(int fd, int buff_size, ReaderCallback callback);
+
+        /**
+         * Add timer by timerfd.
+         * @param interval_ms timer interval in ms, first trigger after interval_ms.
+         * @param callback timer callback, if callback is late more than one interval, missed triggers are merged into one.
+         * @param oneshot true means trigger only once and remove timer automatically.
+         * @return timer id(>0) used by remove_timer, not a fd and not reused while timer alive, < 0 means error, value is -err::Err.
+         * @maixcdk maix.io.Reactor.add_timer
+         */
+        int add_timer(int interval_ms, std::function<void()> callback, bool oneshot = false);
+
+        /**
+         * Remove timer, timer fd is closed, waits timer callback running in other thread like remove().
+         * @param id timer id returned by add_timer.
+         * @return err::ERR_NOT_FOUND if timer not exists or oneshot timer already triggered.
+         * @maixcdk maix.io.Reactor.remove_timer
+         */
+        err::Err remove_timer(int id);
+
+        /**
+         * Get number of watched fds, including timers.
+         * @maixcdk maix.io.Reactor.size
+         */
+        int size();
+
+    private:
+        void *_impl;
+    };
+} // namespace maix::io
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add slice-by-8 CRC16 and zero copy batch decode.
  */
 
 #pragma once
@@ -11,6 +12,7 @@
 #include <tuple>
 #include <valarray>
 #include <string>
+#include <functional>
 #include "maix_err.hpp"
 #include "maix_type.hpp"
 
@@ -219,6 +221,14 @@ namespace maix
             */
             void set_body(uint8_t *body_new, int body_len);
 
+            /**
+             * Let message body point to body_new without copy, message won't free it.
+             * @param body_new body data, must keep valid while message body used
+             * @param body_len body data length
+             * @maixcdk maix.protocol.MSG.set_body_view
+            */
+            void set_body_view(uint8_t *body_new, int body_len);
+
             /**
              * Update message body
              * @param body_new new body data
@@ -241,6 +251,7 @@ namespace maix
 
         private:
             int _body_buff_len;
+            bool _body_view;
         };
 
         /**
@@ -299,6 +310,18 @@ namespace maix
             */
             protocol::MSG *decode(const Bytes *new_data = nullptr);
 
+            /**
+             * Decode all complete messages in data queue, without memory allocation or body copy.
+             * @param callback called for every message, msg.body points to data queue buffer,
+             *                 only valid in callback, copy it if needed later.
+             *                 Don't call push_data or decode of this object in callback.
+             * @param new_data new data add to data queue, if null, only decode.
+             * @param len new data length, can be 0.
+             * @return number of decoded messages.
+             * @maixcdk maix.protocol.Protocol.decode_all
+            */
+            int decode_all(const std::function<void(MSG &msg)> &callback, uint8_t *new_data = nullptr, size_t len = 0);
+
             /**
              * Encode response ok(success) message to buffer
              * @param buff output buffer
@@ -383,11 +406,16 @@ namespace maix
             */
             Bytes *encode_resp_err(uint8_t cmd, err::Err code, const std::string &msg);
 
+        private:
+            void consume(int len);
+
         private:
             int _buff_size;
             uint8_t *_buff;
-            int _data_len;
+            int _data_len;   // end of valid data in _buff
+            int _read_pos;   // start of valid data in _buff, data before it are decoded
             uint32_t _header;
+            MSG _view_msg;
         };
 
         /**
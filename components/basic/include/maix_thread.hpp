@@ -3,12 +3,19 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add Pool, affinity and priority control.
  */
 
 #pragma once
 
 #include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 #include "maix_type.hpp"
+#include "maix_err.hpp"
 
 namespace maix
 {
@@ -58,6 +65,124 @@ namespace maix
 
         void sleep_ms(uint32_t ms);
 
+        /**
+         * Get CPU core number of this system.
+         * @return CPU core number, at least 1.
+         * @maixpy maix.thread.cpu_count
+         */
+        int cpu_count();
+
+        /**
+         * Bind current thread to CPU cores.
+         * @param cpus CPU core index list, e.g. [0, 1], empty means all cores.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if core index invalid, other error code if failed.
+         * @maixpy maix.thread.set_affinity
+         */
+        err::Err set_affinity(const std::vector<int> &cpus);
+
+        /**
+         * Set scheduling priority of current thread.
+         * @param priority real-time priority, 1~99 use SCHED_FIFO with this priority(need root or CAP_SYS_NICE),
+         *                 0 means normal SCHED_OTHER scheduler.
+         * @param nice nice value of current thread, -20~19, lower is higher priority, only valid when priority is 0.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if args invalid, err::ERR_NOT_PERMIT if no permission.
+         * @maixpy maix.thread.set_priority
+         */
+        err::Err set_priority(int priority, int nice = 0);
+
+        /**
+         * Thread pool with work stealing, tasks submitted from a worker are pushed to its own queue,
+         * idle workers steal tasks from other workers' queues.
+         * Use Pool::global() to share one pool between modules instead of creating many threads.
+         * @note Don't block on a future of the same pool in a task, it may dead lock if all workers are waiting,
+         *       parallel_for is safe to call in a task because caller thread also runs the loop.
+         * @maixcdk maix.thread.Pool
+         */
+        class Pool
+        {
+        public:
+            /**
+             * @brief Create thread pool
+             * @param threads worker thread number, <= 0 means CPU core number.
+             * @param cpus CPU cores workers bind to, worker i bind to cpus[i % cpus.size()], empty means not bind.
+             * @param priority 1~99 means workers use SCHED_FIFO with this priority, 0 means normal scheduler.
+             * @param nice nice value of workers, only valid when priority is 0.
+             * @param name worker thread name prefix, name will be name-N, max 15 characters for Linux.
+             * @maixcdk maix.thread.Pool.Pool
+             */
+            Pool(int threads = 0, const std::vector<int> &cpus = std::vector<int>(), int priority = 0, int nice = 0, const std::string &name = "pool");
+
+            /**
+             * @brief Wait all tasks finished and destroy workers.
+             */
+            ~Pool();
+
+            /**
+             * Global shared pool, created at first call,
+             * thread number set by CONFIG_THREAD_POOL_THREAD_NUMBER, 0 means CPU core number.
+             * @maixcdk maix.thread.Pool.global
+             */
+            static Pool &global();
+
+            /**
+             * Get worker thread number.
+             * @maixcdk maix.thread.Pool.size
+             */
+            int size();
+
+            /**
+             * Post a task without result, exceptions thrown by the task will be logged and ignored.
+             * @maixcdk maix.thread.Pool.post
+             */
+            void post(std::function<void()> task);
+
+            /**
+             * Submit a task and get its result by future, exception thrown by the task will be rethrown by future.get().
+             * @param func task function
+             * @param args task function arguments
+             * @return std::future of task function return value
+             * @maixcdk maix.thread.Pool.submit
+             */
+            template <typename F, typename... Args>
+            auto submit(F &&func, Args &&...args) -> std::future<std::invoke_result_t<F, Args...>>
+            {
+                using R = std::invoke_result_t<F, Args...>;
+                auto task = std::make_shared<std::packaged_task<R()>>(std::bind(std::forward<F>(func), std::forward<Args>(args)...));
+                std::future<R> res = task->get_future();
+                post([task]() { (*task)(); });
+                return res;
+            }
+
+            /**
+             * Run func on range [begin, end) in parallel, range is split to chunks of grain size,
+             * func(chunk_begin, chunk_end) is called for every chunk, caller thread also runs chunks and return after all done.
+             * @param begin range begin
+             * @param end range end, not included
+             * @param func chunk function, args are chunk begin and end(not included)
+             * @param grain chunk size, <= 0 means auto, about 4 chunks per worker.
+             * @throw the first exception thrown by func, after all chunks finished.
+             * @maixcdk maix.thread.Pool.parallel_for
+             */
+            void parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain = 0);
+
+            /**
+             * Run one pending task in caller thread if there is one,
+             * useful for waiting something in a task without blocking a worker.
+             * @return true if run one task, false if no task pending.
+             * @maixcdk maix.thread.Pool.run_pending_task
+             */
+            bool run_pending_task();
+
+            /**
+             * Wait until all submitted tasks finished.
+             * @maixcdk maix.thread.Pool.wait_idle
+             */
+            void wait_idle();
+
+        private:
+            void *_impl;
+        };
+
 
     }; // namespace thread
 };     // namespace maix
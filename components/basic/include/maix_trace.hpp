@@ -0,0 +1,172 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add trace profiler, create this file.
+ */
+
+#pragma once
+
+#include "maix_err.hpp"
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+/**
+ * Trace profiler, record scoped spans, counters and instant events to per thread ring buffers,
+ * then export to Chrome/Perfetto json(open with chrome://tracing or https://ui.perfetto.dev).
+ * Usage:
+ *   maix::trace::enable();
+ *   {
+ *       MAIX_TRACE_SCOPE("my_func");   // name must be a string literal or static string
+ *       ...
+ *   }
+ *   maix::trace::counter("objs", objs->size());
+ *   maix::trace::dump("/root/trace.json");
+ * Or set environment variable MAIX_TRACE=/root/trace.json before run program,
+ * trace will be enabled at startup and dumped at program exit, no code changed needed.
+ * When disabled, a span only costs one relaxed atomic load.
+ */
+namespace maix::trace
+{
+    namespace _priv
+    {
+        extern std::atomic<bool> enabled;
+        uint64_t now_ns();
+        void complete(const char *name, const char *cat, uint64_t start_ns, uint64_t end_ns);
+    } // namespace _priv
+
+    /**
+     * Enable or disable trace recording.
+     * @param en true to enable, false to disable, already recorded events will be kept.
+     * @maixpy maix.trace.enable
+     */
+    void enable(bool en = true);
+
+    /**
+     * Whether trace recording is enabled
+     * @return true if enabled
+     * @maixpy maix.trace.is_enabled
+     */
+    inline bool is_enabled()
+    {
+        return _priv::enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set ring buffer size of each thread, only affect threads which record first event after this call.
+     * When ring buffer full, oldest events will be overwritten.
+     * @param events max events count per thread, default 16384.
+     * @maixpy maix.trace.set_buffer_size
+     */
+    void set_buffer_size(int events);
+
+    /**
+     * Set name of current thread shown in trace viewer,
+     * default use name set by pthread_setname_np.
+     * Only stores the name, trace buffer of thread is allocated when its first event is recorded with trace enabled.
+     * @param name thread name
+     * @maixpy maix.trace.set_thread_name
+     */
+    void set_thread_name(const std::string &name);
+
+    /**
+     * Record counter value, shown as a track in trace viewer.
+     * @param name counter name, must be a string literal or static string, pointer is stored instead of copy.
+     * @param value counter value
+     * @maixcdk maix.trace.counter
+     */
+    void counter(const char *name, double value);
+
+    /**
+     * Record instant event, e.g. frame start, error occurred.
+     * @param name event name, must be a string literal or static string, pointer is stored instead of copy.
+     * @param cat category, must be a string literal or static string.
+     * @maixcdk maix.trace.instant
+     */
+    void instant(const char *name, const char *cat = "maix");
+
+    /**
+     * Clear all recorded events
+     * @maixpy maix.trace.clear
+     */
+    void clear();
+
+    /**
+     * Export recorded events as Chrome trace event format json string.
+     * Better disable trace before export, events being recorded when export may be dropped.
+     * @return json string
+     * @maixpy maix.trace.to_json
+     */
+    std::string to_json();
+
+    /**
+     * Export recorded events to file in Chrome trace event format,
+     * open with chrome://tracing or https://ui.perfetto.dev
+     * @param path file path, e.g. /root/trace.json
+     * @return err::ERR_NONE if success, or error code
+     * @maixpy maix.trace.dump
+     */
+    err::Err dump(const std::string &path);
+
+    /**
+     * Scoped span, record from construct to destruct as one complete event.
+     * Use MAIX_TRACE_SCOPE macro instead of use this class directly.
+     * @maixcdk maix.trace.Span
+     */
+    class Span
+    {
+    public:
+        /**
+         * Start span
+         * @param name span name, must be a string literal or static string, pointer is stored instead of copy.
+         * @param cat category, must be a string literal or static string.
+         * @maixcdk maix.trace.Span.Span
+         */
+        Span(const char *name, const char *cat = "maix")
+            : _name(name), _cat(cat), _start(0)
+        {
+            if (is_enabled())
+                _start = _priv::now_ns();
+        }
+
+        ~Span()
+        {
+            end();
+        }
+
+        /**
+         * End span before destruct, no effect if already ended.
+         * @maixcdk maix.trace.Span.end
+         */
+        void end()
+        {
+            if (_start)
+            {
+                _priv::complete(_name, _cat, _start, _priv::now_ns());
+                _start = 0;
+            }
+        }
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+    private:
+        const char *_name;
+        const char *_cat;
+        uint64_t _start;
+    };
+} // namespace maix::trace
+
+#define _MAIX_TRACE_CONCAT2(a, b) a##b
+#define _MAIX_TRACE_CONCAT(a, b) _MAIX_TRACE_CONCAT2(a, b)
+
+/**
+ * Trace current scope, e.g. MAIX_TRACE_SCOPE("camera.read"), or MAIX_TRACE_SCOPE("camera.read", "vision")
+ */
+#define MAIX_TRACE_SCOPE(...) maix::trace::Span _MAIX_TRACE_CONCAT(_maix_trace_span_, __LINE__)(__VA_ARGS__)
+
+/**
+ * Trace current function, use function name as span name
+ */
+#define MAIX_TRACE_FUNC() MAIX_TRACE_SCOPE(__func__)
@@ -0,0 +1,459 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add epoll I/O reactor, create this file.
+ */
+
+#include "maix_io_reactor.hpp"
+#include "maix_thread.hpp"
+#include "maix_log.hpp"
+#include "maix_trace.hpp"
+#include "global_config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#ifndef CONFIG_IO_REACTOR_WORKER_NUMBER
+#define CONFIG_IO_REACTOR_WORKER_NUMBER 2
+#endif
+
+namespace maix::io
+{
+    class ReactorImpl
+    {
+    public:
+        enum State
+        {
+            IDLE = 0, // armed in epoll, waiting event
+            QUEUED,   // event got, waiting worker, not armed so no duplicate dispatch
+            RUNNING,  // callback running
+        };
+
+        struct Entry
+        {
+            uint64_t id;
+            int fd;
+            uint32_t events;
+            uint32_t revents;
+            State state;
+            std::atomic<bool> removed;
+            bool owned;   // fd created by reactor, close when removed
+            bool oneshot; // remove after first callback
+            int timer_id = 0; // > 0 if created by add_timer, -1 before assigned
+            EventCallback callback;
+            ReaderCallback reader;
+            std::vector<uint8_t> buff; // reader receive buffer
+        };
+
+        ReactorImpl(int workers, const std::string &name)
+            : name(name)
+        {
+            epfd = epoll_create1(EPOLL_CLOEXEC);
+            if (epfd < 0)
+                throw err::Exception(err::ERR_IO, std::string("create epoll failed: ") + strerror(errno));
+            evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (evfd < 0)
+            {
+                ::close(epfd);
+                throw err::Exception(err::ERR_IO, std::string("create eventfd failed: ") + strerror(errno));
+            }
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.u64 = 0; // id 0 is stop event
+            epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &ev);
+            if (workers > 0)
+                pool = new thread::Pool(workers, std::vector<int>(), 0, 0, name);
+            loop_thread = std::thread(&ReactorImpl::loop, this);
+        }
+
+        ~ReactorImpl()
+        {
+            uint64_t v = 1;
+            if (::write(evfd, &v, sizeof(v)) != sizeof(v))
+                log::error("reactor stop failed: %s\n", strerror(errno));
+            loop_thread.join();
+            delete pool; // wait queued callbacks
+            for (auto &it : entries)
+            {
+                if (it.second->owned)
+                    ::close(it.second->fd);
+            }
+            ::close(evfd);
+            ::close(epfd);
+        }
+
+        err::Err add(int fd, uint32_t events, EventCallback &&callback, bool owned, bool oneshot)
+        {
+            if (fd < 0 || !callback)
+                return err::ERR_ARGS;
+            auto e = std::make_shared<Entry>();
+            e->callback = std::move(callback);
+            return add(fd, events, e, owned, oneshot);
+        }
+
+        err::Err add_reader(int fd, int buff_size, ReaderCallback &&callback)
+        {
+            if (fd < 0 || buff_size <= 0 || !callback)
+                return err::ERR_ARGS;
+            int flags = fcntl(fd, F_GETFL, 0);
+            if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+                return err::ERR_ARGS;
+            auto e = std::make_shared<Entry>();
+            e->reader = std::move(callback);
+            e->buff.resize(buff_size);
+            return add(fd, EVENT_IN, e, false, false);
+        }
+
+        err::Err add(int fd, uint32_t events, const std::shared_ptr<Entry> &e, bool owned, bool oneshot)
+        {
+            e->fd = fd;
+            e->events = events;
+            e->revents = 0;
+            e->state = IDLE;
+            e->removed = false;
+            e->owned = owned;
+            e->oneshot = oneshot;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (fds.find(fd) != fds.end())
+                return err::ERR_BUSY;
+            e->id = ++last_id;
+            if (ctl(EPOLL_CTL_ADD, *e) < 0)
+            {
+                log::error("reactor add fd %d failed: %s\n", fd, strerror(errno));
+                return err::ERR_IO;
+            }
+            fds[fd] = e->id;
+            entries[e->id] = e;
+            if (e->timer_id < 0)
+            {
+                // timer ids are never reused while alive, unlike fds which kernel reuses after close
+                do
+                {
+                    last_timer_id = last_timer_id == INT_MAX ? 1 : last_timer_id + 1;
+                } while (timers.find(last_timer_id) != timers.end());
+                e->timer_id = last_timer_id;
+                timers[e->timer_id] = e->id;
+            }
+            return err::ERR_NONE;
+        }
+
+        // return timer id > 0, or -err::Err
+        int add_timer(int fd, EventCallback &&callback, bool oneshot)
+        {
+            auto e = std::make_shared<Entry>();
+            e->callback = std::move(callback);
+            e->timer_id = -1;
+            err::Err err = add(fd, EVENT_IN, e, true, oneshot);
+            if (err != err::ERR_NONE)
+                return -err;
+            return e->timer_id;
+        }
+
+        err::Err modify(int fd, uint32_t events)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = fds.find(fd);
+            if (it == fds.end())
+                return err::ERR_NOT_FOUND;
+            Entry &e = *entries[it->second];
+            e.events = events;
+            // not armed while queued or running, new events take effect when re-armed
+            if (e.state == IDLE && ctl(EPOLL_CTL_MOD, e) < 0)
+                return err::ERR_IO;
+            return err::ERR_NONE;
+        }
+
+        err::Err remove(int fd)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = fds.find(fd);
+            if (it == fds.end())
+                return err::ERR_NOT_FOUND;
+            remove(entries[it->second], lock);
+            return err::ERR_NONE;
+        }
+
+        err::Err remove_timer(int timer_id)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto it = timers.find(timer_id);
+            if (it == timers.end())
+                return err::ERR_NOT_FOUND;
+            remove(entries[it->second], lock);
+            return err::ERR_NONE;
+        }
+
+        int size()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return fds.size();
+        }
+
+        std::string name;
+        thread::Pool *pool = nullptr;
+
+    private:
+        void remove(std::shared_ptr<Entry> e, std::unique_lock<std::mutex> &lock)
+        {
+            detach(*e);
+            // wait callback running in other thread, queued callback will see removed and skip
+            if (tl_current != e.get())
+                cond.wait(lock, [&e] { return e->state != RUNNING; });
+        }
+
+        int ctl(int op, Entry &e)
+        {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            // one shot, re-armed after callback, so one fd is never dispatched twice at the same time
+            ev.events = e.events | EPOLLONESHOT;
+            ev.data.u64 = e.id;
+            return epoll_ctl(epfd, op, e.fd, &ev);
+        }
+
+        // with mutex held
+        void detach(Entry &e)
+        {
+            e.removed = true;
+            // fd may be already closed by user, it's removed from epoll automatically then
+            epoll_ctl(epfd, EPOLL_CTL_DEL, e.fd, nullptr);
+            fds.erase(e.fd);
+            entries.erase(e.id);
+            if (e.timer_id > 0)
+                timers.erase(e.timer_id);
+            // running callback may still use fd, closed when it returns
+            if (e.owned && e.state != RUNNING)
+                ::close(e.fd);
+        }
+
+        // read until no data, limit reads of one dispatch so other fds get a chance,
+        // level triggered epoll fires again if more data left
+        void read_loop(Entry &e)
+        {
+            uint8_t *p = e.buff.data();
+            int size = e.buff.size();
+            for (int i = 0; i < 8 && !e.removed; ++i)
+            {
+                ssize_t len = ::read(e.fd, p, size);
+                if (len > 0)
+                {
+                    e.reader(p, (int)len);
+                    if (len < size)
+                        return;
+                    continue;
+                }
+                if (len < 0 && errno == EINTR)
+                    continue;
+                if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    if (e.revents & (EPOLLERR | EPOLLHUP))
+                        break; // hang up without data, e.g. pty peer closed
+                    return;
+                }
+                break;
+            }
+            if (e.removed)
+                return;
+            e.reader(nullptr, -err::ERR_IO);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!e.removed)
+                detach(e);
+        }
+
+        void dispatch(const std::shared_ptr<Entry> &e)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (e->removed)
+                {
+                    e->state = IDLE;
+                    cond.notify_all();
+                    return;
+                }
+                e->state = RUNNING;
+            }
+            tl_current = e.get();
+            try
+            {
+                if (e->reader)
+                    read_loop(*e);
+                else
+                    e->callback(e->fd, e->revents);
+            }
+            catch (const std::exception &ex)
+            {
+                log::error("reactor callback of fd %d exception: %s\n", e->fd, ex.what());
+            }
+            tl_current = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            e->state = IDLE;
+            if (e->removed)
+            {
+                if (e->owned)
+                    ::close(e->fd);
+            }
+            else
+            {
+                if (e->oneshot)
+                    detach(*e);
+                else if (ctl(EPOLL_CTL_MOD, *e) < 0)
+                {
+                    log::error("reactor re-arm fd %d failed: %s, removed\n", e->fd, strerror(errno));
+                    detach(*e);
+                }
+            }
+            cond.notify_all();
+        }
+
+        void loop()
+        {
+            std::string thread_name = name.substr(0, 15);
+            pthread_setname_np(pthread_self(), thread_name.c_str());
+            trace::set_thread_name(thread_name);
+            struct epoll_event evs[32];
+            while (true)
+            {
+                int n = epoll_wait(epfd, evs, sizeof(evs) / sizeof(evs[0]), -1);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    log::error("reactor epoll wait failed: %s\n", strerror(errno));
+                    break;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    uint64_t id = evs[i].data.u64;
+                    if (id == 0)
+                        return;
+                    std::shared_ptr<Entry> e;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        auto it = entries.find(id);
+                        // removed after epoll_wait returned
+                        if (it == entries.end())
+                            continue;
+                        e = it->second;
+                        e->revents = evs[i].events;
+                        e->state = QUEUED;
+                    }
+                    if (pool)
+                        pool->post([this, e]() { dispatch(e); });
+                    else
+                        dispatch(e);
+                }
+            }
+        }
+
+        int epfd = -1;
+        int evfd = -1;
+        uint64_t last_id = 0;
+        int last_timer_id = 0;
+        std::unordered_map<int, uint64_t> fds;
+        std::unordered_map<int, uint64_t> timers; // timer id to entry id
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> entries;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread loop_thread;
+
+        static thread_local Entry *tl_current;
+    };
+
+    thread_local ReactorImpl::Entry *ReactorImpl::tl_current = nullptr;
+
+    Reactor::Reactor(int workers, const std::string &name)
+    {
+        _impl = new ReactorImpl(workers, name);
+    }
+
+    Reactor::~Reactor()
+    {
+        delete (ReactorImpl *)_impl;
+    }
+
+    Reactor &Reactor::global()
+    {
+        static Reactor *reactor = new Reactor(CONFIG_IO_REACTOR_WORKER_NUMBER, "maix_io");
+        return *reactor;
+    }
+
+    err::Err Reactor::add(int fd, uint32_t events, EventCallback callback)
+    {
+        return ((ReactorImpl *)_impl)->add(fd, events, std::move(callback), false, false);
+    }
+
+    err::Err Reactor::modify(int fd, uint32_t events)
+    {
+        return ((ReactorImpl *)_impl)->modify(fd, events);
+    }
+
+    err::Err Reactor::remove(int fd)
+    {
+        return ((ReactorImpl *)_impl)->remove(fd);
+    }
+
+    err::Err Reactor::add_reader(int fd, int buff_size, ReaderCallback callback)
+    {
+        return ((ReactorImpl *)_impl)->add_reader(fd, buff_size, std::move(callback));
+    }
+
+    int Reactor::add_timer(int interval_ms, std::function<void()> callback, bool oneshot)
+    {
+        if (interval_ms <= 0 || !callback)
+            return -err::ERR_ARGS;
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0)
+        {
+            log::error("create timerfd failed: %s\n", strerror(errno));
+            return -err::ERR_IO;
+        }
+        struct itimerspec ts;
+        memset(&ts, 0, sizeof(ts));
+        ts.it_value.tv_sec = interval_ms / 1000;
+        ts.it_value.tv_nsec = (interval_ms % 1000) * 1000000L;
+        if (!oneshot)
+            ts.it_interval = ts.it_value;
+        if (timerfd_settime(fd, 0, &ts, nullptr) < 0)
+        {
+            log::error("set timerfd failed: %s\n", strerror(errno));
+            ::close(fd);
+            return -err::ERR_IO;
+        }
+        int id = ((ReactorImpl *)_impl)->add_timer(fd, [callback](int fd, uint32_t) {
+            uint64_t expirations;
+            if (::read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+                return;
+            callback();
+        }, oneshot);
+        if (id < 0)
+            ::close(fd);
+        return id;
+    }
+
+    err::Err Reactor::remove_timer(int id)
+    {
+        return ((ReactorImpl *)_impl)->remove_timer(id);
+    }
+
+    int Reactor::size()
+    {
+        return ((ReactorImpl *)_impl)->size();
+    }
+} // namespace maix::io
@@ -9,26 +9,48 @@
 #include "maix_protocol.hpp"
 #include <string.h>
 #include <assert.h>
+#include <array>
 
 namespace maix::protocol
 {
     uint32_t HEADER = 0xBBACCAAA;
+    // slice-by-8 tables of reflected polynomial 0xA001, table[k][i] is CRC of byte i followed by k zero bytes
+    static constexpr std::array<std::array<uint16_t, 256>, 8> __crc16_IBM_table()
+    {
+        std::array<std::array<uint16_t, 256>, 8> table{};
+        for (int i = 0; i < 256; ++i)
+        {
+            uint16_t crc = i;
+            for (int j = 0; j < 8; ++j)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+            table[0][i] = crc;
+        }
+        for (int k = 1; k < 8; ++k)
+        {
+            for (int i = 0; i < 256; ++i)
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+        }
+        return table;
+    }
+
+    static constexpr std::array<std::array<uint16_t, 256>, 8> CRC16_IBM_TABLE = __crc16_IBM_table();
+
     uint16_t crc16_IBM(uint8_t *ptr, size_t len)
     {
-        unsigned int i;
+        const auto &t = CRC16_IBM_TABLE;
         uint16_t crc = 0x0000;
 
-        while (len--)
+        // 8 bytes per iteration, table lookups are independent so CPU can run them in parallel
+        while (len >= 8)
         {
-            crc ^= *ptr++;
-            for (i = 0; i < 8; ++i)
-            {
-                if (crc & 1)
-                    crc = (crc >> 1) ^ 0xA001;
-                else
-                    crc = (crc >> 1);
-            }
+            uint32_t lo = (ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24)) ^ crc;
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                  t[3][ptr[4]] ^ t[2][ptr[5]] ^ t[1][ptr[6]] ^ t[0][ptr[7]];
+            ptr += 8;
+            len -= 8;
         }
+        while (len--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xFF];
 
         return crc;
     }
@@ -56,13 +78,15 @@ namespace maix::protocol
         if (code != 0xFF)
         {
             out_buff[10] = code;
-            memcpy(out_buff + 11, body, body_len);
+            if (body_len > 0)
+                memcpy(out_buff + 11, body, body_len);
             uint16_t crc16 = crc16_IBM(out_buff, body_len + 11);
             out_buff[11 + body_len] = crc16 & 0xFF;
             out_buff[12 + body_len] = crc16 >> 8 & 0xFF;
             return body_len + 13;
         }
-        memcpy(out_buff + 10, body, body_len);
+        if (body_len > 0)
+            memcpy(out_buff + 10, body, body_len);
         uint16_t crc16 = crc16_IBM(out_buff, body_len + 10);
         out_buff[10 + body_len] = crc16 & 0xFF;
         out_buff[11 + body_len] = crc16 >> 8 & 0xFF;
@@ -111,70 +135,78 @@ namespace maix::protocol
         return encode(buff, buff_len, cmd, FLAG_RESP | FLAG_RESP_ERR, (uint8_t *)msg.c_str(), msg.length(), code);
     }
 
-    bool get_msg(uint8_t *data, int len, MSG *frame, int *idx, const uint32_t header=HEADER)
+    /**
+     * Find first valid frame in data.
+     * @param skip bytes before the frame, or bytes can be dropped if no frame found.
+     * @param frame_len whole frame length when found.
+     * @param max_frame_len frames longer than this can never be received, treated as corrupted.
+     * @return true if found a frame with right CRC.
+     */
+    static bool find_frame(const uint8_t *data, size_t len, uint32_t header, size_t max_frame_len, size_t *skip, size_t *frame_len)
     {
-        size_t data_len = 0;
-
-        *idx = 0;
-        if (len < 12)
-            return false;
-        // find header
-        uint32_t i = 0;
-        bool found = false;
-        for (; i < (uint32_t)len - 4; i++)
+        const uint8_t header_bytes[4] = {(uint8_t)(header & 0xFF), (uint8_t)(header >> 8 & 0xFF), (uint8_t)(header >> 16 & 0xFF), (uint8_t)(header >> 24 & 0xFF)};
+        size_t i = 0;
+        while (i < len)
         {
-            if (data[i] == (header & 0xFF) &&
-                data[i + 1] == ((header >> 8) & 0xFF) &&
-                data[i + 2] == ((header >> 16) & 0xFF) &&
-                data[i + 3] == ((header >> 24) & 0xFF))
-            {
-                found = true;
+            const uint8_t *p = (const uint8_t *)memchr(data + i, header_bytes[0], len - i);
+            if (!p)
                 break;
+            i = p - data;
+            if (len - i < 12)
+            {
+                // maybe a frame not fully received
+                *skip = i;
+                return false;
             }
+            if (memcmp(p, header_bytes, 4) != 0)
+            {
+                ++i;
+                continue;
+            }
+            size_t data_len = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+            // data_len includes flags, cmd and crc at least, a corrupted length resyncs from next byte
+            if (data_len < 4 || data_len + 8 > max_frame_len)
+            {
+                ++i;
+                continue;
+            }
+            if (data_len + 8 > len - i)
+            {
+                *skip = i;
+                return false;
+            }
+            uint16_t crc16 = crc16_IBM((uint8_t *)p, data_len + 6);
+            if (p[6 + data_len] != (crc16 & 0xFF) || p[7 + data_len] != (crc16 >> 8 & 0xFF))
+            {
+                ++i;
+                continue;
+            }
+            *skip = i;
+            *frame_len = data_len + 8;
+            return true;
         }
-        // len >= 12
-        if (!found)
-        {
-            *idx = i;
-            return false;
-        }
-        if (len - i < 12)
-            return false;
-
-        // get data_len, and check data length
-        data_len = data[i + 4] | (data[i + 5] << 8) | (data[i + 6] << 16) | (data[i + 7] << 24);
-        if (data_len > len - i - 8)
-            return false;
-        *idx = i + 8 + data_len;
-        // check crc
-        uint16_t crc16 = crc16_IBM(data + i, data_len + 6);
-        if (data[i + 6 + data_len] != (crc16 & 0xFF) || data[i + 7 + data_len] != (crc16 >> 8 & 0xFF))
-        {
-            return false;
-        }
-        // parse data
-        frame->version = data[i + 8] & FLAG_VERSION_MASK;
-        frame->is_resp = data[i + 8] & FLAG_IS_RESP_MASK;
-        frame->is_req = !frame->is_resp;
-        frame->is_report = data[i + 8] & FLAG_REPORT_MASK;
-        frame->resp_ok = data[i + 8] & FLAG_RESP_OK_MASK;
-        frame->cmd = data[i + 9];
-        frame->set_body(data + i + 10, data_len - 4);
-        frame->body_len = data_len - 4;
-        return true;
-    }
-
-    std::tuple<MSG *, int> get_msg(uint8_t *data, int len)
-    {
-        MSG *frame = new MSG();
-        int idx = 0;
-        if (get_msg(data, len, frame, &idx))
-            return std::make_tuple(frame, idx);
+        // no header start byte, all data can be dropped
+        *skip = len;
+        return false;
+    }
+
+    /**
+     * Parse frame found by find_frame to msg.
+     * @param copy copy body to msg, or msg body points to frame.
+     */
+    static void parse_frame(uint8_t *frame, size_t frame_len, MSG *msg, bool copy)
+    {
+        msg->version = frame[8] & FLAG_VERSION_MASK;
+        msg->is_resp = frame[8] & FLAG_IS_RESP_MASK;
+        msg->is_req = !msg->is_resp;
+        msg->is_report = frame[8] & FLAG_REPORT_MASK;
+        msg->resp_ok = frame[8] & FLAG_RESP_OK_MASK;
+        msg->has_been_replied = false;
+        msg->cmd = frame[9];
+        if (copy)
+            msg->set_body(frame + 10, frame_len - 12);
         else
-        {
-            delete frame;
-            return std::make_tuple(nullptr, idx);
-        }
+            msg->set_body_view(frame + 10, frame_len - 12);
     }
 
     MSG::MSG()
@@ -188,11 +220,12 @@ namespace maix::protocol
         body = nullptr;
         body_len = 0;
         _body_buff_len = 0;
+        _body_view = false;
     }
 
     MSG::~MSG()
     {
-        if (body)
+        if (body && !_body_view)
         {
             delete[] body;
         }
@@ -256,6 +289,13 @@ namespace maix::protocol
 
     void MSG::set_body(uint8_t *body_new, int body_len)
     {
+        if (_body_view)
+        {
+            // body points to protocol buffer, never free it
+            body = nullptr;
+            _body_buff_len = 0;
+            _body_view = false;
+        }
         if ((body && _body_buff_len < body_len))
         {
             delete[] body;
@@ -271,6 +311,16 @@ namespace maix::protocol
         this->body_len = body_len;
     }
 
+    void MSG::set_body_view(uint8_t *body_new, int body_len)
+    {
+        if (body && !_body_view)
+            delete[] body;
+        body = body_new;
+        this->body_len = body_len;
+        _body_buff_len = 0;
+        _body_view = true;
+    }
+
     int Protocol::encode_resp_ok(uint8_t *buff, int buff_len, uint8_t cmd, uint8_t *body, int body_len)
     {
         return protocol::encode_resp_ok(buff, buff_len, cmd, body, body_len);
@@ -324,6 +374,7 @@ namespace maix::protocol
         _buff_size = buff_size;
         _buff = new uint8_t[buff_size];
         _data_len = 0;
+        _read_pos = 0;
         _header = header;
         HEADER = header;
     }
@@ -336,7 +387,14 @@ namespace maix::protocol
     err::Err Protocol::push_data(uint8_t *new_data, int len)
     {
         if (_data_len + len > _buff_size)
-            return err::ERR_BUFF_FULL;
+        {
+            // consumed bytes are only dropped here, so decode never moves data after every frame
+            if (_data_len - _read_pos + len > _buff_size)
+                return err::ERR_BUFF_FULL;
+            memmove(_buff, _buff + _read_pos, _data_len - _read_pos);
+            _data_len -= _read_pos;
+            _read_pos = 0;
+        }
         memcpy(_buff + _data_len, new_data, len);
         _data_len += len;
         return err::ERR_NONE;
@@ -344,7 +402,17 @@ namespace maix::protocol
 
     err::Err Protocol::push_data(const Bytes *new_data)
     {
-        return push_data((uint8_t *)&new_data[0], new_data->size());
+        return push_data(new_data->data, new_data->size());
+    }
+
+    void Protocol::consume(int len)
+    {
+        _read_pos += len;
+        if (_read_pos >= _data_len)
+        {
+            _read_pos = 0;
+            _data_len = 0;
+        }
     }
 
     MSG *Protocol::decode(uint8_t *new_data, size_t len)
@@ -353,26 +421,51 @@ namespace maix::protocol
         {
             push_data(new_data, len);
         }
-        MSG *frame = new MSG();
-        int idx = 0;
-        if (get_msg(_buff, _data_len, frame, &idx, _header))
-        {
-            memmove(_buff, _buff + idx, _data_len - idx);
-            _data_len -= idx;
-            return frame;
-        }
-        if (idx > 0)
+        size_t skip = 0, frame_len = 0;
+        bool found = find_frame(_buff + _read_pos, _data_len - _read_pos, _header, _buff_size, &skip, &frame_len);
+        if (!found)
         {
-            memmove(_buff, _buff + idx, _data_len - idx);
-            _data_len -= idx;
+            consume(skip);
+            return nullptr;
         }
-        delete frame;
-        return nullptr;
+        MSG *frame = new MSG();
+        parse_frame(_buff + _read_pos + skip, frame_len, frame, true);
+        consume(skip + frame_len);
+        return frame;
     }
 
     MSG *Protocol::decode(const Bytes *new_data)
     {
-        return decode((uint8_t *)&new_data[0], new_data->size());
+        if (!new_data)
+            return decode(nullptr, 0);
+        return decode(new_data->data, new_data->size());
+    }
+
+    int Protocol::decode_all(const std::function<void(MSG &msg)> &callback, uint8_t *new_data, size_t len)
+    {
+        if (len > 0)
+        {
+            push_data(new_data, len);
+        }
+        int count = 0;
+        while (true)
+        {
+            size_t skip = 0, frame_len = 0;
+            bool found = find_frame(_buff + _read_pos, _data_len - _read_pos, _header, _buff_size, &skip, &frame_len);
+            if (!found)
+            {
+                consume(skip);
+                break;
+            }
+            // consume before callback, buffer is not moved until next push_data, so body view is still valid
+            uint8_t *frame = _buff + _read_pos + skip;
+            consume(skip + frame_len);
+            parse_frame(frame, frame_len, &_view_msg, false);
+            callback(_view_msg);
+            ++count;
+        }
+        _view_msg.set_body_view(nullptr, 0);
+        return count;
     }
 
 } // namespace maix::protocol
@@ -0,0 +1,407 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add thread pool, affinity and priority control, create this file.
+ */
+
+#include "maix_thread.hpp"
+#include "maix_log.hpp"
+#include "maix_trace.hpp"
+#include "global_config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef CONFIG_THREAD_POOL_THREAD_NUMBER
+#define CONFIG_THREAD_POOL_THREAD_NUMBER 0
+#endif
+
+namespace maix::thread
+{
+    int cpu_count()
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+    }
+
+    err::Err set_affinity(const std::vector<int> &cpus)
+    {
+        int num = cpu_count();
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (cpus.empty())
+        {
+            for (int i = 0; i < num; ++i)
+                CPU_SET(i, &set);
+        }
+        for (int cpu : cpus)
+        {
+            if (cpu < 0 || cpu >= num)
+            {
+                log::error("cpu %d out of range [0, %d)\n", cpu, num);
+                return err::ERR_ARGS;
+            }
+            CPU_SET(cpu, &set);
+        }
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0)
+        {
+            log::error("set affinity failed: %s\n", strerror(ret));
+            return err::ERR_RUNTIME;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err set_priority(int priority, int nice)
+    {
+        if (priority < 0 || priority > 99 || nice < -20 || nice > 19)
+            return err::ERR_ARGS;
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int ret = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+        if (ret != 0)
+        {
+            log::warn("set thread priority %d failed: %s\n", priority, strerror(ret));
+            return ret == EPERM ? err::ERR_NOT_PERMIT : err::ERR_RUNTIME;
+        }
+        if (priority == 0 && nice != 0)
+        {
+            // nice is per thread on Linux, use tid
+            if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice) != 0)
+            {
+                log::warn("set thread nice %d failed: %s\n", nice, strerror(errno));
+                return errno == EACCES || errno == EPERM ? err::ERR_NOT_PERMIT : err::ERR_RUNTIME;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    class PoolImpl
+    {
+    public:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        PoolImpl(int threads, const std::vector<int> &cpus, int priority, int nice, const std::string &name)
+        {
+            if (threads <= 0)
+                threads = cpu_count();
+            for (int i = 0; i < threads; ++i)
+                queues.emplace_back(new Queue());
+            for (int i = 0; i < threads; ++i)
+            {
+                std::vector<int> cpu;
+                if (!cpus.empty())
+                    cpu.push_back(cpus[i % cpus.size()]);
+                std::string thread_name = name + "-" + std::to_string(i);
+                workers.emplace_back(&PoolImpl::worker, this, i, cpu, priority, nice, thread_name);
+            }
+        }
+
+        ~PoolImpl()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                exit = true;
+            }
+            cond.notify_all();
+            for (auto &t : workers)
+                t.join();
+        }
+
+        void push(std::function<void()> &&task)
+        {
+            {
+                // count before queued, so a fast worker never makes unfinished negative
+                std::lock_guard<std::mutex> lock(mutex);
+                ++unfinished;
+            }
+            int idx;
+            if (tl_pool == this)
+                idx = tl_index;
+            else
+                idx = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+            {
+                std::lock_guard<std::mutex> lock(queues[idx]->mutex);
+                queues[idx]->tasks.push_back(std::move(task));
+            }
+            {
+                // pending is changed with mutex held so waiting workers won't miss it
+                std::lock_guard<std::mutex> lock(mutex);
+                ++pending;
+            }
+            cond.notify_one();
+        }
+
+        // own queue from back(LIFO, cache hot), others from front(oldest, usually biggest)
+        bool pop(int self, std::function<void()> &task)
+        {
+            int n = queues.size();
+            if (self >= 0 && pop_from(self, true, task))
+                return true;
+            int start = self >= 0 ? self + 1 : next_queue.load(std::memory_order_relaxed);
+            for (int i = 0; i < n; ++i)
+            {
+                int idx = (start + i) % n;
+                if (idx != self && pop_from(idx, false, task))
+                    return true;
+            }
+            return false;
+        }
+
+        void run(std::function<void()> &task)
+        {
+            try
+            {
+                task();
+            }
+            catch (const std::exception &e)
+            {
+                log::error("thread pool task exception: %s\n", e.what());
+            }
+            catch (...)
+            {
+                log::error("thread pool task unknown exception\n");
+            }
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinished == 0)
+                idle_cond.notify_all();
+        }
+
+        bool run_pending()
+        {
+            std::function<void()> task;
+            if (!pop(tl_pool == this ? tl_index : -1, task))
+                return false;
+            run(task);
+            return true;
+        }
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::condition_variable idle_cond;
+        int pending = 0;
+        int unfinished = 0;
+        bool exit = false;
+        std::atomic<unsigned int> next_queue{0};
+
+        static thread_local PoolImpl *tl_pool;
+        static thread_local int tl_index;
+
+    private:
+        bool pop_from(int idx, bool back, std::function<void()> &task)
+        {
+            Queue &q = *queues[idx];
+            {
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (q.tasks.empty())
+                    return false;
+                if (back)
+                {
+                    task = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                }
+            }
+            // may run before push() increases pending, it's fine for pending to be -1 for a short time
+            std::lock_guard<std::mutex> lock(mutex);
+            --pending;
+            return true;
+        }
+
+        void worker(int index, std::vector<int> cpus, int priority, int nice, std::string name)
+        {
+            tl_pool = this;
+            tl_index = index;
+            if (name.size() > 15)
+                name = name.substr(0, 15);
+            pthread_setname_np(pthread_self(), name.c_str());
+            trace::set_thread_name(name.c_str());
+            if (!cpus.empty())
+                set_affinity(cpus);
+            if (priority != 0 || nice != 0)
+                set_priority(priority, nice);
+
+            std::function<void()> task;
+            while (true)
+            {
+                if (pop(index, task))
+                {
+                    run(task);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [this] { return exit || pending > 0; });
+                if (exit && pending == 0)
+                    break;
+            }
+        }
+    };
+
+    thread_local PoolImpl *PoolImpl::tl_pool = nullptr;
+    thread_local int PoolImpl::tl_index = -1;
+
+    Pool::Pool(int threads, const std::vector<int> &cpus, int priority, int nice, const std::string &name)
+    {
+        _impl = new PoolImpl(threads, cpus, priority, nice, name);
+    }
+
+    Pool::~Pool()
+    {
+        delete (PoolImpl *)_impl;
+    }
+
+    Pool &Pool::global()
+    {
+        static Pool pool(CONFIG_THREAD_POOL_THREAD_NUMBER, std::vector<int>(), 0, 0, "maix_pool");
+        return pool;
+    }
+
+    int Pool::size()
+    {
+        return ((PoolImpl *)_impl)->workers.size();
+    }
+
+    void Pool::post(std::function<void()> task)
+    {
+        ((PoolImpl *)_impl)->push(std::move(task));
+    }
+
+    bool Pool::run_pending_task()
+    {
+        return ((PoolImpl *)_impl)->run_pending();
+    }
+
+    void Pool::wait_idle()
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        if (PoolImpl::tl_pool == impl)
+        {
+            // called in a task, this task itself is unfinished, just help until others done
+            while (true)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(impl->mutex);
+                    if (impl->unfinished <= 1)
+                        return;
+                }
+                if (!impl->run_pending())
+                    std::this_thread::yield();
+            }
+        }
+        std::unique_lock<std::mutex> lock(impl->mutex);
+        impl->idle_cond.wait(lock, [impl] { return impl->unfinished == 0; });
+    }
+
+    struct ParallelForState
+    {
+        const std::function<void(int, int)> *func;
+        int begin;
+        int end;
+        int grain;
+        int chunks;
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::exception_ptr error;
+
+        // run chunks until no chunk left
+        void work()
+        {
+            while (true)
+            {
+                int c = next.fetch_add(1, std::memory_order_relaxed);
+                if (c >= chunks)
+                    return;
+                int s = begin + c * grain;
+                int e = std::min(s + grain, end);
+                try
+                {
+                    (*func)(s, e);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                }
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == chunks)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cond.notify_all();
+                }
+            }
+        }
+    };
+
+    void Pool::parallel_for(int begin, int end, const std::function<void(int, int)> &func, int grain)
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        int n = end - begin;
+        if (n <= 0)
+            return;
+        int workers = impl->workers.size();
+        if (grain <= 0)
+            grain = std::max(1, n / (workers * 4));
+        int chunks = (n + grain - 1) / grain;
+        if (chunks == 1 || workers == 0)
+        {
+            func(begin, end);
+            return;
+        }
+
+        // state is shared with helper tasks, helpers started after loop finished find no chunk and return
+        auto state = std::make_shared<ParallelForState>();
+        state->func = &func;
+        state->begin = begin;
+        state->end = end;
+        state->grain = grain;
+        state->chunks = chunks;
+        int helpers = std::min(chunks - 1, workers);
+        for (int i = 0; i < helpers; ++i)
+            impl->push([state]() { state->work(); });
+        state->work();
+
+        if (PoolImpl::tl_pool == impl)
+        {
+            // in a worker, run other tasks while waiting so nested parallel_for won't starve
+            while (state->done.load(std::memory_order_acquire) < chunks)
+            {
+                if (!impl->run_pending())
+                    std::this_thread::yield();
+            }
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->cond.wait(lock, [&] { return state->done.load(std::memory_order_acquire) == chunks; });
+        }
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+} // namespace maix::thread
@@ -0,0 +1,331 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add trace profiler, create this file.
+ */
+
+#include "maix_trace.hpp"
+#include "maix_log.hpp"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+namespace maix::trace
+{
+    namespace _priv
+    {
+        std::atomic<bool> enabled(false);
+    }
+
+    enum EventType
+    {
+        EVENT_COMPLETE = 0,
+        EVENT_COUNTER,
+        EVENT_INSTANT,
+    };
+
+    struct Event
+    {
+        const char *name;
+        const char *cat;
+        uint64_t ts;
+        uint64_t dur;
+        double value;
+        uint8_t type;
+    };
+
+    /**
+     * Single producer ring buffer, only owner thread writes,
+     * exporter reads events between tail and head, and drops events overwritten during read.
+     * Each slot has a sequence number, odd while owner thread is writing it, (index + 1) * 2 after written,
+     * exporter only keeps events whose sequence is the expected one before and after copy.
+     */
+    struct ThreadBuffer
+    {
+        int tid;
+        std::string name;
+        std::vector<Event> events;
+        std::unique_ptr<std::atomic<uint64_t>[]> seqs;
+        uint64_t mask;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<bool> alive;
+    };
+
+    // buffers are kept after thread exit so events can still be exported,
+    // dead buffers are reused when too many threads created.
+    static const size_t MAX_DEAD_BUFFERS = 32;
+    static std::mutex _buffers_lock;
+    static std::vector<ThreadBuffer *> _buffers;
+    static std::atomic<int> _buffer_size(16384);
+
+    struct ThreadBufferHolder
+    {
+        ThreadBuffer *buf = nullptr;
+        std::string name;   // set by set_thread_name, buffer is allocated only when first event recorded
+        ~ThreadBufferHolder()
+        {
+            if (buf)
+                buf->alive.store(false);
+        }
+    };
+    static thread_local ThreadBufferHolder _tls;
+
+    static ThreadBuffer *_new_buffer()
+    {
+        uint64_t size = 1;
+        while (size < (uint64_t)_buffer_size.load())
+            size <<= 1;
+        std::lock_guard<std::mutex> lock(_buffers_lock);
+        ThreadBuffer *buf = nullptr;
+        size_t dead = 0;
+        for (auto b : _buffers)
+        {
+            if (!b->alive.load())
+                ++dead;
+        }
+        if (dead >= MAX_DEAD_BUFFERS)
+        {
+            for (size_t i = 0; i < _buffers.size(); ++i)
+            {
+                if (!_buffers[i]->alive.load())
+                {
+                    buf = _buffers[i];
+                    _buffers.erase(_buffers.begin() + i);
+                    break;
+                }
+            }
+        }
+        if (!buf)
+            buf = new ThreadBuffer();
+        buf->tid = (int)syscall(SYS_gettid);
+        char name[32] = {0};
+        if (!_tls.name.empty())
+            buf->name = _tls.name;
+        else
+        {
+            if (pthread_getname_np(pthread_self(), name, sizeof(name)) != 0 || !name[0])
+                snprintf(name, sizeof(name), "thread %d", buf->tid);
+            buf->name = name;
+        }
+        buf->events.resize(size);
+        buf->seqs.reset(new std::atomic<uint64_t>[size]);
+        for (uint64_t i = 0; i < size; ++i)
+            buf->seqs[i].store(0, std::memory_order_relaxed);
+        buf->mask = size - 1;
+        buf->head.store(0);
+        buf->tail.store(0);
+        buf->alive.store(true);
+        _buffers.push_back(buf);
+        return buf;
+    }
+
+    static inline ThreadBuffer *_buffer()
+    {
+        if (!_tls.buf)
+            _tls.buf = _new_buffer();
+        return _tls.buf;
+    }
+
+    static inline void _push(uint8_t type, const char *name, const char *cat, uint64_t ts, uint64_t dur, double value)
+    {
+        ThreadBuffer *buf = _buffer();
+        uint64_t head = buf->head.load(std::memory_order_relaxed);
+        std::atomic<uint64_t> &seq = buf->seqs[head & buf->mask];
+        Event &e = buf->events[head & buf->mask];
+        seq.store(head * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        e.name = name;
+        e.cat = cat;
+        e.ts = ts;
+        e.dur = dur;
+        e.value = value;
+        e.type = type;
+        seq.store(head * 2 + 2, std::memory_order_release);
+        buf->head.store(head + 1, std::memory_order_release);
+    }
+
+    uint64_t _priv::now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    void _priv::complete(const char *name, const char *cat, uint64_t start_ns, uint64_t end_ns)
+    {
+        _push(EVENT_COMPLETE, name, cat, start_ns, end_ns - start_ns, 0);
+    }
+
+    void enable(bool en)
+    {
+        _priv::enabled.store(en);
+    }
+
+    void set_buffer_size(int events)
+    {
+        if (events < 16)
+            events = 16;
+        _buffer_size.store(events);
+    }
+
+    void set_thread_name(const std::string &name)
+    {
+        _tls.name = name;
+        if (!_tls.buf)
+            return;
+        std::lock_guard<std::mutex> lock(_buffers_lock);
+        _tls.buf->name = name;
+    }
+
+    void counter(const char *name, double value)
+    {
+        if (!is_enabled())
+            return;
+        _push(EVENT_COUNTER, name, "counter", _priv::now_ns(), 0, value);
+    }
+
+    void instant(const char *name, const char *cat)
+    {
+        if (!is_enabled())
+            return;
+        _push(EVENT_INSTANT, name, cat, _priv::now_ns(), 0, 0);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(_buffers_lock);
+        for (auto buf : _buffers)
+            buf->tail.store(buf->head.load(std::memory_order_acquire));
+    }
+
+    static void _append_escaped(std::string &out, const char *s)
+    {
+        for (; *s; ++s)
+        {
+            char c = *s;
+            if (c == '"' || c == '\\')
+                out.push_back('\\');
+            else if ((unsigned char)c < 0x20)
+                continue;
+            out.push_back(c);
+        }
+    }
+
+    std::string to_json()
+    {
+        std::string json;
+        json.reserve(1024 * 1024);
+        json += "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        int pid = (int)getpid();
+        char buf[256];
+        bool first = true;
+        std::vector<Event> events;
+        std::lock_guard<std::mutex> lock(_buffers_lock);
+        for (auto b : _buffers)
+        {
+            // events before head - cap are overwritten, slots overwritten or being written during copy
+            // are found by sequence number and dropped
+            uint64_t head = b->head.load(std::memory_order_acquire);
+            uint64_t cap = b->mask + 1;
+            uint64_t start = b->tail.load();
+            if (head > cap && head - cap > start)
+                start = head - cap;
+            events.clear();
+            for (uint64_t i = start; i < head; ++i)
+            {
+                std::atomic<uint64_t> &seq = b->seqs[i & b->mask];
+                if (seq.load(std::memory_order_acquire) != i * 2 + 2)
+                    continue;
+                Event e = b->events[i & b->mask];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) != i * 2 + 2)
+                    continue;
+                events.push_back(e);
+            }
+
+            snprintf(buf, sizeof(buf), "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"", first ? "" : ",\n", pid, b->tid);
+            first = false;
+            json += buf;
+            _append_escaped(json, b->name.c_str());
+            json += "\"}}";
+            for (size_t i = 0; i < events.size(); ++i)
+            {
+                const Event &e = events[i];
+                json += ",\n{\"name\": \"";
+                _append_escaped(json, e.name);
+                json += "\", \"cat\": \"";
+                _append_escaped(json, e.cat);
+                switch (e.type)
+                {
+                case EVENT_COMPLETE:
+                    snprintf(buf, sizeof(buf), "\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d}",
+                             e.ts / 1000.0, e.dur / 1000.0, pid, b->tid);
+                    break;
+                case EVENT_COUNTER:
+                    snprintf(buf, sizeof(buf), "\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d, \"args\": {\"value\": %.6g}}",
+                             e.ts / 1000.0, pid, b->tid, e.value);
+                    break;
+                default:
+                    snprintf(buf, sizeof(buf), "\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d}",
+                             e.ts / 1000.0, pid, b->tid);
+                    break;
+                }
+                json += buf;
+            }
+        }
+        json += "\n]}\n";
+        return json;
+    }
+
+    err::Err dump(const std::string &path)
+    {
+        std::string json = to_json();
+        FILE *f = fopen(path.c_str(), "w");
+        if (!f)
+        {
+            log::error("open %s failed", path.c_str());
+            return err::ERR_IO;
+        }
+        size_t n = fwrite(json.data(), 1, json.size(), f);
+        fclose(f);
+        if (n != json.size())
+        {
+            log::error("write %s failed", path.c_str());
+            return err::ERR_IO;
+        }
+        log::info("trace saved to %s", path.c_str());
+        return err::ERR_NONE;
+    }
+
+    // MAIX_TRACE=/path/to/trace.json enable trace at startup and dump at exit
+    static std::string _env_dump_path;
+
+    static void _dump_at_exit()
+    {
+        enable(false);
+        dump(_env_dump_path);
+    }
+
+    static struct EnvInit
+    {
+        EnvInit()
+        {
+            const char *path = getenv("MAIX_TRACE");
+            if (!path || !path[0])
+                return;
+            _env_dump_path = path;
+            enable(true);
+            atexit(_dump_at_exit);
+        }
+    } _env_init;
+} // namespace maix::trace
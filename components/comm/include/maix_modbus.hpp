@@ -6,6 +6,13 @@
 #include <memory>
 #include <thread>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 
 #include "maix_err.hpp"
 #include "modbus/modbus.h"
@@ -387,6 +394,197 @@ namespace maix::comm::modbus {
         bool tcp_listener_need_exit_{false};
     };
 
+    /**
+     * @brief Register tables of SlaveTCP, index 0 is the start address of each table.
+     *
+     * @maixcdk maix.comm.modbus.RegisterMap
+     */
+    struct RegisterMap {
+        std::vector<uint8_t> coils;                 ///< Coils, one byte per coil, 0 or 1
+        std::vector<uint8_t> discrete_inputs;       ///< Discrete inputs, one byte per input, 0 or 1
+        std::vector<uint16_t> holding_registers;    ///< Holding registers
+        std::vector<uint16_t> input_registers;      ///< Input registers
+    };
+
+    /**
+     * @brief Multi-client Modbus TCP slave(server).
+     *
+     * Unlike Slave in TCP mode which serves only one master at a time, SlaveTCP serves many masters
+     * on one epoll event loop thread. Masters can send several requests without waiting for the responses(pipelining),
+     * responses are sent in request order.
+     *
+     * Registers are double buffered: requests read a consistent snapshot without lock, so the application
+     * can update registers at any time without blocking request handling. Every write, from application or from master,
+     * is committed atomically, use update() to change several registers in one commit, e.g. a 32-bit value.
+     *
+     * Supported functions: read coils(0x01), read discrete inputs(0x02), read holding registers(0x03),
+     * read input registers(0x04), write single coil(0x05), write single register(0x06), write multiple coils(0x0F),
+     * write multiple registers(0x10), mask write register(0x16), read/write multiple registers(0x17).
+     * Unit identifier is not checked.
+     *
+     * @maixcdk maix.comm.modbus.SlaveTCP
+     */
+    class SlaveTCP final {
+    public:
+        /**
+         * @brief Construct a new SlaveTCP object, start serving.
+         *
+         * @param registers Start addresses and sizes of coils, discrete inputs, holding registers and input registers.
+         * @param port The TCP port to listen. Default is 502.
+         * @param ip The IP to bind, empty string means all interfaces.
+         * @param max_clients Max number of connected masters, new connections beyond it are closed immediately.
+         * @param debug A boolean flag to enable or disable debug log. Default is false.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.SlaveTCP
+         */
+        SlaveTCP(const Registers& registers, int port=502, const std::string& ip="",
+                int max_clients=16, bool debug=false);
+
+        SlaveTCP(const SlaveTCP&) = delete;
+        SlaveTCP& operator=(const SlaveTCP&) = delete;
+
+        ~SlaveTCP();
+
+        /**
+         * @brief Stop serving, close all connections. Called by destructor automatically.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.stop
+         */
+        void stop();
+
+        /**
+         * @brief Set callback called after a master request wrote registers.
+         *
+         * Callback runs in event loop thread, keep it short, it blocks serving all masters.
+         * Set before masters connect, it's not thread safe with a running request.
+         *
+         * @param callback Arguments are request type, start address and number of written coils or registers.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.set_write_callback
+         */
+        void set_write_callback(std::function<void(RequestType, uint32_t, uint32_t)> callback);
+
+        /**
+         * @brief Reads from or writes to coils, same as Slave::coils.
+         *
+         * @param data A vector of data to be written. If empty, a read operation is performed.
+         * @param index The starting index for writing data, relative to coils start address.
+         *
+         * @return Read result when reading. When writing, a non-empty list on success and an empty list on failure.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.coils
+         */
+        std::vector<uint8_t> coils(const std::vector<uint8_t>& data = std::vector<uint8_t>{}, const uint32_t index = 0);
+
+        /**
+         * @brief Reads from or writes to discrete input, same as Slave::discrete_input.
+         *
+         * @param data A vector of data to be written. If empty, a read operation is performed.
+         * @param index The starting index for writing data, relative to discrete inputs start address.
+         *
+         * @return Read result when reading. When writing, a non-empty list on success and an empty list on failure.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.discrete_input
+         */
+        std::vector<uint8_t> discrete_input(const std::vector<uint8_t>& data = std::vector<uint8_t>{}, const uint32_t index = 0);
+
+        /**
+         * @brief Reads from or writes to input registers, same as Slave::input_registers.
+         *
+         * @param data A vector of data to be written. If empty, a read operation is performed.
+         * @param index The starting index for writing data, relative to input registers start address.
+         *
+         * @return Read result when reading. When writing, a non-empty list on success and an empty list on failure.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.input_registers
+         */
+        std::vector<uint16_t> input_registers(const std::vector<uint16_t>& data = std::vector<uint16_t>{}, const uint32_t index = 0);
+
+        /**
+         * @brief Reads from or writes to holding registers, same as Slave::holding_registers.
+         *
+         * @param data A vector of data to be written. If empty, a read operation is performed.
+         * @param index The starting index for writing data, relative to holding registers start address.
+         *
+         * @return Read result when reading. When writing, a non-empty list on success and an empty list on failure.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.holding_registers
+         */
+        std::vector<uint16_t> holding_registers(const std::vector<uint16_t>& data = std::vector<uint16_t>{}, const uint32_t index = 0);
+
+        /**
+         * @brief Modify several tables or registers in one commit, masters see all or none of the changes.
+         *
+         * @param func Modify the tables in place, don't resize them. Runs with write lock held, keep it short.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.update
+         */
+        void update(const std::function<void(RegisterMap&)>& func);
+
+        /**
+         * @brief Get a consistent copy of all tables.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.snapshot
+         */
+        RegisterMap snapshot();
+
+        /**
+         * @brief Number of connected masters.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.client_num
+         */
+        int client_num() const noexcept;
+
+        /**
+         * @brief Number of requests served since start, including exception responses.
+         *
+         * @maixcdk maix.comm.modbus.SlaveTCP.request_count
+         */
+        uint64_t request_count() const noexcept;
+
+    private:
+        struct Client;
+        struct Dirty {
+            int table;
+            uint32_t start;
+            uint32_t size;
+        };
+
+        const std::string TAG() const noexcept;
+        void listen_init(const std::string& ip, int port);
+        void loop();
+        void accept_clients();
+        void close_client(Client* client);
+        bool read_client(Client* client);
+        bool flush_client(Client* client);
+        bool parse_client(Client* client);
+        int process(const uint8_t* pdu, int len, uint8_t* rsp);
+        int acquire() noexcept;
+        void release(int idx) noexcept;
+        void commit(const Dirty& dirty, const std::function<void(RegisterMap&)>& func);
+        void sync_back(RegisterMap& back, const RegisterMap& front, const Dirty& dirty);
+        template <typename T>
+        std::vector<T> access(int table, const std::vector<T>& data, uint32_t index);
+
+    private:
+        Registers registers_info_;
+        bool debug_;
+        int max_clients_;
+        int listen_fd_{-1};
+        int epoll_fd_{-1};
+        int event_fd_{-1};
+        RegisterMap banks_[2];
+        std::atomic<int> front_{0};
+        std::atomic<int> readers_[2];
+        std::mutex write_mutex_;
+        std::vector<Dirty> last_dirty_;
+        std::vector<std::unique_ptr<Client>> clients_;
+        std::atomic<int> client_num_{0};
+        std::atomic<uint64_t> request_count_{0};
+        std::function<void(RequestType, uint32_t, uint32_t)> write_callback_;
+        std::unique_ptr<std::thread> loop_thread_{nullptr};
+    };
+
     /**
      * @brief Set the master debug ON/OFF
      *
@@ -1032,6 +1230,219 @@ namespace maix::comm::modbus {
     private:
         int port_;
     };
+
+    /**
+     * @brief Scan list poller for modbus masters.
+     *
+     * Declare the coils, discrete inputs, holding registers and input registers needed from each slave with a poll period,
+     * Scanner merges adjacent and overlapping ranges of the same slave, function and period into as few requests as possible
+     * within protocol limits, polls them in a background thread or by scan(), and keeps the results in a cache with timestamps.
+     *
+     * In TCP mode, one connection to ip:port is used and slave id is the unit identifier,
+     * up to max_inflight requests are sent without waiting for responses and matched by transaction id.
+     * In RTU mode, requests are sent one by one on the bus, a slave which timed out is skipped until its next period,
+     * so an offline device costs one timeout per period instead of one per request.
+     *
+     * @maixcdk maix.comm.modbus.Scanner
+     */
+    class Scanner final {
+    public:
+        /**
+         * @brief Construct a new Scanner object
+         *
+         * @param mode RTU or TCP.
+         * @param ip_or_device UART device in RTU mode, slave IP in TCP mode.
+         * @param baudrate_or_port UART baudrate in RTU mode, TCP port in TCP mode.
+         * @param timeout_ms Response timeout of one request.
+         * @param max_gap Max number of unneeded coils or registers between two ranges to merge them into one request,
+         *                reading a few extra registers is usually cheaper than another request.
+         * @param max_inflight Max number of requests sent without response in TCP mode, 1 means no pipelining.
+         * @param debug A boolean flag to enable or disable debug log. Default is false.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.Scanner
+         */
+        Scanner(Mode mode, const std::string& ip_or_device, int baudrate_or_port,
+                int timeout_ms=1000, int max_gap=8, int max_inflight=8, bool debug=false);
+
+        Scanner(const Scanner&) = delete;
+        Scanner& operator=(const Scanner&) = delete;
+
+        ~Scanner();
+
+        /**
+         * @brief Add a range to scan list, must be called before start().
+         *
+         * @param slave_id Slave id in RTU mode, unit identifier in TCP mode.
+         * @param type One of READ_COILS, READ_DISCRETE_INPUTS, READ_HOLDING_REGISTERS and READ_INPUT_REGISTERS.
+         * @param addr Start address.
+         * @param size Number of coils or registers.
+         * @param period_ms Poll period.
+         *
+         * @return maix::err::Err type, err::ERR_ARGS if arguments invalid, err::ERR_BUSY if already started.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.add
+         */
+        ::maix::err::Err add(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size, int period_ms);
+
+        /**
+         * @brief Start polling in background thread.
+         *
+         * @return maix::err::Err type, err::ERR_BUSY if already started.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.start
+         */
+        ::maix::err::Err start();
+
+        /**
+         * @brief Stop background polling, called by destructor automatically.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.stop
+         */
+        void stop();
+
+        /**
+         * @brief Poll all requests whose period is due once in caller thread, use it instead of start().
+         *
+         * @return maix::err::Err type, err::ERR_NONE if all due requests succeeded, else error of the last failed one.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.scan
+         */
+        ::maix::err::Err scan();
+
+        /**
+         * @brief Get cached coils or discrete inputs.
+         *
+         * @param slave_id Slave id.
+         * @param type READ_COILS or READ_DISCRETE_INPUTS.
+         * @param addr Start address, the range must be inside a range added by add().
+         * @param size Number of coils or discrete inputs.
+         * @param values Output values, 0 or 1.
+         * @param timestamp_us Output time::ticks_us() of the response, can be nullptr.
+         *
+         * @return maix::err::Err type, err::ERR_NOT_FOUND if range not in scan list,
+         *         err::ERR_NOT_READY if never read successfully, in this case error of last request is logged.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.get_bits
+         */
+        ::maix::err::Err get_bits(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size,
+                                std::vector<uint8_t>& values, uint64_t* timestamp_us=nullptr);
+
+        /**
+         * @brief Get cached holding registers or input registers.
+         *
+         * @param slave_id Slave id.
+         * @param type READ_HOLDING_REGISTERS or READ_INPUT_REGISTERS.
+         * @param addr Start address, the range must be inside a range added by add().
+         * @param size Number of registers.
+         * @param values Output values.
+         * @param timestamp_us Output time::ticks_us() of the response, can be nullptr.
+         *
+         * @return maix::err::Err type, same as get_bits.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.get_registers
+         */
+        ::maix::err::Err get_registers(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size,
+                                    std::vector<uint16_t>& values, uint64_t* timestamp_us=nullptr);
+
+        /**
+         * @brief Get a cached value of type T from consecutive registers, e.g. uint16_t, int16_t, uint32_t, int32_t, float, double.
+         *
+         * @param slave_id Slave id.
+         * @param type READ_HOLDING_REGISTERS or READ_INPUT_REGISTERS.
+         * @param addr Address of the first register.
+         * @param value Output value.
+         * @param word_swap Registers are big endian, multi-register values are high word first by default,
+         *                  set true for low word first devices.
+         * @param timestamp_us Output time::ticks_us() of the response, can be nullptr.
+         *
+         * @return maix::err::Err type, same as get_bits.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.get
+         */
+        template <typename T>
+        ::maix::err::Err get(uint32_t slave_id, RequestType type, uint32_t addr, T& value,
+                            bool word_swap=false, uint64_t* timestamp_us=nullptr)
+        {
+            static_assert(sizeof(T) % 2 == 0 && std::is_trivially_copyable<T>::value, "T must be made of 16-bit registers");
+            constexpr uint32_t words = sizeof(T) / 2;
+            std::vector<uint16_t> regs;
+            ::maix::err::Err e = this->get_registers(slave_id, type, addr, words, regs, timestamp_us);
+            if (e != ::maix::err::Err::ERR_NONE)
+                return e;
+            // compose big endian words into an integer, then copy its bits so it works for float and double too
+            uint64_t bits = 0;
+            for (uint32_t i = 0; i < words; ++i)
+                bits = (bits << 16) | regs[word_swap ? words - 1 - i : i];
+            if constexpr (sizeof(T) == 2) {
+                uint16_t v = static_cast<uint16_t>(bits);
+                std::memcpy(&value, &v, sizeof(T));
+            } else if constexpr (sizeof(T) == 4) {
+                uint32_t v = static_cast<uint32_t>(bits);
+                std::memcpy(&value, &v, sizeof(T));
+            } else {
+                std::memcpy(&value, &bits, sizeof(T));
+            }
+            return ::maix::err::Err::ERR_NONE;
+        }
+
+        /**
+         * @brief Number of requests after merging, one request is sent for each per period.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.request_num
+         */
+        int request_num();
+
+        /**
+         * @brief Number of requests sent and number of failed ones since construct.
+         *
+         * @maixcdk maix.comm.modbus.Scanner.stats
+         */
+        std::pair<uint64_t, uint64_t> stats();
+
+    private:
+        struct Item {
+            uint8_t slave;
+            uint8_t function;
+            uint32_t addr;
+            uint32_t size;
+            int period_ms;
+        };
+        struct Block;
+
+        const std::string TAG() const noexcept;
+        void build();
+        Block* find(uint32_t slave_id, RequestType type, uint32_t addr);
+        ::maix::err::Err scan_rtu(std::vector<Block*>& due);
+        ::maix::err::Err scan_tcp(std::vector<Block*>& due);
+        ::maix::err::Err tcp_connect();
+        void tcp_close();
+        void finish(Block* block, ::maix::err::Err e, const void* values);
+
+    private:
+        Mode mode_;
+        std::string ip_or_device_;
+        int baudrate_or_port_;
+        int timeout_ms_;
+        int max_gap_;
+        int max_inflight_;
+        bool debug_;
+        std::vector<Item> items_;
+        std::vector<std::unique_ptr<Block>> blocks_;
+        std::atomic<bool> built_{false};   // written under scan_mutex_, read under cache_mutex_
+        std::mutex cache_mutex_;
+        std::mutex scan_mutex_;
+        std::unique_ptr<modbus_t, decltype(&modbus_free)>
+            ctx_{nullptr, &modbus_free};
+        int socket_{-1};
+        uint16_t next_tid_{0};
+        std::vector<uint8_t> rx_buff_;
+        uint64_t request_count_{0};
+        uint64_t error_count_{0};
+        bool thread_exit_{false};
+        std::mutex thread_mutex_;
+        std::condition_variable thread_cond_;
+        std::unique_ptr<std::thread> thread_{nullptr};
+    };
 }
 
 
@@ -635,7 +635,10 @@ namespace maix::comm
                 break;
         }
         if (msg)
+        {
+            MAIX_TRACE_SCOPE("comm.execute_cmd", "comm");
             this->execute_cmd(msg);
+        }
         return msg;
     }
 
@@ -785,6 +788,7 @@ namespace maix::comm
         int timeout = 50; // 50 ms for fast exit at program start if user want comm to exit. after 3s, timeout will be 500ms to reduce cpu usage.
         uint64_t _t0 = time::ticks_ms();
         bool flag = false;
+        trace::set_thread_name("comm");
         while (!maix::app::need_exit() && !_comm_loop_need_exit)
         {
             try
@@ -7,6 +7,16 @@
 #include <limits>           // std::numeric_limits
 #include <sys/select.h>     // select
 #include <sstream>          // std::stringstream
+#include <algorithm>        // std::copy
+#include <sys/epoll.h>      // epoll
+#include <sys/eventfd.h>    // eventfd
+#include <sys/socket.h>     // socket
+#include <netinet/in.h>     // sockaddr_in
+#include <netinet/tcp.h>    // TCP_NODELAY
+#include <arpa/inet.h>      // inet_pton
+#include <poll.h>           // poll
+#include <chrono>           // std::chrono
+#include "maix_time.hpp"
 
 namespace maix::comm::modbus {
 
@@ -488,6 +498,672 @@ std::vector<uint16_t> Slave::holding_registers(const std::vector<uint16_t>& data
     return this->ctx_.get();
 }
 
+/****************************** SlaveTCP *********************************/
+
+enum {
+    TABLE_ALL = -1,
+    TABLE_COILS = 0,
+    TABLE_DISCRETE_INPUTS,
+    TABLE_HOLDING_REGISTERS,
+    TABLE_INPUT_REGISTERS,
+};
+
+// MBAP header: transaction id(2) + protocol id(2) + length(2) + unit id(1)
+static constexpr int MBAP_HEADER_LEN = 7;
+static constexpr int MAX_PDU_LEN = 253;
+static constexpr size_t CLIENT_IN_BUFF_SIZE = 4096;
+// stop reading a client when this many response bytes are not sent yet
+static constexpr size_t CLIENT_MAX_PENDING_OUT = 64 * 1024;
+
+struct SlaveTCP::Client {
+    int fd{-1};
+    uint32_t events{0};
+    bool paused{false};
+    std::vector<uint8_t> in;
+    size_t in_len{0};
+    std::vector<uint8_t> out;
+    size_t out_pos{0};
+};
+
+static inline uint16_t __get_u16__(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static inline void __set_u16__(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+static inline bool __in_range__(const RegisterInfo& info, uint32_t addr, uint32_t size)
+{
+    // compare offsets instead of end addresses, sums could overflow uint32
+    return addr >= info.start_address && size <= info.size && addr - info.start_address <= info.size - size;
+}
+
+static inline int __exception_rsp__(uint8_t* rsp, uint8_t function, uint8_t code)
+{
+    rsp[0] = function | 0x80;
+    rsp[1] = code;
+    return 2;
+}
+
+template <typename T>
+static std::vector<T>& __table_of__(RegisterMap& map, int table)
+{
+    if constexpr (sizeof(T) == 1)
+        return table == TABLE_COILS ? map.coils : map.discrete_inputs;
+    else
+        return table == TABLE_HOLDING_REGISTERS ? map.holding_registers : map.input_registers;
+}
+
+const std::string SlaveTCP::TAG() const noexcept
+{
+    return "[Maix Modbus SlaveTCP]";
+}
+
+SlaveTCP::SlaveTCP(const Registers& registers, int port, const std::string& ip,
+                int max_clients, bool debug)
+{
+    this->registers_info_ = registers;
+    this->debug_ = debug;
+    this->max_clients_ = max_clients > 0 ? max_clients : 1;
+    for (auto& bank : this->banks_) {
+        bank.coils.assign(registers.coils.size, 0);
+        bank.discrete_inputs.assign(registers.discrete_inputs.size, 0);
+        bank.holding_registers.assign(registers.holding_registers.size, 0);
+        bank.input_registers.assign(registers.input_registers.size, 0);
+    }
+    this->readers_[0].store(0);
+    this->readers_[1].store(0);
+
+    this->listen_init(ip, port);
+    this->loop_thread_ = std::make_unique<std::thread>([this](){
+        this->loop();
+    });
+}
+
+SlaveTCP::~SlaveTCP()
+{
+    this->stop();
+}
+
+void SlaveTCP::listen_init(const std::string& ip, int port)
+{
+    if (this->debug_) {
+        log::info("%s Listen: %s:%d, max clients: %d",
+            this->TAG().c_str(), ip.empty() ? "0.0.0.0" : ip.c_str(), port, this->max_clients_);
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (ip.empty()) {
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    } else if (::inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        __error_and_throw__(this->TAG()+" Invalid ip: "+ip);
+    }
+
+    this->listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (this->listen_fd_ < 0) {
+        __error_and_throw__(this->TAG()+" Create socket failed!"+std::string(std::strerror(errno)));
+    }
+    int enable = 1;
+    ::setsockopt(this->listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (::bind(this->listen_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+        || ::listen(this->listen_fd_, this->max_clients_) < 0) {
+        const std::string msg(this->TAG()+" Listen port "+std::to_string(port)+" failed!"+std::string(std::strerror(errno)));
+        ::close(this->listen_fd_);
+        this->listen_fd_ = -1;
+        __error_and_throw__(msg);
+    }
+
+    this->epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    this->event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->epoll_fd_ < 0 || this->event_fd_ < 0) {
+        const std::string msg(this->TAG()+" Create epoll failed!"+std::string(std::strerror(errno)));
+        this->stop();
+        __error_and_throw__(msg);
+    }
+
+    // listen socket is marked by nullptr, stop event by event_fd_ address, others are clients
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    ::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, this->listen_fd_, &ev);
+    ev.data.ptr = &this->event_fd_;
+    ::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, this->event_fd_, &ev);
+}
+
+void SlaveTCP::stop()
+{
+    if (this->loop_thread_ != nullptr) {
+        uint64_t one = 1;
+        if (::write(this->event_fd_, &one, sizeof(one)) < 0)
+            log::warn("%s notify event loop failed!%s", this->TAG().c_str(), std::strerror(errno));
+        this->loop_thread_->join();
+        this->loop_thread_.reset();
+    }
+    for (auto& client : this->clients_)
+        ::close(client->fd);
+    this->clients_.clear();
+    this->client_num_.store(0);
+    for (int* fd : {&this->listen_fd_, &this->epoll_fd_, &this->event_fd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void SlaveTCP::set_write_callback(std::function<void(RequestType, uint32_t, uint32_t)> callback)
+{
+    this->write_callback_ = std::move(callback);
+}
+
+void SlaveTCP::loop()
+{
+    struct epoll_event events[32];
+    while (true) {
+        int n = ::epoll_wait(this->epoll_fd_, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            log::error("%s epoll wait failed!%s", this->TAG().c_str(), std::strerror(errno));
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            void* ptr = events[i].data.ptr;
+            if (ptr == &this->event_fd_)
+                return;
+            if (ptr == nullptr) {
+                this->accept_clients();
+                continue;
+            }
+            Client* client = static_cast<Client*>(ptr);
+            uint32_t ev = events[i].events;
+            bool ok = true;
+            if (ev & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                ok = this->read_client(client);
+            if (ok && (ev & EPOLLOUT))
+                ok = this->flush_client(client);
+            if (!ok)
+                this->close_client(client);
+        }
+    }
+}
+
+void SlaveTCP::accept_clients()
+{
+    while (true) {
+        int fd = ::accept4(this->listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                log::warn("%s tcp accept failed!%s", this->TAG().c_str(), std::strerror(errno));
+            return;
+        }
+        if (static_cast<int>(this->clients_.size()) >= this->max_clients_) {
+            log::warn("%s too many clients, max %d, close new connection", this->TAG().c_str(), this->max_clients_);
+            ::close(fd);
+            continue;
+        }
+        int enable = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        client->events = EPOLLIN;
+        client->in.resize(CLIENT_IN_BUFF_SIZE);
+        struct epoll_event ev;
+        ev.events = client->events;
+        ev.data.ptr = client.get();
+        if (::epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            log::warn("%s epoll add client failed!%s", this->TAG().c_str(), std::strerror(errno));
+            ::close(fd);
+            continue;
+        }
+        this->clients_.push_back(std::move(client));
+        this->client_num_.store(static_cast<int>(this->clients_.size()));
+        if (this->debug_) {
+            log::info("%s new tcp connected, fd: %d, clients: %zu", this->TAG().c_str(), fd, this->clients_.size());
+        }
+    }
+}
+
+void SlaveTCP::close_client(Client* client)
+{
+    if (this->debug_) {
+        log::info("%s tcp disconnected, fd: %d", this->TAG().c_str(), client->fd);
+    }
+    ::epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, client->fd, nullptr);
+    ::close(client->fd);
+    for (size_t i = 0; i < this->clients_.size(); ++i) {
+        if (this->clients_[i].get() == client) {
+            this->clients_[i] = std::move(this->clients_.back());
+            this->clients_.pop_back();
+            break;
+        }
+    }
+    this->client_num_.store(static_cast<int>(this->clients_.size()));
+}
+
+bool SlaveTCP::read_client(Client* client)
+{
+    while (!client->paused && client->in_len < client->in.size()) {
+        ssize_t n = ::recv(client->fd, client->in.data() + client->in_len, client->in.size() - client->in_len, 0);
+        if (n > 0) {
+            client->in_len += n;
+            if (!this->parse_client(client))
+                return false;
+            continue;
+        }
+        if (n == 0)
+            return false;
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        return false;
+    }
+    // responses of all requests in this read are sent together
+    return this->flush_client(client);
+}
+
+bool SlaveTCP::parse_client(Client* client)
+{
+    size_t pos = 0;
+    while (!client->paused && client->in_len - pos >= MBAP_HEADER_LEN) {
+        const uint8_t* adu = client->in.data() + pos;
+        uint16_t protocol = __get_u16__(adu + 2);
+        uint16_t length = __get_u16__(adu + 4);
+        if (protocol != 0 || length < 2 || length > MAX_PDU_LEN + 1) {
+            log::warn("%s invalid MBAP header, protocol: %u, length: %u, close connection",
+                this->TAG().c_str(), protocol, length);
+            return false;
+        }
+        if (client->in_len - pos < 6u + length)
+            break;
+
+        size_t off = client->out.size();
+        client->out.resize(off + MBAP_HEADER_LEN + MAX_PDU_LEN);
+        uint8_t* rsp = client->out.data() + off;
+        int rsp_len = this->process(adu + MBAP_HEADER_LEN, length - 1, rsp + MBAP_HEADER_LEN);
+        std::memcpy(rsp, adu, 4);
+        __set_u16__(rsp + 4, static_cast<uint16_t>(rsp_len + 1));
+        rsp[6] = adu[6];
+        client->out.resize(off + MBAP_HEADER_LEN + rsp_len);
+        this->request_count_.fetch_add(1, std::memory_order_relaxed);
+
+        pos += 6 + length;
+        if (client->out.size() - client->out_pos >= CLIENT_MAX_PENDING_OUT)
+            client->paused = true;
+    }
+    if (pos > 0) {
+        client->in_len -= pos;
+        std::memmove(client->in.data(), client->in.data() + pos, client->in_len);
+    }
+    return true;
+}
+
+bool SlaveTCP::flush_client(Client* client)
+{
+    while (true) {
+        while (client->out_pos < client->out.size()) {
+            ssize_t n = ::send(client->fd, client->out.data() + client->out_pos,
+                            client->out.size() - client->out_pos, MSG_NOSIGNAL);
+            if (n > 0) {
+                client->out_pos += n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            return false;
+        }
+        if (client->out_pos == client->out.size()) {
+            client->out.clear();
+            client->out_pos = 0;
+        } else if (client->out_pos >= client->out.size() / 2) {
+            client->out.erase(client->out.begin(), client->out.begin() + client->out_pos);
+            client->out_pos = 0;
+        }
+        // resume requests left in buffer when paused by too many unsent responses
+        if (client->paused && client->out.size() - client->out_pos < CLIENT_MAX_PENDING_OUT) {
+            client->paused = false;
+            if (!this->parse_client(client))
+                return false;
+            if (client->out_pos < client->out.size())
+                continue;
+        }
+        break;
+    }
+
+    uint32_t events = 0;
+    if (!client->paused)
+        events |= EPOLLIN;
+    if (client->out_pos < client->out.size())
+        events |= EPOLLOUT;
+    if (events != client->events) {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = client;
+        if (::epoll_ctl(this->epoll_fd_, EPOLL_CTL_MOD, client->fd, &ev) < 0)
+            return false;
+        client->events = events;
+    }
+    return true;
+}
+
+int SlaveTCP::process(const uint8_t* pdu, int len, uint8_t* rsp)
+{
+    const uint8_t function = pdu[0];
+    const auto callback = [this](RequestType type, uint32_t addr, uint32_t size) {
+        if (this->write_callback_)
+            this->write_callback_(type, addr, size);
+    };
+
+    switch (static_cast<RequestType>(function)) {
+    case RequestType::READ_COILS:
+    case RequestType::READ_DISCRETE_INPUTS: {
+        if (len != 5)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        bool is_coils = function == static_cast<uint8_t>(RequestType::READ_COILS);
+        const RegisterInfo& info = is_coils ? this->registers_info_.coils : this->registers_info_.discrete_inputs;
+        uint32_t addr = __get_u16__(pdu + 1);
+        uint32_t size = __get_u16__(pdu + 3);
+        if (size < 1 || size > MODBUS_MAX_READ_BITS)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, addr, size))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        int bytes = (size + 7) / 8;
+        rsp[0] = function;
+        rsp[1] = static_cast<uint8_t>(bytes);
+        std::memset(rsp + 2, 0, bytes);
+        int idx = this->acquire();
+        const std::vector<uint8_t>& bits = is_coils ? this->banks_[idx].coils : this->banks_[idx].discrete_inputs;
+        const uint8_t* src = bits.data() + (addr - info.start_address);
+        for (uint32_t i = 0; i < size; ++i) {
+            if (src[i])
+                rsp[2 + i / 8] |= 1 << (i % 8);
+        }
+        this->release(idx);
+        return 2 + bytes;
+    }
+    case RequestType::READ_HOLDING_REGISTERS:
+    case RequestType::READ_INPUT_REGISTERS: {
+        if (len != 5)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        bool is_holding = function == static_cast<uint8_t>(RequestType::READ_HOLDING_REGISTERS);
+        const RegisterInfo& info = is_holding ? this->registers_info_.holding_registers : this->registers_info_.input_registers;
+        uint32_t addr = __get_u16__(pdu + 1);
+        uint32_t size = __get_u16__(pdu + 3);
+        if (size < 1 || size > MODBUS_MAX_READ_REGISTERS)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, addr, size))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        rsp[0] = function;
+        rsp[1] = static_cast<uint8_t>(size * 2);
+        int idx = this->acquire();
+        const std::vector<uint16_t>& regs = is_holding ? this->banks_[idx].holding_registers : this->banks_[idx].input_registers;
+        const uint16_t* src = regs.data() + (addr - info.start_address);
+        for (uint32_t i = 0; i < size; ++i)
+            __set_u16__(rsp + 2 + i * 2, src[i]);
+        this->release(idx);
+        return 2 + size * 2;
+    }
+    case RequestType::WRITE_SINGLE_COIL: {
+        if (len != 5)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.coils;
+        uint32_t addr = __get_u16__(pdu + 1);
+        uint16_t value = __get_u16__(pdu + 3);
+        if (value != 0xFF00 && value != 0x0000)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, addr, 1))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t offset = addr - info.start_address;
+        this->commit(Dirty{TABLE_COILS, offset, 1}, [&](RegisterMap& map) {
+            map.coils[offset] = value ? 1 : 0;
+        });
+        callback(RequestType::WRITE_SINGLE_COIL, addr, 1);
+        std::memcpy(rsp, pdu, 5);
+        return 5;
+    }
+    case RequestType::WRITE_SINGLE_REGISTER: {
+        if (len != 5)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.holding_registers;
+        uint32_t addr = __get_u16__(pdu + 1);
+        if (!__in_range__(info, addr, 1))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t offset = addr - info.start_address;
+        this->commit(Dirty{TABLE_HOLDING_REGISTERS, offset, 1}, [&](RegisterMap& map) {
+            map.holding_registers[offset] = __get_u16__(pdu + 3);
+        });
+        callback(RequestType::WRITE_SINGLE_REGISTER, addr, 1);
+        std::memcpy(rsp, pdu, 5);
+        return 5;
+    }
+    case RequestType::WRITE_MULTIPLE_COILS: {
+        if (len < 6)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.coils;
+        uint32_t addr = __get_u16__(pdu + 1);
+        uint32_t size = __get_u16__(pdu + 3);
+        uint32_t bytes = pdu[5];
+        if (size < 1 || size > MODBUS_MAX_WRITE_BITS || bytes != (size + 7) / 8 || len != static_cast<int>(6 + bytes))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, addr, size))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t offset = addr - info.start_address;
+        this->commit(Dirty{TABLE_COILS, offset, size}, [&](RegisterMap& map) {
+            for (uint32_t i = 0; i < size; ++i)
+                map.coils[offset + i] = (pdu[6 + i / 8] >> (i % 8)) & 0x01;
+        });
+        callback(RequestType::WRITE_MULTIPLE_COILS, addr, size);
+        std::memcpy(rsp, pdu, 5);
+        return 5;
+    }
+    case RequestType::WRITE_MULTIPLE_REGISTERS: {
+        if (len < 6)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.holding_registers;
+        uint32_t addr = __get_u16__(pdu + 1);
+        uint32_t size = __get_u16__(pdu + 3);
+        uint32_t bytes = pdu[5];
+        if (size < 1 || size > MODBUS_MAX_WRITE_REGISTERS || bytes != size * 2 || len != static_cast<int>(6 + bytes))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, addr, size))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t offset = addr - info.start_address;
+        this->commit(Dirty{TABLE_HOLDING_REGISTERS, offset, size}, [&](RegisterMap& map) {
+            for (uint32_t i = 0; i < size; ++i)
+                map.holding_registers[offset + i] = __get_u16__(pdu + 6 + i * 2);
+        });
+        callback(RequestType::WRITE_MULTIPLE_REGISTERS, addr, size);
+        std::memcpy(rsp, pdu, 5);
+        return 5;
+    }
+    case RequestType::MASK_WRITE_REGISTER: {
+        if (len != 7)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.holding_registers;
+        uint32_t addr = __get_u16__(pdu + 1);
+        if (!__in_range__(info, addr, 1))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t offset = addr - info.start_address;
+        uint16_t and_mask = __get_u16__(pdu + 3);
+        uint16_t or_mask = __get_u16__(pdu + 5);
+        this->commit(Dirty{TABLE_HOLDING_REGISTERS, offset, 1}, [&](RegisterMap& map) {
+            uint16_t& reg = map.holding_registers[offset];
+            reg = (reg & and_mask) | (or_mask & ~and_mask);
+        });
+        callback(RequestType::MASK_WRITE_REGISTER, addr, 1);
+        std::memcpy(rsp, pdu, 7);
+        return 7;
+    }
+    case RequestType::READ_WRITE_MULTIPLE_REGISTERS: {
+        if (len < 10)
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        const RegisterInfo& info = this->registers_info_.holding_registers;
+        uint32_t read_addr = __get_u16__(pdu + 1);
+        uint32_t read_size = __get_u16__(pdu + 3);
+        uint32_t write_addr = __get_u16__(pdu + 5);
+        uint32_t write_size = __get_u16__(pdu + 7);
+        uint32_t bytes = pdu[9];
+        if (read_size < 1 || read_size > MODBUS_MAX_WR_READ_REGISTERS
+            || write_size < 1 || write_size > MODBUS_MAX_WR_WRITE_REGISTERS
+            || bytes != write_size * 2 || len != static_cast<int>(10 + bytes))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_VALUE);
+        if (!__in_range__(info, read_addr, read_size) || !__in_range__(info, write_addr, write_size))
+            return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_DATA_ADDRESS);
+        uint32_t write_offset = write_addr - info.start_address;
+        uint32_t read_offset = read_addr - info.start_address;
+        rsp[0] = function;
+        rsp[1] = static_cast<uint8_t>(read_size * 2);
+        // write is done before read, read in the same commit so result includes this write only
+        this->commit(Dirty{TABLE_HOLDING_REGISTERS, write_offset, write_size}, [&](RegisterMap& map) {
+            for (uint32_t i = 0; i < write_size; ++i)
+                map.holding_registers[write_offset + i] = __get_u16__(pdu + 10 + i * 2);
+            for (uint32_t i = 0; i < read_size; ++i)
+                __set_u16__(rsp + 2 + i * 2, map.holding_registers[read_offset + i]);
+        });
+        callback(RequestType::READ_WRITE_MULTIPLE_REGISTERS, write_addr, write_size);
+        return 2 + read_size * 2;
+    }
+    default:
+        return __exception_rsp__(rsp, function, MODBUS_EXCEPTION_ILLEGAL_FUNCTION);
+    }
+}
+
+int SlaveTCP::acquire() noexcept
+{
+    // mark the front bank in use, retry if a writer published the other bank meanwhile
+    while (true) {
+        int idx = this->front_.load();
+        this->readers_[idx].fetch_add(1);
+        if (this->front_.load() == idx)
+            return idx;
+        this->readers_[idx].fetch_sub(1);
+    }
+}
+
+void SlaveTCP::release(int idx) noexcept
+{
+    this->readers_[idx].fetch_sub(1);
+}
+
+void SlaveTCP::sync_back(RegisterMap& back, const RegisterMap& front, const Dirty& dirty)
+{
+    switch (dirty.table) {
+    case TABLE_ALL:
+        back.coils = front.coils;
+        back.discrete_inputs = front.discrete_inputs;
+        back.holding_registers = front.holding_registers;
+        back.input_registers = front.input_registers;
+        break;
+    case TABLE_COILS:
+    case TABLE_DISCRETE_INPUTS: {
+        const auto& src = __table_of__<uint8_t>(const_cast<RegisterMap&>(front), dirty.table);
+        auto& dst = __table_of__<uint8_t>(back, dirty.table);
+        std::copy(src.begin() + dirty.start, src.begin() + dirty.start + dirty.size, dst.begin() + dirty.start);
+        break;
+    }
+    default: {
+        const auto& src = __table_of__<uint16_t>(const_cast<RegisterMap&>(front), dirty.table);
+        auto& dst = __table_of__<uint16_t>(back, dirty.table);
+        std::copy(src.begin() + dirty.start, src.begin() + dirty.start + dirty.size, dst.begin() + dirty.start);
+        break;
+    }
+    }
+}
+
+void SlaveTCP::commit(const Dirty& dirty, const std::function<void(RegisterMap&)>& func)
+{
+    std::lock_guard<std::mutex> lock(this->write_mutex_);
+    int back = 1 - this->front_.load();
+    // readers only copy a few registers, wait for the ones still on the old bank
+    while (this->readers_[back].load() > 0)
+        std::this_thread::yield();
+    // back bank misses only the previous commit, copy it from front then apply this one
+    for (const auto& d : this->last_dirty_)
+        this->sync_back(this->banks_[back], this->banks_[1 - back], d);
+    func(this->banks_[back]);
+    this->front_.store(back);
+    this->last_dirty_.assign(1, dirty);
+}
+
+template <typename T>
+std::vector<T> SlaveTCP::access(int table, const std::vector<T>& data, uint32_t index)
+{
+    // read
+    if (data.empty()) {
+        int idx = this->acquire();
+        std::vector<T> res = __table_of__<T>(this->banks_[idx], table);
+        this->release(idx);
+        return res;
+    }
+
+    size_t size = __table_of__<T>(this->banks_[0], table).size();
+    if (data.size() + index > size) {
+        if (this->debug_)
+            log::warn("%s input data out of index", this->TAG().c_str());
+        return {};
+    }
+    this->commit(Dirty{table, index, static_cast<uint32_t>(data.size())}, [&](RegisterMap& map) {
+        std::copy(data.begin(), data.end(), __table_of__<T>(map, table).begin() + index);
+    });
+    return {0x00};
+}
+
+std::vector<uint8_t> SlaveTCP::coils(const std::vector<uint8_t>& data, const uint32_t index)
+{
+    return this->access<uint8_t>(TABLE_COILS, data, index);
+}
+
+std::vector<uint8_t> SlaveTCP::discrete_input(const std::vector<uint8_t>& data, const uint32_t index)
+{
+    return this->access<uint8_t>(TABLE_DISCRETE_INPUTS, data, index);
+}
+
+std::vector<uint16_t> SlaveTCP::input_registers(const std::vector<uint16_t>& data, const uint32_t index)
+{
+    return this->access<uint16_t>(TABLE_INPUT_REGISTERS, data, index);
+}
+
+std::vector<uint16_t> SlaveTCP::holding_registers(const std::vector<uint16_t>& data, const uint32_t index)
+{
+    return this->access<uint16_t>(TABLE_HOLDING_REGISTERS, data, index);
+}
+
+void SlaveTCP::update(const std::function<void(RegisterMap&)>& func)
+{
+    this->commit(Dirty{TABLE_ALL, 0, 0}, func);
+}
+
+RegisterMap SlaveTCP::snapshot()
+{
+    int idx = this->acquire();
+    RegisterMap res = this->banks_[idx];
+    this->release(idx);
+    return res;
+}
+
+int SlaveTCP::client_num() const noexcept
+{
+    return this->client_num_.load();
+}
+
+uint64_t SlaveTCP::request_count() const noexcept
+{
+    return this->request_count_.load();
+}
+
 /****************************** Master *********************************/
 
 class MasterOperator final {
@@ -932,4 +1608,532 @@ int MasterTCP::write_holding_registers(const std::string ip, const int port,
     return MasterOperator::write<uint16_t>(ctx.get(), data, addr, timeout_ms, "holding registers", ::modbus_write_registers);
 }
 
-}
\ No newline at end of file
+/****************************** Scanner *********************************/
+
+struct Scanner::Block {
+    uint8_t slave;
+    uint8_t function;
+    uint32_t addr;
+    uint32_t size;
+    int period_ms;
+    uint64_t next_us{0};
+    std::vector<uint8_t> bits;
+    std::vector<uint16_t> regs;
+    uint64_t timestamp_us{0};
+    ::maix::err::Err err{::maix::err::Err::ERR_NOT_READY};
+    uint16_t tid{0};
+};
+
+static inline bool __is_bits_function__(uint8_t function)
+{
+    return function == static_cast<uint8_t>(RequestType::READ_COILS)
+        || function == static_cast<uint8_t>(RequestType::READ_DISCRETE_INPUTS);
+}
+
+static inline uint32_t __max_read_size__(uint8_t function)
+{
+    return __is_bits_function__(function) ? MODBUS_MAX_READ_BITS : MODBUS_MAX_READ_REGISTERS;
+}
+
+const std::string Scanner::TAG() const noexcept
+{
+    return "[Maix Modbus Scanner]";
+}
+
+Scanner::Scanner(Mode mode, const std::string& ip_or_device, int baudrate_or_port,
+                int timeout_ms, int max_gap, int max_inflight, bool debug)
+{
+    this->mode_ = mode;
+    this->ip_or_device_ = ip_or_device;
+    this->baudrate_or_port_ = baudrate_or_port;
+    this->timeout_ms_ = timeout_ms > 0 ? timeout_ms : 1000;
+    this->max_gap_ = max_gap > 0 ? max_gap : 0;
+    this->max_inflight_ = max_inflight > 0 ? max_inflight : 1;
+    this->debug_ = debug;
+    if (mode != Mode::RTU && mode != Mode::TCP)
+        __error_and_throw__(this->TAG()+" Unknown Mode!");
+}
+
+Scanner::~Scanner()
+{
+    this->stop();
+    this->tcp_close();
+    if (this->ctx_.get() != nullptr)
+        ::modbus_close(this->ctx_.get());
+}
+
+::maix::err::Err Scanner::add(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size, int period_ms)
+{
+    uint8_t function = static_cast<uint8_t>(type);
+    if (function < static_cast<uint8_t>(RequestType::READ_COILS) || function > static_cast<uint8_t>(RequestType::READ_INPUT_REGISTERS)
+        || slave_id > 255 || size == 0 || size > 0x10000 || addr > 0x10000 - size || period_ms <= 0) {
+        log::error("%s add invalid range, slave: %u, function: 0x%02x, addr: %u, size: %u, period: %d",
+            this->TAG().c_str(), slave_id, function, addr, size, period_ms);
+        return ::maix::err::Err::ERR_ARGS;
+    }
+    if (this->thread_ != nullptr)
+        return ::maix::err::Err::ERR_BUSY;
+    std::lock_guard<std::mutex> lock(this->scan_mutex_);
+    this->items_.push_back(Item{static_cast<uint8_t>(slave_id), function, addr, size, period_ms});
+    this->built_ = false;
+    return ::maix::err::Err::ERR_NONE;
+}
+
+void Scanner::build()
+{
+    // ranges of same slave, function and period are merged, sorted by address
+    std::vector<Item> items = this->items_;
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+        if (a.slave != b.slave) return a.slave < b.slave;
+        if (a.function != b.function) return a.function < b.function;
+        if (a.period_ms != b.period_ms) return a.period_ms < b.period_ms;
+        return a.addr < b.addr;
+    });
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex_);
+    this->blocks_.clear();
+    Block* cur = nullptr;
+    for (const auto& item : items) {
+        const uint32_t limit = __max_read_size__(item.function);
+        if (cur != nullptr && (cur->slave != item.slave || cur->function != item.function || cur->period_ms != item.period_ms))
+            cur = nullptr;
+        uint32_t addr = item.addr;
+        const uint32_t end = item.addr + item.size;
+        while (addr < end) {
+            if (cur != nullptr && addr <= cur->addr + cur->size + this->max_gap_ && addr < cur->addr + limit) {
+                uint32_t new_end = std::min(std::max(cur->addr + cur->size, end), cur->addr + limit);
+                cur->size = new_end - cur->addr;
+                addr = std::max(addr, new_end);
+                continue;
+            }
+            auto block = std::make_unique<Block>();
+            block->slave = item.slave;
+            block->function = item.function;
+            block->addr = addr;
+            block->size = std::min(end - addr, limit);
+            block->period_ms = item.period_ms;
+            addr += block->size;
+            cur = block.get();
+            this->blocks_.push_back(std::move(block));
+        }
+    }
+    for (auto& block : this->blocks_) {
+        if (__is_bits_function__(block->function))
+            block->bits.assign(block->size, 0);
+        else
+            block->regs.assign(block->size, 0);
+        if (this->debug_) {
+            log::info("%s request: slave %u, function 0x%02x, addr %u, size %u, period %d ms", this->TAG().c_str(),
+                block->slave, block->function, block->addr, block->size, block->period_ms);
+        }
+    }
+    if (this->debug_) {
+        log::info("%s %zu ranges merged into %zu requests", this->TAG().c_str(), this->items_.size(), this->blocks_.size());
+    }
+    this->built_ = true;
+}
+
+int Scanner::request_num()
+{
+    std::lock_guard<std::mutex> lock(this->scan_mutex_);
+    if (!this->built_)
+        this->build();
+    return static_cast<int>(this->blocks_.size());
+}
+
+std::pair<uint64_t, uint64_t> Scanner::stats()
+{
+    std::lock_guard<std::mutex> lock(this->cache_mutex_);
+    return {this->request_count_, this->error_count_};
+}
+
+::maix::err::Err Scanner::start()
+{
+    if (this->thread_ != nullptr)
+        return ::maix::err::Err::ERR_BUSY;
+    this->thread_exit_ = false;
+    this->thread_ = std::make_unique<std::thread>([this]() {
+        while (true) {
+            this->scan();
+            // sleep until the nearest due request
+            uint64_t now = ::maix::time::ticks_us();
+            uint64_t wait_us = 100000;
+            {
+                std::lock_guard<std::mutex> lock(this->scan_mutex_);
+                for (const auto& block : this->blocks_)
+                    wait_us = std::min(wait_us, block->next_us > now ? block->next_us - now : 0);
+            }
+            std::unique_lock<std::mutex> lock(this->thread_mutex_);
+            if (wait_us > 0)
+                this->thread_cond_.wait_for(lock, std::chrono::microseconds(wait_us), [this]() { return this->thread_exit_; });
+            if (this->thread_exit_)
+                break;
+        }
+    });
+    return ::maix::err::Err::ERR_NONE;
+}
+
+void Scanner::stop()
+{
+    if (this->thread_ == nullptr)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(this->thread_mutex_);
+        this->thread_exit_ = true;
+    }
+    this->thread_cond_.notify_all();
+    this->thread_->join();
+    this->thread_.reset();
+}
+
+::maix::err::Err Scanner::scan()
+{
+    std::lock_guard<std::mutex> lock(this->scan_mutex_);
+    if (!this->built_)
+        this->build();
+
+    uint64_t now = ::maix::time::ticks_us();
+    std::vector<Block*> due;
+    for (auto& block : this->blocks_) {
+        if (block->next_us > now)
+            continue;
+        // don't burst to catch up when late, keep the period from now
+        block->next_us += block->period_ms * 1000ULL;
+        if (block->next_us <= now)
+            block->next_us = now + block->period_ms * 1000ULL;
+        due.push_back(block.get());
+    }
+    if (due.empty())
+        return ::maix::err::Err::ERR_NONE;
+    if (this->mode_ == Mode::RTU)
+        return this->scan_rtu(due);
+    return this->scan_tcp(due);
+}
+
+void Scanner::finish(Block* block, ::maix::err::Err e, const void* values)
+{
+    std::lock_guard<std::mutex> lock(this->cache_mutex_);
+    ++this->request_count_;
+    if (e != ::maix::err::Err::ERR_NONE) {
+        ++this->error_count_;
+        // keep last good values and timestamp, only log once when state changes
+        if (this->debug_ || block->err != e) {
+            log::warn("%s slave %u function 0x%02x addr %u size %u failed: %s", this->TAG().c_str(),
+                block->slave, block->function, block->addr, block->size, ::maix::err::to_str(e).c_str());
+        }
+        block->err = e;
+        return;
+    }
+    if (__is_bits_function__(block->function))
+        std::memcpy(block->bits.data(), values, block->size);
+    else
+        std::memcpy(block->regs.data(), values, block->size * sizeof(uint16_t));
+    block->timestamp_us = ::maix::time::ticks_us();
+    block->err = e;
+}
+
+::maix::err::Err Scanner::scan_rtu(std::vector<Block*>& due)
+{
+    if (this->ctx_.get() == nullptr) {
+        this->ctx_.reset(::modbus_new_rtu(this->ip_or_device_.c_str(), this->baudrate_or_port_, 'N', 8, 1));
+        if (this->ctx_.get() == nullptr || ::modbus_connect(this->ctx_.get()) < 0) {
+            log::error("%s open %s failed!%s", this->TAG().c_str(), this->ip_or_device_.c_str(), ::modbus_strerror(errno));
+            this->ctx_.reset();
+            return ::maix::err::Err::ERR_IO;
+        }
+        ::modbus_set_debug(this->ctx_.get(), this->debug_);
+        ::modbus_set_response_timeout(this->ctx_.get(), this->timeout_ms_ / 1000, this->timeout_ms_ % 1000 * 1000);
+    }
+
+    ::maix::err::Err ret = ::maix::err::Err::ERR_NONE;
+    std::vector<uint8_t> bits;
+    std::vector<uint16_t> regs;
+    std::vector<uint8_t> timeout_slaves;
+    for (Block* block : due) {
+        // slave didn't respond in this round, don't block the bus for it again
+        if (std::find(timeout_slaves.begin(), timeout_slaves.end(), block->slave) != timeout_slaves.end()) {
+            this->finish(block, ::maix::err::Err::ERR_TIMEOUT, nullptr);
+            continue;
+        }
+        ::modbus_set_slave(this->ctx_.get(), block->slave);
+        int rc = -1;
+        const void* values = nullptr;
+        switch (static_cast<RequestType>(block->function)) {
+        case RequestType::READ_COILS:
+            bits.resize(block->size);
+            rc = ::modbus_read_bits(this->ctx_.get(), block->addr, block->size, bits.data());
+            values = bits.data();
+            break;
+        case RequestType::READ_DISCRETE_INPUTS:
+            bits.resize(block->size);
+            rc = ::modbus_read_input_bits(this->ctx_.get(), block->addr, block->size, bits.data());
+            values = bits.data();
+            break;
+        case RequestType::READ_HOLDING_REGISTERS:
+            regs.resize(block->size);
+            rc = ::modbus_read_registers(this->ctx_.get(), block->addr, block->size, regs.data());
+            values = regs.data();
+            break;
+        default:
+            regs.resize(block->size);
+            rc = ::modbus_read_input_registers(this->ctx_.get(), block->addr, block->size, regs.data());
+            values = regs.data();
+            break;
+        }
+        if (rc == static_cast<int>(block->size)) {
+            this->finish(block, ::maix::err::Err::ERR_NONE, values);
+            continue;
+        }
+        ret = errno == ETIMEDOUT ? ::maix::err::Err::ERR_TIMEOUT : ::maix::err::Err::ERR_IO;
+        if (ret == ::maix::err::Err::ERR_TIMEOUT)
+            timeout_slaves.push_back(block->slave);
+        else
+            ::modbus_flush(this->ctx_.get());
+        this->finish(block, ret, nullptr);
+    }
+    return ret;
+}
+
+::maix::err::Err Scanner::tcp_connect()
+{
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(this->baudrate_or_port_));
+    if (::inet_pton(AF_INET, this->ip_or_device_.c_str(), &addr.sin_addr) != 1) {
+        log::error("%s invalid ip: %s", this->TAG().c_str(), this->ip_or_device_.c_str());
+        return ::maix::err::Err::ERR_ARGS;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return ::maix::err::Err::ERR_IO;
+    int rc = ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    if (rc < 0 && errno == EINPROGRESS) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        int err = 0;
+        socklen_t len = sizeof(err);
+        rc = ::poll(&pfd, 1, this->timeout_ms_);
+        if (rc > 0 && ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0)
+            rc = 0;
+        else
+            rc = -1;
+    }
+    if (rc < 0) {
+        if (this->debug_)
+            log::warn("%s connect %s:%d failed", this->TAG().c_str(), this->ip_or_device_.c_str(), this->baudrate_or_port_);
+        ::close(fd);
+        return ::maix::err::Err::ERR_IO;
+    }
+    int enable = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    this->socket_ = fd;
+    this->rx_buff_.clear();
+    return ::maix::err::Err::ERR_NONE;
+}
+
+void Scanner::tcp_close()
+{
+    if (this->socket_ >= 0) {
+        ::close(this->socket_);
+        this->socket_ = -1;
+    }
+    this->rx_buff_.clear();
+}
+
+::maix::err::Err Scanner::scan_tcp(std::vector<Block*>& due)
+{
+    ::maix::err::Err ret = ::maix::err::Err::ERR_NONE;
+    std::vector<Block*> inflight;
+    std::vector<uint8_t> bits;
+    std::vector<uint16_t> regs;
+    size_t next = 0;
+    while (next < due.size() || !inflight.empty()) {
+        if (this->socket_ < 0) {
+            ::maix::err::Err e = this->tcp_connect();
+            if (e != ::maix::err::Err::ERR_NONE) {
+                for (; next < due.size(); ++next)
+                    this->finish(due[next], e, nullptr);
+                return e;
+            }
+        }
+
+        // send requests without waiting for previous responses
+        bool send_failed = false;
+        while (inflight.size() < static_cast<size_t>(this->max_inflight_) && next < due.size()) {
+            Block* block = due[next];
+            block->tid = this->next_tid_++;
+            uint8_t adu[12] = {
+                static_cast<uint8_t>(block->tid >> 8), static_cast<uint8_t>(block->tid), 0, 0, 0, 6, block->slave, block->function,
+                static_cast<uint8_t>(block->addr >> 8), static_cast<uint8_t>(block->addr),
+                static_cast<uint8_t>(block->size >> 8), static_cast<uint8_t>(block->size)
+            };
+            if (::send(this->socket_, adu, sizeof(adu), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(adu))) {
+                send_failed = true;
+                break;
+            }
+            inflight.push_back(block);
+            ++next;
+        }
+
+        // wait for any response
+        struct pollfd pfd = {this->socket_, POLLIN, 0};
+        ssize_t n = -1;
+        if (!send_failed && ::poll(&pfd, 1, this->timeout_ms_) > 0) {
+            size_t old = this->rx_buff_.size();
+            this->rx_buff_.resize(old + 1024);
+            n = ::recv(this->socket_, this->rx_buff_.data() + old, 1024, 0);
+            this->rx_buff_.resize(old + (n > 0 ? n : 0));
+        }
+        if (n <= 0) {
+            // timeout or connection broken, responses still in flight may come later and confuse, reconnect
+            ret = n == 0 || send_failed ? ::maix::err::Err::ERR_IO : ::maix::err::Err::ERR_TIMEOUT;
+            for (Block* block : inflight)
+                this->finish(block, ret, nullptr);
+            inflight.clear();
+            this->tcp_close();
+            continue;
+        }
+
+        size_t pos = 0;
+        bool bad_frame = false;
+        while (this->rx_buff_.size() - pos >= 9) {
+            const uint8_t* adu = this->rx_buff_.data() + pos;
+            size_t len = 6 + ((adu[4] << 8) | adu[5]);
+            if (adu[2] != 0 || adu[3] != 0 || len < 9) {
+                bad_frame = true;
+                break;
+            }
+            if (this->rx_buff_.size() - pos < len)
+                break;
+            pos += len;
+            uint16_t tid = (adu[0] << 8) | adu[1];
+            auto it = std::find_if(inflight.begin(), inflight.end(), [tid](Block* b) { return b->tid == tid; });
+            if (it == inflight.end())
+                continue;
+            Block* block = *it;
+            inflight.erase(it);
+            const uint8_t* pdu = adu + 7;
+            if (pdu[0] != block->function) {
+                ret = ::maix::err::Err::ERR_IO;
+                if (this->debug_)
+                    log::warn("%s slave %u exception 0x%02x", this->TAG().c_str(), block->slave, pdu[1]);
+                this->finish(block, ret, nullptr);
+                continue;
+            }
+            if (__is_bits_function__(block->function)) {
+                if (pdu[1] != (block->size + 7) / 8 || len != 9u + pdu[1]) {
+                    this->finish(block, ::maix::err::Err::ERR_IO, nullptr);
+                    continue;
+                }
+                bits.resize(block->size);
+                for (uint32_t i = 0; i < block->size; ++i)
+                    bits[i] = (pdu[2 + i / 8] >> (i % 8)) & 0x01;
+                this->finish(block, ::maix::err::Err::ERR_NONE, bits.data());
+            } else {
+                if (pdu[1] != block->size * 2 || len != 9u + pdu[1]) {
+                    this->finish(block, ::maix::err::Err::ERR_IO, nullptr);
+                    continue;
+                }
+                regs.resize(block->size);
+                for (uint32_t i = 0; i < block->size; ++i)
+                    regs[i] = static_cast<uint16_t>((pdu[2 + i * 2] << 8) | pdu[3 + i * 2]);
+                this->finish(block, ::maix::err::Err::ERR_NONE, regs.data());
+            }
+        }
+        if (bad_frame) {
+            log::warn("%s invalid response frame, reconnect", this->TAG().c_str());
+            ret = ::maix::err::Err::ERR_IO;
+            for (Block* block : inflight)
+                this->finish(block, ret, nullptr);
+            inflight.clear();
+            this->tcp_close();
+            continue;
+        }
+        this->rx_buff_.erase(this->rx_buff_.begin(), this->rx_buff_.begin() + pos);
+    }
+    return ret;
+}
+
+Scanner::Block* Scanner::find(uint32_t slave_id, RequestType type, uint32_t addr)
+{
+    for (auto& block : this->blocks_) {
+        if (block->slave == slave_id && block->function == static_cast<uint8_t>(type)
+            && addr >= block->addr && addr < block->addr + block->size)
+            return block.get();
+    }
+    return nullptr;
+}
+
+template <typename T>
+static ::maix::err::Err __scanner_get__(uint32_t size, std::vector<T>& values, uint64_t* timestamp_us,
+                                    const std::function<const std::vector<T>*(uint32_t, uint32_t&, uint64_t&, ::maix::err::Err&)>& next)
+{
+    // a range may be split into several requests, copy piece by piece, timestamp is the oldest one
+    values.resize(size);
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    uint32_t done = 0;
+    while (done < size) {
+        uint32_t offset = 0;
+        uint64_t ts = 0;
+        ::maix::err::Err e = ::maix::err::Err::ERR_NONE;
+        const std::vector<T>* src = next(done, offset, ts, e);
+        if (src == nullptr)
+            return e;
+        uint32_t n = std::min<uint32_t>(size - done, src->size() - offset);
+        std::copy(src->begin() + offset, src->begin() + offset + n, values.begin() + done);
+        oldest = std::min(oldest, ts);
+        done += n;
+    }
+    if (timestamp_us)
+        *timestamp_us = oldest;
+    return ::maix::err::Err::ERR_NONE;
+}
+
+::maix::err::Err Scanner::get_bits(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size,
+                                std::vector<uint8_t>& values, uint64_t* timestamp_us)
+{
+    if (!__is_bits_function__(static_cast<uint8_t>(type)) || size == 0 || size > 0x10000 || addr > 0x10000 - size)
+        return ::maix::err::Err::ERR_ARGS;
+    std::lock_guard<std::mutex> lock(this->cache_mutex_);
+    return __scanner_get__<uint8_t>(size, values, timestamp_us,
+        [&](uint32_t done, uint32_t& offset, uint64_t& ts, ::maix::err::Err& e) -> const std::vector<uint8_t>* {
+            Block* block = this->built_ ? this->find(slave_id, type, addr + done) : nullptr;
+            if (block == nullptr) {
+                e = ::maix::err::Err::ERR_NOT_FOUND;
+                return nullptr;
+            }
+            if (block->timestamp_us == 0) {
+                e = ::maix::err::Err::ERR_NOT_READY;
+                return nullptr;
+            }
+            offset = addr + done - block->addr;
+            ts = block->timestamp_us;
+            return &block->bits;
+        });
+}
+
+::maix::err::Err Scanner::get_registers(uint32_t slave_id, RequestType type, uint32_t addr, uint32_t size,
+                                    std::vector<uint16_t>& values, uint64_t* timestamp_us)
+{
+    if (__is_bits_function__(static_cast<uint8_t>(type)) || size == 0 || size > 0x10000 || addr > 0x10000 - size
+        || static_cast<uint8_t>(type) > static_cast<uint8_t>(RequestType::READ_INPUT_REGISTERS))
+        return ::maix::err::Err::ERR_ARGS;
+    std::lock_guard<std::mutex> lock(this->cache_mutex_);
+    return __scanner_get__<uint16_t>(size, values, timestamp_us,
+        [&](uint32_t done, uint32_t& offset, uint64_t& ts, ::maix::err::Err& e) -> const std::vector<uint16_t>* {
+            Block* block = this->built_ ? this->find(slave_id, type, addr + done) : nullptr;
+            if (block == nullptr) {
+                e = ::maix::err::Err::ERR_NOT_FOUND;
+                return nullptr;
+            }
+            if (block->timestamp_us == 0) {
+                e = ::maix::err::Err::ERR_NOT_READY;
+                return nullptr;
+            }
+            offset = addr + done - block->addr;
+            ts = block->timestamp_us;
+            return &block->regs;
+        });
+}
+
+}
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2024.10.28: Add framework, create this file.
+ * @update 2026.10.18: Use combined register read and write.
  */
 
 #include "maix_i2c.hpp"
@@ -26,34 +27,39 @@ static uint8_t dev_addr{0};
 
 static err::Err maix_i2c_read(uint8_t address, uint8_t reg, uint8_t *buffer, uint16_t size)
 {
-    ::maix::Bytes* res = nullptr;
-
+    int ret;
     {
+        // register address and data in one transaction with repeated start
         std::lock_guard<std::recursive_mutex> lock(mtx);
-        i2cdev->writeto((int)address, &reg, 1);
-        res = i2cdev->readfrom((int)address, (int)size);
+        ret = i2cdev->readfrom_mem_into((int)address, reg, buffer, (int)size);
     }
 
-    if (res == nullptr) return err::Err::ERR_READ;
+    if (ret != (int)size) return err::Err::ERR_READ;
+    return err::Err::ERR_NONE;
+}
 
-    std::copy(res->data, res->data+res->data_len, buffer);
+// read several registers in one transaction
+static err::Err maix_i2c_read_regs(uint8_t address, const ::maix::peripheral::i2c::MemRead *reads, int num)
+{
+    int ret;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mtx);
+        ret = i2cdev->readfrom_mems((int)address, reads, num);
+    }
 
-    delete res;
+    if (ret != num) return err::Err::ERR_READ;
     return err::Err::ERR_NONE;
 }
 
 static err::Err maix_i2c_write(uint8_t address, uint8_t reg, const uint8_t *buffer, uint16_t size)
 {
-    auto buff = new uint8_t[size+1];
-    buff[0] = reg;
-    std::copy(buffer, buffer+size, buff+1);
-
+    int ret;
     {
         std::lock_guard<std::recursive_mutex> lock(mtx);
-        i2cdev->writeto((int)address, buff, size+1);
+        ret = i2cdev->writeto_mem((int)address, reg, buffer, (int)size);
     }
 
-    delete[] buff;
+    if (ret != (int)size) return err::Err::ERR_WRITE;
     return err::Err::ERR_NONE;
 }
 
@@ -267,12 +273,12 @@ uint16_t AXP2101::get_bat_vol()
 {
     uint8_t val_h, val_l;
     err::Err ret;
-    ret = priv::maix_i2c_read(priv::dev_addr, AXP2101_ADC_DATA_RELUST0, &val_h, 1);
-    if (ret != err::Err::ERR_NONE) {
-        log::error("[%s]: maix_i2c_read failed. Error code:%d", priv::TAG, ret);
-        return false;
-    }
-    ret = priv::maix_i2c_read(priv::dev_addr, AXP2101_ADC_DATA_RELUST1, &val_l, 1);
+    // high and low byte in one transaction, so they are from the same sample
+    const ::maix::peripheral::i2c::MemRead reads[2] = {
+        {AXP2101_ADC_DATA_RELUST0, &val_h, 1},
+        {AXP2101_ADC_DATA_RELUST1, &val_l, 1},
+    };
+    ret = priv::maix_i2c_read_regs(priv::dev_addr, reads, 2);
     if (ret != err::Err::ERR_NONE) {
         log::error("[%s]: maix_i2c_read failed. Error code:%d", priv::TAG, ret);
         return false;
@@ -72,13 +72,9 @@ void Qmi8658c::qmi8658_write(uint8_t reg, uint8_t value)
 
 uint8_t Qmi8658c::qmi8658_read(uint8_t reg)
 {
-    maix::Bytes* res = nullptr;
-    {
-        res = i2cbus->readfrom_mem(this->deviceAdress, reg, 1);
-    }
-    uint8_t value = res->at(0);
+    uint8_t value = 0;
+    i2cbus->readfrom_mem_into(this->deviceAdress, reg, &value, 1);
     // maix::log::info0("%u ", value);
-    delete res;
     return value;
 }
 
@@ -227,27 +223,26 @@ qmi8658_result_t Qmi8658c::open(qmi8658_cfg_t* qmi8658_cfg) {
 // Read data from the QMI8658 sensor and stores it in the provided data structure.
 
 void Qmi8658c::read(qmi_data_t* data) {
-    maix::Bytes* res = nullptr;
+    // temperature, accelerometer and gyroscope registers are continuous, one burst read per sample
+    uint8_t res[14];
     static qmi_data_t last_data = {0};
-    res = i2cbus->readfrom_mem(this->deviceAdress, QMI8658_TEMP_L, 14);
-    if (res || res->data_len != 14) {
-        int16_t temp = (((int16_t)res->data[1] << 8) | res->data[0]);
+    if (i2cbus->readfrom_mem_into(this->deviceAdress, QMI8658_TEMP_L, res, sizeof(res)) == sizeof(res)) {
+        int16_t temp = (((int16_t)res[1] << 8) | res[0]);
         data->temperature = (float)temp/TEMPERATURE_SENSOR_RESOLUTION;
 
-        int16_t acc_x = (((int16_t)res->data[3] << 8) | res->data[2]);
-        int16_t acc_y = (((int16_t)res->data[5] << 8) | res->data[4]);
-        int16_t acc_z = (((int16_t)res->data[7] << 8) | res->data[6]);
+        int16_t acc_x = (((int16_t)res[3] << 8) | res[2]);
+        int16_t acc_y = (((int16_t)res[5] << 8) | res[4]);
+        int16_t acc_z = (((int16_t)res[7] << 8) | res[6]);
         data->acc_xyz.x = (float)acc_x/qmi_ctx.acc_sensitivity;
         data->acc_xyz.y = (float)acc_y/qmi_ctx.acc_sensitivity;
         data->acc_xyz.z = (float)acc_z/qmi_ctx.acc_sensitivity;
 
-        int16_t rot_x = (int16_t)(((uint16_t)res->data[9] << 8) | res->data[8]);
-        int16_t rot_y = (int16_t)(((uint16_t)res->data[11] << 8) | res->data[10]);
-        int16_t rot_z = (int16_t)(((uint16_t)res->data[13] << 8) | res->data[12]);
+        int16_t rot_x = (int16_t)(((uint16_t)res[9] << 8) | res[8]);
+        int16_t rot_y = (int16_t)(((uint16_t)res[11] << 8) | res[10]);
+        int16_t rot_z = (int16_t)(((uint16_t)res[13] << 8) | res[12]);
         data->gyro_xyz.x = (float)rot_x/qmi_ctx.gyro_sensitivity;
         data->gyro_xyz.y = (float)rot_y/qmi_ctx.gyro_sensitivity;
         data->gyro_xyz.z = (float)rot_z/qmi_ctx.gyro_sensitivity;
-        delete res;
 
         memcpy(&last_data, data, sizeof(last_data));
     } else {
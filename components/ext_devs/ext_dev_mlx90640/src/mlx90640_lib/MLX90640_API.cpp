@@ -134,31 +134,13 @@ int MLX90640_GetFrameData(uint8_t slaveAddr, uint16_t *frameData)
     }
     // maix::log::info("Wait ready used: %llu", maix::time::ticks_ms()-_wait_ready_ltime);
 
-    // uint64_t _w_0x8000_0x0030_ltime = maix::time::ticks_ms();
-    error = MLX90640_I2CWrite(slaveAddr, 0x8000, 0x0030);
-    if(error == -1)
-    {
-        return error;
-    }
-    // maix::log::info("_w_0x8000_0x0030 used: %llu", maix::time::ticks_ms()-_w_0x8000_0x0030_ltime);
-
-    // uint64_t _r_768_ltime = maix::time::ticks_ms();
-    error = MLX90640_I2CRead(slaveAddr, 0x0400, 768, frameData);
-    if(error != 0)
+    // clear data ready, then read frame, aux data and control register, all in one bus transaction
     {
-        return error;
+        const uint16_t startAddresses[3] = {0x0400, 0x0700, 0x800D};
+        const uint16_t nMemAddressReads[3] = {768, 64, 1};
+        uint16_t *datas[3] = {frameData, data, &controlRegister1};
+        error = MLX90640_I2CWriteReads(slaveAddr, 0x8000, 0x0030, 3, startAddresses, nMemAddressReads, datas);
     }
-    // maix::log::info("_r_768 used: %llu", maix::time::ticks_ms()-_r_768_ltime);
-
-    // auto _r_64_ltime = maix::time::ticks_ms();
-    error = MLX90640_I2CRead(slaveAddr, 0x0700, 64, data);
-    if(error != 0)
-    {
-        return error;
-    }
-    // maix::log::info("_r_64 used: %llu", maix::time::ticks_ms()-_r_64_ltime);
-
-    error = MLX90640_I2CRead(slaveAddr, 0x800D, 1, &controlRegister1);
     frameData[832] = controlRegister1;
     frameData[833] = statusRegister & 0x0001;
 
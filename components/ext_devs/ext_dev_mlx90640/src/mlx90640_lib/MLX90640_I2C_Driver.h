@@ -28,6 +28,9 @@ void MLX90640_I2CInit(int i2c_bus_num);
 int MLX90640_I2CGeneralReset(void);
 int MLX90640_I2CRead(uint8_t slaveAddr,uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *data);
 int MLX90640_I2CWrite(uint8_t slaveAddr,uint16_t writeAddress, uint16_t data);
+// write one register, then read num register blocks to datas[i], in one combined transaction if bus supports
+int MLX90640_I2CWriteReads(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data, int num,
+                           const uint16_t *startAddresses, const uint16_t *nMemAddressReads, uint16_t **datas);
 void MLX90640_I2CFreqSet(int freq);
 
 #ifdef __cplusplus
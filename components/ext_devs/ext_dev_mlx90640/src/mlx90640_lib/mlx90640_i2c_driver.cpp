@@ -4,11 +4,32 @@
 #define MLX90640_MAIX_I2C           1
 #define MLX90640_SOFT_I2C           2
 
-#define MLX_90640_I2C_MODE MLX90640_LINUX_SYSCALL_I2C
+#define MLX_90640_I2C_MODE MLX90640_MAIX_I2C
+
+#include "MLX90640_I2C_Driver.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+static int i2c_bus_num = -1;
+
+void MLX90640_I2CFreqSet([[maybe_unused]]int freq)
+{
+#if 1 // PLATFORM_MAIXCAM
+    if (i2c_bus_num == 5) {
+        const char* priv_freq_path = "/sys/devices/platform/i2c5@gpio/udelay_value/udelay_v";
+        const char* wd = "0";
+
+        int _fd = ::open(priv_freq_path, O_WRONLY);
+        if (_fd < 0) return;
+
+        int ret = ::write(_fd, wd, 1);
+        if (ret < 0) return;
+    }
+#endif
+}
 
 #if MLX_90640_I2C_MODE == MLX90640_LINUX_SYSCALL_I2C
 
-#include "MLX90640_I2C_Driver.h"
 #include <iostream>
 #include <unistd.h>
 #include <stdio.h>
@@ -26,7 +47,6 @@
 #include <sys/ioctl.h>
 
 int i2c_fd = 0;
-static int i2c_bus_num = -1;
 static std::string i2c_device;
 
 int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *data)
@@ -71,22 +91,6 @@ int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddr
     return 0;
 }
 
-void MLX90640_I2CFreqSet([[maybe_unused]]int freq)
-{
-#if 1 // PLATFORM_MAIXCAM
-    if (i2c_bus_num == 5) {
-        const char* priv_freq_path = "/sys/devices/platform/i2c5@gpio/udelay_value/udelay_v";
-        const char* wd = "0";
-
-        int _fd = ::open(priv_freq_path, O_WRONLY);
-        if (_fd < 0) return;
-
-        int ret = ::write(_fd, wd, 1);
-        if (ret < 0) return;
-    }
-#endif
-}
-
 int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
 {
     char cmd[4] = {(char)(writeAddress >> 8), (char)(writeAddress & 0x00FF), (char)(data >> 8), (char)(data & 0x00FF)};
@@ -111,6 +115,18 @@ int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
     return 0;
 }
 
+int MLX90640_I2CWriteReads(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data, int num,
+                           const uint16_t *startAddresses, const uint16_t *nMemAddressReads, uint16_t **datas)
+{
+    if (MLX90640_I2CWrite(slaveAddr, writeAddress, data) < 0)
+        return -1;
+    for (int i = 0; i < num; ++i) {
+        if (MLX90640_I2CRead(slaveAddr, startAddresses[i], nMemAddressReads[i], datas[i]) < 0)
+            return -1;
+    }
+    return 0;
+}
+
 int MLX90640_I2CGeneralReset(void)
 {
 	MLX90640_I2CWrite(0x33,0x06,0x00);
@@ -124,5 +140,101 @@ void MLX90640_I2CInit(int bus_num)
     MLX90640_I2CFreqSet(0);
 }
 
+#elif MLX_90640_I2C_MODE == MLX90640_MAIX_I2C
+
+#include "maix_i2c.hpp"
+
+using namespace maix::peripheral;
+
+static i2c::I2C *i2c_dev = nullptr;
+
+static i2c::I2C *_get_i2c()
+{
+    if (!i2c_dev) {
+        try {
+            i2c_dev = new i2c::I2C(i2c_bus_num, i2c::Mode::MASTER);
+        } catch (const std::exception &e) {
+            printf("I2C open Error: %s\n", e.what());
+            return nullptr;
+        }
+    }
+    return i2c_dev;
+}
+
+// registers are 16 bit big endian, convert in place, word i only uses its own 2 bytes
+static void _be16_to_cpu(uint16_t *data, int n)
+{
+    uint8_t *b = (uint8_t *)data;
+    for (int i = 0; i < n; ++i)
+        data[i] = ((uint16_t)b[i * 2] << 8) | b[i * 2 + 1];
+}
+
+int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *data)
+{
+    i2c::I2C *dev = _get_i2c();
+    if (!dev)
+        return -1;
+    // read into caller's buffer directly, address and data in one transaction
+    if (dev->readfrom_mem_into(slaveAddr, startAddress, (uint8_t *)data, nMemAddressRead * 2, 16) < 0) {
+        printf("I2C Read Error!\n");
+        return -1;
+    }
+    _be16_to_cpu(data, nMemAddressRead);
+    return 0;
+}
+
+int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
+{
+    i2c::I2C *dev = _get_i2c();
+    if (!dev)
+        return -1;
+    uint8_t buff[2] = {(uint8_t)(data >> 8), (uint8_t)(data & 0xFF)};
+    if (dev->writeto_mem(slaveAddr, writeAddress, buff, 2, 16) < 0) {
+        printf("I2C Write Error!\n");
+        return -1;
+    }
+    return 0;
+}
+
+int MLX90640_I2CWriteReads(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data, int num,
+                           const uint16_t *startAddresses, const uint16_t *nMemAddressReads, uint16_t **datas)
+{
+    i2c::I2C *dev = _get_i2c();
+    if (!dev || num < 0 || num > 8)
+        return -1;
+    uint8_t cmd[4] = {(uint8_t)(writeAddress >> 8), (uint8_t)(writeAddress & 0xFF), (uint8_t)(data >> 8), (uint8_t)(data & 0xFF)};
+    uint8_t addrs[8][2];
+    i2c::Msg msgs[1 + 8 * 2];
+    msgs[0] = {slaveAddr, false, cmd, 4};
+    for (int i = 0; i < num; ++i) {
+        addrs[i][0] = startAddresses[i] >> 8;
+        addrs[i][1] = startAddresses[i] & 0xFF;
+        msgs[1 + i * 2] = {slaveAddr, false, addrs[i], 2};
+        msgs[2 + i * 2] = {slaveAddr, true, (uint8_t *)datas[i], nMemAddressReads[i] * 2};
+    }
+    if (dev->transfer(msgs, 1 + num * 2) < 0) {
+        printf("I2C Read Error!\n");
+        return -1;
+    }
+    for (int i = 0; i < num; ++i)
+        _be16_to_cpu(datas[i], nMemAddressReads[i]);
+    return 0;
+}
+
+int MLX90640_I2CGeneralReset(void)
+{
+	MLX90640_I2CWrite(0x33,0x06,0x00);
+	return 0;
+}
+
+void MLX90640_I2CInit(int bus_num)
+{
+    if (i2c_dev && bus_num != i2c_bus_num) {
+        delete i2c_dev;
+        i2c_dev = nullptr;
+    }
+    i2c_bus_num = bus_num;
+    MLX90640_I2CFreqSet(0);
+}
 
 #endif
\ No newline at end of file
@@ -3,6 +3,8 @@
  * @license: Apache-2.0
  * @author: neucrack@sipeed
  * @date: 2025-05-20
+ * @update: 2026.10.18: Add min-p sampling and random seed to post config.
+ * @update: 2026.10.18: Add convert_embed_int8.
  */
 #pragma once
 
@@ -70,6 +72,9 @@ namespace maix::nn
 
             enable_top_k_sampling = true;
             top_k = 10;
+            enable_min_p_sampling = false;
+            min_p = 0.05;
+            seed = -1;
         }
 
         /**
@@ -125,6 +130,25 @@ namespace maix::nn
          * @maixpy maix.nn.QwenPostConfig.top_k
          */
         int top_k;
+
+        /**
+         * Enable min p sampling, only tokens with probability >= min_p * max probability are sampled,
+         * can be used together with top p or top k sampling.
+         * @maixpy maix.nn.QwenPostConfig.enable_min_p_sampling
+         */
+        bool enable_min_p_sampling;
+
+        /**
+         * Min p sampling value
+         * @maixpy maix.nn.QwenPostConfig.min_p
+         */
+        float min_p;
+
+        /**
+         * Random seed of sampling, same seed and same input get same output, -1 means random seed.
+         * @maixpy maix.nn.QwenPostConfig.seed
+         */
+        int seed;
     };
 
     /**
@@ -239,6 +263,16 @@ namespace maix::nn
          */
         err::Err clear_context();
 
+        /**
+         * Convert bf16 token embed table to int8 table, one scale for each token, about half size, saved to bf16_path + ".int8".
+         * Set int8_embed = true in extra of model mud file to load int8 table, it will be converted at first load if not exists.
+         * @param bf16_path bf16 token embed table file path, token_num * embed_size bf16 values.
+         * @param token_num token number of table, tokens_embed_num in model mud file.
+         * @param embed_size embed size of one token, tokens_embed_size in model mud file.
+         * @return error code, err::ERR_NONE if int8 table exists and up to date or converted.
+         * @maixcdk maix.nn.Qwen.convert_embed_int8
+         */
+        static err::Err convert_embed_int8(const std::string &bf16_path, int token_num, int embed_size);
 
         /**
          * Get model version
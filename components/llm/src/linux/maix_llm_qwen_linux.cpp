@@ -81,4 +81,9 @@ namespace maix::nn
     {
         return err::ERR_NONE;
     }
+
+    err::Err Qwen::convert_embed_int8(const std::string &bf16_path, int token_num, int embed_size)
+    {
+        return err::ERR_NOT_IMPL;
+    }
 } // namespace maix::nn
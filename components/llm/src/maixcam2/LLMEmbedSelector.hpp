@@ -1,26 +1,92 @@
 #pragma once
 #include <string.h>
+#include <math.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sys/stat.h>
 
 #include "sample_log.h"
 
 #include "memory_utils.hpp"
 
+/**
+ * Token embedding table lookup.
+ * Table file is bf16 rows of token_num * embed_size, or int8 compressed table created by Quantize() or Int8Table(),
+ * which is token_num float row scales followed by token_num * embed_size int8 rows, format is detected by file size.
+ * Table is memory mapped by default, only pages of used rows are read and they can be dropped by kernel when memory is low,
+ * rows are copied to destination buffer(e.g. model input) directly, int8 rows are dequantized to bf16 when copy.
+ */
 class LLaMaEmbedSelector
 {
     MMap _embed_map;
-    std::vector<unsigned short> _embeds;
+    std::vector<uint8_t> _embeds;
+    const uint8_t *_data = nullptr;
+    const float *_scales = nullptr; // int8 table row scales, nullptr for bf16 table
     unsigned int _token_num, _embed_size;
     bool _use_mmap = false;
 
+    static unsigned short float_to_bf16(float v)
+    {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        bits += 0x7fff + ((bits >> 16) & 1); // round to nearest even
+        return (unsigned short)(bits >> 16);
+    }
+
+    static float bf16_to_float(unsigned short v)
+    {
+        uint32_t bits = (uint32_t)v << 16;
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    size_t row_bytes()
+    {
+        return _scales ? _embed_size : _embed_size * sizeof(unsigned short);
+    }
+
+    const uint8_t *row_data(unsigned int index)
+    {
+        return _data + (_scales ? _token_num * sizeof(float) : 0) + (size_t)index * row_bytes();
+    }
+
+    // tell kernel to read pages of row now, rows of one gather are read in parallel instead of one page fault by one
+    void prefetch(unsigned int index)
+    {
+        if (!_use_mmap)
+            return;
+        uintptr_t page = sysconf(_SC_PAGESIZE);
+        uintptr_t start = (uintptr_t)row_data(index) & ~(page - 1);
+        uintptr_t end = (uintptr_t)row_data(index) + row_bytes();
+        madvise((void *)start, end - start, MADV_WILLNEED);
+    }
+
+    void copy_row(unsigned int index, unsigned short *embed)
+    {
+        const uint8_t *src = row_data(index);
+        if (!_scales)
+        {
+            memcpy(embed, src, row_bytes());
+            return;
+        }
+        float scale = _scales[index];
+        const int8_t *q = (const int8_t *)src;
+        for (unsigned int i = 0; i < _embed_size; i++)
+        {
+            embed[i] = float_to_bf16(q[i] * scale);
+        }
+    }
+
 public:
-    bool Init(std::string embed_path, unsigned int token_num, unsigned int embed_size, bool use_mmap = false)
+    bool Init(std::string embed_path, unsigned int token_num, unsigned int embed_size, bool use_mmap = true)
     {
         _token_num = token_num;
         _embed_size = embed_size;
         _use_mmap = use_mmap;
+        size_t file_size = 0;
         if (use_mmap)
         {
             // ALOGI("LLaMaEmbedSelector use mmap");
@@ -29,10 +95,14 @@ public:
                 ALOGE("embed file(%s) open failed", embed_path.c_str());
                 return false;
             }
+            _data = (const uint8_t *)_embed_map.data();
+            file_size = _embed_map.size();
+            // rows are accessed randomly, read ahead only read rows not used
+            madvise(_embed_map.data(), file_size, MADV_RANDOM);
         }
         else
         {
-            std::ifstream fin(embed_path);
+            std::ifstream fin(embed_path, std::ios::binary);
             if (!fin.is_open())
             {
                 ALOGE("embed file(%s) open failed", embed_path.c_str());
@@ -41,19 +111,31 @@ public:
 
             // get file size
             fin.seekg(0, std::ios::end);
-            int file_size = fin.tellg();
+            file_size = fin.tellg();
             fin.seekg(0, std::ios::beg);
-            if ((unsigned int)file_size != token_num * embed_size * 2)
-            {
-                ALOGE("embed file(%s) size(%d) not equal token_num(%d) * embed_size(%d) * 2", embed_path.c_str(), file_size, token_num, embed_size);
-                return false;
-            }
-
-            _embeds.resize(token_num * embed_size);
+            _embeds.resize(file_size);
             fin.read((char *)_embeds.data(), file_size);
             fin.close();
+            _data = _embeds.data();
         }
 
+        size_t bf16_size = (size_t)token_num * embed_size * sizeof(unsigned short);
+        size_t int8_size = (size_t)token_num * (embed_size + sizeof(float));
+        if (file_size == bf16_size)
+        {
+            _scales = nullptr;
+        }
+        else if (file_size == int8_size)
+        {
+            _scales = (const float *)_data;
+            ALOGI("embed file(%s) is int8 table", embed_path.c_str());
+        }
+        else
+        {
+            ALOGE("embed file(%s) size(%zu) not equal token_num(%d) * embed_size(%d) * 2 or token_num * (embed_size + 4)", embed_path.c_str(), file_size, token_num, embed_size);
+            Deinit();
+            return false;
+        }
         return true;
     }
 
@@ -61,6 +143,36 @@ public:
     {
         _embed_map.close_file();
         _embeds.clear();
+        _embeds.shrink_to_fit();
+        _data = nullptr;
+        _scales = nullptr;
+    }
+
+    /**
+     * Copy embeds of tokens to out continuously, out size must >= count * embed_size.
+     * Invalid token's row is set to 0.
+     */
+    void Gather(const int *tokens, int count, unsigned short *out)
+    {
+        if (count > 1)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (tokens[i] >= 0 && (unsigned int)tokens[i] < _token_num)
+                    prefetch(tokens[i]);
+            }
+        }
+        for (int i = 0; i < count; i++)
+        {
+            unsigned short *dst = out + (size_t)i * _embed_size;
+            if (tokens[i] < 0 || (unsigned int)tokens[i] >= _token_num)
+            {
+                ALOGE("index(%d) > token_num(%d)", tokens[i], _token_num);
+                memset(dst, 0, _embed_size * sizeof(unsigned short));
+                continue;
+            }
+            copy_row(tokens[i], dst);
+        }
     }
 
     void getByIndex(unsigned int index, std::vector<unsigned short> &embed)
@@ -71,15 +183,7 @@ public:
             return;
         }
         embed.resize(_embed_size);
-        if (_use_mmap)
-        {
-            unsigned short *ptr = (unsigned short *)_embed_map.data();
-            memcpy(embed.data(), ptr + index * _embed_size, _embed_size * sizeof(unsigned short));
-        }
-        else
-        {
-            memcpy(embed.data(), _embeds.data() + index * _embed_size, _embed_size * sizeof(unsigned short));
-        }
+        copy_row(index, embed.data());
     }
 
     void getByIndex(unsigned int index, unsigned short *embed)
@@ -89,15 +193,7 @@ public:
             ALOGE("index(%d) > token_num(%d)", index, _token_num);
             return;
         }
-        if (_use_mmap)
-        {
-            unsigned short *ptr = (unsigned short *)_embed_map.data();
-            memcpy(embed, ptr + index * _embed_size, _embed_size * sizeof(unsigned short));
-        }
-        else
-        {
-            memcpy(embed, _embeds.data() + index * _embed_size, _embed_size * sizeof(unsigned short));
-        }
+        copy_row(index, embed);
     }
 
     std::vector<unsigned short> getByIndex(unsigned int index)
@@ -106,4 +202,77 @@ public:
         this->getByIndex(index, embed);
         return embed;
     }
+
+    /**
+     * Compress bf16 table to int8 table, symmetric quantization with one scale for each row, about half size.
+     * Rows are processed one by one, memory usage is small.
+     */
+    static bool Quantize(std::string bf16_path, std::string int8_path, unsigned int token_num, unsigned int embed_size)
+    {
+        MMap src;
+        if (!src.open_file(bf16_path.c_str()) || src.size() != (size_t)token_num * embed_size * sizeof(unsigned short))
+        {
+            ALOGE("embed file(%s) open failed or size not match", bf16_path.c_str());
+            return false;
+        }
+        madvise(src.data(), src.size(), MADV_SEQUENTIAL);
+        std::ofstream fout(int8_path, std::ios::binary);
+        if (!fout.is_open())
+        {
+            ALOGE("file(%s) open failed", int8_path.c_str());
+            return false;
+        }
+        const unsigned short *rows = (const unsigned short *)src.data();
+        std::vector<float> scales(token_num);
+        for (unsigned int t = 0; t < token_num; t++)
+        {
+            float max_abs = 0;
+            for (unsigned int i = 0; i < embed_size; i++)
+            {
+                max_abs = fmaxf(max_abs, fabsf(bf16_to_float(rows[(size_t)t * embed_size + i])));
+            }
+            scales[t] = max_abs / 127.0f;
+        }
+        fout.write((const char *)scales.data(), scales.size() * sizeof(float));
+        std::vector<int8_t> q(embed_size);
+        for (unsigned int t = 0; t < token_num; t++)
+        {
+            float inv = scales[t] > 0 ? 1.0f / scales[t] : 0;
+            for (unsigned int i = 0; i < embed_size; i++)
+            {
+                q[i] = (int8_t)lrintf(bf16_to_float(rows[(size_t)t * embed_size + i]) * inv);
+            }
+            fout.write((const char *)q.data(), q.size());
+        }
+        fout.close();
+        if (!fout)
+        {
+            ALOGE("write file(%s) failed", int8_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Get int8 table of bf16 table, bf16_path + ".int8", created by Quantize() if not exists or older than bf16 table.
+     * @return path of int8 table, or bf16_path if create failed.
+     */
+    static std::string Int8Table(const std::string &bf16_path, unsigned int token_num, unsigned int embed_size)
+    {
+        std::string int8_path = bf16_path + ".int8";
+        struct stat bf16_st, int8_st;
+        if (stat(int8_path.c_str(), &int8_st) == 0 && (size_t)int8_st.st_size == (size_t)token_num * (embed_size + sizeof(float)) &&
+            (stat(bf16_path.c_str(), &bf16_st) != 0 || bf16_st.st_mtime <= int8_st.st_mtime))
+            return int8_path;
+        ALOGI("quantize embed file(%s) to %s", bf16_path.c_str(), int8_path.c_str());
+        // write to temp file then rename, a broken file is never used
+        std::string tmp = int8_path + ".tmp";
+        if (!Quantize(bf16_path, tmp, token_num, embed_size) || rename(tmp.c_str(), int8_path.c_str()) != 0)
+        {
+            remove(tmp.c_str());
+            ALOGW("create int8 embed file(%s) failed, use bf16 table", int8_path.c_str());
+            return bf16_path;
+        }
+        return int8_path;
+    }
 };
@@ -0,0 +1,400 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include "sample_log.h"
+
+/**
+ * Host side pool of KV cache snapshots of token prefixes.
+ * Prefixes are stored as a tree, every node holds K/V rows of one token segment and is keyed by chained hash of
+ * all tokens from position 0, so a prefix shared by many prompts(e.g. system prompt) is stored only once.
+ * Rows of position i only depend on tokens [0, i], so a node can also be partially used when tokens diverge inside it.
+ */
+class LLMKVCachePool
+{
+public:
+    struct Node
+    {
+        uint64_t hash = 0;
+        uint64_t parent = 0;            // 0 means root
+        int start = 0;                  // position of first token
+        std::vector<int> tokens;
+        std::vector<unsigned short> k, v; // [layer][token][kv_size]
+        std::vector<uint64_t> children;
+        uint64_t last_use = 0;
+        bool persist = false;           // saved to snapshot file
+    };
+
+    static constexpr uint64_t HASH_SEED = 1469598103934665603ULL; // FNV-1a 64 offset basis
+
+    static uint64_t Hash(uint64_t h, const int *tokens, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t t = (uint32_t)tokens[i];
+            for (int b = 0; b < 4; b++)
+            {
+                h ^= (t >> (b * 8)) & 0xff;
+                h *= 1099511628211ULL;
+            }
+        }
+        return h;
+    }
+
+    void Init(int layer_num, int kv_size, size_t max_bytes, uint64_t model_tag)
+    {
+        Clear();
+        _layer_num = layer_num;
+        _kv_size = kv_size;
+        _max_bytes = max_bytes;
+        _model_tag = model_tag;
+    }
+
+    void Clear()
+    {
+        _nodes.clear();
+        _roots.clear();
+        _bytes = 0;
+    }
+
+    size_t Bytes() const
+    {
+        return _bytes;
+    }
+
+    /**
+     * Find longest cached prefix of tokens.
+     * @param max_len only match first max_len tokens.
+     * @param chain nodes from root, the last node may be partially used.
+     * @return matched tokens number.
+     */
+    int Match(const std::vector<int> &tokens, int max_len, std::vector<const Node *> &chain)
+    {
+        chain.clear();
+        max_len = std::min(max_len, (int)tokens.size());
+        const std::vector<uint64_t> *children = &_roots;
+        int pos = 0;
+        while (pos < max_len)
+        {
+            Node *best = nullptr;
+            int best_n = 0;
+            for (auto h : *children)
+            {
+                auto it = _nodes.find(h);
+                if (it == _nodes.end())
+                    continue;
+                Node &node = it->second;
+                int n = 0;
+                int limit = std::min((int)node.tokens.size(), max_len - pos);
+                while (n < limit && node.tokens[n] == tokens[pos + n])
+                    n++;
+                if (n > best_n)
+                {
+                    best = &node;
+                    best_n = n;
+                }
+            }
+            if (!best)
+                break;
+            best->last_use = ++_clock;
+            chain.push_back(best);
+            pos += best_n;
+            if (best_n < (int)best->tokens.size())
+                break;
+            children = &best->children;
+        }
+        return pos;
+    }
+
+    /**
+     * Copy rows [from, to) of matched chain to KV caches.
+     * @param k_dst K cache of every layer, rows of kv_size.
+     */
+    void Restore(const std::vector<const Node *> &chain, int from, int to, const std::vector<unsigned short *> &k_dst, const std::vector<unsigned short *> &v_dst)
+    {
+        for (auto node : chain)
+        {
+            int n = (int)node->tokens.size();
+            int s = std::max(from, node->start);
+            int e = std::min(to, node->start + n);
+            if (s >= e)
+                continue;
+            size_t row_bytes = (size_t)_kv_size * sizeof(unsigned short);
+            for (int l = 0; l < _layer_num; l++)
+            {
+                size_t src = ((size_t)l * n + (s - node->start)) * _kv_size;
+                memcpy(k_dst[l] + (size_t)s * _kv_size, node->k.data() + src, (e - s) * row_bytes);
+                memcpy(v_dst[l] + (size_t)s * _kv_size, node->v.data() + src, (e - s) * row_bytes);
+            }
+        }
+    }
+
+    /**
+     * Add prefix tokens[0, len) whose KV rows are in caches, only rows not in pool are copied.
+     * @param persist mark the prefix to be saved by Save.
+     */
+    void Insert(const std::vector<int> &tokens, int len, const std::vector<unsigned short *> &k_src, const std::vector<unsigned short *> &v_src, bool persist = false)
+    {
+        if (_max_bytes == 0 || len <= 0)
+            return;
+        // walk fully matched nodes
+        std::vector<uint64_t> *children = &_roots;
+        uint64_t parent = 0;
+        uint64_t hash = HASH_SEED;
+        int pos = 0;
+        std::vector<uint64_t> path;
+        while (pos < len)
+        {
+            // take the longest fully matched child, a shorter one would make a new node of the same prefix
+            Node *next = nullptr;
+            for (auto h : *children)
+            {
+                auto it = _nodes.find(h);
+                if (it == _nodes.end())
+                    continue;
+                Node &node = it->second;
+                int n = (int)node.tokens.size();
+                if (pos + n <= len && (!next || n > (int)next->tokens.size()) && std::equal(node.tokens.begin(), node.tokens.end(), tokens.begin() + pos))
+                    next = &node;
+            }
+            if (!next)
+                break;
+            next->last_use = ++_clock;
+            next->persist |= persist;
+            path.push_back(next->hash);
+            parent = next->hash;
+            hash = next->hash;
+            pos += next->tokens.size();
+            children = &next->children;
+        }
+        if (pos < len)
+        {
+            int n = len - pos;
+            size_t bytes = (size_t)2 * _layer_num * n * _kv_size * sizeof(unsigned short);
+            if (bytes > _max_bytes)
+            {
+                ALOGW("kv cache prefix(%d tokens, %zu bytes) larger than pool size %zu", n, bytes, _max_bytes);
+                return;
+            }
+            Node node;
+            node.hash = Hash(hash, tokens.data() + pos, n);
+            node.parent = parent;
+            node.start = pos;
+            node.tokens.assign(tokens.begin() + pos, tokens.begin() + len);
+            node.k.resize((size_t)_layer_num * n * _kv_size);
+            node.v.resize((size_t)_layer_num * n * _kv_size);
+            for (int l = 0; l < _layer_num; l++)
+            {
+                memcpy(node.k.data() + (size_t)l * n * _kv_size, k_src[l] + (size_t)pos * _kv_size, (size_t)n * _kv_size * sizeof(unsigned short));
+                memcpy(node.v.data() + (size_t)l * n * _kv_size, v_src[l] + (size_t)pos * _kv_size, (size_t)n * _kv_size * sizeof(unsigned short));
+            }
+            node.last_use = ++_clock;
+            node.persist = persist;
+            uint64_t node_hash = node.hash;
+            if (_add(std::move(node)))
+                path.push_back(node_hash);
+        }
+        _evict(path);
+    }
+
+    /**
+     * Save persist prefixes to file.
+     * @return false if failed.
+     */
+    bool Save(const std::string &path)
+    {
+        std::vector<const Node *> nodes;
+        for (auto &item : _nodes)
+        {
+            if (item.second.persist)
+                nodes.push_back(&item.second);
+        }
+        // parent before child
+        std::sort(nodes.begin(), nodes.end(), [](const Node *a, const Node *b)
+                  { return a->start < b->start; });
+
+        std::string tmp = path + ".tmp";
+        FILE *fp = fopen(tmp.c_str(), "wb");
+        if (!fp)
+        {
+            ALOGE("open %s failed", tmp.c_str());
+            return false;
+        }
+        uint32_t header[4] = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, (uint32_t)_layer_num, (uint32_t)_kv_size};
+        uint32_t count = nodes.size();
+        bool ok = fwrite(header, sizeof(header), 1, fp) == 1 && fwrite(&_model_tag, sizeof(_model_tag), 1, fp) == 1 && fwrite(&count, sizeof(count), 1, fp) == 1;
+        for (auto node : nodes)
+        {
+            if (!ok)
+                break;
+            int32_t info[2] = {node->start, (int32_t)node->tokens.size()};
+            ok = fwrite(&node->parent, sizeof(node->parent), 1, fp) == 1 && fwrite(info, sizeof(info), 1, fp) == 1 && fwrite(node->tokens.data(), sizeof(int), node->tokens.size(), fp) == node->tokens.size() && fwrite(node->k.data(), sizeof(unsigned short), node->k.size(), fp) == node->k.size() && fwrite(node->v.data(), sizeof(unsigned short), node->v.size(), fp) == node->v.size();
+        }
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            ALOGE("write kv cache snapshot %s failed", path.c_str());
+            remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Load prefixes saved by Save, snapshot of other model is ignored.
+     * @return false if file not exists or not valid.
+     */
+    bool Load(const std::string &path)
+    {
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp)
+            return false;
+        fseek(fp, 0, SEEK_END);
+        long file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        uint32_t header[4];
+        uint64_t model_tag;
+        uint32_t count;
+        if (fread(header, sizeof(header), 1, fp) != 1 || fread(&model_tag, sizeof(model_tag), 1, fp) != 1 || fread(&count, sizeof(count), 1, fp) != 1 ||
+            header[0] != SNAPSHOT_MAGIC || header[1] != SNAPSHOT_VERSION || header[2] != (uint32_t)_layer_num || header[3] != (uint32_t)_kv_size || model_tag != _model_tag)
+        {
+            ALOGW("kv cache snapshot %s not match current model, ignore it", path.c_str());
+            fclose(fp);
+            return false;
+        }
+        bool ok = true;
+        for (uint32_t i = 0; i < count && ok; i++)
+        {
+            Node node;
+            int32_t info[2];
+            ok = fread(&node.parent, sizeof(node.parent), 1, fp) == 1 && fread(info, sizeof(info), 1, fp) == 1 && info[1] > 0 && info[0] >= 0;
+            if (!ok)
+                break;
+            // check sizes before allocating, a broken file must not make us allocate more than pool size or file length
+            uint64_t row_bytes = (uint64_t)2 * _layer_num * _kv_size * sizeof(unsigned short);
+            uint64_t node_bytes = (uint64_t)info[1] * row_bytes;
+            uint64_t remain = file_size > ftell(fp) ? (uint64_t)(file_size - ftell(fp)) : 0;
+            if (row_bytes == 0 || (uint64_t)info[0] + info[1] > INT32_MAX || node_bytes > _max_bytes || node_bytes + (uint64_t)info[1] * sizeof(int) > remain)
+            {
+                ok = false;
+                break;
+            }
+            size_t rows = (size_t)_layer_num * info[1] * _kv_size;
+            node.start = info[0];
+            node.tokens.resize(info[1]);
+            node.k.resize(rows);
+            node.v.resize(rows);
+            ok = fread(node.tokens.data(), sizeof(int), info[1], fp) == (size_t)info[1] && fread(node.k.data(), sizeof(unsigned short), rows, fp) == rows && fread(node.v.data(), sizeof(unsigned short), rows, fp) == rows;
+            if (!ok)
+                break;
+            uint64_t parent_hash = HASH_SEED;
+            int parent_end = 0;
+            if (node.parent)
+            {
+                auto it = _nodes.find(node.parent);
+                if (it == _nodes.end())
+                    continue; // parent evicted when saving, drop
+                parent_hash = it->second.hash;
+                parent_end = it->second.start + it->second.tokens.size();
+            }
+            if (parent_end != node.start)
+            {
+                ok = false;
+                break;
+            }
+            node.hash = Hash(parent_hash, node.tokens.data(), node.tokens.size());
+            node.last_use = ++_clock;
+            node.persist = true;
+            _add(std::move(node));
+        }
+        fclose(fp);
+        if (!ok)
+        {
+            ALOGW("kv cache snapshot %s broken, ignore it", path.c_str());
+            Clear();
+            return false;
+        }
+        _evict({});
+        return true;
+    }
+
+private:
+    static constexpr uint32_t SNAPSHOT_MAGIC = 0x43564b4d; // "MKVC"
+    static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+    // add node, or reuse the existing one with same hash, chained hash of a prefix is the same however it is split into nodes.
+    // @return false if not added
+    bool _add(Node &&node)
+    {
+        uint64_t hash = node.hash;
+        uint64_t parent = node.parent;
+        auto exist = _nodes.find(hash);
+        if (exist != _nodes.end())
+        {
+            Node &old = exist->second;
+            // same prefix end has the same rows, else it's a real hash collision, keep the old one
+            if (old.start + old.tokens.size() != node.start + node.tokens.size())
+                return false;
+            old.last_use = std::max(old.last_use, node.last_use);
+            old.persist |= node.persist;
+            return true;
+        }
+        auto parent_it = _nodes.find(parent);
+        if (parent && parent_it == _nodes.end())
+            return false;
+        _bytes += (node.k.size() + node.v.size()) * sizeof(unsigned short);
+        _nodes.emplace(hash, std::move(node));
+        if (parent)
+            parent_it->second.children.push_back(hash);
+        else
+            _roots.push_back(hash);
+        return true;
+    }
+
+    void _remove(uint64_t hash)
+    {
+        auto it = _nodes.find(hash);
+        if (it == _nodes.end())
+            return;
+        Node &node = it->second;
+        auto parent_it = _nodes.find(node.parent);
+        auto &siblings = node.parent && parent_it != _nodes.end() ? parent_it->second.children : _roots;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), hash), siblings.end());
+        _bytes -= (node.k.size() + node.v.size()) * sizeof(unsigned short);
+        _nodes.erase(it);
+    }
+
+    // remove least recently used leaves until pool is not over size, nodes in keep are not removed
+    void _evict(const std::vector<uint64_t> &keep)
+    {
+        while (_bytes > _max_bytes)
+        {
+            uint64_t victim = 0;
+            uint64_t oldest = UINT64_MAX;
+            for (auto &item : _nodes)
+            {
+                const Node &node = item.second;
+                if (!node.children.empty() || node.last_use >= oldest || std::find(keep.begin(), keep.end(), item.first) != keep.end())
+                    continue;
+                victim = item.first;
+                oldest = node.last_use;
+            }
+            if (!victim)
+                break;
+            _remove(victim);
+        }
+    }
+
+    std::unordered_map<uint64_t, Node> _nodes;
+    std::vector<uint64_t> _roots;
+    int _layer_num = 0;
+    int _kv_size = 0;
+    size_t _max_bytes = 0;
+    size_t _bytes = 0;
+    uint64_t _model_tag = 0;
+    uint64_t _clock = 0;
+};
@@ -6,216 +6,275 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
-#include <unordered_set>
+#include <stdint.h>
+#include <string.h>
 #include "nlohmann/json.hpp"
 #include "utils/sample_log.h"
 #include "maix_llm_qwen.hpp"
-
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Token sampling of LLM output logits.
+ * All buffers are allocated once for vocabulary size and reused for every token,
+ * bf16 to float conversion, temperature and max are done in one vectorized pass, penalties only touch their tokens,
+ * and top-k/top-p/min-p only sort the few candidates above a logit threshold instead of the whole vocabulary.
+ */
 class LLMPostprocess
 {
 private:
-    // 	控制随机性
-    void apply_temperature(std::vector<float> &logits, float temperature)
+    // exp(x) for x <= 0, 2^(x*log2(e)) with polynomial of fraction part, relative error about 1e-5, enough for sampling weights
+    static inline float fast_exp(float x)
+    {
+        x = std::max(x, -87.0f);
+        float t = x * 1.44269504f;
+        float fi = std::floor(t);
+        float f = t - fi;
+        float p = 1.0f + f * (0.693147182f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f + f * (0.00133335581f + f * 0.000154035304f)))));
+        int32_t bits = ((int32_t)fi + 127) << 23;
+        float s;
+        memcpy(&s, &bits, sizeof(s));
+        return p * s;
+    }
+
+    static float max_value(const float *x, int n)
     {
-        for (float &logit : logits)
+        int i = 0;
+        float max_val = -INFINITY;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        float32x4_t vmax = vdupq_n_f32(-INFINITY);
+        for (; i + 4 <= n; i += 4)
+        {
+            vmax = vmaxq_f32(vmax, vld1q_f32(x + i));
+        }
+        max_val = vmaxvq_f32(vmax);
+#endif
+        for (; i < n; i++)
         {
-            logit /= temperature;
+            max_val = x[i] > max_val ? x[i] : max_val;
         }
+        return max_val;
     }
 
-    // 防止重复
-    void apply_repetition_penalty(std::vector<float> &logits, const std::vector<int> &history, float penalty)
+    // bf16 to float and multiply scale, return max value
+    float load_logits(const unsigned short *p, int n, float scale)
     {
-        for (int token : history)
+        float *out = _logits.data();
+        int i = 0;
+        float max_val = -INFINITY;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        float32x4_t vmax = vdupq_n_f32(-INFINITY);
+        float32x4_t vscale = vdupq_n_f32(scale);
+        for (; i + 8 <= n; i += 8)
         {
-            if ((size_t)token < logits.size())
-            {
-                logits[token] = logits[token] < 0 ? logits[token] * penalty : logits[token] / penalty;
-            }
+            uint16x8_t raw = vld1q_u16(p + i);
+            float32x4_t lo = vmulq_f32(vreinterpretq_f32_u32(vshll_n_u16(vget_low_u16(raw), 16)), vscale);
+            float32x4_t hi = vmulq_f32(vreinterpretq_f32_u32(vshll_high_n_u16(raw, 16)), vscale);
+            vst1q_f32(out + i, lo);
+            vst1q_f32(out + i + 4, hi);
+            vmax = vmaxq_f32(vmax, vmaxq_f32(lo, hi));
         }
+        max_val = vmaxvq_f32(vmax);
+#endif
+        for (; i < n; i++)
+        {
+            uint32_t bits = (uint32_t)p[i] << 16;
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            v *= scale;
+            out[i] = v;
+            max_val = v > max_val ? v : max_val;
+        }
+        return max_val;
     }
 
-    void apply_repetition_penalty(std::vector<float> &logits,
-                                  const std::vector<int> &generated_tokens,
-                                  float repetition_penalty,
-                                  int penalty_window)
+    float load_logits(const float *p, int n, float scale)
     {
-        if (repetition_penalty == 1.0f || generated_tokens.empty())
+        float *out = _logits.data();
+        for (int i = 0; i < n; i++)
         {
-            return; // 如果 penalty = 1.0 或者没有生成 token，则不进行修改
+            out[i] = p[i] * scale;
         }
+        return max_value(out, n);
+    }
 
-        int start_idx = std::max(0, (int)generated_tokens.size() - penalty_window);
-        std::unordered_set<int> recent_tokens(generated_tokens.begin() + start_idx, generated_tokens.end());
-
-        for (int token : recent_tokens)
+    void reserve(int n)
+    {
+        if ((int)_logits.size() < n)
         {
-            if ((size_t)token < 0 || (size_t)token >= logits.size())
-                continue;
+            _logits.resize(n);
+            _idx.resize(n);
+            _weights.resize(n);
+            _stamp.assign(n, 0);
+        }
+    }
 
-            if (logits[token] > 0)
+    // penalties only change logits of history tokens, return true if any logit changed
+    bool apply_penalties(int n, const std::vector<int> &history)
+    {
+        bool changed = false;
+        if (enable_repetition_penalty && repetition_penalty != 1.0f && !history.empty())
+        {
+            // every token in window is penalized once, stamp instead of set to find repeated ones
+            if (++_stamp_gen == 0)
             {
-                logits[token] /= std::sqrt(repetition_penalty);
+                std::fill(_stamp.begin(), _stamp.end(), 0);
+                _stamp_gen = 1;
             }
-            else
+            float factor = std::sqrt(repetition_penalty);
+            int start_idx = std::max(0, (int)history.size() - penalty_window);
+            for (size_t i = start_idx; i < history.size(); i++)
             {
-                logits[token] *= std::sqrt(repetition_penalty);
+                int token = history[i];
+                if (token < 0 || token >= n || _stamp[token] == _stamp_gen)
+                    continue;
+                _stamp[token] = _stamp_gen;
+                _logits[token] = _logits[token] > 0 ? _logits[token] / factor : _logits[token] * factor;
+                changed = true;
             }
         }
-    }
-
-    // 增强多样性
-    void apply_diversity_penalty(std::vector<float> &logits, const std::vector<int> &common_phrases, float penalty)
-    {
-        for (int token : common_phrases)
+        if (enable_diversity_penalty)
         {
-            if ((size_t)token < logits.size())
+            for (int token : common_phrases)
             {
-                logits[token] *= penalty;
+                if (token >= 0 && token < n)
+                {
+                    _logits[token] *= diversity_penalty;
+                    changed = true;
+                }
             }
         }
+        return changed;
     }
 
-    // Softmax function
-    std::vector<float> softmax(const std::vector<float> &logits)
+    int argmax(int n, float max_val)
     {
-        std::vector<float> probs(logits.size());
-        float max_logit = *std::max_element(logits.begin(), logits.end());
-        float sum = 0.0f;
-
-        for (size_t i = 0; i < logits.size(); ++i)
+        const float *logits = _logits.data();
+        for (int i = 0; i < n; i++)
         {
-            probs[i] = std::exp(logits[i] - max_logit);
-            sum += probs[i];
+            if (logits[i] == max_val)
+                return i;
         }
+        return 0;
+    }
 
-        for (float &p : probs)
+    // indices of logits >= threshold to _idx, return number
+    int collect(int n, float threshold)
+    {
+        const float *logits = _logits.data();
+        int *idx = _idx.data();
+        int count = 0;
+        for (int i = 0; i < n; i++)
         {
-            p /= sum;
+            idx[count] = i;
+            count += logits[i] >= threshold;
         }
-
-        return probs;
+        return count;
     }
 
-    // 	动态裁剪低概率 token
-    int faster_top_p_sampling(const std::vector<float> &logits, float top_p)
+    void sort_candidates(int count)
     {
-        // 计算softmax
-        std::vector<float> probs = softmax(logits);
+        const float *logits = _logits.data();
+        std::sort(_idx.begin(), _idx.begin() + count, [logits](int a, int b)
+                  { return logits[a] > logits[b]; });
+    }
 
-        // 构建最大堆（概率和索引的配对）
-        std::vector<std::pair<float, size_t>> prob_index;
-        prob_index.reserve(logits.size());
-        for (size_t i = 0; i < logits.size(); ++i)
+    // sample from first count candidates in _idx, weights are exp(logit - max_val)
+    int sample(int count, float max_val, float min_logit)
+    {
+        const float *logits = _logits.data();
+        float sum = 0;
+        int valid = 0;
+        for (int i = 0; i < count; i++)
         {
-            prob_index.emplace_back(probs[i], i);
+            float logit = logits[_idx[i]];
+            if (logit < min_logit)
+                continue;
+            _idx[valid] = _idx[i];
+            _weights[valid] = fast_exp(logit - max_val);
+            sum += _weights[valid];
+            valid++;
         }
-        auto cmp = [](const auto &a, const auto &b)
-        { return a.first < b.first; };
-        std::make_heap(prob_index.begin(), prob_index.end(), cmp);
-
-        // 提取top-p元素
-        std::vector<size_t> filtered_indices;
-        std::vector<float> filtered_probs;
-        float cumulative_prob = 0.0f;
-
-        while (!prob_index.empty() && cumulative_prob < top_p)
+        if (valid == 0)
+            return count > 0 ? _idx[0] : 0;
+        float r = std::uniform_real_distribution<float>(0.0f, sum)(_gen);
+        for (int i = 0; i < valid; i++)
         {
-            std::pop_heap(prob_index.begin(), prob_index.end(), cmp);
-            auto [prob, index] = prob_index.back();
-            prob_index.pop_back();
-
-            cumulative_prob += prob;
-            filtered_indices.push_back(index);
-            filtered_probs.push_back(prob);
-
-            if (cumulative_prob >= top_p)
-                break;
+            r -= _weights[i];
+            if (r < 0)
+                return _idx[i];
         }
-
-        // 处理边缘情况（概率全零时返回第一个元素）
-        if (filtered_indices.empty())
-            return 0;
-
-        // 使用thread_local随机数生成器（线程安全）
-        static thread_local std::mt19937 gen(std::random_device{}());
-        std::discrete_distribution<int> dist(filtered_probs.begin(), filtered_probs.end());
-        return filtered_indices[dist(gen)];
+        return _idx[valid - 1];
     }
-    int top_p_sampling(const std::vector<float> &logits, float top_p)
+
+    int top_k_sampling(int n, float max_val, int k, float min_logit)
     {
-        std::vector<float> probs = softmax(logits);
-
-        // Sort indices by probability in descending order
-        std::vector<size_t> indices(logits.size());
-        std::iota(indices.begin(), indices.end(), 0);
-        std::sort(indices.begin(), indices.end(), [&](size_t i, size_t j)
-                  { return probs[i] > probs[j]; });
-
-        // Compute cumulative probabilities
-        float cumulative_prob = 0.0f;
-        size_t cut_off = 0;
-        for (; cut_off < indices.size(); ++cut_off)
+        k = std::max(1, std::min(k, n));
+        // bisect threshold until candidates are enough but not too many, collect is much cheaper than selection
+        float lo = 0, hi = 0, delta = 8.0f;
+        int count = 0;
+        for (int i = 0; i < 16; i++)
         {
-            cumulative_prob += probs[indices[cut_off]];
-            if (cumulative_prob >= top_p)
+            count = collect(n, delta > 1024.0f ? -INFINITY : max_val - delta);
+            if (count < k)
+            {
+                if (delta > 1024.0f)
+                    break;
+                lo = delta;
+                delta = hi > 0 ? (lo + hi) / 2 : delta * 2;
+            }
+            else if (count > 8 * k + 64)
+            {
+                hi = delta;
+                delta = (lo + hi) / 2;
+            }
+            else
                 break;
         }
-
-        // Keep only the top-p probabilities
-        std::vector<size_t> filtered_indices(indices.begin(), indices.begin() + cut_off + 1);
-        std::vector<float> filtered_probs(filtered_indices.size());
-        for (size_t i = 0; i < filtered_indices.size(); ++i)
-        {
-            filtered_probs[i] = probs[filtered_indices[i]];
-        }
-
-        // Normalize the probabilities
-        float filtered_sum = std::accumulate(filtered_probs.begin(), filtered_probs.end(), 0.0f);
-        for (float &p : filtered_probs)
+        if (count < k)
+            count = collect(n, hi > 0 ? max_val - hi : -INFINITY);
+        const float *logits = _logits.data();
+        if (count > k)
         {
-            p /= filtered_sum;
+            std::nth_element(_idx.begin(), _idx.begin() + k - 1, _idx.begin() + count, [logits](int a, int b)
+                             { return logits[a] > logits[b]; });
         }
-
-        // Sample from the filtered distribution
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::discrete_distribution<int> dist(filtered_probs.begin(), filtered_probs.end());
-        return filtered_indices[dist(gen)];
+        return sample(k, max_val, min_logit);
     }
 
-    // 限制候选 token 数
-    int top_k_sampling(const std::vector<float> &logits, int k)
+    int top_p_sampling(int n, float max_val, float p, float min_logit)
     {
-        // std::vector<float> probs = softmax(logits);
-
-        // 获取 top-k 索引
-        std::vector<size_t> indices(logits.size());
-        std::iota(indices.begin(), indices.end(), 0);
-        std::partial_sort(indices.begin(), indices.begin() + k, indices.end(), [&](size_t i, size_t j)
-                          { return logits[i] > logits[j]; });
-
-        // 仅保留 top-k 概率
-        std::vector<size_t> filtered_indices(indices.begin(), indices.begin() + k);
-        std::vector<float> filtered_probs(k);
-        for (int i = 0; i < k; ++i)
+        // normalizer of softmax
+        const float *logits = _logits.data();
+        float sum = 0;
+        for (int i = 0; i < n; i++)
         {
-            filtered_probs[i] = logits[filtered_indices[i]];
+            sum += fast_exp(logits[i] - max_val);
         }
-        filtered_probs = softmax(filtered_probs);
+        float target = p * sum;
 
-        // 归一化
-        float sum = std::accumulate(filtered_probs.begin(), filtered_probs.end(), 0.0f);
-        for (float &p : filtered_probs)
+        // sort only candidates near max, lower threshold if their probability is not enough
+        float delta = 8.0f;
+        int cut = 0;
+        while (true)
         {
-            p /= sum;
+            float threshold = delta > 1024.0f ? -INFINITY : max_val - delta;
+            int count = collect(n, threshold);
+            sort_candidates(count);
+            float cumulative = 0;
+            for (cut = 0; cut < count;)
+            {
+                cumulative += fast_exp(logits[_idx[cut]] - max_val);
+                cut++;
+                if (cumulative >= target)
+                    break;
+            }
+            if (cumulative >= target || threshold == -INFINITY)
+                break;
+            delta *= 2;
         }
-
-        // 采样
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::discrete_distribution<int> dist(filtered_probs.begin(), filtered_probs.end());
-        return filtered_indices[dist(gen)];
+        return sample(cut, max_val, min_logit);
     }
 
     bool enable_temperature = false;
@@ -235,6 +294,44 @@ private:
     bool enable_top_k_sampling = false;
     int top_k = 1;
 
+    bool enable_min_p_sampling = false;
+    float min_p = 0.05f;
+
+    // scratch, size of vocabulary
+    std::vector<float> _logits;
+    std::vector<int> _idx;
+    std::vector<float> _weights;
+    std::vector<uint32_t> _stamp;
+    uint32_t _stamp_gen = 0;
+    std::mt19937 _gen{std::random_device{}()};
+    int _seed = -1;
+
+    int sample_logits(int n, float max_val, const std::vector<int> &history)
+    {
+        if (apply_penalties(n, history))
+            max_val = max_value(_logits.data(), n);
+
+        // min-p keeps tokens with probability >= min_p * max probability
+        float min_logit = enable_min_p_sampling && min_p > 0 ? max_val + std::log(min_p) : -INFINITY;
+        if (enable_top_p_sampling)
+        {
+            // top_p >= 1 keeps all tokens, no need to normalize and sort
+            if (top_p >= 1.0f)
+                return sample(collect(n, min_logit), max_val, min_logit);
+            return top_p_sampling(n, max_val, top_p, min_logit);
+        }
+        else if (enable_top_k_sampling)
+            return top_k_sampling(n, max_val, top_k, min_logit);
+        else if (enable_min_p_sampling)
+            return sample(collect(n, min_logit), max_val, min_logit);
+        return argmax(n, max_val);
+    }
+
+    float logit_scale()
+    {
+        return enable_temperature && temperature > 0 ? 1.0f / temperature : 1.0f;
+    }
+
 public:
     LLMPostprocess() {}
 
@@ -271,6 +368,32 @@ public:
         this->top_k = top_k;
     }
 
+    void set_min_p_sampling(bool enable, float min_p)
+    {
+        enable_min_p_sampling = enable;
+        this->min_p = min_p;
+    }
+
+    /**
+     * Set random seed, same seed and same input get same output.
+     * @param seed < 0 means random seed.
+     */
+    void set_seed(int seed)
+    {
+        _seed = seed;
+        _gen.seed(seed < 0 ? std::random_device{}() : (uint32_t)seed);
+    }
+
+    /**
+     * Call at start of every generation, restart random sequence if seed is set,
+     * so output only depends on seed and input, not on generations before.
+     */
+    void begin()
+    {
+        if (_seed >= 0)
+            _gen.seed((uint32_t)_seed);
+    }
+
     bool load_config(std::string config_path)
     {
         std::ifstream config_file(config_path);
@@ -294,6 +417,10 @@ public:
 
         enable_top_k_sampling = config["enable_top_k_sampling"];
         top_k = config["top_k"];
+
+        enable_min_p_sampling = config.value("enable_min_p_sampling", false);
+        min_p = config.value("min_p", 0.05f);
+        set_seed(config.value("seed", -1));
         return true;
     }
 
@@ -311,28 +438,30 @@ public:
 
         enable_top_k_sampling = config.enable_top_k_sampling;
         top_k = config.top_k;
+
+        enable_min_p_sampling = config.enable_min_p_sampling;
+        min_p = config.min_p;
+        set_seed(config.seed);
         return true;
     }
 
-    int apply(std::vector<float> &logits, const std::vector<int> &history)
+    /**
+     * Sample next token from bf16 logits of model output.
+     * @param logits bf16 logits, n is vocabulary size.
+     * @param history generated tokens, used by repetition penalty.
+     */
+    int apply(const unsigned short *logits, int n, const std::vector<int> &history)
     {
-        if (enable_temperature)
-            apply_temperature(logits, temperature);
-        if (enable_repetition_penalty)
-            apply_repetition_penalty(logits, history, repetition_penalty, penalty_window);
-        if (enable_diversity_penalty)
-            apply_diversity_penalty(logits, common_phrases, diversity_penalty);
+        reserve(n);
+        float max_val = load_logits(logits, n, logit_scale());
+        return sample_logits(n, max_val, history);
+    }
 
-        if (enable_top_p_sampling)
-            return faster_top_p_sampling(logits, top_p);
-        else if (enable_top_k_sampling)
-            return top_k_sampling(logits, top_k);
-        else
-        {
-            // 最大值
-            // float max_logit = *std::max_element(logits.begin(), logits.end());
-            int max_index = std::distance(logits.begin(), std::max_element(logits.begin(), logits.end()));
-            return max_index;
-        }
+    int apply(std::vector<float> &logits, const std::vector<int> &history)
+    {
+        int n = logits.size();
+        reserve(n);
+        float max_val = load_logits(logits.data(), n, logit_scale());
+        return sample_logits(n, max_val, history);
     }
-};
\ No newline at end of file
+};
@@ -59,7 +59,7 @@ struct LLMAttrType
 
     int prefill_grpid = -1;
 
-    bool b_use_mmap_load_embed = false;
+    bool b_use_mmap_load_embed = true;
 
     int vpm_len;
 
@@ -102,17 +102,7 @@ private:
     LLMPostprocess postprocess;
     static int post_process(LLMPostprocess &postprocess, unsigned short *p, int n, std::vector<int> &history, float *val = 0)
     {
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wstrict-aliasing"
-        std::vector<float> logits(n);
-        for (int i = 0; i < n; i++)
-        {
-            unsigned int proc = p[i] << 16;
-            logits[i] = *reinterpret_cast<float *>(&proc);
-        }
-        #pragma GCC diagnostic pop
-
-        return postprocess.apply(logits, history);
+        return postprocess.apply(p, n, history);
     }
 
 public:
@@ -366,6 +356,7 @@ public:
     std::string Run(std::vector<unsigned short> test_embed)
     {
         b_stop = false;
+        postprocess.begin();
         std::string final_out;
 
         bfloat16 bf16 = -65536.f;
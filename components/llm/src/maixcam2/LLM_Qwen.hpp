@@ -3,9 +3,11 @@
 #include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <sys/stat.h>
 #include "bfloat16.hpp"
 #include "Tokenizer/Tokenizer.hpp"
 #include "LLMEmbedSelector.hpp"
+#include "LLMKVCache.hpp"
 #include "ax_model_runner/ax_model_runner_ax650.hpp"
 #include "ax_cmm_utils.hpp"
 #include "cqdm.h"
@@ -56,10 +58,13 @@ struct LLMAttrType
 
     int prefill_grpid = -1;
 
-    bool b_use_mmap_load_embed = false;
+    bool b_use_mmap_load_embed = true;
+    bool b_int8_embed = false; // use int8 table converted from bf16 table, about half size, see LLaMaEmbedSelector::Int8Table
 
     bool b_use_mmap_load_layer = true;
 
+    int kv_cache_pool_mb = 64; // host memory for K/V caches of computed prompt prefixes, 0 to disable
+
     // bool b_live_print = true;
     LLMRuningCallback runing_callback = nullptr;
     void *reserve = nullptr;
@@ -89,24 +94,21 @@ private:
 
     // ax_runner_ax650 vpm_resampler;
 
-    // std::vector<std::vector<unsigned short>> k_caches, v_caches;
+    // K/V caches of context stay in decode group inputs and are updated in place,
+    // prefill group caches are synced from decode group only for rows they miss.
+    LLMKVCachePool kv_pool;
+    int kv_len = 0;                         // tokens of context in decode group caches
+    std::vector<int> kv_tokens;             // tokens of context
+    std::vector<int> kv_grp_len;            // tokens synced to prefill group caches, index is group id
+    std::vector<int> prompt_tokens;         // tokens to prefill in next Run
+    std::vector<unsigned short> prefill_mask;
 
     bool b_stop = false;
 
     LLMPostprocess postprocess;
     static int post_process(LLMPostprocess &postprocess, unsigned short *p, int n, std::vector<int> &history, float *val = 0)
     {
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wstrict-aliasing"
-        std::vector<float> logits(n);
-        for (int i = 0; i < n; i++)
-        {
-            unsigned int proc = p[i] << 16;
-            logits[i] = *reinterpret_cast<float *>(&proc);
-        }
-        #pragma GCC diagnostic pop
-
-        return postprocess.apply(logits, history);
+        return postprocess.apply(p, n, history);
     }
 
 public:
@@ -136,9 +138,12 @@ public:
         //     printf("\n");
         // }
 
-        if (!embed_selector.Init(attr.filename_tokens_embed, attr.tokens_embed_num, attr.tokens_embed_size, attr.b_use_mmap_load_embed))
+        std::string embed_path = attr.filename_tokens_embed;
+        if (attr.b_int8_embed)
+            embed_path = LLaMaEmbedSelector::Int8Table(embed_path, attr.tokens_embed_num, attr.tokens_embed_size);
+        if (!embed_selector.Init(embed_path, attr.tokens_embed_num, attr.tokens_embed_size, attr.b_use_mmap_load_embed))
         {
-            ALOGE("embed_selector.Init(%s, %d, %d) failed", attr.filename_tokens_embed.c_str(), attr.tokens_embed_num, attr.tokens_embed_size);
+            ALOGE("embed_selector.Init(%s, %d, %d) failed", embed_path.c_str(), attr.tokens_embed_num, attr.tokens_embed_size);
             return false;
         }
         update_cqdm(&cqdm, 1, "count", "embed_selector init ok");
@@ -214,6 +219,33 @@ public:
             ALOGI("prefill_max_token_num : %d", _attr.prefill_max_token_num);
         }
 
+        // context K/V caches, cleared once here, rows after context are always masked
+        for (int i = 0; i < _attr.axmodel_num; i++)
+        {
+            auto &layer = llama_layers[i].layer;
+            for (int g = 0; g < layer.get_num_input_groups(); g++)
+            {
+                memset((void *)layer.get_input(g, "K_cache").pVirAddr, 0, layer.get_input(g, "K_cache").nSize);
+                memset((void *)layer.get_input(g, "V_cache").pVirAddr, 0, layer.get_input(g, "V_cache").nSize);
+            }
+        }
+        kv_len = 0;
+        kv_tokens.clear();
+        kv_grp_len.assign(llama_layers[0].layer.get_num_input_groups(), 0);
+        {
+            // snapshot is only valid for the same model files
+            uint64_t model_tag = LLMKVCachePool::HASH_SEED;
+            int dims[4] = {_attr.axmodel_num, _attr.kv_cache_size, _attr.tokens_embed_num, _attr.tokens_embed_size};
+            model_tag = LLMKVCachePool::Hash(model_tag, dims, 4);
+            struct stat st;
+            if (stat(llama_layers[0].filename.c_str(), &st) == 0)
+            {
+                int file_info[3] = {(int)st.st_size, (int)st.st_mtime, (int)(st.st_mtime >> 31 >> 1)};
+                model_tag = LLMKVCachePool::Hash(model_tag, file_info, 3);
+            }
+            kv_pool.Init(_attr.axmodel_num, _attr.kv_cache_size, (size_t)attr.kv_cache_pool_mb * 1024 * 1024, model_tag);
+        }
+
         if (!postprocess.load_config(post_config))
         {
             ALOGW("load postprocess config failed");
@@ -257,54 +289,92 @@ public:
         return 0;
     }
 
-    int GenerateKVCachePrefill(std::vector<int> &_token_ids, std::vector<std::vector<unsigned short>> &k_caches, std::vector<std::vector<unsigned short>> &v_caches, int &precompute_len)
+    // decode group K/V caches of every layer, they hold all tokens of current context
+    void GetDecodeKVCache(std::vector<unsigned short *> &k_caches, std::vector<unsigned short *> &v_caches)
     {
-        bfloat16 bf16 = -65536.f;
-        int input_embed_num = _token_ids.size();
-        int prefill_split_num = ceil((double)input_embed_num / _attr.prefill_token_num);
-
-        int prefill_grpid = _attr.prefill_max_kv_cache_num_grp.size();
+        k_caches.resize(_attr.axmodel_num);
+        v_caches.resize(_attr.axmodel_num);
+        for (int i = 0; i < _attr.axmodel_num; i++)
+        {
+            k_caches[i] = (unsigned short *)llama_layers[i].layer.get_input(decode_grpid, "K_cache").pVirAddr;
+            v_caches[i] = (unsigned short *)llama_layers[i].layer.get_input(decode_grpid, "V_cache").pVirAddr;
+        }
+    }
 
+    // smallest prefill group can hold token_num tokens, -1 if none
+    int SelectPrefillGroup(int token_num)
+    {
         for (size_t i = 0; i < _attr.prefill_max_kv_cache_num_grp.size(); i++)
         {
-            if (input_embed_num <= _attr.prefill_max_kv_cache_num_grp[i])
+            if (token_num <= _attr.prefill_max_kv_cache_num_grp[i])
             {
-                prefill_grpid = i + 1;
-                break;
+                return i + 1;
             }
         }
-        ALOGI("input token num : %d, prefill_split_num : %d prefill_grpid : %d", input_embed_num, prefill_split_num, prefill_grpid);
+        return -1;
+    }
 
-        // clear kv cache
-        for (int i = 0; i < _attr.axmodel_num; i++)
+    // copy rows decode group has but prefill group not, so prefill group K/V caches are the same as decode group
+    void SyncPrefillGroup(int prefill_grpid)
+    {
+        int from = std::min(kv_grp_len[prefill_grpid], kv_len);
+        if (from < kv_len)
         {
-            memset((void *)llama_layers[i].layer.get_input(prefill_grpid, "K_cache").pVirAddr, 0, llama_layers[i].layer.get_input(prefill_grpid, "K_cache").nSize);
-            memset((void *)llama_layers[i].layer.get_input(prefill_grpid, "V_cache").pVirAddr, 0, llama_layers[i].layer.get_input(prefill_grpid, "V_cache").nSize);
+            size_t offset = (size_t)from * _attr.kv_cache_size;
+            size_t bytes = (size_t)(kv_len - from) * _attr.kv_cache_size * sizeof(unsigned short);
+            for (int i = 0; i < _attr.axmodel_num; i++)
+            {
+                auto &layer = llama_layers[i].layer;
+                memcpy((unsigned short *)layer.get_input(prefill_grpid, "K_cache").pVirAddr + offset, (unsigned short *)layer.get_input(decode_grpid, "K_cache").pVirAddr + offset, bytes);
+                memcpy((unsigned short *)layer.get_input(prefill_grpid, "V_cache").pVirAddr + offset, (unsigned short *)layer.get_input(decode_grpid, "V_cache").pVirAddr + offset, bytes);
+            }
         }
+        kv_grp_len[prefill_grpid] = kv_len;
+    }
 
-        int kv_cache_num = _attr.prefill_max_kv_cache_num_grp[prefill_grpid - 1];
-
-        std::vector<unsigned short> test_embed;
-        test_embed.resize(_token_ids.size() * _attr.tokens_embed_size);
-
-
-        for (size_t i = 0; i < _token_ids.size(); i++)
-        {
-            embed_selector.getByIndex(_token_ids[i], test_embed.data() + i * _attr.tokens_embed_size);
-        }
+    // copy cached rows [kv_len, to) of chain to decode group K/V caches
+    void RestoreKVCache(const std::vector<const LLMKVCachePool::Node *> &chain, const std::vector<int> &tokens, int to)
+    {
+        std::vector<unsigned short *> k_caches, v_caches;
+        GetDecodeKVCache(k_caches, v_caches);
+        kv_pool.Restore(chain, kv_len, to, k_caches, v_caches);
+        kv_tokens.insert(kv_tokens.end(), tokens.begin() + kv_len, tokens.begin() + to);
+        kv_len = to;
+    }
 
+    // add current context to KV cache pool, only rows not in pool are copied
+    void SaveKVCacheToPool(bool persist)
+    {
+        std::vector<unsigned short *> k_caches, v_caches;
+        GetDecodeKVCache(k_caches, v_caches);
+        kv_pool.Insert(kv_tokens, kv_len, k_caches, v_caches, persist);
+    }
 
-        // axcl_Memcpy((void *)llama_layers[0].layer.get_input(_attr.prefill_grpid, "input").phyAddr, test_embed.data(), test_embed.size() * sizeof(unsigned short), AXCL_MEMCPY_HOST_TO_DEVICE, llama_layers[0].layer.get_devid());
-        // test_embed.resize(_attr.prefill_token_num * _attr.tokens_embed_size);
+    /**
+     * Chunked prefill tokens after current kv_len tokens,
+     * embeds of each chunk are gathered to input of first layer directly,
+     * K/V rows are written to decode group and prefill group caches in place.
+     * @param last_embed if not nullptr, output embed of last token will be copied to it.
+     * @return false if stopped.
+     */
+    bool Prefill(const int *tokens, int input_embed_num, int prefill_grpid, unsigned short *last_embed)
+    {
+        bfloat16 bf16 = -65536.f;
+        int precompute_len = kv_len;
+        int kv_cache_num = _attr.prefill_max_kv_cache_num_grp[prefill_grpid - 1];
+        int prefill_split_num = ceil((double)input_embed_num / _attr.prefill_token_num);
+        ALOGI("input token num : %d, precompute_len : %d, prefill_split_num : %d prefill_grpid : %d", input_embed_num, precompute_len, prefill_split_num, prefill_grpid);
 
+        prefill_mask.resize(_attr.prefill_token_num * (kv_cache_num + _attr.prefill_token_num));
+        size_t input_bytes = (size_t)_attr.prefill_token_num * _attr.tokens_embed_size * sizeof(unsigned short);
         for (int p = 0; p < prefill_split_num; p++)
         {
             if (b_stop)
             {
-                break;
+                return false;
             }
-            std::vector<unsigned short> mask_tmp;
-            mask_tmp.resize(1 * _attr.prefill_token_num * (kv_cache_num + _attr.prefill_token_num), bf16.data);
+
+            std::fill(prefill_mask.begin(), prefill_mask.end(), bf16.data);
             int input_num_token = _attr.prefill_token_num;
             if (p == prefill_split_num - 1)
             {
@@ -312,61 +382,59 @@ public:
             }
 
             ALOGI("input_num_token:%d", input_num_token);
-            for (int i = 0; i < _attr.prefill_token_num; i++)
+            for (int i = 0; i < input_num_token; i++)
             {
-                if (i < input_num_token)
-                {
-                    int mask_current_start = kv_cache_num;
-                    auto mask_ptr = mask_tmp.data() + i * (kv_cache_num + _attr.prefill_token_num);
-
-                    for (int j = 0; j < p * _attr.prefill_token_num; j++)
-                    {
-                        mask_ptr[j] = 0;
-                    }
+                int mask_current_start = kv_cache_num;
+                auto mask_ptr = prefill_mask.data() + i * (kv_cache_num + _attr.prefill_token_num);
 
-                    for (int j = mask_current_start; j < mask_current_start + i + 1; j++)
-                    {
-                        mask_ptr[j] = 0;
-                    }
+                for (int j = 0; j < precompute_len + p * _attr.prefill_token_num; j++)
+                {
+                    mask_ptr[j] = 0;
                 }
-            }
 
-            std::vector<unsigned short> embed_tmp(_attr.prefill_token_num * _attr.tokens_embed_size, 0);
-            if (p == (prefill_split_num - 1))
-            {
-                memcpy(embed_tmp.data(), test_embed.data() + p * _attr.prefill_token_num * _attr.tokens_embed_size, (input_embed_num - p * _attr.prefill_token_num) * _attr.tokens_embed_size * sizeof(unsigned short));
-            }
-            else
-            {
-                memcpy(embed_tmp.data(), test_embed.data() + p * _attr.prefill_token_num * _attr.tokens_embed_size, _attr.prefill_token_num * _attr.tokens_embed_size * sizeof(unsigned short));
+                for (int j = mask_current_start; j < mask_current_start + i + 1; j++)
+                {
+                    mask_ptr[j] = 0;
+                }
             }
 
+            // embeds are gathered to input of first layer, padding rows are 0,
+            // output of each layer is copied to input of next layer directly
+            unsigned short *first_input = (unsigned short *)llama_layers[0].layer.get_input(prefill_grpid, "input").pVirAddr;
+            embed_selector.Gather(tokens + p * _attr.prefill_token_num, input_num_token, first_input);
+            size_t valid_bytes = (size_t)input_num_token * _attr.tokens_embed_size * sizeof(unsigned short);
+            memset((uint8_t *)first_input + valid_bytes, 0, input_bytes - valid_bytes);
+            void *layer_output = nullptr;
             for (int m = 0; m < _attr.axmodel_num; m++)
             {
                 if (b_stop)
                 {
-                    break;
+                    return false;
                 }
 
                 auto &layer = llama_layers[m];
+
                 // set indices
                 auto &input_indices = layer.layer.get_input(prefill_grpid, "indices");
                 unsigned int *input_indices_ptr = (unsigned int *)input_indices.pVirAddr;
                 memset(input_indices_ptr, 0, input_indices.nSize);
                 int idx = 0;
-                for (int i = p * _attr.prefill_token_num; i < (p + 1) * _attr.prefill_token_num; i++)
+                for (int i = precompute_len + p * _attr.prefill_token_num; i < precompute_len + (p + 1) * _attr.prefill_token_num; i++)
                 {
                     input_indices_ptr[idx] = i;
                     idx++;
                 }
-                // memcpy((void *)input_indices.phyAddr, input_indices_ptr, input_indices.nSize);
 
                 // set mask
                 auto &input_mask = layer.layer.get_input(prefill_grpid, "mask");
-                memcpy((void *)input_mask.pVirAddr, (void *)mask_tmp.data(), mask_tmp.size() * sizeof(unsigned short));
+                memcpy((void *)input_mask.pVirAddr, (void *)prefill_mask.data(), prefill_mask.size() * sizeof(unsigned short));
 
-                auto &input_input = layer.layer.get_input(prefill_grpid, "input");
-                memcpy((void *)input_input.pVirAddr, embed_tmp.data(), embed_tmp.size() * sizeof(unsigned short));
+                // set input, first layer's input is already set
+                if (m > 0)
+                {
+                    auto &input_input = layer.layer.get_input(prefill_grpid, "input");
+                    memcpy((void *)input_input.pVirAddr, layer_output, input_bytes);
+                }
 
                 layer.layer.inference(prefill_grpid);
 
@@ -379,291 +447,156 @@ public:
                 auto &output_k_cache = layer.layer.get_output(prefill_grpid, "K_cache_out");
                 auto &output_v_cache = layer.layer.get_output(prefill_grpid, "V_cache_out");
 
-                int kv_offset = (p * _attr.prefill_token_num) * _attr.kv_cache_size;
+                // only rows of valid tokens, padding rows may exceed cache size
+                int kv_offset = (precompute_len + p * _attr.prefill_token_num) * _attr.kv_cache_size;
+                size_t kv_bytes = sizeof(unsigned short) * input_num_token * _attr.kv_cache_size;
 
-                memcpy((unsigned short *)input_decoder_k_cache.pVirAddr + kv_offset,
-                       (void *)output_k_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_decoder_v_cache.pVirAddr + kv_offset,
-                       (void *)output_v_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_prefill_k_cache.pVirAddr + kv_offset,
-                       (void *)output_k_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_prefill_v_cache.pVirAddr + kv_offset,
-                       (void *)output_v_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
+                memcpy((unsigned short *)input_decoder_k_cache.pVirAddr + kv_offset, (void *)output_k_cache.pVirAddr, kv_bytes);
+                memcpy((unsigned short *)input_decoder_v_cache.pVirAddr + kv_offset, (void *)output_v_cache.pVirAddr, kv_bytes);
+                memcpy((unsigned short *)input_prefill_k_cache.pVirAddr + kv_offset, (void *)output_k_cache.pVirAddr, kv_bytes);
+                memcpy((unsigned short *)input_prefill_v_cache.pVirAddr + kv_offset, (void *)output_v_cache.pVirAddr, kv_bytes);
 
                 auto &output = layer.layer.get_output(prefill_grpid, "output");
-                memcpy(embed_tmp.data(), (void *)output.pVirAddr, embed_tmp.size() * sizeof(unsigned short));
-
-                // ALOGI("%f %f %f %f %f", bfloat16(embed[0]).fp32(), bfloat16(embed[1]).fp32(), bfloat16(embed[2]).fp32(), bfloat16(embed[3]).fp32(), bfloat16(embed[4]).fp32());
+                layer_output = output.pVirAddr;
+            }
+            if (p == (prefill_split_num - 1) && last_embed)
+            {
+                memcpy(last_embed,
+                       (unsigned short *)layer_output + (input_num_token - 1) * _attr.tokens_embed_size,
+                       _attr.tokens_embed_size * sizeof(unsigned short));
             }
         }
 
-        precompute_len = _token_ids.size();
-
-        k_caches.resize(_attr.axmodel_num);
-        v_caches.resize(_attr.axmodel_num);
-        for (int i = 0; i < _attr.axmodel_num; i++)
-        {
-            auto &layer = llama_layers[i];
-            k_caches[i].resize(precompute_len * _attr.kv_cache_size);
-            v_caches[i].resize(precompute_len * _attr.kv_cache_size);
-            auto &input_k_cache = layer.layer.get_input(prefill_grpid, "K_cache");
-            auto &input_v_cache = layer.layer.get_input(prefill_grpid, "V_cache");
-            memcpy((void *)k_caches[i].data(), (void *)input_k_cache.pVirAddr, precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-            memcpy((void *)v_caches[i].data(), (void *)input_v_cache.pVirAddr, precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-        }
-
-        return 0;
+        kv_len = precompute_len + input_embed_num;
+        kv_grp_len[prefill_grpid] = kv_len;
+        return true;
     }
 
-    int GenerateKVCache(std::vector<int> &_token_ids)
+    /**
+     * Reset context to system prompt tokens, K/V rows are restored from KV cache pool if the prompt was computed before,
+     * or prefill and add to pool.
+     * @return tokens number restored from pool, < 0 if failed.
+     */
+    int PrefillPrompt(std::vector<int> &_token_ids)
     {
-        // clear kv cache
-        for (int i = 0; i < _attr.axmodel_num; i++)
-        {
-            memset((void *)llama_layers[i].layer.get_input(decode_grpid, "K_cache").pVirAddr, 0, llama_layers[i].layer.get_input(decode_grpid, "K_cache").nSize);
-            memset((void *)llama_layers[i].layer.get_input(decode_grpid, "V_cache").pVirAddr, 0, llama_layers[i].layer.get_input(decode_grpid, "V_cache").nSize);
-        }
-
-        bfloat16 bf16 = -65536.f;
-        std::vector<unsigned short> mask(_attr.kv_cache_num + 1, bf16.data);
-        mask[_attr.kv_cache_num] = 0;
-        std::vector<unsigned short> embed;
-
-        int next_token = _token_ids[0];
-
-        t_cqdm cqdm = create_cqdm(_token_ids.size(), 32);
+        b_stop = false;
+        kv_len = 0;
+        kv_tokens.clear();
+        std::fill(kv_grp_len.begin(), kv_grp_len.end(), 0);
 
-        for (unsigned int indices = 0; indices < _token_ids.size(); indices++)
+        int input_embed_num = _token_ids.size();
+        int prefill_grpid = SelectPrefillGroup(input_embed_num);
+        if (prefill_grpid < 0)
         {
-            // ALOGI("out %d %d", indices, next_token);
-            embed_selector.getByIndex(next_token, embed);
-
-            for (int m = 0; m < _attr.axmodel_num; m++)
-            {
-                if (b_stop)
-                {
-                    break;
-                }
-
-                auto &layer = llama_layers[m];
-
-                auto &input_k_cache = layer.layer.get_input(decode_grpid, "K_cache");
-                unsigned short *input_k_cache_ptr = (unsigned short *)input_k_cache.pVirAddr;
-                auto &input_v_cache = layer.layer.get_input(decode_grpid, "V_cache");
-                unsigned short *input_v_cache_ptr = (unsigned short *)input_v_cache.pVirAddr;
-
-                auto &input_indices = layer.layer.get_input(decode_grpid, "indices");
-                memcpy(input_indices.pVirAddr, &indices, sizeof(indices));
-
-                auto &input_mask = layer.layer.get_input(decode_grpid, "mask");
-                memcpy(input_mask.pVirAddr, mask.data(), mask.size() * sizeof(unsigned short));
-
-                auto &input_input = layer.layer.get_input(decode_grpid, "input");
-                memcpy(input_input.pVirAddr, embed.data(), embed.size() * sizeof(unsigned short));
-
-                layer.layer.inference(decode_grpid);
-
-                auto &output_k_cache = layer.layer.get_output(decode_grpid, "K_cache_out");
-                memcpy(input_k_cache_ptr + indices * _attr.kv_cache_size, output_k_cache.pVirAddr, sizeof(unsigned short) * _attr.kv_cache_size);
-
-                auto &output_v_cache = layer.layer.get_output(decode_grpid, "V_cache_out");
-                memcpy(input_v_cache_ptr + indices * _attr.kv_cache_size, output_v_cache.pVirAddr, sizeof(unsigned short) * _attr.kv_cache_size);
-
-                auto &output = layer.layer.get_output(decode_grpid, "output");
-                memcpy(embed.data(), output.pVirAddr, embed.size() * sizeof(unsigned short));
-
-                // ALOGI("%f %f %f %f %f", bfloat16(embed[0]).fp32(), bfloat16(embed[1]).fp32(), bfloat16(embed[2]).fp32(), bfloat16(embed[3]).fp32(), bfloat16(embed[4]).fp32());
-            }
-            mask[indices] = 0;
-            next_token = _token_ids[indices + 1];
-            update_cqdm(&cqdm, indices, "token", "");
-            // ALOGI("");
+            ALOGE("system prompt tokens(%d) > prefill_max_token_num(%d)", input_embed_num, _attr.prefill_max_token_num);
+            return -1;
         }
-        return 0;
-    }
 
-    int GetKVCache(std::vector<std::vector<unsigned short>> &k_caches, std::vector<std::vector<unsigned short>> &v_caches, int &precompute_len)
-    {
-        bfloat16 bf16 = -65536.f;
-        std::vector<unsigned short> mask(_attr.kv_cache_num + 1, bf16.data);
-        auto &input_mask = llama_layers[0].layer.get_input(decode_grpid, "mask");
-        memcpy(mask.data(), (void *)input_mask.pVirAddr, input_mask.nSize);
-        for (size_t i = 0; i < mask.size(); i++)
+        std::vector<const LLMKVCachePool::Node *> chain;
+        int cached = kv_pool.Match(_token_ids, input_embed_num, chain);
+        RestoreKVCache(chain, _token_ids, cached);
+        if (cached < input_embed_num)
         {
-            if (mask[i] == bf16.data)
+            SyncPrefillGroup(prefill_grpid);
+            if (!Prefill(_token_ids.data() + cached, input_embed_num - cached, prefill_grpid, nullptr))
             {
-                precompute_len = i + 1;
-                break;
+                return -1;
             }
+            kv_tokens.insert(kv_tokens.end(), _token_ids.begin() + cached, _token_ids.end());
         }
-        ALOGI("precompute_len:%d, remaining:%d", precompute_len, _attr.prefill_max_kv_cache_num_grp[_attr.prefill_max_kv_cache_num_grp.size() - 1] - precompute_len);
-        k_caches.resize(_attr.axmodel_num);
-        v_caches.resize(_attr.axmodel_num);
-        for (int i = 0; i < _attr.axmodel_num; i++)
-        {
-            auto &layer = llama_layers[i];
-            k_caches[i].resize(precompute_len * _attr.kv_cache_size);
-            v_caches[i].resize(precompute_len * _attr.kv_cache_size);
-            auto &input_k_cache = layer.layer.get_input(decode_grpid, "K_cache");
-            auto &input_v_cache = layer.layer.get_input(decode_grpid, "V_cache");
-            memcpy((void *)k_caches[i].data(), (void *)input_k_cache.pVirAddr, precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-            memcpy((void *)v_caches[i].data(), (void *)input_v_cache.pVirAddr, precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-        }
-
-        _attr.prefill_max_token_num = _attr.prefill_max_kv_cache_num_grp[_attr.prefill_max_kv_cache_num_grp.size() - 1];
-
-        return 0;
+        SaveKVCacheToPool(true);
+        ALOGI("system prompt tokens: %d, from kv cache: %d, kv cache pool: %zu KiB", input_embed_num, cached, kv_pool.Bytes() / 1024);
+        return cached;
     }
 
-    int SetKVCache(std::vector<std::vector<unsigned short>> &k_caches, std::vector<std::vector<unsigned short>> &v_caches, int precompute_len, int input_num_token)
+    /**
+     * Prepare K/V caches before Run, leading tokens of tokens_diff are served from KV cache pool if this prompt prefix was computed before.
+     * @param tokens_ids all tokens of conversation.
+     * @param tokens_diff new tokens to input after current context.
+     * @return leading tokens number of tokens_diff restored from pool, Run should skip them, < 0 if context is full.
+     */
+    int PrepareKVCache(const std::vector<int> &tokens_ids, const std::vector<int> &tokens_diff)
     {
-        _attr.precompute_len = precompute_len;
-        for (size_t i = 0; i < _attr.prefill_max_kv_cache_num_grp.size(); i++)
-        {
-            if (_attr.precompute_len + input_num_token <= _attr.prefill_max_kv_cache_num_grp[i])
+        int input_num_token = tokens_diff.size();
+        int cached = 0;
+        // context is exactly the prefix of conversation, the rest can be found in pool, at least one token left to prefill
+        if (kv_len + input_num_token == (int)tokens_ids.size() && input_num_token > 1 &&
+            std::equal(kv_tokens.begin(), kv_tokens.end(), tokens_ids.begin()))
+        {
+            std::vector<const LLMKVCachePool::Node *> chain;
+            int matched = kv_pool.Match(tokens_ids, tokens_ids.size() - 1, chain);
+            if (matched > kv_len)
             {
-                _attr.prefill_grpid = i + 1;
-                break;
+                cached = matched - kv_len;
+                RestoreKVCache(chain, tokens_ids, matched);
             }
         }
-        int kv_cache_num = _attr.prefill_max_kv_cache_num_grp[_attr.prefill_grpid - 1];
-        ALOGI("prefill_grpid:%d kv_cache_num:%d precompute_len:%d input_num_token:%d, prefill_max_token_num: %d", _attr.prefill_grpid, kv_cache_num, precompute_len, input_num_token, _attr.prefill_max_token_num);
+        input_num_token -= cached;
 
-        _attr.prefill_max_token_num = ALIGN_DOWN(_attr.prefill_max_token_num - _attr.precompute_len, _attr.prefill_token_num);
-        ALOGI("current prefill_max_token_num:%d", _attr.prefill_max_token_num);
-
-        if (precompute_len == 0)
+        _attr.precompute_len = kv_len;
+        int prefill_grpid = SelectPrefillGroup(kv_len + input_num_token);
+        int max_kv_cache_num = _attr.prefill_max_kv_cache_num_grp[_attr.prefill_max_kv_cache_num_grp.size() - 1];
+        int prefill_max_token_num = ALIGN_DOWN(max_kv_cache_num - kv_len, _attr.prefill_token_num);
+        ALOGI("prefill_grpid:%d precompute_len:%d input_num_token:%d from kv cache:%d, prefill_max_token_num: %d", prefill_grpid, kv_len, input_num_token, cached, prefill_max_token_num);
+        if (prefill_grpid < 0)
         {
-            ALOGI("first run");
-            return 0;
-        }
-
-        if (precompute_len + input_num_token > kv_cache_num)
-        {
-            ALOGE("precompute_len(%d) + input_num_token(%d) > _attr.prefill_max_kv_cache_num_grp[%d]", precompute_len, input_num_token, _attr.prefill_grpid - 1);
+            ALOGE("precompute_len(%d) + input_num_token(%d) > max kv cache num(%d)", kv_len, input_num_token, max_kv_cache_num);
             return -1;
         }
-
-        if (input_num_token > _attr.prefill_max_token_num)
-        {
-            ALOGE("input_num_token(%d) > _attr.prefill_max_token_num(%d)", input_num_token, _attr.prefill_max_token_num);
-            return -1;
-        }
-
-        if (k_caches.size() != v_caches.size())
+        if (input_num_token > prefill_max_token_num)
         {
-            ALOGE("k_caches.size(%ld) != v_caches.size(%ld)", k_caches.size(), v_caches.size());
+            ALOGE("input_num_token(%d) > prefill_max_token_num(%d)", input_num_token, prefill_max_token_num);
             return -1;
         }
+        _attr.prefill_grpid = prefill_grpid;
+        SyncPrefillGroup(prefill_grpid);
+        prompt_tokens.assign(tokens_diff.begin() + cached, tokens_diff.end());
+        return cached;
+    }
 
-        if (k_caches.size() != (size_t)_attr.axmodel_num)
-        {
-            ALOGE("k_caches.size(%ld) != _attr.axmodel_num(%d)", k_caches.size(), _attr.axmodel_num);
-            return -1;
-        }
-
-        // clear kv cache
-        for (int i = 0; i < _attr.axmodel_num; i++)
-        {
-            memset((void *)llama_layers[i].layer.get_input(_attr.prefill_grpid, "K_cache").pVirAddr, 0, llama_layers[i].layer.get_input(_attr.prefill_grpid, "K_cache").nSize);
-            memset((void *)llama_layers[i].layer.get_input(_attr.prefill_grpid, "V_cache").pVirAddr, 0, llama_layers[i].layer.get_input(_attr.prefill_grpid, "V_cache").nSize);
-
-            memset((void *)llama_layers[i].layer.get_input(decode_grpid, "K_cache").pVirAddr, 0, llama_layers[i].layer.get_input(decode_grpid, "K_cache").nSize);
-            memset((void *)llama_layers[i].layer.get_input(decode_grpid, "V_cache").pVirAddr, 0, llama_layers[i].layer.get_input(decode_grpid, "V_cache").nSize);
-        }
-
-        // int prefill_grpid = llama_layers[0].layer.get_num_input_groups() - 1;
-
-        for (int m = 0; m < _attr.axmodel_num; m++)
+    bool LoadKVCacheSnapshot(const std::string &path)
+    {
+        if (!kv_pool.Load(path))
         {
-            auto &layer = llama_layers[m];
-
-            auto &k_cache = k_caches[m];
-            auto &v_cache = v_caches[m];
-
-            if (k_cache.size() != (size_t)_attr.precompute_len * _attr.kv_cache_size)
-            {
-                ALOGE("k_cache.size(%ld) != precompute_len(%d) * _attr.kv_cache_size(%d)", k_cache.size(), _attr.precompute_len, _attr.kv_cache_size);
-                return -1;
-            }
-            if (v_cache.size() < (size_t)_attr.precompute_len * _attr.kv_cache_size)
-            {
-                ALOGE("v_cache.size(%ld) < precompute_len(%d) * _attr.kv_cache_size(%d)", v_cache.size(), _attr.precompute_len, _attr.kv_cache_size);
-                return -1;
-            }
-
-            // set kv cache inputs
-            {
-                auto &input_k_cache = layer.layer.get_input(_attr.prefill_grpid, "K_cache");
-                unsigned short *input_k_cache_ptr = (unsigned short *)input_k_cache.pVirAddr;
-                auto &input_v_cache = layer.layer.get_input(_attr.prefill_grpid, "V_cache");
-                unsigned short *input_v_cache_ptr = (unsigned short *)input_v_cache.pVirAddr;
-
-                memcpy(input_k_cache_ptr, k_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-                memcpy(input_v_cache_ptr, v_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-                // axcl_Memcpy((void *)input_k_cache_ptr, (void *)k_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short), axclrtMemcpyKind::AXCL_MEMCPY_HOST_TO_DEVICE, layer.layer.get_devid());
-                // axcl_Memcpy((void *)input_v_cache_ptr, (void *)v_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short), axclrtMemcpyKind::AXCL_MEMCPY_HOST_TO_DEVICE, layer.layer.get_devid());
-            }
-
-            {
-                auto &input_k_cache = layer.layer.get_input(decode_grpid, "K_cache");
-                unsigned short *input_k_cache_ptr = (unsigned short *)input_k_cache.pVirAddr;
-                auto &input_v_cache = layer.layer.get_input(decode_grpid, "V_cache");
-                unsigned short *input_v_cache_ptr = (unsigned short *)input_v_cache.pVirAddr;
-
-                memcpy(input_k_cache_ptr, k_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-                memcpy(input_v_cache_ptr, v_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short));
-                // axcl_Memcpy((void *)input_k_cache_ptr, (void *)k_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short), axclrtMemcpyKind::AXCL_MEMCPY_HOST_TO_DEVICE, layer.layer.get_devid());
-                // axcl_Memcpy((void *)input_v_cache_ptr, (void *)v_cache.data(), _attr.precompute_len * _attr.kv_cache_size * sizeof(unsigned short), axclrtMemcpyKind::AXCL_MEMCPY_HOST_TO_DEVICE, layer.layer.get_devid());
-            }
+            return false;
         }
+        ALOGI("load kv cache snapshot %s, %zu KiB", path.c_str(), kv_pool.Bytes() / 1024);
+        return true;
+    }
 
-        return 0;
+    bool SaveKVCacheSnapshot(const std::string &path)
+    {
+        return kv_pool.Save(path);
     }
 
-    int Encode(std::vector<unsigned short> &out_embed, std::string prompt, std::string last_reply, std::vector<int> &tokens_ids, std::vector<int> &tokens_diff)
+    // embeds of tokens are gathered by Run when prefill, no need to get here
+    int Encode(std::string prompt, std::string last_reply, std::vector<int> &tokens_ids, std::vector<int> &tokens_diff)
     {
         if (!tokenizer->Encode(prompt, last_reply, tokens_ids, tokens_diff))
         {
             ALOGE("encode failed");
             return -1;
         }
-
-        out_embed.resize(tokens_diff.size() * _attr.tokens_embed_size);
-
-        for (size_t i = 0; i < tokens_diff.size(); i++)
-        {
-            embed_selector.getByIndex(tokens_diff[i], out_embed.data() + i * _attr.tokens_embed_size);
-        }
-
-        // memcpy(out_embed.data() + 5 * _attr.tokens_embed_size, vpm_resampler.get_output("output").pVirAddr, vpm_resampler.get_output("output").nSize);
-
         return 0;
     }
 
-    std::string Run(std::vector<unsigned short> test_embed)
+    /**
+     * Run prompt and generate reply, call PrepareKVCache first, tokens not restored from KV cache pool are prefilled.
+     */
+    std::string Run()
     {
         b_stop = false;
+        postprocess.begin();
         std::string final_out;
 
         bfloat16 bf16 = -65536.f;
         std::vector<unsigned short> mask(_attr.kv_cache_num + 1, bf16.data);
         std::vector<unsigned short> embed(_attr.tokens_embed_size, 0);
-        int kv_cache_num = _attr.prefill_max_kv_cache_num_grp[_attr.prefill_grpid - 1];
 
         std::vector<int> cached_token;
         std::vector<int> token_ids;
 
-        int input_embed_num = test_embed.size() / _attr.tokens_embed_size;
-        int prefill_split_num = ceil((double)input_embed_num / _attr.prefill_token_num);
-        ALOGI("input token num : %d, prefill_split_num : %d", input_embed_num, prefill_split_num);
+        int input_embed_num = prompt_tokens.size();
 
         mask[_attr.kv_cache_num] = 0;
         for (int i = 0; i < _attr.precompute_len + input_embed_num; i++)
@@ -677,121 +610,13 @@ public:
         float decode_t_all = 0;
         int decode_req_times = 0;
 
-        for (int p = 0; p < prefill_split_num; p++)
+        if (!Prefill(prompt_tokens.data(), input_embed_num, _attr.prefill_grpid, embed.data()))
         {
-            if (b_stop)
-            {
-                break;
-            }
-
-            std::vector<unsigned short> mask_tmp;
-            mask_tmp.resize(1 * _attr.prefill_token_num * (kv_cache_num + _attr.prefill_token_num), bf16.data);
-            int input_num_token = _attr.prefill_token_num;
-            if (p == prefill_split_num - 1)
-            {
-                input_num_token = input_embed_num - p * _attr.prefill_token_num;
-            }
-
-            ALOGI("input_num_token:%d", input_num_token);
-            for (int i = 0; i < _attr.prefill_token_num; i++)
-            {
-                if (i < input_num_token)
-                {
-                    int mask_current_start = kv_cache_num;
-                    auto mask_ptr = mask_tmp.data() + i * (kv_cache_num + _attr.prefill_token_num);
-
-                    for (int j = 0; j < _attr.precompute_len + p * _attr.prefill_token_num; j++)
-                    {
-                        mask_ptr[j] = 0;
-                    }
-
-                    for (int j = mask_current_start; j < mask_current_start + i + 1; j++)
-                    {
-                        mask_ptr[j] = 0;
-                    }
-                }
-            }
-
-            std::vector<unsigned short> embed_tmp(_attr.prefill_token_num * _attr.tokens_embed_size, 0);
-            if (p == (prefill_split_num - 1))
-            {
-                memcpy(embed_tmp.data(), test_embed.data() + p * _attr.prefill_token_num * _attr.tokens_embed_size, (input_embed_num - p * _attr.prefill_token_num) * _attr.tokens_embed_size * sizeof(unsigned short));
-            }
-            else
-            {
-                memcpy(embed_tmp.data(), test_embed.data() + p * _attr.prefill_token_num * _attr.tokens_embed_size, _attr.prefill_token_num * _attr.tokens_embed_size * sizeof(unsigned short));
-            }
-
-            for (int m = 0; m < _attr.axmodel_num; m++)
-            {
-                if (b_stop)
-                {
-                    break;
-                }
-
-                auto &layer = llama_layers[m];
-
-                // set indices
-                auto &input_indices = layer.layer.get_input(_attr.prefill_grpid, "indices");
-                unsigned int *input_indices_ptr = (unsigned int *)input_indices.pVirAddr;
-                memset(input_indices_ptr, 0, input_indices.nSize);
-                int idx = 0;
-                for (int i = _attr.precompute_len + p * _attr.prefill_token_num; i < _attr.precompute_len + (p + 1) * _attr.prefill_token_num; i++)
-                {
-                    input_indices_ptr[idx] = i;
-                    idx++;
-                }
-                // memcpy((void *)input_indices.phyAddr, input_indices_ptr, input_indices.nSize, AXCL_MEMCPY_HOST_TO_DEVICE, layer.layer.get_devid());
-
-                // set mask
-                auto &input_mask = layer.layer.get_input(_attr.prefill_grpid, "mask");
-                memcpy((void *)input_mask.pVirAddr, (void *)mask_tmp.data(), mask_tmp.size() * sizeof(unsigned short));
-
-                // set input
-                auto &input_input = layer.layer.get_input(_attr.prefill_grpid, "input");
-                memcpy((void *)input_input.pVirAddr, embed_tmp.data(), embed_tmp.size() * sizeof(unsigned short));
-
-                layer.layer.inference(_attr.prefill_grpid);
-
-                auto &input_decoder_k_cache = layer.layer.get_input(decode_grpid, "K_cache");
-                auto &input_decoder_v_cache = layer.layer.get_input(decode_grpid, "V_cache");
-
-                auto &input_prefill_k_cache = layer.layer.get_input(_attr.prefill_grpid, "K_cache");
-                auto &input_prefill_v_cache = layer.layer.get_input(_attr.prefill_grpid, "V_cache");
-
-                auto &output_k_cache = layer.layer.get_output(_attr.prefill_grpid, "K_cache_out");
-                auto &output_v_cache = layer.layer.get_output(_attr.prefill_grpid, "V_cache_out");
-
-                int kv_offset = (_attr.precompute_len + p * _attr.prefill_token_num) * _attr.kv_cache_size;
-
-                memcpy((unsigned short *)input_decoder_k_cache.pVirAddr + kv_offset,
-                       (void *)output_k_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_decoder_v_cache.pVirAddr + kv_offset,
-                       (void *)output_v_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_prefill_k_cache.pVirAddr + kv_offset,
-                       (void *)output_k_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                memcpy((unsigned short *)input_prefill_v_cache.pVirAddr + kv_offset,
-                       (void *)output_v_cache.pVirAddr,
-                       sizeof(unsigned short) * _attr.prefill_token_num * _attr.kv_cache_size);
-
-                auto &output = layer.layer.get_output(_attr.prefill_grpid, "output");
-                memcpy(embed_tmp.data(), (void *)output.pVirAddr, embed_tmp.size() * sizeof(unsigned short));
-
-                // ALOGI("%f %f %f %f %f", bfloat16(embed[0]).fp32(), bfloat16(embed[1]).fp32(), bfloat16(embed[2]).fp32(), bfloat16(embed[3]).fp32(), bfloat16(embed[4]).fp32());
-            }
-            if (p == (prefill_split_num - 1))
-            {
-                memcpy(embed.data(),
-                       embed_tmp.data() + (input_embed_num - p * _attr.prefill_token_num - 1) * _attr.tokens_embed_size,
-                       _attr.tokens_embed_size * sizeof(unsigned short));
-            }
+            return final_out;
         }
+        kv_tokens.insert(kv_tokens.end(), prompt_tokens.begin(), prompt_tokens.end());
+        SaveKVCacheToPool(false);
+
 
         int next_token = -1;
         t_cqdm cqdm = create_cqdm(_attr.max_token_len, 32);
@@ -828,8 +653,9 @@ public:
             }
 
             // ALOGI("out %d %d", indices, next_token);
-            embed_selector.getByIndex(next_token, embed);
-            // ALOGI("%f %f %f %f %f", bfloat16(embed[0]).fp32(), bfloat16(embed[1]).fp32(), bfloat16(embed[2]).fp32(), bfloat16(embed[3]).fp32(), bfloat16(embed[4]).fp32());
+            // token embed is copied to input of first layer, output of each layer is copied to input of next layer directly
+            embed_selector.getByIndex(next_token, (unsigned short *)llama_layers[0].layer.get_input(decode_grpid, "input").pVirAddr);
+            void *layer_output = nullptr;
 
             for (int m = 0; m < _attr.axmodel_num; m++)
             {
@@ -853,8 +679,11 @@ public:
                 auto &input_mask = layer.layer.get_input(decode_grpid, "mask");
                 memcpy(input_mask.pVirAddr, mask.data(), mask.size() * sizeof(unsigned short));
 
-                auto &input_input = layer.layer.get_input(decode_grpid, "input");
-                memcpy(input_input.pVirAddr, embed.data(), embed.size() * sizeof(unsigned short));
+                if (layer_output)
+                {
+                    auto &input_input = layer.layer.get_input(decode_grpid, "input");
+                    memcpy(input_input.pVirAddr, layer_output, embed.size() * sizeof(unsigned short));
+                }
 
                 layer.layer.inference(decode_grpid);
 
@@ -868,16 +697,19 @@ public:
 
                 auto &output = layer.layer.get_output(decode_grpid, "output");
                 // AX_SYS_MinvalidateCache(output.phyAddr, output.pVirAddr, output.nSize);
-                memcpy(embed.data(), output.pVirAddr, embed.size() * sizeof(unsigned short));
-
-                // ALOGI("%f %f %f %f %f", bfloat16(embed[0]).fp32(), bfloat16(embed[1]).fp32(), bfloat16(embed[2]).fp32(), bfloat16(embed[3]).fp32(), bfloat16(embed[4]).fp32());
+                layer_output = output.pVirAddr;
+            }
+            if (b_stop)
+            {
+                break;
             }
-            // ALOGI("");
+            kv_len = indices + 1;
+            kv_tokens.push_back(next_token);
             mask[indices] = 0;
             {
                 // post process
                 auto &input = llama_post.get_input("input");
-                memcpy(input.pVirAddr, embed.data(), embed.size() * sizeof(unsigned short));
+                memcpy(input.pVirAddr, layer_output, embed.size() * sizeof(unsigned short));
                 llama_post.inference();
                 int max_index;
 
@@ -3,6 +3,7 @@
  * @license Apache-2.0
  * @author neucrack@sipeed
  * @date 2025-05-21
+ * @update 2026.10.18: Keep KV cache in place and reuse computed prompt prefixes, snapshot system prompt KV cache to disk.
  */
 
 #include "maix_llm_qwen.hpp"
@@ -21,8 +22,7 @@ namespace maix::nn
         maix::middleware::maixcam2::SYS *ax_sys;
         maix::middleware::maixcam2::ENGINE *ax_engine;
         std::string last_reply;
-        std::vector<std::vector<unsigned short>> k_caches, v_caches;
-        int precompute_len = 0;
+        std::string kv_cache_path;  // system prompt KV cache snapshot file
         QwenResp resp;
         Qwen *qwen;
     };
@@ -120,7 +120,14 @@ namespace maix::nn
             attr.axmodel_num = std::stoi(obj->mud.items["extra"]["model_num"]);
             attr.tokens_embed_num = std::stoi(obj->mud.items["extra"]["tokens_embed_num"]);
             attr.tokens_embed_size = std::stoi(obj->mud.items["extra"]["tokens_embed_size"]);
-            attr.b_use_mmap_load_embed = (obj->mud.items["extra"]["use_mmap_load_embed"] == "true" || obj->mud.items["extra"]["use_mmap_load_embed"] == "1") ? true : false;
+            // mmap embed table by default, only disable if set to false explicitly
+            attr.b_use_mmap_load_embed = !(obj->mud.items["extra"]["use_mmap_load_embed"] == "false" || obj->mud.items["extra"]["use_mmap_load_embed"] == "0");
+            // int8 embed table is created next to bf16 table at first load
+            attr.b_int8_embed = obj->mud.items["extra"]["int8_embed"] == "true" || obj->mud.items["extra"]["int8_embed"] == "1";
+            if (obj->mud.items["extra"].find("kv_cache_pool_mb") != obj->mud.items["extra"].end())
+            {
+                attr.kv_cache_pool_mb = std::stoi(obj->mud.items["extra"]["kv_cache_pool_mb"]);
+            }
         }
         catch(...)
         {
@@ -138,6 +145,15 @@ namespace maix::nn
             post_config.top_p = std::stof(obj->mud.items["post_config"]["top_p"]);
             post_config.enable_top_k_sampling = obj->mud.items["post_config"]["enable_top_k_sampling"] == "true" ? true : false;
             post_config.top_k = std::stoi(obj->mud.items["post_config"]["top_k"]);
+            if (obj->mud.items["post_config"].find("enable_min_p_sampling") != obj->mud.items["post_config"].end())
+            {
+                post_config.enable_min_p_sampling = obj->mud.items["post_config"]["enable_min_p_sampling"] == "true" ? true : false;
+                post_config.min_p = std::stof(obj->mud.items["post_config"]["min_p"]);
+            }
+            if (obj->mud.items["post_config"].find("seed") != obj->mud.items["post_config"].end())
+            {
+                post_config.seed = std::stoi(obj->mud.items["post_config"]["seed"]);
+            }
         }
         catch(...)
         {
@@ -159,6 +175,7 @@ namespace maix::nn
         log::print(log::LogLevel::LEVEL_INFO, "\tpost model path: %s\n", obj->mud.items["extra"]["post_model"].c_str());
         log::print(log::LogLevel::LEVEL_INFO, "\ttokens embed path: %s\n", obj->mud.items["extra"]["tokens_embed"].c_str());
         log::print(log::LogLevel::LEVEL_INFO, "\tuse_mmap_load_embed: %s\n", obj->mud.items["extra"]["use_mmap_load_embed"].c_str());
+        log::print(log::LogLevel::LEVEL_INFO, "\tint8_embed: %s\n", attr.b_int8_embed ? "true" : "false");
         log::print(log::LogLevel::LEVEL_INFO, "\tmodel num: %d\n", attr.axmodel_num);
         log::print(log::LogLevel::LEVEL_INFO, "\ttokens embed num: %d\n", attr.tokens_embed_num);
         log::print(log::LogLevel::LEVEL_INFO, "\ttokens embed size: %d\n", attr.tokens_embed_size);
@@ -212,13 +229,17 @@ namespace maix::nn
             return err::ERR_RUNTIME;
         }
 
-        // kvcache
-        std::vector<int> _token_ids;
-        obj->lLaMa.SetSystemPrompt(attr.system_prompt, _token_ids);
-        obj->lLaMa.GenerateKVCachePrefill(_token_ids, obj->k_caches, obj->v_caches, obj->precompute_len);
-        log::info("System prompt tokens size: %d", obj->precompute_len);
-
+        // kvcache, load snapshot so system prompt computed before is not computed again
+        obj->kv_cache_path = fs::splitext(model)[0] + ".kvcache";
+        obj->lLaMa.LoadKVCacheSnapshot(obj->kv_cache_path);
         _loaded = true;
+        e = clear_context();
+        if(e != err::ERR_NONE)
+        {
+            log::error("prefill system prompt failed");
+            unload();
+            return e;
+        }
         return err::ERR_NONE;
     }
 
@@ -273,20 +294,19 @@ namespace maix::nn
         }
 
         // run LLM model
-        std::vector<unsigned short> prompt_data;
         std::vector<int> tokens_ids, tokens_diff;
-        obj->lLaMa.Encode(prompt_data, msg, obj->last_reply, tokens_ids, tokens_diff);
-        if (auto ret = obj->lLaMa.SetKVCache(obj->k_caches, obj->v_caches, obj->precompute_len, tokens_diff.size()); ret != 0)
+        obj->lLaMa.Encode(msg, obj->last_reply, tokens_ids, tokens_diff);
+        int cached = obj->lLaMa.PrepareKVCache(tokens_ids, tokens_diff);
+        if (cached < 0)
         {
             obj->resp.err_code = err::Err::ERR_BUFF_FULL;
             obj->resp.err_msg = "";
             char buf[128];
-            snprintf(buf, sizeof(buf), "SetKVCache failed: %d,the context may be full, try clear context", ret);
+            snprintf(buf, sizeof(buf), "PrepareKVCache failed: %d,the context may be full, try clear context", cached);
             obj->resp.msg = buf;
             return obj->resp;
         }
-        obj->last_reply = obj->lLaMa.Run(prompt_data);
-        obj->lLaMa.GetKVCache(obj->k_caches, obj->v_caches, obj->precompute_len);
+        obj->last_reply = obj->lLaMa.Run();
 
         // obj->resp.msg = obj->last_reply;
         return obj->resp;
@@ -305,10 +325,28 @@ namespace maix::nn
             QwenObj *obj = (QwenObj *)_data;
             std::vector<int> _token_ids;
             obj->lLaMa.SetSystemPrompt(_system_prompt, _token_ids);
-            obj->lLaMa.GenerateKVCachePrefill(_token_ids, obj->k_caches, obj->v_caches, obj->precompute_len);
-            // log::info("precompute_len: %d", obj->precompute_len);
+            int cached = obj->lLaMa.PrefillPrompt(_token_ids);
+            if (cached < 0)
+            {
+                return err::ERR_RUNTIME;
+            }
+            log::info("System prompt tokens size: %d, %d from cache", (int)_token_ids.size(), cached);
+            // new system prompt computed, save snapshot for next start
+            if (cached < (int)_token_ids.size() && !obj->kv_cache_path.empty() && !obj->lLaMa.SaveKVCacheSnapshot(obj->kv_cache_path))
+            {
+                log::warn("save kv cache snapshot to %s failed", obj->kv_cache_path.c_str());
+            }
             return err::ERR_NONE;
         }
         return err::ERR_NOT_OPEN;
     }
+
+    err::Err Qwen::convert_embed_int8(const std::string &bf16_path, int token_num, int embed_size)
+    {
+        if (token_num <= 0 || embed_size <= 0)
+            return err::ERR_ARGS;
+        if (LLaMaEmbedSelector::Int8Table(bf16_path, token_num, embed_size) == bf16_path)
+            return err::ERR_RUNTIME;
+        return err::ERR_NONE;
+    }
 } // namespace maix::nn
@@ -123,7 +123,8 @@
              attr.axmodel_num = std::stoi(obj->mud.items["extra"]["model_num"]);
              attr.tokens_embed_num = std::stoi(obj->mud.items["extra"]["tokens_embed_num"]);
              attr.tokens_embed_size = std::stoi(obj->mud.items["extra"]["tokens_embed_size"]);
-             attr.b_use_mmap_load_embed = (obj->mud.items["extra"]["use_mmap_load_embed"] == "true" || obj->mud.items["extra"]["use_mmap_load_embed"] == "1") ? true : false;
+             // mmap embed table by default, only disable if set to false explicitly
+             attr.b_use_mmap_load_embed = !(obj->mud.items["extra"]["use_mmap_load_embed"] == "false" || obj->mud.items["extra"]["use_mmap_load_embed"] == "0");
              attr.filename_vpm_resampler_axmodedl = fs::join({model_dir, obj->mud.items["extra"]["vpm_resampler_model"]});
              attr.vpm_len = std::stoi(obj->mud.items["extra"]["vpm_len"]);
          }
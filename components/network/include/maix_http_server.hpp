@@ -0,0 +1,333 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add epoll based http server.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+namespace maix::http
+{
+    class ServerImpl;
+
+    /**
+     * Http request, parsed by Server and passed to route handlers.
+     * Header keys are stored in lower case.
+     * @maixcdk maix.http.Request
+     */
+    class Request
+    {
+    public:
+        std::string method;      // GET, POST, ...
+        std::string path;        // url path without query string, percent decoded
+        std::string query;       // raw query string, without '?'
+        std::string version;     // HTTP/1.1 or HTTP/1.0
+        std::map<std::string, std::string> headers;
+        std::string body;
+        std::string remote_addr; // client ip
+
+        /**
+         * Get header value
+         * @param key header key, case insensitive
+         * @param default_value return this value if header not found
+         * @return header value
+         * @maixcdk maix.http.Request.header
+         */
+        std::string header(const std::string &key, const std::string &default_value = "") const;
+
+        /**
+         * Parse query string to key value map, values are percent decoded.
+         * @return query params
+         * @maixcdk maix.http.Request.params
+         */
+        std::map<std::string, std::string> params() const;
+    };
+
+    /**
+     * Stream writer for chunked and multipart responses.
+     * Data passed in is written to socket directly with writev, no copy is made,
+     * so the buffer can be released or reused as soon as write returns.
+     * @maixcdk maix.http.Stream
+     */
+    class Stream
+    {
+    public:
+        Stream(int fd, bool chunked, const std::string &boundary, int timeout_ms);
+
+        /**
+         * Write one chunk(chunked mode) or raw data(multipart mode).
+         * @param data data pointer
+         * @param len data length, 0 will be ignored in chunked mode because it means end of body.
+         * @return err::ERR_NONE if success, err::ERR_IO if client disconnected.
+         * @maixcdk maix.http.Stream.write
+         */
+        err::Err write(const uint8_t *data, size_t len);
+
+        /**
+         * Write Bytes object.
+         * @param data Bytes object, only data_len bytes will be sent.
+         * @return err::ERR_NONE if success, err::ERR_IO if client disconnected.
+         * @maixcdk maix.http.Stream.write
+         */
+        err::Err write(const Bytes *data)
+        {
+            return write(data->data, data->data_len);
+        }
+
+        /**
+         * Write one part of multipart body, boundary and part headers are added automatically.
+         * @param data data pointer
+         * @param len data length
+         * @param content_type part content type, e.g. image/jpeg
+         * @return err::ERR_NONE if success, err::ERR_IO if client disconnected.
+         * @maixcdk maix.http.Stream.write_part
+         */
+        err::Err write_part(const uint8_t *data, size_t len, const std::string &content_type);
+
+        /**
+         * Check whether client is disconnected or write failed
+         * @return true if closed
+         * @maixcdk maix.http.Stream.closed
+         */
+        bool closed() const { return _closed; }
+
+        /**
+         * Send end of body, called by server automatically after provider finished.
+         */
+        err::Err finish();
+
+    private:
+        int _fd;
+        bool _chunked;
+        bool _closed;
+        bool _finished;
+        std::string _boundary;
+        int _timeout_ms;
+    };
+
+    /**
+     * Http response, filled by route handler.
+     * Only one of the set_xxx body setters takes effect, the last one called wins.
+     * @maixcdk maix.http.Response
+     */
+    class Response
+    {
+    public:
+        Response();
+
+        Response(const Response&) = delete;
+        Response& operator=(const Response&) = delete;
+
+        ~Response();
+
+        int status;
+        std::map<std::string, std::string> headers;
+
+        /**
+         * Set response body from string, the string will be copied into response.
+         * @param body body content
+         * @param content_type content type, default text/plain
+         * @maixcdk maix.http.Response.set_content
+         */
+        void set_content(const std::string &body, const std::string &content_type = "text/plain");
+
+        /**
+         * Set response body from string, the string will be moved into response without copy.
+         * @param body body content
+         * @param content_type content type, default text/plain
+         * @maixcdk maix.http.Response.set_content
+         */
+        void set_content(std::string &&body, const std::string &content_type = "text/plain");
+
+        /**
+         * Set response body from Bytes without copy.
+         * @param data Bytes object, must be valid until response sent if take_ownership is false.
+         * @param content_type content type
+         * @param take_ownership if true, data will be deleted by response after sent.
+         * @maixcdk maix.http.Response.set_content
+         */
+        void set_content(Bytes *data, const std::string &content_type, bool take_ownership = false);
+
+        /**
+         * Send file as body with sendfile, file is opened when response is sent.
+         * @param path file path
+         * @param content_type content type, empty means guess from file extension
+         * @maixcdk maix.http.Response.set_file
+         */
+        void set_file(const std::string &path, const std::string &content_type = "");
+
+        /**
+         * Send body with Transfer-Encoding: chunked.
+         * provider will be called repeatedly in worker thread until it returns false or client disconnected,
+         * the worker thread is occupied during the whole stream, @see Server::Server workers.
+         * @param content_type content type
+         * @param provider function to write data to stream, return false to end body
+         * @maixcdk maix.http.Response.set_chunked_provider
+         */
+        void set_chunked_provider(const std::string &content_type, std::function<bool(Stream &)> provider);
+
+        /**
+         * Send body as multipart/x-mixed-replace stream, e.g. MJPEG stream.
+         * Connection will be closed after provider returns false.
+         * Provider runs in worker thread and occupies it until stream ends, e.g. each MJPEG viewer takes one worker,
+         * so set workers of Server larger than max stream clients, or other requests will wait for a free worker.
+         * @param boundary multipart boundary
+         * @param provider function to write parts to stream with Stream::write_part, return false to end body
+         * @maixcdk maix.http.Response.set_multipart_provider
+         */
+        void set_multipart_provider(const std::string &boundary, std::function<bool(Stream &)> provider);
+
+    private:
+        friend class ServerImpl;
+        enum BodyType
+        {
+            BODY_STRING = 0,
+            BODY_BYTES,
+            BODY_FILE,
+            BODY_CHUNKED,
+            BODY_MULTIPART,
+        };
+        BodyType _body_type;
+        std::string _body;
+        Bytes *_bytes;
+        bool _own_bytes;
+        std::string _file_path;
+        std::string _boundary;
+        std::function<bool(Stream &)> _provider;
+        void _release_bytes();
+        void _reset();
+    };
+
+    /**
+     * Route handler, runs in server worker thread.
+     */
+    typedef std::function<void(const Request &, Response &)> Handler;
+
+    /**
+     * Http/1.1 server based on epoll event loop and a worker pool.
+     * Connections are parsed in event loop thread, complete requests are
+     * dispatched to workers, supports keep-alive and pipelined requests.
+     * @maixcdk maix.http.Server
+     */
+    class Server
+    {
+    public:
+        /**
+         * Construct a new server object
+         * @param host bind address, empty means 0.0.0.0
+         * @param port listen port, 0 means pick a free port, get it by port() after start
+         * @param workers worker thread number, chunked and multipart stream responses occupy one worker until stream ends,
+         *                so workers should be larger than max stream clients to keep other routes responsive.
+         * @maixcdk maix.http.Server.Server
+         */
+        Server(const std::string &host = "", int port = 8080, int workers = 4);
+        ~Server();
+
+        /**
+         * Add route
+         * @param method http method, e.g. GET, POST, "*" means any method
+         * @param pattern path pattern, exact match, or prefix match if pattern ends with '*'
+         * @param handler handler function
+         * @maixcdk maix.http.Server.route
+         */
+        void route(const std::string &method, const std::string &pattern, Handler handler);
+
+        /**
+         * Add GET route, @see route
+         * @maixcdk maix.http.Server.get
+         */
+        void get(const std::string &pattern, Handler handler) { route("GET", pattern, handler); }
+
+        /**
+         * Add POST route, @see route
+         * @maixcdk maix.http.Server.post
+         */
+        void post(const std::string &pattern, Handler handler) { route("POST", pattern, handler); }
+
+        /**
+         * Serve static files in dir under url prefix, files are sent with sendfile.
+         * Route handlers are matched first.
+         * @param prefix url prefix, e.g. /static
+         * @param dir local directory
+         * @return err::ERR_NOT_FOUND if dir not exists
+         * @maixcdk maix.http.Server.mount
+         */
+        err::Err mount(const std::string &prefix, const std::string &dir);
+
+        /**
+         * Set keep-alive params, must be called before start
+         * @param timeout_ms idle connection will be closed after timeout_ms, 0 means disable keep-alive
+         * @param max_requests max requests per connection
+         * @maixcdk maix.http.Server.set_keep_alive
+         */
+        void set_keep_alive(int timeout_ms, int max_requests = 1000);
+
+        /**
+         * Set max request body size, request with larger body will get 413.
+         * @param size max body size in bytes, default 8MB
+         * @maixcdk maix.http.Server.set_max_body_size
+         */
+        void set_max_body_size(size_t size);
+
+        /**
+         * Start server, event loop and workers run in background threads.
+         * @return err::ERR_NONE if success
+         * @maixcdk maix.http.Server.start
+         */
+        err::Err start();
+
+        /**
+         * Stop server, close all connections and wait threads exit.
+         * @return err::ERR_NONE if success
+         * @maixcdk maix.http.Server.stop
+         */
+        err::Err stop();
+
+        /**
+         * Is server running
+         * @maixcdk maix.http.Server.is_running
+         */
+        bool is_running();
+
+        /**
+         * Get listen port, if construct with port 0, return the actual port after start.
+         * @maixcdk maix.http.Server.port
+         */
+        int port() { return _port; }
+
+        /**
+         * Get host
+         * @maixcdk maix.http.Server.host
+         */
+        std::string host() { return _host; }
+
+    private:
+        std::string _host;
+        int _port;
+        int _workers;
+        ServerImpl *_impl;
+    };
+
+    /**
+     * Guess content type from file name extension
+     * @param path file path
+     * @return content type, application/octet-stream if unknown
+     * @maixcdk maix.http.guess_content_type
+     */
+    std::string guess_content_type(const std::string &path);
+
+    /**
+     * Percent decode url string, '+' is decoded to space if plus_as_space is true.
+     * @maixcdk maix.http.url_decode
+     */
+    std::string url_decode(const std::string &s, bool plus_as_space = false);
+
+} // namespace maix::http
@@ -0,0 +1,163 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add async MQTT client.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace maix::network::mqtt
+{
+    /**
+     * MQTT client config
+     * @maixcdk maix.network.mqtt.Config
+     */
+    class Config
+    {
+    public:
+        std::string host = "127.0.0.1";
+        int port = 1883;
+        std::string client_id;          // empty means generate from time
+        std::string username;
+        std::string password;
+        int keep_alive_s = 60;          // keep alive interval, PINGREQ is sent if idle
+        bool clean_session = true;
+        int connect_timeout_ms = 5000;
+        int reconnect_min_ms = 500;     // reconnect backoff, doubled every failure until reconnect_max_ms
+        int reconnect_max_ms = 30000;
+
+        int queue_max = 1024;           // max messages in memory publish queue
+        size_t queue_max_bytes = 1024 * 1024; // max payload bytes in memory publish queue
+        int inflight_max = 32;          // max QoS1 messages sent but not acked
+        size_t batch_max_bytes = 16 * 1024;   // max bytes written to socket in one syscall
+        bool coalesce = false;          // QoS0 message replaces the queued not sent QoS0 message of the same topic
+
+        std::string spool_path;         // file to persist QoS1 messages when queue full or offline, empty to disable
+        size_t spool_max_bytes = 16 * 1024 * 1024;
+    };
+
+    /**
+     * MQTT client statistics
+     * @maixcdk maix.network.mqtt.Stats
+     */
+    class Stats
+    {
+    public:
+        uint64_t published = 0;   // messages written to socket
+        uint64_t acked = 0;       // QoS1 messages acked by broker
+        uint64_t received = 0;    // messages received from subscriptions
+        uint64_t coalesced = 0;   // messages replaced by newer message of same topic
+        uint64_t dropped = 0;     // messages dropped because queue full
+        uint64_t spooled = 0;     // messages written to spool file
+        uint64_t reconnects = 0;
+        uint64_t batches = 0;     // socket writes
+        int queue_len = 0;
+        int inflight = 0;
+        size_t spool_bytes = 0;   // not yet replayed bytes in spool file
+    };
+
+    /**
+     * Subscription message callback, called in client event loop thread, should return quickly.
+     */
+    typedef std::function<void(const std::string &topic, const std::string &payload)> MessageCallback;
+
+    /**
+     * Asynchronous MQTT 3.1.1 client.
+     * publish() only puts message into a bounded queue, an event loop thread
+     * connects, batches queued messages into one socket write, keeps QoS1 messages
+     * inflight until PUBACK and reconnects automatically.
+     * @maixcdk maix.network.mqtt.Client
+     */
+    class Client
+    {
+    public:
+        /**
+         * Construct a new client object, call start() to connect.
+         * @param config client config
+         * @maixcdk maix.network.mqtt.Client.Client
+         */
+        Client(const mqtt::Config &config);
+        ~Client();
+
+        /**
+         * Start event loop thread, connect to broker in background.
+         * If spool file exists, not sent messages in it will be sent after connected.
+         * @return err::ERR_NONE if loop started
+         * @maixcdk maix.network.mqtt.Client.start
+         */
+        err::Err start();
+
+        /**
+         * Stop event loop and disconnect, not acked QoS1 messages are saved to spool file if enabled.
+         * @maixcdk maix.network.mqtt.Client.stop
+         */
+        void stop();
+
+        /**
+         * Publish message, non-blocking.
+         * @param topic topic
+         * @param data payload
+         * @param len payload length
+         * @param qos 0 or 1
+         * @param retain retain flag
+         * @return err::ERR_NONE if queued or spooled, err::ERR_BUFF_FULL if dropped, err::ERR_ARGS if args invalid.
+         * @maixcdk maix.network.mqtt.Client.publish
+         */
+        err::Err publish(const std::string &topic, const uint8_t *data, size_t len, int qos = 0, bool retain = false);
+
+        /**
+         * Publish message, non-blocking. @see publish
+         * @maixcdk maix.network.mqtt.Client.publish
+         */
+        err::Err publish(const std::string &topic, const std::string &payload, int qos = 0, bool retain = false)
+        {
+            return publish(topic, (const uint8_t *)payload.data(), payload.size(), qos, retain);
+        }
+
+        /**
+         * Subscribe topic, subscriptions are restored automatically after reconnect.
+         * @param topic topic filter, support + and # wildcards
+         * @param qos max qos, 0 or 1
+         * @param callback message callback
+         * @return err::ERR_NONE if success
+         * @maixcdk maix.network.mqtt.Client.subscribe
+         */
+        err::Err subscribe(const std::string &topic, int qos, MessageCallback callback);
+
+        /**
+         * Wait until all queued and inflight messages are sent and acked.
+         * @param timeout_ms timeout, -1 means wait forever
+         * @return err::ERR_NONE if all sent, err::ERR_TIMEOUT if timeout
+         * @maixcdk maix.network.mqtt.Client.flush
+         */
+        err::Err flush(int timeout_ms = -1);
+
+        /**
+         * Is connected to broker(CONNACK received)
+         * @maixcdk maix.network.mqtt.Client.is_connected
+         */
+        bool is_connected();
+
+        /**
+         * Get statistics
+         * @maixcdk maix.network.mqtt.Client.stats
+         */
+        mqtt::Stats stats();
+
+    private:
+        void *_priv;
+    };
+
+    /**
+     * Check if topic matches topic filter with + and # wildcards
+     * @maixcdk maix.network.mqtt.topic_match
+     */
+    bool topic_match(const std::string &filter, const std::string &topic);
+
+} // namespace maix::network::mqtt
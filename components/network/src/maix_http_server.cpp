@@ -0,0 +1,1109 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add epoll based http server.
+ */
+
+#include "maix_http_server.hpp"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
+#include <algorithm>
+
+namespace maix::http
+{
+    #define MAX_HEADER_SIZE     (16 * 1024)
+    #define READ_BUFF_SIZE      (16 * 1024)
+    #define SEND_TIMEOUT_MS     10000
+    #define FIRST_REQUEST_TIMEOUT_MS 10000
+
+    static err::Err _send_iov(int fd, struct iovec *iov, int iovcnt, int timeout_ms)
+    {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        while (iovcnt > 0)
+        {
+            // skip empty iov
+            if (iov->iov_len == 0)
+            {
+                ++iov;
+                --iovcnt;
+                continue;
+            }
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iovcnt;
+            ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return err::ERR_IO;
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                int ret = poll(&pfd, 1, timeout_ms);
+                if (ret == 0)
+                    return err::ERR_TIMEOUT;
+                if (ret < 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
+                    return err::ERR_IO;
+                continue;
+            }
+            // advance iov
+            size_t left = (size_t)n;
+            while (iovcnt > 0 && left >= iov->iov_len)
+            {
+                left -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            if (iovcnt > 0 && left > 0)
+            {
+                iov->iov_base = (uint8_t *)iov->iov_base + left;
+                iov->iov_len -= left;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    static err::Err _send_file(int fd, int file_fd, off_t size, int timeout_ms)
+    {
+        off_t offset = 0;
+        while (offset < size)
+        {
+            ssize_t n = sendfile(fd, file_fd, &offset, size - offset);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return err::ERR_IO;
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                int ret = poll(&pfd, 1, timeout_ms);
+                if (ret == 0)
+                    return err::ERR_TIMEOUT;
+                if (ret < 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)))
+                    return err::ERR_IO;
+            }
+            else if (n == 0)
+            {
+                // file truncated while sending
+                return err::ERR_IO;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
+    static const char *_status_text(int status)
+    {
+        switch (status)
+        {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 411: return "Length Required";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+        }
+    }
+
+    static std::string _to_lower(const std::string &s)
+    {
+        std::string res = s;
+        std::transform(res.begin(), res.end(), res.begin(), [](unsigned char c) { return std::tolower(c); });
+        return res;
+    }
+
+    static std::string _trim(const std::string &s)
+    {
+        size_t start = s.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            return "";
+        size_t end = s.find_last_not_of(" \t\r");
+        return s.substr(start, end - start + 1);
+    }
+
+    static uint64_t _now_ms()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    std::string guess_content_type(const std::string &path)
+    {
+        static const std::map<std::string, std::string> types = {
+            {"html", "text/html"},
+            {"htm", "text/html"},
+            {"css", "text/css"},
+            {"js", "application/javascript"},
+            {"mjs", "application/javascript"},
+            {"json", "application/json"},
+            {"txt", "text/plain"},
+            {"xml", "application/xml"},
+            {"svg", "image/svg+xml"},
+            {"png", "image/png"},
+            {"jpg", "image/jpeg"},
+            {"jpeg", "image/jpeg"},
+            {"gif", "image/gif"},
+            {"bmp", "image/bmp"},
+            {"ico", "image/x-icon"},
+            {"webp", "image/webp"},
+            {"mp4", "video/mp4"},
+            {"wav", "audio/wav"},
+            {"mp3", "audio/mpeg"},
+            {"wasm", "application/wasm"},
+            {"woff", "font/woff"},
+            {"woff2", "font/woff2"},
+            {"ttf", "font/ttf"},
+            {"pdf", "application/pdf"},
+            {"zip", "application/zip"},
+        };
+        size_t pos = path.rfind('.');
+        if (pos == std::string::npos || path.find('/', pos) != std::string::npos)
+            return "application/octet-stream";
+        auto it = types.find(_to_lower(path.substr(pos + 1)));
+        if (it == types.end())
+            return "application/octet-stream";
+        return it->second;
+    }
+
+    std::string url_decode(const std::string &s, bool plus_as_space)
+    {
+        std::string res;
+        res.reserve(s.size());
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            char c = s[i];
+            if (c == '%' && i + 2 < s.size() && isxdigit((unsigned char)s[i + 1]) && isxdigit((unsigned char)s[i + 2]))
+            {
+                char hex[3] = {s[i + 1], s[i + 2], 0};
+                res.push_back((char)strtol(hex, NULL, 16));
+                i += 2;
+            }
+            else if (c == '+' && plus_as_space)
+                res.push_back(' ');
+            else
+                res.push_back(c);
+        }
+        return res;
+    }
+
+    /*************************** Request ***************************/
+
+    std::string Request::header(const std::string &key, const std::string &default_value) const
+    {
+        auto it = headers.find(_to_lower(key));
+        if (it == headers.end())
+            return default_value;
+        return it->second;
+    }
+
+    std::map<std::string, std::string> Request::params() const
+    {
+        std::map<std::string, std::string> res;
+        size_t start = 0;
+        while (start < query.size())
+        {
+            size_t end = query.find('&', start);
+            if (end == std::string::npos)
+                end = query.size();
+            std::string kv = query.substr(start, end - start);
+            if (!kv.empty())
+            {
+                size_t eq = kv.find('=');
+                if (eq == std::string::npos)
+                    res[url_decode(kv, true)] = "";
+                else
+                    res[url_decode(kv.substr(0, eq), true)] = url_decode(kv.substr(eq + 1), true);
+            }
+            start = end + 1;
+        }
+        return res;
+    }
+
+    /*************************** Stream ***************************/
+
+    Stream::Stream(int fd, bool chunked, const std::string &boundary, int timeout_ms)
+        : _fd(fd), _chunked(chunked), _closed(false), _finished(false), _boundary(boundary), _timeout_ms(timeout_ms)
+    {
+    }
+
+    err::Err Stream::write(const uint8_t *data, size_t len)
+    {
+        if (_closed || _finished)
+            return err::ERR_IO;
+        if (len == 0)
+            return err::ERR_NONE;
+        err::Err e;
+        if (_chunked)
+        {
+            char size_line[32];
+            int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", len);
+            struct iovec iov[3] = {
+                {size_line, (size_t)n},
+                {(void *)data, len},
+                {(void *)"\r\n", 2},
+            };
+            e = _send_iov(_fd, iov, 3, _timeout_ms);
+        }
+        else
+        {
+            struct iovec iov = {(void *)data, len};
+            e = _send_iov(_fd, &iov, 1, _timeout_ms);
+        }
+        if (e != err::ERR_NONE)
+            _closed = true;
+        return e;
+    }
+
+    err::Err Stream::write_part(const uint8_t *data, size_t len, const std::string &content_type)
+    {
+        if (_closed || _finished)
+            return err::ERR_IO;
+        char part_header[256];
+        int n = snprintf(part_header, sizeof(part_header),
+                         "--%s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+                         _boundary.c_str(), content_type.c_str(), len);
+        if (n < 0 || n >= (int)sizeof(part_header))
+            return err::ERR_ARGS;
+        struct iovec iov[3] = {
+            {part_header, (size_t)n},
+            {(void *)data, len},
+            {(void *)"\r\n", 2},
+        };
+        err::Err e;
+        if (_chunked)
+        {
+            // multipart inside chunked encoding, one chunk per part
+            char size_line[32];
+            int sn = snprintf(size_line, sizeof(size_line), "%zx\r\n", n + len + 2);
+            struct iovec iov2[5] = {
+                {size_line, (size_t)sn},
+                iov[0], iov[1], iov[2],
+                {(void *)"\r\n", 2},
+            };
+            e = _send_iov(_fd, iov2, 5, _timeout_ms);
+        }
+        else
+            e = _send_iov(_fd, iov, 3, _timeout_ms);
+        if (e != err::ERR_NONE)
+            _closed = true;
+        return e;
+    }
+
+    err::Err Stream::finish()
+    {
+        if (_finished)
+            return err::ERR_NONE;
+        _finished = true;
+        if (_closed || !_chunked)
+            return _closed ? err::ERR_IO : err::ERR_NONE;
+        struct iovec iov = {(void *)"0\r\n\r\n", 5};
+        err::Err e = _send_iov(_fd, &iov, 1, _timeout_ms);
+        if (e != err::ERR_NONE)
+            _closed = true;
+        return e;
+    }
+
+    /*************************** Response ***************************/
+
+    Response::Response()
+        : status(200), _body_type(BODY_STRING), _bytes(nullptr), _own_bytes(false)
+    {
+    }
+
+    Response::~Response()
+    {
+        _release_bytes();
+    }
+
+    void Response::_release_bytes()
+    {
+        if (_bytes && _own_bytes)
+            delete _bytes;
+        _bytes = nullptr;
+        _own_bytes = false;
+    }
+
+    void Response::_reset()
+    {
+        _release_bytes();
+        status = 200;
+        headers.clear();
+        _body_type = BODY_STRING;
+        _body.clear();
+        _file_path.clear();
+        _boundary.clear();
+        _provider = nullptr;
+    }
+
+    void Response::set_content(const std::string &body, const std::string &content_type)
+    {
+        _release_bytes();
+        _body_type = BODY_STRING;
+        _body = body;
+        headers["Content-Type"] = content_type;
+    }
+
+    void Response::set_content(std::string &&body, const std::string &content_type)
+    {
+        _release_bytes();
+        _body_type = BODY_STRING;
+        _body = std::move(body);
+        headers["Content-Type"] = content_type;
+    }
+
+    void Response::set_content(Bytes *data, const std::string &content_type, bool take_ownership)
+    {
+        _release_bytes();
+        _body_type = BODY_BYTES;
+        _body.clear();
+        _bytes = data;
+        _own_bytes = take_ownership;
+        headers["Content-Type"] = content_type;
+    }
+
+    void Response::set_file(const std::string &path, const std::string &content_type)
+    {
+        _release_bytes();
+        _body_type = BODY_FILE;
+        _body.clear();
+        _file_path = path;
+        headers["Content-Type"] = content_type.empty() ? guess_content_type(path) : content_type;
+    }
+
+    void Response::set_chunked_provider(const std::string &content_type, std::function<bool(Stream &)> provider)
+    {
+        _release_bytes();
+        _body_type = BODY_CHUNKED;
+        _body.clear();
+        _provider = provider;
+        headers["Content-Type"] = content_type;
+    }
+
+    void Response::set_multipart_provider(const std::string &boundary, std::function<bool(Stream &)> provider)
+    {
+        _release_bytes();
+        _body_type = BODY_MULTIPART;
+        _body.clear();
+        _boundary = boundary;
+        _provider = provider;
+        headers["Content-Type"] = "multipart/x-mixed-replace; boundary=" + boundary;
+    }
+
+    /*************************** Server ***************************/
+
+    struct Connection
+    {
+        int fd;
+        std::string remote_addr;
+        std::string rbuf;
+        std::deque<Request> pending;  // parsed requests, processed by worker in order
+        int error_status;             // parse error, send this status and close
+        int requests;
+        uint64_t last_active_ms;
+        bool busy;                    // owned by worker, removed from epoll by EPOLLONESHOT
+    };
+
+    struct Route
+    {
+        std::string method;
+        std::string pattern;
+        bool prefix;
+        Handler handler;
+    };
+
+    enum
+    {
+        PARSE_AGAIN = 0,
+        PARSE_OK = 1,
+    };
+
+    class ServerImpl
+    {
+    public:
+        std::string host;
+        int port;
+        int workers_num;
+        int keep_alive_ms;
+        int max_requests;
+        size_t max_body_size;
+
+        std::vector<Route> routes;
+        std::vector<std::pair<std::string, std::string>> mounts;
+
+        int listen_fd;
+        int epoll_fd;
+        int event_fd;
+        std::atomic<bool> running;
+        std::thread loop_thread;
+        std::vector<std::thread> worker_threads;
+
+        std::mutex conns_lock;
+        std::unordered_map<int, std::shared_ptr<Connection>> conns;
+
+        std::mutex tasks_lock;
+        std::condition_variable tasks_cond;
+        std::deque<std::shared_ptr<Connection>> tasks;
+
+        ServerImpl()
+            : port(0), workers_num(4), keep_alive_ms(5000), max_requests(1000), max_body_size(8 * 1024 * 1024),
+              listen_fd(-1), epoll_fd(-1), event_fd(-1), running(false)
+        {
+        }
+
+        err::Err start()
+        {
+            listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (listen_fd < 0)
+            {
+                log::error("http server create socket failed: %s", strerror(errno));
+                return err::ERR_IO;
+            }
+            int opt = 1;
+            setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (host.empty() || host == "0.0.0.0")
+                addr.sin_addr.s_addr = INADDR_ANY;
+            else if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+            {
+                log::error("http server invalid host: %s", host.c_str());
+                _close_fds();
+                return err::ERR_ARGS;
+            }
+            if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 128) < 0)
+            {
+                log::error("http server bind %s:%d failed: %s", host.c_str(), port, strerror(errno));
+                _close_fds();
+                return err::ERR_IO;
+            }
+            socklen_t len = sizeof(addr);
+            getsockname(listen_fd, (struct sockaddr *)&addr, &len);
+            port = ntohs(addr.sin_port);
+
+            epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epoll_fd < 0 || event_fd < 0)
+            {
+                log::error("http server create epoll failed: %s", strerror(errno));
+                _close_fds();
+                return err::ERR_IO;
+            }
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.fd = listen_fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+            ev.data.fd = event_fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, event_fd, &ev);
+
+            running = true;
+            for (int i = 0; i < workers_num; ++i)
+                worker_threads.emplace_back(&ServerImpl::worker, this);
+            loop_thread = std::thread(&ServerImpl::loop, this);
+            return err::ERR_NONE;
+        }
+
+        void stop()
+        {
+            if (!running)
+                return;
+            running = false;
+            uint64_t one = 1;
+            if (::write(event_fd, &one, sizeof(one)) < 0)
+                log::warn("http server wake up loop failed");
+            if (loop_thread.joinable())
+                loop_thread.join();
+            {
+                // break workers blocked in send or stream provider
+                std::lock_guard<std::mutex> lock(conns_lock);
+                for (auto &it : conns)
+                    shutdown(it.first, SHUT_RDWR);
+            }
+            tasks_cond.notify_all();
+            for (auto &t : worker_threads)
+            {
+                if (t.joinable())
+                    t.join();
+            }
+            worker_threads.clear();
+            tasks.clear();
+            {
+                std::lock_guard<std::mutex> lock(conns_lock);
+                for (auto &it : conns)
+                    close(it.first);
+                conns.clear();
+            }
+            _close_fds();
+        }
+
+    private:
+        void _close_fds()
+        {
+            if (listen_fd >= 0)
+                close(listen_fd);
+            if (epoll_fd >= 0)
+                close(epoll_fd);
+            if (event_fd >= 0)
+                close(event_fd);
+            listen_fd = epoll_fd = event_fd = -1;
+        }
+
+        void _arm(int fd, int op)
+        {
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.fd = fd;
+            epoll_ctl(epoll_fd, op, fd, &ev);
+        }
+
+        // must hold conns_lock
+        void _close_conn_locked(int fd)
+        {
+            conns.erase(fd);
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+            close(fd);
+        }
+
+        void _close_conn(int fd)
+        {
+            std::lock_guard<std::mutex> lock(conns_lock);
+            _close_conn_locked(fd);
+        }
+
+        void _sweep_idle(uint64_t now)
+        {
+            std::lock_guard<std::mutex> lock(conns_lock);
+            for (auto it = conns.begin(); it != conns.end();)
+            {
+                Connection &c = *it->second;
+                uint64_t timeout = c.requests == 0 ? FIRST_REQUEST_TIMEOUT_MS : (uint64_t)keep_alive_ms;
+                if (!c.busy && now - c.last_active_ms > timeout)
+                {
+                    int fd = it->first;
+                    it = conns.erase(it);
+                    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+                    close(fd);
+                }
+                else
+                    ++it;
+            }
+        }
+
+        void _on_accept()
+        {
+            while (1)
+            {
+                struct sockaddr_in addr;
+                socklen_t len = sizeof(addr);
+                int fd = accept4(listen_fd, (struct sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        log::warn("http server accept failed: %s", strerror(errno));
+                    break;
+                }
+                int opt = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+                auto c = std::make_shared<Connection>();
+                c->fd = fd;
+                char ip[INET_ADDRSTRLEN] = {0};
+                inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+                c->remote_addr = ip;
+                c->error_status = 0;
+                c->requests = 0;
+                c->last_active_ms = _now_ms();
+                c->busy = false;
+                {
+                    std::lock_guard<std::mutex> lock(conns_lock);
+                    conns[fd] = c;
+                }
+                _arm(fd, EPOLL_CTL_ADD);
+            }
+        }
+
+        /**
+         * Parse one request from c.rbuf head.
+         * @return PARSE_AGAIN if need more data, PARSE_OK if req is filled, or http error status
+         */
+        int _parse(Connection &c, Request &req)
+        {
+            size_t header_end = c.rbuf.find("\r\n\r\n");
+            if (header_end == std::string::npos)
+                return c.rbuf.size() > MAX_HEADER_SIZE ? 431 : PARSE_AGAIN;
+            if (header_end > MAX_HEADER_SIZE)
+                return 431;
+            size_t line_end = c.rbuf.find("\r\n");
+            std::string line = c.rbuf.substr(0, line_end);
+            size_t sp1 = line.find(' ');
+            size_t sp2 = line.rfind(' ');
+            if (sp1 == std::string::npos || sp2 == sp1)
+                return 400;
+            req.method = line.substr(0, sp1);
+            std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+            req.version = line.substr(sp2 + 1);
+            if (req.version != "HTTP/1.1" && req.version != "HTTP/1.0")
+                return 400;
+            size_t q = target.find('?');
+            if (q != std::string::npos)
+            {
+                req.query = target.substr(q + 1);
+                target = target.substr(0, q);
+            }
+            req.path = url_decode(target);
+            req.remote_addr = c.remote_addr;
+
+            size_t pos = line_end + 2;
+            while (pos < header_end)
+            {
+                size_t end = c.rbuf.find("\r\n", pos);
+                std::string h = c.rbuf.substr(pos, end - pos);
+                pos = end + 2;
+                size_t colon = h.find(':');
+                if (colon == std::string::npos)
+                    return 400;
+                req.headers[_to_lower(_trim(h.substr(0, colon)))] = _trim(h.substr(colon + 1));
+            }
+            if (req.headers.count("transfer-encoding"))
+                return 501; // chunked request body not supported
+            size_t body_len = 0;
+            auto it = req.headers.find("content-length");
+            if (it != req.headers.end())
+            {
+                char *end = NULL;
+                unsigned long long v = strtoull(it->second.c_str(), &end, 10);
+                if (end == it->second.c_str() || *end != '\0')
+                    return 400;
+                if (v > max_body_size)
+                    return 413;
+                body_len = (size_t)v;
+            }
+            size_t total = header_end + 4 + body_len;
+            if (c.rbuf.size() < total)
+                return PARSE_AGAIN;
+            req.body.assign(c.rbuf, header_end + 4, body_len);
+            c.rbuf.erase(0, total);
+            return PARSE_OK;
+        }
+
+        void _on_readable(int fd)
+        {
+            std::shared_ptr<Connection> c;
+            {
+                std::lock_guard<std::mutex> lock(conns_lock);
+                auto it = conns.find(fd);
+                if (it == conns.end() || it->second->busy)
+                    return;
+                c = it->second;
+            }
+            char buf[READ_BUFF_SIZE];
+            bool eof = false;
+            while (1)
+            {
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n > 0)
+                {
+                    c->rbuf.append(buf, n);
+                    if (c->rbuf.size() > MAX_HEADER_SIZE + max_body_size)
+                        break;
+                    continue;
+                }
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                    eof = true;
+                break;
+            }
+            while (c->error_status == 0)
+            {
+                Request req;
+                int ret = _parse(*c, req);
+                if (ret == PARSE_AGAIN)
+                    break;
+                if (ret == PARSE_OK)
+                    c->pending.emplace_back(std::move(req));
+                else
+                    c->error_status = ret;
+            }
+            if (c->pending.empty() && c->error_status == 0)
+            {
+                if (eof)
+                    _close_conn(fd);
+                else
+                {
+                    c->last_active_ms = _now_ms();
+                    _arm(fd, EPOLL_CTL_MOD);
+                }
+                return;
+            }
+            // client half closed after sending requests, still reply then close
+            if (eof)
+                _mark_close(*c);
+            {
+                std::lock_guard<std::mutex> lock(conns_lock);
+                c->busy = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(tasks_lock);
+                tasks.push_back(c);
+            }
+            tasks_cond.notify_one();
+        }
+
+        static void _mark_close(Connection &c)
+        {
+            for (auto &r : c.pending)
+                r.headers["connection"] = "close";
+        }
+
+        void loop()
+        {
+            struct epoll_event events[64];
+            uint64_t last_sweep = _now_ms();
+            while (running)
+            {
+                uint64_t now = _now_ms();
+                if (now - last_sweep >= 1000)
+                {
+                    _sweep_idle(now);
+                    last_sweep = now;
+                }
+                int n = epoll_wait(epoll_fd, events, 64, 1000);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    log::error("http server epoll_wait failed: %s", strerror(errno));
+                    break;
+                }
+                for (int i = 0; i < n; ++i)
+                {
+                    int fd = events[i].data.fd;
+                    if (fd == event_fd)
+                    {
+                        uint64_t v;
+                        if (read(event_fd, &v, sizeof(v)) < 0)
+                            continue;
+                    }
+                    else if (fd == listen_fd)
+                        _on_accept();
+                    else
+                        _on_readable(fd);
+                }
+            }
+        }
+
+        void worker()
+        {
+            while (running)
+            {
+                std::shared_ptr<Connection> c;
+                {
+                    std::unique_lock<std::mutex> lock(tasks_lock);
+                    tasks_cond.wait(lock, [this] { return !running || !tasks.empty(); });
+                    if (!running)
+                        return;
+                    c = tasks.front();
+                    tasks.pop_front();
+                }
+                _serve(c);
+            }
+        }
+
+        bool _keep_alive(const Request &req, Connection &c)
+        {
+            if (keep_alive_ms <= 0 || c.requests >= max_requests || !running)
+                return false;
+            std::string conn = _to_lower(req.header("connection"));
+            if (req.version == "HTTP/1.0")
+                return conn == "keep-alive";
+            return conn != "close";
+        }
+
+        void _serve(std::shared_ptr<Connection> c)
+        {
+            bool keep = true;
+            while (keep && !c->pending.empty())
+            {
+                Request req = std::move(c->pending.front());
+                c->pending.pop_front();
+                c->requests++;
+                keep = _keep_alive(req, *c);
+                Response res;
+                _dispatch(req, res);
+                if (_send_response(*c, req, res, keep) != err::ERR_NONE)
+                    keep = false;
+            }
+            if (keep && c->error_status != 0)
+            {
+                Request req;
+                Response res;
+                res.status = c->error_status;
+                res.set_content(std::string(_status_text(c->error_status)) + "\n");
+                keep = false;
+                _send_response(*c, req, res, keep);
+            }
+            std::lock_guard<std::mutex> lock(conns_lock);
+            if (!keep)
+            {
+                _close_conn_locked(c->fd);
+                return;
+            }
+            c->pending.clear();
+            c->busy = false;
+            c->last_active_ms = _now_ms();
+            _arm(c->fd, EPOLL_CTL_MOD);
+        }
+
+        bool _match(const Route &r, const Request &req)
+        {
+            if (r.method != "*" && r.method != req.method && !(r.method == "GET" && req.method == "HEAD"))
+                return false;
+            if (r.prefix)
+                return req.path.compare(0, r.pattern.size(), r.pattern) == 0;
+            return req.path == r.pattern;
+        }
+
+        void _dispatch(const Request &req, Response &res)
+        {
+            for (auto &r : routes)
+            {
+                if (!_match(r, req))
+                    continue;
+                try
+                {
+                    r.handler(req, res);
+                }
+                catch (const std::exception &e)
+                {
+                    log::error("http handler %s %s exception: %s", req.method.c_str(), req.path.c_str(), e.what());
+                    // release bytes owned by handler's response before reuse
+                    res._reset();
+                    res.status = 500;
+                    res.set_content("Internal Server Error\n");
+                }
+                return;
+            }
+            if (req.method == "GET" || req.method == "HEAD")
+            {
+                for (auto &m : mounts)
+                {
+                    // prefix must end at a path segment boundary, "/static" not match "/staticfoo"
+                    if (req.path.compare(0, m.first.size(), m.first) != 0 ||
+                        (req.path.size() > m.first.size() && req.path[m.first.size()] != '/'))
+                        continue;
+                    std::string rel = req.path.substr(m.first.size());
+                    if (rel.find("..") != std::string::npos)
+                    {
+                        res.status = 403;
+                        res.set_content("Forbidden\n");
+                        return;
+                    }
+                    if (rel.empty() || rel.back() == '/')
+                        rel += "index.html";
+                    if (rel[0] != '/')
+                        rel = "/" + rel;
+                    std::string path = m.second + rel;
+                    struct stat st;
+                    if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+                    {
+                        res.set_file(path);
+                        return;
+                    }
+                }
+            }
+            res.status = 404;
+            res.set_content("Not Found\n");
+        }
+
+        std::string _build_header(const Response &res, bool keep, const std::string &length_or_encoding)
+        {
+            std::string header;
+            header.reserve(256);
+            header += "HTTP/1.1 ";
+            header += std::to_string(res.status);
+            header += " ";
+            header += _status_text(res.status);
+            header += "\r\n";
+            for (auto &h : res.headers)
+            {
+                header += h.first;
+                header += ": ";
+                header += h.second;
+                header += "\r\n";
+            }
+            header += length_or_encoding;
+            header += keep ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+            return header;
+        }
+
+        err::Err _send_response(Connection &c, const Request &req, Response &res, bool &keep)
+        {
+            bool head = req.method == "HEAD";
+            switch (res._body_type)
+            {
+            case Response::BODY_STRING:
+            case Response::BODY_BYTES:
+            {
+                const uint8_t *data = (const uint8_t *)res._body.data();
+                size_t len = res._body.size();
+                if (res._body_type == Response::BODY_BYTES)
+                {
+                    data = res._bytes ? res._bytes->data : nullptr;
+                    len = res._bytes ? res._bytes->data_len : 0;
+                }
+                std::string header = _build_header(res, keep, "Content-Length: " + std::to_string(len) + "\r\n");
+                struct iovec iov[2] = {
+                    {(void *)header.data(), header.size()},
+                    {(void *)data, head ? 0 : len},
+                };
+                return _send_iov(c.fd, iov, 2, SEND_TIMEOUT_MS);
+            }
+            case Response::BODY_FILE:
+            {
+                int file_fd = open(res._file_path.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat st;
+                if (file_fd < 0 || fstat(file_fd, &st) != 0)
+                {
+                    if (file_fd >= 0)
+                        close(file_fd);
+                    res.status = 404;
+                    res.set_content("Not Found\n");
+                    return _send_response(c, req, res, keep);
+                }
+                std::string header = _build_header(res, keep, "Content-Length: " + std::to_string(st.st_size) + "\r\n");
+                struct iovec iov = {(void *)header.data(), header.size()};
+                err::Err e = _send_iov(c.fd, &iov, 1, SEND_TIMEOUT_MS);
+                if (e == err::ERR_NONE && !head)
+                    e = _send_file(c.fd, file_fd, st.st_size, SEND_TIMEOUT_MS);
+                close(file_fd);
+                return e;
+            }
+            case Response::BODY_CHUNKED:
+            case Response::BODY_MULTIPART:
+            {
+                bool chunked = res._body_type == Response::BODY_CHUNKED;
+                if (!chunked)
+                    keep = false;
+                std::string header = _build_header(res, keep, chunked ? "Transfer-Encoding: chunked\r\n" : "Cache-Control: no-cache\r\n");
+                struct iovec iov = {(void *)header.data(), header.size()};
+                err::Err e = _send_iov(c.fd, &iov, 1, SEND_TIMEOUT_MS);
+                if (e != err::ERR_NONE || head)
+                    return e;
+                Stream stream(c.fd, chunked, res._boundary, SEND_TIMEOUT_MS);
+                while (running && !stream.closed() && res._provider && res._provider(stream))
+                    ;
+                return stream.finish();
+            }
+            default:
+                break;
+            }
+            return err::ERR_ARGS;
+        }
+    };
+
+    Server::Server(const std::string &host, int port, int workers)
+        : _host(host), _port(port), _workers(workers > 0 ? workers : 1)
+    {
+        _impl = new ServerImpl();
+        _impl->host = host;
+        _impl->port = port;
+        _impl->workers_num = _workers;
+    }
+
+    Server::~Server()
+    {
+        stop();
+        delete _impl;
+    }
+
+    void Server::route(const std::string &method, const std::string &pattern, Handler handler)
+    {
+        Route r;
+        r.method = method;
+        r.prefix = !pattern.empty() && pattern.back() == '*';
+        r.pattern = r.prefix ? pattern.substr(0, pattern.size() - 1) : pattern;
+        r.handler = handler;
+        _impl->routes.push_back(r);
+    }
+
+    err::Err Server::mount(const std::string &prefix, const std::string &dir)
+    {
+        if (!fs::isdir(dir))
+            return err::ERR_NOT_FOUND;
+        std::string p = prefix;
+        if (!p.empty() && p.back() == '/')
+            p.pop_back();
+        std::string d = dir;
+        if (!d.empty() && d.back() == '/')
+            d.pop_back();
+        _impl->mounts.emplace_back(p, d);
+        return err::ERR_NONE;
+    }
+
+    void Server::set_keep_alive(int timeout_ms, int max_requests)
+    {
+        _impl->keep_alive_ms = timeout_ms;
+        _impl->max_requests = max_requests;
+    }
+
+    void Server::set_max_body_size(size_t size)
+    {
+        _impl->max_body_size = size;
+    }
+
+    err::Err Server::start()
+    {
+        if (_impl->running)
+            return err::ERR_BUSY;
+        err::Err e = _impl->start();
+        if (e == err::ERR_NONE)
+            _port = _impl->port;
+        return e;
+    }
+
+    err::Err Server::stop()
+    {
+        _impl->stop();
+        return err::ERR_NONE;
+    }
+
+    bool Server::is_running()
+    {
+        return _impl->running;
+    }
+} // namespace maix::http
@@ -0,0 +1,911 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add async MQTT client.
+ */
+
+#include "maix_mqtt_client.hpp"
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+
+namespace maix::network::mqtt
+{
+    enum PacketType
+    {
+        PKT_CONNECT = 1,
+        PKT_CONNACK = 2,
+        PKT_PUBLISH = 3,
+        PKT_PUBACK = 4,
+        PKT_SUBSCRIBE = 8,
+        PKT_SUBACK = 9,
+        PKT_PINGREQ = 12,
+        PKT_PINGRESP = 13,
+        PKT_DISCONNECT = 14,
+    };
+
+    enum State
+    {
+        STATE_DISCONNECTED = 0,
+        STATE_CONNECTING,   // tcp connected, wait CONNACK
+        STATE_CONNECTED,
+    };
+
+    struct Message
+    {
+        std::string topic;
+        std::string payload;
+        uint8_t qos;
+        bool retain;
+        uint16_t id;
+    };
+
+    struct OutMessage
+    {
+        uint64_t end;   // stream offset after last byte of packet
+        bool requeue;   // QoS0 message, put back to queue if not sent
+        Message msg;
+    };
+
+    struct Subscription
+    {
+        std::string filter;
+        int qos;
+        MessageCallback callback;
+    };
+
+#pragma pack(push, 1)
+    struct SpoolRecordHeader
+    {
+        uint8_t flags;        // bit0: retain
+        uint16_t topic_len;
+        uint32_t payload_len;
+    };
+#pragma pack(pop)
+
+    static void _put_u16(std::string &out, uint16_t v)
+    {
+        out.push_back((char)(v >> 8));
+        out.push_back((char)(v & 0xff));
+    }
+
+    static void _put_str(std::string &out, const std::string &s)
+    {
+        _put_u16(out, (uint16_t)s.size());
+        out.append(s);
+    }
+
+    static void _put_header(std::string &out, uint8_t first_byte, size_t remaining)
+    {
+        out.push_back((char)first_byte);
+        do
+        {
+            uint8_t b = remaining % 128;
+            remaining /= 128;
+            if (remaining > 0)
+                b |= 0x80;
+            out.push_back((char)b);
+        } while (remaining > 0);
+    }
+
+    static void _put_publish(std::string &out, const Message &msg, bool dup)
+    {
+        size_t remaining = 2 + msg.topic.size() + (msg.qos ? 2 : 0) + msg.payload.size();
+        _put_header(out, (PKT_PUBLISH << 4) | (dup ? 0x08 : 0) | (msg.qos << 1) | (msg.retain ? 1 : 0), remaining);
+        _put_str(out, msg.topic);
+        if (msg.qos)
+            _put_u16(out, msg.id);
+        out.append(msg.payload);
+    }
+
+    bool topic_match(const std::string &filter, const std::string &topic)
+    {
+        size_t f = 0, t = 0;
+        while (f < filter.size())
+        {
+            if (filter[f] == '#')
+                return true;
+            size_t f_end = filter.find('/', f);
+            if (f_end == std::string::npos)
+                f_end = filter.size();
+            if (t > topic.size())
+                return false;
+            size_t t_end = topic.find('/', t);
+            if (t_end == std::string::npos)
+                t_end = topic.size();
+            if (!(f_end - f == 1 && filter[f] == '+') &&
+                filter.compare(f, f_end - f, topic, t, t_end - t) != 0)
+                return false;
+            f = f_end + 1;
+            t = t_end + 1;
+            // filter ends with "/#" also matches parent level
+            if (f < filter.size() && filter[f] == '#' && t > topic.size())
+                return true;
+        }
+        return t > topic.size() && f > filter.size();
+    }
+
+    class ClientPriv
+    {
+    public:
+        Config cfg;
+
+        std::mutex lock;
+        std::condition_variable flush_cond;
+        std::deque<Message> queue;
+        size_t queue_bytes;
+        std::unordered_map<std::string, Message *> coalesce_index;
+        std::map<uint16_t, Message> inflight;
+        uint16_t next_id;
+        std::vector<Subscription> subs;
+        bool subs_dirty;
+        bool out_empty;
+        Stats stats;
+        State state;
+
+        int spool_fd;
+        size_t spool_size;
+        size_t spool_offset;  // records before offset already moved to queue
+
+        std::atomic<bool> running;
+        std::thread thread;
+        int wake_fd;
+        int sock;
+        std::string out;
+        uint64_t out_pos;                 // stream offset of out[0]
+        std::deque<OutMessage> out_msgs;  // publish packets in out, counted as published when fully sent
+        std::string in;
+        uint64_t connect_start_ms;
+        uint64_t last_send_ms;
+        uint64_t ping_sent_ms;
+        uint64_t next_connect_ms;
+        int backoff_ms;
+        bool ever_connected;
+
+        ClientPriv(const Config &config)
+            : cfg(config), queue_bytes(0), next_id(1), subs_dirty(false), out_empty(true), state(STATE_DISCONNECTED),
+              spool_fd(-1), spool_size(0), spool_offset(0), running(false), wake_fd(-1), sock(-1), out_pos(0),
+              connect_start_ms(0), last_send_ms(0), ping_sent_ms(0), next_connect_ms(0), backoff_ms(config.reconnect_min_ms),
+              ever_connected(false)
+        {
+            if (cfg.client_id.empty())
+                cfg.client_id = "maix_" + std::to_string(time::ticks_us());
+            if (cfg.inflight_max < 1)
+                cfg.inflight_max = 1;
+            if (cfg.inflight_max > 65535)
+                cfg.inflight_max = 65535;
+        }
+
+        /************************ spool, must hold lock ************************/
+
+        bool _spool_open()
+        {
+            if (cfg.spool_path.empty())
+                return true;
+            spool_fd = open(cfg.spool_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (spool_fd < 0)
+            {
+                log::error("mqtt open spool %s failed: %s", cfg.spool_path.c_str(), strerror(errno));
+                return false;
+            }
+            struct stat st;
+            fstat(spool_fd, &st);
+            spool_size = st.st_size;
+            spool_offset = 0;
+            stats.spool_bytes = spool_size;
+            return true;
+        }
+
+        bool _spool_pending()
+        {
+            return spool_fd >= 0 && spool_offset < spool_size;
+        }
+
+        bool _spool_append(const Message &msg)
+        {
+            size_t rec_size = sizeof(SpoolRecordHeader) + msg.topic.size() + msg.payload.size();
+            if (spool_fd < 0 || spool_size - spool_offset + rec_size > cfg.spool_max_bytes)
+                return false;
+            SpoolRecordHeader h;
+            h.flags = msg.retain ? 1 : 0;
+            h.topic_len = (uint16_t)msg.topic.size();
+            h.payload_len = (uint32_t)msg.payload.size();
+            struct iovec iov[3] = {
+                {&h, sizeof(h)},
+                {(void *)msg.topic.data(), msg.topic.size()},
+                {(void *)msg.payload.data(), msg.payload.size()},
+            };
+            ssize_t n = writev(spool_fd, iov, 3);
+            if (n != (ssize_t)rec_size)
+            {
+                log::error("mqtt write spool failed: %s", strerror(errno));
+                // drop partial record
+                if (ftruncate(spool_fd, spool_size) != 0)
+                    log::error("mqtt truncate spool failed");
+                return false;
+            }
+            spool_size += rec_size;
+            stats.spooled++;
+            stats.spool_bytes = spool_size - spool_offset;
+            return true;
+        }
+
+        bool _spool_read(size_t &offset, Message &msg)
+        {
+            SpoolRecordHeader h;
+            if (pread(spool_fd, &h, sizeof(h), offset) != (ssize_t)sizeof(h))
+                return false;
+            msg.topic.resize(h.topic_len);
+            msg.payload.resize(h.payload_len);
+            if (h.topic_len && pread(spool_fd, &msg.topic[0], h.topic_len, offset + sizeof(h)) != h.topic_len)
+                return false;
+            if (h.payload_len && pread(spool_fd, &msg.payload[0], h.payload_len, offset + sizeof(h) + h.topic_len) != (ssize_t)h.payload_len)
+                return false;
+            msg.qos = 1;
+            msg.retain = h.flags & 1;
+            msg.id = 0;
+            offset += sizeof(h) + h.topic_len + h.payload_len;
+            return true;
+        }
+
+        // move spooled messages to memory queue while queue has space
+        void _spool_load()
+        {
+            if (!_spool_pending())
+                return;
+            while (spool_offset < spool_size && (int)queue.size() < cfg.queue_max && queue_bytes < cfg.queue_max_bytes)
+            {
+                Message msg;
+                if (!_spool_read(spool_offset, msg))
+                {
+                    log::error("mqtt spool file corrupted, discard %zu bytes", spool_size - spool_offset);
+                    spool_offset = spool_size;
+                    break;
+                }
+                queue_bytes += msg.payload.size();
+                queue.emplace_back(std::move(msg));
+            }
+            if (spool_offset >= spool_size)
+            {
+                if (ftruncate(spool_fd, 0) != 0)
+                    log::error("mqtt truncate spool failed");
+                spool_size = spool_offset = 0;
+            }
+            stats.spool_bytes = spool_size - spool_offset;
+        }
+
+        // save not acked messages to spool before exit, keep order: inflight, queue, remaining spool
+        void _spool_save()
+        {
+            if (spool_fd < 0)
+                return;
+            std::vector<Message> rest;
+            size_t offset = spool_offset;
+            while (offset < spool_size)
+            {
+                Message msg;
+                if (!_spool_read(offset, msg))
+                    break;
+                rest.emplace_back(std::move(msg));
+            }
+            if (ftruncate(spool_fd, 0) != 0)
+                log::error("mqtt truncate spool failed");
+            spool_size = spool_offset = 0;
+            for (auto &it : inflight)
+                _spool_append(it.second);
+            for (auto &msg : queue)
+            {
+                if (msg.qos)
+                    _spool_append(msg);
+            }
+            for (auto &msg : rest)
+                _spool_append(msg);
+            inflight.clear();
+            queue.clear();
+            coalesce_index.clear();
+            queue_bytes = 0;
+            close(spool_fd);
+            spool_fd = -1;
+        }
+
+        /************************ queue ************************/
+
+        err::Err publish(const std::string &topic, const uint8_t *data, size_t len, int qos, bool retain)
+        {
+            if (topic.empty() || topic.size() > 65535 || (qos != 0 && qos != 1))
+                return err::ERR_ARGS;
+            bool wake = false;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (qos == 0 && cfg.coalesce)
+                {
+                    auto it = coalesce_index.find(topic);
+                    if (it != coalesce_index.end())
+                    {
+                        Message *msg = it->second;
+                        queue_bytes = queue_bytes - msg->payload.size() + len;
+                        msg->payload.assign((const char *)data, len);
+                        msg->retain = retain;
+                        stats.coalesced++;
+                        return err::ERR_NONE;
+                    }
+                }
+                Message msg;
+                msg.topic = topic;
+                msg.payload.assign((const char *)data, len);
+                msg.qos = qos;
+                msg.retain = retain;
+                msg.id = 0;
+                bool full = (int)queue.size() >= cfg.queue_max || queue_bytes + len > cfg.queue_max_bytes;
+                // keep order, once spool is used, later QoS1 messages go to spool too
+                if (qos == 1 && (full || _spool_pending()))
+                {
+                    if (_spool_append(msg))
+                        return err::ERR_NONE;
+                }
+                if (full || (qos == 1 && _spool_pending()))
+                {
+                    stats.dropped++;
+                    return err::ERR_BUFF_FULL;
+                }
+                wake = queue.empty();
+                queue_bytes += len;
+                queue.emplace_back(std::move(msg));
+                if (qos == 0 && cfg.coalesce)
+                    coalesce_index[topic] = &queue.back();
+            }
+            if (wake)
+                _wake();
+            return err::ERR_NONE;
+        }
+
+        void _wake()
+        {
+            uint64_t one = 1;
+            if (write(wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+                log::warn("mqtt wake loop failed");
+        }
+
+        // serialize queued messages to out buffer, must hold lock
+        void _fill_out()
+        {
+            _spool_load();
+            while (out.size() < cfg.batch_max_bytes && !queue.empty())
+            {
+                Message &front = queue.front();
+                if (front.qos == 1 && (int)inflight.size() >= cfg.inflight_max)
+                    break;
+                auto it = coalesce_index.find(front.topic);
+                if (it != coalesce_index.end() && it->second == &front)
+                    coalesce_index.erase(it);
+                Message msg = std::move(front);
+                queue.pop_front();
+                queue_bytes -= msg.payload.size();
+                if (msg.qos == 1)
+                {
+                    do
+                    {
+                        msg.id = next_id++;
+                        if (next_id == 0)
+                            next_id = 1;
+                    } while (inflight.count(msg.id));
+                    _put_publish(out, msg, false);
+                    out_msgs.push_back({out_pos + out.size(), false, Message()});
+                    inflight.emplace(msg.id, std::move(msg));
+                }
+                else
+                {
+                    // keep QoS0 message until sent, requeue it if disconnected before that
+                    _put_publish(out, msg, false);
+                    out_msgs.push_back({out_pos + out.size(), true, std::move(msg)});
+                }
+                if (queue.empty())
+                    _spool_load();
+            }
+        }
+
+        /************************ connection ************************/
+
+        void _disconnect(uint64_t now)
+        {
+            if (sock >= 0)
+                close(sock);
+            sock = -1;
+            out.clear();
+            out_pos = 0;
+            in.clear();
+            std::lock_guard<std::mutex> guard(lock);
+            // not fully sent QoS0 messages go back to queue front in order, QoS1 messages are resent from inflight
+            for (auto it = out_msgs.rbegin(); it != out_msgs.rend(); ++it)
+            {
+                if (!it->requeue)
+                    continue;
+                queue_bytes += it->msg.payload.size();
+                queue.emplace_front(std::move(it->msg));
+            }
+            out_msgs.clear();
+            if (state == STATE_CONNECTED)
+                log::warn("mqtt disconnected from %s:%d", cfg.host.c_str(), cfg.port);
+            state = STATE_DISCONNECTED;
+            next_connect_ms = now + backoff_ms;
+            backoff_ms = std::min(backoff_ms * 2, cfg.reconnect_max_ms);
+        }
+
+        int _tcp_connect()
+        {
+            struct addrinfo hints, *res = NULL;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            if (getaddrinfo(cfg.host.c_str(), std::to_string(cfg.port).c_str(), &hints, &res) != 0 || !res)
+                return -1;
+            int fd = socket(res->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+            {
+                freeaddrinfo(res);
+                return -1;
+            }
+            int ret = connect(fd, res->ai_addr, res->ai_addrlen);
+            freeaddrinfo(res);
+            if (ret < 0 && errno != EINPROGRESS)
+            {
+                close(fd);
+                return -1;
+            }
+            if (ret < 0)
+            {
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                int so_err = 0;
+                socklen_t len = sizeof(so_err);
+                if (poll(&pfd, 1, cfg.connect_timeout_ms) <= 0 ||
+                    getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_err, &len) < 0 || so_err != 0)
+                {
+                    close(fd);
+                    return -1;
+                }
+            }
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            return fd;
+        }
+
+        void _connect(uint64_t now)
+        {
+            sock = _tcp_connect();
+            if (sock < 0)
+            {
+                log::debug("mqtt connect %s:%d failed", cfg.host.c_str(), cfg.port);
+                _disconnect(now);
+                return;
+            }
+            std::string payload;
+            _put_str(payload, cfg.client_id);
+            uint8_t flags = cfg.clean_session ? 0x02 : 0;
+            if (!cfg.username.empty())
+            {
+                flags |= 0x80;
+                _put_str(payload, cfg.username);
+                if (!cfg.password.empty())
+                {
+                    flags |= 0x40;
+                    _put_str(payload, cfg.password);
+                }
+            }
+            _put_header(out, PKT_CONNECT << 4, 10 + payload.size());
+            _put_str(out, "MQTT");
+            out.push_back(4); // protocol level 3.1.1
+            out.push_back((char)flags);
+            _put_u16(out, (uint16_t)cfg.keep_alive_s);
+            out.append(payload);
+            std::lock_guard<std::mutex> guard(lock);
+            state = STATE_CONNECTING;
+            connect_start_ms = now;
+        }
+
+        void _on_connack(uint8_t rc, uint64_t now)
+        {
+            if (rc != 0)
+            {
+                log::error("mqtt connect refused, code: %d", rc);
+                _disconnect(now);
+                return;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            state = STATE_CONNECTED;
+            backoff_ms = cfg.reconnect_min_ms;
+            if (ever_connected)
+                stats.reconnects++;
+            ever_connected = true;
+            ping_sent_ms = 0;
+            // resend not acked messages
+            for (auto &it : inflight)
+                _put_publish(out, it.second, true);
+            subs_dirty = !subs.empty();
+            log::info("mqtt connected to %s:%d", cfg.host.c_str(), cfg.port);
+        }
+
+        void _put_subscribe()
+        {
+            // must hold lock
+            std::string body;
+            _put_u16(body, next_id++);
+            if (next_id == 0)
+                next_id = 1;
+            for (auto &s : subs)
+            {
+                _put_str(body, s.filter);
+                body.push_back((char)s.qos);
+            }
+            _put_header(out, (PKT_SUBSCRIBE << 4) | 0x02, body.size());
+            out.append(body);
+            subs_dirty = false;
+        }
+
+        void _on_publish(uint8_t flags, const uint8_t *p, size_t len)
+        {
+            if (len < 2)
+                return;
+            uint16_t topic_len = (p[0] << 8) | p[1];
+            if ((size_t)topic_len + 2 > len)
+                return;
+            std::string topic((const char *)p + 2, topic_len);
+            size_t pos = 2 + topic_len;
+            uint8_t qos = (flags >> 1) & 0x03;
+            if (qos > 0)
+            {
+                if (pos + 2 > len)
+                    return;
+                uint16_t id = (p[pos] << 8) | p[pos + 1];
+                pos += 2;
+                _put_header(out, PKT_PUBACK << 4, 2);
+                _put_u16(out, id);
+            }
+            std::string payload((const char *)p + pos, len - pos);
+            std::vector<MessageCallback> callbacks;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stats.received++;
+                for (auto &s : subs)
+                {
+                    if (topic_match(s.filter, topic))
+                        callbacks.push_back(s.callback);
+                }
+            }
+            for (auto &cb : callbacks)
+                cb(topic, payload);
+        }
+
+        // parse received packets, return false if protocol error
+        bool _on_recv(uint64_t now)
+        {
+            size_t pos = 0;
+            while (in.size() - pos >= 2)
+            {
+                const uint8_t *p = (const uint8_t *)in.data() + pos;
+                size_t avail = in.size() - pos;
+                size_t remaining = 0, i = 1;
+                int shift = 0;
+                bool complete = false;
+                while (i < avail && i <= 4)
+                {
+                    remaining |= (size_t)(p[i] & 0x7f) << shift;
+                    shift += 7;
+                    if (!(p[i++] & 0x80))
+                    {
+                        complete = true;
+                        break;
+                    }
+                }
+                if (!complete)
+                {
+                    if (i > 4)
+                        return false;
+                    break;
+                }
+                if (avail < i + remaining)
+                    break;
+                uint8_t type = p[0] >> 4;
+                const uint8_t *body = p + i;
+                switch (type)
+                {
+                case PKT_CONNACK:
+                    if (remaining < 2)
+                        return false;
+                    _on_connack(body[1], now);
+                    if (sock < 0)
+                        return true;
+                    break;
+                case PKT_PUBACK:
+                {
+                    if (remaining < 2)
+                        return false;
+                    uint16_t id = (body[0] << 8) | body[1];
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (inflight.erase(id))
+                        stats.acked++;
+                    break;
+                }
+                case PKT_PUBLISH:
+                    _on_publish(p[0] & 0x0f, body, remaining);
+                    break;
+                case PKT_PINGRESP:
+                    ping_sent_ms = 0;
+                    break;
+                case PKT_SUBACK:
+                    break;
+                default:
+                    log::warn("mqtt unsupported packet type %d", type);
+                    break;
+                }
+                pos += i + remaining;
+            }
+            in.erase(0, pos);
+            return true;
+        }
+
+        bool _done()
+        {
+            return queue.empty() && inflight.empty() && !_spool_pending() && out_empty;
+        }
+
+        void loop()
+        {
+            char buf[4096];
+            while (running)
+            {
+                uint64_t now = time::ticks_ms();
+                State st;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    st = state;
+                }
+                if (st == STATE_DISCONNECTED && now >= next_connect_ms)
+                {
+                    _connect(now);
+                    st = state;
+                }
+                else if (st == STATE_CONNECTING && now - connect_start_ms > (uint64_t)cfg.connect_timeout_ms)
+                {
+                    log::warn("mqtt wait CONNACK timeout");
+                    _disconnect(now);
+                    st = STATE_DISCONNECTED;
+                }
+                else if (st == STATE_CONNECTED)
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    if (subs_dirty)
+                        _put_subscribe();
+                    _fill_out();
+                    if (out.empty() && cfg.keep_alive_s > 0)
+                    {
+                        uint64_t interval = cfg.keep_alive_s * 1000ULL;
+                        if (ping_sent_ms && now - ping_sent_ms > interval)
+                        {
+                            log::warn("mqtt ping timeout");
+                            // unlock before disconnect
+                            ping_sent_ms = 0;
+                            st = STATE_DISCONNECTED;
+                        }
+                        else if (!ping_sent_ms && now - last_send_ms >= interval)
+                        {
+                            _put_header(out, PKT_PINGREQ << 4, 0);
+                            ping_sent_ms = now;
+                        }
+                    }
+                }
+                if (st == STATE_DISCONNECTED && sock >= 0)
+                    _disconnect(now);
+
+                if (sock >= 0 && !out.empty())
+                {
+                    ssize_t n = send(sock, out.data(), out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                    if (n > 0)
+                    {
+                        out.erase(0, n);
+                        out_pos += n;
+                        last_send_ms = now;
+                        std::lock_guard<std::mutex> guard(lock);
+                        stats.batches++;
+                        while (!out_msgs.empty() && out_msgs.front().end <= out_pos)
+                        {
+                            stats.published++;
+                            out_msgs.pop_front();
+                        }
+                    }
+                    else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                        _disconnect(now);
+                }
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    out_empty = out.empty();
+                    if (_done())
+                        flush_cond.notify_all();
+                }
+
+                struct pollfd pfds[2];
+                int nfds = 1;
+                pfds[0] = {wake_fd, POLLIN, 0};
+                if (sock >= 0)
+                {
+                    pfds[1] = {sock, (short)(POLLIN | (out.empty() ? 0 : POLLOUT)), 0};
+                    nfds = 2;
+                }
+                int timeout = 100;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    // more to send as soon as socket writable
+                    if (state == STATE_CONNECTED && out.empty() && !queue.empty() && (queue.front().qos == 0 || (int)inflight.size() < cfg.inflight_max))
+                        timeout = 0;
+                }
+                int ret = poll(pfds, nfds, timeout);
+                if (ret < 0 && errno != EINTR)
+                {
+                    log::error("mqtt poll failed: %s", strerror(errno));
+                    break;
+                }
+                if (ret <= 0)
+                    continue;
+                if (pfds[0].revents & POLLIN)
+                {
+                    uint64_t v;
+                    if (read(wake_fd, &v, sizeof(v)) < 0)
+                        continue;
+                }
+                if (nfds == 2 && (pfds[1].revents & (POLLIN | POLLERR | POLLHUP)))
+                {
+                    ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+                    if (n > 0)
+                    {
+                        in.append(buf, n);
+                        if (!_on_recv(time::ticks_ms()))
+                        {
+                            log::error("mqtt protocol error");
+                            _disconnect(time::ticks_ms());
+                        }
+                    }
+                    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                        _disconnect(time::ticks_ms());
+                }
+            }
+        }
+
+        err::Err start()
+        {
+            if (running)
+                return err::ERR_BUSY;
+            wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (wake_fd < 0)
+                return err::ERR_IO;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!_spool_open())
+                {
+                    close(wake_fd);
+                    wake_fd = -1;
+                    return err::ERR_IO;
+                }
+            }
+            running = true;
+            next_connect_ms = 0;
+            thread = std::thread(&ClientPriv::loop, this);
+            return err::ERR_NONE;
+        }
+
+        void stop()
+        {
+            if (!running)
+                return;
+            running = false;
+            _wake();
+            if (thread.joinable())
+                thread.join();
+            if (sock >= 0)
+            {
+                std::string disconnect;
+                _put_header(disconnect, PKT_DISCONNECT << 4, 0);
+                if (send(sock, disconnect.data(), disconnect.size(), MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+                    log::debug("mqtt send disconnect failed");
+                close(sock);
+                sock = -1;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            state = STATE_DISCONNECTED;
+            _spool_save();
+            close(wake_fd);
+            wake_fd = -1;
+            flush_cond.notify_all();
+        }
+    };
+
+    Client::Client(const mqtt::Config &config)
+    {
+        _priv = new ClientPriv(config);
+    }
+
+    Client::~Client()
+    {
+        stop();
+        delete (ClientPriv *)_priv;
+    }
+
+    err::Err Client::start()
+    {
+        return ((ClientPriv *)_priv)->start();
+    }
+
+    void Client::stop()
+    {
+        ((ClientPriv *)_priv)->stop();
+    }
+
+    err::Err Client::publish(const std::string &topic, const uint8_t *data, size_t len, int qos, bool retain)
+    {
+        return ((ClientPriv *)_priv)->publish(topic, data, len, qos, retain);
+    }
+
+    err::Err Client::subscribe(const std::string &topic, int qos, MessageCallback callback)
+    {
+        ClientPriv *priv = (ClientPriv *)_priv;
+        if (topic.empty() || qos < 0 || qos > 1 || !callback)
+            return err::ERR_ARGS;
+        {
+            std::lock_guard<std::mutex> guard(priv->lock);
+            Subscription s;
+            s.filter = topic;
+            s.qos = qos;
+            s.callback = callback;
+            priv->subs.push_back(s);
+            if (priv->state == STATE_CONNECTED)
+                priv->subs_dirty = true;
+        }
+        if (priv->running)
+            priv->_wake();
+        return err::ERR_NONE;
+    }
+
+    err::Err Client::flush(int timeout_ms)
+    {
+        ClientPriv *priv = (ClientPriv *)_priv;
+        std::unique_lock<std::mutex> guard(priv->lock);
+        auto done = [priv] { return !priv->running || priv->_done(); };
+        if (timeout_ms < 0)
+            priv->flush_cond.wait(guard, done);
+        else if (!priv->flush_cond.wait_for(guard, std::chrono::milliseconds(timeout_ms), done))
+            return err::ERR_TIMEOUT;
+        return priv->_done() ? err::ERR_NONE : err::ERR_CANCEL;
+    }
+
+    bool Client::is_connected()
+    {
+        ClientPriv *priv = (ClientPriv *)_priv;
+        std::lock_guard<std::mutex> guard(priv->lock);
+        return priv->state == STATE_CONNECTED;
+    }
+
+    mqtt::Stats Client::stats()
+    {
+        ClientPriv *priv = (ClientPriv *)_priv;
+        std::lock_guard<std::mutex> guard(priv->lock);
+        Stats s = priv->stats;
+        s.queue_len = priv->queue.size();
+        s.inflight = priv->inflight.size();
+        return s;
+    }
+
+} // namespace maix::network::mqtt
@@ -3,10 +3,12 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2025.5.20: Add melotts support.
+ * @update 2026.10.18: Add compiled lexicon and streaming synthesis.
  */
 
 #pragma once
 #include "maix_basic.hpp"
+#include <functional>
 
 namespace maix::nn
 {
@@ -60,6 +62,32 @@ namespace maix::nn
         */
         Bytes *infer(std::string text, std::string path = "", bool output_pcm = false);
 
+        /**
+         * Text to speech, output audio chunk by chunk while synthesizing.
+         * Text is split to sentences, and every sentence is decoded in slices, each slice is output once decoded,
+         * so the first audio can be played while later sentences are still being synthesized, e.g. call audio.Player.play in callback.
+         * Synthesis runs in a background thread, callback is called in the caller's thread.
+         * @param text input text
+         * @param callback called with raw PCM data of each chunk, sampling rate is samplerate(), 1 channel, 16 bits,
+         * PCM data is only valid during callback. Return false to stop synthesis.
+         * @return err::ERR_NONE if success, err::ERR_CANCEL if stopped by callback.
+         * @maixpy maix.nn.MeloTTS.infer_stream
+        */
+        err::Err infer_stream(std::string text, std::function<bool(Bytes *)> callback);
+
+        /**
+         * Compile text lexicon and tokens file to binary lexicon, which is memory mapped when load model,
+         * load is faster and uses less memory than text lexicon.
+         * load() will compile it automatically as `lexicon + ".bin"` if it not exists or is older than text files,
+         * use this function to compile it offline when model directory is read-only on device.
+         * @param lexicon text lexicon file path, each line is `word phone1 ... phoneN tone1 ... toneN`.
+         * @param tokens text tokens file path, each line is `phone id`.
+         * @param out output file path, default empty means `lexicon + ".bin"`.
+         * @return err::ERR_NONE if success.
+         * @maixpy maix.nn.MeloTTS.compile_lexicon
+        */
+        static err::Err compile_lexicon(const std::string &lexicon, const std::string &tokens, const std::string &out = "");
+
         /**
          * Get pcm samplerate
          * @return pcm samplerate
@@ -298,6 +298,11 @@ namespace maix::nn
                     _rec_input_size = image::Size(rec_inputs[0].shape[2], rec_inputs[0].shape[1]);
                 else
                     _rec_input_size = image::Size(rec_inputs[0].shape[3], rec_inputs[0].shape[2]);
+                _rec_nhwc = rec_inputs[0].shape[3] <= 4;
+                _rec_batch = rec_inputs[0].shape[0] > 1 ? rec_inputs[0].shape[0] : 1;
+                _rec_input_name = rec_inputs[0].name;
+                if(_rec_batch > 1)
+                    log::print(log::LogLevel::LEVEL_INFO, "\trec batch: %d\n", _rec_batch);
                 std::vector<nn::LayerInfo> rec_outputs = _rec_model->outputs_info();
                 size_t labels_num = rec_outputs[0].shape[2] - 2;
                 if(labels_num != labels.size())
@@ -342,7 +347,7 @@ namespace maix::nn
                 throw err::Exception("image format not match, input_type: " + image::fmt_names[_input_img_fmt] + ", image format: " + image::fmt_names[img.format()]);
             }
             tensor::Tensors *outputs;
-            outputs = _model->forward_image(img, this->mean, this->scale, fit, true);
+            outputs = _model->forward_image(img, this->mean, this->scale, fit, false);
             if (!outputs) // not ready, return empty result.
             {
                 return new nn::OCR_Objects();
@@ -391,8 +396,8 @@ namespace maix::nn
             {
                 throw err::Exception(err::ERR_NO_MEM);
             }
-            _recognize(img, box, obj->idx_list, char_list, obj->char_pos, crop);
-            obj->update_chars(char_list);
+            std::vector<nn::OCR_Object *> objs(1, obj);
+            _recognize(img, objs, crop);
             return obj;
         }
 
@@ -533,6 +538,9 @@ namespace maix::nn
         std::string _score_mode = "fast";
         int _max_ch_num;
         int _prob_num;
+        int _rec_batch = 1;
+        bool _rec_nhwc = false;
+        std::string _rec_input_name;
 
     private:
         err::Err _load_labels_from_file(std::vector<std::string> &labels, const std::string &label_path)
@@ -561,7 +569,11 @@ namespace maix::nn
 
         nn::OCR_Objects *_post_process(image::Image &img, tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit);
 
-        void _recognize(image::Image &img, const nn::OCR_Box &box, std::vector<int> &idx_list, std::vector<std::string> &char_list, std::vector<int> &char_pos, bool crop);
+        /**
+         * Recognize all objects' boxes in one pass: warp every box, slice lines wider than model input,
+         * then forward slices in batches of model batch size, results are written to objects.
+         */
+        void _recognize(image::Image &img, std::vector<nn::OCR_Object *> &objs, bool crop);
 
         // void _get_layer_objs(std::vector<nn::Object> &objs, tensor::Tensor &output, int layer_i, int layer_num)
         // {
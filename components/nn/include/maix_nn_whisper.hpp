@@ -3,11 +3,13 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2024.6.7: Add yolov8 support.
+ * @update 2026.10.18: Add streaming transcription with voice activity detection.
  */
 
 #pragma once
 #include "maix_basic.hpp"
 #include "maix_nn.hpp"
+#include <functional>
 
 namespace maix::nn
 {
@@ -69,6 +71,39 @@ namespace maix::nn
         */
         std::string transcribe_raw(Bytes *pcm, int sample_rate = 16000, int channels = 1, int bits_per_frame = 16);
 
+        /**
+         * Start streaming transcription, then feed pcm chunks by stream_feed and end by stream_stop.
+         * Voice activity detection cuts input into utterances, only closed utterances are transcribed and silence is skipped,
+         * so short voice commands are recognized soon after speaking instead of after whole recording.
+         * @param callback called with text of each utterance. The second arg is_final is false if the utterance is longer than
+         * the max model input length(30s) and was cut, then rest of it will be output by later callbacks.
+         * @param sample_rate input pcm sample rate.
+         * @param channels input pcm channels, will be mixed to mono.
+         * @param bits_per_frame input pcm sample bits, supports 8, 16, 24 and 32.
+         * @param silence_ms utterance is closed after silence of this time, unit ms.
+         * @param vad_threshold_db frame is voice when its energy is higher than estimated noise floor by this value, unit dB.
+         * @return err::ERR_NONE if success.
+         * @maixpy maix.nn.Whisper.stream_start
+        */
+        err::Err stream_start(std::function<void(std::string, bool)> callback, int sample_rate = 16000, int channels = 1, int bits_per_frame = 16, int silence_ms = 500, float vad_threshold_db = 12.0);
+
+        /**
+         * Feed pcm data to streaming transcription.
+         * @note When an utterance is closed, it's transcribed and callback is called in this function,
+         * so this function may block for the inference time, audio::Recorder keeps recording meanwhile.
+         * @param pcm pcm data chunk, format is set by stream_start, can be any length.
+         * @return err::ERR_NONE if success, err::ERR_NOT_READY if stream not started.
+         * @maixpy maix.nn.Whisper.stream_feed
+        */
+        err::Err stream_feed(Bytes *pcm);
+
+        /**
+         * Stop streaming transcription, the unclosed utterance is transcribed and output by callback.
+         * @return err::ERR_NONE if success, err::ERR_NOT_READY if stream not started.
+         * @maixpy maix.nn.Whisper.stream_stop
+        */
+        err::Err stream_stop();
+
         /**
          * Get input pcm samplerate
          * @return input pcm samplerate
@@ -534,7 +534,7 @@ namespace maix::nn
             {
                 return new nn::Objects();
             }
-            nn::Objects *res = _post_process(outputs, img.width(), img.height(), fit, sort);
+            nn::Objects *res = _post_process(outputs, img.width(), img.height(), fit, sort, conf_th, iou_th, keypoint_th);
 #if SHOW_DETECT_TIME
             log::info("postprocess time: %ld", time::ticks_ms() - start);
 #endif
@@ -546,6 +546,25 @@ namespace maix::nn
             return res;
         }
 
+        /**
+         * Decode and NMS model outputs, the same post process detect() runs after forward.
+         * Useful when forward is done by yourself, e.g. nn::NN::forward_image, or for benchmark.
+         * @param outputs model outputs of this model
+         * @param img_w original image width, used to correct bbox
+         * @param img_h original image height, used to correct bbox
+         * @param conf_th Confidence threshold, default 0.5.
+         * @param iou_th IoU threshold, default 0.45.
+         * @param fit Resize method used when forward, default image.Fit.FIT_CONTAIN.
+         * @param keypoint_th keypoint threshold, default 0.5, only for yolo11-pose model.
+         * @param sort sort result according to object size, default 0 means not sort, 1 means bigger in front, -1 means smaller in front.
+         * @return Object list, NULL if decode failed. In C++, you should delete it after use.
+         * @maixcdk maix.nn.YOLO11.post_process
+         */
+        nn::Objects *post_process(tensor::Tensors *outputs, int img_w, int img_h, float conf_th = 0.5, float iou_th = 0.45, maix::image::Fit fit = maix::image::FIT_CONTAIN, float keypoint_th = 0.5, int sort = 0)
+        {
+            return _post_process(outputs, img_w, img_h, fit, sort, conf_th, iou_th, keypoint_th);
+        }
+
         /**
          * Get model input size
          * @return model input size
@@ -760,15 +779,16 @@ namespace maix::nn
             return err::ERR_NONE;
         }
 
-        nn::Objects *_post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort)
+        nn::Objects *_post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort, float conf_th, float iou_th, float keypoint_th)
         {
+            MAIX_TRACE_SCOPE("yolo11.post_process", "nn");
             nn::Objects *objects = new nn::Objects();
             tensor::Tensor *kp_out = NULL;
             tensor::Tensor *mask_out = NULL;
             float scale_w = 1;
             float scale_h = 1;
 
-            if(!_decode_objs(*objects, outputs, _conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
+            if(!_decode_objs(*objects, outputs, conf_th, _input_size.width(), _input_size.height(), &kp_out, &mask_out))
             {
                 delete objects;
                 return NULL;
@@ -776,7 +796,7 @@ namespace maix::nn
             if (objects->size() > 0)
             {
                 nn::Objects *objects_total = objects;
-                objects = _nms(*objects);
+                objects = _nms(*objects, iou_th);
                 delete objects_total;
                 if(sort != 0)
                 {
@@ -786,7 +806,7 @@ namespace maix::nn
             // decode keypoints
             if (_type == YOLO11_Type::POSE)
             {
-                _decode_keypoints(*objects, kp_out);
+                _decode_keypoints(*objects, kp_out, keypoint_th);
             }
             else if (_type == YOLO11_Type::SEG)
             {
@@ -1233,7 +1253,7 @@ namespace maix::nn
             return true;
         }
 
-        nn::Objects *_nms(nn::Objects &objs)
+        nn::Objects *_nms(nn::Objects &objs, float iou_th)
         {
             nn::Objects *result = new nn::Objects();
             std::sort(objs.begin(), objs.end(), [](const nn::Object *a, const nn::Object *b)
@@ -1247,7 +1267,7 @@ namespace maix::nn
                 {
                     nn::Object &b = objs.at(j);
                     {
-                        if (b.score != 0 && a.class_id == b.class_id && _calc_iou(a, b) > this->_iou_th)
+                        if (b.score != 0 && a.class_id == b.class_id && _calc_iou(a, b) > iou_th)
                         {
                             b.score = 0;
                         }
@@ -1298,7 +1318,7 @@ namespace maix::nn
                       { return (a->w * a->h) < (b->w * b->h); });
         }
 
-        void _decode_keypoints(nn::Objects &objs, tensor::Tensor *kp_out)
+        void _decode_keypoints(nn::Objects &objs, tensor::Tensor *kp_out, float keypoint_th)
         {
             float *data = (float *)kp_out->data();
             if(_out_chw)
@@ -1314,7 +1334,7 @@ namespace maix::nn
                         float score = _sigmoid(p[(k * 3 + 2) * _anchor_num]);
                         int x = -1;
                         int y = -1;
-                        if (score > _keypoint_th)
+                        if (score > keypoint_th)
                         {
                             x = (p[(k * 3) * _anchor_num] * 2.0 + kp_info->anchor_x) * kp_info->stride;
                             y = (p[(k * 3 + 1) * _anchor_num] * 2.0 + kp_info->anchor_y) * kp_info->stride;
@@ -1339,7 +1359,7 @@ namespace maix::nn
                         float score = _sigmoid(p[k * 3 + 2]);
                         int x = -1;
                         int y = -1;
-                        if (score > _keypoint_th)
+                        if (score > keypoint_th)
                         {
                             x = (p[k * 3] * 2.0 + kp_info->anchor_x) * kp_info->stride;
                             y = (p[k * 3 + 1] * 2.0 + kp_info->anchor_y) * kp_info->stride;
@@ -363,6 +363,7 @@ namespace maix::nn
         std::vector<nn::Object> *_post_process(tensor::Tensors *outputs, int img_w, int img_h, 
                                                 maix::image::Fit fit)
         {
+            MAIX_TRACE_SCOPE("yolo26.post_process", "nn");
             std::vector<nn::Object> *objects = new std::vector<nn::Object>();
             
             // Process each scale
@@ -608,6 +608,7 @@ namespace maix::nn
 
         nn::Objects *_post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort)
         {
+            MAIX_TRACE_SCOPE("yolo_world.post_process", "nn");
             nn::Objects *objects = new nn::Objects();
             tensor::Tensor *kp_out = NULL;
             tensor::Tensor *mask_out = NULL;
@@ -354,6 +354,7 @@ namespace maix::nn
 
         std::vector<nn::Object> *_post_process(tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit, int sort)
         {
+            MAIX_TRACE_SCOPE("yolov5.post_process", "nn");
             std::vector<nn::Object> *objects = new std::vector<nn::Object>();
             int layer_num = outputs->size();
             int i = 0;
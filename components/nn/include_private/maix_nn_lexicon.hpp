@@ -0,0 +1,87 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add compiled and memory mapped TTS lexicon, create this file.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "darts.h"
+#include <string>
+#include <vector>
+
+namespace maix::nn
+{
+    /**
+     * Word to phones and tones lexicon of TTS models.
+     * Text lexicon and tokens files are compiled to one binary file, a double array trie(darts-clone) with values packed after it,
+     * the binary file is memory mapped when load, so load is fast and pages are shared and only read when used.
+     */
+    class Lexicon
+    {
+    public:
+        Lexicon();
+        ~Lexicon();
+
+        /**
+         * Load lexicon, use compiled file `lexicon_file + ".bin"` if it's newer than text files,
+         * or compile text files and save to it first, if save failed(e.g. read only file system), use compiled data in memory.
+         * @param lexicon_file text lexicon file, each line is `word phone1 ... phoneN tone1 ... toneN`.
+         * @param tokens_file text tokens file, each line is `phone id`.
+         * @return err::ERR_NONE if success.
+         */
+        err::Err load(const std::string &lexicon_file, const std::string &tokens_file);
+
+        /**
+         * Memory map compiled lexicon file.
+         * @param compiled_file file compiled by compile().
+         * @return err::ERR_NONE if success.
+         */
+        err::Err open(const std::string &compiled_file);
+
+        /**
+         * Compile text lexicon and tokens file to binary file.
+         * @param out_file output file path, empty means not save file.
+         * @param data if not nullptr, compiled file content will be put in it.
+         * @return err::ERR_NONE if success.
+         */
+        static err::Err compile(const std::string &lexicon_file, const std::string &tokens_file, const std::string &out_file, std::vector<uint8_t> *data = nullptr);
+
+        /**
+         * Close lexicon, unmap file.
+         */
+        void close();
+
+        /**
+         * Find word, append its phones and tones.
+         * @return false if word not found, phones and tones not changed.
+         */
+        bool lookup(const std::string &word, std::vector<int> &phones, std::vector<int> &tones) const;
+
+        /**
+         * Convert text to phones and tones, unknown words use blank token.
+         * @param word2ph phones number of each word.
+         */
+        void convert(const std::string &text, std::vector<int> &phones, std::vector<int> &tones, std::vector<int> &word2ph) const;
+
+        /**
+         * Words number.
+         */
+        int size() const;
+
+    private:
+        err::Err _attach(const uint8_t *data, size_t size);
+
+        Darts::DoubleArray _trie;
+        const uint8_t *_data = nullptr;     // mapped file or _buffer
+        size_t _size = 0;
+        bool _mapped = false;
+        std::vector<uint8_t> _buffer;       // compiled data if not mapped
+        const uint8_t *_values = nullptr;
+        size_t _values_size = 0;
+        int _entries = 0;
+        int _blank = 0;
+    };
+} // namespace maix::nn
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <array>
 #include "clipper2/clipper.h"
 #include "opencv2/opencv.hpp"
 #include "pp_ocr_utility.h"
@@ -22,38 +23,49 @@ namespace PaddleOCR {
 
 class DBPostProcessor {
 public:
-  void GetContourArea(const std::vector<std::vector<float>> &box,
-                      float unclip_ratio, float &distance);
+  void GetContourArea(const cv::Point2f box[4], float unclip_ratio,
+                      float &distance);
 
-  cv::RotatedRect UnClip(std::vector<std::vector<float>> box,
-                         const float &unclip_ratio);
+  cv::RotatedRect UnClip(const cv::Point2f box[4], const float &unclip_ratio);
 
-  float **Mat2Vec(cv::Mat mat);
+  std::vector<float> Mat2Vec(const cv::Mat &mat);
 
   std::vector<std::vector<int>>
-  OrderPointsClockwise(std::vector<std::vector<int>> pts);
+  OrderPointsClockwise(const std::vector<std::vector<int>> &pts);
 
-  std::vector<std::vector<float>> GetMiniBoxes(cv::RotatedRect box,
-                                               float &ssid);
+  void GetMiniBoxes(const cv::RotatedRect &box, float &ssid,
+                    cv::Point2f array[4]);
 
-  float BoxScoreFast(std::vector<std::vector<float>> box_array, cv::Mat pred);
-  float PolygonScoreAcc(std::vector<cv::Point> contour, cv::Mat pred);
+  float BoxScoreFast(const cv::Point2f box_array[4], const cv::Mat &pred);
+  float PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                        const cv::Mat &pred);
 
-  std::vector<std::vector<std::vector<int>>>
-  BoxesFromBitmap(const cv::Mat pred, const cv::Mat bitmap,
-                  const float &box_thresh, const float &det_db_unclip_ratio,
-                  const std::string &det_db_score_mode, std::vector<float> &scores);
+  // boxes and scores are cleared and filled, keep the instance and output
+  // vectors alive across frames to reuse their buffers.
+  void BoxesFromBitmap(const cv::Mat &pred, const cv::Mat &bitmap,
+                       const float &box_thresh, const float &det_db_unclip_ratio,
+                       const std::string &det_db_score_mode,
+                       std::vector<std::array<cv::Point, 4>> &boxes,
+                       std::vector<float> &scores);
 
   std::vector<std::vector<std::vector<int>>>
   FilterTagDetRes(std::vector<std::vector<std::vector<int>>> boxes,
                   float ratio_h, float ratio_w, cv::Mat srcimg);
 
 private:
-  static bool XsortInt(std::vector<int> a, std::vector<int> b);
+  static bool XsortInt(const std::vector<int> &a, const std::vector<int> &b);
+
+  static bool XsortFp32(const cv::Point2f &a, const cv::Point2f &b);
 
-  static bool XsortFp32(std::vector<float> a, std::vector<float> b);
+  cv::Mat MaskBuffer(int rows, int cols);
 
-  std::vector<std::vector<float>> Mat2Vector(cv::Mat mat);
+  // reusable buffers
+  std::vector<std::vector<cv::Point>> contours_;
+  std::vector<cv::Point> rook_points_;
+  std::vector<cv::Point2f> unclip_points_;
+  Clipper2Lib::Path64 clip_path_;
+  Clipper2Lib::Paths64 clip_soln_;
+  cv::Mat mask_buf_;
 
   inline int _max(int a, int b) { return a >= b ? a : b; }
 
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2025.5.20: Add melotts support.
+ * @update 2026.10.18: Add infer_stream.
  */
 
 #include "maix_basic.hpp"
@@ -33,4 +34,8 @@ namespace maix::nn
     Bytes *MeloTTS::infer(std::string text, std::string path, bool output_pcm) {
         return nullptr;
     }
+
+    err::Err MeloTTS::infer_stream(std::string text, std::function<bool(Bytes *)> callback) {
+        return err::ERR_NOT_IMPL;
+    }
 } // namespace maix::nn
\ No newline at end of file
@@ -39,4 +39,16 @@ namespace maix::nn
     std::string Whisper::transcribe_raw(Bytes *pcm, int sample_rate, int channels, int bits_per_frame) {
         return "";
     }
+
+    err::Err Whisper::stream_start(std::function<void(std::string, bool)> callback, int sample_rate, int channels, int bits_per_frame, int silence_ms, float vad_threshold_db) {
+        return err::ERR_NOT_IMPL;
+    }
+
+    err::Err Whisper::stream_feed(Bytes *pcm) {
+        return err::ERR_NOT_IMPL;
+    }
+
+    err::Err Whisper::stream_stop() {
+        return err::ERR_NOT_IMPL;
+    }
 } // namespace maix::nn
\ No newline at end of file
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2025.5.20: Add melotts support.
+ * @update 2026.10.18: Use memory mapped compiled lexicon, add streaming synthesis.
  */
 
 #include "maix_basic.hpp"
@@ -19,156 +20,16 @@
 #include <fstream>
 #include "onnxruntime/onnxruntime_cxx_api.h"
 #include "maix_nn_melotts.hpp"
+#include "maix_nn_lexicon.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
 
 namespace maix::nn
 {
     namespace {
-        class Lexicon {
-        private:
-            std::unordered_map<std::string, std::pair<std::vector<int>, std::vector<int>>> lexicon;
-
-        public:
-            Lexicon(const std::string& lexicon_filename, const std::string& tokens_filename) {
-                std::unordered_map<std::string, int> tokens;
-                std::ifstream ifs(tokens_filename);
-                assert(ifs.is_open());
-
-                std::string line;
-                while ( std::getline(ifs, line) ) {
-                    auto splitted_line = split(line, ' ');
-                    tokens.insert({splitted_line[0], std::stoi(splitted_line[1])});
-                }
-                ifs.close();
-
-                ifs.open(lexicon_filename);
-                assert(ifs.is_open());
-                while ( std::getline(ifs, line) ) {
-                    auto splitted_line = split(line, ' ');
-                    std::string word_or_phrase = splitted_line[0];
-                    size_t phone_tone_len = splitted_line.size() - 1;
-                    size_t half_len = phone_tone_len / 2;
-                    std::vector<int> phones, tones;
-                    for (size_t i = 0; i < phone_tone_len; i++) {
-                        auto phone_or_tone = splitted_line[i + 1];
-                        if (i < half_len) {
-                            phones.push_back(tokens[phone_or_tone]);
-                        } else {
-                            tones.push_back(std::stoi(phone_or_tone));
-                        }
-                    }
-
-                    lexicon.insert({word_or_phrase, std::make_pair(phones, tones)});
-                }
-
-                lexicon["呣"] = lexicon["母"];
-                lexicon["嗯"] = lexicon["恩"];
-
-                const std::vector<std::string> punctuation{"!", "?", "…", ",", ".", "'", "-"};
-                for (auto p : punctuation) {
-                    int i = tokens[p];
-                    int tone = 0;
-                    lexicon[p] = std::make_pair(std::vector<int>{i}, std::vector<int>{tone});
-                }
-                lexicon[" "] = std::make_pair(std::vector<int>{tokens["_"]}, std::vector<int>{0});
-            }
-
-            std::vector<std::string> split (const std::string &s, char delim) {
-                std::vector<std::string> result;
-                std::stringstream ss (s);
-                std::string item;
-                while (getline (ss, item, delim)) {
-                    result.push_back (item);
-                }
-                return result;
-            }
-
-            std::vector<std::string> splitEachChar(const std::string& text)
-            {
-                std::vector<std::string> words;
-                std::string input(text);
-                int len = input.length();
-                int i = 0;
-
-                while (i < len) {
-                int next = 1;
-                if ((input[i] & 0x80) == 0x00) {
-                    // std::cout << "one character: " << input[i] << std::endl;
-                } else if ((input[i] & 0xE0) == 0xC0) {
-                    next = 2;
-                    // std::cout << "two character: " << input.substr(i, next) << std::endl;
-                } else if ((input[i] & 0xF0) == 0xE0) {
-                    next = 3;
-                    // std::cout << "three character: " << input.substr(i, next) << std::endl;
-                } else if ((input[i] & 0xF8) == 0xF0) {
-                    next = 4;
-                    // std::cout << "four character: " << input.substr(i, next) << std::endl;
-                }
-                words.push_back(input.substr(i, next));
-                i += next;
-                }
-                return words;
-            }
-
-            bool is_english(std::string s) {
-                if (s.size() == 1)
-                    return (s[0] >= 'A' && s[0] <= 'Z') || (s[0] >= 'a' && s[0] <= 'z');
-                else
-                    return false;
-            }
-
-            std::vector<std::string> merge_english(const std::vector<std::string>& splitted_text) {
-                std::vector<std::string> words;
-                size_t i = 0;
-                while (i < splitted_text.size()) {
-                    std::string s;
-                    if (is_english(splitted_text[i])) {
-                        while (i < splitted_text.size()) {
-                            if (!is_english(splitted_text[i])) {
-                                break;
-                            }
-                            s += splitted_text[i];
-                            i++;
-                        }
-                        // to lowercase
-                        std::transform(s.begin(), s.end(), s.begin(),
-                            [](unsigned char c){ return std::tolower(c); });
-                        words.push_back(s);
-                        if (i >= splitted_text.size())
-                            break;
-                    }
-                    else {
-                        words.push_back(splitted_text[i]);
-                        i++;
-                    }
-                }
-                return words;
-            }
-
-            void convert(const std::string& text, std::vector<int>& phones, std::vector<int>& tones, std::vector<int>& word2ph) {
-                auto splitted_text = splitEachChar(text);
-                auto zh_mix_en = merge_english(splitted_text);
-                for (auto c : zh_mix_en) {
-                    std::string s{c};
-                    if (s == "，")
-                        s = ",";
-                    else if (s == "。")
-                        s = ".";
-                    else if (s == "！")
-                        s = "!";
-                    else if (s == "？")
-                        s = "?";
-
-                    auto phones_and_tones = lexicon[" "];
-                    if (lexicon.find(s) != lexicon.end()) {
-                        phones_and_tones = lexicon[s];
-                    }
-                    phones.insert(phones.end(), phones_and_tones.first.begin(), phones_and_tones.first.end());
-                    tones.insert(tones.end(), phones_and_tones.second.begin(), phones_and_tones.second.end());
-                    word2ph.push_back(phones_and_tones.first.size());
-                }
-            }
-        };
-
         class OnnxWrapper {
         public:
             OnnxWrapper():
@@ -692,8 +553,14 @@ namespace maix::nn
             return res;
         }
         std::string lexicon_file = fs::dirname(model) + "/" + value_string;
-        param->lexicon = std::make_unique<Lexicon>(lexicon_file, token_file);
-        log::info("load token and lexicon cost %ld ms", time::ticks_ms() - start);
+        param->lexicon = std::make_unique<Lexicon>();
+        res = param->lexicon->load(lexicon_file, token_file);
+        if (res != err::ERR_NONE) {
+            log::error("load lexicon %s failed", lexicon_file.c_str());
+            this->unload();
+            return res;
+        }
+        log::info("load token and lexicon cost %ld ms, %d words", time::ticks_ms() - start, param->lexicon->size());
 
         start = time::ticks_ms();
         // load static input
@@ -732,6 +599,7 @@ namespace maix::nn
     err::Err MeloTTS::unload() {
         MelottsParam *param = (MelottsParam *)_extra_param;
         param->decoder_model = nullptr;
+        param->lexicon = nullptr;
         return err::ERR_NONE;
     }
 
@@ -777,6 +645,104 @@ namespace maix::nn
     //     }printf("\r\n");
     // }
 
+    // Synthesize one sentence, on_audio is called with audio of each decoder slice, return false to stop.
+    static err::Err _synthesize(MelottsParam *param, double speed, const std::string &sentence, const std::function<bool(const float *, int)> &on_audio) {
+        err::Err err = err::ERR_NONE;
+        float noise_scale   = param->noise_scale;
+        float length_scale  = 1.0 / speed;
+        float noise_scale_w = param->noise_scale_w;
+        float sdp_ratio     = param->sdp_ratio;
+
+        // Convert sentence to phones and tones
+        std::vector<int> phones_bef, tones_bef, word2ph;
+        param->lexicon->convert(sentence, phones_bef, tones_bef, word2ph);
+
+        // Add blank between words
+        auto phones = intersperse(phones_bef, 0);
+        auto tones = intersperse(tones_bef, 0);
+        for (int& i : word2ph) {
+            i *= 2;
+        }
+        if (!word2ph.empty())
+            word2ph[0] += 1;
+
+        int phone_len = phones.size();
+
+        std::vector<int> langids(phone_len, 3);
+
+        // Run encoder
+        auto encoder_output = param->encoder.Run(phones, tones, langids, param->g, noise_scale, noise_scale_w, length_scale, sdp_ratio);
+        float* zp_data = encoder_output.at(0).GetTensorMutableData<float>();
+        int* pronoun_lens_data = encoder_output.at(1).GetTensorMutableData<int>();
+        // int audio_len = encoder_output.at(2).GetTensorMutableData<int>()[0];
+        auto zp_info = encoder_output.at(0).GetTensorTypeAndShapeInfo();
+        auto zp_shape = zp_info.GetShape();
+        std::vector<int> pronoun_lens(pronoun_lens_data, pronoun_lens_data + phone_len);
+
+        auto inputs_info = param->decoder_model->inputs_info();
+        auto outputs_info = param->decoder_model->outputs_info();
+        int zp_size = inputs_info[0].shape_int();
+        int dec_len = zp_size / zp_shape[1];
+        int audio_slice_len = outputs_info[0].shape_int();
+
+        // Generate pronoun slices for better effect
+        auto word2pronoun = calc_word2pronoun(word2ph, pronoun_lens);
+        auto dec_slices = generate_slices(word2pronoun, dec_len);
+
+        // int dec_slice_num = int(std::ceil(zp_shape[2] * 1.0 / dec_len));
+        size_t dec_slice_num = dec_slices.first.size();
+
+        // Iteratively run decoder
+        std::vector<float> zp_slice(zp_size, 0);
+        for (size_t i = 0; i < dec_slice_num; i++) {
+            const Slice& ps = dec_slices.first[i];
+            const Slice& zs = dec_slices.second[i];
+
+            std::fill(zp_slice.begin(), zp_slice.end(), 0);
+            int actual_size = std::min(zs.end - zs.start, dec_len);
+            for (int n = 0; n < zp_shape[1]; n++) {
+                memcpy(zp_slice.data() + n * dec_len, zp_data + n * zp_shape[2] + zs.start, sizeof(float) * actual_size);
+            }
+
+            // 输出音频的长度
+            int sub_audio_len = 512 * actual_size;
+            tensor::Tensors input_tensors, output_tensors;
+            tensor::Tensor *input_tensor0 = new tensor::Tensor(inputs_info[0].shape, inputs_info[0].dtype, zp_slice.data(), false);
+            tensor::Tensor *input_tensor1 = new tensor::Tensor(inputs_info[1].shape, inputs_info[1].dtype, param->g.data(), false);
+            input_tensors.add_tensor(inputs_info[0].name, input_tensor0, false, true);
+            input_tensors.add_tensor(inputs_info[1].name, input_tensor1, false, true);
+            if (err::ERR_NONE != (err = param->decoder_model->forward(input_tensors, output_tensors, false, true))) {
+                log::error("decoder forward failed! err:%d", err);
+                return err;
+            }
+            auto output_tensor = output_tensors.get_tensor(outputs_info[0].name);
+            if (output_tensor.size_int() != audio_slice_len) {
+                log::error("decoder output size error! %d != %d", output_tensor.size_int(), audio_slice_len);
+                return err::ERR_RUNTIME;
+            }
+
+            // 处理overlap
+            int audio_start = 0;
+            if (i > 0 && dec_slices.first[i - 1].end > ps.start) {
+                // 去掉第一个字
+                audio_start = 512 * word2pronoun[ps.start];
+            }
+
+            int audio_end = sub_audio_len;
+            if (i < dec_slices.first.size() - 1) {
+                if (ps.end > dec_slices.first[i + 1].start) {
+                    // 去掉最后一个字
+                    audio_end = sub_audio_len - 512 * word2pronoun[ps.end - 1];
+                }
+            }
+
+            if (audio_end > audio_start && !on_audio((float *)output_tensor.data() + audio_start, audio_end - audio_start)) {
+                return err::ERR_CANCEL;
+            }
+        }
+        return err::ERR_NONE;
+    }
+
     /**
      * Text to speech
      * @param text input text
@@ -788,102 +754,21 @@ namespace maix::nn
      * @maixpy maix.nn.MeloTTS.infer
     */
     Bytes *MeloTTS::infer(std::string text, std::string path, bool output_pcm) {
-        err::Err err = err::ERR_NONE;
         MelottsParam *param = (MelottsParam *)_extra_param;
-        float noise_scale   = param->noise_scale;
-        float length_scale  = 1.0 / _speed;
-        float noise_scale_w = param->noise_scale_w;
-        float sdp_ratio     = param->sdp_ratio;
+        if (!param->decoder_model || !param->lexicon) {
+            log::error("model not loaded");
+            return nullptr;
+        }
 
         auto sens = split_sentence(text, 10, param->language);
         std::vector<float> wavlist;
         for (auto& se : sens) {
-
-            // Convert sentence to phones and tones
-            std::vector<int> phones_bef, tones_bef, word2ph;
-            param->lexicon->convert(se, phones_bef, tones_bef, word2ph);
-
-            // Add blank between words
-            auto phones = intersperse(phones_bef, 0);
-            auto tones = intersperse(tones_bef, 0);
-            for (int& i : word2ph) {
-                i *= 2;
-            }
-            if (!word2ph.empty())
-                word2ph[0] += 1;
-
-            int phone_len = phones.size();
-
-            std::vector<int> langids(phone_len, 3);
-
-            // Run encoder
-            auto encoder_output = param->encoder.Run(phones, tones, langids, param->g, noise_scale, noise_scale_w, length_scale, sdp_ratio);
-            float* zp_data = encoder_output.at(0).GetTensorMutableData<float>();
-            int* pronoun_lens_data = encoder_output.at(1).GetTensorMutableData<int>();
-            // int audio_len = encoder_output.at(2).GetTensorMutableData<int>()[0];
-            auto zp_info = encoder_output.at(0).GetTensorTypeAndShapeInfo();
-            auto zp_shape = zp_info.GetShape();
-            std::vector<int> pronoun_lens(pronoun_lens_data, pronoun_lens_data + phone_len);
-
-            auto inputs_info = param->decoder_model->inputs_info();
-            auto outputs_info = param->decoder_model->outputs_info();
-            int zp_size = inputs_info[0].shape_int();
-            int dec_len = zp_size / zp_shape[1];
-            int audio_slice_len = outputs_info[0].shape_int();
-
-            // Generate pronoun slices for better effect
-            auto word2pronoun = calc_word2pronoun(word2ph, pronoun_lens);
-            auto dec_slices = generate_slices(word2pronoun, dec_len);
-
-            // int dec_slice_num = int(std::ceil(zp_shape[2] * 1.0 / dec_len));
-            size_t dec_slice_num = dec_slices.first.size();
-
-            // Iteratively run decoder
-            for (size_t i = 0; i < dec_slice_num; i++) {
-                const Slice& ps = dec_slices.first[i];
-                const Slice& zs = dec_slices.second[i];
-
-                std::vector<float> zp_slice(zp_size, 0);
-                int actual_size = std::min(zs.end - zs.start, dec_len);
-                for (int n = 0; n < zp_shape[1]; n++) {
-                    memcpy(zp_slice.data() + n * dec_len, zp_data + n * zp_shape[2] + zs.start, sizeof(float) * actual_size);
-                }
-
-                // 输出音频的长度
-                int sub_audio_len = 512 * actual_size;
-                tensor::Tensors input_tensors, output_tensors;
-                tensor::Tensor *input_tensor0 = new tensor::Tensor(inputs_info[0].shape, inputs_info[0].dtype, zp_slice.data(), false);
-                tensor::Tensor *input_tensor1 = new tensor::Tensor(inputs_info[1].shape, inputs_info[1].dtype, param->g.data(), false);
-                input_tensors.add_tensor(inputs_info[0].name, input_tensor0, false, true);
-                input_tensors.add_tensor(inputs_info[1].name, input_tensor1, false, true);
-                if (err::ERR_NONE != (err = param->decoder_model->forward(input_tensors, output_tensors, false, true))) {
-                    log::error("decoder forward failed! err:%d", err);
-                    return nullptr;
-                }
-                auto output_tensor = output_tensors.get_tensor(outputs_info[0].name);
-                if (output_tensor.size_int() != audio_slice_len) {
-                    log::error("decoder output size error! %d != %d", output_tensor.size_int(), audio_slice_len);
-                    return nullptr;
-                }
-
-                // 处理overlap
-                int audio_start = 0;
-                if (!wavlist.empty()) {
-                    if (dec_slices.first[i - 1].end > ps.start) {
-                        // 去掉第一个字
-                        audio_start = 512 * word2pronoun[ps.start];
-                    }
-                }
-
-                int audio_end = sub_audio_len;
-                if (i < dec_slices.first.size() - 1) {
-                    if (ps.end > dec_slices.first[i + 1].start) {
-                        // 去掉最后一个字
-                        audio_end = sub_audio_len - 512 * word2pronoun[ps.end - 1];
-                    }
-                }
-
-                wavlist.insert(wavlist.end(), (float *)output_tensor.data() + audio_start, (float *)output_tensor.data() + audio_end);
+            err::Err e = _synthesize(param, _speed, se, [&wavlist](const float *data, int len) {
+                wavlist.insert(wavlist.end(), data, data + len);
+                return true;
+            });
+            if (e != err::ERR_NONE) {
+                return nullptr;
             }
         }
 
@@ -908,4 +793,91 @@ namespace maix::nn
         }
         return pcm;
     }
+
+    err::Err MeloTTS::infer_stream(std::string text, std::function<bool(Bytes *)> callback) {
+        MelottsParam *param = (MelottsParam *)_extra_param;
+        if (!param->decoder_model || !param->lexicon) {
+            log::error("model not loaded");
+            return err::ERR_NOT_READY;
+        }
+        if (!callback) {
+            return err::ERR_ARGS;
+        }
+
+        // synthesize in worker thread, caller thread converts chunks and calls callback,
+        // so callback(e.g. blocking audio play, or python function) never stalls synthesis.
+        std::mutex lock;
+        std::condition_variable cond;
+        std::deque<std::vector<float>> chunks;
+        std::atomic<bool> stop{false};
+        bool done = false;
+        err::Err result = err::ERR_NONE;
+        double speed = _speed;
+        auto sens = split_sentence(text, 10, param->language);
+
+        std::thread worker([&]() {
+            err::Err e = err::ERR_NONE;
+            // exception must not leave thread(std::terminate), report it as error and still set done
+            try {
+                for (auto &se : sens) {
+                    e = _synthesize(param, speed, se, [&](const float *data, int len) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        chunks.emplace_back(data, data + len);
+                        cond.notify_one();
+                        return !stop.load();
+                    });
+                    if (e != err::ERR_NONE || stop || app::need_exit()) {
+                        break;
+                    }
+                }
+            } catch (const std::exception &ex) {
+                log::error("melotts synthesize exception: %s", ex.what());
+                e = err::ERR_RUNTIME;
+            } catch (...) {
+                log::error("melotts synthesize unknown exception");
+                e = err::ERR_RUNTIME;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            if (e != err::ERR_CANCEL) {
+                result = e;
+            }
+            done = true;
+            cond.notify_one();
+        });
+
+        std::vector<uint8_t> pcm;
+        bool cancelled = false;
+        while (true) {
+            std::vector<float> chunk;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                cond.wait(guard, [&] { return !chunks.empty() || done; });
+                if (chunks.empty()) {
+                    break;
+                }
+                chunk.swap(chunks.front());
+                chunks.pop_front();
+            }
+            pcm.resize(chunk.size() * sizeof(int16_t));
+            audio::from_float(chunk.data(), audio::FMT_S16_LE, pcm.data(), chunk.size());
+            Bytes out(pcm.data(), pcm.size(), false, false);
+            bool go_on;
+            try {
+                go_on = callback(&out);
+            } catch (...) {
+                // stop worker before exception leaves, a joinable std::thread destructed calls std::terminate
+                stop = true;
+                worker.join();
+                throw;
+            }
+            if (!go_on || app::need_exit()) {
+                stop = true;
+                cancelled = true;
+                break;
+            }
+        }
+        // result is written by worker, read it only after join
+        worker.join();
+        return cancelled ? err::ERR_CANCEL : result;
+    }
 } // namespace maix::nn
\ No newline at end of file
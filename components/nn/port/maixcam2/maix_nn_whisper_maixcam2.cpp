@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2024-
  * @license Apache 2.0
  * @update 2024.6.7: Add yolov8 support.
+ * @update 2026.10.18: Resample and downmix input pcm with audio::Converter.
+ * @update 2026.10.18: Add streaming transcription with VAD, reuse decode buffers across calls.
  */
 
 #include "maix_basic.hpp"
@@ -19,6 +21,7 @@
 #include "maix_nn_whisper.hpp"
 #include "uchardet.h"
 #include <iconv.h>
+#include <functional>
 
 namespace maix::nn
 {
@@ -143,7 +146,70 @@ namespace maix::nn
         return j;
     }
 
+    #define WHISPER_VAD_FRAME_MS     20
+    #define WHISPER_VAD_INIT_FRAMES  10     // frames used to estimate initial noise floor
+    #define WHISPER_VAD_START_FRAMES 3      // continuous voice frames to start utterance
+    #define WHISPER_VAD_PREROLL_MS   300    // audio kept before utterance start
+    #define WHISPER_VAD_MIN_SPEECH_MS 150   // utterances with less voice are dropped as clicks
+    #define WHISPER_VAD_MIN_DB       -55.0f // frames quieter than this are never voice
+
     namespace {
+        /**
+         * Energy based voice activity detection, like WebRTC VAD, noise floor is tracked,
+         * and a frame is voice if its energy is higher than noise floor by threshold.
+         */
+        class Vad {
+        public:
+            void reset(int frame_len, float threshold_db) {
+                _frame_len = frame_len;
+                _threshold_db = threshold_db;
+                _noise_db = 0;
+                _frames = 0;
+            }
+
+            bool process(const float *frame) {
+                float sum = 0;
+                for (int i = 0; i < _frame_len; i++) {
+                    sum += frame[i] * frame[i];
+                }
+                float db = 10.0f * std::log10(sum / _frame_len + 1e-12f);
+                if (_frames < WHISPER_VAD_INIT_FRAMES) {
+                    _noise_db = _frames == 0 ? db : std::min(_noise_db, db);
+                    _frames++;
+                    return false;
+                }
+                bool voice = db > _noise_db + _threshold_db && db > WHISPER_VAD_MIN_DB;
+                // fall fast and rise slowly, still follow rising noise during voice
+                float alpha = voice ? 0.005f : (db < _noise_db ? 0.2f : 0.02f);
+                _noise_db += alpha * (db - _noise_db);
+                return voice;
+            }
+
+        private:
+            int _frame_len = 0;
+            float _threshold_db = 12.0f;
+            float _noise_db = 0;
+            int _frames = 0;
+        };
+
+        class WhisperStream {
+        public:
+            bool started = false;
+            std::function<void(std::string, bool)> callback;
+            std::unique_ptr<audio::Converter> converter;
+            Vad vad;
+            std::vector<float> converted;   // converter output
+            std::vector<float> input;       // model sample rate pcm not processed by vad yet
+            std::vector<float> preroll;     // recent audio before utterance start
+            std::vector<float> segment;     // current utterance
+            bool in_speech = false;
+            int frame_len = 0;
+            int silence_frames = 0;         // silence frames to close utterance
+            int voice_run = 0;
+            int silence_run = 0;
+            int voice_frames = 0;
+        };
+
         class WhisperParam {
         public:
             nn::NN *encoder_model;
@@ -160,6 +226,16 @@ namespace maix::nn
             int n_text_state;
             std::map<string, string> extra_info;
             std::unique_ptr<opencc::SimpleConverter> simple_converter;
+
+            // buffers reused by every transcription
+            std::vector<float> pcm;
+            std::vector<float> mel;
+            std::vector<float> logits;
+            std::vector<float> mask;
+            std::vector<int> results;
+            std::vector<int> tokens;
+
+            WhisperStream stream;
         };
     }
 
@@ -615,122 +691,45 @@ namespace maix::nn
     };
 
 
-    /**
-     * Transcribe pcm data to text
-     * @param pcm RAW data
-     * @return The output result after automatic speech recognition.
-     * @maixpy maix.nn.Whisper.transcribe_raw
-    */
-    std::string Whisper::transcribe_raw(Bytes *pcm, int sample_rate, int channels, int bits_per_frame) {
+    static std::string _transcribe(WhisperParam *param, int sample_rate) {
         err::Err err = err::ERR_NONE;
-        if (!pcm || pcm->data_len == 0) {
-            log::info("pcm data is empty");
-            return "";
-        }
+        const int max_frames = WHISPER_CHUNK_SIZE * sample_rate / param->n_hop;   // fixed encoder input length
+        auto mel = librosa_simple::Feature::melspectrogram(param->pcm, sample_rate, param->n_fft, param->n_hop, "hann", true, "reflect", 2.0f, param->n_mels, 0.0f, sample_rate / 2);
+        int n_len = std::min((int)mel[0].size(), max_frames);
 
-        WhisperParam *param = (WhisperParam *) _extra_param;
-        if (sample_rate != _input_pcm_samplerate) {
-            log::error("wav sample rate not match, must be %d!", _input_pcm_samplerate);
-            return "";
-        }
-
-        int bytes_per_frame = bits_per_frame * channels / 8;
-        int num_of_samples = pcm->data_len / bytes_per_frame;
-        std::vector<float> pcm_data(num_of_samples);
-        for (int i = 0; i < num_of_samples; i ++) {
-            uint8_t *data = pcm->data + i * bytes_per_frame;
-            switch (bits_per_frame) {
-            case 8:
-            {
-                pcm_data[i] = (float)(data[0] - 128) / 128.;
-                break;
-            }
-            case 16:
-            {
-                int16_t result = ((int16_t)data[1] << 8) | data[0];
-                pcm_data[i] = (float)result / 32768.;
-                break;
-            }
-            case 24:
-            {
-                int32_t result = ((int32_t)data[2] << 16) | ((int32_t)data[1] << 8) | data[0];
-                if (result & 0x800000) {
-                    result = result | ~0xFFFFFF;
-                }
-                pcm_data[i] = (float)(result) / 8388608.;
-                break;
-            }
-            case 32:
-            {
-                int32_t result = ((int32_t)data[3] << 24) | ((int32_t)data[2] << 16) | ((int32_t)data[1] << 8) | data[0];
-                pcm_data[i] = (float)(result) / 2147483648.;
-                break;
-            }
-            default:
-                log::error("unsupported sample bit %d", bits_per_frame);
-                return "";
-            }
-        }
-        // print_test("pcm_data_F", (float *)pcm_data.data(), pcm_data.size(), 100);
-        // print_test("pcm_data", (uint8_t *)pcm->data, pcm->data_len, 100);
-        auto mel = librosa_simple::Feature::melspectrogram(pcm_data, _input_pcm_samplerate, param->n_fft, param->n_hop, "hann", true, "reflect", 2.0f, param->n_mels, 0.0f, _input_pcm_samplerate / 2);
-        int n_mel = mel.size();
-        int n_len = mel[0].size();
-
-        // clamping and normalization
-        double mmax = -1e20;
+        // clamping and normalization, frames after input are padded with 0
+        float mmax = -1e20;
         for (int i = 0; i < WHISPER_N_MELS; i++) {
             for (int n = 0; n < n_len; n++) {
                 mel[i][n] = std::log10(std::max(mel[i][n], 1e-10f));
-
                 if (mel[i][n] > mmax) {
-                    mmax = mel[i][n] ;
+                    mmax = mel[i][n];
                 }
             }
         }
-
+        param->mel.assign(WHISPER_N_MELS * max_frames, 0);
         for (int i = 0; i < WHISPER_N_MELS; i++) {
+            float *out = param->mel.data() + i * max_frames;
             for (int n = 0; n < n_len; n++) {
-                mel[i][n] = (std::max(mel[i][n], (float)(mmax - 8.0)) + 4.0)/4.0;
-                mel[i].resize(3000);
+                out[n] = (std::max(mel[i][n], mmax - 8.0f) + 4.0f) / 4.0f;
             }
         }
 
-        n_len = mel[0].size();
-
         int offset = 0;
-        std::vector<float> logits(WHISPER_VOCAB_SIZE);
         int max_token_id = -1;
-        std::vector<int> results;
-        std::vector<int> tokens(1);
-
-        auto encoder_outputs_info0 = param->encoder_model->outputs_info()[0];
-        auto encoder_outputs_info1 = param->encoder_model->outputs_info()[1];
-        auto encoder_ouptut_size0 = encoder_outputs_info0.shape_int() * tensor::dtype_size[encoder_outputs_info0.dtype];
-        auto encoder_ouptut_size1 = encoder_outputs_info0.shape_int() * tensor::dtype_size[encoder_outputs_info1.dtype];
-
-        auto decoder_main_outputs_info1 = param->decoder_main_model->outputs_info()[1];
-        auto decoder_main_outputs_info2 = param->decoder_main_model->outputs_info()[2];
-        auto decoder_main_ouptut_size1 = decoder_main_outputs_info1.shape_int() * tensor::dtype_size[decoder_main_outputs_info1.dtype];
-        auto decoder_main_ouptut_size2 = decoder_main_outputs_info2.shape_int() * tensor::dtype_size[decoder_main_outputs_info2.dtype];
-
-        std::vector<float> n_layer_cross_k(encoder_ouptut_size0 / sizeof(float));
-        std::vector<float> n_layer_cross_v(encoder_ouptut_size1 / sizeof(float));
-
-        std::vector<float> decoder_main_logits(4 * WHISPER_VOCAB_SIZE);
-        std::vector<float> n_layer_self_k_cache(decoder_main_ouptut_size1 / sizeof(float));
-        std::vector<float> n_layer_self_v_cache(decoder_main_ouptut_size2 / sizeof(float));
+        param->logits.resize(WHISPER_VOCAB_SIZE);
+        param->mask.assign(WHISPER_N_TEXT_CTX, 0);
+        param->results.clear();
+        param->tokens.resize(1);
+        std::vector<float> &logits = param->logits;
+        std::vector<float> &mask = param->mask;
+        std::vector<int> &results = param->results;
+        std::vector<int> &tokens = param->tokens;
 
         // encoder
-        std::vector<float> continous_mel(WHISPER_N_MELS * n_len);
-        for (int i = 0; i < n_mel; i++) {
-            memcpy(continous_mel.data() + i * n_len, mel[i].data(), sizeof(float) * n_len);
-        }
-
-        // print_test(">>>>>>>>>>>>>>>>> Encoder input 0", (float *)continous_mel.data(), continous_mel.size());
-        auto encoder_input_tensor = new tensor::Tensor({1, 80, 3000}, tensor::DType::FLOAT32, continous_mel.data(), false);
+        auto encoder_input_tensor = new tensor::Tensor({1, WHISPER_N_MELS, max_frames}, tensor::DType::FLOAT32, param->mel.data(), false);
         tensor::Tensors encoder_input_tensors, encoder_output_tensors;
-        encoder_input_tensors.add_tensor("mel", encoder_input_tensor, true, true);
+        encoder_input_tensors.add_tensor("mel", encoder_input_tensor, false, true);
         if ( err::ERR_NONE != (err = param->encoder_model->forward(encoder_input_tensors, encoder_output_tensors, false, true))) {
             log::error("encoder forward failed! err:%d", err);
             return "";
@@ -738,13 +737,11 @@ namespace maix::nn
 
         SOT_SEQUENCE[1] = detect_language(param->language);
 
-        // print_test(">>>>>>>>>>>>>>>>> Decoder main input 0", (int *)SOT_SEQUENCE.data(), SOT_SEQUENCE.size());
-        // print_test(">>>>>>>>>>>>>>>>> Decoder main input 1", (float *)encoder_output_tensors[0].data(), encoder_output_tensors[0].size_int());
-        // print_test(">>>>>>>>>>>>>>>>> Decoder main input 2", (float *)encoder_output_tensors[1].data(), encoder_output_tensors[1].size_int());
+        // decoder main, cross attention k/v are used from encoder output directly
         auto decoder_main_input_tensor0 = new tensor::Tensor({1, 4}, tensor::DType::INT32, SOT_SEQUENCE.data(), false);
         auto decoder_main_input_tensor1 = new tensor::Tensor({6, 1, 1500, 512}, tensor::DType::FLOAT32, encoder_output_tensors[0].data(), false);
         auto decoder_main_input_tensor2 = new tensor::Tensor({6, 1, 1500, 512}, tensor::DType::FLOAT32, encoder_output_tensors[1].data(), false);
-        tensor::Tensors decoder_main_input_tensors, decoder_main_input_tensors2,decoder_main_output_tensors;
+        tensor::Tensors decoder_main_input_tensors, decoder_main_output_tensors;
         decoder_main_input_tensors.add_tensor("tokens", decoder_main_input_tensor0, false, true);
         decoder_main_input_tensors.add_tensor("n_layer_cross_k", decoder_main_input_tensor1, false, true);
         decoder_main_input_tensors.add_tensor("n_layer_cross_v", decoder_main_input_tensor2, false, true);
@@ -753,13 +750,13 @@ namespace maix::nn
             return "";
         }
 
-        memcpy(decoder_main_logits.data(), decoder_main_output_tensors[0].data(), decoder_main_output_tensors[0].size_int() * tensor::dtype_size[decoder_main_output_tensors[0].dtype()]);
+        // only logits of last sot token are used
+        const float *decoder_main_logits = (const float *)decoder_main_output_tensors[0].data();
+        memcpy(logits.data(), decoder_main_logits + (SOT_SEQUENCE.size() - 1) * WHISPER_VOCAB_SIZE, WHISPER_VOCAB_SIZE * sizeof(float));
         offset += SOT_SEQUENCE.size();
-        std::copy(decoder_main_logits.begin() + 3 * WHISPER_VOCAB_SIZE, decoder_main_logits.end(), logits.begin());
         supress_tokens(logits, true);
         max_token_id = argmax(logits);
 
-        std::vector<float> mask(WHISPER_N_TEXT_CTX);
         for (int n = 0; n < WHISPER_N_TEXT_CTX - offset - 1; n++) {
             mask[n] = NEG_INF;
         }
@@ -832,22 +829,199 @@ namespace maix::nn
         for (const auto i : results) {
             char str[1024] = {0};
             base64_decode((const uint8_t*)param->token_tables[i].c_str(), (uint32_t)param->token_tables[i].size(), str);
-            auto new_str = std::string(str);
-            // if (!isValidUTF8(new_str)) {
-            //     continue;
-            // }
-            s += new_str;
+            s += str;
         }
 
         if (param->language == "zh") {
             s = param->simple_converter->Convert(s);
         }
 
-        // auto t = time::ticks_ms();
         auto charset = _detect_charset(s);
-        if (charset != "utf-8") {
+        if (!s.empty() && charset != "utf-8") {
             s = _convert_to_utf8(s, charset);
         }
         return s;
     }
-} // namespace maix::nn
\ No newline at end of file
+
+    static err::Err _pcm_format(int bits_per_frame, audio::Format &format) {
+        switch (bits_per_frame) {
+        case 8: format = audio::FMT_U8; break;
+        case 16: format = audio::FMT_S16_LE; break;
+        case 24: format = audio::FMT_S24_LE; break;
+        case 32: format = audio::FMT_S32_LE; break;
+        default:
+            log::error("unsupported sample bit %d", bits_per_frame);
+            return err::ERR_ARGS;
+        }
+        return err::ERR_NONE;
+    }
+
+    /**
+     * Transcribe pcm data to text
+     * @param pcm RAW data
+     * @return The output result after automatic speech recognition.
+     * @maixpy maix.nn.Whisper.transcribe_raw
+    */
+    std::string Whisper::transcribe_raw(Bytes *pcm, int sample_rate, int channels, int bits_per_frame) {
+        if (!pcm || pcm->data_len == 0) {
+            log::info("pcm data is empty");
+            return "";
+        }
+
+        WhisperParam *param = (WhisperParam *) _extra_param;
+        audio::Format format;
+        if (_pcm_format(bits_per_frame, format) != err::ERR_NONE) {
+            return "";
+        }
+        if (sample_rate <= 0 || channels <= 0) {
+            log::error("invalid sample rate %d or channels %d", sample_rate, channels);
+            return "";
+        }
+
+        // downmix to mono and resample to model input sample rate
+        std::vector<float> pcm_tail;
+        audio::Converter converter(sample_rate, format, channels, _input_pcm_samplerate, audio::FMT_F32_LE, 1);
+        if (converter.process_float(pcm->data, pcm->data_len, param->pcm) < 0) {
+            log::error("convert pcm data failed");
+            return "";
+        }
+        converter.flush_float(pcm_tail);
+        param->pcm.insert(param->pcm.end(), pcm_tail.begin(), pcm_tail.end());
+        return _transcribe(param, _input_pcm_samplerate);
+    }
+
+    static void _stream_emit(WhisperParam *param, int sample_rate, bool is_final) {
+        WhisperStream &st = param->stream;
+        if (st.voice_frames * WHISPER_VAD_FRAME_MS >= WHISPER_VAD_MIN_SPEECH_MS) {
+            param->pcm.assign(st.segment.begin(), st.segment.end());
+            auto text = _transcribe(param, sample_rate);
+            if (!text.empty() && st.callback) {
+                st.callback(text, is_final);
+            }
+        }
+        st.segment.clear();
+        st.voice_frames = 0;
+    }
+
+    err::Err Whisper::stream_start(std::function<void(std::string, bool)> callback, int sample_rate, int channels, int bits_per_frame, int silence_ms, float vad_threshold_db) {
+        WhisperParam *param = (WhisperParam *) _extra_param;
+        if (!param->encoder_model) {
+            log::error("model not loaded");
+            return err::ERR_NOT_READY;
+        }
+        audio::Format format;
+        err::Err e = _pcm_format(bits_per_frame, format);
+        if (e != err::ERR_NONE) {
+            return e;
+        }
+        if (sample_rate <= 0 || channels <= 0 || silence_ms <= 0) {
+            log::error("invalid sample rate %d, channels %d or silence_ms %d", sample_rate, channels, silence_ms);
+            return err::ERR_ARGS;
+        }
+
+        WhisperStream &st = param->stream;
+        st.converter.reset(new audio::Converter(sample_rate, format, channels, _input_pcm_samplerate, audio::FMT_F32_LE, 1));
+        st.callback = callback;
+        st.frame_len = _input_pcm_samplerate * WHISPER_VAD_FRAME_MS / 1000;
+        st.silence_frames = std::max(1, silence_ms / WHISPER_VAD_FRAME_MS);
+        st.vad.reset(st.frame_len, vad_threshold_db);
+        st.input.clear();
+        st.preroll.clear();
+        st.segment.clear();
+        st.segment.reserve(WHISPER_CHUNK_SIZE * _input_pcm_samplerate);
+        st.in_speech = false;
+        st.voice_run = 0;
+        st.silence_run = 0;
+        st.voice_frames = 0;
+        st.started = true;
+        return err::ERR_NONE;
+    }
+
+    static void _stream_process(WhisperParam *param, int sample_rate) {
+        WhisperStream &st = param->stream;
+        const size_t preroll_len = (size_t)sample_rate * WHISPER_VAD_PREROLL_MS / 1000;
+        const size_t max_len = (size_t)WHISPER_CHUNK_SIZE * sample_rate;
+        size_t pos = 0;
+        for (; pos + st.frame_len <= st.input.size(); pos += st.frame_len) {
+            const float *frame = st.input.data() + pos;
+            bool voice = st.vad.process(frame);
+            if (!st.in_speech) {
+                st.preroll.insert(st.preroll.end(), frame, frame + st.frame_len);
+                st.voice_run = voice ? st.voice_run + 1 : 0;
+                if (st.voice_run >= WHISPER_VAD_START_FRAMES) {
+                    st.in_speech = true;
+                    st.segment.assign(st.preroll.begin(), st.preroll.end());
+                    st.preroll.clear();
+                    st.voice_frames = st.voice_run;
+                    st.silence_run = 0;
+                } else if (st.preroll.size() > preroll_len) {
+                    st.preroll.erase(st.preroll.begin(), st.preroll.begin() + (st.preroll.size() - preroll_len));
+                }
+                continue;
+            }
+
+            st.segment.insert(st.segment.end(), frame, frame + st.frame_len);
+            if (voice) {
+                st.voice_frames++;
+                st.silence_run = 0;
+            } else if (++st.silence_run >= st.silence_frames) {
+                // utterance closed, drop trailing silence except preroll length
+                size_t trailing = (size_t)st.silence_run * st.frame_len;
+                if (trailing > preroll_len) {
+                    st.segment.resize(st.segment.size() - (trailing - preroll_len));
+                }
+                _stream_emit(param, sample_rate, true);
+                st.in_speech = false;
+                st.voice_run = 0;
+                continue;
+            }
+            if (st.segment.size() + st.frame_len > max_len) {
+                // reach max model input length, cut here and continue utterance
+                _stream_emit(param, sample_rate, false);
+            }
+        }
+        st.input.erase(st.input.begin(), st.input.begin() + pos);
+    }
+
+    err::Err Whisper::stream_feed(Bytes *pcm) {
+        WhisperParam *param = (WhisperParam *) _extra_param;
+        WhisperStream &st = param->stream;
+        if (!st.started) {
+            return err::ERR_NOT_READY;
+        }
+        if (!pcm || pcm->data_len == 0) {
+            return err::ERR_NONE;
+        }
+        int ret = st.converter->process_float(pcm->data, pcm->data_len, st.converted);
+        if (ret < 0) {
+            log::error("convert pcm data failed");
+            return (err::Err)-ret;
+        }
+        st.input.insert(st.input.end(), st.converted.begin(), st.converted.end());
+        _stream_process(param, _input_pcm_samplerate);
+        return err::ERR_NONE;
+    }
+
+    err::Err Whisper::stream_stop() {
+        WhisperParam *param = (WhisperParam *) _extra_param;
+        WhisperStream &st = param->stream;
+        if (!st.started) {
+            return err::ERR_NOT_READY;
+        }
+        st.converter->flush_float(st.converted);
+        st.input.insert(st.input.end(), st.converted.begin(), st.converted.end());
+        _stream_process(param, _input_pcm_samplerate);
+        if (st.in_speech) {
+            st.segment.insert(st.segment.end(), st.input.begin(), st.input.end());
+            _stream_emit(param, _input_pcm_samplerate, true);
+        }
+        st.started = false;
+        st.in_speech = false;
+        st.converter.reset();
+        st.callback = nullptr;
+        st.input.clear();
+        st.preroll.clear();
+        st.segment.clear();
+        return err::ERR_NONE;
+    }
+} // namespace maix::nn
@@ -295,16 +295,19 @@ namespace maix::nn
 
     err::Err NN::forward(tensor::Tensors &inputs, tensor::Tensors &outputs, bool copy_result, bool dual_buff_wait)
     {
+        MAIX_TRACE_SCOPE("nn.forward", "nn");
         return _impl->forward(inputs, outputs, copy_result, dual_buff_wait);
     }
 
     tensor::Tensors *NN::forward(tensor::Tensors &inputs, bool copy_result, bool dual_buff_wait)
     {
+        MAIX_TRACE_SCOPE("nn.forward", "nn");
         return _impl->forward(inputs, copy_result, dual_buff_wait);
     }
 
     tensor::Tensors *NN::forward_image(image::Image &img, std::vector<float> mean, std::vector<float> scale, image::Fit fit, bool copy_result, bool dual_buff_wait, bool chw)
     {
+        MAIX_TRACE_SCOPE("nn.forward_image", "nn");
         int input_w = 0;
         int input_h = 0;
         int input_c = 0;
@@ -0,0 +1,399 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add compiled and memory mapped TTS lexicon, create this file.
+ */
+
+#include "maix_nn_lexicon.hpp"
+#include "maix_nn_melotts.hpp"
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace maix::nn
+{
+    #define LEXICON_MAGIC   0x58454C4D  // "MLEX"
+    #define LEXICON_VERSION 1
+
+    typedef struct {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entries;
+        int32_t blank;          // token of unknown word
+        uint32_t trie_offset;
+        uint32_t trie_size;     // bytes
+        uint32_t values_offset;
+        uint32_t values_size;   // bytes
+    } lexicon_header_t;
+
+    // value of each word: uint8 phones_num, uint8 tones_num, int16 phones[phones_num], int8 tones[tones_num]
+
+    static std::vector<std::string> _split(const std::string &s, char delim)
+    {
+        std::vector<std::string> result;
+        std::stringstream ss(s);
+        std::string item;
+        while (getline(ss, item, delim)) {
+            result.push_back(item);
+        }
+        return result;
+    }
+
+    static std::vector<std::string> _split_each_char(const std::string &text)
+    {
+        std::vector<std::string> words;
+        int len = text.length();
+        int i = 0;
+        while (i < len) {
+            int next = 1;
+            if ((text[i] & 0xE0) == 0xC0) {
+                next = 2;
+            } else if ((text[i] & 0xF0) == 0xE0) {
+                next = 3;
+            } else if ((text[i] & 0xF8) == 0xF0) {
+                next = 4;
+            }
+            words.push_back(text.substr(i, next));
+            i += next;
+        }
+        return words;
+    }
+
+    static bool _is_english(const std::string &s)
+    {
+        return s.size() == 1 && ((s[0] >= 'A' && s[0] <= 'Z') || (s[0] >= 'a' && s[0] <= 'z'));
+    }
+
+    static std::vector<std::string> _merge_english(const std::vector<std::string> &splitted_text)
+    {
+        std::vector<std::string> words;
+        size_t i = 0;
+        while (i < splitted_text.size()) {
+            if (_is_english(splitted_text[i])) {
+                std::string s;
+                while (i < splitted_text.size() && _is_english(splitted_text[i])) {
+                    s += (char)std::tolower((unsigned char)splitted_text[i][0]);
+                    i++;
+                }
+                words.push_back(s);
+            } else {
+                words.push_back(splitted_text[i]);
+                i++;
+            }
+        }
+        return words;
+    }
+
+    static int64_t _mtime(const std::string &path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return -1;
+        return (int64_t)st.st_mtime;
+    }
+
+    Lexicon::Lexicon()
+    {
+    }
+
+    Lexicon::~Lexicon()
+    {
+        close();
+    }
+
+    void Lexicon::close()
+    {
+        _trie.clear();
+        if (_mapped && _data) {
+            munmap((void *)_data, _size);
+        }
+        _mapped = false;
+        _data = nullptr;
+        _size = 0;
+        _buffer.clear();
+        _buffer.shrink_to_fit();
+        _values = nullptr;
+        _values_size = 0;
+        _entries = 0;
+    }
+
+    err::Err Lexicon::_attach(const uint8_t *data, size_t size)
+    {
+        lexicon_header_t header;
+        if (size < sizeof(header)) {
+            return err::ERR_ARGS;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != LEXICON_MAGIC || header.version != LEXICON_VERSION
+            || (uint64_t)header.trie_offset + header.trie_size > size
+            || (uint64_t)header.values_offset + header.values_size > size
+            || header.trie_offset % 4 != 0) {
+            log::error("invalid compiled lexicon");
+            return err::ERR_ARGS;
+        }
+        _trie.set_array(data + header.trie_offset, header.trie_size / _trie.unit_size());
+        _values = data + header.values_offset;
+        _values_size = header.values_size;
+        _entries = header.entries;
+        _blank = header.blank;
+        return err::ERR_NONE;
+    }
+
+    err::Err Lexicon::open(const std::string &compiled_file)
+    {
+        close();
+        int fd = ::open(compiled_file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return err::ERR_NOT_FOUND;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(lexicon_header_t)) {
+            ::close(fd);
+            return err::ERR_ARGS;
+        }
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            log::error("mmap %s failed", compiled_file.c_str());
+            return err::ERR_IO;
+        }
+        _data = (const uint8_t *)addr;
+        _size = st.st_size;
+        _mapped = true;
+        err::Err e = _attach(_data, _size);
+        if (e != err::ERR_NONE) {
+            close();
+        }
+        return e;
+    }
+
+    err::Err Lexicon::compile(const std::string &lexicon_file, const std::string &tokens_file, const std::string &out_file, std::vector<uint8_t> *data)
+    {
+        std::map<std::string, int> tokens;
+        std::ifstream ifs(tokens_file);
+        if (!ifs.is_open()) {
+            log::error("open %s failed", tokens_file.c_str());
+            return err::ERR_NOT_FOUND;
+        }
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            auto splitted_line = _split(line, ' ');
+            if (splitted_line.size() < 2)
+                continue;
+            tokens[splitted_line[0]] = std::atoi(splitted_line[1].c_str());
+        }
+        ifs.close();
+
+        // sorted map, keys must be sorted to build trie
+        std::map<std::string, std::pair<std::vector<int>, std::vector<int>>> lexicon;
+        ifs.open(lexicon_file);
+        if (!ifs.is_open()) {
+            log::error("open %s failed", lexicon_file.c_str());
+            return err::ERR_NOT_FOUND;
+        }
+        while (std::getline(ifs, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            auto splitted_line = _split(line, ' ');
+            if (splitted_line.size() < 1 || splitted_line[0].empty())
+                continue;
+            size_t phone_tone_len = splitted_line.size() - 1;
+            size_t half_len = phone_tone_len / 2;
+            std::vector<int> phones, tones;
+            for (size_t i = 0; i < phone_tone_len; i++) {
+                auto &phone_or_tone = splitted_line[i + 1];
+                if (i < half_len) {
+                    phones.push_back(tokens[phone_or_tone]);
+                } else {
+                    tones.push_back(std::atoi(phone_or_tone.c_str()));
+                }
+            }
+            lexicon.insert({splitted_line[0], std::make_pair(phones, tones)});
+        }
+        ifs.close();
+
+        lexicon["呣"] = lexicon["母"];
+        lexicon["嗯"] = lexicon["恩"];
+        const std::vector<std::string> punctuation{"!", "?", "…", ",", ".", "'", "-"};
+        for (auto &p : punctuation) {
+            lexicon[p] = std::make_pair(std::vector<int>{tokens[p]}, std::vector<int>{0});
+        }
+        int blank = tokens["_"];
+        lexicon[" "] = std::make_pair(std::vector<int>{blank}, std::vector<int>{0});
+
+        // pack values
+        std::vector<uint8_t> values;
+        std::vector<const char *> keys;
+        std::vector<size_t> lengths;
+        std::vector<Darts::DoubleArray::value_type> offsets;
+        keys.reserve(lexicon.size());
+        lengths.reserve(lexicon.size());
+        offsets.reserve(lexicon.size());
+        for (auto &item : lexicon) {
+            auto &phones = item.second.first;
+            auto &tones = item.second.second;
+            if (phones.size() > 255 || tones.size() > 255) {
+                log::warn("lexicon word %s too long, skip", item.first.c_str());
+                continue;
+            }
+            keys.push_back(item.first.c_str());
+            lengths.push_back(item.first.size());
+            offsets.push_back((int)values.size());
+            values.push_back((uint8_t)phones.size());
+            values.push_back((uint8_t)tones.size());
+            for (int p : phones) {
+                int16_t v = (int16_t)p;
+                values.insert(values.end(), (uint8_t *)&v, (uint8_t *)&v + sizeof(v));
+            }
+            for (int t : tones) {
+                values.push_back((uint8_t)(int8_t)t);
+            }
+        }
+        Darts::DoubleArray trie;
+        try {
+            if (trie.build(keys.size(), keys.data(), lengths.data(), offsets.data()) != 0) {
+                log::error("build lexicon trie failed");
+                return err::ERR_RUNTIME;
+            }
+        } catch (const std::exception &e) {
+            log::error("build lexicon trie failed: %s", e.what());
+            return err::ERR_RUNTIME;
+        }
+
+        lexicon_header_t header = {
+            .magic = LEXICON_MAGIC,
+            .version = LEXICON_VERSION,
+            .entries = (uint32_t)keys.size(),
+            .blank = blank,
+            .trie_offset = sizeof(lexicon_header_t),
+            .trie_size = (uint32_t)trie.total_size(),
+            .values_offset = (uint32_t)(sizeof(lexicon_header_t) + trie.total_size()),
+            .values_size = (uint32_t)values.size(),
+        };
+        std::vector<uint8_t> out(header.values_offset + header.values_size);
+        memcpy(out.data(), &header, sizeof(header));
+        memcpy(out.data() + header.trie_offset, trie.array(), header.trie_size);
+        memcpy(out.data() + header.values_offset, values.data(), values.size());
+
+        err::Err ret = err::ERR_NONE;
+        if (!out_file.empty()) {
+            // write to temp file then rename, another process may be mapping the old one
+            std::string tmp = out_file + ".tmp";
+            FILE *fp = fopen(tmp.c_str(), "wb");
+            if (!fp || fwrite(out.data(), 1, out.size(), fp) != out.size()) {
+                log::warn("write compiled lexicon %s failed", tmp.c_str());
+                ret = err::ERR_IO;
+            }
+            if (fp) {
+                fclose(fp);
+            }
+            if (ret == err::ERR_NONE && rename(tmp.c_str(), out_file.c_str()) != 0) {
+                ret = err::ERR_IO;
+            }
+            if (ret != err::ERR_NONE) {
+                unlink(tmp.c_str());
+            }
+        }
+        if (data) {
+            data->swap(out);
+        }
+        return ret;
+    }
+
+    err::Err Lexicon::load(const std::string &lexicon_file, const std::string &tokens_file)
+    {
+        std::string compiled_file = lexicon_file + ".bin";
+        int64_t compiled_time = _mtime(compiled_file);
+        if (compiled_time >= 0 && compiled_time >= _mtime(lexicon_file) && compiled_time >= _mtime(tokens_file)) {
+            if (open(compiled_file) == err::ERR_NONE) {
+                return err::ERR_NONE;
+            }
+            log::warn("compiled lexicon %s invalid, compile again", compiled_file.c_str());
+        }
+        close();
+        log::info("compile lexicon to %s", compiled_file.c_str());
+        // compile to local buffer, open() calls close() which clears _buffer
+        std::vector<uint8_t> compiled;
+        err::Err e = compile(lexicon_file, tokens_file, compiled_file, &compiled);
+        if (e == err::ERR_NONE && open(compiled_file) == err::ERR_NONE) {
+            return err::ERR_NONE;
+        }
+        if (compiled.empty()) {
+            return e == err::ERR_NONE ? err::ERR_RUNTIME : e;
+        }
+        // can't save or map file, use compiled data in memory
+        log::warn("use compiled lexicon in memory");
+        close();
+        _buffer.swap(compiled);
+        _data = _buffer.data();
+        _size = _buffer.size();
+        return _attach(_data, _size);
+    }
+
+    bool Lexicon::lookup(const std::string &word, std::vector<int> &phones, std::vector<int> &tones) const
+    {
+        if (!_values || word.empty()) {
+            return false;
+        }
+        int offset = _trie.exactMatchSearch<Darts::DoubleArray::value_type>(word.c_str(), word.size());
+        if (offset < 0 || (size_t)offset + 2 > _values_size) {
+            return false;
+        }
+        const uint8_t *p = _values + offset;
+        int phones_num = p[0], tones_num = p[1];
+        p += 2;
+        if ((size_t)(p - _values) + phones_num * 2 + tones_num > _values_size) {
+            return false;
+        }
+        for (int i = 0; i < phones_num; i++, p += 2) {
+            int16_t v;
+            memcpy(&v, p, sizeof(v));
+            phones.push_back(v);
+        }
+        for (int i = 0; i < tones_num; i++, p++) {
+            tones.push_back((int8_t)*p);
+        }
+        return true;
+    }
+
+    void Lexicon::convert(const std::string &text, std::vector<int> &phones, std::vector<int> &tones, std::vector<int> &word2ph) const
+    {
+        auto zh_mix_en = _merge_english(_split_each_char(text));
+        for (auto &c : zh_mix_en) {
+            std::string s{c};
+            if (s == "，")
+                s = ",";
+            else if (s == "。")
+                s = ".";
+            else if (s == "！")
+                s = "!";
+            else if (s == "？")
+                s = "?";
+
+            size_t count = phones.size();
+            if (!lookup(s, phones, tones)) {
+                phones.push_back(_blank);
+                tones.push_back(0);
+            }
+            word2ph.push_back(phones.size() - count);
+        }
+    }
+
+    int Lexicon::size() const
+    {
+        return _entries;
+    }
+
+    err::Err MeloTTS::compile_lexicon(const std::string &lexicon, const std::string &tokens, const std::string &out)
+    {
+        return Lexicon::compile(lexicon, tokens, out.empty() ? lexicon + ".bin" : out);
+    }
+} // namespace maix::nn
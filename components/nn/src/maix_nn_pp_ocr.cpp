@@ -1,6 +1,7 @@
 #include "maix_nn_pp_ocr.hpp"
 #include "pp_ocr_postprocess_op.h"
 #include <omp.h>
+#include <algorithm>
 
 namespace maix::nn
 {
@@ -35,67 +36,81 @@ namespace maix::nn
         h = h - y;
     }
 
+    // detection post process buffers, reused across frames, one set per thread
+    struct DetBuffers
+    {
+        PaddleOCR::DBPostProcessor post_processor;
+        cv::Mat bit_map;
+        std::vector<std::array<cv::Point, 4>> boxes;
+        std::vector<float> scores;
+    };
+    static thread_local DetBuffers _det_buffers;
+
+    // one slice of a text line, model input width at most
+    struct RecSlice
+    {
+        int obj_idx;
+        int slice_idx;
+        cv::Mat img;
+        std::vector<int> max_idxes;
+    };
+
+    // recognize buffers, reused across frames, one set per thread
+    struct RecBuffers
+    {
+        std::vector<cv::Mat> lines;
+        std::vector<RecSlice> slices;
+        std::vector<int> order;
+        cv::Mat padded;
+        std::vector<float> batch_input;
+    };
+    static thread_local RecBuffers _rec_buffers;
+
     nn::OCR_Objects *PP_OCR::_post_process(image::Image &img, tensor::Tensors *outputs, int img_w, int img_h, maix::image::Fit fit)
     {
+        MAIX_TRACE_SCOPE("pp_ocr.post_process", "nn");
         nn::OCR_Objects *objects = new nn::OCR_Objects();
-        // int layer_num = outputs->size();
-        // int i = 0;
         for (auto it = outputs->begin(); it != outputs->end(); it++)
         {
-        //     // log::info("output: %s, tensor: %s", it->first.c_str(), it->second->to_str().c_str());
-        //     _get_layer_objs(*objects, *it->second, i++, layer_num);
             tensor::Tensor *out = it->second;
             std::vector<int> shape = out->shape(); // 1, 1, h, w
-            image::Image *tmp_img = new image::Image(shape[3], shape[2], image::Format::FMT_GRAYSCALE);
             float *data = (float*)out->data();
-            float *p_data = data;
-            uint8_t *img_data = (uint8_t*)tmp_img->data();
-            uint8_t *p_img_data = img_data;
-            cv::Mat bit_map(shape[2], shape[3], CV_8UC1);
-            uint8_t *p_binary_data = (uint8_t*)bit_map.data;
+            DetBuffers &buf = _det_buffers;
+            buf.bit_map.create(shape[2], shape[3], CV_8UC1);
+            uint8_t *p_binary_data = (uint8_t*)buf.bit_map.data;
             uint8_t _thresh_uint8 = (uint8_t)(_thresh * 255);
-            #pragma omp parallel for
-            for(int i=0; i < shape[3] * shape[2]; ++i)
-            {
-                p_img_data[i] = (uint8_t)(p_data[i] * 255);
-                if(p_img_data[i] > _thresh_uint8)
-                    p_binary_data[i] = 1;
-                else
-                    p_binary_data[i] = 0;
-            }
+            thread::Pool::global().parallel_for(0, shape[3] * shape[2], [&](int start, int end) {
+                for(int i = start; i < end; ++i)
+                {
+                    p_binary_data[i] = (uint8_t)(data[i] * 255) > _thresh_uint8 ? 1 : 0;
+                }
+            }, 4096);
 
             // post process
-            PaddleOCR::DBPostProcessor post_processor;
-            cv::Mat cbuf_map(shape[2], shape[3], CV_8UC1, img_data);
             cv::Mat pred_map(shape[2], shape[3], CV_32F, data);
             if (_use_dilation) {
                 cv::Mat dila_ele = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2, 2));
-                cv::dilate(bit_map, bit_map, dila_ele);
+                cv::dilate(buf.bit_map, buf.bit_map, dila_ele);
             }
-            std::vector<float> scores;
-            std::vector<std::vector<std::vector<int>>> boxes = post_processor.BoxesFromBitmap(pred_map, bit_map, _box_thresh, _unclip_ratio, _score_mode, scores);
-            for(size_t i = 0; i < boxes.size(); ++i)
+            buf.post_processor.BoxesFromBitmap(pred_map, buf.bit_map, _box_thresh, _unclip_ratio, _score_mode, buf.boxes, buf.scores);
+            std::vector<int> idxes;
+            std::vector<std::string> chars;
+            std::vector<int> char_pos;
+            for(size_t i = 0; i < buf.boxes.size(); ++i)
             {
-                nn::OCR_Box box(boxes[i][0][0], boxes[i][0][1], boxes[i][1][0], boxes[i][1][1], boxes[i][2][0], boxes[i][2][1], boxes[i][3][0], boxes[i][3][1]);
-                std::vector<int> idxes;
-                std::vector<std::string> chars;
-                std::vector<int> char_pos;
-                objects->add(box, idxes, chars, scores[i], char_pos);
+                const std::array<cv::Point, 4> &b = buf.boxes[i];
+                nn::OCR_Box box(b[0].x, b[0].y, b[1].x, b[1].y, b[2].x, b[2].y, b[3].x, b[3].y);
+                objects->add(box, idxes, chars, buf.scores[i], char_pos);
             }
-            delete tmp_img;
 
             // correct boxes
             if(objects->size() > 0)
                 _correct_bbox(*objects, img_w, img_h, fit);
-            // recognize charactors
-            for(size_t i = 0; i < boxes.size(); ++i)
+            // recognize charactors of all boxes
+            if(_rec_model && objects->size() > 0)
             {
-                // int x, y, w, h;
-                // _get_external_box(boxes[i], x, y, w, h, shape[3], shape[2]);
-                std::vector<std::string> char_list;
-                nn::OCR_Object &obj = objects->at(i);
-                _recognize(img, obj.box, obj.idx_list, char_list, obj.char_pos, true);
-                obj.update_chars(char_list);
+                std::vector<nn::OCR_Object *> objs(objects->begin(), objects->end());
+                _recognize(img, objs, true);
             }
             break;
         }
@@ -103,60 +118,40 @@ namespace maix::nn
         return objects;
     }
 
-    static void _recognize_stdimg(nn::NN *_rec_model, image::Image &std_img, std::vector<float> &mean, std::vector<float> &scale, std::vector<int> &max_idxes, const int &_max_ch_num, const int &_prob_num)
+    static void _argmax_steps(const float *data, int max_ch_num, int prob_num, std::vector<int> &max_idxes)
     {
-        // foward image
-        tensor::Tensors *outputs;
-        outputs = _rec_model->forward_image(std_img, mean, scale, image::Fit::FIT_FILL, true);
-        if (!outputs) // not happen here
+        max_idxes.resize(max_ch_num);
+        #pragma omp parallel for
+        for(int i = 0; i < max_ch_num; ++i)
         {
-            throw err::Exception(err::ERR_RUNTIME);
-        }
-
-        // rec postprocess, outputs shape: _max_ch_num x (_prob_num)
-        // get all max prob, totally _max_ch_num sections,
-        // then remove dumplicate and empty section, get charactors store in chars var.
-        for (auto it = outputs->begin(); it != outputs->end(); it++)
-        {
-            tensor::Tensor *out = it->second;
-            float *data = (float*)out->data();
-            float max_score;
-            #pragma omp parallel for
-            for(int i = 0; i < _max_ch_num; ++i)
+            const float *p_data = data + i * prob_num;
+            float max_score = p_data[0];
+            int max_idx = 0;
+            for(int j = 1; j < prob_num; ++j)
             {
-                float *p_data = data + i * _prob_num;
-                max_score = p_data[0];
-                max_idxes[i] = 0;
-                for(int j = 1; j < _prob_num; ++j)
+                if(p_data[j] > max_score)
                 {
-                    if(p_data[j] > max_score)
-                    {
-                        max_score = p_data[j];
-                        max_idxes[i] = j;
-                    }
+                    max_score = p_data[j];
+                    max_idx = j;
                 }
             }
-            break;
+            max_idxes[i] = max_idx;
         }
-        delete outputs;
     }
 
-    void PP_OCR::_recognize(image::Image &img, const nn::OCR_Box &box, std::vector<int> &idx_list, std::vector<std::string> &char_list, std::vector<int> &char_pos, bool crop)
+    // crop box with perspective transform, rotate vertical text, resize to model input height keep ratio
+    static void _warp_line(const cv::Mat &img_src, const nn::OCR_Box &box, bool crop, int dst_h, cv::Mat &line)
     {
-        idx_list.clear();
-        char_list.clear();
-        cv::Mat img_src(img.height(), img.width(), CV_8UC3, img.data());
-        cv::Mat *std_img = &img_src;
+        const cv::Mat *std_img = &img_src;
         cv::Mat img_dst;
-        cv::Mat srcCopy;
+        cv::Mat src_copy;
         if(crop)
         {
-            // crop and get std
             cv::Point2f pts_std[4];
-            int img_crop_width = int(sqrt(pow(box.x1 - box.x2, 2) +
-                                    pow(box.y1 - box.y2, 2)));
-            int img_crop_height = int(sqrt(pow(box.x1 - box.x4, 2) +
-                                            pow(box.y1 - box.y4, 2)));
+            int img_crop_width = std::max(1, int(sqrt(pow(box.x1 - box.x2, 2) +
+                                    pow(box.y1 - box.y2, 2))));
+            int img_crop_height = std::max(1, int(sqrt(pow(box.x1 - box.x4, 2) +
+                                            pow(box.y1 - box.y4, 2))));
             pts_std[0] = cv::Point2f(0., 0.);
             pts_std[1] = cv::Point2f(img_crop_width, 0.);
             pts_std[2] = cv::Point2f(img_crop_width, img_crop_height);
@@ -172,85 +167,145 @@ namespace maix::nn
                         cv::BORDER_REPLICATE);
             std_img = &img_dst;
             if (float(img_dst.rows) >= float(img_dst.cols) * 1.5) {
-                srcCopy = cv::Mat(img_dst.rows, img_dst.cols, img_dst.depth());
-                cv::transpose(img_dst, srcCopy);
-                cv::flip(srcCopy, srcCopy, 0);
-                std_img = &srcCopy;
+                cv::transpose(img_dst, src_copy);
+                cv::flip(src_copy, src_copy, 0);
+                std_img = &src_copy;
             }
         }
-
-        // resize pad image to model input size(_rec_input_size) like 320x48
-        // keep ratio resize image's height to _rec_input_size.height(),
-        // if new image width > _rec_input_size.width()， resize new image width to _rec_input_size.width(), padding black color at bottom,
-        // else if new image width < _rec_input_size.width(), keep new image content at left, right padding black color.
-        // finally we got _rec_input_size image
         float aspect_ratio = float(std_img->cols) / float(std_img->rows);
-        cv::Mat resized_img;
-        // Height is the limiting factor
-        cv::resize(*std_img, resized_img, cv::Size(static_cast<int>(_rec_input_size.height() * aspect_ratio),
-                    _rec_input_size.height()));
-        if (aspect_ratio > float(_rec_input_size.width()) / float(_rec_input_size.height())) {
-            // Width > input width
-            // slice and recognize
-            for(int i = 0; i < std::ceil((float)resized_img.cols / _rec_input_size.width()); ++i)
+        int dst_w = std::max(1, static_cast<int>(dst_h * aspect_ratio));
+        cv::resize(*std_img, line, cv::Size(dst_w, dst_h));
+    }
+
+    void PP_OCR::_recognize(image::Image &img, std::vector<nn::OCR_Object *> &objs, bool crop)
+    {
+        MAIX_TRACE_SCOPE("pp_ocr.recognize", "nn");
+        RecBuffers &buf = _rec_buffers;
+        const int in_w = _rec_input_size.width();
+        const int in_h = _rec_input_size.height();
+        cv::Mat img_src(img.height(), img.width(), CV_8UC3, img.data());
+
+        // 1. warp all boxes in one pass
+        buf.lines.resize(objs.size());
+        thread::Pool::global().parallel_for(0, objs.size(), [&](int start, int end) {
+            for(int i = start; i < end; ++i)
             {
-                // crop
-                cv::Mat crop_img = resized_img(cv::Rect(i * _rec_input_size.width(), 0, std::min(_rec_input_size.width(), resized_img.cols - i * _rec_input_size.width()), resized_img.rows));
-                cv::Mat final_img;
-                if(crop_img.cols < _rec_input_size.width())
-                {
-                    cv::Mat padded_img(_rec_input_size.height(), _rec_input_size.width(), CV_8UC3, cv::Scalar(0, 0, 0));
-                    crop_img.copyTo(padded_img(cv::Rect(0, 0, crop_img.cols, crop_img.rows)));
-                    padded_img.copyTo(final_img);
-                }
-                else
-                {
-                    crop_img.copyTo(final_img);
-                }
-                // show image on left-top
-                image::Image std_img(final_img.cols, final_img.rows, image::Format::FMT_BGR888, final_img.data, -1, false);
-                // if(i == 0)
-                //     img.draw_image(0, 0, std_img);
+                _warp_line(img_src, objs[i]->box, crop, in_h, buf.lines[i]);
+            }
+        }, 1);
 
-                std::vector<int> max_idxes(_max_ch_num);
-                _recognize_stdimg(_rec_model, std_img, this->rec_mean, this->rec_scale, max_idxes, _max_ch_num, _prob_num);
+        // 2. slice lines wider than model input, and sort slices by width,
+        // model input shape is fixed, so narrow slices are padded with black at right.
+        size_t slice_num = 0;
+        for(size_t i = 0; i < objs.size(); ++i)
+            slice_num += (buf.lines[i].cols + in_w - 1) / in_w;
+        if(buf.slices.size() < slice_num)
+            buf.slices.resize(slice_num);
+        buf.order.clear();
+        size_t n = 0;
+        for(size_t i = 0; i < objs.size(); ++i)
+        {
+            cv::Mat &line = buf.lines[i];
+            for(int x = 0, s = 0; x < line.cols; x += in_w, ++s)
+            {
+                RecSlice &slice = buf.slices[n];
+                slice.obj_idx = i;
+                slice.slice_idx = s;
+                slice.img = line(cv::Rect(x, 0, std::min(in_w, line.cols - x), in_h));
+                buf.order.push_back(n++);
+            }
+        }
+        std::stable_sort(buf.order.begin(), buf.order.end(), [&buf](int a, int b) {
+            return buf.slices[a].img.cols > buf.slices[b].img.cols;
+        });
 
-                int last_idx = 0;
-                for(int j = 0; j < _max_ch_num; ++j)
+        // 3. forward slices, batch_size slices per forward
+        buf.padded.create(in_h, in_w, CV_8UC3);
+        for(size_t start = 0; start < n; start += _rec_batch)
+        {
+            size_t end = std::min(n, start + _rec_batch);
+            tensor::Tensors *outputs;
+            if(_rec_batch == 1)
+            {
+                RecSlice &slice = buf.slices[buf.order[start]];
+                buf.padded.setTo(cv::Scalar(0, 0, 0));
+                slice.img.copyTo(buf.padded(cv::Rect(0, 0, slice.img.cols, slice.img.rows)));
+                image::Image pad_img(in_w, in_h, image::Format::FMT_BGR888, buf.padded.data, -1, false);
+                outputs = _rec_model->forward_image(pad_img, this->rec_mean, this->rec_scale, image::Fit::FIT_FILL, false);
+            }
+            else
+            {
+                // normalize to float32 input, (value - mean) * scale, padding samples of last batch are zero
+                size_t sample_size = 3 * in_h * in_w;
+                buf.batch_input.assign(sample_size * _rec_batch, 0);
+                for(size_t k = start; k < end; ++k)
                 {
-                    if((max_idxes[j] != last_idx) && (max_idxes[j] != 0))
+                    RecSlice &slice = buf.slices[buf.order[k]];
+                    buf.padded.setTo(cv::Scalar(0, 0, 0));
+                    slice.img.copyTo(buf.padded(cv::Rect(0, 0, slice.img.cols, slice.img.rows)));
+                    float *dst = buf.batch_input.data() + (k - start) * sample_size;
+                    const uint8_t *src = buf.padded.data;
+                    for(int c = 0; c < 3; ++c)
                     {
-                        idx_list.push_back(max_idxes[j] - 1);
-                        char_list.push_back(labels[max_idxes[j] - 1]);
-                        char_pos.push_back(j + i * _max_ch_num);
+                        float m = rec_mean.empty() ? 0 : rec_mean[c % rec_mean.size()];
+                        float sc = rec_scale.empty() ? 1 : rec_scale[c % rec_scale.size()];
+                        for(int p = 0; p < in_h * in_w; ++p)
+                        {
+                            float v = (src[p * 3 + c] - m) * sc;
+                            if(_rec_nhwc)
+                                dst[p * 3 + c] = v;
+                            else
+                                dst[c * in_h * in_w + p] = v;
+                        }
                     }
-                    last_idx = max_idxes[j];
                 }
+                std::vector<int> shape = _rec_nhwc ? std::vector<int>{_rec_batch, in_h, in_w, 3} : std::vector<int>{_rec_batch, 3, in_h, in_w};
+                tensor::Tensors inputs;
+                tensor::Tensor *input = new tensor::Tensor(shape, tensor::DType::FLOAT32, buf.batch_input.data(), false);
+                inputs.add_tensor(_rec_input_name, input, false, true);
+                outputs = _rec_model->forward(inputs, false);
             }
-        } else {
-            // pad
-            cv::Mat padded_img(_rec_input_size.height(), _rec_input_size.width(), CV_8UC3, cv::Scalar(0, 0, 0));
-            resized_img.copyTo(padded_img(cv::Rect(0, 0, resized_img.cols, resized_img.rows)));
-            image::Image pad_img(padded_img.cols, padded_img.rows, image::Format::FMT_BGR888, padded_img.data, -1, false);
-
-            // show image on left-top
-            // img.draw_image(0, 0, pad_img);
-
-            std::vector<int> max_idxes(_max_ch_num);
-            _recognize_stdimg(_rec_model, pad_img, this->rec_mean, this->rec_scale, max_idxes, _max_ch_num, _prob_num);
+            if (!outputs) // not happen here
+            {
+                throw err::Exception(err::ERR_RUNTIME);
+            }
+            // rec postprocess, outputs shape: batch x _max_ch_num x (_prob_num)
+            tensor::Tensor *out = outputs->begin()->second;
+            float *data = (float*)out->data();
+            for(size_t k = start; k < end; ++k)
+            {
+                RecSlice &slice = buf.slices[buf.order[k]];
+                _argmax_steps(data + (k - start) * _max_ch_num * _prob_num, _max_ch_num, _prob_num, slice.max_idxes);
+            }
+            delete outputs;
+        }
 
+        // 4. get all max prob of slices, remove dumplicate and empty section, get charactors
+        for(nn::OCR_Object *obj : objs)
+        {
+            obj->idx_list.clear();
+            obj->char_pos.clear();
+        }
+        std::vector<std::vector<std::string>> char_lists(objs.size());
+        for(size_t k = 0; k < n; ++k) // slices were added in object and slice order
+        {
+            RecSlice &slice = buf.slices[k];
+            nn::OCR_Object *obj = objs[slice.obj_idx];
             int last_idx = 0;
-            for(int i = 0; i < _max_ch_num; ++i)
+            for(int j = 0; j < _max_ch_num; ++j)
             {
-                if((max_idxes[i] != last_idx) && (max_idxes[i] != 0))
+                int idx = slice.max_idxes[j];
+                if((idx != last_idx) && (idx != 0))
                 {
-                    idx_list.push_back(max_idxes[i] - 1);
-                    char_list.push_back(labels[max_idxes[i] - 1]);
-                    char_pos.push_back(i);
+                    obj->idx_list.push_back(idx - 1);
+                    char_lists[slice.obj_idx].push_back(labels[idx - 1]);
+                    obj->char_pos.push_back(j + slice.slice_idx * _max_ch_num);
                 }
-                last_idx = max_idxes[i];
+                last_idx = idx;
             }
         }
+        for(size_t i = 0; i < objs.size(); ++i)
+            objs[i]->update_chars(char_lists[i]);
     }
 
     void PP_OCR::_correct_bbox(nn::OCR_Objects &objs, int img_w, int img_h, maix::image::Fit fit)
@@ -16,71 +16,64 @@
 
 namespace PaddleOCR {
 
-void DBPostProcessor::GetContourArea(const std::vector<std::vector<float>> &box,
+void DBPostProcessor::GetContourArea(const cv::Point2f box[4],
                                      float unclip_ratio, float &distance) {
   int pts_num = 4;
   float area = 0.0f;
   float dist = 0.0f;
   for (int i = 0; i < pts_num; i++) {
-    area += box[i][0] * box[(i + 1) % pts_num][1] -
-            box[i][1] * box[(i + 1) % pts_num][0];
-    dist += sqrtf((box[i][0] - box[(i + 1) % pts_num][0]) *
-                      (box[i][0] - box[(i + 1) % pts_num][0]) +
-                  (box[i][1] - box[(i + 1) % pts_num][1]) *
-                      (box[i][1] - box[(i + 1) % pts_num][1]));
+    const cv::Point2f &a = box[i];
+    const cv::Point2f &b = box[(i + 1) % pts_num];
+    area += a.x * b.y - a.y * b.x;
+    dist += sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
   }
   area = fabs(float(area / 2.0));
 
   distance = area * unclip_ratio / dist;
 }
 
-cv::RotatedRect DBPostProcessor::UnClip(std::vector<std::vector<float>> box,
+cv::RotatedRect DBPostProcessor::UnClip(const cv::Point2f box[4],
                                         const float &unclip_ratio) {
   float distance = 1.0;
 
   GetContourArea(box, unclip_ratio, distance);
 
   Clipper2Lib::ClipperOffset offset;
-  Clipper2Lib::Path64 p;
-  p.push_back(Clipper2Lib::Point<int64_t>(int64_t(box[0][0]), int64_t(box[0][1])));
-  p.push_back(Clipper2Lib::Point<int64_t>(int64_t(box[1][0]), int64_t(box[1][1])));
-  p.push_back(Clipper2Lib::Point<int64_t>(int64_t(box[2][0]), int64_t(box[2][1])));
-  p.push_back(Clipper2Lib::Point<int64_t>(int64_t(box[3][0]), int64_t(box[3][1])));
-  offset.AddPath(p, Clipper2Lib::JoinType::Round, Clipper2Lib::EndType::Polygon);
-
-  Clipper2Lib::Paths64 soln;
-  offset.Execute(distance, soln);
-  std::vector<cv::Point2f> points;
-
-  for (size_t j = 0; j < soln.size(); j++) {
-    for (size_t i = 0; i < soln[soln.size() - 1].size(); i++) {
-      points.emplace_back(soln[j][i].x, soln[j][i].y);
+  clip_path_.clear();
+  for (int i = 0; i < 4; i++)
+    clip_path_.push_back(Clipper2Lib::Point<int64_t>(int64_t(box[i].x), int64_t(box[i].y)));
+  offset.AddPath(clip_path_, Clipper2Lib::JoinType::Round, Clipper2Lib::EndType::Polygon);
+
+  clip_soln_.clear();
+  offset.Execute(distance, clip_soln_);
+  unclip_points_.clear();
+
+  for (size_t j = 0; j < clip_soln_.size(); j++) {
+    for (size_t i = 0; i < clip_soln_[clip_soln_.size() - 1].size(); i++) {
+      unclip_points_.emplace_back(clip_soln_[j][i].x, clip_soln_[j][i].y);
     }
   }
   cv::RotatedRect res;
-  if (points.size() <= 0) {
+  if (unclip_points_.size() <= 0) {
     res = cv::RotatedRect(cv::Point2f(0, 0), cv::Size2f(1, 1), 0);
   } else {
-    res = cv::minAreaRect(points);
+    res = cv::minAreaRect(unclip_points_);
   }
   return res;
 }
 
-float **DBPostProcessor::Mat2Vec(cv::Mat mat) {
-  auto **array = new float *[mat.rows];
-  for (int i = 0; i < mat.rows; ++i)
-    array[i] = new float[mat.cols];
+std::vector<float> DBPostProcessor::Mat2Vec(const cv::Mat &mat) {
+  // one contiguous row major block instead of rows * new float[]
+  std::vector<float> array(mat.rows * mat.cols);
   for (int i = 0; i < mat.rows; ++i) {
-    for (int j = 0; j < mat.cols; ++j) {
-      array[i][j] = mat.at<float>(i, j);
-    }
+    const float *row = mat.ptr<float>(i);
+    std::copy(row, row + mat.cols, array.begin() + i * mat.cols);
   }
-
   return array;
 }
 
 std::vector<std::vector<int>>
-DBPostProcessor::OrderPointsClockwise(std::vector<std::vector<int>> pts) {
+DBPostProcessor::OrderPointsClockwise(const std::vector<std::vector<int>> &pts) {
   std::vector<std::vector<int>> box = pts;
   std::sort(box.begin(), box.end(), XsortInt);
 
@@ -98,121 +91,87 @@ DBPostProcessor::OrderPointsClockwise(std::vector<std::vector<int>> pts) {
   return rect;
 }
 
-std::vector<std::vector<float>> DBPostProcessor::Mat2Vector(cv::Mat mat) {
-  std::vector<std::vector<float>> img_vec;
-  std::vector<float> tmp;
-
-  for (int i = 0; i < mat.rows; ++i) {
-    tmp.clear();
-    for (int j = 0; j < mat.cols; ++j) {
-      tmp.push_back(mat.at<float>(i, j));
-    }
-    img_vec.push_back(tmp);
-  }
-  return img_vec;
-}
-
-bool DBPostProcessor::XsortFp32(std::vector<float> a, std::vector<float> b) {
-  if (a[0] != b[0])
-    return a[0] < b[0];
-  return false;
+bool DBPostProcessor::XsortFp32(const cv::Point2f &a, const cv::Point2f &b) {
+  return a.x < b.x;
 }
 
-bool DBPostProcessor::XsortInt(std::vector<int> a, std::vector<int> b) {
-  if (a[0] != b[0])
-    return a[0] < b[0];
-  return false;
+bool DBPostProcessor::XsortInt(const std::vector<int> &a, const std::vector<int> &b) {
+  return a[0] < b[0];
 }
 
-std::vector<std::vector<float>>
-DBPostProcessor::GetMiniBoxes(cv::RotatedRect box, float &ssid) {
+void DBPostProcessor::GetMiniBoxes(const cv::RotatedRect &box, float &ssid,
+                                   cv::Point2f array[4]) {
   ssid = std::max(box.size.width, box.size.height);
 
-  cv::Mat points;
-  cv::boxPoints(box, points);
+  cv::Point2f points[4];
+  box.points(points);
+  std::stable_sort(points, points + 4, XsortFp32);
 
-  auto array = Mat2Vector(points);
-  std::sort(array.begin(), array.end(), XsortFp32);
-
-  std::vector<float> idx1 = array[0], idx2 = array[1], idx3 = array[2],
-                     idx4 = array[3];
-  if (array[3][1] <= array[2][1]) {
-    idx2 = array[3];
-    idx3 = array[2];
+  // left two points: top-left and bottom-left, right two: top-right and bottom-right
+  if (points[1].y <= points[0].y) {
+    array[0] = points[1];
+    array[3] = points[0];
   } else {
-    idx2 = array[2];
-    idx3 = array[3];
+    array[0] = points[0];
+    array[3] = points[1];
   }
-  if (array[1][1] <= array[0][1]) {
-    idx1 = array[1];
-    idx4 = array[0];
+  if (points[3].y <= points[2].y) {
+    array[1] = points[3];
+    array[2] = points[2];
   } else {
-    idx1 = array[0];
-    idx4 = array[1];
+    array[1] = points[2];
+    array[2] = points[3];
   }
+}
 
-  array[0] = idx1;
-  array[1] = idx2;
-  array[2] = idx3;
-  array[3] = idx4;
-
-  return array;
+cv::Mat DBPostProcessor::MaskBuffer(int rows, int cols) {
+  // grow only, return zeroed roi, avoid allocating a mask for every box
+  if (mask_buf_.rows < rows || mask_buf_.cols < cols)
+    mask_buf_.create(std::max(mask_buf_.rows, rows), std::max(mask_buf_.cols, cols), CV_8UC1);
+  cv::Mat mask = mask_buf_(cv::Rect(0, 0, cols, rows));
+  mask.setTo(cv::Scalar(0));
+  return mask;
 }
 
-float DBPostProcessor::PolygonScoreAcc(std::vector<cv::Point> contour,
-                                       cv::Mat pred) {
+float DBPostProcessor::PolygonScoreAcc(const std::vector<cv::Point> &contour,
+                                       const cv::Mat &pred) {
   int width = pred.cols;
   int height = pred.rows;
-  std::vector<float> box_x;
-  std::vector<float> box_y;
-  for (size_t i = 0; i < contour.size(); ++i) {
-    box_x.push_back(contour[i].x);
-    box_y.push_back(contour[i].y);
+  float xmin_f = contour[0].x, xmax_f = contour[0].x;
+  float ymin_f = contour[0].y, ymax_f = contour[0].y;
+  for (size_t i = 1; i < contour.size(); ++i) {
+    xmin_f = std::min(xmin_f, (float)contour[i].x);
+    xmax_f = std::max(xmax_f, (float)contour[i].x);
+    ymin_f = std::min(ymin_f, (float)contour[i].y);
+    ymax_f = std::max(ymax_f, (float)contour[i].y);
   }
 
-  int xmin =
-      clamp(int(std::floor(*(std::min_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int xmax =
-      clamp(int(std::ceil(*(std::max_element(box_x.begin(), box_x.end())))), 0,
-            width - 1);
-  int ymin =
-      clamp(int(std::floor(*(std::min_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
-  int ymax =
-      clamp(int(std::ceil(*(std::max_element(box_y.begin(), box_y.end())))), 0,
-            height - 1);
+  int xmin = clamp(int(std::floor(xmin_f)), 0, width - 1);
+  int xmax = clamp(int(std::ceil(xmax_f)), 0, width - 1);
+  int ymin = clamp(int(std::floor(ymin_f)), 0, height - 1);
+  int ymax = clamp(int(std::ceil(ymax_f)), 0, height - 1);
 
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
-
-  cv::Point *rook_point = new cv::Point[contour.size()];
+  cv::Mat mask = MaskBuffer(ymax - ymin + 1, xmax - xmin + 1);
 
+  rook_points_.resize(contour.size());
   for (size_t i = 0; i < contour.size(); ++i) {
-    rook_point[i] = cv::Point(int(box_x[i]) - xmin, int(box_y[i]) - ymin);
+    rook_points_[i] = cv::Point(contour[i].x - xmin, contour[i].y - ymin);
   }
-  const cv::Point *ppt[1] = {rook_point};
+  const cv::Point *ppt[1] = {rook_points_.data()};
   int npt[] = {int(contour.size())};
 
   cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
 
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
-  float score = cv::mean(croppedImg, mask)[0];
-
-  delete[] rook_point;
-  return score;
+  return cv::mean(pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1)), mask)[0];
 }
 
-float DBPostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
-                                    cv::Mat pred) {
-  auto array = box_array;
+float DBPostProcessor::BoxScoreFast(const cv::Point2f array[4],
+                                    const cv::Mat &pred) {
   int width = pred.cols;
   int height = pred.rows;
 
-  float box_x[4] = {array[0][0], array[1][0], array[2][0], array[3][0]};
-  float box_y[4] = {array[0][1], array[1][1], array[2][1], array[3][1]};
+  float box_x[4] = {array[0].x, array[1].x, array[2].x, array[3].x};
+  float box_y[4] = {array[0].y, array[1].y, array[2].y, array[3].y};
 
   int xmin = clamp(int(std::floor(*(std::min_element(box_x, box_x + 4)))), 0,
                    width - 1);
@@ -223,66 +182,53 @@ float DBPostProcessor::BoxScoreFast(std::vector<std::vector<float>> box_array,
   int ymax = clamp(int(std::ceil(*(std::max_element(box_y, box_y + 4)))), 0,
                    height - 1);
 
-  cv::Mat mask;
-  mask = cv::Mat::zeros(ymax - ymin + 1, xmax - xmin + 1, CV_8UC1);
+  cv::Mat mask = MaskBuffer(ymax - ymin + 1, xmax - xmin + 1);
 
   cv::Point root_point[4];
-  root_point[0] = cv::Point(int(array[0][0]) - xmin, int(array[0][1]) - ymin);
-  root_point[1] = cv::Point(int(array[1][0]) - xmin, int(array[1][1]) - ymin);
-  root_point[2] = cv::Point(int(array[2][0]) - xmin, int(array[2][1]) - ymin);
-  root_point[3] = cv::Point(int(array[3][0]) - xmin, int(array[3][1]) - ymin);
+  for (int i = 0; i < 4; i++)
+    root_point[i] = cv::Point(int(array[i].x) - xmin, int(array[i].y) - ymin);
   const cv::Point *ppt[1] = {root_point};
   int npt[] = {4};
   cv::fillPoly(mask, ppt, npt, 1, cv::Scalar(1));
 
-  cv::Mat croppedImg;
-  pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1))
-      .copyTo(croppedImg);
-
-  auto score = cv::mean(croppedImg, mask)[0];
-  return score;
+  // score on roi view of pred, no copy
+  return cv::mean(pred(cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1)), mask)[0];
 }
 
-std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
-    const cv::Mat pred, const cv::Mat bitmap, const float &box_thresh,
-    const float &det_db_unclip_ratio, const std::string &det_db_score_mode, std::vector<float> &scores) {
+void DBPostProcessor::BoxesFromBitmap(
+    const cv::Mat &pred, const cv::Mat &bitmap, const float &box_thresh,
+    const float &det_db_unclip_ratio, const std::string &det_db_score_mode,
+    std::vector<std::array<cv::Point, 4>> &boxes, std::vector<float> &scores) {
   const int min_size = 3;
-  const int max_candidates = 1000;
+  const size_t max_candidates = 1000;
+  const bool slow_mode = det_db_score_mode == "slow";
 
   int width = bitmap.cols;
   int height = bitmap.rows;
 
-  std::vector<std::vector<cv::Point>> contours;
-  std::vector<cv::Vec4i> hierarchy;
-
+  boxes.clear();
   scores.clear();
 
-  cv::findContours(bitmap, contours, hierarchy, cv::RETR_LIST,
-                   cv::CHAIN_APPROX_SIMPLE);
+  cv::findContours(bitmap, contours_, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
 
-  int num_contours =
-      contours.size() >= max_candidates ? max_candidates : contours.size();
+  size_t num_contours = std::min(contours_.size(), max_candidates);
 
-  std::vector<std::vector<std::vector<int>>> boxes;
-
-  for (int _i = 0; _i < num_contours; _i++) {
-    if (contours[_i].size() <= 2) {
+  for (size_t _i = 0; _i < num_contours; _i++) {
+    if (contours_[_i].size() <= 2) {
       continue;
     }
     float ssid;
-    cv::RotatedRect box = cv::minAreaRect(contours[_i]);
-    auto array = GetMiniBoxes(box, ssid);
-
-    auto box_for_unclip = array;
-    // end get_mini_box
+    cv::Point2f array[4];
+    cv::RotatedRect box = cv::minAreaRect(contours_[_i]);
+    GetMiniBoxes(box, ssid, array);
 
     if (ssid < min_size) {
       continue;
     }
     float score;
-    if (det_db_score_mode == "slow")
+    if (slow_mode)
       /* compute using polygon*/
-      score = PolygonScoreAcc(contours[_i], pred);
+      score = PolygonScoreAcc(contours_[_i], pred);
     else
       score = BoxScoreFast(array, pred);
 
@@ -290,36 +236,33 @@ std::vector<std::vector<std::vector<int>>> DBPostProcessor::BoxesFromBitmap(
       continue;
 
     // start for unclip
-    cv::RotatedRect points = UnClip(box_for_unclip, det_db_unclip_ratio);
+    cv::RotatedRect points = UnClip(array, det_db_unclip_ratio);
     if (points.size.height < 1.001 && points.size.width < 1.001) {
       continue;
     }
     // end for unclip
 
-    cv::RotatedRect clipbox = points;
-    auto cliparray = GetMiniBoxes(clipbox, ssid);
+    cv::Point2f cliparray[4];
+    GetMiniBoxes(points, ssid, cliparray);
 
     if (ssid < min_size + 2)
       continue;
 
     int dest_width = pred.cols;
     int dest_height = pred.rows;
-    std::vector<std::vector<int>> intcliparray;
+    std::array<cv::Point, 4> intcliparray;
 
     for (int num_pt = 0; num_pt < 4; num_pt++) {
-      std::vector<int> a{int(clampf(roundf(cliparray[num_pt][0] / float(width) *
-                                           float(dest_width)),
-                                    0, float(dest_width))),
-                         int(clampf(roundf(cliparray[num_pt][1] /
-                                           float(height) * float(dest_height)),
-                                    0, float(dest_height)))};
-      intcliparray.push_back(a);
+      intcliparray[num_pt] = cv::Point(
+          int(clampf(roundf(cliparray[num_pt].x / float(width) * float(dest_width)),
+                     0, float(dest_width))),
+          int(clampf(roundf(cliparray[num_pt].y / float(height) * float(dest_height)),
+                     0, float(dest_height))));
     }
     boxes.push_back(intcliparray);
     scores.push_back(score);
 
   } // end for
-  return boxes;
 }
 
 std::vector<std::vector<std::vector<int>>> DBPostProcessor::FilterTagDetRes(
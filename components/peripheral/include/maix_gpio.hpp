@@ -3,11 +3,14 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add edge events.
  */
 
 #pragma once
 
 #include <string>
+#include <vector>
+#include <functional>
 #include "maix_basic.hpp"
 
 namespace maix::peripheral::gpio
@@ -36,6 +39,46 @@ namespace maix::peripheral::gpio
         PULL_MAX
     };
 
+    /**
+     * @brief GPIO edge type
+     * @maixpy maix.peripheral.gpio.Edge
+     */
+    enum Edge
+    {
+        EDGE_NONE    = 0x00,  // no edge
+        EDGE_RISING  = 0x01,  // rising edge, low to high
+        EDGE_FALLING = 0x02,  // falling edge, high to low
+        EDGE_BOTH    = 0x03,  // rising and falling edge
+    };
+
+    /**
+     * @brief GPIO edge event
+     * @maixpy maix.peripheral.gpio.Event
+     */
+    class Event
+    {
+    public:
+        /**
+         * Edge type of this event, EDGE_RISING or EDGE_FALLING.
+         * @maixpy maix.peripheral.gpio.Event.edge
+         */
+        gpio::Edge edge = gpio::Edge::EDGE_NONE;
+
+        /**
+         * Kernel timestamp of the edge in ns, CLOCK_MONOTONIC, same clock as time::ticks_us.
+         * Taken in interrupt, so it's accurate even if callback is late.
+         * @maixpy maix.peripheral.gpio.Event.timestamp_ns
+         */
+        uint64_t timestamp_ns = 0;
+
+        /**
+         * Sequence number of events of this line, start from 1, gap means events lost(kernel buffer overflow or queue full).
+         * 0 means settle event, reported when line level differs from last edge after edges dropped by software debounce.
+         * @maixpy maix.peripheral.gpio.Event.seqno
+         */
+        uint32_t seqno = 0;
+    };
+
     /**
      * Peripheral gpio class
      * @maixpy maix.peripheral.gpio.GPIO
@@ -111,6 +154,45 @@ namespace maix::peripheral::gpio
          */
         err::Err reset(gpio::Mode mode, gpio::Pull pull);
 
+        /**
+         * @brief Enable edge events, interrupt driven, no need to poll value().
+         * Events are read by io::Reactor::global(), then passed to callback, or pushed to a queue and read by read_events() if no callback.
+         * GPIO must be input mode, pull is set as bias if hardware supports.
+         * @param[in] edge edges to capture, gpio.Edge type.
+         * @param[in] debounce_us debounce period in us, 0 means no debounce.
+         *            Kernel debounce is used if supported, kernel reports the edge only after line stable for debounce_us.
+         *            Else fall back to software filter, edges within debounce_us after last reported edge are dropped,
+         *            for EDGE_BOTH line level is read again after edges stop for debounce_us, and reported as an edge with seqno 0 if it differs from last reported edge.
+         * @param[in] callback called with every event in reactor worker thread, nullptr means push events to queue.
+         * @param[in] queue_size max events in queue, oldest event is dropped when queue full.
+         * @return err::Err type, err.Err.ERR_NOT_PERMIT if not input mode, err.Err.ERR_NOT_IMPL if kernel not support line events v2.
+         * @maixpy maix.peripheral.gpio.GPIO.enable_events
+         */
+        err::Err enable_events(gpio::Edge edge = gpio::Edge::EDGE_BOTH, int debounce_us = 0,
+                               std::function<void(gpio::GPIO &, const gpio::Event &)> callback = nullptr, int queue_size = 64);
+
+        /**
+         * @brief Disable edge events, GPIO keeps input mode.
+         * @return err::Err type
+         * @maixpy maix.peripheral.gpio.GPIO.disable_events
+         */
+        err::Err disable_events();
+
+        /**
+         * @brief Read events from queue, only valid when enable_events without callback.
+         * @param[in] timeout_ms wait time if queue is empty, 0 means return immediately, -1 means wait until got event.
+         * @param[in] max_num max events number to read, -1 means all events in queue.
+         * @return events in occurred order, empty if timeout or events not enabled.
+         * @maixpy maix.peripheral.gpio.GPIO.read_events
+         */
+        std::vector<gpio::Event> read_events(int timeout_ms = 0, int max_num = -1);
+
+        /**
+         * @brief Get number of events dropped by software debounce filter or full queue.
+         * @maixpy maix.peripheral.gpio.GPIO.events_dropped
+         */
+        uint64_t events_dropped();
+
     private:
         std::string _pin;
         gpio::Mode  _mode;
@@ -119,5 +201,8 @@ namespace maix::peripheral::gpio
         int         _offset;
         int         _line;
         bool        _special;
+        void       *_events;   // edge events data, not nullptr means _line is a v2 line events fd
+
+        err::Err _request_line(gpio::Mode mode, gpio::Pull pull);
     };
 }; // namespace maix::peripheral::gpio
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add combined transactions and burst register access.
  */
 
 #pragma once
@@ -33,6 +34,29 @@ namespace maix::peripheral::i2c
         SLAVE = 0x01   // slave mode
     };
 
+    /**
+     * @brief One message of a combined transaction, see I2C::transfer.
+     * @maixcdk maix.peripheral.i2c.Msg
+     */
+    struct Msg
+    {
+        int addr;      // slave address
+        bool read;     // true means read from slave to buff, false means write buff to slave
+        uint8_t *buff; // data buffer, caller owns it
+        int len;       // data length
+    };
+
+    /**
+     * @brief One register read of a batch, see I2C::readfrom_mems.
+     * @maixcdk maix.peripheral.i2c.MemRead
+     */
+    struct MemRead
+    {
+        int mem_addr;  // register address
+        uint8_t *buff; // buffer to store data, caller owns it
+        int len;       // data length to read
+    };
+
     /**
      * Get supported i2c bus devices.
      * @return i2c bus devices list, int type, is the i2c bus id.
@@ -165,10 +189,56 @@ namespace maix::peripheral::i2c
          */
         Bytes* readfrom_mem(int addr, int mem_addr, int len, int mem_addr_size = 8, bool mem_addr_le = false);
 
+        /**
+         * @brief Read data from i2c slave's memory address into caller's buffer,
+         * write address and read data with repeated start in one transaction, no allocation.
+         * @param[in] addr i2c slave address, int type
+         * @param[in] mem_addr memory address want to read, int type.
+         * @param[out] buff buffer to store data, at least len bytes.
+         * @param[in] len data length to read, int type
+         * @param[in] mem_addr_size memory address size, default is 8.
+         * @param[in] mem_addr_le memory address little endian, default is false, that is send high byte first.
+         * @return data length read if success, error occurred will return -err::Err.
+         * @maixcdk maix.peripheral.i2c.I2C.readfrom_mem_into
+         */
+        int readfrom_mem_into(int addr, int mem_addr, uint8_t *buff, int len, int mem_addr_size = 8, bool mem_addr_le = false);
+
+        /**
+         * @brief Read a batch of registers of one slave, all reads are submitted in one transaction(one syscall)
+         * if the bus supports combined messages, reduce syscall and bus idle time for drivers reading many registers every sample.
+         * @param[in] addr i2c slave address, int type
+         * @param[in] reads registers to read and buffers to store data.
+         * @param[in] num number of reads.
+         * @param[in] mem_addr_size memory address size, default is 8.
+         * @param[in] mem_addr_le memory address little endian, default is false, that is send high byte first.
+         * @return num if success, error occurred will return -err::Err.
+         * @maixcdk maix.peripheral.i2c.I2C.readfrom_mems
+         */
+        int readfrom_mems(int addr, const i2c::MemRead *reads, int num, int mem_addr_size = 8, bool mem_addr_le = false);
+
+        /**
+         * @brief Submit messages as one combined transaction by I2C_RDWR, messages are separated by repeated start and
+         * only one stop at the end, e.g. {write reg, read data, write reg2, read data2}.
+         * More than 42 messages are split into several transactions, only before a write message,
+         * so a write and the reads following it are always in one transaction, and if they are more than 42 messages, return -err::ERR_ARGS.
+         * If bus only supports SMBus(e.g. i2c-stub), messages are converted to SMBus transfers,
+         * then only single write, single byte read and write 1 byte + read pairs are supported, and they are not atomic.
+         * @param[in,out] msgs messages, read messages' buff will be filled.
+         * @param[in] num number of messages.
+         * @return num if success, error occurred will return -err::Err.
+         * @maixcdk maix.peripheral.i2c.I2C.transfer
+         */
+        int transfer(i2c::Msg *msgs, int num);
+
     private:
         int _fd;
+        int _slave_addr;     // address set by I2C_SLAVE last time, -1 means not set
+        unsigned long _funcs; // adapter functionality, I2C_FUNC_*
         int _freq;
         i2c::AddrSize _addr_size;
         i2c::Mode     _mode;
+
+        int _set_slave(int addr);
+        int _smbus_transfer(i2c::Msg *msgs, int num);
     };
 } // namespace maix::peripheral::i2c
\ No newline at end of file
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add multi-segment transfer and async transfer queue.
  */
 
 #pragma once
@@ -10,6 +11,7 @@
 #include "maix_basic.hpp"
 #include "maix_gpio.hpp"
 #include "vector"
+#include <functional>
 
 namespace maix::peripheral::spi
 {
@@ -23,6 +25,28 @@ namespace maix::peripheral::spi
         SLAVE = 0x1,  // spi slave mode
     };
 
+    /**
+     * One segment of a SPI message, see SPI::transfer.
+     * Buffers are owned by caller, no copy is made.
+     * @maixcdk maix.peripheral.spi.Transfer
+     */
+    struct Transfer
+    {
+        uint8_t *tx = nullptr;  // data to send, nullptr means send 0x00. Not modified, segments longer than 50 bytes are
+                                // word swapped for the controller in an internal buffer.
+        uint8_t *rx = nullptr;  // buffer to store received data, nullptr means discard, can be the same as tx.
+        int len = 0;            // segment length in bytes
+        int speed_hz = 0;       // clock of this segment, 0 means use SPI freq.
+        int bits = 0;           // bits per word of this segment, 0 means use SPI bits.
+        int delay_us = 0;       // delay after this segment, before next segment or CS change, max 65535.
+        bool cs_change = false; // deselect CS after this segment before next segment.
+    };
+
+    /**
+     * Async transfer done callback, arg is same as SPI::transfer return value.
+     */
+    using TransferCallback = std::function<void(int)>;
+
     /**
      * Peripheral spi class
      * @maixpy maix.peripheral.spi.SPI
@@ -111,8 +135,50 @@ namespace maix::peripheral::spi
          * @maixpy maix.peripheral.spi.SPI.is_busy
          */
         bool is_busy();
+
+        /**
+         * @brief Transfer segments as one SPI message in one SPI_IOC_MESSAGE ioctl, full duplex, no allocation and no copy.
+         * CS keeps selected during the whole message except after segments with cs_change set,
+         * CS is always deselected at the end of message, cs_change of last segment is ignored.
+         * Message longer than spidev bufsiz(/sys/module/spidev/parameters/bufsiz, default 4096) or more than 64 segments
+         * is split into several ioctls, CS is kept selected between them by soft CS or spidev's cs_change hint.
+         * @param[in,out] xfers segments, rx buffers will be filled.
+         * @param[in] num number of segments.
+         * @return transferred bytes if success, error occurred will return -err::Err.
+         * @maixcdk maix.peripheral.spi.SPI.transfer
+         */
+        int transfer(spi::Transfer *xfers, int num);
+
+        /**
+         * @brief Queue segments to transfer in background worker thread, return immediately,
+         * messages are transferred in submit order. Caller must keep buffers valid until callback called or wait() returns.
+         * Segment descriptors are copied to preallocated queue slots, so xfers can be reused after return.
+         * @param[in] xfers segments, same as transfer.
+         * @param[in] num number of segments.
+         * @param[in] callback called in worker thread after transfer with transfer result, can be nullptr.
+         * @param[in] timeout_ms wait time if queue full, -1 means wait until have space, 0 means return immediately.
+         * @return err::ERR_NONE if queued, err::ERR_BUSY if queue full and timeout, err::ERR_ARGS if args invalid.
+         * @maixcdk maix.peripheral.spi.SPI.submit
+         */
+        err::Err submit(spi::Transfer *xfers, int num, spi::TransferCallback callback = nullptr, int timeout_ms = -1);
+
+        /**
+         * @brief Wait all queued transfers finished.
+         * @param[in] timeout_ms timeout time, -1 means wait forever.
+         * @return err::ERR_NONE if all finished, err::ERR_TIMEOUT if timeout.
+         * @maixcdk maix.peripheral.spi.SPI.wait
+         */
+        err::Err wait(int timeout_ms = -1);
+
+        /**
+         * @brief Get number of queued and transferring messages.
+         * @maixcdk maix.peripheral.spi.SPI.pending
+         */
+        int pending();
     private:
         void enable_cs(bool enable);
+        int _transfer(spi::Transfer *xfers, int num);
+        int _message(spi::Transfer *xfers, int num, bool keep_cs);
     private:
         int _fd = -1;
         bool _used_soft_cs = false;
@@ -121,5 +187,7 @@ namespace maix::peripheral::spi
 
         int _bits;
         int _freq;
+        int _bufsiz;
+        void *_priv = nullptr;
     };
 }; // namespace maix::peripheral::spi
@@ -12,6 +12,7 @@
 #include "maix_type.hpp"
 #include "maix_thread.hpp"
 #include <functional>
+#include <memory>
 
 /**
  * @brief maix uart peripheral driver
@@ -153,8 +154,11 @@ namespace maix::peripheral::uart
         err::Err close();
 
         /**
-         * Set received callback function
-         * @param callback function to call when received data
+         * Set received callback function, callback is called in io::Reactor::global() worker thread,
+         * can be set before or after open, set again will replace the old one.
+         * Received data is delivered once the line is idle for about 30 bytes time(at least 1ms), so one burst is usually one callback.
+         * @param callback function to call when received data, data is only valid in callback, copy it if need to keep.
+         *                 nullptr means remove callback.
          * @maixpy maix.peripheral.uart.UART.set_received_callback
          */
         void set_received_callback(std::function<void(uart::UART&, Bytes&)> callback);
@@ -267,9 +271,11 @@ namespace maix::peripheral::uart
         uart::FLOW_CTRL  _flow_ctrl;
         int         _one_byte_time_us;
         std::function<void(uart::UART&, Bytes&)> callback;
-        thread::Thread *_read_thread;
-        bool        _read_thread_need_exit;
-        bool        _read_thread_exit;
+        bool        _callback_added;
+        std::shared_ptr<void> _rx;   // received data waiting idle gap, shared with reactor callbacks
+
+        err::Err _add_callback();
+        void _remove_callback();
     };
 
     err::Err register_comm_callback(uart::UART *obj, std::function<void(uart::UART*)> callback);
@@ -4,6 +4,7 @@
  * @license Apache 2.0
  * @update 2024.5.13: update this file.
  *         2025.8.7: add HAVE_GPIO_STATE_LED definition.
+ *         2026.10.18: add edge events by line events v2 API, report settled level after software debounce.
  */
 
 #include "maix_gpio.hpp"
@@ -14,7 +15,19 @@
 #include <algorithm>
 #include <sys/ioctl.h>
 #include <errno.h>
+#include <time.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include "maix_gpio_port.hpp"
+#include "maix_io_reactor.hpp"
+
+// line events v2 API added in Linux 5.10
+#ifdef GPIO_V2_GET_LINE_IOCTL
+#define HAVE_GPIO_LINE_EVENTS 1
+#else
+#define HAVE_GPIO_LINE_EVENTS 0
+#endif
 
 
 namespace maix::peripheral::gpio
@@ -146,12 +159,173 @@ namespace maix::peripheral::gpio
 	}
 #endif // HAVE_GPIO_STATE_LED
 
+	class EventData
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::deque<gpio::Event> queue;
+		size_t queue_size;
+		std::function<void(gpio::GPIO &, const gpio::Event &)> callback;
+		uint64_t debounce_ns; // software debounce, 0 if not used
+		uint64_t last_ns;
+		uint64_t dropped;
+		// software debounce of both edges, check line level after bounce settled
+		bool check_settle;
+		int fd;           // line events fd
+		int level;        // line level after last reported edge
+		uint64_t bounce_ns;    // timestamp of last dropped edge
+		int settle_timer; // settle check timer id, 0 if not armed
+		bool closed;
+	};
+
+#if HAVE_GPIO_LINE_EVENTS
+	static int _read_line_level(int fd)
+	{
+		struct gpio_v2_line_values values;
+		memset(&values, 0, sizeof(values));
+		values.mask = 1;
+		if (ioctl(fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+			return -1;
+		return (int)(values.bits & 1);
+	}
+
+	// pass event to callback or queue, lock is unlocked if callback called
+	static void _deliver_event(GPIO &gpio, EventData *data, const gpio::Event &e, std::unique_lock<std::mutex> &lock)
+	{
+		data->level = e.edge == gpio::Edge::EDGE_RISING ? 1 : 0;
+		if (data->callback)
+		{
+			// callbacks of one fd never run concurrently, safe to call without lock
+			lock.unlock();
+			data->callback(gpio, e);
+			return;
+		}
+		data->queue.push_back(e);
+		if (data->queue.size() > data->queue_size)
+		{
+			data->queue.pop_front();
+			++data->dropped;
+		}
+		data->cond.notify_all();
+	}
+
+	static uint64_t _now_ns()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+
+	// report line level as a settle edge with seqno 0 if it differs from last reported edge,
+	// lock is locked when return
+	static void _settle(GPIO &gpio, EventData *data, std::unique_lock<std::mutex> &lock, uint64_t now)
+	{
+		int level = _read_line_level(data->fd);
+		if (level < 0 || level == data->level)
+			return;
+		gpio::Event e;
+		e.edge = level ? gpio::Edge::EDGE_RISING : gpio::Edge::EDGE_FALLING;
+		e.timestamp_ns = now;
+		e.seqno = 0; // not a kernel event, seqno of kernel events never be 0
+		data->last_ns = now;
+		_deliver_event(gpio, data, e, lock);
+		if (!lock.owns_lock())
+			lock.lock();
+	}
+
+	// edges dropped by software debounce may leave line at a level differs from last reported edge,
+	// check level after line stable for debounce period and report the settled level as an edge.
+	static void _on_settle_timer(GPIO &gpio, EventData *data)
+	{
+		std::unique_lock<std::mutex> lock(data->mutex);
+		if (data->closed)
+			return;
+		uint64_t now = _now_ns();
+		if (now - data->bounce_ns < data->debounce_ns)
+		{
+			int ms = (data->debounce_ns - (now - data->bounce_ns) + 999999) / 1000000;
+			int timer = io::Reactor::global().add_timer(ms, [&gpio, data]() {
+				_on_settle_timer(gpio, data);
+			}, true);
+			if (timer > 0)
+			{
+				data->settle_timer = timer;
+				return;
+			}
+			// can't wait more, check level now
+		}
+		// keep timer id until callback returns, so disable_events() waits this callback by remove_timer
+		int timer = data->settle_timer;
+		_settle(gpio, data, lock, now);
+		if (data->settle_timer == timer)
+			data->settle_timer = 0;
+	}
+
+	static void _on_line_events(GPIO &gpio, EventData *data, int fd)
+	{
+		struct gpio_v2_line_event evs[16];
+		ssize_t len = ::read(fd, evs, sizeof(evs));
+		if (len < (ssize_t)sizeof(evs[0]))
+			return;
+		int num = len / sizeof(evs[0]);
+		for (int i = 0; i < num; ++i)
+		{
+			gpio::Event e;
+			e.edge = evs[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE ? gpio::Edge::EDGE_RISING : gpio::Edge::EDGE_FALLING;
+			e.timestamp_ns = evs[i].timestamp_ns;
+			e.seqno = evs[i].line_seqno;
+			std::unique_lock<std::mutex> lock(data->mutex);
+			if (data->debounce_ns > 0)
+			{
+				if (data->last_ns > 0 && e.timestamp_ns - data->last_ns < data->debounce_ns)
+				{
+					++data->dropped;
+					if (data->check_settle)
+					{
+						data->bounce_ns = e.timestamp_ns;
+						if (data->settle_timer == 0 && !data->closed)
+						{
+							int ms = (data->debounce_ns + 999999) / 1000000;
+							int timer = io::Reactor::global().add_timer(ms, [&gpio, data]() {
+								_on_settle_timer(gpio, data);
+							}, true);
+							if (timer > 0)
+								data->settle_timer = timer;
+							else
+								_settle(gpio, data, lock, _now_ns()); // no timer, check level now
+						}
+					}
+					continue;
+				}
+				data->last_ns = e.timestamp_ns;
+			}
+			_deliver_event(gpio, data, e, lock);
+		}
+	}
+
+	// stop reading events and wait running callbacks, data can be deleted after this
+	static void _stop_events(EventData *data, int fd)
+	{
+		io::Reactor::global().remove(fd);
+		int timer;
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+			data->closed = true;
+			timer = data->settle_timer;
+		}
+		if (timer > 0)
+			io::Reactor::global().remove_timer(timer);
+	}
+#endif
+
 	GPIO::GPIO(std::string pin, gpio::Mode mode, gpio::Pull pull)
 	{
 		this->_pull = pull;
 		this->_mode = mode;
 		this->_fd = 0;
 		this->_line = 0;
+		this->_events = nullptr;
 
 		// to upper case first
 		// convert B14/GPIOB14 to chip_id and offset, B can be any letter
@@ -219,6 +393,14 @@ namespace maix::peripheral::gpio
 			return;
 		}
 #endif
+		if (this->_events)
+		{
+#if HAVE_GPIO_LINE_EVENTS
+			_stop_events((EventData *)this->_events, this->_line);
+#endif
+			delete (EventData *)this->_events;
+			this->_events = nullptr;
+		}
 		if (this->_line > 0)
 			close(this->_line);
 		if (this->_fd > 0)
@@ -236,6 +418,16 @@ namespace maix::peripheral::gpio
 				return led_get(_fd);
 			return value;
 		}
+#endif
+#if HAVE_GPIO_LINE_EVENTS
+		if (_events)
+		{
+			// line events fd is input only
+			if (value >= 0)
+				return (int)(-err::Err::ERR_NOT_PERMIT);
+			int level = _read_line_level(this->_line);
+			return level < 0 ? (int)(-err::Err::ERR_IO) : level;
+		}
 #endif
 		struct gpiohandle_data data;
 		memset(&data, 0, sizeof(data));
@@ -285,9 +477,19 @@ namespace maix::peripheral::gpio
 
 	err::Err GPIO::reset(gpio::Mode mode, gpio::Pull pull)
 	{
+		if (_events)
+		{
+			err::Err e = disable_events();
+			if (e != err::ERR_NONE)
+				return e;
+		}
 		if (mode == _mode && pull == _pull)
 			return err::ERR_NONE;
+		return _request_line(mode, pull);
+	}
 
+	err::Err GPIO::_request_line(gpio::Mode mode, gpio::Pull pull)
+	{
 		if (this->_line > 0) {
 			::close(this->_line);
 			this->_line = -1;
@@ -316,4 +518,147 @@ namespace maix::peripheral::gpio
 		return err::ERR_NONE;
 	}
 
+
+	err::Err GPIO::enable_events(gpio::Edge edge, int debounce_us, std::function<void(gpio::GPIO &, const gpio::Event &)> callback, int queue_size)
+	{
+#if HAVE_GPIO_LINE_EVENTS
+		if (_special)
+			return err::ERR_NOT_IMPL;
+		if (_mode != gpio::Mode::IN)
+		{
+			log::error("gpio events need input mode");
+			return err::ERR_NOT_PERMIT;
+		}
+		if (edge == gpio::Edge::EDGE_NONE || debounce_us < 0 || queue_size <= 0)
+			return err::ERR_ARGS;
+		if (_events)
+		{
+			err::Err e = disable_events();
+			if (e != err::ERR_NONE)
+				return e;
+		}
+
+		struct gpio_v2_line_request req;
+		memset(&req, 0, sizeof(req));
+		req.offsets[0] = _offset;
+		req.num_lines = 1;
+		strncpy(req.consumer, "maix_gpio", sizeof(req.consumer) - 1);
+		// kernel buffer, holds events when reactor is busy
+		req.event_buffer_size = std::max(16, std::min(queue_size, 256));
+		req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+		if (edge & gpio::Edge::EDGE_RISING)
+			req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+		if (edge & gpio::Edge::EDGE_FALLING)
+			req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+		if (_pull == gpio::Pull::PULL_UP)
+			req.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+		else if (_pull == gpio::Pull::PULL_DOWN)
+			req.config.flags |= GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+		if (debounce_us > 0)
+		{
+			req.config.num_attrs = 1;
+			req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+			req.config.attrs[0].attr.debounce_period_us = debounce_us;
+			req.config.attrs[0].mask = 1;
+		}
+
+		// line can only be requested once, release v1 handle first
+		if (this->_line > 0)
+		{
+			::close(this->_line);
+			this->_line = -1;
+		}
+		bool soft_debounce = false;
+		int ret = ::ioctl(_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+		if (ret < 0 && debounce_us > 0)
+		{
+			log::warn("gpio kernel debounce not supported(%s), use software debounce", ::strerror(errno));
+			req.config.num_attrs = 0;
+			memset(&req.config.attrs[0], 0, sizeof(req.config.attrs[0]));
+			soft_debounce = true;
+			ret = ::ioctl(_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+		}
+		if (ret < 0)
+		{
+			err::Err e = errno == ENOTTY || errno == EINVAL ? err::ERR_NOT_IMPL : err::ERR_IO;
+			log::error("request gpio line events failed: %s", ::strerror(errno));
+			_request_line(_mode, _pull);
+			return e;
+		}
+		int flags = fcntl(req.fd, F_GETFL, 0);
+		fcntl(req.fd, F_SETFL, flags | O_NONBLOCK);
+
+		EventData *data = new EventData();
+		data->queue_size = queue_size;
+		data->callback = callback;
+		data->debounce_ns = soft_debounce ? (uint64_t)debounce_us * 1000 : 0;
+		data->last_ns = 0;
+		data->dropped = 0;
+		data->check_settle = soft_debounce && (edge & gpio::Edge::EDGE_RISING) && (edge & gpio::Edge::EDGE_FALLING);
+		data->fd = req.fd;
+		data->level = _read_line_level(req.fd);
+		data->bounce_ns = 0;
+		data->settle_timer = 0;
+		data->closed = false;
+		this->_line = req.fd;
+		this->_events = data;
+		err::Err e = io::Reactor::global().add(req.fd, io::EVENT_IN, [this, data](int fd, uint32_t) {
+			_on_line_events(*this, data, fd);
+		});
+		if (e != err::ERR_NONE)
+		{
+			log::error("watch gpio line events failed: %s", err::to_str(e).c_str());
+			disable_events();
+			return e;
+		}
+		return err::ERR_NONE;
+#else
+		return err::ERR_NOT_IMPL;
+#endif
+	}
+
+	err::Err GPIO::disable_events()
+	{
+		if (!_events)
+			return err::ERR_NONE;
+#if HAVE_GPIO_LINE_EVENTS
+		_stop_events((EventData *)_events, this->_line);
+#endif
+		::close(this->_line);
+		this->_line = -1;
+		EventData *data = (EventData *)_events;
+		_events = nullptr;
+		delete data;
+		return _request_line(_mode, _pull);
+	}
+
+	std::vector<gpio::Event> GPIO::read_events(int timeout_ms, int max_num)
+	{
+		std::vector<gpio::Event> events;
+		EventData *data = (EventData *)_events;
+		if (!data || data->callback)
+			return events;
+		std::unique_lock<std::mutex> lock(data->mutex);
+		if (timeout_ms < 0)
+		{
+			while (data->queue.empty() && !app::need_exit())
+				data->cond.wait_for(lock, std::chrono::milliseconds(100));
+		}
+		else if (timeout_ms > 0)
+			data->cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [data] { return !data->queue.empty(); });
+		size_t num = max_num < 0 ? data->queue.size() : std::min((size_t)max_num, data->queue.size());
+		events.assign(data->queue.begin(), data->queue.begin() + num);
+		data->queue.erase(data->queue.begin(), data->queue.begin() + num);
+		return events;
+	}
+
+	uint64_t GPIO::events_dropped()
+	{
+		EventData *data = (EventData *)_events;
+		if (!data)
+			return 0;
+		std::lock_guard<std::mutex> lock(data->mutex);
+		return data->dropped;
+	}
+
 }; // namespace maix::peripheral::gpio
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add combined transactions, burst register access and SMBus fallback.
  */
 
 
@@ -15,11 +16,39 @@
 #include <linux/i2c.h>
 #include <sys/ioctl.h>
 #include <algorithm>
+#include <errno.h>
+#include <string.h>
 
 #define DEV_PATH "/dev/i2c-%d"
 
 namespace maix::peripheral::i2c
 {
+    // encode memory address to buff(at least 4 bytes), return address bytes number, < 0 if mem_addr_size invalid
+    static int _encode_mem_addr(int mem_addr, int mem_addr_size, bool mem_addr_le, uint8_t *buff)
+    {
+        if (mem_addr_size <= 0 || mem_addr_size % 8 != 0 || mem_addr_size > 32)
+        {
+            log::error("mem_addr_size must be 8, 16, 24 or 32");
+            return -1;
+        }
+        int n = mem_addr_size / 8;
+        for (int i = 0; i < n; i++)
+        {
+            int shift = mem_addr_le ? 8 * i : 8 * (n - i - 1);
+            buff[i] = (uint8_t)(mem_addr >> shift);
+        }
+        return n;
+    }
+
+    static int _smbus_access(int fd, char read_write, uint8_t command, int size, union i2c_smbus_data *data)
+    {
+        struct i2c_smbus_ioctl_data args;
+        args.read_write = read_write;
+        args.command = command;
+        args.size = size;
+        args.data = data;
+        return ::ioctl(fd, I2C_SMBUS, &args);
+    }
 
     std::vector<int> list_devices()
     {
@@ -68,6 +97,9 @@ namespace maix::peripheral::i2c
         _freq = freq;
         _mode = mode;
         _addr_size = addr_size;
+        _slave_addr = -1;
+        if (::ioctl(fd, I2C_FUNCS, &_funcs) < 0)
+            _funcs = I2C_FUNC_I2C;
     }
 
     I2C::~I2C()
@@ -116,10 +148,25 @@ namespace maix::peripheral::i2c
             log::error("bit %d not support", _addr_size);
             return data;
         }
+        _slave_addr = -1;
 
         return data;
     }
 
+    int I2C::_set_slave(int addr)
+    {
+        // I2C_SLAVE is sticky for fd, skip the syscall if address not changed
+        if (addr == _slave_addr)
+            return 0;
+        if (0 != ::ioctl(_fd, I2C_SLAVE, addr))
+        {
+            _slave_addr = -1;
+            return -1;
+        }
+        _slave_addr = addr;
+        return 0;
+    }
+
     int I2C::writeto(int addr, const uint8_t *data, int len)
     {
         if (_mode != i2c::Mode::MASTER)
@@ -128,7 +175,7 @@ namespace maix::peripheral::i2c
             return (int)-err::Err::ERR_NOT_PERMIT;
         }
 
-        if (0 != ioctl(_fd, I2C_SLAVE, addr))
+        if (0 != _set_slave(addr))
         {
             log::error("set slave address failed");
             return (int)-err::Err::ERR_IO;
@@ -155,20 +202,20 @@ namespace maix::peripheral::i2c
 
     Bytes* I2C::readfrom(int addr, int len)
     {
-        Bytes *data = new Bytes(nullptr, len);
-
         if (_mode != i2c::Mode::MASTER)
         {
             log::error("Only for master mode");
             return nullptr;
         }
 
-        if (0 != ioctl(_fd, I2C_SLAVE, addr))
+        if (0 != _set_slave(addr))
         {
             log::error("set slave address failed");
             return nullptr;
         }
 
+        Bytes *data = new Bytes(nullptr, len);
+
         if (len != ::read(_fd, data->data, len))
         {
             log::error("read failed");
@@ -185,53 +232,31 @@ namespace maix::peripheral::i2c
             log::error("Only for master mode");
             return (int)-err::Err::ERR_NOT_PERMIT;
         }
-        if(mem_addr_size % 8 != 0)
+        if (len < 0 || (len > 0 && !data))
+            return (int)-err::Err::ERR_ARGS;
+
+        // address and data in one message, small writes use stack buffer
+        uint8_t stack_buff[64];
+        std::vector<uint8_t> heap_buff;
+        uint8_t *buff = stack_buff;
+        if (len + 4 > (int)sizeof(stack_buff))
         {
-            log::error("mem_addr_size must be multiple of 8");
-            return (int)-err::Err::ERR_IO;
+            heap_buff.resize(len + 4);
+            buff = heap_buff.data();
         }
-
-        if (0 != ioctl(_fd, I2C_SLAVE, addr))
-        {
-            log::error("set slave address failed");
+        int addr_len = _encode_mem_addr(mem_addr, mem_addr_size, mem_addr_le, buff);
+        if (addr_len < 0)
             return (int)-err::Err::ERR_IO;
-        }
+        if (len > 0)
+            memcpy(buff + addr_len, data, len);
 
-        std::vector<unsigned char> data_final;
-
-        if(mem_addr_size == 8)
+        i2c::Msg msg = {addr, false, buff, addr_len + len};
+        int ret = transfer(&msg, 1);
+        if (ret < 0)
         {
-            data_final.push_back((unsigned char)mem_addr);
+            log::error("write failed, mem_addr: 0x%x", mem_addr);
+            return ret;
         }
-        else
-        {
-            if(mem_addr_le)
-            {
-                for(int i = 0; i < mem_addr_size / 8; i++)
-                {
-                    data_final.push_back((unsigned char)(mem_addr & 0xff));
-                    mem_addr >>= 8;
-                }
-            }
-            else
-            {
-                for(int i = 0; i < mem_addr_size / 8; i++)
-                {
-                    data_final.push_back((unsigned char)(mem_addr >> (8 * (mem_addr_size / 8 - i - 1))));
-                }
-            }
-        }
-        for(int i = 0; i < len; i++)
-        {
-            data_final.push_back(data[i]);
-        }
-        int write_len = ::write(_fd, data_final.data(), data_final.size());
-        if (data_final.size() != (size_t)write_len)
-        {
-            log::error("write failed, write_len: %d", write_len);
-            return (int)-err::Err::ERR_IO;
-        }
-
         return len;
     }
 
@@ -247,74 +272,197 @@ namespace maix::peripheral::i2c
 
     Bytes* I2C::readfrom_mem(int addr, int mem_addr, int len, int mem_addr_size, bool mem_addr_le)
     {
-        // write mem_addr and restart to read
-        if (_mode != i2c::Mode::MASTER)
+        if (len < 0)
+            return nullptr;
+        Bytes *data = new Bytes(nullptr, len);
+        if (readfrom_mem_into(addr, mem_addr, data->data, len, mem_addr_size, mem_addr_le) != len)
         {
-            log::error("Only for master mode");
+            log::error("read failed");
+            delete data;
             return nullptr;
         }
-        if(mem_addr_size % 8 != 0)
+        return data;
+    }
+
+    int I2C::readfrom_mem_into(int addr, int mem_addr, uint8_t *buff, int len, int mem_addr_size, bool mem_addr_le)
+    {
+        if (len <= 0 || !buff)
+            return (int)-err::Err::ERR_ARGS;
+        uint8_t addr_buff[4];
+        int addr_len = _encode_mem_addr(mem_addr, mem_addr_size, mem_addr_le, addr_buff);
+        if (addr_len < 0)
+            return (int)-err::Err::ERR_ARGS;
+        // write mem_addr and restart to read
+        i2c::Msg msgs[2] = {
+            {addr, false, addr_buff, addr_len},
+            {addr, true, buff, len},
+        };
+        int ret = transfer(msgs, 2);
+        return ret < 0 ? ret : len;
+    }
+
+    int I2C::readfrom_mems(int addr, const i2c::MemRead *reads, int num, int mem_addr_size, bool mem_addr_le)
+    {
+        if (!reads || num <= 0)
+            return (int)-err::Err::ERR_ARGS;
+        // write + read pair for each register, as many pairs as one I2C_RDWR allows
+        constexpr int max_pairs = I2C_RDWR_IOCTL_MAX_MSGS / 2;
+        uint8_t addr_buff[max_pairs][4];
+        i2c::Msg msgs[max_pairs * 2];
+        for (int start = 0; start < num; start += max_pairs)
         {
-            log::error("mem_addr_size must be multiple of 8");
-            return nullptr;
+            int n = std::min(num - start, max_pairs);
+            for (int i = 0; i < n; ++i)
+            {
+                const i2c::MemRead &r = reads[start + i];
+                if (r.len <= 0 || !r.buff)
+                    return (int)-err::Err::ERR_ARGS;
+                int addr_len = _encode_mem_addr(r.mem_addr, mem_addr_size, mem_addr_le, addr_buff[i]);
+                if (addr_len < 0)
+                    return (int)-err::Err::ERR_ARGS;
+                msgs[i * 2] = {addr, false, addr_buff[i], addr_len};
+                msgs[i * 2 + 1] = {addr, true, r.buff, r.len};
+            }
+            int ret = transfer(msgs, n * 2);
+            if (ret < 0)
+                return ret;
         }
+        return num;
+    }
 
-        // write mem_addr first and restart to read
-        if (0 != ioctl(_fd, I2C_SLAVE, addr))
+    int I2C::transfer(i2c::Msg *msgs, int num)
+    {
+        if (_mode != i2c::Mode::MASTER)
         {
-            log::error("set slave address failed");
-            return nullptr;
+            log::error("Only for master mode");
+            return (int)-err::Err::ERR_NOT_PERMIT;
         }
+        if (!msgs || num <= 0)
+            return (int)-err::Err::ERR_ARGS;
+        if (!(_funcs & I2C_FUNC_I2C))
+            return _smbus_transfer(msgs, num);
 
-        std::vector<unsigned char> data_final;
-        if(mem_addr_size == 8)
+        struct i2c_msg kmsgs[I2C_RDWR_IOCTL_MAX_MSGS];
+        for (int start = 0, n = 0; start < num; start += n)
         {
-            data_final.push_back((unsigned char)mem_addr);
+            n = std::min(num - start, I2C_RDWR_IOCTL_MAX_MSGS);
+            // split only before a write, reads stay in one transaction with the write before them,
+            // or stop + start between them may reset register address of slave
+            if (start + n < num)
+            {
+                while (n > 0 && msgs[start + n].read)
+                    --n;
+                if (n == 0)
+                {
+                    log::error("i2c transfer too many reads after one write, max %d messages in one transaction", I2C_RDWR_IOCTL_MAX_MSGS);
+                    return (int)-err::Err::ERR_ARGS;
+                }
+            }
+            for (int i = 0; i < n; ++i)
+            {
+                const i2c::Msg &m = msgs[start + i];
+                if (m.len < 0 || m.len > 0xffff || (m.len > 0 && !m.buff))
+                    return (int)-err::Err::ERR_ARGS;
+                kmsgs[i].addr = m.addr;
+                kmsgs[i].flags = m.read ? I2C_M_RD : 0;
+                kmsgs[i].len = m.len;
+                kmsgs[i].buf = m.buff;
+            }
+            struct i2c_rdwr_ioctl_data msgset;
+            msgset.msgs = kmsgs;
+            msgset.nmsgs = n;
+            if (::ioctl(_fd, I2C_RDWR, &msgset) != n)
+            {
+                log::error("i2c transfer failed: %s", strerror(errno));
+                return (int)-err::Err::ERR_IO;
+            }
         }
-        else
+        return num;
+    }
+
+    int I2C::_smbus_transfer(i2c::Msg *msgs, int num)
+    {
+        union i2c_smbus_data data;
+        bool block_read = _funcs & I2C_FUNC_SMBUS_READ_I2C_BLOCK;
+        bool block_write = _funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK;
+        for (int i = 0; i < num; ++i)
         {
-            if(mem_addr_le)
+            i2c::Msg &m = msgs[i];
+            if (m.len <= 0 || !m.buff)
+                return (int)-err::Err::ERR_ARGS;
+            if (0 != _set_slave(m.addr))
+            {
+                log::error("set slave address failed");
+                return (int)-err::Err::ERR_IO;
+            }
+            int ret = 0;
+            if (!m.read && i + 1 < num && msgs[i + 1].read && msgs[i + 1].addr == m.addr)
             {
-                for(int i = 0; i < mem_addr_size / 8; i++)
+                // register read, register address is SMBus command
+                i2c::Msg &r = msgs[i + 1];
+                if (m.len != 1 || r.len <= 0 || !r.buff)
                 {
-                    data_final.push_back((unsigned char)(mem_addr & 0xff));
-                    mem_addr >>= 8;
+                    log::error("SMBus bus only supports 8 bit register address");
+                    return (int)-err::Err::ERR_NOT_IMPL;
                 }
+                for (int off = 0; off < r.len && ret >= 0;)
+                {
+                    uint8_t cmd = m.buff[0] + off;
+                    if (block_read)
+                    {
+                        int n = std::min(r.len - off, I2C_SMBUS_BLOCK_MAX);
+                        data.block[0] = n;
+                        ret = _smbus_access(_fd, I2C_SMBUS_READ, cmd, I2C_SMBUS_I2C_BLOCK_DATA, &data);
+                        memcpy(r.buff + off, data.block + 1, n);
+                        off += n;
+                    }
+                    else
+                    {
+                        ret = _smbus_access(_fd, I2C_SMBUS_READ, cmd, I2C_SMBUS_BYTE_DATA, &data);
+                        r.buff[off++] = data.byte;
+                    }
+                }
+                ++i;
+            }
+            else if (m.read)
+            {
+                for (int off = 0; off < m.len && ret >= 0; ++off)
+                {
+                    ret = _smbus_access(_fd, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE, &data);
+                    m.buff[off] = data.byte;
+                }
+            }
+            else if (m.len == 1)
+            {
+                ret = _smbus_access(_fd, I2C_SMBUS_WRITE, m.buff[0], I2C_SMBUS_BYTE, nullptr);
             }
             else
             {
-
-                for(int i = 0; i < mem_addr_size / 8; i++)
+                // first byte is register address
+                for (int off = 1; off < m.len && ret >= 0;)
                 {
-                    data_final.push_back((unsigned char)(mem_addr >> (8 * (mem_addr_size / 8 - i - 1))));
+                    uint8_t cmd = m.buff[0] + off - 1;
+                    if (block_write)
+                    {
+                        int n = std::min(m.len - off, I2C_SMBUS_BLOCK_MAX);
+                        data.block[0] = n;
+                        memcpy(data.block + 1, m.buff + off, n);
+                        ret = _smbus_access(_fd, I2C_SMBUS_WRITE, cmd, I2C_SMBUS_I2C_BLOCK_DATA, &data);
+                        off += n;
+                    }
+                    else
+                    {
+                        data.byte = m.buff[off++];
+                        ret = _smbus_access(_fd, I2C_SMBUS_WRITE, cmd, I2C_SMBUS_BYTE_DATA, &data);
+                    }
                 }
             }
+            if (ret < 0)
+            {
+                log::error("i2c SMBus transfer failed: %s", strerror(errno));
+                return (int)-err::Err::ERR_IO;
+            }
         }
-        // write read with I2C_RDWR
-        struct i2c_msg msgs[2];
-        msgs[0].addr = addr;
-        msgs[0].flags = 0;
-        msgs[0].len = data_final.size();
-        msgs[0].buf = data_final.data();
-
-        Bytes *data = new Bytes(nullptr, len);
-        msgs[1].addr = addr;
-        msgs[1].flags = I2C_M_RD;
-        msgs[1].len = len;
-        msgs[1].buf = data->data;
-
-        struct i2c_rdwr_ioctl_data msgset;
-        msgset.msgs = msgs;
-        msgset.nmsgs = 2;
-
-        int read_len = ioctl(_fd, I2C_RDWR, &msgset);
-        if (read_len != 2)
-        {
-            log::error("read failed");
-            delete data;
-            return nullptr;
-        }
-
-        return data;
+        return num;
     }
 }
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add multi-segment transfer and async transfer queue.
  */
 
 #include "maix_spi.hpp"
@@ -18,8 +19,17 @@
 #include <sys/select.h>
 #include <linux/spi/spidev.h>
 #include <errno.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "maix_spi_port.hpp"
 
+#define SPI_MAX_SEGMENTS 64     // segments of one ioctl, kernel max is 511
+#define SPI_QUEUE_SIZE   16     // async queue slots
+#define SPI_DEFAULT_BUFSIZ 4096 // spidev default bufsiz
+
 namespace maix::peripheral::spi
 {
     static inline void __close_fd(int* fd)
@@ -42,74 +52,66 @@ namespace maix::peripheral::spi
         return err::Exception(err::ERR_RUNTIME, __get_errno_msg());
     }
 
-    static inline int __spi_transfer(int fd, unsigned char used_soft_cs,
-                                        unsigned int speed_hz, unsigned char bits,
-                                        const uint8_t *txbuf, uint8_t *rxbuf, size_t len) {
-        struct spi_ioc_transfer transfer;
-
-        ::memset(&transfer, 0, sizeof(struct spi_ioc_transfer));
-        transfer.tx_buf = (uintptr_t)txbuf;
-        transfer.rx_buf = (uintptr_t)rxbuf;
-        transfer.len = len;
-        transfer.delay_usecs = 0;
-        transfer.speed_hz = speed_hz;
-        transfer.bits_per_word = bits;
-        transfer.cs_change = used_soft_cs;
-        // log::info("[__spi_transfer] cs_change = %d", transfer.cs_change);
-
-        if (txbuf) {
-            auto data_size = len;
-            auto p_data = (uint8_t *)txbuf;
-            uint8_t tmp_data = 0;
-            if (data_size > 50)  {
-                if (data_size % 4 == 0) {
-                    for (size_t i = 0; i < data_size; i += 4) {
-                        for (size_t j = i; j < i + 2; j++) {
-                            tmp_data = p_data[j];
-                            p_data[j] = p_data[i + i + 4 - j - 1];
-                            p_data[i + i + 4 - j - 1] = tmp_data;
-                        }
-                    }
-                } else if (data_size % 2 == 0) {
-                    for (size_t i = 0; i < data_size; i += 2) {
-                        tmp_data = p_data[i];
-                        p_data[i] = p_data[i + 1];
-                        p_data[i + 1] = tmp_data;
-                    }
+    // controller needs words byte swapped for long transfers, swap twice restores data
+    static inline bool __need_swap(size_t data_size)
+    {
+        return data_size > 50 && data_size % 2 == 0;
+    }
+
+    static inline void __swap_words(uint8_t *p_data, size_t data_size)
+    {
+        uint8_t tmp_data = 0;
+        if (!__need_swap(data_size))
+            return;
+        if (data_size % 4 == 0) {
+            for (size_t i = 0; i < data_size; i += 4) {
+                for (size_t j = i; j < i + 2; j++) {
+                    tmp_data = p_data[j];
+                    p_data[j] = p_data[i + i + 4 - j - 1];
+                    p_data[i + i + 4 - j - 1] = tmp_data;
                 }
             }
-        }
-        int res = ::ioctl(fd, SPI_IOC_MESSAGE(1), &transfer);
-        if (res < 1) {
-            log::error("[__spi_transfer] run ioctl failed! res:%d", res);
-            return res;
-        }
-        if (rxbuf) {
-            auto data_size = len;
-            auto p_data = (uint8_t *)rxbuf;
-            uint8_t tmp_data = 0;
-            if (data_size > 50)  {
-                if (data_size % 4 == 0) {
-                    for (size_t i = 0; i < data_size; i += 4) {
-                        for (size_t j = i; j < i + 2; j++) {
-                            tmp_data = p_data[j];
-                            p_data[j] = p_data[i + i + 4 - j - 1];
-                            p_data[i + i + 4 - j - 1] = tmp_data;
-                        }
-                    }
-                } else if (data_size % 2 == 0) {
-                    for (size_t i = 0; i < data_size; i += 2) {
-                        tmp_data = p_data[i];
-                        p_data[i] = p_data[i + 1];
-                        p_data[i + 1] = tmp_data;
-                    }
-                }
+        } else if (data_size % 2 == 0) {
+            for (size_t i = 0; i < data_size; i += 2) {
+                tmp_data = p_data[i];
+                p_data[i] = p_data[i + 1];
+                p_data[i + 1] = tmp_data;
             }
         }
+    }
 
-        return 0;
+    static int __get_bufsiz()
+    {
+        int bufsiz = SPI_DEFAULT_BUFSIZ;
+        FILE *f = fopen("/sys/module/spidev/parameters/bufsiz", "r");
+        if (f) {
+            if (fscanf(f, "%d", &bufsiz) != 1 || bufsiz <= 0)
+                bufsiz = SPI_DEFAULT_BUFSIZ;
+            fclose(f);
+        }
+        return bufsiz;
     }
 
+    struct Job
+    {
+        std::vector<spi::Transfer> xfers; // capacity reused, no allocation after warm up
+        spi::TransferCallback callback;
+    };
+
+    struct SPIPriv
+    {
+        std::mutex bus;      // one message on bus at a time
+        std::mutex mutex;    // protect queue
+        std::condition_variable cond;
+        std::condition_variable done_cond;
+        Job jobs[SPI_QUEUE_SIZE];
+        int head = 0;
+        int count = 0;       // queued and transferring jobs, job slot is freed after its callback
+        bool exit = false;
+        std::thread worker;
+        std::vector<uint8_t> tx_swapped; // word swapped copy of tx data, caller's buffer is not modified, protected by bus
+    };
+
     SPI::SPI(int id, spi::Mode mode, int freq, int polarity, int phase, int bits,
             int hw_cs, std::string soft_cs,
             bool cs_active_low)
@@ -168,10 +170,23 @@ namespace maix::peripheral::spi
 
         if (::ioctl(_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0)
             throw __ioctl_error(&_fd);
+
+        _bufsiz = __get_bufsiz();
+        _priv = new SPIPriv();
     }
 
     SPI::~SPI()
     {
+        SPIPriv *priv = (SPIPriv *)_priv;
+        {
+            // worker transfers all queued jobs before exit
+            std::lock_guard<std::mutex> lock(priv->mutex);
+            priv->exit = true;
+        }
+        priv->cond.notify_all();
+        if (priv->worker.joinable())
+            priv->worker.join();
+        delete priv;
         if (_used_soft_cs) {
             delete _cs;
         }
@@ -190,14 +205,22 @@ namespace maix::peripheral::spi
 
     int SPI::write(std::vector<unsigned char> data)
     {
-        this->write_read(data, data.size());
-        return data.size();
+        if (data.empty())
+            return 0;
+        spi::Transfer t;
+        t.tx = data.data();
+        t.len = data.size();
+        return transfer(&t, 1);
     }
 
     int SPI::write(Bytes *data)
     {
-        this->write_read(data, data->data_len);
-        return data->data_len;
+        if (!data || data->data_len == 0)
+            return 0;
+        spi::Transfer t;
+        t.tx = data->data;
+        t.len = data->data_len;
+        return transfer(&t, 1);
     }
 
     std::vector<unsigned char> SPI::write_read(std::vector<unsigned char> data, int read_len)
@@ -205,41 +228,18 @@ namespace maix::peripheral::spi
         if (read_len <= 0)
             return std::vector<unsigned char>();
 
-        auto w_size = data.size();
-        size_t len = std::max(w_size, static_cast<size_t>(read_len));
-        if (len != w_size) {
-            data.resize(len, 0x00);
-        }
-
-        auto wbuf = new unsigned char[len];
-        if (nullptr == wbuf) {
-            log::error("cannot alloc %d bytes for SPI::write_read", len);
-            return std::vector<unsigned char>();
-        }
-        ::memset(wbuf, 0x00, len);
-        ::memcpy(wbuf, data.data(), data.size());
+        size_t len = std::max(data.size(), static_cast<size_t>(read_len));
+        data.resize(len, 0x00);
 
-        auto rbuf = new unsigned char[len];
-        if (nullptr == rbuf) {
-            log::error("cannot alloc %d bytes for SPI::write_read", len);
-            delete[] wbuf;
+        // full duplex in place, data is already a copy
+        spi::Transfer t;
+        t.tx = data.data();
+        t.rx = data.data();
+        t.len = len;
+        if (transfer(&t, 1) < 0)
             return std::vector<unsigned char>();
-        }
-
-        if (_used_soft_cs)
-            this->enable_cs(true);
-        if (__spi_transfer(_fd, _used_soft_cs, _freq, _bits, wbuf, rbuf, len) < 0) {
-            delete[] wbuf;
-            delete[] rbuf;
-            return std::vector<unsigned char>();
-        }
-        if (_used_soft_cs)
-            this->enable_cs(false);
-
-        auto res = std::vector<unsigned char>(rbuf, rbuf+read_len);
-        delete[] wbuf;
-        delete[] rbuf;
-        return res;
+        data.resize(read_len);
+        return data;
     }
 
     Bytes *SPI::write_read(Bytes *data, int read_len)
@@ -251,42 +251,238 @@ namespace maix::peripheral::spi
         if (nullptr != data)
             w_size = data->size();
         size_t len = std::max(w_size, static_cast<size_t>(read_len));
-        auto wbuf = new unsigned char[len];
-        if (wbuf == nullptr) {
-            log::error("cannot alloc %d bytes for SPI::write_read", len);
-            return nullptr;
-        }
-        ::memset(wbuf, 0x00, len);
+        Bytes *res = new Bytes(nullptr, len);
+        ::memset(res->data, 0x00, len);
         if (nullptr != data && data->size() > 0) {
-            std::copy(data->data, data->data+data->data_len, wbuf);
+            std::copy(data->data, data->data+data->data_len, res->data);
         }
 
-        auto rbuf = new unsigned char[len];
-        if (rbuf == nullptr) {
-            log::error("cannot alloc %d bytes for SPI::write_read", len);
-            delete[] wbuf;
+        spi::Transfer t;
+        t.tx = res->data;
+        t.rx = res->data;
+        t.len = len;
+        if (transfer(&t, 1) < 0) {
+            delete res;
             return nullptr;
         }
+        res->data_len = read_len;
+        return res;
+    }
+
+    bool SPI::is_busy()
+    {
+        return pending() > 0;
+    }
+
+    // one ioctl, keep_cs means more ioctls of the same message follow, ask driver to keep CS selected
+    int SPI::_message(spi::Transfer *xfers, int num, bool keep_cs)
+    {
+        struct spi_ioc_transfer tr[SPI_MAX_SEGMENTS];
+        SPIPriv *priv = (SPIPriv *)_priv;
+        int total = 0;
+        size_t swap_size = 0;
+
+        for (int i = 0; i < num; ++i) {
+            if (xfers[i].tx && __need_swap(xfers[i].len))
+                swap_size += xfers[i].len;
+        }
+        if (priv->tx_swapped.size() < swap_size)
+            priv->tx_swapped.resize(swap_size);
+        uint8_t *swap_buf = priv->tx_swapped.data();
+        ::memset(tr, 0, sizeof(struct spi_ioc_transfer) * num);
+        for (int i = 0; i < num; ++i) {
+            spi::Transfer &t = xfers[i];
+            tr[i].tx_buf = (uintptr_t)t.tx;
+            tr[i].rx_buf = (uintptr_t)t.rx;
+            tr[i].len = t.len;
+            tr[i].speed_hz = t.speed_hz > 0 ? t.speed_hz : _freq;
+            tr[i].bits_per_word = t.bits > 0 ? t.bits : _bits;
+            tr[i].delay_usecs = std::min(std::max(t.delay_us, 0), 65535);
+            // soft CS is controlled by us, for the last segment cs_change means keep CS selected after message
+            if (i < num - 1)
+                tr[i].cs_change = _used_soft_cs ? 0 : t.cs_change;
+            else
+                tr[i].cs_change = (keep_cs && !_used_soft_cs) ? !t.cs_change : 0;
+            if (t.tx && __need_swap(t.len)) {
+                ::memcpy(swap_buf, t.tx, t.len);
+                __swap_words(swap_buf, t.len);
+                tr[i].tx_buf = (uintptr_t)swap_buf;
+                swap_buf += t.len;
+            }
+            total += t.len;
+        }
+        int res = ::ioctl(_fd, SPI_IOC_MESSAGE(num), tr);
+        if (res < 0) {
+            int e = errno;
+            log::error("[SPI] transfer %d segments failed: %s", num, strerror(e));
+            return e == EMSGSIZE || e == EINVAL ? -err::ERR_ARGS : -err::ERR_IO;
+        }
+        for (int i = 0; i < num; ++i) {
+            if (xfers[i].rx)
+                __swap_words(xfers[i].rx, xfers[i].len);
+        }
+        return total;
+    }
+
+    int SPI::_transfer(spi::Transfer *xfers, int num)
+    {
+        int total = 0;
+        int start = 0;
+        int bytes = 0;
+        int ret = 0;
+
+        // send xfers[start, end), then deselect and select soft CS if requested by last segment
+        auto flush = [&](int end) -> int {
+            if (end <= start)
+                return 0;
+            bool last = end == num;
+            int n = _message(xfers + start, end - start, !last);
+            if (n < 0)
+                return n;
+            total += n;
+            if (_used_soft_cs && !last && xfers[end - 1].cs_change) {
+                enable_cs(false);
+                enable_cs(true);
+            }
+            start = end;
+            bytes = 0;
+            return 0;
+        };
 
         if (_used_soft_cs)
-            this->enable_cs(true);
-        if (__spi_transfer(_fd, _used_soft_cs, _freq, _bits, wbuf, rbuf, len) < 0) {
-            delete[] rbuf;
-            delete[] wbuf;
-            return nullptr;
+            enable_cs(true);
+        for (int i = 0; i < num && ret == 0; ++i) {
+            spi::Transfer &t = xfers[i];
+            if (t.len <= 0 || t.len > _bufsiz * 1024) {
+                log::error("[SPI] segment %d length %d invalid", i, t.len);
+                ret = -err::ERR_ARGS;
+                break;
+            }
+            if (t.len > _bufsiz) {
+                // split long segment to bufsiz pieces, each piece one ioctl
+                if ((ret = flush(i)) < 0)
+                    break;
+                for (int off = 0; off < t.len; off += _bufsiz) {
+                    spi::Transfer piece = t;
+                    bool last_piece = off + _bufsiz >= t.len;
+                    piece.tx = t.tx ? t.tx + off : nullptr;
+                    piece.rx = t.rx ? t.rx + off : nullptr;
+                    piece.len = std::min(_bufsiz, t.len - off);
+                    piece.delay_us = last_piece ? t.delay_us : 0;
+                    piece.cs_change = last_piece ? t.cs_change : false;
+                    int n = _message(&piece, 1, !(last_piece && i == num - 1));
+                    if (n < 0) {
+                        ret = n;
+                        break;
+                    }
+                    total += n;
+                }
+                start = i + 1;
+                if (ret == 0 && _used_soft_cs && i < num - 1 && t.cs_change) {
+                    enable_cs(false);
+                    enable_cs(true);
+                }
+                continue;
+            }
+            if (i - start == SPI_MAX_SEGMENTS || bytes + t.len > _bufsiz) {
+                if ((ret = flush(i)) < 0)
+                    break;
+            }
+            bytes += t.len;
+            if (_used_soft_cs && t.cs_change)
+                ret = flush(i + 1);
         }
+        if (ret == 0)
+            ret = flush(num);
         if (_used_soft_cs)
-            this->enable_cs(false);
+            enable_cs(false);
+        return ret < 0 ? ret : total;
+    }
 
-        auto res = new Bytes(rbuf, read_len);
-        delete[] wbuf;
-        delete[] rbuf;
-        return res;
+    int SPI::transfer(spi::Transfer *xfers, int num)
+    {
+        if (!xfers || num <= 0)
+            return -err::ERR_ARGS;
+        SPIPriv *priv = (SPIPriv *)_priv;
+        std::lock_guard<std::mutex> lock(priv->bus);
+        return _transfer(xfers, num);
     }
 
-    bool SPI::is_busy()
+    // SPIPriv of the worker running on this thread, wait() compares it instead of reading worker id,
+    // which is assigned by submit() under lock
+    static thread_local SPIPriv *__current_worker = nullptr;
+
+    static void __worker(SPI *spi, SPIPriv *priv)
+    {
+        __current_worker = priv;
+        std::unique_lock<std::mutex> lock(priv->mutex);
+        while (true) {
+            priv->cond.wait(lock, [priv] { return priv->exit || priv->count > 0; });
+            if (priv->count == 0)
+                break;
+            // slot is not reused until count decreased, safe to use without lock
+            Job &job = priv->jobs[priv->head];
+            lock.unlock();
+            int ret = spi->transfer(job.xfers.data(), job.xfers.size());
+            if (job.callback) {
+                try {
+                    job.callback(ret);
+                } catch (const std::exception &e) {
+                    log::error("[SPI] transfer callback exception: %s", e.what());
+                }
+                job.callback = nullptr;
+            }
+            lock.lock();
+            priv->head = (priv->head + 1) % SPI_QUEUE_SIZE;
+            --priv->count;
+            priv->cond.notify_all();
+            priv->done_cond.notify_all();
+        }
+    }
+
+    err::Err SPI::submit(spi::Transfer *xfers, int num, spi::TransferCallback callback, int timeout_ms)
+    {
+        if (!xfers || num <= 0)
+            return err::ERR_ARGS;
+        SPIPriv *priv = (SPIPriv *)_priv;
+        std::unique_lock<std::mutex> lock(priv->mutex);
+        auto have_space = [priv] { return priv->count < SPI_QUEUE_SIZE; };
+        if (timeout_ms < 0)
+            priv->cond.wait(lock, have_space);
+        else if (!priv->cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), have_space))
+            return err::ERR_BUSY;
+        if (priv->exit)
+            return err::ERR_NOT_READY;
+        Job &job = priv->jobs[(priv->head + priv->count) % SPI_QUEUE_SIZE];
+        job.xfers.assign(xfers, xfers + num);
+        job.callback = std::move(callback);
+        ++priv->count;
+        if (!priv->worker.joinable())
+            priv->worker = std::thread(__worker, this, priv);
+        lock.unlock();
+        priv->cond.notify_all();
+        return err::ERR_NONE;
+    }
+
+    err::Err SPI::wait(int timeout_ms)
+    {
+        SPIPriv *priv = (SPIPriv *)_priv;
+        if (__current_worker == priv)
+            return err::ERR_NOT_PERMIT; // called in callback, would wait itself
+        std::unique_lock<std::mutex> lock(priv->mutex);
+        auto done = [priv] { return priv->count == 0; };
+        if (timeout_ms < 0)
+            priv->done_cond.wait(lock, done);
+        else if (!priv->done_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), done))
+            return err::ERR_TIMEOUT;
+        return err::ERR_NONE;
+    }
+
+    int SPI::pending()
     {
-        return false;
+        SPIPriv *priv = (SPIPriv *)_priv;
+        std::lock_guard<std::mutex> lock(priv->mutex);
+        return priv->count;
     }
 
     void SPI::enable_cs(bool enable)
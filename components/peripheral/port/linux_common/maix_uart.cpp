@@ -10,6 +10,7 @@
 #include "maix_time.hpp"
 #include "maix_fs.hpp"
 #include "maix_thread.hpp"
+#include "maix_io_reactor.hpp"
 #include "maix_app.hpp"
 #include <linux/types.h>
 #include <linux/stat.h>
@@ -20,10 +21,29 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/mman.h>
+#include <mutex>
+#include <algorithm>
 #include "maix_uart_port.hpp"
 
 namespace maix::peripheral::uart
 {
+	/**
+	 * Received data of callback mode, data is collected until line idle then delivered in one callback,
+	 * same as read(-1, -1) did in the read thread before.
+	 */
+	struct RxAggregate
+	{
+		std::mutex lock;
+		std::vector<uint8_t> pending;
+		uint64_t last_us = 0;
+		int idle_us = 1000;
+		int timer = -1;         // idle check timer id, -1 if not armed
+		bool closed = false;
+		std::function<void()> on_timer;
+	};
+
+	static const size_t RX_AGGREGATE_MAX = 64 * 1024; // deliver without waiting idle if too much data
+
 	static UART* _comm_uart = nullptr;
 	static std::function<void(uart::UART*)> _comm_callback = nullptr;
 	static int _get_baudrate(int baud)
@@ -236,7 +256,7 @@ namespace maix::peripheral::uart
 		_parity = parity;
 		_stopbits = stopbits;
 		_flow_ctrl = flow_ctrl;
-		_read_thread = nullptr;
+		_callback_added = false;
 		if (!port.empty())
 		{
 			err::Err e = this->open();
@@ -323,6 +343,8 @@ namespace maix::peripheral::uart
 		// self.oneByteTime = 1 / (self.com.baudrate / (self.com.bytesize + 2 + self.com.stopbits)) # 1 byte use time
 		_one_byte_time_us = 1000000.0 / (_baudrate / (_databits + 2 + (_stopbits == STOP_1_5 ? 1.5 : _stopbits)));
 		log::debug("one byte time: %d", _one_byte_time_us);
+		if (this->callback)
+			return _add_callback();
 		return err::ERR_NONE;
 	}
 
@@ -335,24 +357,10 @@ namespace maix::peripheral::uart
 	{
 		if (_fd <= 0)
 			return err::ERR_NONE;
+		// remove before close so fd number won't be reused while still watched
+		_remove_callback();
 		int ret = _uart_deinit(_fd);
 		_fd = -1;
-		if(_read_thread)
-		{
-			_read_thread_need_exit = true;
-			uint64_t t = time::ticks_ms();
-			while(!_read_thread_exit)
-			{
-				time::sleep_ms(10);
-				if(time::ticks_ms() - t > 5000)
-				{
-					log::error("waiting uart read thread exit");
-					t = time::ticks_ms();
-				}
-			}
-			delete _read_thread;
-			_read_thread = nullptr;
-		}
 		if (ret != 0)
 		{
 			log::error("uart close failed\r\n");
@@ -361,39 +369,99 @@ namespace maix::peripheral::uart
 		return err::ERR_NONE;
 	}
 
-	void UART::set_received_callback(std::function<void(uart::UART&, Bytes&)> callback)
+	err::Err UART::_add_callback()
 	{
-		if(!_read_thread)
+		std::function<void(uart::UART&, Bytes&)> cb = this->callback;
+		std::shared_ptr<RxAggregate> rx = std::make_shared<RxAggregate>();
+		rx->idle_us = std::max(1000, _one_byte_time_us * 30);
+		RxAggregate *rx_ptr = rx.get(); // rx owns on_timer, capture raw pointer to avoid reference cycle
+		rx->on_timer = [this, cb, rx_ptr]() {
+			RxAggregate *rx = rx_ptr;
+			std::unique_lock<std::mutex> lock(rx->lock);
+			if (rx->closed)
+				return;
+			uint64_t idle = time::ticks_us() - rx->last_us;
+			if (!rx->pending.empty() && idle < (uint64_t)rx->idle_us)
+			{
+				int ms = (rx->idle_us - idle + 999) / 1000;
+				rx->timer = io::Reactor::global().add_timer(ms, rx->on_timer, true);
+				return;
+			}
+			std::vector<uint8_t> data;
+			data.swap(rx->pending);
+			// keep timer id until callback returns, so close() waits this callback by remove_timer
+			int timer = rx->timer;
+			lock.unlock();
+			if (!data.empty())
+			{
+				Bytes bytes(data.data(), data.size(), false, false);
+				cb(*this, bytes);
+			}
+			lock.lock();
+			if (rx->timer == timer)
+				rx->timer = -1;
+			if (!rx->closed && !rx->pending.empty() && rx->timer < 0)
+				rx->timer = io::Reactor::global().add_timer(rx->idle_us / 1000, rx->on_timer, true);
+		};
+		// data is read into reactor's buffer, and appended to pending data until line idle
+		err::Err e = io::Reactor::global().add_reader(_fd, 4096, [this, cb, rx](uint8_t *data, int len) {
+			if (len < 0)
+			{
+				log::error("uart %s read failed, stop receive callback", _uart_port.c_str());
+				return;
+			}
+			std::unique_lock<std::mutex> lock(rx->lock);
+			rx->pending.insert(rx->pending.end(), data, data + len);
+			rx->last_us = time::ticks_us();
+			if (rx->pending.size() >= RX_AGGREGATE_MAX)
+			{
+				std::vector<uint8_t> full;
+				full.swap(rx->pending);
+				lock.unlock();
+				Bytes bytes(full.data(), full.size(), false, false);
+				cb(*this, bytes);
+				return;
+			}
+			if (rx->timer < 0)
+				rx->timer = io::Reactor::global().add_timer(rx->idle_us / 1000, rx->on_timer, true);
+		});
+		if (e != err::ERR_NONE)
 		{
-			_read_thread_need_exit = false;
-			_read_thread_exit = false;
-			_read_thread = new thread::Thread([callback](void *args){
-				UART *uart = (UART*)args;
-				while(!app::need_exit() && !uart->_read_thread_need_exit)
-				{
-					Bytes *data = NULL;
-					try
-					{
-						data = uart->read(-1, -1);
-					}
-					catch(const err::Exception& e)
-					{
-						log::error("read file failed");
-						break;
-					}
-					if(!data)
-					{
-						log::error("uart read data is null");
-						break;
-					}
-					callback(*uart, *data);
-					delete data;
-				}
-				uart->_read_thread_exit = true;
-			}, this);
-			_read_thread->detach();
+			log::error("add uart %s receive callback failed: %s", _uart_port.c_str(), err::to_str(e).c_str());
+			return e;
+		}
+		_rx = rx;
+		_callback_added = true;
+		return err::ERR_NONE;
+	}
+
+	void UART::_remove_callback()
+	{
+		if (!_callback_added)
+			return;
+		io::Reactor::global().remove(_fd);
+		_callback_added = false;
+		std::shared_ptr<RxAggregate> rx = std::static_pointer_cast<RxAggregate>(_rx);
+		_rx.reset();
+		if (!rx)
+			return;
+		int timer;
+		{
+			std::lock_guard<std::mutex> lock(rx->lock);
+			rx->closed = true;
+			timer = rx->timer;
 		}
+		// wait idle timer callback finish, it may be calling user callback
+		if (timer > 0)
+			io::Reactor::global().remove_timer(timer);
+	}
+
+	void UART::set_received_callback(std::function<void(uart::UART&, Bytes&)> callback)
+	{
+		_remove_callback();
 		this->callback = callback;
+		if (this->callback && _fd > 0)
+			_add_callback();
 	}
 
 	int UART::write(const uint8_t *buff, int len)
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Watch key devices and power key irq by io::Reactor instead of own threads.
  */
 
 #include "maix_basic.hpp"
@@ -20,6 +21,8 @@
 #include "maix_app.hpp"
 #include "maix_log.hpp"
 #include "maix_i2c.hpp"
+#include "maix_io_reactor.hpp"
+#include <mutex>
 
 #define KEY_DEVICE "/dev/input/event_keys"
 #define KEY_DEVICE0 "/dev/input/event0"
@@ -70,163 +73,131 @@ namespace maix::peripheral::key
     class Port_Data
     {
     public:
-        thread::Thread *thread;
-        thread::Thread *powerkey_thread;
+        std::mutex mutex;
         int fd, io_fd, uinput_fd;
         int long_press_time;
-        bool read_thread_exit;
-        bool read_thread_need_exit;
-        bool powerkey_thread_exit;
-        bool powerkey_thread_need_exit;
+        int long_press_timer;
+        uint64_t press_seq;
+        int fail_count;
+        bool powerkey_added;
         std::vector<int> fds;
         Key *key;
         std::function<void(int, int)> callback;
     };
 
-
-    static void _read_process(void *args)
+    // called in reactor worker, callbacks of different key devices are serialized by data->mutex
+    static void _on_key_event(Port_Data *data, int fd)
     {
-        Port_Data *data = (Port_Data *)args;
         int key = 0;
         int value = 0;
-        uint64_t tick = 0;
-        // epoll wait key event
-        struct epoll_event ev;
-        int epoll_fd = epoll_create(1);
-        if (epoll_fd < 0)
+        int cancel_timer = -1;
+        bool start_timer = false;
+        uint64_t seq = 0;
         {
-            data->read_thread_exit = true;
-            log::error("create epoll failed: %s", strerror(errno));
-            return;
-        }
-        ev.events = EPOLLIN;
-        for (int fd : data->fds) {
-            if (fd > 0) {
-                ev.data.fd = fd;
-                if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
-                    log::error("epoll_ctl add failed for fd %d: %s", fd, strerror(errno));
-                    data->read_thread_exit = true;
-                    close(epoll_fd);
-                    return;
-                }
-            }
-        }
-        int fail_count = 0;
-        while (!data->read_thread_need_exit && !app::need_exit())
-        {
-            int nfds = epoll_wait(epoll_fd, &ev, 1, 200);
-            if (nfds > 0)
+            std::lock_guard<std::mutex> lock(data->mutex);
+            data->fd = fd;
+            err::Err e = data->key->read(key, value);
+            if (e == err::Err::ERR_NONE)
             {
-                data->fd = ev.data.fd;
-                err::Err e = data->key->read(key, value);
-                if (e == err::Err::ERR_NONE)
-                {
-                    data->callback(key, value);
-                    // get ticks_ms when the key is pressed.
-                    if (key != 0 && value == 1) {
-                        tick = time::ticks_ms();
-                    } else if (key != 0 && value == 0) {
-                        tick = 0;
-                    }
-                }
-                else if (e != err::Err::ERR_NOT_READY)
+                data->fail_count = 0;
+                data->callback(key, value);
+                if (key != 0 && (value == 1 || value == 0))
                 {
-                    if(++fail_count > 10)
-                    {
-                        log::error("read key thread read failed: %s", err::to_str(e).c_str());
-                        break;
-                    }
-                    time::sleep_ms(300);
+                    // new press or release cancels waiting long press
+                    seq = ++data->press_seq;
+                    cancel_timer = data->long_press_timer;
+                    start_timer = value == 1 && data->long_press_time > 0;
+                    // 0 means timer is being added, timer callback sets -1 when triggered
+                    data->long_press_timer = start_timer ? 0 : -1;
                 }
-                continue;
             }
-            // if long press event occurs, send KEY_LONG_PRESSED.
-            if (tick != 0 && data->long_press_time !=0) {
-                if ((int)(time::ticks_ms()- tick) >= data->long_press_time) {
-                    data->callback(key, State::KEY_LONG_PRESSED);
-                    tick = 0;
+            else if (e != err::Err::ERR_NOT_READY)
+            {
+                if (++data->fail_count > 10)
+                {
+                    log::error("read key failed: %s, stop watching fd %d", err::to_str(e).c_str(), fd);
+                    io::Reactor::global().remove(fd);
                 }
+                return;
             }
-            time::sleep_ms(1);
+            else
+                return;
+        }
+        // timer ops out of lock, remove_timer waits timer callback which needs the lock
+        if (cancel_timer > 0)
+            io::Reactor::global().remove_timer(cancel_timer);
+        if (start_timer)
+        {
+            int timer = io::Reactor::global().add_timer(data->long_press_time, [data, key, seq]() {
+                std::lock_guard<std::mutex> lock(data->mutex);
+                if (seq != data->press_seq)
+                    return;
+                data->long_press_timer = -1;
+                data->callback(key, State::KEY_LONG_PRESSED);
+            }, true);
+            std::lock_guard<std::mutex> lock(data->mutex);
+            // timer may already triggered before here, only keep id of pending timer
+            if (timer > 0 && seq == data->press_seq && data->long_press_timer == 0)
+                data->long_press_timer = timer;
         }
-        log::info("read key thread exit");
-        data->read_thread_exit = true;
     }
 
-    static void _powerkey_process(void *args)
+    static void _on_powerkey_event(Port_Data *data)
     {
-        Port_Data *data = (Port_Data *)args;
-        data->io_fd = open("/sys/class/gpio/gpio448/value", O_RDONLY);
-        if (data->io_fd < 0) {
-            data->powerkey_thread_exit = true;
-            log::error("open gpio failed: %s", strerror(errno));
-            return;
-        }
+        char buf[32];
+        uint8_t i2c_data = 0xFF;
+        struct input_event uinput_ev;
+        static bool is_pressed = false;
 
-        struct epoll_event ev;
-        int epoll_fd = epoll_create1(0);
-        if (epoll_fd < 0)
-        {
-            data->powerkey_thread_exit = true;
-            log::error("create epoll failed: %s", strerror(errno));
-            return;
+        lseek(data->io_fd, 0, SEEK_SET);
+        read(data->io_fd, buf, sizeof(buf));
+
+        if (buf[0] == '0' && !is_pressed) {
+            is_pressed = true;
+            uinput_ev.type = EV_KEY;
+            uinput_ev.code = KEY_POWER;
+            uinput_ev.value = 1;
+            gettimeofday(&uinput_ev.time, NULL);
+            write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
+            log::debug("Key pressed.\n");
+        } else if (buf[0] == '0' && is_pressed) {
+            is_pressed = false;
+            uinput_ev.type = EV_KEY;
+            uinput_ev.code = KEY_POWER;
+            uinput_ev.value = 0;
+            gettimeofday(&uinput_ev.time, NULL);
+            write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
+            log::debug("Key press detected.\n");
+        }
+        uinput_ev.type = EV_SYN;
+        uinput_ev.code = SYN_REPORT;
+        uinput_ev.value = 0;
+        gettimeofday(&uinput_ev.time, NULL);
+        write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
+
+        if (i2c_dev->writeto_mem(0x34, 0x49, &i2c_data, 1) != 1) {
+            log::error("clean pmu irq failed");
         }
-        ev.events = EPOLLPRI;
-        ev.data.fd = data->io_fd;
+    }
 
-        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, data->io_fd, &ev) < 0) {
-            log::error("epoll_ctl add failed: %s", strerror(errno));
-            data->powerkey_thread_exit = true;
-            close(epoll_fd);
+    static void _watch_power_key(Port_Data *data)
+    {
+        data->io_fd = open("/sys/class/gpio/gpio448/value", O_RDONLY);
+        if (data->io_fd < 0) {
+            log::error("open gpio failed: %s", strerror(errno));
             return;
         }
-
         char buf[32];
-        uint8_t i2c_data = 0xFF;
-        struct input_event uinput_ev;
-        static bool is_pressed = false;
         read(data->io_fd, buf, sizeof(buf));
-        while (!data->powerkey_thread_need_exit && !app::need_exit())
-        {
-            int nfds = epoll_wait(epoll_fd, &ev, 1, 200);
-            if (nfds > 0) {
-                if (ev.events & EPOLLPRI) {
-                    lseek(data->io_fd, 0, SEEK_SET);
-                    read(data->io_fd, buf, sizeof(buf));
-
-                    if (buf[0] == '0' && !is_pressed) {
-                        is_pressed = true;
-                        uinput_ev.type = EV_KEY;
-                        uinput_ev.code = KEY_POWER;
-                        uinput_ev.value = 1;
-                        gettimeofday(&uinput_ev.time, NULL);
-                        write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
-                        log::debug("Key pressed.\n");
-                    } else if (buf[0] == '0' && is_pressed) {
-                        is_pressed = false;
-                        uinput_ev.type = EV_KEY;
-                        uinput_ev.code = KEY_POWER;
-                        uinput_ev.value = 0;
-                        gettimeofday(&uinput_ev.time, NULL);
-                        write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
-                        log::debug("Key press detected.\n");
-                    }
-                    uinput_ev.type = EV_SYN;
-                    uinput_ev.code = SYN_REPORT;
-                    uinput_ev.value = 0;
-                    gettimeofday(&uinput_ev.time, NULL);
-                    write(data->uinput_fd, &uinput_ev, sizeof(uinput_ev));
-
-                    if (i2c_dev->writeto_mem(0x34, 0x49, &i2c_data, 1) != 1) {
-                        log::error("clean pmu irq failed");
-                        return;
-                    }
-                }
-            }
-            time::sleep_ms(20);
+        err::Err e = io::Reactor::global().add(data->io_fd, io::EVENT_PRI, [data](int, uint32_t events) {
+            if (events & io::EVENT_PRI)
+                _on_powerkey_event(data);
+        });
+        if (e != err::ERR_NONE) {
+            log::error("watch power key failed: %s", err::to_str(e).c_str());
+            return;
         }
-        log::info("powerkey thread exit");
-        data->powerkey_thread_exit = true;
+        data->powerkey_added = true;
     }
 
     static void _init_power_key(void *args)
@@ -296,13 +267,16 @@ namespace maix::peripheral::key
             log::error("Exception occurred: %s", e.what());
         }
 
-        data->powerkey_thread = new thread::Thread(_powerkey_process, data);
-        data->powerkey_thread->detach();
+        _watch_power_key(data);
     }
 
     static void _deinit_power_key(void *args)
     {
         Port_Data *data = (Port_Data *)args;
+        if (data->powerkey_added) {
+            io::Reactor::global().remove(data->io_fd);
+            data->powerkey_added = false;
+        }
         ioctl(data->uinput_fd, UI_DEV_DESTROY);
         close(data->uinput_fd);
         if (data->io_fd > 0) {
@@ -325,16 +299,14 @@ namespace maix::peripheral::key
         {
             throw err::Exception(err::ERR_NO_MEM, "create key data failed");
         }
-        data->thread = nullptr;
-        data->powerkey_thread = nullptr;
         data->fd = -1;
         data->io_fd = -1;
         data->uinput_fd = -1;
         data->long_press_time = long_press_time;
-        data->read_thread_exit = false;
-        data->read_thread_need_exit = false;
-        data->powerkey_thread_exit = false;
-        data->powerkey_thread_need_exit = false;
+        data->long_press_timer = -1;
+        data->press_seq = 0;
+        data->fail_count = 0;
+        data->powerkey_added = false;
         data->key = this;
         data->callback = callback;
 
@@ -370,28 +342,6 @@ namespace maix::peripheral::key
         if (this->_data)
         {
             Port_Data *data = (Port_Data *)this->_data;
-            if(data->thread)
-            {
-                data->read_thread_need_exit = true;
-                log::info("wait read key thread exit");
-                while (!data->read_thread_exit)
-                {
-                    time::sleep_ms(1);
-                }
-                delete data->thread;
-                data->thread = nullptr;
-            }
-            if(data->powerkey_thread)
-            {
-                data->powerkey_thread_need_exit = true;
-                log::info("wait powerkey thread exit");
-                while (!data->powerkey_thread_exit)
-                {
-                    time::sleep_ms(1);
-                }
-                delete data->powerkey_thread;
-                data->powerkey_thread = nullptr;
-            }
             if (fs::exists(KEY_DEVICE1)) {
                 _deinit_power_key((void*)data);
             }
@@ -445,13 +395,22 @@ namespace maix::peripheral::key
         }
         if (this->_callback)
         {
-            // new thread to read key
+            // key events are dispatched by global reactor, no thread for each key device
             Port_Data *data = (Port_Data *)this->_data;
-            data->fds = this->_fds;
-            data->read_thread_exit = false;
-            data->read_thread_need_exit = false;
-            data->thread = new thread::Thread(_read_process, this->_data);
-            data->thread->detach();
+            data->fds.clear();
+            data->fail_count = 0;
+            for (int fd : this->_fds)
+            {
+                err::Err e = io::Reactor::global().add(fd, io::EVENT_IN, [data](int fd, uint32_t) {
+                    _on_key_event(data, fd);
+                });
+                if (e != err::ERR_NONE)
+                {
+                    log::error("watch key fd %d failed: %s", fd, err::to_str(e).c_str());
+                    continue;
+                }
+                data->fds.push_back(fd);
+            }
         }
         return err::Err::ERR_NONE;
     }
@@ -522,7 +481,19 @@ namespace maix::peripheral::key
     err::Err Key::close()
     {
         Port_Data *data = (Port_Data *)this->_data;
-        data->read_thread_need_exit = true;
+        // stop watching before close so fd numbers won't be reused while still watched
+        for (int fd : data->fds)
+            io::Reactor::global().remove(fd);
+        data->fds.clear();
+        int timer;
+        {
+            std::lock_guard<std::mutex> lock(data->mutex);
+            ++data->press_seq;
+            timer = data->long_press_timer;
+            data->long_press_timer = -1;
+        }
+        if (timer > 0)
+            io::Reactor::global().remove_timer(timer);
 
         bool err = false;
         for (int &fd : this->_fds)
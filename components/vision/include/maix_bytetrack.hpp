@@ -1,6 +1,7 @@
 #pragma once
 
 #include "maix_tracker.hpp"
+#include "maix_thread.hpp"
 #include <vector>
 
 namespace maix::tracker
@@ -38,4 +39,63 @@ namespace maix::tracker
     private:
         void *_data;
     };
+    /**
+     * tracker.MultiByteTracker class, track objects of multiple streams(e.g. cameras) at once,
+     * each stream has its own ByteTracker and streams are updated in parallel on a thread pool.
+     * @maixpy maix.tracker.MultiByteTracker
+     */
+    class MultiByteTracker
+    {
+    public:
+        /**
+         * tracker.MultiByteTracker class constructor
+         * @param stream_num number of streams, one ByteTracker for each stream.
+         * @param max_lost_buff_num the frames for keep lost tracks.
+         * @param track_thresh tracking confidence threshold.
+         * @param high_thresh threshold to add to new track.
+         * @param match_thresh matching threshold for tracking, e.g. one object in two frame iou < match_thresh we think they are the same obj.
+         * @param max_history max tack's position history length.
+         * @param threads number of threads used to update streams, include caller thread, <= 0 means use CPU core number.
+         * @throw err::Exception if stream_num <= 0.
+         * @maixpy maix.tracker.MultiByteTracker.__init__
+         * @maixcdk maix.tracker.MultiByteTracker.MultiByteTracker
+         */
+        MultiByteTracker(const int &stream_num,
+                         const int &max_lost_buff_num = 60,
+                         const float &track_thresh = 0.5,
+                         const float &high_thresh = 0.6,
+                         const float &match_thresh = 0.8,
+                         const int &max_history = 20,
+                         const int &threads = -1);
+        ~MultiByteTracker();
+
+        /**
+         * update tracks of all streams according to current detected objects.
+         * @param objs detected objects of each stream, size must equal to stream_num.
+         * @return tracks of each stream.
+         * @throw err::Exception if objs size not equal to stream_num.
+         * @maixpy maix.tracker.MultiByteTracker.update
+         */
+        std::vector<std::vector<tracker::Track>> update(const std::vector<std::vector<tracker::Object>> &objs);
+
+        /**
+         * update tracks of one stream according to current detected objects.
+         * @param stream stream index.
+         * @param objs detected objects of this stream.
+         * @return tracks of this stream.
+         * @throw err::Exception if stream index out of range.
+         * @maixpy maix.tracker.MultiByteTracker.update_stream
+         */
+        std::vector<tracker::Track> update_stream(const int &stream, const std::vector<tracker::Object> &objs);
+
+        /**
+         * Get stream number.
+         * @maixpy maix.tracker.MultiByteTracker.stream_num
+         */
+        int stream_num() { return _trackers.size(); }
+
+    private:
+        std::vector<ByteTracker *> _trackers;
+        thread::Pool *_pool;
+    };
 } // namespace maix::tracker
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Image data is allocated from image::BufferPool.
+ * @update 2026.10.18: Add generation counter and cached derived views(gray, integral, pyramid).
  */
 
 #pragma once
@@ -14,6 +16,7 @@
 #include "maix_image_def.hpp"
 #include "maix_image_color.hpp"
 #include "maix_image_obj.hpp"
+#include "maix_image_pool.hpp"
 #include "maix_type.hpp"
 #include <stdlib.h>
 
@@ -154,6 +157,50 @@ namespace maix::image
          */
         void *data(){ return _data; }
 
+        /**
+         * Get image's modification generation, increased by every method that modifies image data(draw_*, binary, set_pixel etc.).
+         * Derived views(gray_view, integral_view, pyramid_view) are cached with the generation they were built from,
+         * and rebuilt automatically when generation changed.
+         * Views can be got from many threads at once, but image must not be modified at the same time.
+         * @maixcdk maix.image.Image.generation
+         */
+        uint64_t generation() { return _generation; }
+
+        /**
+         * Mark image data modified, increase generation so cached derived views are rebuilt on next use.
+         * Methods of Image call it automatically, call it yourself after writing data() directly.
+         * @maixcdk maix.image.Image.mark_modified
+         */
+        void mark_modified() { ++_generation; }
+
+        /**
+         * Get grayscale view of this image, cached until image modified, so many find_* on the same frame convert only once.
+         * Return this image itself if format is GRAYSCALE, and the Y plane without copy if format is YVU420SP.
+         * @return grayscale image owned by this image, read only, don't delete it or modify it,
+         *         valid until this image destroyed or modified.
+         * @maixcdk maix.image.Image.gray_view
+         */
+        image::Image *gray_view();
+
+        /**
+         * Get integral image of gray_view(), cached until image modified.
+         * Layout is same as imlib i_image_t, width * height uint32 values, value at (x, y) is sum of pixels in rect (0, 0) to (x, y) inclusive.
+         * @param squared false get sum of pixels, true get sum of pixels square.
+         * @return integral data owned by this image, valid until this image destroyed or modified, nullptr if alloc failed.
+         *         Values wrap around uint32 for large images like imlib, rect sums from differences are still right if they fit in uint32.
+         * @maixcdk maix.image.Image.integral_view
+         */
+        const uint32_t *integral_view(bool squared = false);
+
+        /**
+         * Get gaussian pyramid level of gray_view(), each level is half size of previous level, cached until image modified.
+         * @param level pyramid level, 0 is gray_view() itself.
+         * @return grayscale image owned by this image, read only, don't delete it or modify it,
+         *         nullptr if level too large(width or height less than 1).
+         * @maixcdk maix.image.Image.pyramid_view
+         */
+        image::Image *pyramid_view(int level);
+
         /**
          * To string method
          * @maixpy maix.image.Image.__str__
@@ -268,6 +315,7 @@ namespace maix::image
          * @maixpy maix.image.Image.set_pixel
         */
         err::Err set_pixel(int x, int y, std::vector<uint32_t> pixel) {
+            mark_modified();
             if (!(_format == image::Format::FMT_RGB888 || _format == image::Format::FMT_BGR888 ||
                 _format == image::Format::FMT_RGB565 || _format == image::Format::FMT_BGR565 ||
                 _format == image::Format::FMT_GRAYSCALE ||
@@ -1591,14 +1639,17 @@ namespace maix::image
         }
 
     private:
-        void *_actual_data;
+        void *_actual_data; // allocated from image::BufferPool::global() if _is_malloc
         void *_data;
         int _width;
         int _height;
         int _data_size;
         Format _format;
         bool _is_malloc;
+        uint64_t _generation = 1;
+        void *_views = nullptr; // cached derived views, see maix_image_views.cpp
 
+        void _free_views();
         int _get_cv_pixel_num(image::Format &format);
         std::vector<int> _get_available_roi(std::vector<int> roi, std::vector<int> other_roi = std::vector<int>());
         void _create_image(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy, const image::Color &bg = image::FMT_INVALID);
@@ -0,0 +1,144 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add image buffer pool, create this file.
+ */
+
+#pragma once
+
+#include "maix_err.hpp"
+#include "maix_image_def.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace maix::image
+{
+    /**
+     * Image buffer pool flags, can be combined by |.
+     * @maixcdk maix.image.PoolFlag
+     */
+    enum PoolFlag
+    {
+        POOL_NONE = 0,
+        POOL_POPULATE = 0x01, // map new buffers with MAP_POPULATE, page faults happen at allocation instead of first write.
+        POOL_HUGEPAGE = 0x02, // advise transparent huge pages for buffers >= 2MiB.
+    };
+
+    /**
+     * Image buffer pool statistics.
+     * @maixcdk maix.image.PoolStats
+     */
+    struct PoolStats
+    {
+        uint64_t alloc_count = 0;      // alloc calls
+        uint64_t thread_hit = 0;       // allocs served by calling thread's cache
+        uint64_t global_hit = 0;       // allocs served by shared cache
+        uint64_t miss = 0;             // allocs mapped new memory from system
+        uint64_t release_count = 0;    // buffers returned to system
+        uint64_t in_use_bytes = 0;     // bytes of buffers in use
+        uint64_t peak_in_use_bytes = 0; // max in_use_bytes since start or reset_stats()
+        uint64_t cached_bytes = 0;     // bytes of free buffers kept in caches
+        uint64_t max_cached_bytes = 0; // current cache limit
+    };
+
+    /**
+     * Page aligned buffer pool for image data, image::Image allocates data from it transparently.
+     * Buffers are grouped by size classes(exact pages up to 64KiB, then 4 classes per power of 2, waste <= 25%),
+     * freed buffers are kept in a small per-thread cache and a shared cache for reuse,
+     * so pipelines creating same size images every frame don't mmap, munmap and page fault every frame.
+     * Shared cache and thread caches together are limited by max cached bytes(CONFIG_VISION_IMAGE_POOL_MAX_CACHE_MB), when full,
+     * other size classes are released first, then the freed buffer itself. Each thread cache holds at most 4 buffers and 1/4 of the limit,
+     * thread caches only serve global pool.
+     * @maixcdk maix.image.BufferPool
+     */
+    class BufferPool
+    {
+    public:
+        /**
+         * Global pool used by image::Image, created at first call and never destroyed.
+         * @maixcdk maix.image.BufferPool.global
+         */
+        static BufferPool &global();
+
+        /**
+         * Allocate buffer, start address is page(4KiB) aligned.
+         * @param size buffer size in bytes.
+         * @return buffer, nullptr if no memory.
+         * @maixcdk maix.image.BufferPool.alloc
+         */
+        void *alloc(size_t size);
+
+        /**
+         * Free buffer allocated by alloc.
+         * @param ptr buffer, nullptr will be ignored.
+         * @param size must be same as alloc size.
+         * @maixcdk maix.image.BufferPool.free
+         */
+        void free(void *ptr, size_t size);
+
+        /**
+         * Allocate buffers and put them to shared cache, so first frames of a pipeline don't pay for mmap and page faults.
+         * Pages are populated, max cached bytes grows if not enough to hold them.
+         * @param size buffer size in bytes.
+         * @param count number of buffers of this size to keep cached.
+         * @return err::ERR_NONE if success, err::ERR_NO_MEM if no memory.
+         * @maixcdk maix.image.BufferPool.prewarm
+         */
+        err::Err prewarm(size_t size, int count);
+
+        /**
+         * Pre-warm for images of known resolution and format, e.g. camera resolution and NN input.
+         * @param width image width
+         * @param height image height
+         * @param format image format, uncompressed format only.
+         * @param count number of buffers to keep cached.
+         * @return err::ERR_NONE if success, err::ERR_ARGS if format invalid, err::ERR_NO_MEM if no memory.
+         * @maixcdk maix.image.BufferPool.prewarm
+         */
+        err::Err prewarm(int width, int height, image::Format format, int count);
+
+        /**
+         * Set max bytes of shared cache and thread caches, release cached buffers if over limit.
+         * @param bytes max cached bytes, 0 means not cache, free buffers are released to system at once.
+         * @maixcdk maix.image.BufferPool.set_max_cached
+         */
+        void set_max_cached(size_t bytes);
+
+        /**
+         * Set pool flags for newly mapped buffers.
+         * @param flags PoolFlag bits.
+         * @maixcdk maix.image.BufferPool.set_flags
+         */
+        void set_flags(int flags);
+
+        /**
+         * Release all buffers in shared cache and caches of all threads to system, e.g. after pipeline stopped.
+         * @maixcdk maix.image.BufferPool.trim
+         */
+        void trim();
+
+        /**
+         * Get statistics.
+         * @maixcdk maix.image.BufferPool.stats
+         */
+        image::PoolStats stats();
+
+        /**
+         * Get statistics as human readable string.
+         * @maixcdk maix.image.BufferPool.stats_str
+         */
+        std::string stats_str();
+
+        /**
+         * Reset counters of statistics, byte values are not reset.
+         * @maixcdk maix.image.BufferPool.reset_stats
+         */
+        void reset_stats();
+
+    private:
+        BufferPool(size_t max_cached, int flags);
+        void *_impl;
+    };
+} // namespace maix::image
@@ -0,0 +1,128 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add stateful QR code and barcode scanners with ROI tracking, create this file.
+ */
+
+#pragma once
+
+#include "maix_image.hpp"
+#include <vector>
+
+namespace maix::image
+{
+    /**
+     * Stateful QR code scanner for video stream, scan faster than calling Image.find_qrcodes for every frame.
+     * Full image search only runs every detect_interval frames, or when motion found outside tracked codes,
+     * and runs on a downscaled grayscale image(pyramid level detect_level).
+     * Other frames only decode inside predicted ROIs of tracked codes with full resolution,
+     * codes not moved since last frame reuse last decoded result without decoding.
+     * Use one scanner for one video stream.
+     * @maixcdk maix.image.QRCodeScanner
+     */
+    class QRCodeScanner
+    {
+    public:
+        /**
+         * Construct a new QRCodeScanner object
+         * @param detect_interval full image search interval in frames, 1 means search every frame.
+         * @param detect_level pyramid level of full image search, 0 is full resolution, 1 is half width and height.
+         *                     Increase it for faster search if codes are big in image, decrease it if small codes are missed.
+         * @param motion_threshold ratio(0~1) of changed pixels outside tracked codes to trigger full image search before interval, 0 means disable.
+         * @param max_lost remove tracked code after decode failed continuous max_lost frames.
+         * @param decoder_type decoder used for full image search and ROIs, see Image.find_qrcodes.
+         * @maixcdk maix.image.QRCodeScanner.QRCodeScanner
+         */
+        QRCodeScanner(int detect_interval = 10, int detect_level = 1, float motion_threshold = 0.02, int max_lost = 3,
+                      image::QRCodeDecoderType decoder_type = image::QRCodeDecoderType::QRCODE_DECODER_TYPE_ZBAR);
+
+        QRCodeScanner(const QRCodeScanner&) = delete;
+        QRCodeScanner& operator=(const QRCodeScanner&) = delete;
+
+        ~QRCodeScanner();
+
+        /**
+         * Scan one frame.
+         * @param img frame image, any format find_qrcodes supported, YVU420SP from camera is best, its Y plane is used without convert.
+         * @return QR codes in this frame, coordinates are in img.
+         * @maixcdk maix.image.QRCodeScanner.scan
+         */
+        std::vector<image::QRCode> scan(image::Image &img);
+
+        /**
+         * Clear tracked codes, next scan() will search full image, call it when switched to another video stream.
+         * @maixcdk maix.image.QRCodeScanner.reset
+         */
+        void reset();
+
+        /**
+         * Number of tracked codes.
+         * @maixcdk maix.image.QRCodeScanner.tracked
+         */
+        int tracked();
+
+        /**
+         * Number of full image searches since construct or reset(), to check detect_interval and motion_threshold setting.
+         * @maixcdk maix.image.QRCodeScanner.full_searches
+         */
+        uint64_t full_searches();
+
+    private:
+        void *_impl;
+    };
+
+    /**
+     * Stateful barcode scanner for video stream, scan faster than calling Image.find_barcodes for every frame.
+     * Work in the same way as QRCodeScanner.
+     * @maixcdk maix.image.BarcodeScanner
+     */
+    class BarcodeScanner
+    {
+    public:
+        /**
+         * Construct a new BarcodeScanner object
+         * @param detect_interval full image search interval in frames, 1 means search every frame.
+         * @param detect_level pyramid level of full image search, 0 is full resolution, 1 is half width and height.
+         *                     Barcode bars are narrow, use 0 if bars are narrower than 2 pixels.
+         * @param motion_threshold ratio(0~1) of changed pixels outside tracked codes to trigger full image search before interval, 0 means disable.
+         * @param max_lost remove tracked code after decode failed continuous max_lost frames.
+         * @maixcdk maix.image.BarcodeScanner.BarcodeScanner
+         */
+        BarcodeScanner(int detect_interval = 10, int detect_level = 0, float motion_threshold = 0.02, int max_lost = 3);
+
+        BarcodeScanner(const BarcodeScanner&) = delete;
+        BarcodeScanner& operator=(const BarcodeScanner&) = delete;
+
+        ~BarcodeScanner();
+
+        /**
+         * Scan one frame.
+         * @param img frame image.
+         * @return barcodes in this frame, coordinates are in img.
+         * @maixcdk maix.image.BarcodeScanner.scan
+         */
+        std::vector<image::BarCode> scan(image::Image &img);
+
+        /**
+         * Clear tracked codes, next scan() will search full image.
+         * @maixcdk maix.image.BarcodeScanner.reset
+         */
+        void reset();
+
+        /**
+         * Number of tracked codes.
+         * @maixcdk maix.image.BarcodeScanner.tracked
+         */
+        int tracked();
+
+        /**
+         * Number of full image searches since construct or reset().
+         * @maixcdk maix.image.BarcodeScanner.full_searches
+         */
+        uint64_t full_searches();
+
+    private:
+        void *_impl;
+    };
+} // namespace maix::image
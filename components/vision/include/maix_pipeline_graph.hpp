@@ -0,0 +1,284 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add multi-stage frame pipeline graph, create this file.
+ */
+
+#pragma once
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "maix_camera.hpp"
+#include "maix_display.hpp"
+#include "maix_video.hpp"
+#include "maix_jpg_stream.hpp"
+#include <any>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace maix::pipeline
+{
+    /**
+     * What to do when a stage's input queue is full.
+     * @maixcdk maix.pipeline.DropPolicy
+     */
+    enum class DropPolicy
+    {
+        BLOCK = 0,   // producer waits until queue has space, no frame is lost, slowest stage sets the pace.
+        DROP_NEW,    // producer drops the new frame if queue is full.
+        LATEST,      // queue holds only the newest frame, older waiting frame is dropped, best for display and realtime inference.
+    };
+
+    /**
+     * Frame packet flowing through pipeline, with frame metadata and stage results.
+     * @maixcdk maix.pipeline.Packet
+     */
+    class Packet
+    {
+    public:
+        /**
+         * Sequence number from source, start from 0, dropped frames leave gaps.
+         */
+        uint64_t seq = 0;
+
+        /**
+         * Timestamp when source produced this packet, time::ticks_us().
+         */
+        uint64_t timestamp_us = 0;
+
+        /**
+         * Image of this frame, stages can replace it, e.g. with a resized image.
+         * Sinks share the same image, so sinks must not modify it, draw in a stage before sinks.
+         */
+        std::shared_ptr<image::Image> img;
+
+        /**
+         * Stage result, e.g. std::shared_ptr<nn::Objects>, use set() and get() to access.
+         */
+        std::any data;
+
+        /**
+         * User metadata, key value strings.
+         */
+        std::map<std::string, std::string> meta;
+
+        /**
+         * Set stage result, take ownership of value.
+         * @maixcdk maix.pipeline.Packet.set
+         */
+        template <typename T>
+        void set(T *value)
+        {
+            data = std::shared_ptr<T>(value);
+        }
+
+        /**
+         * Get stage result set by set().
+         * @return result pointer, nullptr if not set or type not match. Valid while packet alive, don't delete it.
+         * @maixcdk maix.pipeline.Packet.get
+         */
+        template <typename T>
+        T *get() const
+        {
+            const std::shared_ptr<T> *p = std::any_cast<std::shared_ptr<T>>(&data);
+            return p ? p->get() : nullptr;
+        }
+    };
+
+    /**
+     * Source function, fill packet's img, return false if no frame this time(e.g. read timeout).
+     */
+    using SourceFunc = std::function<bool(Packet &)>;
+
+    /**
+     * Stage function, process packet in place, return false to drop this packet.
+     */
+    using StageFunc = std::function<bool(Packet &)>;
+
+    /**
+     * Sink function, consume packet, packet is shared by all sinks so don't modify it.
+     */
+    using SinkFunc = std::function<void(const Packet &)>;
+
+    /**
+     * Statistics of one stage.
+     * @maixcdk maix.pipeline.StageStats
+     */
+    struct StageStats
+    {
+        std::string name;
+        uint64_t processed = 0;   // packets processed
+        uint64_t dropped = 0;     // packets dropped by input queue policy or by stage function returned false
+        float fps = 0;            // processed packets per second since start or reset_stats()
+        float avg_us = 0;         // average process time of stage function
+        float max_us = 0;         // max process time of stage function
+        float latency_us = 0;     // average time from source timestamp to this stage finished
+        int queue_len = 0;        // current input queue length
+    };
+
+    /**
+     * Multi-stage frame pipeline, e.g. camera -> preprocess -> NN -> postprocess -> display/encoder/streamer.
+     * Every stage and sink runs in its own thread, stages are connected by bounded lock-free single producer single consumer queues,
+     * so stage N processes frame i while stage N+1 processes frame i-1, throughput is limited by the slowest stage instead of sum of all stages.
+     * Stages run in added order, sinks are all fed by the last stage.
+     * @note Stage functions run in different threads, don't share non thread safe objects between stages.
+     * @maixcdk maix.pipeline.Graph
+     */
+    class Graph
+    {
+    public:
+        /**
+         * Create pipeline graph
+         * @param name graph name, used as thread name prefix and in stats.
+         * @maixcdk maix.pipeline.Graph.Graph
+         */
+        Graph(const std::string &name = "pipeline");
+        ~Graph();
+
+        /**
+         * Set source of pipeline, must set before start.
+         * @param name source name
+         * @param func source function, called repeatedly in source thread,
+         *             return false means no frame this time, it's called again after a short back off(1ms to 20ms).
+         * @param cpus CPU cores source thread bind to, empty means not bind.
+         * @param priority SCHED_FIFO priority of thread, 0 means normal, see thread::set_priority.
+         * @return this graph for chain call.
+         * @maixcdk maix.pipeline.Graph.source
+         */
+        Graph &source(const std::string &name, SourceFunc func, const std::vector<int> &cpus = std::vector<int>(), int priority = 0);
+
+        /**
+         * Add a process stage after last added stage.
+         * @param name stage name
+         * @param func stage function
+         * @param queue_size input queue size, for DropPolicy::LATEST it's always 1.
+         * @param policy input queue full policy
+         * @param cpus CPU cores stage thread bind to, empty means not bind.
+         * @param priority SCHED_FIFO priority of thread, 0 means normal.
+         * @return this graph for chain call.
+         * @maixcdk maix.pipeline.Graph.stage
+         */
+        Graph &stage(const std::string &name, StageFunc func, int queue_size = 2, DropPolicy policy = DropPolicy::BLOCK,
+                     const std::vector<int> &cpus = std::vector<int>(), int priority = 0);
+
+        /**
+         * Add a sink, all sinks receive every packet output by last stage.
+         * @param name sink name
+         * @param func sink function
+         * @param queue_size input queue size, for DropPolicy::LATEST it's always 1.
+         * @param policy input queue full policy
+         * @param cpus CPU cores sink thread bind to, empty means not bind.
+         * @param priority SCHED_FIFO priority of thread, 0 means normal.
+         * @return this graph for chain call.
+         * @maixcdk maix.pipeline.Graph.sink
+         */
+        Graph &sink(const std::string &name, SinkFunc func, int queue_size = 2, DropPolicy policy = DropPolicy::BLOCK,
+                    const std::vector<int> &cpus = std::vector<int>(), int priority = 0);
+
+        /**
+         * Start all threads.
+         * @return err::ERR_NOT_READY if no source or no stage/sink, err::ERR_BUSY if already started.
+         * @maixcdk maix.pipeline.Graph.start
+         */
+        err::Err start();
+
+        /**
+         * Stop all threads and drop packets in queues, stage functions in progress will finish first.
+         * Called by destructor automatically.
+         * @maixcdk maix.pipeline.Graph.stop
+         */
+        void stop();
+
+        /**
+         * Whether graph is running.
+         * @maixcdk maix.pipeline.Graph.running
+         */
+        bool running();
+
+        /**
+         * Block until stopped or app::need_exit() or timeout.
+         * @param timeout_ms timeout, -1 means wait forever.
+         * @return true if stopped or app need exit, false if timeout.
+         * @maixcdk maix.pipeline.Graph.wait
+         */
+        bool wait(int timeout_ms = -1);
+
+        /**
+         * Get statistics of source, stages and sinks, in pipeline order.
+         * @maixcdk maix.pipeline.Graph.stats
+         */
+        std::vector<StageStats> stats();
+
+        /**
+         * Get statistics as human readable string, one line per stage.
+         * @maixcdk maix.pipeline.Graph.stats_str
+         */
+        std::string stats_str();
+
+        /**
+         * Reset statistics.
+         * @maixcdk maix.pipeline.Graph.reset_stats
+         */
+        void reset_stats();
+
+    private:
+        std::string _name;
+        void *_data;
+    };
+
+    /**
+     * Camera source, read one frame from camera every call.
+     * @param cam camera object, must keep alive while graph running.
+     * @param block_ms read block time, -1 means block until got frame.
+     * @maixcdk maix.pipeline.camera_source
+     */
+    SourceFunc camera_source(camera::Camera &cam, int block_ms = -1);
+
+    /**
+     * Display sink, show packet's image on display.
+     * @param disp display object, must keep alive while graph running.
+     * @param fit image fit mode if image size not equal to display size.
+     * @maixcdk maix.pipeline.display_sink
+     */
+    SinkFunc display_sink(display::Display &disp, image::Fit fit = image::FIT_CONTAIN);
+
+    /**
+     * Video encoder sink, encode packet's image.
+     * @param encoder encoder object, must keep alive while graph running.
+     * @param on_frame called with encoded frame, ownership is passed to it, nullptr means delete the frame(e.g. encoder writes to file).
+     * @maixcdk maix.pipeline.encoder_sink
+     */
+    SinkFunc encoder_sink(video::Encoder &encoder, std::function<void(video::Frame *)> on_frame = nullptr);
+
+    /**
+     * JPEG streamer sink, push packet's image to http JPEG stream.
+     * @param streamer streamer object, must started and keep alive while graph running.
+     * @maixcdk maix.pipeline.jpeg_streamer_sink
+     */
+    SinkFunc jpeg_streamer_sink(http::JpegStreamer &streamer);
+
+    /**
+     * Report sink, send packet results by communication protocol report message, e.g. comm::CommProtocol.
+     * @param comm object with report(uint8_t cmd, uint8_t *body, int body_len) method, must keep alive while graph running.
+     * @param cmd report CMD value
+     * @param encode encode packet to report body, return empty to skip this packet.
+     * @maixcdk maix.pipeline.report_sink
+     */
+    template <typename T>
+    SinkFunc report_sink(T &comm, uint8_t cmd, std::function<std::vector<uint8_t>(const Packet &)> encode)
+    {
+        return [&comm, cmd, encode](const Packet &p) {
+            std::vector<uint8_t> body = encode(p);
+            if (body.empty())
+                return;
+            err::Err e = comm.report(cmd, body.data(), (int)body.size());
+            if (e != err::ERR_NONE)
+                log::warn("pipeline report failed: %s", err::to_str(e).c_str());
+        };
+    }
+} // namespace maix::pipeline
@@ -1,76 +1,93 @@
-#pragma once
-
-#include "ByteTrack/STrack.h"
-#include "ByteTrack/lapjv.h"
-#include "ByteTrack/Object.h"
-
-#include <cstddef>
-#include <limits>
-#include <map>
-#include <memory>
-#include <vector>
-
-namespace byte_track
-{
-class BYTETracker
-{
-public:
-    using STrackPtr = std::shared_ptr<STrack>;
-
-    BYTETracker(const int& max_lost_buff_num = 60,
-                const float& track_thresh = 0.5,
-                const float& high_thresh = 0.6,
-                const float& match_thresh = 0.8,
-                const int& max_history = 20);
-    ~BYTETracker();
-
-    std::vector<STrackPtr> update(const std::vector<Object>& objects);
-
-private:
-    std::vector<STrackPtr> jointStracks(const std::vector<STrackPtr> &a_tlist,
-                                        const std::vector<STrackPtr> &b_tlist) const;
-
-    std::vector<STrackPtr> subStracks(const std::vector<STrackPtr> &a_tlist,
-                                      const std::vector<STrackPtr> &b_tlist) const;
-
-    void removeDuplicateStracks(const std::vector<STrackPtr> &a_stracks,
-                                const std::vector<STrackPtr> &b_stracks,
-                                std::vector<STrackPtr> &a_res,
-                                std::vector<STrackPtr> &b_res) const;
-
-    void linearAssignment(const std::vector<std::vector<float>> &cost_matrix,
-                          const int &cost_matrix_size,
-                          const int &cost_matrix_size_size,
-                          const float &thresh,
-                          std::vector<std::vector<int>> &matches,
-                          std::vector<int> &b_unmatched,
-                          std::vector<int> &a_unmatched) const;
-
-    std::vector<std::vector<float>> calcIouDistance(const std::vector<STrackPtr> &a_tracks,
-                                                    const std::vector<STrackPtr> &b_tracks) const;
-
-    std::vector<std::vector<float>> calcIous(const std::vector<Rect<float>> &a_rect,
-                                             const std::vector<Rect<float>> &b_rect) const;
-
-    double execLapjv(const std::vector<std::vector<float> > &cost,
-                     std::vector<int> &rowsol,
-                     std::vector<int> &colsol,
-                     bool extend_cost = false,
-                     float cost_limit = std::numeric_limits<float>::max(),
-                     bool return_cost = true) const;
-
-private:
-    const float track_thresh_;
-    const float high_thresh_;
-    const float match_thresh_;
-    const int max_history_;
-    const size_t max_time_lost_;
-
-    size_t frame_id_;
-    size_t track_id_count_;
-
-    std::vector<STrackPtr> tracked_stracks_;
-    std::vector<STrackPtr> lost_stracks_;
-    std::vector<STrackPtr> removed_stracks_;
-};
-}
\ No newline at end of file
+#pragma once
+
+#include "ByteTrack/STrack.h"
+#include "ByteTrack/KalmanFilter.h"
+#include "ByteTrack/lapjv.h"
+#include "ByteTrack/Object.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace byte_track
+{
+class BYTETracker
+{
+public:
+    // tlwh box used for association
+    struct Box
+    {
+        float x, y, w, h;
+    };
+
+    BYTETracker(const int& max_lost_buff_num = 60,
+                const float& track_thresh = 0.5,
+                const float& high_thresh = 0.6,
+                const float& match_thresh = 0.8,
+                const int& max_history = 20);
+    ~BYTETracker();
+
+    // return slot indexes of output tracks in tracks(), valid until next update
+    const std::vector<int> &update(const std::vector<Object>& objects);
+
+    const STrackStore &tracks() const { return store_; }
+
+private:
+    // gated sparse assignment, only pairs with cost(1 - iou) < thresh are candidates,
+    // candidates are split into connected components and each is solved by lapjv independently.
+    // matches are sorted by a index, unmatched indexes are ascending.
+    void linearAssignment(const std::vector<Box> &a_boxes,
+                          const std::vector<Box> &b_boxes,
+                          const float &thresh,
+                          std::vector<std::pair<int, int>> &matches,
+                          std::vector<int> &a_unmatched,
+                          std::vector<int> &b_unmatched);
+
+    // find pairs with 1 - iou < thresh by sweeping boxes sorted by x
+    void gatePairs(const std::vector<Box> &a_boxes,
+                   const std::vector<Box> &b_boxes,
+                   const float &thresh,
+                   std::vector<std::pair<int, int>> &pairs);
+
+    void removeDuplicateStracks(std::vector<int> &a_stracks,
+                                std::vector<int> &b_stracks);
+
+    double execLapjv(int n_rows, int n_cols,
+                     std::vector<int> &rowsol,
+                     std::vector<int> &colsol,
+                     float cost_limit);
+
+    void trackBoxes(const std::vector<int> &slots, std::vector<Box> &boxes) const;
+
+    void updateTrack(const int &idx, const Object &det, const bool &reactivate);
+
+private:
+    const float track_thresh_;
+    const float high_thresh_;
+    const float match_thresh_;
+    const int max_history_;
+    const size_t max_time_lost_;
+
+    size_t frame_id_;
+    size_t track_id_count_;
+
+    STrackStore store_;
+    KalmanFilter kalman_filter_;
+
+    std::vector<int> tracked_stracks_;
+    std::vector<int> lost_stracks_;
+    std::vector<int> output_stracks_;
+
+    // reusable buffers
+    std::vector<uint8_t> predict_mask_;
+    std::vector<int> sort_idx_;
+    std::vector<int> uf_parent_;
+    std::vector<float> block_cost_;
+    std::vector<double> lap_cost_;
+    std::vector<double *> lap_rows_;
+    std::vector<int> lap_x_;
+    std::vector<int> lap_y_;
+};
+
+float calcIoU(const BYTETracker::Box &a, const BYTETracker::Box &b);
+}
@@ -1,39 +1,38 @@
-#pragma once
-
-#include "Eigen/Dense"
-
-#include "ByteTrack/Rect.h"
-
-namespace byte_track
-{
-class KalmanFilter
-{
-public:
-    using DetectBox = Xyah<float>;
-
-    using StateMean = Eigen::Matrix<float, 1, 8, Eigen::RowMajor>;
-    using StateCov = Eigen::Matrix<float, 8, 8, Eigen::RowMajor>;
-
-    using StateHMean = Eigen::Matrix<float, 1, 4, Eigen::RowMajor>;
-    using StateHCov = Eigen::Matrix<float, 4, 4, Eigen::RowMajor>;
-
-    KalmanFilter(const float& std_weight_position = 1. / 20,
-                 const float& std_weight_velocity = 1. / 160);
-
-    void initiate(StateMean& mean, StateCov& covariance, const DetectBox& measurement);
-
-    void predict(StateMean& mean, StateCov& covariance);
-
-    void update(StateMean& mean, StateCov& covariance, const DetectBox& measurement);
-
-private:
-    float std_weight_position_;
-    float std_weight_velocity_;
-
-    Eigen::Matrix<float, 8, 8, Eigen::RowMajor> motion_mat_;
-    Eigen::Matrix<float, 4, 8, Eigen::RowMajor> update_mat_;
-
-    void project(StateHMean &projected_mean, StateHCov &projected_covariance,
-                 const StateMean& mean, const StateCov& covariance);
-};
-}
\ No newline at end of file
+#pragma once
+
+#include "ByteTrack/STrack.h"
+
+#include <vector>
+
+namespace byte_track
+{
+/**
+ * Constant velocity Kalman filter on (cx, cy, aspect, h) working on STrackStore slots.
+ * predict() runs all tracks in one pass with per component loops so compiler can vectorize them,
+ * update() runs a batch of measurements.
+ */
+class KalmanFilter
+{
+public:
+    KalmanFilter(const float& std_weight_position = 1. / 20,
+                 const float& std_weight_velocity = 1. / 160);
+
+    // measurement is xyah: center x, center y, aspect(w / h), h
+    void initiate(STrackStore &store, const int &idx, const float measurement[4]);
+
+    // predict tracks whose mask is not zero, mask size must be store.capacity()
+    void predict(STrackStore &store, const std::vector<uint8_t> &mask);
+
+    void update(STrackStore &store, const int &idx, const float measurement[4]);
+
+    // measurements: 4 floats per index
+    void update(STrackStore &store, const std::vector<int> &indexes, const std::vector<float> &measurements);
+
+private:
+    float std_weight_position_;
+    float std_weight_velocity_;
+
+    std::vector<float> q_pos_;
+    std::vector<float> q_vel_;
+};
+}
@@ -1,80 +1,67 @@
-#pragma once
-
-#include "ByteTrack/Rect.h"
-#include "ByteTrack/Object.h"
-#include "ByteTrack/KalmanFilter.h"
-
-#include <cstddef>
-#include <deque>
-
-namespace byte_track
-{
-enum class STrackState {
-    New = 0,
-    Tracked = 1,
-    Lost = 2,
-    Removed = 3,
-};
-
-class STrack
-{
-public:
-    STrack(const Rect<float>& rect, const float& score, const int &label,const int& max_history);
-    ~STrack();
-
-    const Rect<float>& getRect() const;
-    const STrackState& getSTrackState() const;
-
-    const bool& isActivated() const;
-    const float& getScore() const;
-    const size_t& getTrackId() const;
-    const size_t& getFrameId() const;
-    const size_t& getStartFrameId() const;
-    const size_t& getTrackletLength() const;
-
-    void activate(const size_t& frame_id, const size_t& track_id);
-    void reActivate(const STrack &new_track, const size_t &frame_id, const int &new_track_id = -1);
-
-    void predict();
-    void update(const STrack &new_track, const size_t &frame_id);
-
-    void markAsLost();
-    void markAsRemoved();
-
-    std::deque<Object> &get_rect_history()
-    {
-        return rect_history_;
-    }
-
-    bool getLost() const
-    {
-        return lost_;
-    }
-
-    void setLost(const bool &lost)
-    {
-        lost_ = lost;
-    }
-
-private:
-    KalmanFilter kalman_filter_;
-    KalmanFilter::StateMean mean_;
-    KalmanFilter::StateCov covariance_;
-
-    Rect<float> rect_;
-    std::deque<Object> rect_history_;
-    STrackState state_;
-
-    bool is_activated_;
-    float score_;
-    int label_;
-    int max_history_;
-    size_t track_id_;
-    size_t frame_id_;
-    size_t start_frame_id_;
-    size_t tracklet_len_;
-    bool lost_;
-
-    void updateRect();
-};
-}
\ No newline at end of file
+#pragma once
+
+#include "ByteTrack/Rect.h"
+#include "ByteTrack/Object.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace byte_track
+{
+enum class STrackState {
+    New = 0,
+    Tracked = 1,
+    Lost = 2,
+    Removed = 3,
+};
+
+/**
+ * Structure of arrays storage of all tracks of one tracker.
+ * A track is referred by its slot index, slots of removed tracks are reused by new tracks,
+ * Kalman state is stored per component so predict can run on all slots in one loop.
+ */
+class STrackStore
+{
+public:
+    static constexpr int STATE_DIM = 8;
+    static constexpr int COV_SIZE = STATE_DIM * STATE_DIM;
+
+    STrackStore(const int &max_history);
+
+    // slot count, including free slots
+    size_t capacity() const { return live_.size(); }
+
+    // allocate a slot for a new track, state New, not activated
+    int alloc(const Rect<float> &rect, const float &score, const int &label);
+    void release(const int &idx);
+    bool isLive(const int &idx) const { return live_[idx] != 0; }
+
+    // update rect from Kalman mean and append to history
+    void updateRect(const int &idx);
+
+    // Kalman mean, mean[k][idx] is component k of track idx: cx, cy, aspect, h and their velocities
+    std::vector<float> mean[STATE_DIM];
+    // Kalman covariance, cov[r * 8 + c][idx]
+    std::vector<float> cov[COV_SIZE];
+
+    // rect of last update, tlwh
+    std::vector<float> x, y, w, h;
+    std::vector<float> score;
+    std::vector<int> label;
+    std::vector<STrackState> state;
+    std::vector<uint8_t> activated;
+    std::vector<uint8_t> lost;
+    std::vector<size_t> track_id;
+    std::vector<size_t> frame_id;
+    std::vector<size_t> start_frame_id;
+    std::vector<size_t> tracklet_len;
+    std::vector<std::deque<Object>> history;
+
+private:
+    int max_history_;
+    std::vector<uint8_t> live_;
+    std::vector<int> free_;
+};
+}
@@ -1309,6 +1309,7 @@ namespace maix::camera
 
     image::Image *Camera::read(void *buff, size_t buff_size, bool block, int block_ms)
     {
+        MAIX_TRACE_SCOPE("camera.read", "vision");
         (void)block_ms;
         if (!this->is_opened()) {
             err::Err e = open(_width, _height, _format, _buff_num);
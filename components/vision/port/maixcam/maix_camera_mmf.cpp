@@ -1162,6 +1162,7 @@ _error:
 
     image::Image *Camera::read(void *buff, size_t buff_size, bool block, int block_ms)
     {
+        MAIX_TRACE_SCOPE("camera.read", "vision");
         if (!this->is_opened()) {
             err::Err e = open(_width, _height, _format, _fps, _buff_num);
             err::check_raise(e, "open camera failed");
@@ -624,6 +624,7 @@ namespace maix::video
     }
 
     video::Frame *Encoder::encode(image::Image *img, Bytes *pcm) {
+        MAIX_TRACE_SCOPE("video.encode", "vision");
         uint8_t *stream_buffer = NULL;
         int stream_size = 0;
         uint64_t pts = 0, dts = 0;
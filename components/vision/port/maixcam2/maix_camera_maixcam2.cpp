@@ -657,6 +657,7 @@ namespace maix::camera
 
     image::Image *Camera::read(void *buff, size_t buff_size, bool block, int block_ms)
     {
+        MAIX_TRACE_SCOPE("camera.read", "vision");
         auto *priv = (camera_priv_t *)_param;
         auto vi = priv->ax_vi;
         if (!this->is_opened()) {
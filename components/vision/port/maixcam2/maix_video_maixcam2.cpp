@@ -525,6 +525,7 @@ namespace maix::video
     }
 
     video::Frame *Encoder::encode(image::Image *img, Bytes *pcm) {
+        MAIX_TRACE_SCOPE("video.encode", "vision");
         auto err = err::ERR_NONE;
         auto param = (encoder_param_t *)_param;
         auto need_save = false;
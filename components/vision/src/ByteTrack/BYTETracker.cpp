@@ -1,597 +1,541 @@
-#include "ByteTrack/BYTETracker.h"
-
-#include <cstddef>
-#include <limits>
-#include <map>
-#include <memory>
-#include <stdexcept>
-#include <utility>
-#include <vector>
-
-byte_track::BYTETracker::BYTETracker(const int& max_lost_buff_num,
-                                     const float& track_thresh,  // 持续跟踪
-                                     const float& high_thresh,   // 增加新 id
-                                     const float& match_thresh,  // 
-                                     const int& max_history) :
-    track_thresh_(track_thresh),
-    high_thresh_(high_thresh),
-    match_thresh_(match_thresh),
-    max_history_(max_history),
-    max_time_lost_(static_cast<size_t>(max_lost_buff_num)),
-    frame_id_(0),
-    track_id_count_(0)
-{
-}
-
-byte_track::BYTETracker::~BYTETracker()
-{
-}
-
-std::vector<byte_track::BYTETracker::STrackPtr> byte_track::BYTETracker::update(const std::vector<Object>& objects)
-{
-    ////////////////// Step 1: Get detections //////////////////
-    frame_id_++;
-
-    // Create new STracks using the result of object detection
-    std::vector<STrackPtr> det_stracks;
-    std::vector<STrackPtr> det_low_stracks;
-
-    for (const auto &object : objects)
-    {
-        const auto strack = std::make_shared<STrack>(object.rect, object.prob, object.label, max_history_);
-        if (object.prob >= track_thresh_)
-        {
-            det_stracks.push_back(strack);
-        }
-        else
-        {
-            det_low_stracks.push_back(strack);
-        }
-    }
-
-    // Create lists of existing STrack
-    std::vector<STrackPtr> active_stracks;
-    std::vector<STrackPtr> non_active_stracks;
-    std::vector<STrackPtr> strack_pool;
-
-    for (const auto& tracked_strack : tracked_stracks_)
-    {
-        if (!tracked_strack->isActivated())
-        {
-            non_active_stracks.push_back(tracked_strack);
-        }
-        else
-        {
-            active_stracks.push_back(tracked_strack);
-        }
-    }
-
-    strack_pool = jointStracks(active_stracks, lost_stracks_);
-
-    // Predict current pose by KF
-    for (auto &strack : strack_pool)
-    {
-        strack->predict();
-    }
-
-    ////////////////// Step 2: First association, with IoU //////////////////
-    std::vector<STrackPtr> current_tracked_stracks;
-    std::vector<STrackPtr> remain_tracked_stracks;
-    std::vector<STrackPtr> remain_det_stracks;
-    std::vector<STrackPtr> refind_stracks;
-
-    {
-        std::vector<std::vector<int>> matches_idx;
-        std::vector<int> unmatch_detection_idx, unmatch_track_idx;
-
-        const auto dists = calcIouDistance(strack_pool, det_stracks);
-        linearAssignment(dists, strack_pool.size(), det_stracks.size(), match_thresh_,
-                         matches_idx, unmatch_track_idx, unmatch_detection_idx);
-
-        for (const auto &match_idx : matches_idx)
-        {
-            const auto track = strack_pool[match_idx[0]];
-            const auto det = det_stracks[match_idx[1]];
-            if (track->getSTrackState() == STrackState::Tracked)
-            {
-                track->update(*det, frame_id_);
-                current_tracked_stracks.push_back(track);
-            }
-            else
-            {
-                track->reActivate(*det, frame_id_);
-                refind_stracks.push_back(track);
-            }
-        }
-
-        for (const auto &unmatch_idx : unmatch_detection_idx)
-        {
-            remain_det_stracks.push_back(det_stracks[unmatch_idx]);
-        }
-
-        for (const auto &unmatch_idx : unmatch_track_idx)
-        {
-            if (strack_pool[unmatch_idx]->getSTrackState() == STrackState::Tracked)
-            {
-                remain_tracked_stracks.push_back(strack_pool[unmatch_idx]);
-            }
-        }
-    }
-
-    ////////////////// Step 3: Second association, using low score dets //////////////////
-    std::vector<STrackPtr> current_lost_stracks;
-
-    {
-        std::vector<std::vector<int>> matches_idx;
-        std::vector<int> unmatch_track_idx, unmatch_detection_idx;
-
-        const auto dists = calcIouDistance(remain_tracked_stracks, det_low_stracks);
-        linearAssignment(dists, remain_tracked_stracks.size(), det_low_stracks.size(), 0.5,
-                         matches_idx, unmatch_track_idx, unmatch_detection_idx);
-
-        for (const auto &match_idx : matches_idx)
-        {
-            const auto track = remain_tracked_stracks[match_idx[0]];
-            const auto det = det_low_stracks[match_idx[1]];
-            if (track->getSTrackState() == STrackState::Tracked)
-            {
-                track->update(*det, frame_id_);
-                current_tracked_stracks.push_back(track);
-            }
-            else
-            {
-                track->reActivate(*det, frame_id_);
-                refind_stracks.push_back(track);
-            }
-        }
-
-        for (const auto &unmatch_track : unmatch_track_idx)
-        {
-            const auto track = remain_tracked_stracks[unmatch_track];
-            if (track->getSTrackState() != STrackState::Lost)
-            {
-                track->markAsLost();
-                current_lost_stracks.push_back(track);
-            }
-        }
-    }
-
-    ////////////////// Step 4: Init new stracks //////////////////
-    std::vector<STrackPtr> current_removed_stracks;
-
-    {
-        std::vector<int> unmatch_detection_idx;
-        std::vector<int> unmatch_unconfirmed_idx;
-        std::vector<std::vector<int>> matches_idx;
-
-        // Deal with unconfirmed tracks, usually tracks with only one beginning frame
-        const auto dists = calcIouDistance(non_active_stracks, remain_det_stracks);
-        linearAssignment(dists, non_active_stracks.size(), remain_det_stracks.size(), 0.7,
-                         matches_idx, unmatch_unconfirmed_idx, unmatch_detection_idx);
-
-        for (const auto &match_idx : matches_idx)
-        {
-            non_active_stracks[match_idx[0]]->update(*remain_det_stracks[match_idx[1]], frame_id_);
-            current_tracked_stracks.push_back(non_active_stracks[match_idx[0]]);
-        }
-
-        for (const auto &unmatch_idx : unmatch_unconfirmed_idx)
-        {
-            const auto track = non_active_stracks[unmatch_idx];
-            track->markAsRemoved();
-            current_removed_stracks.push_back(track);
-        }
-
-        // Add new stracks
-        for (const auto &unmatch_idx : unmatch_detection_idx)
-        {
-            const auto track = remain_det_stracks[unmatch_idx];
-            if (track->getScore() < high_thresh_)
-            {
-                continue;
-            }
-            track_id_count_++;
-            track->activate(frame_id_, track_id_count_);
-            current_tracked_stracks.push_back(track);
-        }
-    }
-
-    ////////////////// Step 5: Update state //////////////////
-    for (const auto &lost_strack : lost_stracks_)
-    {
-        if (frame_id_ - lost_strack->getFrameId() > max_time_lost_)
-        {
-            lost_strack->markAsRemoved();
-            current_removed_stracks.push_back(lost_strack);
-        }
-    }
-
-    tracked_stracks_ = jointStracks(current_tracked_stracks, refind_stracks);
-    lost_stracks_ = subStracks(jointStracks(subStracks(lost_stracks_, tracked_stracks_), current_lost_stracks), current_removed_stracks);
-    // lost_stracks_ = subStracks(jointStracks(subStracks(lost_stracks_, tracked_stracks_), current_lost_stracks), removed_stracks_);
-    // removed_stracks_ = jointStracks(removed_stracks_, current_removed_stracks);
-
-    std::vector<STrackPtr> tracked_stracks_out, lost_stracks_out;
-    removeDuplicateStracks(tracked_stracks_, lost_stracks_, tracked_stracks_out, lost_stracks_out);
-    tracked_stracks_ = tracked_stracks_out;
-    lost_stracks_ = lost_stracks_out;
-
-    std::vector<STrackPtr> output_stracks;
-    for (const auto &track : tracked_stracks_)
-    {
-        if (track->isActivated())
-        {
-            track->setLost(false);
-            output_stracks.push_back(track);
-        }
-    }
-    for (const auto &track : lost_stracks_)
-    {
-        if (track->isActivated())
-        {
-            track->setLost(true);
-            output_stracks.push_back(track);
-        }
-    }
-    return output_stracks;
-}
-std::vector<byte_track::BYTETracker::STrackPtr> byte_track::BYTETracker::jointStracks(const std::vector<STrackPtr> &a_tlist,
-                                                                                      const std::vector<STrackPtr> &b_tlist) const
-{
-    std::map<int, int> exists;
-    std::vector<STrackPtr> res;
-    for (size_t i = 0; i < a_tlist.size(); i++)
-    {
-        exists.emplace(a_tlist[i]->getTrackId(), 1);
-        res.push_back(a_tlist[i]);
-    }
-    for (size_t i = 0; i < b_tlist.size(); i++)
-    {
-        const int &tid = b_tlist[i]->getTrackId();
-        if (!exists[tid] || exists.count(tid) == 0)
-        {
-            exists[tid] = 1;
-            res.push_back(b_tlist[i]);
-        }
-    }
-    return res;
-}
-
-std::vector<byte_track::BYTETracker::STrackPtr> byte_track::BYTETracker::subStracks(const std::vector<STrackPtr> &a_tlist,
-                                                                                    const std::vector<STrackPtr> &b_tlist) const
-{
-    std::map<int, STrackPtr> stracks;
-    for (size_t i = 0; i < a_tlist.size(); i++)
-    {
-        stracks.emplace(a_tlist[i]->getTrackId(), a_tlist[i]);
-    }
-
-    for (size_t i = 0; i < b_tlist.size(); i++)
-    {
-        const int &tid = b_tlist[i]->getTrackId();
-        if (stracks.count(tid) != 0)
-        {
-            stracks.erase(tid);
-        }
-    }
-
-    std::vector<STrackPtr> res;
-    std::map<int, STrackPtr>::iterator it;
-    for (it = stracks.begin(); it != stracks.end(); ++it)
-    {
-        res.push_back(it->second);
-    }
-
-    return res;
-}
-
-void byte_track::BYTETracker::removeDuplicateStracks(const std::vector<STrackPtr> &a_stracks,
-                                                     const std::vector<STrackPtr> &b_stracks,
-                                                     std::vector<STrackPtr> &a_res,
-                                                     std::vector<STrackPtr> &b_res) const
-{
-    const auto ious = calcIouDistance(a_stracks, b_stracks);
-
-    std::vector<std::pair<size_t, size_t>> overlapping_combinations;
-    for (size_t i = 0; i < ious.size(); i++)
-    {
-        for (size_t j = 0; j < ious[i].size(); j++)
-        {
-            if (ious[i][j] < 0.15)
-            {
-                overlapping_combinations.emplace_back(i, j);
-            }
-        }
-    }
-
-    std::vector<bool> a_overlapping(a_stracks.size(), false), b_overlapping(b_stracks.size(), false);
-    for (const auto &[a_idx, b_idx] : overlapping_combinations)
-    {
-        const int timep = a_stracks[a_idx]->getFrameId() - a_stracks[a_idx]->getStartFrameId();
-        const int timeq = b_stracks[b_idx]->getFrameId() - b_stracks[b_idx]->getStartFrameId();
-        if (timep > timeq)
-        {
-            b_overlapping[b_idx] = true;
-        }
-        else
-        {
-            a_overlapping[a_idx] = true;
-        }
-    }
-
-    for (size_t ai = 0; ai < a_stracks.size(); ai++)
-    {
-        if (!a_overlapping[ai])
-        {
-            a_res.push_back(a_stracks[ai]);
-        }
-    }
-
-    for (size_t bi = 0; bi < b_stracks.size(); bi++)
-    {
-        if (!b_overlapping[bi])
-        {
-            b_res.push_back(b_stracks[bi]);
-        }
-    }
-}
-
-void byte_track::BYTETracker::linearAssignment(const std::vector<std::vector<float>> &cost_matrix,
-                                               const int &cost_matrix_size,
-                                               const int &cost_matrix_size_size,
-                                               const float &thresh,
-                                               std::vector<std::vector<int>> &matches,
-                                               std::vector<int> &a_unmatched,
-                                               std::vector<int> &b_unmatched) const
-{
-    if (cost_matrix.size() == 0)
-    {
-        for (int i = 0; i < cost_matrix_size; i++)
-        {
-            a_unmatched.push_back(i);
-        }
-        for (int i = 0; i < cost_matrix_size_size; i++)
-        {
-            b_unmatched.push_back(i);
-        }
-        return;
-    }
-
-    std::vector<int> rowsol; std::vector<int> colsol;
-    execLapjv(cost_matrix, rowsol, colsol, true, thresh);
-    for (size_t i = 0; i < rowsol.size(); i++)
-    {
-        if (rowsol[i] >= 0)
-        {
-            std::vector<int> match;
-            match.push_back(i);
-            match.push_back(rowsol[i]);
-            matches.push_back(match);
-        }
-        else
-        {
-            a_unmatched.push_back(i);
-        }
-    }
-
-    for (size_t i = 0; i < colsol.size(); i++)
-    {
-        if (colsol[i] < 0)
-        {
-            b_unmatched.push_back(i);
-        }
-    }
-}
-
-std::vector<std::vector<float>> byte_track::BYTETracker::calcIous(const std::vector<Rect<float>> &a_rect,
-                                                                  const std::vector<Rect<float>> &b_rect) const
-{
-    std::vector<std::vector<float>> ious;
-    if (a_rect.size() * b_rect.size() == 0)
-    {
-        return ious;
-    }
-
-    ious.resize(a_rect.size());
-    for (size_t i = 0; i < ious.size(); i++)
-    {
-        ious[i].resize(b_rect.size());
-    }
-
-    for (size_t bi = 0; bi < b_rect.size(); bi++)
-    {
-        for (size_t ai = 0; ai < a_rect.size(); ai++)
-        {
-            ious[ai][bi] = b_rect[bi].calcIoU(a_rect[ai]);
-        }
-    }
-    return ious;
-}
-
-std::vector<std::vector<float> > byte_track::BYTETracker::calcIouDistance(const std::vector<STrackPtr> &a_tracks,
-                                                                          const std::vector<STrackPtr> &b_tracks) const
-{
-    std::vector<byte_track::Rect<float>> a_rects, b_rects;
-    for (size_t i = 0; i < a_tracks.size(); i++)
-    {
-        a_rects.push_back(a_tracks[i]->getRect());
-    }
-
-    for (size_t i = 0; i < b_tracks.size(); i++)
-    {
-        b_rects.push_back(b_tracks[i]->getRect());
-    }
-
-    const auto ious = calcIous(a_rects, b_rects);
-
-    std::vector<std::vector<float>> cost_matrix;
-    for (size_t i = 0; i < ious.size(); i++)
-    {
-        std::vector<float> iou;
-        for (size_t j = 0; j < ious[i].size(); j++)
-        {
-            iou.push_back(1 - ious[i][j]);
-        }
-        cost_matrix.push_back(iou);
-    }
-
-    return cost_matrix;
-}
-
-double byte_track::BYTETracker::execLapjv(const std::vector<std::vector<float>> &cost,
-                                          std::vector<int> &rowsol,
-                                          std::vector<int> &colsol,
-                                          bool extend_cost,
-                                          float cost_limit,
-                                          bool return_cost) const
-{
-    std::vector<std::vector<float> > cost_c;
-    cost_c.assign(cost.begin(), cost.end());
-
-    std::vector<std::vector<float> > cost_c_extended;
-
-    int n_rows = cost.size();
-    int n_cols = cost[0].size();
-    rowsol.resize(n_rows);
-    colsol.resize(n_cols);
-
-    int n = 0;
-    if (n_rows == n_cols)
-    {
-        n = n_rows;
-    }
-    else
-    {
-        if (!extend_cost)
-        {
-            throw std::runtime_error("The `extend_cost` variable should set True");
-        }
-    }
-
-    if (extend_cost || cost_limit < std::numeric_limits<float>::max())
-    {
-        n = n_rows + n_cols;
-        cost_c_extended.resize(n);
-        for (size_t i = 0; i < cost_c_extended.size(); i++)
-            cost_c_extended[i].resize(n);
-
-        if (cost_limit < std::numeric_limits<float>::max())
-        {
-            for (size_t i = 0; i < cost_c_extended.size(); i++)
-            {
-                for (size_t j = 0; j < cost_c_extended[i].size(); j++)
-                {
-                    cost_c_extended[i][j] = cost_limit / 2.0;
-                }
-            }
-        }
-        else
-        {
-            float cost_max = -1;
-            for (size_t i = 0; i < cost_c.size(); i++)
-            {
-                for (size_t j = 0; j < cost_c[i].size(); j++)
-                {
-                    if (cost_c[i][j] > cost_max)
-                        cost_max = cost_c[i][j];
-                }
-            }
-            for (size_t i = 0; i < cost_c_extended.size(); i++)
-            {
-                for (size_t j = 0; j < cost_c_extended[i].size(); j++)
-                {
-                    cost_c_extended[i][j] = cost_max + 1;
-                }
-            }
-        }
-
-        for (size_t i = n_rows; i < cost_c_extended.size(); i++)
-        {
-            for (size_t j = n_cols; j < cost_c_extended[i].size(); j++)
-            {
-                cost_c_extended[i][j] = 0;
-            }
-        }
-        for (int i = 0; i < n_rows; i++)
-        {
-            for (int j = 0; j < n_cols; j++)
-            {
-                cost_c_extended[i][j] = cost_c[i][j];
-            }
-        }
-
-        cost_c.clear();
-        cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
-    }
-
-    double **cost_ptr;
-    cost_ptr = new double *[sizeof(double *) * n];
-    for (int i = 0; i < n; i++)
-        cost_ptr[i] = new double[sizeof(double) * n];
-
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = 0; j < n; j++)
-        {
-            cost_ptr[i][j] = cost_c[i][j];
-        }
-    }
-
-    int* x_c = new int[sizeof(int) * n];
-    int *y_c = new int[sizeof(int) * n];
-
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
-    if (ret != 0)
-    {
-        throw std::runtime_error("The result of lapjv_internal() is invalid.");
-    }
-
-    double opt = 0.0;
-
-    if (n != n_rows)
-    {
-        for (int i = 0; i < n; i++)
-        {
-            if (x_c[i] >= n_cols)
-                x_c[i] = -1;
-            if (y_c[i] >= n_rows)
-                y_c[i] = -1;
-        }
-        for (int i = 0; i < n_rows; i++)
-        {
-            rowsol[i] = x_c[i];
-        }
-        for (int i = 0; i < n_cols; i++)
-        {
-            colsol[i] = y_c[i];
-        }
-
-        if (return_cost)
-        {
-            for (size_t i = 0; i < rowsol.size(); i++)
-            {
-                if (rowsol[i] != -1)
-                {
-                    opt += cost_ptr[i][rowsol[i]];
-                }
-            }
-        }
-    }
-    else if (return_cost)
-    {
-        for (size_t i = 0; i < rowsol.size(); i++)
-        {
-            opt += cost_ptr[i][rowsol[i]];
-        }
-    }
-
-    for (int i = 0; i < n; i++)
-    {
-        delete[]cost_ptr[i];
-    }
-    delete[]cost_ptr;
-    delete[]x_c;
-    delete[]y_c;
-
-    return opt;
-}
+#include "ByteTrack/BYTETracker.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+byte_track::BYTETracker::BYTETracker(const int& max_lost_buff_num,
+                                     const float& track_thresh,  // 持续跟踪
+                                     const float& high_thresh,   // 增加新 id
+                                     const float& match_thresh,  //
+                                     const int& max_history) :
+    track_thresh_(track_thresh),
+    high_thresh_(high_thresh),
+    match_thresh_(match_thresh),
+    max_history_(max_history),
+    max_time_lost_(static_cast<size_t>(max_lost_buff_num)),
+    frame_id_(0),
+    track_id_count_(0),
+    store_(max_history),
+    kalman_filter_()
+{
+}
+
+byte_track::BYTETracker::~BYTETracker()
+{
+}
+
+float byte_track::calcIoU(const BYTETracker::Box &a, const BYTETracker::Box &b)
+{
+    const float box_area = (b.w + 1) * (b.h + 1);
+    const float iw = std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x) + 1;
+    float iou = 0;
+    if (iw > 0)
+    {
+        const float ih = std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y) + 1;
+        if (ih > 0)
+        {
+            const float ua = (a.w + 1) * (a.h + 1) + box_area - iw * ih;
+            iou = iw * ih / ua;
+        }
+    }
+    return iou;
+}
+
+static inline void objectXyah(const byte_track::Object &obj, float xyah[4])
+{
+    xyah[0] = obj.rect.x() + obj.rect.width() / 2;
+    xyah[1] = obj.rect.y() + obj.rect.height() / 2;
+    xyah[2] = obj.rect.width() / obj.rect.height();
+    xyah[3] = obj.rect.height();
+}
+
+static inline byte_track::BYTETracker::Box objectBox(const byte_track::Object &obj)
+{
+    return {obj.rect.x(), obj.rect.y(), obj.rect.width(), obj.rect.height()};
+}
+
+void byte_track::BYTETracker::trackBoxes(const std::vector<int> &slots, std::vector<Box> &boxes) const
+{
+    boxes.resize(slots.size());
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        const int s = slots[i];
+        boxes[i] = {store_.x[s], store_.y[s], store_.w[s], store_.h[s]};
+    }
+}
+
+void byte_track::BYTETracker::updateTrack(const int &idx, const Object &det, const bool &reactivate)
+{
+    // Kalman state already updated, history records score before this update
+    store_.updateRect(idx);
+    store_.state[idx] = STrackState::Tracked;
+    store_.activated[idx] = 1;
+    store_.score[idx] = det.prob;
+    store_.frame_id[idx] = frame_id_;
+    if (reactivate)
+        store_.tracklet_len[idx] = 0;
+    else
+        store_.tracklet_len[idx]++;
+}
+
+const std::vector<int> &byte_track::BYTETracker::update(const std::vector<Object>& objects)
+{
+    ////////////////// Step 1: Get detections //////////////////
+    frame_id_++;
+
+    std::vector<int> det_high, det_low;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        if (objects[i].prob >= track_thresh_)
+            det_high.push_back(i);
+        else
+            det_low.push_back(i);
+    }
+
+    // Create lists of existing STrack
+    std::vector<int> active_stracks;
+    std::vector<int> non_active_stracks;
+    std::vector<int> strack_pool;
+
+    for (const int &s : tracked_stracks_)
+    {
+        if (!store_.activated[s])
+            non_active_stracks.push_back(s);
+        else
+            active_stracks.push_back(s);
+    }
+    strack_pool = active_stracks;
+    strack_pool.insert(strack_pool.end(), lost_stracks_.begin(), lost_stracks_.end());
+
+    // Predict current pose of all pool tracks by KF in one pass
+    predict_mask_.assign(store_.capacity(), 0);
+    for (const int &s : strack_pool)
+    {
+        if (store_.state[s] != STrackState::Tracked)
+            store_.mean[7][s] = 0;
+        predict_mask_[s] = 1;
+    }
+    kalman_filter_.predict(store_, predict_mask_);
+
+    std::vector<Box> a_boxes, b_boxes;
+    std::vector<std::pair<int, int>> matches;
+    std::vector<int> unmatch_a, unmatch_b;
+    std::vector<int> kf_idx;
+    std::vector<float> kf_meas;
+
+    // update matched tracks, Kalman update in batch then bookkeeping
+    auto apply_matches = [&](const std::vector<int> &tracks, const std::vector<int> &dets,
+                             std::vector<int> &updated, std::vector<int> &refind) {
+        kf_idx.clear();
+        kf_meas.resize(matches.size() * 4);
+        for (size_t i = 0; i < matches.size(); i++)
+        {
+            kf_idx.push_back(tracks[matches[i].first]);
+            objectXyah(objects[dets[matches[i].second]], &kf_meas[i * 4]);
+        }
+        kalman_filter_.update(store_, kf_idx, kf_meas);
+        for (const auto &match : matches)
+        {
+            const int s = tracks[match.first];
+            const Object &det = objects[dets[match.second]];
+            if (store_.state[s] == STrackState::Tracked)
+            {
+                updateTrack(s, det, false);
+                updated.push_back(s);
+            }
+            else
+            {
+                updateTrack(s, det, true);
+                refind.push_back(s);
+            }
+        }
+    };
+    auto det_boxes = [&](const std::vector<int> &dets, std::vector<Box> &boxes) {
+        boxes.resize(dets.size());
+        for (size_t i = 0; i < dets.size(); i++)
+            boxes[i] = objectBox(objects[dets[i]]);
+    };
+
+    ////////////////// Step 2: First association, with IoU //////////////////
+    std::vector<int> current_tracked_stracks;
+    std::vector<int> remain_tracked_stracks;
+    std::vector<int> remain_det_stracks;
+    std::vector<int> refind_stracks;
+
+    trackBoxes(strack_pool, a_boxes);
+    det_boxes(det_high, b_boxes);
+    linearAssignment(a_boxes, b_boxes, match_thresh_, matches, unmatch_a, unmatch_b);
+    apply_matches(strack_pool, det_high, current_tracked_stracks, refind_stracks);
+    for (const int &i : unmatch_b)
+        remain_det_stracks.push_back(det_high[i]);
+    for (const int &i : unmatch_a)
+    {
+        if (store_.state[strack_pool[i]] == STrackState::Tracked)
+            remain_tracked_stracks.push_back(strack_pool[i]);
+    }
+
+    ////////////////// Step 3: Second association, using low score dets //////////////////
+    std::vector<int> current_lost_stracks;
+
+    trackBoxes(remain_tracked_stracks, a_boxes);
+    det_boxes(det_low, b_boxes);
+    linearAssignment(a_boxes, b_boxes, 0.5, matches, unmatch_a, unmatch_b);
+    apply_matches(remain_tracked_stracks, det_low, current_tracked_stracks, refind_stracks);
+    for (const int &i : unmatch_a)
+    {
+        const int s = remain_tracked_stracks[i];
+        if (store_.state[s] != STrackState::Lost)
+        {
+            store_.state[s] = STrackState::Lost;
+            current_lost_stracks.push_back(s);
+        }
+    }
+
+    ////////////////// Step 4: Init new stracks //////////////////
+    std::vector<int> current_removed_stracks;
+
+    // Deal with unconfirmed tracks, usually tracks with only one beginning frame
+    trackBoxes(non_active_stracks, a_boxes);
+    det_boxes(remain_det_stracks, b_boxes);
+    linearAssignment(a_boxes, b_boxes, 0.7, matches, unmatch_a, unmatch_b);
+    apply_matches(non_active_stracks, remain_det_stracks, current_tracked_stracks, refind_stracks);
+    for (const int &i : unmatch_a)
+    {
+        const int s = non_active_stracks[i];
+        store_.state[s] = STrackState::Removed;
+        current_removed_stracks.push_back(s);
+    }
+
+    // Add new stracks
+    for (const int &i : unmatch_b)
+    {
+        const Object &det = objects[remain_det_stracks[i]];
+        if (det.prob < high_thresh_)
+        {
+            continue;
+        }
+        const int s = store_.alloc(det.rect, det.prob, det.label);
+        float xyah[4];
+        objectXyah(det, xyah);
+        kalman_filter_.initiate(store_, s, xyah);
+        store_.updateRect(s);
+        store_.state[s] = STrackState::Tracked;
+        store_.activated[s] = frame_id_ == 1;
+        store_.track_id[s] = ++track_id_count_;
+        store_.frame_id[s] = frame_id_;
+        store_.start_frame_id[s] = frame_id_;
+        store_.tracklet_len[s] = 0;
+        current_tracked_stracks.push_back(s);
+    }
+
+    ////////////////// Step 5: Update state //////////////////
+    for (const int &s : lost_stracks_)
+    {
+        if (frame_id_ - store_.frame_id[s] > max_time_lost_)
+        {
+            store_.state[s] = STrackState::Removed;
+            current_removed_stracks.push_back(s);
+        }
+    }
+
+    tracked_stracks_ = current_tracked_stracks;
+    tracked_stracks_.insert(tracked_stracks_.end(), refind_stracks.begin(), refind_stracks.end());
+
+    // lost = (lost - tracked) + current lost - removed, ordered by track id
+    std::vector<uint8_t> in_tracked(store_.capacity(), 0), removed(store_.capacity(), 0);
+    for (const int &s : tracked_stracks_)
+        in_tracked[s] = 1;
+    for (const int &s : current_removed_stracks)
+        removed[s] = 1;
+    std::vector<int> lost;
+    for (const int &s : lost_stracks_)
+    {
+        if (!in_tracked[s] && !removed[s])
+            lost.push_back(s);
+    }
+    for (const int &s : current_lost_stracks)
+    {
+        if (!removed[s])
+            lost.push_back(s);
+    }
+    std::sort(lost.begin(), lost.end(), [this](const int &a, const int &b) {
+        return store_.track_id[a] < store_.track_id[b];
+    });
+    lost_stracks_ = lost;
+
+    removeDuplicateStracks(tracked_stracks_, lost_stracks_);
+
+    // release slots not referenced any more
+    std::vector<uint8_t> keep(store_.capacity(), 0);
+    for (const int &s : tracked_stracks_)
+        keep[s] = 1;
+    for (const int &s : lost_stracks_)
+        keep[s] = 1;
+    for (size_t s = 0; s < store_.capacity(); s++)
+    {
+        if (store_.isLive(s) && !keep[s])
+            store_.release(s);
+    }
+
+    output_stracks_.clear();
+    for (const int &s : tracked_stracks_)
+    {
+        if (store_.activated[s])
+        {
+            store_.lost[s] = 0;
+            output_stracks_.push_back(s);
+        }
+    }
+    for (const int &s : lost_stracks_)
+    {
+        if (store_.activated[s])
+        {
+            store_.lost[s] = 1;
+            output_stracks_.push_back(s);
+        }
+    }
+    return output_stracks_;
+}
+
+void byte_track::BYTETracker::removeDuplicateStracks(std::vector<int> &a_stracks,
+                                                     std::vector<int> &b_stracks)
+{
+    std::vector<Box> a_boxes, b_boxes;
+    std::vector<std::pair<int, int>> pairs;
+    trackBoxes(a_stracks, a_boxes);
+    trackBoxes(b_stracks, b_boxes);
+    gatePairs(a_boxes, b_boxes, 0.15, pairs);
+    if (pairs.empty())
+        return;
+
+    std::vector<bool> a_overlapping(a_stracks.size(), false), b_overlapping(b_stracks.size(), false);
+    for (const auto &[a_idx, b_idx] : pairs)
+    {
+        const int sa = a_stracks[a_idx];
+        const int sb = b_stracks[b_idx];
+        const int timep = store_.frame_id[sa] - store_.start_frame_id[sa];
+        const int timeq = store_.frame_id[sb] - store_.start_frame_id[sb];
+        if (timep > timeq)
+        {
+            b_overlapping[b_idx] = true;
+        }
+        else
+        {
+            a_overlapping[a_idx] = true;
+        }
+    }
+
+    size_t n = 0;
+    for (size_t ai = 0; ai < a_stracks.size(); ai++)
+    {
+        if (!a_overlapping[ai])
+            a_stracks[n++] = a_stracks[ai];
+    }
+    a_stracks.resize(n);
+    n = 0;
+    for (size_t bi = 0; bi < b_stracks.size(); bi++)
+    {
+        if (!b_overlapping[bi])
+            b_stracks[n++] = b_stracks[bi];
+    }
+    b_stracks.resize(n);
+}
+
+void byte_track::BYTETracker::gatePairs(const std::vector<Box> &a_boxes,
+                                        const std::vector<Box> &b_boxes,
+                                        const float &thresh,
+                                        std::vector<std::pair<int, int>> &pairs)
+{
+    pairs.clear();
+    if (a_boxes.empty() || b_boxes.empty())
+        return;
+
+    // boxes overlap only if b.x in (a.x - b.w - 1, a.x + a.w + 1), sweep b sorted by x
+    sort_idx_.resize(b_boxes.size());
+    float max_w = 0;
+    for (size_t i = 0; i < b_boxes.size(); i++)
+    {
+        sort_idx_[i] = i;
+        max_w = std::max(max_w, b_boxes[i].w);
+    }
+    std::sort(sort_idx_.begin(), sort_idx_.end(), [&b_boxes](const int &a, const int &b) {
+        return b_boxes[a].x < b_boxes[b].x;
+    });
+
+    for (size_t ai = 0; ai < a_boxes.size(); ai++)
+    {
+        const Box &a = a_boxes[ai];
+        const float x_min = a.x - max_w - 1;
+        const float x_max = a.x + a.w + 1;
+        auto it = std::lower_bound(sort_idx_.begin(), sort_idx_.end(), x_min, [&b_boxes](const int &idx, const float &v) {
+            return b_boxes[idx].x < v;
+        });
+        for (; it != sort_idx_.end() && b_boxes[*it].x < x_max; ++it)
+        {
+            const Box &b = b_boxes[*it];
+            if (b.y >= a.y + a.h + 1 || a.y >= b.y + b.h + 1)
+                continue;
+            if (1 - calcIoU(a, b) < thresh)
+                pairs.emplace_back(ai, *it);
+        }
+    }
+}
+
+void byte_track::BYTETracker::linearAssignment(const std::vector<Box> &a_boxes,
+                                               const std::vector<Box> &b_boxes,
+                                               const float &thresh,
+                                               std::vector<std::pair<int, int>> &matches,
+                                               std::vector<int> &a_unmatched,
+                                               std::vector<int> &b_unmatched)
+{
+    const int na = a_boxes.size();
+    const int nb = b_boxes.size();
+    matches.clear();
+    a_unmatched.clear();
+    b_unmatched.clear();
+
+    std::vector<std::pair<int, int>> pairs;
+    gatePairs(a_boxes, b_boxes, thresh, pairs);
+
+    // union find, node a: [0, na), node b: [na, na + nb)
+    uf_parent_.resize(na + nb);
+    for (int i = 0; i < na + nb; i++)
+        uf_parent_[i] = i;
+    auto find = [this](int x) {
+        while (uf_parent_[x] != x)
+        {
+            uf_parent_[x] = uf_parent_[uf_parent_[x]];
+            x = uf_parent_[x];
+        }
+        return x;
+    };
+    for (const auto &p : pairs)
+    {
+        const int ra = find(p.first);
+        const int rb = find(na + p.second);
+        if (ra != rb)
+            uf_parent_[rb] = ra;
+    }
+
+    // group rows and cols by component, rows and cols without candidate are unmatched
+    std::vector<uint8_t> a_has(na, 0), b_has(nb, 0);
+    for (const auto &p : pairs)
+    {
+        a_has[p.first] = 1;
+        b_has[p.second] = 1;
+    }
+    std::vector<int> comp_id(na + nb, -1);
+    std::vector<std::vector<int>> comp_rows, comp_cols;
+    for (int i = 0; i < na + nb; i++)
+    {
+        if ((i < na && !a_has[i]) || (i >= na && !b_has[i - na]))
+            continue;
+        const int r = find(i);
+        if (comp_id[r] < 0)
+        {
+            comp_id[r] = comp_rows.size();
+            comp_rows.emplace_back();
+            comp_cols.emplace_back();
+        }
+        if (i < na)
+            comp_rows[comp_id[r]].push_back(i);
+        else
+            comp_cols[comp_id[r]].push_back(i - na);
+    }
+
+    std::vector<int> a_match(na, -1), b_match(nb, -1);
+    std::vector<int> rowsol, colsol;
+    for (size_t c = 0; c < comp_rows.size(); c++)
+    {
+        const std::vector<int> &rows = comp_rows[c];
+        const std::vector<int> &cols = comp_cols[c];
+        if (rows.size() == 1 && cols.size() == 1)
+        {
+            // only one candidate pair and its cost < thresh
+            a_match[rows[0]] = cols[0];
+            b_match[cols[0]] = rows[0];
+            continue;
+        }
+        block_cost_.resize(rows.size() * cols.size());
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            for (size_t j = 0; j < cols.size(); j++)
+            {
+                block_cost_[i * cols.size() + j] = 1 - calcIoU(a_boxes[rows[i]], b_boxes[cols[j]]);
+            }
+        }
+        execLapjv(rows.size(), cols.size(), rowsol, colsol, thresh);
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            if (rowsol[i] >= 0)
+            {
+                a_match[rows[i]] = cols[rowsol[i]];
+                b_match[cols[rowsol[i]]] = rows[i];
+            }
+        }
+    }
+
+    for (int i = 0; i < na; i++)
+    {
+        if (a_match[i] >= 0)
+            matches.emplace_back(i, a_match[i]);
+        else
+            a_unmatched.push_back(i);
+    }
+    for (int i = 0; i < nb; i++)
+    {
+        if (b_match[i] < 0)
+            b_unmatched.push_back(i);
+    }
+}
+
+double byte_track::BYTETracker::execLapjv(int n_rows, int n_cols,
+                                          std::vector<int> &rowsol,
+                                          std::vector<int> &colsol,
+                                          float cost_limit)
+{
+    // extend cost matrix to (n_rows + n_cols) square, dummy assignment cost is cost_limit / 2,
+    // so a pair is matched only if its cost < cost_limit
+    const int n = n_rows + n_cols;
+    rowsol.resize(n_rows);
+    colsol.resize(n_cols);
+    lap_cost_.assign((size_t)n * n, cost_limit / 2.0);
+    lap_rows_.resize(n);
+    for (int i = 0; i < n; i++)
+        lap_rows_[i] = &lap_cost_[(size_t)i * n];
+    for (int i = n_rows; i < n; i++)
+    {
+        for (int j = n_cols; j < n; j++)
+            lap_rows_[i][j] = 0;
+    }
+    for (int i = 0; i < n_rows; i++)
+    {
+        for (int j = 0; j < n_cols; j++)
+            lap_rows_[i][j] = block_cost_[(size_t)i * n_cols + j];
+    }
+
+    lap_x_.resize(n);
+    lap_y_.resize(n);
+    int ret = lapjv_internal(n, lap_rows_.data(), lap_x_.data(), lap_y_.data());
+    if (ret != 0)
+    {
+        throw std::runtime_error("The result of lapjv_internal() is invalid.");
+    }
+
+    double opt = 0.0;
+    for (int i = 0; i < n_rows; i++)
+    {
+        rowsol[i] = lap_x_[i] >= n_cols ? -1 : lap_x_[i];
+        if (rowsol[i] >= 0)
+            opt += lap_rows_[i][rowsol[i]];
+    }
+    for (int i = 0; i < n_cols; i++)
+    {
+        colsol[i] = lap_y_[i] >= n_rows ? -1 : lap_y_[i];
+    }
+    return opt;
+}
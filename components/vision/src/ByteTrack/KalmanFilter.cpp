@@ -1,89 +1,187 @@
-#include "ByteTrack/KalmanFilter.h"
-
-#include <cstddef>
-
-byte_track::KalmanFilter::KalmanFilter(const float& std_weight_position,
-                                       const float& std_weight_velocity) :
-    std_weight_position_(std_weight_position),
-    std_weight_velocity_(std_weight_velocity)
-{
-    constexpr size_t ndim = 4;
-    constexpr float dt = 1;
-
-    motion_mat_ = Eigen::MatrixXf::Identity(8, 8);
-    update_mat_ = Eigen::MatrixXf::Identity(4, 8);
-
-    for (size_t i = 0; i < ndim; i++)
-    {
-        motion_mat_(i, ndim + i) = dt;
-    }
-}
-
-void byte_track::KalmanFilter::initiate(StateMean &mean, StateCov &covariance, const DetectBox &measurement)
-{
-    mean.block<1, 4>(0, 0) = measurement.block<1, 4>(0, 0);
-    mean.block<1, 4>(0, 4) = Eigen::Vector4f::Zero();
-
-    StateMean std;
-    std(0) = 2 * std_weight_position_ * measurement[3];
-    std(1) = 2 * std_weight_position_ * measurement[3];
-    std(2) = 1e-2;
-    std(3) = 2 * std_weight_position_ * measurement[3];
-    std(4) = 10 * std_weight_velocity_ * measurement[3];
-    std(5) = 10 * std_weight_velocity_ * measurement[3];
-    std(6) = 1e-5;
-    std(7) = 10 * std_weight_velocity_ * measurement[3];
-
-    StateMean tmp = std.array().square();
-    covariance = tmp.asDiagonal();
-}
-
-void byte_track::KalmanFilter::predict(StateMean &mean, StateCov &covariance)
-{
-    StateMean std;
-    std(0) = std_weight_position_ * mean(3);
-    std(1) = std_weight_position_ * mean(3);
-    std(2) = 1e-2;
-    std(3) = std_weight_position_ * mean(3);
-    std(4) = std_weight_velocity_ * mean(3);
-    std(5) = std_weight_velocity_ * mean(3);
-    std(6) = 1e-5;
-    std(7) = std_weight_velocity_ * mean(3);
-
-    StateMean tmp = std.array().square();
-    StateCov motion_cov = tmp.asDiagonal();
-
-    mean = motion_mat_ * mean.transpose();
-    covariance = motion_mat_ * covariance * (motion_mat_.transpose()) + motion_cov;
-}
-
-void byte_track::KalmanFilter::update(StateMean &mean, StateCov &covariance, const DetectBox &measurement)
-{
-    StateHMean projected_mean;
-    StateHCov projected_cov;
-    project(projected_mean, projected_cov, mean, covariance);
-
-    Eigen::Matrix<float, 4, 8> B = (covariance * (update_mat_.transpose())).transpose();
-    Eigen::Matrix<float, 8, 4> kalman_gain = (projected_cov.llt().solve(B)).transpose();
-    Eigen::Matrix<float, 1, 4> innovation = measurement - projected_mean;
-
-    const auto tmp = innovation * (kalman_gain.transpose());
-    mean = (mean.array() + tmp.array()).matrix();
-    covariance = covariance - kalman_gain * projected_cov * (kalman_gain.transpose());
-}
-
-void byte_track::KalmanFilter::project(StateHMean &projected_mean, StateHCov &projected_covariance,
-                                       const StateMean& mean, const StateCov& covariance)
-{
-    DetectBox std;
-    std << std_weight_position_ * mean(3),
-           std_weight_position_ * mean(3),
-           1e-1,
-           std_weight_position_ * mean(3);
-
-    projected_mean = update_mat_ * mean.transpose();
-    projected_covariance = update_mat_ * covariance * (update_mat_.transpose());
-
-    Eigen::Matrix<float, 4, 4> diag = std.asDiagonal();
-    projected_covariance += diag.array().square().matrix();
-}
+#include "ByteTrack/KalmanFilter.h"
+
+#include <cstddef>
+#include <cmath>
+
+byte_track::KalmanFilter::KalmanFilter(const float& std_weight_position,
+                                       const float& std_weight_velocity) :
+    std_weight_position_(std_weight_position),
+    std_weight_velocity_(std_weight_velocity)
+{
+}
+
+void byte_track::KalmanFilter::initiate(STrackStore &store, const int &idx, const float measurement[4])
+{
+    for (int k = 0; k < 4; k++)
+    {
+        store.mean[k][idx] = measurement[k];
+        store.mean[k + 4][idx] = 0;
+    }
+
+    float std[STrackStore::STATE_DIM];
+    std[0] = 2 * std_weight_position_ * measurement[3];
+    std[1] = 2 * std_weight_position_ * measurement[3];
+    std[2] = 1e-2;
+    std[3] = 2 * std_weight_position_ * measurement[3];
+    std[4] = 10 * std_weight_velocity_ * measurement[3];
+    std[5] = 10 * std_weight_velocity_ * measurement[3];
+    std[6] = 1e-5;
+    std[7] = 10 * std_weight_velocity_ * measurement[3];
+
+    for (int r = 0; r < STrackStore::STATE_DIM; r++)
+    {
+        for (int c = 0; c < STrackStore::STATE_DIM; c++)
+        {
+            store.cov[r * STrackStore::STATE_DIM + c][idx] = r == c ? std[r] * std[r] : 0;
+        }
+    }
+}
+
+void byte_track::KalmanFilter::predict(STrackStore &store, const std::vector<uint8_t> &mask)
+{
+    // motion matrix F = [[I, I], [0, I]], so with covariance blocks P = [[A, B], [B', C]]:
+    // F P F' = [[A + B + B' + C, B + C], [B' + C, C]], mean: position += velocity.
+    // Masked out tracks keep their state, m is 0 or 1.
+    const size_t n = store.capacity();
+    q_pos_.resize(n);
+    q_vel_.resize(n);
+    float *h = store.mean[3].data();
+    for (size_t i = 0; i < n; i++)
+    {
+        const float m = mask[i] ? 1.f : 0.f;
+        const float sp = std_weight_position_ * h[i];
+        const float sv = std_weight_velocity_ * h[i];
+        q_pos_[i] = m * sp * sp;
+        q_vel_[i] = m * sv * sv;
+    }
+    const float q_aspect = 1e-2f * 1e-2f;
+    const float q_aspect_vel = 1e-5f * 1e-5f;
+    constexpr int D = STrackStore::STATE_DIM;
+
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            float *A = store.cov[r * D + c].data();
+            float *B = store.cov[r * D + c + 4].data();
+            float *Bt = store.cov[(r + 4) * D + c].data();
+            float *C = store.cov[(r + 4) * D + c + 4].data();
+            const bool diag = r == c;
+            const bool aspect = r == 2;
+            for (size_t i = 0; i < n; i++)
+            {
+                const float m = mask[i] ? 1.f : 0.f;
+                const float a = A[i], b = B[i], bt = Bt[i], cc = C[i];
+                float qa = 0, qc = 0;
+                if (diag)
+                {
+                    qa = aspect ? m * q_aspect : q_pos_[i];
+                    qc = aspect ? m * q_aspect_vel : q_vel_[i];
+                }
+                A[i] = a + m * (b + bt + cc) + qa;
+                B[i] = b + m * cc;
+                Bt[i] = bt + m * cc;
+                C[i] = cc + qc;
+            }
+        }
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        float *p = store.mean[k].data();
+        const float *v = store.mean[k + 4].data();
+        for (size_t i = 0; i < n; i++)
+        {
+            p[i] += (mask[i] ? 1.f : 0.f) * v[i];
+        }
+    }
+}
+
+void byte_track::KalmanFilter::update(STrackStore &store, const int &idx, const float measurement[4])
+{
+    constexpr int D = STrackStore::STATE_DIM;
+    float P[D][D];
+    float x[D];
+    for (int r = 0; r < D; r++)
+    {
+        x[r] = store.mean[r][idx];
+        for (int c = 0; c < D; c++)
+            P[r][c] = store.cov[r * D + c][idx];
+    }
+
+    // project to measurement space, S = H P H' + R, H = [I, 0]
+    float std[4] = {std_weight_position_ * x[3], std_weight_position_ * x[3], 1e-1f, std_weight_position_ * x[3]};
+    float S[4][4];
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c < 4; c++)
+            S[r][c] = P[r][c];
+        S[r][r] += std[r] * std[r];
+    }
+
+    // cholesky S = L L'
+    float L[4][4] = {{0}};
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c <= r; c++)
+        {
+            float sum = S[r][c];
+            for (int k = 0; k < c; k++)
+                sum -= L[r][k] * L[c][k];
+            if (r == c)
+                L[r][c] = std::sqrt(sum > 0 ? sum : 1e-12f);
+            else
+                L[r][c] = sum / L[c][c];
+        }
+    }
+
+    // kalman gain K' = S^-1 (P H')' = S^-1 P[0:4, :], solve 8 columns
+    float Kt[4][D];
+    for (int j = 0; j < D; j++)
+    {
+        float z[4];
+        for (int r = 0; r < 4; r++)
+        {
+            float sum = P[r][j];
+            for (int k = 0; k < r; k++)
+                sum -= L[r][k] * z[k];
+            z[r] = sum / L[r][r];
+        }
+        for (int r = 3; r >= 0; r--)
+        {
+            float sum = z[r];
+            for (int k = r + 1; k < 4; k++)
+                sum -= L[k][r] * Kt[k][j];
+            Kt[r][j] = sum / L[r][r];
+        }
+    }
+
+    // x += K (z - H x), P -= K S K' = P H' K'
+    float innovation[4];
+    for (int r = 0; r < 4; r++)
+        innovation[r] = measurement[r] - x[r];
+    for (int r = 0; r < D; r++)
+    {
+        float sum = 0;
+        for (int k = 0; k < 4; k++)
+            sum += Kt[k][r] * innovation[k];
+        store.mean[r][idx] = x[r] + sum;
+    }
+    for (int r = 0; r < D; r++)
+    {
+        for (int c = 0; c < D; c++)
+        {
+            float sum = 0;
+            for (int k = 0; k < 4; k++)
+                sum += P[r][k] * Kt[k][c];
+            store.cov[r * D + c][idx] = P[r][c] - sum;
+        }
+    }
+}
+
+void byte_track::KalmanFilter::update(STrackStore &store, const std::vector<int> &indexes, const std::vector<float> &measurements)
+{
+    for (size_t i = 0; i < indexes.size(); i++)
+    {
+        update(store, indexes[i], &measurements[i * 4]);
+    }
+}
@@ -1,143 +1,86 @@
-#include "ByteTrack/STrack.h"
-
-#include <cstddef>
-
-byte_track::STrack::STrack(const Rect<float>& rect, const float& score, const int &label, const int& max_history) :
-    kalman_filter_(),
-    mean_(),
-    covariance_(),
-    rect_(rect),
-    state_(STrackState::New),
-    is_activated_(false),
-    score_(score),
-    label_(label),
-    max_history_(max_history),
-    track_id_(0),
-    frame_id_(0),
-    start_frame_id_(0),
-    tracklet_len_(0)
-{
-}
-
-byte_track::STrack::~STrack()
-{
-}
-
-const byte_track::Rect<float>& byte_track::STrack::getRect() const
-{
-    return rect_;
-}
-
-const byte_track::STrackState& byte_track::STrack::getSTrackState() const
-{
-    return state_;
-}
-
-const bool& byte_track::STrack::isActivated() const
-{
-    return is_activated_;
-}
-const float& byte_track::STrack::getScore() const
-{
-    return score_;
-}
-
-const size_t& byte_track::STrack::getTrackId() const
-{
-    return track_id_;
-}
-
-const size_t& byte_track::STrack::getFrameId() const
-{
-    return frame_id_;
-}
-
-const size_t& byte_track::STrack::getStartFrameId() const
-{
-    return start_frame_id_;
-}
-
-const size_t& byte_track::STrack::getTrackletLength() const
-{
-    return tracklet_len_;
-}
-
-void byte_track::STrack::activate(const size_t& frame_id, const size_t& track_id)
-{
-    kalman_filter_.initiate(mean_, covariance_, rect_.getXyah());
-
-    updateRect();
-
-    state_ = STrackState::Tracked;
-    if (frame_id == 1)
-    {
-        is_activated_ = true;
-    }
-    track_id_ = track_id;
-    frame_id_ = frame_id;
-    start_frame_id_ = frame_id;
-    tracklet_len_ = 0;
-}
-
-void byte_track::STrack::reActivate(const STrack &new_track, const size_t &frame_id, const int &new_track_id)
-{
-    kalman_filter_.update(mean_, covariance_, new_track.getRect().getXyah());
-
-    updateRect();
-
-    state_ = STrackState::Tracked;
-    is_activated_ = true;
-    score_ = new_track.getScore();
-    if (0 <= new_track_id)
-    {
-        track_id_ = new_track_id;
-    }
-    frame_id_ = frame_id;
-    tracklet_len_ = 0;
-}
-
-void byte_track::STrack::predict()
-{
-    if (state_ != STrackState::Tracked)
-    {
-        mean_[7] = 0;
-    }
-    kalman_filter_.predict(mean_, covariance_);
-}
-
-void byte_track::STrack::update(const STrack &new_track, const size_t &frame_id)
-{
-    kalman_filter_.update(mean_, covariance_, new_track.getRect().getXyah());
-
-    updateRect();
-
-    state_ = STrackState::Tracked;
-    is_activated_ = true;
-    score_ = new_track.getScore();
-    frame_id_ = frame_id;
-    tracklet_len_++;
-}
-
-void byte_track::STrack::markAsLost()
-{
-    state_ = STrackState::Lost;
-}
-
-void byte_track::STrack::markAsRemoved()
-{
-    state_ = STrackState::Removed;
-}
-
-void byte_track::STrack::updateRect()
-{
-    rect_.width() = mean_[2] * mean_[3];
-    rect_.height() = mean_[3];
-    rect_.x() = mean_[0] - rect_.width() / 2;
-    rect_.y() = mean_[1] - rect_.height() / 2;
-    Object obj(rect_, label_, score_);
-    rect_history_.push_back(obj);
-    if(rect_history_.size() > (size_t)max_history_)
-    {
-        rect_history_.pop_front();
-    }
-}
+#include "ByteTrack/STrack.h"
+
+#include <cstddef>
+
+byte_track::STrackStore::STrackStore(const int &max_history) :
+    max_history_(max_history)
+{
+}
+
+int byte_track::STrackStore::alloc(const Rect<float> &rect, const float &score_, const int &label_)
+{
+    int idx;
+    if (!free_.empty())
+    {
+        idx = free_.back();
+        free_.pop_back();
+    }
+    else
+    {
+        idx = live_.size();
+        const size_t n = idx + 1;
+        for (int k = 0; k < STATE_DIM; k++)
+            mean[k].resize(n);
+        for (int k = 0; k < COV_SIZE; k++)
+            cov[k].resize(n);
+        x.resize(n);
+        y.resize(n);
+        w.resize(n);
+        h.resize(n);
+        score.resize(n);
+        label.resize(n);
+        state.resize(n);
+        activated.resize(n);
+        lost.resize(n);
+        track_id.resize(n);
+        frame_id.resize(n);
+        start_frame_id.resize(n);
+        tracklet_len.resize(n);
+        history.resize(n);
+        live_.resize(n);
+    }
+    for (int k = 0; k < STATE_DIM; k++)
+        mean[k][idx] = 0;
+    for (int k = 0; k < COV_SIZE; k++)
+        cov[k][idx] = 0;
+    x[idx] = rect.x();
+    y[idx] = rect.y();
+    w[idx] = rect.width();
+    h[idx] = rect.height();
+    score[idx] = score_;
+    label[idx] = label_;
+    state[idx] = STrackState::New;
+    activated[idx] = 0;
+    lost[idx] = 0;
+    track_id[idx] = 0;
+    frame_id[idx] = 0;
+    start_frame_id[idx] = 0;
+    tracklet_len[idx] = 0;
+    history[idx].clear();
+    live_[idx] = 1;
+    return idx;
+}
+
+void byte_track::STrackStore::release(const int &idx)
+{
+    if (!live_[idx])
+        return;
+    live_[idx] = 0;
+    state[idx] = STrackState::Removed;
+    activated[idx] = 0;
+    history[idx].clear();
+    free_.push_back(idx);
+}
+
+void byte_track::STrackStore::updateRect(const int &idx)
+{
+    w[idx] = mean[2][idx] * mean[3][idx];
+    h[idx] = mean[3][idx];
+    x[idx] = mean[0][idx] - w[idx] / 2;
+    y[idx] = mean[1][idx] - h[idx] / 2;
+    history[idx].emplace_back(Rect<float>(x[idx], y[idx], w[idx], h[idx]), label[idx], score[idx]);
+    if (history[idx].size() > (size_t)max_history_)
+    {
+        history[idx].pop_front();
+    }
+}
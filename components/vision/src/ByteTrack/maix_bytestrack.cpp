@@ -22,28 +22,79 @@ namespace maix::tracker
 
     std::vector<tracker::Track> ByteTracker::update(const std::vector<tracker::Object> &objs)
     {
+        MAIX_TRACE_SCOPE("tracker.update", "vision");
         byte_track::BYTETracker *bytetracker = (byte_track::BYTETracker*)_data;
         std::vector<tracker::Track> res;
         std::vector<byte_track::Object> objs2;
+        objs2.reserve(objs.size());
         for(const auto &obj : objs)
         {
             byte_track::Rect<float> rect(obj.x, obj.y, obj.w, obj.h);
-            objs2.push_back(byte_track::Object(rect, obj.class_id, obj.score));
+            objs2.emplace_back(rect, obj.class_id, obj.score);
         }
         const auto &res0 = bytetracker->update(objs2);
-        for (const auto &r : res0)
+        const byte_track::STrackStore &store = bytetracker->tracks();
+        res.reserve(res0.size());
+        for (const int &s : res0)
         {
-            res.push_back(tracker::Track(r->getTrackId(), r->getScore(), r->getLost(), r->getStartFrameId(), r->getFrameId()));
+            res.emplace_back(store.track_id[s], store.score[s], store.lost[s] != 0, store.start_frame_id[s], store.frame_id[s]);
             tracker::Track &track = res.back();
-            const std::deque<byte_track::Object> &history = r->get_rect_history();
-            for(const auto &i : history)
+            for(const auto &i : store.history[s])
             {
-                track.history.push_back(tracker::Object(i.rect.x(), i.rect.y(), i.rect.width(), i.rect.height(), i.label, i.prob));
+                track.history.emplace_back(i.rect.x(), i.rect.y(), i.rect.width(), i.rect.height(), i.label, i.prob);
             }
         }
         return res;
     }
-} // namespace maix::tracker
 
+    MultiByteTracker::MultiByteTracker(const int &stream_num,
+                const int &max_lost_buff_num,
+                const float &track_thresh,
+                const float &high_thresh,
+                const float &match_thresh,
+                const int &max_history,
+                const int &threads)
+    {
+        if (stream_num <= 0)
+            throw err::Exception(err::ERR_ARGS, "stream_num must > 0");
+        for (int i = 0; i < stream_num; ++i)
+            _trackers.push_back(new ByteTracker(max_lost_buff_num, track_thresh, high_thresh, match_thresh, max_history));
+        int num = threads;
+        if (num <= 0)
+            num = thread::cpu_count();
+        num = std::min(num, stream_num);
+        // caller thread also works in parallel_for
+        _pool = num > 1 ? new thread::Pool(num - 1, std::vector<int>(), 0, 0, "bytetrack") : nullptr;
+    }
+
+    MultiByteTracker::~MultiByteTracker()
+    {
+        delete _pool;
+        for (auto t : _trackers)
+            delete t;
+    }
 
+    std::vector<std::vector<tracker::Track>> MultiByteTracker::update(const std::vector<std::vector<tracker::Object>> &objs)
+    {
+        MAIX_TRACE_SCOPE("tracker.multi_update", "vision");
+        if (objs.size() != _trackers.size())
+            throw err::Exception(err::ERR_ARGS, "objs size must equal to stream_num");
+        std::vector<std::vector<tracker::Track>> res(objs.size());
+        auto task = [&](int start, int end) {
+            for (int i = start; i < end; ++i)
+                res[i] = _trackers[i]->update(objs[i]);
+        };
+        if (_pool)
+            _pool->parallel_for(0, objs.size(), task, 1);
+        else
+            task(0, objs.size());
+        return res;
+    }
 
+    std::vector<tracker::Track> MultiByteTracker::update_stream(const int &stream, const std::vector<tracker::Object> &objs)
+    {
+        if (stream < 0 || stream >= (int)_trackers.size())
+            throw err::Exception(err::ERR_ARGS, "stream index out of range");
+        return _trackers[stream]->update(objs);
+    }
+} // namespace maix::tracker
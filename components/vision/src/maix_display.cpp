@@ -11,6 +11,7 @@
 #include "maix_thread.hpp"
 #include "global_config.h"
 #include "maix_image_trans.hpp"
+#include "maix_trace.hpp"
 #ifdef PLATFORM_LINUX
     #include "maix_display_sdl.hpp"
     #include "maix_display_fb.hpp"
@@ -185,6 +186,7 @@ namespace maix::display
 
     err::Err Display::show(image::Image &img, image::Fit fit)
     {
+        MAIX_TRACE_SCOPE("display.show", "vision");
         err::Err e = err::ERR_NONE;
 
         if(img_trans)
@@ -3,6 +3,8 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Allocate image data from image::BufferPool.
+ * @update 2026.10.18: Increase generation in methods that modify image data.
  */
 
 #include "maix_image.hpp"
@@ -396,10 +398,11 @@ namespace maix::image
 
         if (!data)
         {
-            _actual_data = malloc(_data_size + 0x1000);
+            // page aligned, recycled by pool instead of malloc and page fault every frame
+            _actual_data = image::BufferPool::global().alloc(_data_size);
             if (!_actual_data)
                 throw err::Exception(err::ERR_NO_MEM, "malloc image data failed");
-            _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+            _data = _actual_data;
             // set background color
             if(bg.format == image::FMT_INVALID)
             {
@@ -451,7 +454,7 @@ namespace maix::image
             }
             else
             {
-                free(_actual_data);
+                image::BufferPool::global().free(_actual_data, _data_size);
                 _actual_data = NULL;
                 _data = NULL;
                 log::error("image bg format not support, format: %d\n", bg.format);
@@ -469,10 +472,10 @@ namespace maix::image
             }
             else
             {
-                _actual_data = malloc(_data_size + 0x1000);
+                _actual_data = image::BufferPool::global().alloc(_data_size);
                 if (!_actual_data)
                     throw std::bad_alloc();
-                _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+                _data = _actual_data;
                 memcpy(_data, data, _data_size);
                 // log::debug("malloc image data\n");
                 _is_malloc = true;
@@ -498,10 +501,11 @@ namespace maix::image
 
     Image::~Image()
     {
+        _free_views();
         if (_is_malloc)
         {
             // log::debug("free image data\n");
-            free(_actual_data);
+            image::BufferPool::global().free(_actual_data, _data_size);
             _actual_data = NULL;
             _data = NULL;
         }
@@ -509,10 +513,11 @@ namespace maix::image
 
     err::Err Image::update(int width, int height, image::Format format, uint8_t *data, int data_size, bool copy)
     {
+        mark_modified();
         if (_actual_data && _is_malloc)
         {
             // log::debug("free image data\n");
-            free(_actual_data);
+            image::BufferPool::global().free(_actual_data, _data_size);
             _actual_data = NULL;
             _data = NULL;
         }
@@ -522,12 +527,13 @@ namespace maix::image
 
     void Image::operator=(const image::Image &img)
     {
+        mark_modified();
         if (_data)
         {
             if (_is_malloc)
             {
                 log::info("free _actual_data");
-                free(_actual_data);
+                image::BufferPool::global().free(_actual_data, _data_size);
                 _actual_data = NULL;
                 _data = NULL;
             }
@@ -538,10 +544,10 @@ namespace maix::image
         _width = img._width;
         _height = img._height;
         _data_size = _width * _height * image::fmt_size[_format];
-        _actual_data = malloc(_data_size + 0x1000);
+        _actual_data = image::BufferPool::global().alloc(_data_size);
         if (!_actual_data)
             throw std::bad_alloc();
-        _data = (void *)(((uint64_t)_actual_data + 0x1000) & ~0xFFF);
+        _data = _actual_data;
         memcpy(_data, img._data, _data_size);
         _is_malloc = true;
         // log::debug("malloc image data\n");
@@ -1286,6 +1292,7 @@ __EXIT:
 
     image::Image *Image::draw_image(int x, int y, image::Image &img)
     {
+        mark_modified();
         image::Format fmt = img.format();
         if (!(fmt == image::FMT_GRAYSCALE || fmt == image::FMT_RGB888 || fmt == image::FMT_BGR888 ||
               fmt == image::FMT_RGBA8888 || fmt == image::FMT_BGRA8888))
@@ -1371,6 +1378,7 @@ __EXIT:
 
     image::Image *Image::draw_rect(int x, int y, int w, int h, const image::Color &color, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1389,6 +1397,7 @@ __EXIT:
 
     image::Image *Image::draw_line(int x1, int y1, int x2, int y2, const image::Color &color, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1399,6 +1408,7 @@ __EXIT:
 
     image::Image *Image::draw_circle(int x, int y, int radius, const image::Color &color, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1409,6 +1419,7 @@ __EXIT:
 
     image::Image *Image::draw_ellipse(int x, int y, int a, int b, float angle, float start_angle, float end_angle, const image::Color &color, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1420,6 +1431,7 @@ __EXIT:
     image::Image *image::Image::draw_string(int x, int y, const std::string &text, const image::Color &color, float scale, int thickness,
                                             bool wrap, int wrap_space, const std::string &font)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         add_default_fonts(fonts_info);
@@ -1538,6 +1550,7 @@ __EXIT:
 
     image::Image *Image::draw_cross(int x, int y, const image::Color &color, int size, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1549,6 +1562,7 @@ __EXIT:
 
     image::Image *Image::draw_arrow(int x0, int y0, int x1, int y1, const image::Color &color, int thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1561,6 +1575,7 @@ __EXIT:
 
     image::Image *Image::draw_edges(std::vector<std::vector<int>> corners, const image::Color &color, int size, int thickness, bool fill)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -1585,6 +1600,7 @@ __EXIT:
 
     image::Image *Image::draw_keypoints(const std::vector<int> &keypoints, const image::Color &color, int size, int thickness, int line_thickness)
     {
+        mark_modified();
         int ch_format = 0;
         cv::Scalar cv_color;
         _get_cv_format_color(_format, color, &ch_format, cv_color);
@@ -45,13 +45,7 @@ namespace maix::image
         }
 
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        convert_to_imlib_image(gray_view(), &src_img);
 
         // This code is used to fix imlib_find_apriltags crash bug, but this is a terrible fix
         if (roi_rect.x == 0 && roi_rect.y == 0 && roi_rect.w == src_img.w && roi_rect.h == src_img.h) {
@@ -118,10 +112,6 @@ namespace maix::image
             apriltags.push_back(apriltag);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return apriltags;
     }
 } // namespace maix::image
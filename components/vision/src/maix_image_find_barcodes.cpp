@@ -14,13 +14,7 @@ namespace maix::image
     std::vector<image::BarCode> Image::find_barcodes(std::vector<int> roi)
     {
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        convert_to_imlib_image(gray_view(), &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -59,10 +53,6 @@ namespace maix::image
             barcodes.push_back(barcode);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return barcodes;
     }
 } // namespace maix::image
@@ -14,13 +14,7 @@ namespace maix::image
     std::vector<image::DataMatrix> Image::find_datamatrices(std::vector<int> roi, int effort)
     {
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        convert_to_imlib_image(gray_view(), &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -72,10 +66,6 @@ namespace maix::image
             datamatrices.push_back(datamatrix);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return datamatrices;
     }
 } // namespace maix::image
@@ -13,6 +13,7 @@ namespace maix::image
 {
     image::Image* Image::find_edges(EdgeDetector edge_type, std::vector<int> roi, std::vector<int> threshold)
     {
+        mark_modified();
         image_t src_img;
         Image *gray_img = NULL;
         if (_format == image::FMT_GRAYSCALE) {
@@ -13,6 +13,7 @@ namespace maix::image
 {
     image::Image* Image::find_hog(std::vector<int> roi, int size)
     {
+        mark_modified();
         image_t src_img;
         Image *gray_img = NULL;
         if (_format == image::FMT_GRAYSCALE) {
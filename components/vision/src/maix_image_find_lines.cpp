@@ -54,13 +54,7 @@ namespace maix::image
     std::vector<image::Line> Image::find_line_segments(std::vector<int> roi, int merge_distance, int max_theta_difference)
     {
         image_t src_img;
-        Image *gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(gray_img, &src_img);
-        }
+        convert_to_imlib_image(gray_view(), &src_img);
 
         rectangle_t roi_rect;
         std::vector<int> avail_roi = _get_available_roi(roi);
@@ -86,10 +80,6 @@ namespace maix::image
             lines.push_back(line);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete gray_img;
-        }
-
         return lines;
     }
 } // namespace maix::image
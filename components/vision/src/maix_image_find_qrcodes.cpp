@@ -105,19 +105,7 @@ namespace maix::image
             case QRCodeDecoderType::QRCODE_DECODER_TYPE_QUIRC:
             {
                 image_t src_img;
-                Image *gray_img = NULL;
-
-                if (_format == image::FMT_GRAYSCALE) {
-                    convert_to_imlib_image(this, &src_img);
-                } else {
-                    if (image::FMT_YVU420SP == _format) {
-                        gray_img = new image::Image(_width, _height, image::FMT_GRAYSCALE);
-                        memcpy(gray_img->data(), _data, _width * _height);
-                    } else {
-                        gray_img = this->to_format(image::FMT_GRAYSCALE);
-                    }
-                    convert_to_imlib_image(gray_img, &src_img);
-                }
+                convert_to_imlib_image(gray_view(), &src_img);
 
                 rectangle_t roi_rect;
                 std::vector<int> avail_roi = _get_available_roi(roi);
@@ -167,28 +155,12 @@ namespace maix::image
                     qrcodes.push_back(qrcode);
                 }
 
-                if (_format != image::FMT_GRAYSCALE) {
-                    delete gray_img;
-                }
-
                 break;
             }
             case QRCodeDecoderType::QRCODE_DECODER_TYPE_ZBAR:
             {
-                bool need_delete_gray_img = false;
                 bool need_delete_new_img = false;
-                Image *gray_img = NULL;
-                if (_format == image::FMT_GRAYSCALE) {
-                    gray_img = this;
-                } else {
-                    if (image::FMT_YVU420SP == _format) {
-                        gray_img = new image::Image(_width, _height, image::FMT_GRAYSCALE);
-                        memcpy(gray_img->data(), _data, _width * _height);
-                    } else {
-                        gray_img = this->to_format(image::FMT_GRAYSCALE);
-                    }
-                    need_delete_gray_img = true;
-                }
+                Image *gray_img = gray_view();
                 image::Image *new_img = NULL;
                 if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height()) {
                     new_img = gray_img->crop(avail_roi[0], avail_roi[1], avail_roi[2], avail_roi[3]);
@@ -229,10 +201,6 @@ namespace maix::image
                                         0);
                     qrcodes.push_back(qrcode);
                 }
-                if (need_delete_gray_img) {
-                    delete gray_img;
-                }
-
                 if (need_delete_new_img) {
                     delete new_img;
                 }
@@ -241,20 +209,8 @@ namespace maix::image
             case QRCodeDecoderType::QRCODE_DECODER_TYPE_ZXING:
             {
                 // ZXing QR code detection using ZXing-C++ 2.3.0
-                bool need_delete_gray_img = false;
                 bool need_delete_new_img = false;
-                Image *gray_img = NULL;
-                if (_format == image::FMT_GRAYSCALE) {
-                    gray_img = this;
-                } else {
-                    if (image::FMT_YVU420SP == _format) {
-                        gray_img = new image::Image(_width, _height, image::FMT_GRAYSCALE);
-                        memcpy(gray_img->data(), _data, _width * _height);
-                    } else {
-                        gray_img = this->to_format(image::FMT_GRAYSCALE);
-                    }
-                    need_delete_gray_img = true;
-                }
+                Image *gray_img = gray_view();
                 image::Image *new_img = NULL;
                 if (avail_roi[0] != 0 || avail_roi[1] != 0 || avail_roi[2] != gray_img->width() || avail_roi[3] != gray_img->height()) {
                     new_img = gray_img->crop(avail_roi[0], avail_roi[1], avail_roi[2], avail_roi[3]);
@@ -294,9 +250,6 @@ namespace maix::image
                                         0);
                     qrcodes.push_back(qrcode);
                 }
-                if (need_delete_gray_img) {
-                    delete gray_img;
-                }
                 if (need_delete_new_img) {
                     delete new_img;
                 }
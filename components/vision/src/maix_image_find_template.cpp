@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Use cached gray and integral views of image.
  */
 
 #include "maix_image.hpp"
@@ -14,13 +15,8 @@ namespace maix::image
     std::vector<int> Image::find_template(image::Image &template_image, float threshold, std::vector<int> roi, int step, TemplateMatch search)
     {
         image_t src_img, template_img;
-        Image *src_gray_img = NULL, *template_gray_img = NULL;
-        if (_format == image::FMT_GRAYSCALE) {
-            convert_to_imlib_image(this, &src_img);
-        } else {
-            src_gray_img = to_format(image::FMT_GRAYSCALE);
-            convert_to_imlib_image(src_gray_img, &src_img);
-        }
+        Image *template_gray_img = NULL;
+        convert_to_imlib_image(gray_view(), &src_img);
 
         if (template_image.format() == image::FMT_GRAYSCALE) {
             convert_to_imlib_image(&template_image, &template_img);
@@ -46,17 +42,21 @@ namespace maix::image
             throw std::runtime_error("ROI must be smaller than or equal to image size");
         }
 
+        // integral images are cached by image, reused by following find_template calls on the same frame
         rectangle_t r;
         float corr;
+        i_image_t sum = {src_img.w, src_img.h, (uint32_t *)integral_view(false)};
+        if (!sum.data)
+            throw std::bad_alloc();
         if (search == SEARCH_DS) {
-            corr = imlib_template_match_ds(&src_img, &template_img, &r);
+            corr = imlib_template_match_ds_ii(&src_img, &template_img, &r, &sum);
         } else {
-            corr = imlib_template_match_ex(&src_img, &template_img, &roi_rect, step, &r);
+            i_image_t sumsq = {src_img.w, src_img.h, (uint32_t *)integral_view(true)};
+            if (!sumsq.data)
+                throw std::bad_alloc();
+            corr = imlib_template_match_ex_ii(&src_img, &template_img, &roi_rect, step, &r, &sum, &sumsq);
         }
 
-        if (_format != image::FMT_GRAYSCALE) {
-            delete src_gray_img;
-        }
         if (template_image.format() != image::FMT_GRAYSCALE) {
             delete template_gray_img;
         }
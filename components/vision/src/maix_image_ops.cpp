@@ -55,6 +55,8 @@ namespace maix::image {
             }
             out_img.pixels = buffer;
         } else {
+            // pooled in place, only then cached views of this image are invalid
+            mark_modified();
             out_img.pixels = src_img.pixels;
         }
 
@@ -87,6 +89,7 @@ namespace maix::image {
         if (copy) {
             dst = new image::Image(_dst_width, _dst_height, _format);
         } else {
+            mark_modified();
             dst = this;
         }
 
@@ -167,6 +170,7 @@ namespace maix::image {
     }
 
     image::Image *Image::clear(image::Image *mask) {
+        mark_modified();
         if (!mask) {
             memset(_data, 0, _data_size);
         } else {
@@ -177,6 +181,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mask_rectange(int x, int y, int w, int h) {
+        mark_modified();
         int use_default_setting = 0;
         if (x < 0 || y < 0 || w < 0 || h < 0) {
             use_default_setting = 1;
@@ -194,6 +199,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mask_circle(int x, int y, int radius) {
+        mark_modified();
         int use_default_setting = 0;
         if (x < 0 || y < 0 || radius < 0) {
             use_default_setting = 1;
@@ -210,6 +216,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mask_ellipse(int x, int y, int radius_x, int radius_y, float rotation_angle_in_degrees) {
+        mark_modified();
         int use_default_setting = 0;
         if (x < 0 || y < 0 || radius_x < 0 || radius_y < 0) {
             use_default_setting = 1;
@@ -240,6 +247,7 @@ namespace maix::image {
         if (copy) {
             dst = new image::Image(_width, _height, _format);
         } else {
+            mark_modified();
             dst = this;
         }
 
@@ -256,6 +264,7 @@ namespace maix::image {
     }
 
     image::Image *Image::invert() {
+        mark_modified();
         int remain_len = _data_size % 4;
         int u32_len = (_data_size - remain_len) >> 2;
         uint8_t *remain_data = (uint8_t *)((uint8_t *)_data + (u32_len << 2));
@@ -272,6 +281,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_and(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -304,6 +314,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_nand(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -336,6 +347,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_or(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -369,6 +381,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_nor(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -402,6 +415,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_xor(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -434,6 +448,7 @@ namespace maix::image {
     }
 
     image::Image *Image::b_xnor(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
 
         err::check_bool_raise(other != NULL && other->data() != NULL, "Other image is null");
@@ -466,6 +481,7 @@ namespace maix::image {
     }
 
     image::Image *Image::awb(bool max) {
+        mark_modified();
         image_t src_img;
         Image *rgb565_img = nullptr;
         if (_format == image::FMT_RGB888 || _format == image::FMT_BGR888) {
@@ -488,6 +504,7 @@ namespace maix::image {
     }
 
     image::Image *Image::ccm(std::vector<float> &matrix) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -508,6 +525,7 @@ namespace maix::image {
     }
 
     image::Image *Image::gamma(double gamma, double contrast, double brightness) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -516,10 +534,12 @@ namespace maix::image {
     }
 
     image::Image *Image::gamma_corr(double gamma, double contrast, double brightness) {
+        mark_modified();
         return this->gamma(gamma, contrast, brightness);
     }
 
     image::Image *Image::negate(void) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_negate(&src_img);
@@ -527,6 +547,7 @@ namespace maix::image {
     }
 
     image::Image *Image::replace(image::Image *other, bool hmirror, bool vflip, bool transpose, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -557,10 +578,12 @@ namespace maix::image {
     }
 
     image::Image *Image::set(image::Image *other, bool hmirror, bool vflip, bool transpose, image::Image *mask) {
+        mark_modified();
         return this->replace(other, hmirror, vflip, transpose, mask);
     }
 
     image::Image *Image::add(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -575,6 +598,7 @@ namespace maix::image {
     }
 
     image::Image *Image::sub(image::Image *other, bool reverse, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -589,6 +613,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mul(image::Image *other, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -603,6 +628,7 @@ namespace maix::image {
     }
 
     image::Image *Image::div(image::Image *other, bool invert, bool mod, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -617,6 +643,7 @@ namespace maix::image {
     }
 
     image::Image *Image::min(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -631,6 +658,7 @@ namespace maix::image {
     }
 
     image::Image *Image::max(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -645,6 +673,7 @@ namespace maix::image {
     }
 
     image::Image *Image::difference(image::Image *other, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -659,6 +688,7 @@ namespace maix::image {
     }
 
     image::Image *Image::blend(image::Image *other, int alpha, image::Image *mask) {
+        mark_modified();
         image_t src_img, other_img, mask_img;
         convert_to_imlib_image(this, &src_img);
         convert_to_imlib_image(other, &other_img);
@@ -679,6 +709,7 @@ namespace maix::image {
     }
 
     image::Image *Image::histeq(bool adaptive, int clip_limit, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -702,6 +733,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mean(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -715,6 +747,7 @@ namespace maix::image {
     }
 
     image::Image *Image::median(int size, double percentile, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -729,6 +762,7 @@ namespace maix::image {
     }
 
     image::Image *Image::mode(int size, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -742,6 +776,7 @@ namespace maix::image {
     }
 
     image::Image *Image::midpoint(int size, double bias, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -755,6 +790,7 @@ namespace maix::image {
     }
 
     image::Image *Image::morph(int size, std::vector<int> kernel, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -785,6 +821,7 @@ namespace maix::image {
     }
 
     image::Image *Image::gaussian(int size, bool unsharp, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -829,6 +866,7 @@ namespace maix::image {
     }
 
     image::Image *Image::laplacian(int size, bool sharpen, float mul, float add, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         std::vector<int> pascal;
         std::vector<int> kernel;
         int m = 0;
@@ -874,6 +912,7 @@ namespace maix::image {
     }
 
     image::Image *Image::bilateral(int size, double color_sigma, double space_sigma, bool threshold, int offset, bool invert, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -887,6 +926,7 @@ namespace maix::image {
     }
 
     image::Image *Image::linpolar(bool reverse) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, true, reverse);
@@ -894,6 +934,7 @@ namespace maix::image {
     }
 
     image::Image *Image::logpolar(bool reverse) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_logpolar(&src_img, false, reverse);
@@ -901,6 +942,7 @@ namespace maix::image {
     }
 
     image::Image *Image::lens_corr(double strength, double zoom, double x_corr, double y_corr) {
+        mark_modified();
         if (_width % 2 || _height % 2) {
             log::error("lens_corr image size must be even");
             return this;
@@ -913,6 +955,7 @@ namespace maix::image {
     }
 
     image::Image *Image::rotation_corr(double x_rotation, double y_rotation, double z_rotation, double x_translation, double y_translation, double zoom, double fov, std::vector<float> corners) {
+        mark_modified();
         image_t src_img;
         convert_to_imlib_image(this, &src_img);
         imlib_rotation_corr(&src_img, x_rotation, y_rotation, z_rotation, x_translation, y_translation, zoom, fov, (float *)corners.data());
@@ -1187,6 +1230,7 @@ namespace maix::image {
     }
 
     image::Image *Image::flood_fill(int x, int y, float seed_threshold, float floating_threshold, image::Color color , bool invert, bool clear_background, image::Image *mask) {
+        mark_modified();
         image_t src_img, mask_img;
         convert_to_imlib_image(this, &src_img);
 
@@ -1200,6 +1244,7 @@ namespace maix::image {
     }
 
     image::Image *Image::erode(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "erode size must be greater than 0");
         err::check_bool_raise(threshold == -1 || threshold >= 0, "erode threshold must be greater than or equal to 0");
 
@@ -1220,6 +1265,7 @@ namespace maix::image {
     }
 
     image::Image *Image::dilate(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "dilate size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "dilate threshold must be greater than or equal to 0");
 
@@ -1236,6 +1282,7 @@ namespace maix::image {
     }
 
     image::Image *Image::open(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "open size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "open threshold must be greater than or equal to 0");
 
@@ -1252,6 +1299,7 @@ namespace maix::image {
     }
 
     image::Image *Image::close(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "close size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "close threshold must be greater than or equal to 0");
 
@@ -1268,6 +1316,7 @@ namespace maix::image {
     }
 
     image::Image *Image::top_hat(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "top_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "top_hat threshold must be greater than or equal to 0");
 
@@ -1284,6 +1333,7 @@ namespace maix::image {
     }
 
     image::Image *Image::black_hat(int size, int threshold, image::Image *mask) {
+        mark_modified();
         err::check_bool_raise(size > 0, "black_hat size must be greater than 0");
         err::check_bool_raise(threshold >= 0, "black_hat threshold must be greater than or equal to 0");
 
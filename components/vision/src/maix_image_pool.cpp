@@ -0,0 +1,486 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add image buffer pool, create this file.
+ */
+
+#include "maix_image_pool.hpp"
+#include "maix_log.hpp"
+#include "global_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <stdio.h>
+#include <sys/mman.h>
+
+#ifndef CONFIG_VISION_IMAGE_POOL_MAX_CACHE_MB
+#define CONFIG_VISION_IMAGE_POOL_MAX_CACHE_MB 32
+#endif
+
+#define PAGE_SHIFT_BITS 12
+#define EXACT_CLASSES 16       // classes of 1 ~ 16 pages
+#define OCTAVE_CLASSES 4       // classes per power of 2 after exact classes
+#define CLASS_NUM (EXACT_CLASSES + OCTAVE_CLASSES * 28)
+#define THREAD_CACHE_NUM 4
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+namespace maix::image
+{
+    // size class index and class size in pages
+    static int _size_class(size_t size, size_t *class_pages)
+    {
+        size_t pages = (size + (1 << PAGE_SHIFT_BITS) - 1) >> PAGE_SHIFT_BITS;
+        if (pages == 0)
+            pages = 1;
+        if (pages <= EXACT_CLASSES)
+        {
+            *class_pages = pages;
+            return (int)pages - 1;
+        }
+        int k = 63 - __builtin_clzll(pages);
+        size_t step = (size_t)1 << (k - 2);
+        size_t q = (pages - ((size_t)1 << k) + step - 1) / step;
+        if (q == 0)
+        {
+            // exact power of 2 is the last class of previous octave
+            k -= 1;
+            q = OCTAVE_CLASSES;
+            step >>= 1;
+        }
+        *class_pages = ((size_t)1 << k) + q * step;
+        int idx = EXACT_CLASSES + (k - 4) * OCTAVE_CLASSES + (int)q - 1;
+        return idx < CLASS_NUM ? idx : -1;
+    }
+
+    struct ThreadCache;
+
+    class PoolImpl
+    {
+    public:
+        PoolImpl(size_t max_cached, int flags)
+            : max_cached(max_cached), flags(flags)
+        {
+        }
+
+        void *map(size_t bytes, bool populate)
+        {
+            int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+            if (populate || (flags & POOL_POPULATE))
+                map_flags |= MAP_POPULATE;
+            void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+#ifdef MADV_HUGEPAGE
+            if ((flags & POOL_HUGEPAGE) && bytes >= HUGEPAGE_SIZE)
+                madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+            return p;
+        }
+
+        void unmap(void *p, size_t bytes)
+        {
+            munmap(p, bytes);
+            release_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // pop from shared cache, nullptr if empty
+        void *pop(int idx, size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<void *> &list = lists[idx];
+            if (list.empty())
+                return nullptr;
+            void *p = list.back();
+            list.pop_back();
+            cached_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            return p;
+        }
+
+        // cached bytes of shared cache and all thread caches over limit after adding bytes
+        bool over_limit(size_t bytes)
+        {
+            return cached_bytes.load(std::memory_order_relaxed) + bytes > max_cached.load(std::memory_order_relaxed);
+        }
+
+        // release other classes first until bytes fit, caller holds mutex, return false if still not fit
+        bool make_room(size_t bytes, int keep_idx)
+        {
+            for (int i = CLASS_NUM - 1; i >= 0 && over_limit(bytes); --i)
+            {
+                if (i == keep_idx)
+                    continue;
+                size_t class_bytes = class_size[i];
+                while (!lists[i].empty() && over_limit(bytes))
+                {
+                    unmap(lists[i].back(), class_bytes);
+                    lists[i].pop_back();
+                    cached_bytes.fetch_sub(class_bytes, std::memory_order_relaxed);
+                }
+            }
+            return !over_limit(bytes);
+        }
+
+        void push(int idx, void *p, size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (bytes <= max_cached && make_room(bytes, idx))
+                {
+                    // capacity reserved at first use of class, no allocation in steady state
+                    lists[idx].push_back(p);
+                    cached_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            unmap(p, bytes);
+        }
+
+        void trim_shared()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < CLASS_NUM; ++i)
+            {
+                for (void *p : lists[i])
+                {
+                    unmap(p, class_size[i]);
+                    cached_bytes.fetch_sub(class_size[i], std::memory_order_relaxed);
+                }
+                lists[i].clear();
+            }
+        }
+
+        void add_in_use(int64_t bytes)
+        {
+            uint64_t now = in_use_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            if (bytes > 0)
+            {
+                uint64_t peak = peak_in_use_bytes.load(std::memory_order_relaxed);
+                while (now > peak && !peak_in_use_bytes.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+                    ;
+            }
+        }
+
+        std::mutex mutex;
+        std::mutex caches_mutex;               // lock before ThreadCache::mutex and mutex
+        std::vector<ThreadCache *> caches;     // thread caches of this pool, trim() flushes them all
+        std::vector<void *> lists[CLASS_NUM];
+        size_t class_size[CLASS_NUM] = {0}; // bytes of class, set at first use
+        std::atomic<size_t> max_cached;
+        std::atomic<int> flags;
+
+        std::atomic<uint64_t> alloc_count{0};
+        std::atomic<uint64_t> thread_hit{0};
+        std::atomic<uint64_t> global_hit{0};
+        std::atomic<uint64_t> miss{0};
+        std::atomic<uint64_t> release_count{0};
+        std::atomic<uint64_t> in_use_bytes{0};
+        std::atomic<uint64_t> peak_in_use_bytes{0};
+        std::atomic<uint64_t> cached_bytes{0};
+    };
+
+    // only for global pool, global pool is never destroyed so thread exit can always give buffers back.
+    // mutex is only contended by trim() of other threads, bytes are counted in pool's cached_bytes and limited by max_cached.
+    struct ThreadCache
+    {
+        struct Entry
+        {
+            void *ptr;
+            int idx;
+            size_t bytes;
+        };
+        std::mutex mutex;
+        Entry entries[THREAD_CACHE_NUM];
+        int num = 0;
+        size_t bytes = 0;
+        PoolImpl *pool = nullptr;
+
+        void bind(PoolImpl *impl)
+        {
+            std::lock_guard<std::mutex> lock(impl->caches_mutex);
+            pool = impl;
+            impl->caches.push_back(this);
+        }
+
+        void *pop(int idx)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = num - 1; i >= 0; --i)
+            {
+                if (entries[i].idx == idx)
+                {
+                    void *p = entries[i].ptr;
+                    bytes -= entries[i].bytes;
+                    pool->cached_bytes.fetch_sub(entries[i].bytes, std::memory_order_relaxed);
+                    entries[i] = entries[--num];
+                    return p;
+                }
+            }
+            return nullptr;
+        }
+
+        bool push(int idx, void *p, size_t size)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t limit = pool->max_cached.load(std::memory_order_relaxed);
+            if (num >= THREAD_CACHE_NUM || bytes + size > limit / 4)
+                return false;
+            // reserve bytes in pool's limit, or let shared cache decide which buffer to release
+            size_t cached = pool->cached_bytes.load(std::memory_order_relaxed);
+            do
+            {
+                if (cached + size > limit)
+                    return false;
+            } while (!pool->cached_bytes.compare_exchange_weak(cached, cached + size, std::memory_order_relaxed));
+            entries[num++] = {p, idx, size};
+            bytes += size;
+            return true;
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (num > 0)
+            {
+                Entry e = entries[--num];
+                bytes -= e.bytes;
+                pool->cached_bytes.fetch_sub(e.bytes, std::memory_order_relaxed);
+                pool->push(e.idx, e.ptr, e.bytes);
+            }
+        }
+
+        ~ThreadCache()
+        {
+            if (!pool)
+                return;
+            std::lock_guard<std::mutex> lock(pool->caches_mutex);
+            pool->caches.erase(std::find(pool->caches.begin(), pool->caches.end(), this));
+            flush();
+        }
+    };
+
+    static thread_local ThreadCache tl_cache;
+    static std::atomic<PoolImpl *> _global_impl{nullptr}; // thread caches only serve global pool
+
+    // flush thread caches of all threads to shared cache
+    static void _flush_thread_caches(PoolImpl *impl)
+    {
+        std::lock_guard<std::mutex> lock(impl->caches_mutex);
+        for (ThreadCache *cache : impl->caches)
+            cache->flush();
+    }
+
+    BufferPool::BufferPool(size_t max_cached, int flags)
+    {
+        _impl = new PoolImpl(max_cached, flags);
+    }
+
+    BufferPool &BufferPool::global()
+    {
+        int flags = POOL_NONE;
+#ifdef CONFIG_VISION_IMAGE_POOL_POPULATE
+        flags |= POOL_POPULATE;
+#endif
+#ifdef CONFIG_VISION_IMAGE_POOL_HUGEPAGE
+        flags |= POOL_HUGEPAGE;
+#endif
+        // leaked on purpose, images destroyed at program exit still free to it
+        static BufferPool *pool = [flags]() {
+            BufferPool *p = new BufferPool((size_t)CONFIG_VISION_IMAGE_POOL_MAX_CACHE_MB * 1024 * 1024, flags);
+            _global_impl.store((PoolImpl *)p->_impl, std::memory_order_relaxed);
+            return p;
+        }();
+        return *pool;
+    }
+
+    void *BufferPool::alloc(size_t size)
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        size_t pages;
+        int idx = _size_class(size, &pages);
+        size_t bytes = pages << PAGE_SHIFT_BITS;
+        impl->alloc_count.fetch_add(1, std::memory_order_relaxed);
+        if (idx < 0)
+        {
+            impl->miss.fetch_add(1, std::memory_order_relaxed);
+            void *p = impl->map(bytes, false);
+            if (p)
+                impl->add_in_use(bytes);
+            return p;
+        }
+        if (impl == _global_impl.load(std::memory_order_relaxed) && tl_cache.pool)
+        {
+            void *p = tl_cache.pop(idx);
+            if (p)
+            {
+                impl->thread_hit.fetch_add(1, std::memory_order_relaxed);
+                impl->add_in_use(bytes);
+                return p;
+            }
+        }
+        void *p = impl->pop(idx, bytes);
+        if (p)
+        {
+            impl->global_hit.fetch_add(1, std::memory_order_relaxed);
+            impl->add_in_use(bytes);
+            return p;
+        }
+        impl->miss.fetch_add(1, std::memory_order_relaxed);
+        p = impl->map(bytes, false);
+        if (!p)
+        {
+            // cached buffers of other sizes may be what we need
+            trim();
+            p = impl->map(bytes, false);
+            if (!p)
+                return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(impl->mutex);
+            if (impl->class_size[idx] == 0)
+            {
+                impl->class_size[idx] = bytes;
+                impl->lists[idx].reserve(8);
+            }
+        }
+        impl->add_in_use(bytes);
+        return p;
+    }
+
+    void BufferPool::free(void *ptr, size_t size)
+    {
+        if (!ptr)
+            return;
+        PoolImpl *impl = (PoolImpl *)_impl;
+        size_t pages;
+        int idx = _size_class(size, &pages);
+        size_t bytes = pages << PAGE_SHIFT_BITS;
+        impl->add_in_use(-(int64_t)bytes);
+        if (idx < 0)
+        {
+            impl->unmap(ptr, bytes);
+            return;
+        }
+        if (impl == _global_impl.load(std::memory_order_relaxed))
+        {
+            if (!tl_cache.pool)
+                tl_cache.bind(impl);
+            if (tl_cache.push(idx, ptr, bytes))
+                return;
+        }
+        impl->push(idx, ptr, bytes);
+    }
+
+    err::Err BufferPool::prewarm(size_t size, int count)
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        size_t pages;
+        int idx = _size_class(size, &pages);
+        size_t bytes = pages << PAGE_SHIFT_BITS;
+        if (idx < 0 || count < 0)
+            return err::ERR_ARGS;
+        {
+            std::lock_guard<std::mutex> lock(impl->mutex);
+            if (impl->class_size[idx] == 0)
+                impl->class_size[idx] = bytes;
+            int have = impl->lists[idx].size();
+            if (have >= count)
+                return err::ERR_NONE;
+            size_t need = impl->cached_bytes.load(std::memory_order_relaxed) + (count - have) * bytes;
+            if (need > impl->max_cached)
+            {
+                log::info("image buffer pool max cached grows to %zu bytes for prewarm\n", need);
+                impl->max_cached.store(need, std::memory_order_relaxed);
+            }
+            count -= have;
+            impl->lists[idx].reserve(impl->lists[idx].size() + count + 8);
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            void *p = impl->map(bytes, true);
+            if (!p)
+            {
+                log::error("image buffer pool prewarm %zu bytes failed\n", bytes);
+                return err::ERR_NO_MEM;
+            }
+            impl->push(idx, p, bytes);
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err BufferPool::prewarm(int width, int height, image::Format format, int count)
+    {
+        if (width <= 0 || height <= 0 || format >= image::FMT_COMPRESSED_MIN)
+            return err::ERR_ARGS;
+        return prewarm((size_t)width * height * image::fmt_size[format], count);
+    }
+
+    void BufferPool::set_max_cached(size_t bytes)
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        std::unique_lock<std::mutex> lock(impl->mutex);
+        impl->max_cached = bytes;
+        if (impl->make_room(0, -1))
+            return;
+        // thread caches hold the rest, give them back to shared cache which releases buffers over limit
+        lock.unlock();
+        _flush_thread_caches(impl);
+    }
+
+    void BufferPool::set_flags(int flags)
+    {
+        ((PoolImpl *)_impl)->flags = flags;
+    }
+
+    void BufferPool::trim()
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        _flush_thread_caches(impl);
+        impl->trim_shared();
+    }
+
+    image::PoolStats BufferPool::stats()
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        image::PoolStats s;
+        s.alloc_count = impl->alloc_count.load(std::memory_order_relaxed);
+        s.thread_hit = impl->thread_hit.load(std::memory_order_relaxed);
+        s.global_hit = impl->global_hit.load(std::memory_order_relaxed);
+        s.miss = impl->miss.load(std::memory_order_relaxed);
+        s.release_count = impl->release_count.load(std::memory_order_relaxed);
+        s.in_use_bytes = impl->in_use_bytes.load(std::memory_order_relaxed);
+        s.peak_in_use_bytes = impl->peak_in_use_bytes.load(std::memory_order_relaxed);
+        s.cached_bytes = impl->cached_bytes.load(std::memory_order_relaxed);
+        s.max_cached_bytes = impl->max_cached.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    std::string BufferPool::stats_str()
+    {
+        image::PoolStats s = stats();
+        char buf[256];
+        uint64_t hit = s.thread_hit + s.global_hit;
+        snprintf(buf, sizeof(buf), "alloc: %llu, hit: %.1f%% (thread %llu, shared %llu), miss: %llu, released: %llu, "
+                                   "in use: %.1f MiB (peak %.1f MiB), cached: %.1f / %.1f MiB",
+                 (unsigned long long)s.alloc_count, s.alloc_count ? hit * 100.0 / s.alloc_count : 0.0,
+                 (unsigned long long)s.thread_hit, (unsigned long long)s.global_hit,
+                 (unsigned long long)s.miss, (unsigned long long)s.release_count,
+                 s.in_use_bytes / 1048576.0, s.peak_in_use_bytes / 1048576.0,
+                 s.cached_bytes / 1048576.0, s.max_cached_bytes / 1048576.0);
+        return std::string(buf);
+    }
+
+    void BufferPool::reset_stats()
+    {
+        PoolImpl *impl = (PoolImpl *)_impl;
+        impl->alloc_count = 0;
+        impl->thread_hit = 0;
+        impl->global_hit = 0;
+        impl->miss = 0;
+        impl->release_count = 0;
+        impl->peak_in_use_bytes = impl->in_use_bytes.load(std::memory_order_relaxed);
+    }
+} // namespace maix::image
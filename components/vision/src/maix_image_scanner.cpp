@@ -0,0 +1,437 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add stateful QR code and barcode scanners with ROI tracking, create this file.
+ */
+
+#include "maix_image_scanner.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+namespace maix::image
+{
+    static const int MOTION_THUMB_WIDTH = 160; // detect motion on pyramid level not wider than this
+    static const int MOTION_PIXEL_DIFF = 24;   // pixel is changed if abs diff larger than this
+    static const int ROI_MIN_MARGIN = 16;      // min margin around predicted code position
+
+    static image::QRCode _scale_code(image::QRCode &c, float sx, float sy)
+    {
+        std::vector<int> rect = c.rect();
+        std::vector<std::vector<int>> corners = c.corners();
+        std::string payload = c.payload();
+        rect = {(int)(rect[0] * sx), (int)(rect[1] * sy), (int)(rect[2] * sx), (int)(rect[3] * sy)};
+        for (auto &p : corners)
+        {
+            p[0] = (int)(p[0] * sx);
+            p[1] = (int)(p[1] * sy);
+        }
+        return image::QRCode(rect, corners, payload, c.version(), c.ecc_level(), c.mask(), c.data_type(), c.eci());
+    }
+
+    static image::BarCode _scale_code(image::BarCode &c, float sx, float sy)
+    {
+        std::vector<int> rect = c.rect();
+        std::vector<std::vector<int>> corners = c.corners();
+        std::string payload = c.payload();
+        rect = {(int)(rect[0] * sx), (int)(rect[1] * sy), (int)(rect[2] * sx), (int)(rect[3] * sy)};
+        for (auto &p : corners)
+        {
+            p[0] = (int)(p[0] * sx);
+            p[1] = (int)(p[1] * sy);
+        }
+        return image::BarCode(rect, corners, payload, c.type(), c.rotation(), c.quality());
+    }
+
+    template <typename Code>
+    struct ScanTrack
+    {
+        Code code;
+        float vx = 0;             // velocity of center, pixels per frame
+        float vy = 0;
+        uint64_t last_frame = 0;  // frame number code decoded last time
+        int lost = 0;             // continuous frames decode failed
+        bool still = false;       // no change in code area since last frame
+        bool updated = false;     // code found in current frame
+
+        ScanTrack(const Code &code) : code(code) {}
+    };
+
+    template <typename Code>
+    class Scanner
+    {
+    public:
+        using DecodeFunc = std::function<std::vector<Code>(image::Image &, std::vector<int>)>;
+
+        Scanner(DecodeFunc decode, int detect_interval, int detect_level, float motion_threshold, int max_lost)
+            : _decode(decode), _detect_interval(std::max(detect_interval, 1)), _detect_level(std::max(detect_level, 0)),
+              _motion_threshold(motion_threshold), _max_lost(std::max(max_lost, 0))
+        {
+        }
+
+        void reset()
+        {
+            _tracks.clear();
+            _thumb.clear();
+            _frame = 0;
+            _last_full = 0;
+            _full_searches = 0;
+        }
+
+        int tracked() { return (int)_tracks.size(); }
+
+        uint64_t full_searches() { return _full_searches; }
+
+        std::vector<Code> scan(image::Image &img)
+        {
+            if (img.width() != _width || img.height() != _height)
+            {
+                reset();
+                _width = img.width();
+                _height = img.height();
+            }
+            ++_frame;
+            // build gray view once before decoding, all decoders of this frame share it
+            if (!img.gray_view())
+                throw err::Exception(err::ERR_ARGS, "scanner not support image format " + image::fmt_names[img.format()]);
+            for (auto &t : _tracks)
+                t.updated = false;
+
+            bool motion = _check_motion(img);
+            if (_full_searches == 0 || _frame - _last_full >= (uint64_t)_detect_interval || motion)
+                _full_search(img);
+            _decode_rois(img);
+
+            std::vector<Code> codes;
+            for (auto it = _tracks.begin(); it != _tracks.end();)
+            {
+                if (it->updated)
+                {
+                    codes.push_back(it->code);
+                    ++it;
+                }
+                else if (++it->lost > _max_lost)
+                    it = _tracks.erase(it);
+                else
+                    ++it;
+            }
+            return codes;
+        }
+
+    private:
+        DecodeFunc _decode;
+        int _detect_interval;
+        int _detect_level;
+        float _motion_threshold;
+        int _max_lost;
+        int _width = 0;
+        int _height = 0;
+        uint64_t _frame = 0;
+        uint64_t _last_full = 0;
+        uint64_t _full_searches = 0;
+        std::vector<ScanTrack<Code>> _tracks;
+        std::vector<uint8_t> _thumb; // small gray image of last frame for motion detect
+        int _thumb_w = 0;
+        int _thumb_h = 0;
+
+        // compare with last frame on a small pyramid level, mark still tracks,
+        // return true if changed pixels outside tracked codes over threshold.
+        bool _check_motion(image::Image &img)
+        {
+            int level = 0;
+            while ((img.width() >> level) > MOTION_THUMB_WIDTH)
+                ++level;
+            image::Image *thumb = img.pyramid_view(level);
+            if (!thumb)
+                return false;
+            int tw = thumb->width(), th = thumb->height();
+            const uint8_t *cur = (const uint8_t *)thumb->data();
+            bool motion = false;
+            if (tw == _thumb_w && th == _thumb_h)
+            {
+                float sx = (float)tw / img.width(), sy = (float)th / img.height();
+                std::vector<uint8_t> covered(tw * th, 0);
+                for (auto &t : _tracks)
+                {
+                    std::vector<int> r = t.code.rect();
+                    int x0 = std::max((int)(r[0] * sx), 0), y0 = std::max((int)(r[1] * sy), 0);
+                    int x1 = std::min((int)ceilf((r[0] + r[2]) * sx), tw), y1 = std::min((int)ceilf((r[1] + r[3]) * sy), th);
+                    int changed = 0, total = 0;
+                    for (int y = y0; y < y1; ++y)
+                    {
+                        for (int x = x0; x < x1; ++x)
+                        {
+                            int i = y * tw + x;
+                            changed += abs((int)cur[i] - _thumb[i]) > MOTION_PIXEL_DIFF;
+                            covered[i] = 1;
+                            ++total;
+                        }
+                    }
+                    t.still = total > 0 && changed == 0;
+                }
+                if (_motion_threshold > 0)
+                {
+                    int changed = 0, total = 0;
+                    for (int i = 0; i < tw * th; ++i)
+                    {
+                        if (covered[i])
+                            continue;
+                        changed += abs((int)cur[i] - _thumb[i]) > MOTION_PIXEL_DIFF;
+                        ++total;
+                    }
+                    motion = total > 0 && changed > total * _motion_threshold;
+                }
+            }
+            _thumb.assign(cur, cur + tw * th);
+            _thumb_w = tw;
+            _thumb_h = th;
+            return motion;
+        }
+
+        static void _center(Code &code, float &cx, float &cy)
+        {
+            std::vector<int> r = code.rect();
+            cx = r[0] + r[2] / 2.0f;
+            cy = r[1] + r[3] / 2.0f;
+        }
+
+        // find track of code, near predicted position and same payload first
+        int _match(Code &code, bool only_not_updated)
+        {
+            float cx, cy;
+            _center(code, cx, cy);
+            std::string payload = code.payload();
+            int best = -1;
+            float best_score = 0;
+            for (size_t i = 0; i < _tracks.size(); ++i)
+            {
+                ScanTrack<Code> &t = _tracks[i];
+                if (only_not_updated && t.updated)
+                    continue;
+                float tx, ty;
+                _center(t.code, tx, ty);
+                float dt = (float)(_frame - t.last_frame);
+                tx += t.vx * dt;
+                ty += t.vy * dt;
+                float radius = (float)std::max(t.code.w(), t.code.h()) + (fabsf(t.vx) + fabsf(t.vy)) * dt;
+                float dist = hypotf(cx - tx, cy - ty);
+                if (dist > radius)
+                    continue;
+                float score = dist - (t.code.payload() == payload ? radius : 0);
+                if (best < 0 || score < best_score)
+                {
+                    best = (int)i;
+                    best_score = score;
+                }
+            }
+            return best;
+        }
+
+        void _update(ScanTrack<Code> &t, Code &code)
+        {
+            float ox, oy, nx, ny;
+            _center(t.code, ox, oy);
+            _center(code, nx, ny);
+            float dt = (float)(_frame - t.last_frame);
+            if (dt > 0)
+            {
+                t.vx = t.vx * 0.5f + (nx - ox) / dt * 0.5f;
+                t.vy = t.vy * 0.5f + (ny - oy) / dt * 0.5f;
+            }
+            t.code = code;
+            t.last_frame = _frame;
+            t.lost = 0;
+            t.updated = true;
+        }
+
+        void _add_or_update(Code &code)
+        {
+            int idx = _match(code, true);
+            if (idx >= 0)
+            {
+                _update(_tracks[idx], code);
+                return;
+            }
+            float cx, cy;
+            _center(code, cx, cy);
+            for (auto &t : _tracks)
+            {
+                // same code already found in this frame
+                if (t.updated && t.code.payload() == code.payload() &&
+                    cx >= t.code.x() && cx < t.code.x() + t.code.w() && cy >= t.code.y() && cy < t.code.y() + t.code.h())
+                    return;
+            }
+            ScanTrack<Code> t(code);
+            t.last_frame = _frame;
+            t.updated = true;
+            _tracks.push_back(t);
+        }
+
+        void _full_search(image::Image &img)
+        {
+            image::Image *src = img.pyramid_view(_detect_level);
+            if (!src)
+                src = img.gray_view();
+            std::vector<Code> codes = _decode(*src, std::vector<int>());
+            float sx = (float)img.width() / src->width(), sy = (float)img.height() / src->height();
+            for (auto &c : codes)
+            {
+                Code code = src == img.gray_view() ? c : _scale_code(c, sx, sy);
+                _add_or_update(code);
+            }
+            _last_full = _frame;
+            ++_full_searches;
+        }
+
+        void _decode_rois(image::Image &img)
+        {
+            std::vector<int> idxs;
+            std::vector<std::vector<int>> rois;
+            for (size_t i = 0; i < _tracks.size(); ++i)
+            {
+                ScanTrack<Code> &t = _tracks[i];
+                if (t.updated)
+                    continue;
+                // code not moved, use last decoded result
+                if (t.still && t.last_frame == _frame - 1)
+                {
+                    t.last_frame = _frame;
+                    t.vx = t.vy = 0;
+                    t.updated = true;
+                    continue;
+                }
+                float dt = (float)(_frame - t.last_frame);
+                float cx, cy;
+                _center(t.code, cx, cy);
+                cx += t.vx * dt;
+                cy += t.vy * dt;
+                float hw = t.code.w() / 2.0f + std::max(t.code.w() / 2.0f, (float)ROI_MIN_MARGIN) + fabsf(t.vx) * dt;
+                float hh = t.code.h() / 2.0f + std::max(t.code.h() / 2.0f, (float)ROI_MIN_MARGIN) + fabsf(t.vy) * dt;
+                int x0 = std::max((int)(cx - hw), 0), y0 = std::max((int)(cy - hh), 0);
+                int x1 = std::min((int)(cx + hw), img.width()), y1 = std::min((int)(cy + hh), img.height());
+                if (x1 - x0 < 8 || y1 - y0 < 8)
+                    continue;
+                idxs.push_back((int)i);
+                rois.push_back({x0, y0, x1 - x0, y1 - y0});
+            }
+            if (rois.empty())
+                return;
+
+            // decode one by one, decoders use imlib's global fb_alloc and umm_malloc heaps which are not thread safe
+            int n = (int)rois.size();
+            std::vector<std::vector<Code>> results(n);
+            for (int i = 0; i < n; ++i)
+            {
+                try
+                {
+                    results[i] = _decode(img, rois[i]);
+                }
+                catch (std::exception &e)
+                {
+                    log::warn("scanner decode roi failed: %s", e.what());
+                }
+            }
+
+            for (int i = 0; i < n; ++i)
+            {
+                ScanTrack<Code> &t = _tracks[idxs[i]];
+                std::vector<Code> &codes = results[i];
+                // take the code nearest to prediction and same payload first, other codes in ROI may be new ones
+                int best = -1;
+                float best_score = 0;
+                float dt = (float)(_frame - t.last_frame);
+                float tx, ty;
+                _center(t.code, tx, ty);
+                tx += t.vx * dt;
+                ty += t.vy * dt;
+                for (size_t j = 0; j < codes.size(); ++j)
+                {
+                    float cx, cy;
+                    _center(codes[j], cx, cy);
+                    float score = hypotf(cx - tx, cy - ty) - (codes[j].payload() == t.code.payload() ? 1e6f : 0);
+                    if (best < 0 || score < best_score)
+                    {
+                        best = (int)j;
+                        best_score = score;
+                    }
+                }
+                if (best >= 0 && !t.updated)
+                    _update(t, codes[best]);
+                for (size_t j = 0; j < codes.size(); ++j)
+                {
+                    if ((int)j != best)
+                        _add_or_update(codes[j]);
+                }
+            }
+        }
+    };
+
+    QRCodeScanner::QRCodeScanner(int detect_interval, int detect_level, float motion_threshold, int max_lost,
+                                 image::QRCodeDecoderType decoder_type)
+    {
+        auto decode = [decoder_type](image::Image &img, std::vector<int> roi) {
+            return img.find_qrcodes(roi, decoder_type);
+        };
+        _impl = new Scanner<image::QRCode>(decode, detect_interval, detect_level, motion_threshold, max_lost);
+    }
+
+    QRCodeScanner::~QRCodeScanner()
+    {
+        delete (Scanner<image::QRCode> *)_impl;
+    }
+
+    std::vector<image::QRCode> QRCodeScanner::scan(image::Image &img)
+    {
+        return ((Scanner<image::QRCode> *)_impl)->scan(img);
+    }
+
+    void QRCodeScanner::reset()
+    {
+        ((Scanner<image::QRCode> *)_impl)->reset();
+    }
+
+    int QRCodeScanner::tracked()
+    {
+        return ((Scanner<image::QRCode> *)_impl)->tracked();
+    }
+
+    uint64_t QRCodeScanner::full_searches()
+    {
+        return ((Scanner<image::QRCode> *)_impl)->full_searches();
+    }
+
+    BarcodeScanner::BarcodeScanner(int detect_interval, int detect_level, float motion_threshold, int max_lost)
+    {
+        auto decode = [](image::Image &img, std::vector<int> roi) {
+            return img.find_barcodes(roi);
+        };
+        _impl = new Scanner<image::BarCode>(decode, detect_interval, detect_level, motion_threshold, max_lost);
+    }
+
+    BarcodeScanner::~BarcodeScanner()
+    {
+        delete (Scanner<image::BarCode> *)_impl;
+    }
+
+    std::vector<image::BarCode> BarcodeScanner::scan(image::Image &img)
+    {
+        return ((Scanner<image::BarCode> *)_impl)->scan(img);
+    }
+
+    void BarcodeScanner::reset()
+    {
+        ((Scanner<image::BarCode> *)_impl)->reset();
+    }
+
+    int BarcodeScanner::tracked()
+    {
+        return ((Scanner<image::BarCode> *)_impl)->tracked();
+    }
+
+    uint64_t BarcodeScanner::full_searches()
+    {
+        return ((Scanner<image::BarCode> *)_impl)->full_searches();
+    }
+} // namespace maix::image
@@ -687,21 +687,7 @@ static std::vector<image::LineGroup> found_path(std::list<NewLine> &merged_lines
 std::vector<image::LineGroup> Image::search_line_path(int threshold, int merge_degree, int min_len_of_new_path)
 {
     DEBUG_EN(0);
-    auto gray_img = (image::Image *)nullptr;
-    auto need_free_gray_img = false;
-    if (this->format() != image::FMT_GRAYSCALE) {
-        // auto new_img = this->binary(thresholds, false, false, nullptr, false, true);
-        // gray_img = new_img->to_format(image::FMT_GRAYSCALE);
-        // delete new_img;
-
-        gray_img = this->to_format(image::FMT_GRAYSCALE);
-        need_free_gray_img = true;
-    } else {
-        // gray_img = this->binary(thresholds, false, false, nullptr, false, true);
-
-        gray_img = this;
-        need_free_gray_img = false;
-    }
+    auto gray_img = this->gray_view();
 
     cv::Mat edges;
     cv::Mat gray = cv::Mat(gray_img->height(), gray_img->width(), CV_8UC((int)image::fmt_size[gray_img->format()]), gray_img->data());
@@ -766,10 +752,6 @@ std::vector<image::LineGroup> Image::search_line_path(int threshold, int merge_d
 
     auto groups = found_path(merged_lines, min_len_of_new_path);
 
-    if (need_free_gray_img) {
-        delete gray_img;
-    }
-
     return groups;
 }
 }
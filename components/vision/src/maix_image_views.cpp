@@ -0,0 +1,172 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add cached derived views of image, create this file.
+ *         2026.10.18: Views can be requested by many threads at once.
+ */
+
+#include "maix_image.hpp"
+#include "opencv2/opencv.hpp"
+#include <mutex>
+#include <vector>
+
+namespace maix::image
+{
+    // Derived views of one image, every view records the generation it was built from,
+    // stale views are rebuilt on next access and their buffers reused if size not changed.
+    // Views may be requested by many threads at once(e.g. decoders of image::Scanner), mutex protects all members.
+    struct ImageViews
+    {
+        std::mutex mutex;
+        image::Image *gray = nullptr;
+        uint64_t gray_gen = 0;
+        uint32_t *sum[2] = {nullptr, nullptr}; // [0] sum, [1] squared sum
+        int sum_size[2] = {0, 0};
+        uint64_t sum_gen[2] = {0, 0};
+        std::vector<image::Image *> pyramid;    // level 1 ~ n, level 0 is gray
+        uint64_t pyramid_gen = 0;
+    };
+
+    static void _free_pyramid(ImageViews *views)
+    {
+        for (auto img : views->pyramid)
+            delete img;
+        views->pyramid.clear();
+    }
+
+    // get views of image, created at first use, threads racing to create it agree on one by compare and swap
+    static ImageViews *_get_views(void **slot)
+    {
+        ImageViews *views = (ImageViews *)__atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (views)
+            return views;
+        ImageViews *created = new ImageViews();
+        void *expected = nullptr;
+        if (__atomic_compare_exchange_n(slot, &expected, (void *)created, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return created;
+        delete created;
+        return (ImageViews *)expected;
+    }
+
+    // caller holds views->mutex
+    static image::Image *_gray_locked(image::Image *img, ImageViews *views)
+    {
+        if (views->gray && views->gray_gen == img->generation())
+            return views->gray;
+        delete views->gray;
+        views->gray = nullptr;
+        if (img->format() == image::FMT_YVU420SP)
+        {
+            // Y plane is already grayscale, only wrap it
+            views->gray = new image::Image(img->width(), img->height(), image::FMT_GRAYSCALE, (uint8_t *)img->data(), img->width() * img->height(), false);
+        }
+        else
+        {
+            views->gray = img->to_format(image::FMT_GRAYSCALE);
+        }
+        views->gray_gen = img->generation();
+        return views->gray;
+    }
+
+    void Image::_free_views()
+    {
+        ImageViews *views = (ImageViews *)_views;
+        if (!views)
+            return;
+        if (views->gray != this)
+            delete views->gray;
+        for (int i = 0; i < 2; ++i)
+        {
+            if (views->sum[i])
+                image::BufferPool::global().free(views->sum[i], views->sum_size[i]);
+        }
+        _free_pyramid(views);
+        delete views;
+        _views = nullptr;
+    }
+
+    image::Image *Image::gray_view()
+    {
+        if (_format == image::FMT_GRAYSCALE)
+            return this;
+        ImageViews *views = _get_views(&_views);
+        std::lock_guard<std::mutex> lock(views->mutex);
+        return _gray_locked(this, views);
+    }
+
+    const uint32_t *Image::integral_view(bool squared)
+    {
+        ImageViews *views = _get_views(&_views);
+        std::lock_guard<std::mutex> lock(views->mutex);
+        image::Image *gray = _format == image::FMT_GRAYSCALE ? this : _gray_locked(this, views);
+        if (!gray)
+            return nullptr;
+        int idx = squared ? 1 : 0;
+        int size = _width * _height * sizeof(uint32_t);
+        if (views->sum[idx] && views->sum_gen[idx] == _generation && views->sum_size[idx] == size)
+            return views->sum[idx];
+        if (views->sum[idx] && views->sum_size[idx] != size)
+        {
+            image::BufferPool::global().free(views->sum[idx], views->sum_size[idx]);
+            views->sum[idx] = nullptr;
+        }
+        if (!views->sum[idx])
+        {
+            views->sum[idx] = (uint32_t *)image::BufferPool::global().alloc(size);
+            if (!views->sum[idx])
+                return nullptr;
+            views->sum_size[idx] = size;
+        }
+
+        // same layout and arithmetic as imlib_integral_image and imlib_integral_image_sq
+        const uint8_t *src = (const uint8_t *)gray->data();
+        uint32_t *dst = views->sum[idx];
+        int w = _width;
+        for (int y = 0; y < _height; ++y)
+        {
+            const uint8_t *s = src + y * w;
+            uint32_t *d = dst + y * w;
+            uint32_t row = 0;
+            for (int x = 0; x < w; ++x)
+            {
+                row += squared ? (uint32_t)s[x] * s[x] : s[x];
+                d[x] = y == 0 ? row : row + d[x - w];
+            }
+        }
+        views->sum_gen[idx] = _generation;
+        return dst;
+    }
+
+    image::Image *Image::pyramid_view(int level)
+    {
+        if (level < 0)
+            return nullptr;
+        if (level == 0)
+            return gray_view();
+        ImageViews *views = _get_views(&_views);
+        std::lock_guard<std::mutex> lock(views->mutex);
+        image::Image *gray = _format == image::FMT_GRAYSCALE ? this : _gray_locked(this, views);
+        if (!gray)
+            return nullptr;
+        if (views->pyramid_gen != _generation)
+        {
+            _free_pyramid(views);
+            views->pyramid_gen = _generation;
+        }
+        while ((int)views->pyramid.size() < level)
+        {
+            image::Image *prev = views->pyramid.empty() ? gray : views->pyramid.back();
+            if (prev->width() < 2 || prev->height() < 2)
+                return nullptr;
+            int w = (prev->width() + 1) / 2;
+            int h = (prev->height() + 1) / 2;
+            image::Image *next = new image::Image(w, h, image::FMT_GRAYSCALE);
+            cv::Mat src(prev->height(), prev->width(), CV_8UC1, prev->data());
+            cv::Mat dst(h, w, CV_8UC1, next->data());
+            cv::pyrDown(src, dst, cv::Size(w, h));
+            views->pyramid.push_back(next);
+        }
+        return views->pyramid[level - 1];
+    }
+} // namespace maix::image
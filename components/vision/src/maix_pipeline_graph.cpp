@@ -0,0 +1,558 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add multi-stage frame pipeline graph, create this file.
+ */
+
+#include "maix_pipeline_graph.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <pthread.h>
+
+namespace maix::pipeline
+{
+    // trace stores name pointer, stage names are kept for whole program life
+    static const char *_intern_name(const std::string &name)
+    {
+        static std::mutex mutex;
+        static std::unordered_set<std::string> names;
+        std::lock_guard<std::mutex> lock(mutex);
+        return names.insert(name).first->c_str();
+    }
+
+    using PacketPtr = std::shared_ptr<Packet>;
+
+    /**
+     * Bounded single producer single consumer queue.
+     * BLOCK and DROP_NEW use a lock-free ring, LATEST uses one atomic slot exchanged by both sides.
+     * Mutex and condition variable are only touched when one side has to sleep.
+     */
+    class PacketQueue
+    {
+    public:
+        PacketQueue(int size, DropPolicy policy)
+            : _policy(policy)
+        {
+            _cap = size > 0 ? size : 1;
+            _ring.resize(_cap);
+        }
+
+        ~PacketQueue()
+        {
+            delete _slot.exchange(nullptr);
+        }
+
+        // called by producer, return false if packet dropped or queue closed
+        bool push(const PacketPtr &p)
+        {
+            if (_policy == DropPolicy::LATEST)
+            {
+                PacketPtr *old = _slot.exchange(new PacketPtr(p));
+                if (old)
+                {
+                    delete old;
+                    ++dropped;
+                }
+                _notify();
+                return true;
+            }
+            while (_full())
+            {
+                if (_policy == DropPolicy::DROP_NEW)
+                {
+                    ++dropped;
+                    return false;
+                }
+                if (!_wait([this] { return !_full(); }))
+                    return false;
+            }
+            size_t h = _head.load(std::memory_order_relaxed);
+            _ring[h % _cap] = p;
+            _head.store(h + 1);
+            _notify();
+            return true;
+        }
+
+        // called by consumer, block until got one packet, return false if queue closed
+        bool pop(PacketPtr &p)
+        {
+            while (true)
+            {
+                if (_closed)
+                    return false;
+                if (_policy == DropPolicy::LATEST)
+                {
+                    PacketPtr *slot = _slot.exchange(nullptr);
+                    if (slot)
+                    {
+                        p = std::move(*slot);
+                        delete slot;
+                        return true;
+                    }
+                    if (!_wait([this] { return _slot.load() != nullptr; }))
+                        return false;
+                    continue;
+                }
+                size_t t = _tail.load(std::memory_order_relaxed);
+                if (t != _head.load())
+                {
+                    p = std::move(_ring[t % _cap]);
+                    _tail.store(t + 1);
+                    _notify();
+                    return true;
+                }
+                if (!_wait([this] { return _tail.load(std::memory_order_relaxed) != _head.load(); }))
+                    return false;
+            }
+        }
+
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
+            }
+            _cond.notify_all();
+        }
+
+        // drop all packets and reopen, only call when both sides stopped
+        void reset()
+        {
+            delete _slot.exchange(nullptr);
+            for (auto &p : _ring)
+                p.reset();
+            _head = 0;
+            _tail = 0;
+            _closed = false;
+        }
+
+        int size()
+        {
+            if (_policy == DropPolicy::LATEST)
+                return _slot.load() ? 1 : 0;
+            return (int)(_head.load() - _tail.load());
+        }
+
+        std::atomic<uint64_t> dropped{0};
+
+    private:
+        bool _full()
+        {
+            return _head.load(std::memory_order_relaxed) - _tail.load() >= _cap;
+        }
+
+        // waiters is checked by other side after publishing, both seq_cst, so wakeup won't be lost
+        void _notify()
+        {
+            if (_waiters.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cond.notify_all();
+            }
+        }
+
+        template <typename F>
+        bool _wait(F ready)
+        {
+            ++_waiters;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cond.wait(lock, [&] { return _closed || ready(); });
+            }
+            --_waiters;
+            return !_closed;
+        }
+
+        DropPolicy _policy;
+        size_t _cap;
+        std::vector<PacketPtr> _ring;
+        std::atomic<size_t> _head{0};
+        std::atomic<size_t> _tail{0};
+        std::atomic<PacketPtr *> _slot{nullptr};
+        std::atomic<int> _waiters{0};
+        std::atomic<bool> _closed{false};
+        std::mutex _mutex;
+        std::condition_variable _cond;
+    };
+
+    enum class NodeType
+    {
+        SOURCE = 0,
+        STAGE,
+        SINK,
+    };
+
+    struct Node
+    {
+        std::string name;
+        const char *trace_name;
+        NodeType type;
+        SourceFunc source;
+        StageFunc stage;
+        SinkFunc sink;
+        std::unique_ptr<PacketQueue> in;
+        std::vector<PacketQueue *> outs;
+        std::vector<int> cpus;
+        int priority;
+        std::thread thread;
+
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> sum_us{0};
+        std::atomic<uint64_t> max_us{0};
+        std::atomic<uint64_t> sum_latency_us{0};
+    };
+
+    struct GraphData
+    {
+        std::vector<std::unique_ptr<Node>> nodes; // source, stages, sinks
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> stats_start_us{0};
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+
+    static void _shutdown(GraphData *g)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g->mutex);
+            g->running = false;
+        }
+        g->cond.notify_all();
+        for (auto &n : g->nodes)
+        {
+            if (n->in)
+                n->in->close();
+        }
+    }
+
+    static void _run_node(GraphData *g, Node *n, std::string thread_name)
+    {
+        if (thread_name.size() > 15)
+            thread_name = thread_name.substr(0, 15);
+        pthread_setname_np(pthread_self(), thread_name.c_str());
+        trace::set_thread_name(n->name);
+        if (!n->cpus.empty())
+            thread::set_affinity(n->cpus);
+        if (n->priority > 0)
+            thread::set_priority(n->priority);
+
+        uint64_t seq = 0;
+        int idle_ms = 0; // source back off when no frame
+        while (g->running)
+        {
+            PacketPtr p;
+            bool ok = false;
+            uint64_t t0;
+            if (n->type == NodeType::SOURCE)
+            {
+                if (app::need_exit())
+                {
+                    _shutdown(g);
+                    break;
+                }
+                p = std::make_shared<Packet>();
+                t0 = time::ticks_us();
+                p->seq = seq;
+                p->timestamp_us = t0;
+            }
+            else
+            {
+                if (!n->in->pop(p))
+                    break;
+                t0 = time::ticks_us();
+            }
+
+            try
+            {
+                trace::Span span(n->trace_name, "pipeline");
+                switch (n->type)
+                {
+                case NodeType::SOURCE:
+                    ok = n->source(*p);
+                    break;
+                case NodeType::STAGE:
+                    ok = n->stage(*p);
+                    break;
+                case NodeType::SINK:
+                    n->sink(*p);
+                    ok = true;
+                    break;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                log::error("pipeline %s exception: %s", n->name.c_str(), e.what());
+                ok = false;
+            }
+            uint64_t t1 = time::ticks_us();
+
+            if (n->type == NodeType::SOURCE)
+            {
+                // no frame this time, not a drop, wait a while before retry instead of spinning, stop wakes up the wait
+                if (!ok)
+                {
+                    idle_ms = idle_ms ? std::min(idle_ms * 2, 20) : 1;
+                    std::unique_lock<std::mutex> lock(g->mutex);
+                    g->cond.wait_for(lock, std::chrono::milliseconds(idle_ms), [g]() { return !g->running; });
+                    continue;
+                }
+                idle_ms = 0;
+                ++seq;
+            }
+            else if (!ok)
+            {
+                ++n->dropped;
+                continue;
+            }
+            uint64_t used = t1 - t0;
+            ++n->processed;
+            n->sum_us += used;
+            n->sum_latency_us += t1 - p->timestamp_us;
+            if (used > n->max_us.load(std::memory_order_relaxed))
+                n->max_us = used;
+
+            for (auto out : n->outs)
+                out->push(p);
+        }
+    }
+
+    Graph::Graph(const std::string &name)
+        : _name(name)
+    {
+        _data = new GraphData();
+    }
+
+    Graph::~Graph()
+    {
+        stop();
+        delete (GraphData *)_data;
+    }
+
+    Graph &Graph::source(const std::string &name, SourceFunc func, const std::vector<int> &cpus, int priority)
+    {
+        GraphData *g = (GraphData *)_data;
+        err::check_bool_raise(!g->running, "pipeline is running, can not change graph");
+        err::check_bool_raise(g->nodes.empty() || g->nodes[0]->type != NodeType::SOURCE, "pipeline source already set");
+        Node *n = new Node();
+        n->name = name;
+        n->trace_name = _intern_name(name);
+        n->type = NodeType::SOURCE;
+        n->source = func;
+        n->cpus = cpus;
+        n->priority = priority;
+        g->nodes.emplace(g->nodes.begin(), n);
+        return *this;
+    }
+
+    Graph &Graph::stage(const std::string &name, StageFunc func, int queue_size, DropPolicy policy, const std::vector<int> &cpus, int priority)
+    {
+        GraphData *g = (GraphData *)_data;
+        err::check_bool_raise(!g->running, "pipeline is running, can not change graph");
+        for (auto &n : g->nodes)
+            err::check_bool_raise(n->type != NodeType::SINK, "pipeline stage must be added before sinks");
+        Node *n = new Node();
+        n->name = name;
+        n->trace_name = _intern_name(name);
+        n->type = NodeType::STAGE;
+        n->stage = func;
+        n->in.reset(new PacketQueue(queue_size, policy));
+        n->cpus = cpus;
+        n->priority = priority;
+        g->nodes.emplace_back(n);
+        return *this;
+    }
+
+    Graph &Graph::sink(const std::string &name, SinkFunc func, int queue_size, DropPolicy policy, const std::vector<int> &cpus, int priority)
+    {
+        GraphData *g = (GraphData *)_data;
+        err::check_bool_raise(!g->running, "pipeline is running, can not change graph");
+        Node *n = new Node();
+        n->name = name;
+        n->trace_name = _intern_name(name);
+        n->type = NodeType::SINK;
+        n->sink = func;
+        n->in.reset(new PacketQueue(queue_size, policy));
+        n->cpus = cpus;
+        n->priority = priority;
+        g->nodes.emplace_back(n);
+        return *this;
+    }
+
+    err::Err Graph::start()
+    {
+        GraphData *g = (GraphData *)_data;
+        if (g->running)
+            return err::ERR_BUSY;
+        // join threads of last run, e.g. stopped by app exit
+        stop();
+        if (g->nodes.size() < 2 || g->nodes[0]->type != NodeType::SOURCE)
+        {
+            log::error("pipeline %s need a source and at least one stage or sink", _name.c_str());
+            return err::ERR_NOT_READY;
+        }
+
+        // connect: source -> stage ... -> last stage -> all sinks
+        size_t first_sink = g->nodes.size();
+        for (size_t i = 0; i < g->nodes.size(); ++i)
+        {
+            if (g->nodes[i]->type == NodeType::SINK)
+            {
+                first_sink = i;
+                break;
+            }
+        }
+        for (size_t i = 0; i < first_sink; ++i)
+        {
+            Node *n = g->nodes[i].get();
+            n->outs.clear();
+            if (i + 1 < first_sink)
+                n->outs.push_back(g->nodes[i + 1]->in.get());
+            else
+            {
+                for (size_t j = first_sink; j < g->nodes.size(); ++j)
+                    n->outs.push_back(g->nodes[j]->in.get());
+            }
+        }
+        for (auto &n : g->nodes)
+        {
+            if (n->in)
+                n->in->reset();
+        }
+
+        reset_stats();
+        g->running = true;
+        for (size_t i = 0; i < g->nodes.size(); ++i)
+        {
+            Node *n = g->nodes[i].get();
+            n->thread = std::thread(_run_node, g, n, _name + "-" + std::to_string(i));
+        }
+        return err::ERR_NONE;
+    }
+
+    void Graph::stop()
+    {
+        GraphData *g = (GraphData *)_data;
+        _shutdown(g);
+        for (auto &n : g->nodes)
+        {
+            if (n->thread.joinable())
+                n->thread.join();
+        }
+    }
+
+    bool Graph::running()
+    {
+        return ((GraphData *)_data)->running;
+    }
+
+    bool Graph::wait(int timeout_ms)
+    {
+        GraphData *g = (GraphData *)_data;
+        uint64_t start = time::ticks_ms();
+        std::unique_lock<std::mutex> lock(g->mutex);
+        while (g->running && !app::need_exit())
+        {
+            if (timeout_ms >= 0 && time::ticks_ms() - start >= (uint64_t)timeout_ms)
+                return false;
+            // app exit flag has no notify, check it periodically
+            g->cond.wait_for(lock, std::chrono::milliseconds(50));
+        }
+        return true;
+    }
+
+    std::vector<StageStats> Graph::stats()
+    {
+        GraphData *g = (GraphData *)_data;
+        std::vector<StageStats> res;
+        float elapsed_s = (time::ticks_us() - g->stats_start_us) / 1000000.0f;
+        for (auto &n : g->nodes)
+        {
+            StageStats s;
+            s.name = n->name;
+            s.processed = n->processed;
+            s.dropped = n->dropped + (n->in ? n->in->dropped.load() : 0);
+            s.fps = elapsed_s > 0 ? s.processed / elapsed_s : 0;
+            s.avg_us = s.processed ? (float)n->sum_us / s.processed : 0;
+            s.max_us = n->max_us;
+            s.latency_us = s.processed ? (float)n->sum_latency_us / s.processed : 0;
+            s.queue_len = n->in ? n->in->size() : 0;
+            res.push_back(s);
+        }
+        return res;
+    }
+
+    std::string Graph::stats_str()
+    {
+        std::string res;
+        char buf[256];
+        for (auto &s : stats())
+        {
+            snprintf(buf, sizeof(buf), "%-16s fps: %6.2f, avg: %8.2f ms, max: %8.2f ms, latency: %8.2f ms, processed: %llu, dropped: %llu, queue: %d\n",
+                     s.name.c_str(), s.fps, s.avg_us / 1000, s.max_us / 1000, s.latency_us / 1000,
+                     (unsigned long long)s.processed, (unsigned long long)s.dropped, s.queue_len);
+            res += buf;
+        }
+        return res;
+    }
+
+    void Graph::reset_stats()
+    {
+        GraphData *g = (GraphData *)_data;
+        for (auto &n : g->nodes)
+        {
+            n->processed = 0;
+            n->dropped = 0;
+            n->sum_us = 0;
+            n->max_us = 0;
+            n->sum_latency_us = 0;
+            if (n->in)
+                n->in->dropped = 0;
+        }
+        g->stats_start_us = time::ticks_us();
+    }
+
+    SourceFunc camera_source(camera::Camera &cam, int block_ms)
+    {
+        return [&cam, block_ms](Packet &p) {
+            image::Image *img = cam.read(true, block_ms);
+            if (!img)
+                return false;
+            p.img.reset(img);
+            return true;
+        };
+    }
+
+    SinkFunc display_sink(display::Display &disp, image::Fit fit)
+    {
+        return [&disp, fit](const Packet &p) {
+            if (p.img)
+                disp.show(*p.img, fit);
+        };
+    }
+
+    SinkFunc encoder_sink(video::Encoder &encoder, std::function<void(video::Frame *)> on_frame)
+    {
+        return [&encoder, on_frame](const Packet &p) {
+            if (!p.img)
+                return;
+            video::Frame *frame = encoder.encode(p.img.get());
+            if (on_frame)
+                on_frame(frame);
+            else
+                delete frame;
+        };
+    }
+
+    SinkFunc jpeg_streamer_sink(http::JpegStreamer &streamer)
+    {
+        return [&streamer](const Packet &p) {
+            if (p.img)
+                streamer.write(p.img.get());
+        };
+    }
+} // namespace maix::pipeline
@@ -3,6 +3,7 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Add sample format, channel conversion and streaming resampler.
  */
 
 #pragma once
@@ -33,6 +34,8 @@ namespace maix::audio
         FMT_U32_LE,         // unsigned 32 bits, little endian
         FMT_U16_BE,         // unsigned 16 bits, big endian
         FMT_U32_BE,         // unsigned 32 bits, big endian
+        FMT_S24_LE,         // signed 24 bits, little endian, packed in 3 bytes
+        FMT_F32_LE,         // 32 bits float, little endian, range [-1.0, 1.0]
     };
 
     /**
@@ -42,9 +45,57 @@ namespace maix::audio
      * @maixpy maix.audio.fmt_bits
     */
     const std::vector<int> fmt_bits = {
-        0, 8, 16, 32, 16, 32, 8, 16, 32, 16, 32
+        0, 8, 16, 32, 16, 32, 8, 16, 32, 16, 32, 24, 32
     };
 
+    /**
+     * Convert samples to float, range [-1.0, 1.0].
+     * S16_LE and F32_LE use SIMD on platforms with NEON.
+     * @param src source samples, interleaved if multiple channels.
+     * @param format source sample format.
+     * @param dst output float samples, at least samples floats.
+     * @param samples number of samples, frames * channels.
+     * @return err::ERR_ARGS if format not supported.
+     * @maixcdk maix.audio.to_float
+     */
+    err::Err to_float(const void *src, audio::Format format, float *dst, int samples);
+
+    /**
+     * Convert float samples to format, values out of range [-1.0, 1.0] are clamped, integer formats are rounded.
+     * @param src float samples.
+     * @param format output sample format.
+     * @param dst output samples, at least samples * fmt_bits[format] / 8 bytes.
+     * @param samples number of samples, frames * channels.
+     * @return err::ERR_ARGS if format not supported.
+     * @maixcdk maix.audio.from_float
+     */
+    err::Err from_float(const float *src, audio::Format format, void *dst, int samples);
+
+    /**
+     * Convert sample format, e.g. S32_LE from microphone to S16_LE.
+     * @param src source samples.
+     * @param src_format source sample format.
+     * @param dst output samples, can be the same as src only if output sample is not bigger than source sample.
+     * @param dst_format output sample format.
+     * @param samples number of samples, frames * channels.
+     * @return err::ERR_ARGS if format not supported.
+     * @maixcdk maix.audio.convert_format
+     */
+    err::Err convert_format(const void *src, audio::Format src_format, void *dst, audio::Format dst_format, int samples);
+
+    /**
+     * Convert channel number of interleaved float frames.
+     * Down mix to mono averages all channels, down mix to N channels averages channel i, i + N, i + 2N...,
+     * up mix copies channel i % src_channels to channel i.
+     * @param src source frames.
+     * @param src_channels source channel number.
+     * @param dst output frames, at least frames * dst_channels floats, must not overlap with src.
+     * @param dst_channels output channel number.
+     * @param frames number of frames.
+     * @maixcdk maix.audio.mix_channels
+     */
+    void mix_channels(const float *src, int src_channels, float *dst, int dst_channels, int frames);
+
     /**
      * Audio file reader
      * @maixpy maix.audio.File
@@ -57,43 +108,19 @@ namespace maix::audio
         int _sample_bits;
         bool is_pcm_file = false;
 
-        static float _clamp_float(float val) {
-            return std::max(-1.0f, std::min(1.0f, val));
+        static audio::Format _bits_to_format(int bit_depth) {
+            switch (bit_depth) {
+                case 8: return audio::Format::FMT_U8;   // 8-bit PCM is unsigned
+                case 16: return audio::Format::FMT_S16_LE;
+                case 24: return audio::Format::FMT_S24_LE;
+                case 32: return audio::Format::FMT_S32_LE;
+                default:
+                    throw std::runtime_error("Unsupported bit depth");
+            }
         }
 
         static void _float_to_pcm_bytes(const float* float_data, size_t sample_count, int bit_depth, uint8_t *out_bytes) {
-            for (size_t i = 0; i < sample_count; ++i) {
-                float sample = _clamp_float(float_data[i]);
-
-                switch (bit_depth) {
-                    case 8: {
-                        // 8-bit PCM is unsigned
-                        uint8_t val = static_cast<uint8_t>((sample + 1.0f) * 127.5f);  // [−1,1] → [0,255]
-                        out_bytes[i] = val;
-                        break;
-                    }
-                    case 16: {
-                        int16_t val = static_cast<int16_t>(sample * 32767.0f);
-                        std::memcpy(&out_bytes[i * 2], &val, 2);
-                        break;
-                    }
-                    case 24: {
-                        int32_t val = static_cast<int32_t>(sample * 8388607.0f);
-                        uint8_t* p = &out_bytes[i * 3];
-                        p[0] = val & 0xFF;
-                        p[1] = (val >> 8) & 0xFF;
-                        p[2] = (val >> 16) & 0xFF;
-                        break;
-                    }
-                    case 32: {
-                        int32_t val = static_cast<int32_t>(sample * 2147483647.0f);
-                        std::memcpy(&out_bytes[i * 4], &val, 4);
-                        break;
-                    }
-                    default:
-                        throw std::runtime_error("Unsupported bit depth");
-                }
-            }
+            audio::from_float(float_data, _bits_to_format(bit_depth), out_bytes, sample_count);
         }
 
         err::Err _load_pcm(std::string path, int sample_rate = 16000, int channels = 1, int bits_per_sample = 16) {
@@ -265,38 +292,7 @@ namespace maix::audio
         */
         void pcm_bytes_to_float(const uint8_t* pcm_data, size_t sample_count, int bit_depth, std::vector<float>& float_out) {
             float_out.resize(sample_count);
-
-            for (size_t i = 0; i < sample_count; ++i) {
-                switch (bit_depth) {
-                    case 8: {
-                        uint8_t val = pcm_data[i];
-                        float_out[i] = (val / 127.5f) - 1.0f;
-                        break;
-                    }
-                    case 16: {
-                        int16_t val;
-                        std::memcpy(&val, &pcm_data[i * 2], 2);
-                        float_out[i] = val / 32768.0f;
-                        break;
-                    }
-                    case 24: {
-                        const uint8_t* p = &pcm_data[i * 3];
-                        int32_t val = (p[2] << 16) | (p[1] << 8) | p[0];
-                        // sign-extend to 32-bit if necessary
-                        if (val & 0x800000) val |= 0xFF000000;
-                        float_out[i] = val / 8388608.0f;
-                        break;
-                    }
-                    case 32: {
-                        int32_t val;
-                        std::memcpy(&val, &pcm_data[i * 4], 4);
-                        float_out[i] = val / 2147483648.0f;
-                        break;
-                    }
-                    default:
-                        throw std::runtime_error("Unsupported bit depth");
-                }
-            }
+            audio::to_float(pcm_data, _bits_to_format(bit_depth), float_out.data(), sample_count);
         }
 
         /**
@@ -595,7 +591,9 @@ namespace maix::audio
 
         /**
          * Play
-         * @param data audio data, must be raw data
+         * @param data audio data, must be raw data.
+         * If not set, play file passed to constructor, in non-block mode return err::ERR_BUFF_FULL when buffer is full,
+         * call play() again to continue from where it stopped, file restarts from beginning after whole file queued.
          * @return error code, err::ERR_NONE means success, others means failed
          * @maixpy maix.audio.Player.play
         */
@@ -667,5 +665,142 @@ namespace maix::audio
          */
         int channel();
     };
+
+    /**
+     * Streaming polyphase resampler, band limited by Kaiser windowed sinc filter, support any sample rate pair, e.g. 48000 to 16000, 44100 to 16000.
+     * Process audio chunk by chunk, filter state is kept between chunks so there is no click at chunk boundaries.
+     * @maixcdk maix.audio.Resampler
+     */
+    class Resampler
+    {
+    public:
+        /**
+         * Construct a new Resampler object
+         * @param in_rate input sample rate.
+         * @param out_rate output sample rate.
+         * @param channels channel number, frames are interleaved.
+         * @param quality filter zero crossings each side, bigger has sharper cutoff and more CPU, 8 ~ 32, default 16.
+         * @throw err::Exception if args invalid.
+         * @maixcdk maix.audio.Resampler.Resampler
+         */
+        Resampler(int in_rate, int out_rate, int channels = 1, int quality = 16);
+
+        Resampler(const Resampler&) = delete;
+        Resampler& operator=(const Resampler&) = delete;
+
+        ~Resampler();
+
+        /**
+         * Resample one chunk.
+         * @param in input float frames, interleaved.
+         * @param frames input frame number.
+         * @param out output float frames, interleaved, resized to output frames * channels.
+         * @return output frame number, output lags input by latency() frames, call flush() at the end of stream to get them.
+         * @maixcdk maix.audio.Resampler.process
+         */
+        int process(const float *in, int frames, std::vector<float> &out);
+
+        /**
+         * Output frames still in filter at the end of stream, then reset to start a new stream.
+         * @param out output float frames, interleaved.
+         * @return output frame number.
+         * @maixcdk maix.audio.Resampler.flush
+         */
+        int flush(std::vector<float> &out);
+
+        /**
+         * Clear filter state to start a new stream.
+         * @maixcdk maix.audio.Resampler.reset
+         */
+        void reset();
+
+        /**
+         * Filter delay, unit is input frames.
+         * @maixcdk maix.audio.Resampler.latency
+         */
+        int latency();
+
+    private:
+        void *_impl;
+    };
+
+    /**
+     * Streaming audio converter, convert sample format, channel number and sample rate in one call,
+     * e.g. put it between Recorder::record(48KHz, stereo, S16_LE) and speech models(16KHz, mono, float).
+     * @maixcdk maix.audio.Converter
+     */
+    class Converter
+    {
+    public:
+        /**
+         * Construct a new Converter object
+         * @param in_rate input sample rate.
+         * @param in_format input sample format.
+         * @param in_channels input channel number.
+         * @param out_rate output sample rate.
+         * @param out_format output sample format.
+         * @param out_channels output channel number.
+         * @param quality resampler quality, see Resampler.
+         * @throw err::Exception if args invalid.
+         * @maixcdk maix.audio.Converter.Converter
+         */
+        Converter(int in_rate, audio::Format in_format, int in_channels, int out_rate, audio::Format out_format, int out_channels, int quality = 16);
+
+        Converter(const Converter&) = delete;
+        Converter& operator=(const Converter&) = delete;
+
+        ~Converter();
+
+        /**
+         * Convert one chunk, a partial frame at the end is kept and joined with next chunk.
+         * @param in input data.
+         * @param in_bytes input data length.
+         * @param out output data in out_format.
+         * @return output frame number, < 0 means error, value is -err::Err.
+         * @maixcdk maix.audio.Converter.process
+         */
+        int process(const void *in, int in_bytes, std::vector<uint8_t> &out);
+
+        /**
+         * Convert one chunk and output float samples instead of out_format, for speech models need float input.
+         * @param in input data.
+         * @param in_bytes input data length.
+         * @param out output float frames, interleaved.
+         * @return output frame number, < 0 means error, value is -err::Err.
+         * @maixcdk maix.audio.Converter.process_float
+         */
+        int process_float(const void *in, int in_bytes, std::vector<float> &out);
+
+        /**
+         * Convert one chunk.
+         * @param in input data.
+         * @return output data in out_format, nullptr if error. For MaixCDK users, you need to manually release the returned object.
+         * @maixcdk maix.audio.Converter.process
+         */
+        maix::Bytes *process(maix::Bytes *in);
+
+        /**
+         * Output data still in resampler at the end of stream, then reset to start a new stream.
+         * @param out output data in out_format.
+         * @return output frame number.
+         * @maixcdk maix.audio.Converter.flush
+         */
+        int flush(std::vector<uint8_t> &out);
+
+        /**
+         * Same as flush, output float samples.
+         * @maixcdk maix.audio.Converter.flush_float
+         */
+        int flush_float(std::vector<float> &out);
+
+        /**
+         * Clear state to start a new stream.
+         * @maixcdk maix.audio.Converter.reset
+         */
+        void reset();
+
+    private:
+        void *_impl;
+    };
 }
 
@@ -3,15 +3,1014 @@
  * @copyright Sipeed Ltd 2023-
  * @license Apache 2.0
  * @update 2023.9.8: Add framework, create this file.
+ * @update 2026.10.18: Implement Recorder and Player with ALSA, device io runs in worker thread and exchanges data with api by lock-free ring buffer.
+ *                     Keep not implemented version if libasound not found.
  */
 
 #include <stdint.h>
 #include "maix_basic.hpp"
 #include "maix_err.hpp"
 #include "maix_audio.hpp"
+#if HAVE_ALSA
+#include <alsa/asoundlib.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
 
 using namespace maix;
 
+#if HAVE_ALSA
+namespace maix::audio
+{
+    // ALSA device name, set env to select device, e.g. `hw:Loopback,0,0` of snd-aloop or `hw:Dummy` of snd-dummy for test.
+    #define ENV_CAPTURE_DEVICE  "MAIX_AUDIO_CAPTURE_DEVICE"
+    #define ENV_PLAYBACK_DEVICE "MAIX_AUDIO_PLAYBACK_DEVICE"
+    #define DEFAULT_PERIOD_SIZE 1024
+    #define DEFAULT_PERIOD_COUNT 4
+
+    typedef struct {
+        int file_size;  // pcm + 44
+        int channel;
+        int sample_rate;
+        int sample_bit;
+        int bitrate;
+        int data_size;  // size of pcm
+    } wav_header_t;
+
+    static int _create_wav_header(wav_header_t *header, uint8_t *data, size_t size)
+    {
+        if (size < 44) return -1;
+
+        int cnt = 0;
+        data[cnt ++] = 'R';
+        data[cnt ++] = 'I';
+        data[cnt ++] = 'F';
+        data[cnt ++] = 'F';
+
+        data[cnt ++] = (uint8_t)((header->file_size - 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->file_size - 8) >> 24) & 0xff);
+
+        data[cnt ++] = 'W';
+        data[cnt ++] = 'A';
+        data[cnt ++] = 'V';
+        data[cnt ++] = 'E';
+
+        data[cnt ++] = 'f';
+        data[cnt ++] = 'm';
+        data[cnt ++] = 't';
+        data[cnt ++] = ' ';
+
+        data[cnt ++] = 16;
+        data[cnt ++] = 0;
+        data[cnt ++] = 0;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = 1;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)header->channel;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)((header->sample_rate) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->sample_rate) >> 24) & 0xff);
+
+        data[cnt ++] = (uint8_t)((header->bitrate) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->bitrate) >> 24) & 0xff);
+
+        data[cnt ++] = (uint8_t)(header->channel * header->sample_bit / 8);
+        data[cnt ++] = 0;
+
+        data[cnt ++] = (uint8_t)header->sample_bit;
+        data[cnt ++] = 0;
+
+        data[cnt ++] = 'd';
+        data[cnt ++] = 'a';
+        data[cnt ++] = 't';
+        data[cnt ++] = 'a';
+
+        data[cnt ++] = (uint8_t)((header->data_size) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 8) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 16) & 0xff);
+        data[cnt ++] = (uint8_t)(((header->data_size) >> 24) & 0xff);
+
+        return 0;
+    }
+
+    static int _read_wav_header(wav_header_t *header, uint8_t *data, size_t size)
+    {
+        int cnt = 0;
+        if (size < 44) return -1;
+
+        if (data[cnt ++] != 'R' || data[cnt ++] != 'I' || data[cnt ++] != 'F' || data[cnt ++] != 'F')
+        {
+            log::error("RIFF not found in wav header!");
+            return -1;
+        }
+
+        cnt += 4; // jump file size
+
+        if (data[cnt ++] != 'W' || data[cnt ++] != 'A' || data[cnt ++] != 'V' || data[cnt ++] != 'E')
+        {
+            log::error("WAVE not found in wav header!");
+            return -2;
+        }
+
+        cnt += 4; // jump fmt
+        cnt += 4;
+
+        int audio_format = (uint32_t)data[cnt]
+                        | ((uint32_t)data[cnt + 1] << 8);
+        cnt += 2;
+        if (audio_format != 1) {
+            log::error("audio format is not pcm!");
+            return -3;
+        }
+
+        header->channel = (uint32_t)data[cnt]
+                        | ((uint32_t)data[cnt + 1] << 8);
+        cnt += 2;
+        header->sample_rate = (uint32_t)data[cnt]
+                            | ((uint32_t)data[cnt + 1] << 8)
+                            | ((uint32_t)data[cnt + 2] << 16)
+                            | ((uint32_t)data[cnt + 3] << 24);
+        cnt += 4;
+        header->bitrate = (uint32_t)data[cnt]
+                            | ((uint32_t)data[cnt + 1] << 8)
+                            | ((uint32_t)data[cnt + 2] << 16)
+                            | ((uint32_t)data[cnt + 3] << 24);
+        cnt += 6;
+        header->sample_bit = (uint32_t)data[cnt]
+                            | ((uint32_t)data[cnt + 1] << 8);
+        cnt += 6;
+        header->data_size = (uint32_t)data[cnt]
+                            | ((uint32_t)data[cnt + 1] << 8)
+                            | ((uint32_t)data[cnt + 2] << 16)
+                            | ((uint32_t)data[cnt + 3] << 24);
+        return 0;
+    }
+
+    /**
+     * Single producer single consumer byte ring, one side is the api caller, the other side is the worker thread.
+     * head and tail only increase, size is power of 2 so index is head & mask.
+     */
+    class RingBuffer
+    {
+    public:
+        void resize(size_t size)
+        {
+            size_t cap = 1;
+            while (cap < size)
+                cap <<= 1;
+            _buf.assign(cap, 0);
+            _mask = cap - 1;
+            _head.store(0);
+            _tail.store(0);
+        }
+
+        size_t capacity() const { return _buf.size(); }
+
+        size_t readable() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+
+        size_t writable() const { return capacity() - readable(); }
+
+        // producer side
+        size_t write(const uint8_t *data, size_t size)
+        {
+            size_t head = _head.load(std::memory_order_relaxed);
+            size_t tail = _tail.load(std::memory_order_acquire);
+            size = std::min(size, capacity() - (head - tail));
+            size_t offset = head & _mask;
+            size_t first = std::min(size, capacity() - offset);
+            memcpy(&_buf[offset], data, first);
+            memcpy(&_buf[0], data + first, size - first);
+            _head.store(head + size, std::memory_order_release);
+            return size;
+        }
+
+        // consumer side
+        size_t read(uint8_t *data, size_t size)
+        {
+            size_t tail = _tail.load(std::memory_order_relaxed);
+            size_t head = _head.load(std::memory_order_acquire);
+            size = std::min(size, head - tail);
+            size_t offset = tail & _mask;
+            size_t first = std::min(size, capacity() - offset);
+            memcpy(data, &_buf[offset], first);
+            memcpy(data + first, &_buf[0], size - first);
+            _tail.store(tail + size, std::memory_order_release);
+            return size;
+        }
+
+        // consumer side, drop all readable data
+        void clear()
+        {
+            _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+    private:
+        std::vector<uint8_t> _buf;
+        size_t _mask = 0;
+        alignas(64) std::atomic<size_t> _head{0};
+        alignas(64) std::atomic<size_t> _tail{0};
+    };
+
+    typedef struct {
+        std::string device;
+        snd_pcm_stream_t stream;
+        snd_pcm_t *pcm = nullptr;
+        bool mmap = true;               // false if device not support mmap access, fallback to readi/writei
+        int sample_rate;
+        audio::Format format;
+        int channel;
+        int frame_bytes;
+        snd_pcm_uframes_t period_size = DEFAULT_PERIOD_SIZE;
+        unsigned int period_count = DEFAULT_PERIOD_COUNT;
+
+        RingBuffer ring;
+        std::thread thread;
+        std::atomic<bool> running{false};
+        std::mutex wait_lock;           // only for waking up waiters, ring itself is lock-free
+        std::condition_variable wait_cond;
+        std::atomic<uint64_t> xruns{0};          // ALSA overrun(capture) or underrun(playback) recovered
+        std::atomic<uint64_t> dropped_frames{0}; // capture frames dropped because ring is full
+
+        std::string path = "";
+        FILE *file = nullptr;
+        bool file_playing = false;      // non-block file play stopped by full buffer, next play() continues from file position
+        wav_header_t wav_header;
+        bool block;
+        int volume = 100;
+        bool mute = false;
+    } audio_param_t;
+
+    static snd_pcm_format_t _to_alsa_format(audio::Format format)
+    {
+        switch (format) {
+        case FMT_S8: return SND_PCM_FORMAT_S8;
+        case FMT_U8: return SND_PCM_FORMAT_U8;
+        case FMT_S16_LE: return SND_PCM_FORMAT_S16_LE;
+        case FMT_S16_BE: return SND_PCM_FORMAT_S16_BE;
+        case FMT_U16_LE: return SND_PCM_FORMAT_U16_LE;
+        case FMT_U16_BE: return SND_PCM_FORMAT_U16_BE;
+        case FMT_S32_LE: return SND_PCM_FORMAT_S32_LE;
+        case FMT_S32_BE: return SND_PCM_FORMAT_S32_BE;
+        case FMT_U32_LE: return SND_PCM_FORMAT_U32_LE;
+        case FMT_U32_BE: return SND_PCM_FORMAT_U32_BE;
+        case FMT_S24_LE: return SND_PCM_FORMAT_S24_3LE;
+        case FMT_F32_LE: return SND_PCM_FORMAT_FLOAT_LE;
+        default: return SND_PCM_FORMAT_UNKNOWN;
+        }
+    }
+
+    static audio::Format _wav_sample_bit_to_format(int sample_bit)
+    {
+        switch (sample_bit) {
+        case 8: return FMT_U8;
+        case 16: return FMT_S16_LE;
+        case 24: return FMT_S24_LE;
+        case 32: return FMT_S32_LE;
+        default:
+            err::check_raise(err::ERR_ARGS, "not support sample bit(" + std::to_string(sample_bit) + ")");
+        }
+        return FMT_NONE;
+    }
+
+    static err::Err _pcm_config(audio_param_t *param, snd_pcm_uframes_t period_size, unsigned int period_count)
+    {
+        snd_pcm_t *pcm = param->pcm;
+        snd_pcm_hw_params_t *hw;
+        snd_pcm_sw_params_t *sw;
+        snd_pcm_hw_params_alloca(&hw);
+        snd_pcm_sw_params_alloca(&sw);
+
+        int res = snd_pcm_hw_params_any(pcm, hw);
+        if (res < 0) {
+            log::error("pcm %s get hw params failed: %s", param->device.c_str(), snd_strerror(res));
+            return err::ERR_RUNTIME;
+        }
+        param->mmap = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+        if (!param->mmap && (res = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+            log::error("pcm %s set access failed: %s", param->device.c_str(), snd_strerror(res));
+            return err::ERR_NOT_IMPL;
+        }
+        if ((res = snd_pcm_hw_params_set_format(pcm, hw, _to_alsa_format(param->format))) < 0) {
+            log::error("pcm %s not support format %d: %s", param->device.c_str(), param->format, snd_strerror(res));
+            return err::ERR_ARGS;
+        }
+        if ((res = snd_pcm_hw_params_set_channels(pcm, hw, param->channel)) < 0) {
+            log::error("pcm %s not support %d channels: %s", param->device.c_str(), param->channel, snd_strerror(res));
+            return err::ERR_ARGS;
+        }
+        unsigned int rate = param->sample_rate;
+        snd_pcm_hw_params_set_rate_resample(pcm, hw, 1);
+        if ((res = snd_pcm_hw_params_set_rate_near(pcm, hw, &rate, nullptr)) < 0) {
+            log::error("pcm %s not support sample rate %d: %s", param->device.c_str(), param->sample_rate, snd_strerror(res));
+            return err::ERR_ARGS;
+        }
+        if ((int)rate != param->sample_rate)
+            log::warn("pcm %s sample rate %d not supported, use %u", param->device.c_str(), param->sample_rate, rate);
+        snd_pcm_hw_params_set_period_size_near(pcm, hw, &period_size, nullptr);
+        snd_pcm_hw_params_set_periods_near(pcm, hw, &period_count, nullptr);
+        if ((res = snd_pcm_hw_params(pcm, hw)) < 0) {
+            log::error("pcm %s set hw params failed: %s", param->device.c_str(), snd_strerror(res));
+            return err::ERR_RUNTIME;
+        }
+        snd_pcm_uframes_t buffer_size;
+        snd_pcm_hw_params_get_period_size(hw, &period_size, nullptr);
+        snd_pcm_hw_params_get_periods(hw, &period_count, nullptr);
+        snd_pcm_hw_params_get_buffer_size(hw, &buffer_size);
+
+        snd_pcm_sw_params_current(pcm, sw);
+        snd_pcm_sw_params_set_avail_min(pcm, sw, period_size);
+        // playback auto starts once one period queued, capture is started by worker
+        snd_pcm_sw_params_set_start_threshold(pcm, sw, param->stream == SND_PCM_STREAM_PLAYBACK ? period_size : buffer_size * 2);
+        if ((res = snd_pcm_sw_params(pcm, sw)) < 0) {
+            log::error("pcm %s set sw params failed: %s", param->device.c_str(), snd_strerror(res));
+            return err::ERR_RUNTIME;
+        }
+
+        param->sample_rate = rate;
+        param->period_size = period_size;
+        param->period_count = period_count;
+        // ring holds at least 1 second, so api caller can be late for a while without losing data
+        size_t ring_size = std::max((size_t)rate * param->frame_bytes, (size_t)buffer_size * param->frame_bytes * 4);
+        param->ring.resize(ring_size);
+        return err::ERR_NONE;
+    }
+
+    static void _pcm_open(audio_param_t *param, snd_pcm_stream_t stream, const char *env_device)
+    {
+        const char *device = getenv(env_device);
+        param->device = device ? device : "default";
+        param->stream = stream;
+        param->frame_bytes = fmt_bits[param->format] / 8 * param->channel;
+        if (_to_alsa_format(param->format) == SND_PCM_FORMAT_UNKNOWN) {
+            err::check_raise(err::ERR_ARGS, "not support audio format(" + std::to_string(param->format) + ")");
+        }
+        int res = snd_pcm_open(&param->pcm, param->device.c_str(), stream, 0);
+        if (res < 0) {
+            param->pcm = nullptr;
+            err::check_raise(err::ERR_RUNTIME, "open pcm " + param->device + " failed: " + snd_strerror(res));
+        }
+        err::Err e = _pcm_config(param, param->period_size, param->period_count);
+        if (e != err::ERR_NONE) {
+            snd_pcm_close(param->pcm);
+            param->pcm = nullptr;
+            err::check_raise(e, "config pcm " + param->device + " failed");
+        }
+    }
+
+    static void _notify(audio_param_t *param)
+    {
+        {
+            std::lock_guard<std::mutex> lock(param->wait_lock);
+        }
+        param->wait_cond.notify_all();
+    }
+
+    static void _xrun_recover(audio_param_t *param, int res, bool count)
+    {
+        if (count && (res == -EPIPE || res == -ESTRPIPE)) {
+            uint64_t n = ++param->xruns;
+            log::warn("pcm %s %s, total %llu", param->device.c_str(),
+                      param->stream == SND_PCM_STREAM_CAPTURE ? "overrun" : "underrun", (unsigned long long)n);
+        }
+        res = snd_pcm_recover(param->pcm, res, 1);
+        if (res < 0) {
+            log::error("pcm %s recover failed: %s", param->device.c_str(), snd_strerror(res));
+            time::sleep_ms(10);
+            return;
+        }
+        if (param->stream == SND_PCM_STREAM_CAPTURE)
+            snd_pcm_start(param->pcm);
+    }
+
+    static inline uint8_t *_area_ptr(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset)
+    {
+        // interleaved, all channels share areas[0]
+        return (uint8_t *)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+    }
+
+    static void _capture_loop(audio_param_t *param)
+    {
+        snd_pcm_t *pcm = param->pcm;
+        std::vector<uint8_t> buffer(param->mmap ? 0 : param->period_size * param->frame_bytes);
+        int res = snd_pcm_start(pcm);
+        if (res < 0)
+            log::error("pcm %s start failed: %s", param->device.c_str(), snd_strerror(res));
+        while (param->running) {
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+            if (avail < 0) {
+                _xrun_recover(param, avail, true);
+                continue;
+            }
+            if ((snd_pcm_uframes_t)avail < param->period_size) {
+                res = snd_pcm_wait(pcm, 100);
+                if (res < 0)
+                    _xrun_recover(param, res, true);
+                continue;
+            }
+            snd_pcm_uframes_t frames = avail;
+            res = 0;
+            while (frames > 0) {
+                const uint8_t *src;
+                snd_pcm_uframes_t offset = 0, size = frames;
+                const snd_pcm_channel_area_t *areas;
+                if (param->mmap) {
+                    if ((res = snd_pcm_mmap_begin(pcm, &areas, &offset, &size)) < 0)
+                        break;
+                    src = _area_ptr(areas, offset);
+                } else {
+                    size = std::min(size, param->period_size);
+                    snd_pcm_sframes_t n = snd_pcm_readi(pcm, buffer.data(), size);
+                    if (n < 0) {
+                        res = n;
+                        break;
+                    }
+                    size = n;
+                    src = buffer.data();
+                }
+                size_t bytes = size * param->frame_bytes;
+                size_t written = param->ring.write(src, bytes);
+                if (written < bytes)
+                    param->dropped_frames += (bytes - written) / param->frame_bytes;
+                if (param->mmap) {
+                    snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, size);
+                    if (committed < 0 || (snd_pcm_uframes_t)committed != size) {
+                        res = committed < 0 ? committed : -EPIPE;
+                        break;
+                    }
+                }
+                frames -= size;
+            }
+            if (frames > 0 && res < 0)
+                _xrun_recover(param, res, true);
+            _notify(param);
+        }
+        snd_pcm_drop(pcm);
+    }
+
+    static void _playback_loop(audio_param_t *param)
+    {
+        snd_pcm_t *pcm = param->pcm;
+        std::vector<uint8_t> buffer(param->mmap ? 0 : param->period_size * param->frame_bytes);
+        // set when ring ran out while playing, the underrun followed is end of data, not a real xrun
+        bool starved = true;
+        while (param->running) {
+            snd_pcm_uframes_t ready = param->ring.readable() / param->frame_bytes;
+            if (ready == 0) {
+                starved = true;
+                std::unique_lock<std::mutex> lock(param->wait_lock);
+                param->wait_cond.wait_for(lock, std::chrono::milliseconds(10), [param] {
+                    return !param->running || param->ring.readable() >= (size_t)param->frame_bytes;
+                });
+                continue;
+            }
+            snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm);
+            if (avail < 0) {
+                _xrun_recover(param, avail, !starved);
+                continue;
+            }
+            starved = false;
+            if ((snd_pcm_uframes_t)avail < std::min(ready, param->period_size)) {
+                int res = snd_pcm_wait(pcm, 100);
+                if (res < 0)
+                    _xrun_recover(param, res, true);
+                continue;
+            }
+            snd_pcm_uframes_t frames = std::min((snd_pcm_uframes_t)avail, ready);
+            int res = 0;
+            while (frames > 0) {
+                snd_pcm_uframes_t offset = 0, size = frames;
+                const snd_pcm_channel_area_t *areas;
+                if (param->mmap) {
+                    if ((res = snd_pcm_mmap_begin(pcm, &areas, &offset, &size)) < 0)
+                        break;
+                    param->ring.read(_area_ptr(areas, offset), size * param->frame_bytes);
+                    snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, size);
+                    if (committed < 0 || (snd_pcm_uframes_t)committed != size) {
+                        res = committed < 0 ? committed : -EPIPE;
+                        break;
+                    }
+                } else {
+                    size = std::min(size, param->period_size);
+                    param->ring.read(buffer.data(), size * param->frame_bytes);
+                    snd_pcm_sframes_t n = snd_pcm_writei(pcm, buffer.data(), size);
+                    if (n < 0) {
+                        res = n;
+                        break;
+                    }
+                    size = n;
+                }
+                frames -= size;
+            }
+            if (res < 0)
+                _xrun_recover(param, res, true);
+            // data shorter than start threshold never auto starts
+            if (param->ring.readable() < (size_t)param->frame_bytes && snd_pcm_state(pcm) == SND_PCM_STATE_PREPARED)
+                snd_pcm_start(pcm);
+            _notify(param);
+        }
+    }
+
+    static void _worker_start(audio_param_t *param)
+    {
+        if (param->running)
+            return;
+        param->running = true;
+        if (param->stream == SND_PCM_STREAM_CAPTURE)
+            param->thread = std::thread(_capture_loop, param);
+        else
+            param->thread = std::thread(_playback_loop, param);
+    }
+
+    // drain: playback only, wait until all queued data played
+    static void _worker_stop(audio_param_t *param, bool drain)
+    {
+        if (drain && param->running) {
+            uint64_t timeout = time::ticks_ms() + 1000 + (uint64_t)param->ring.capacity() * 1000 / param->frame_bytes / param->sample_rate;
+            while (param->ring.readable() >= (size_t)param->frame_bytes && time::ticks_ms() < timeout && !app::need_exit()) {
+                std::unique_lock<std::mutex> lock(param->wait_lock);
+                param->wait_cond.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+        if (param->running) {
+            param->running = false;
+            _notify(param);
+            param->thread.join();
+        }
+        snd_pcm_state_t state = snd_pcm_state(param->pcm);
+        if (drain && (state == SND_PCM_STATE_RUNNING || state == SND_PCM_STATE_PREPARED))
+            snd_pcm_drain(param->pcm);
+        snd_pcm_drop(param->pcm);
+        snd_pcm_prepare(param->pcm);
+        param->ring.clear();
+    }
+
+    static void _pcm_close(audio_param_t *param)
+    {
+        if (param->pcm) {
+            if (param->xruns || param->dropped_frames)
+                log::info("pcm %s closed, xruns: %llu, dropped frames: %llu", param->device.c_str(),
+                          (unsigned long long)param->xruns, (unsigned long long)param->dropped_frames);
+            snd_pcm_close(param->pcm);
+            param->pcm = nullptr;
+        }
+        if (param->file) {
+            fclose(param->file);
+            param->file = nullptr;
+        }
+    }
+
+    // software volume, for devices without mixer control, such as snd-aloop
+    static void _apply_volume(audio_param_t *param, uint8_t *data, int size)
+    {
+        if (param->volume == 100 && !param->mute)
+            return;
+        float scale = param->mute ? 0 : param->volume / 100.0f;
+        int sample_bytes = fmt_bits[param->format] / 8;
+        int samples = size / sample_bytes;
+        float buffer[256];
+        for (int i = 0; i < samples; i += 256) {
+            int n = std::min(256, samples - i);
+            uint8_t *p = data + i * sample_bytes;
+            audio::to_float(p, param->format, buffer, n);
+            for (int j = 0; j < n; j ++)
+                buffer[j] *= scale;
+            audio::from_float(buffer, param->format, p, n);
+        }
+    }
+
+    Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel, bool block) {
+        if (path.size() > 0) {
+            if (fs::splitext(path)[1] != ".wav"
+                && fs::splitext(path)[1] != ".pcm") {
+                err::check_raise(err::ERR_RUNTIME, "Only files with the `.pcm` and `.wav` extensions are supported.");
+            }
+        }
+        audio_param_t *param = new audio_param_t();
+        err::check_null_raise(param, "malloc failed");
+        param->path = path;
+        param->block = block;
+        param->sample_rate = sample_rate;
+        param->format = format;
+        param->channel = channel;
+        try {
+            _pcm_open(param, SND_PCM_STREAM_CAPTURE, ENV_CAPTURE_DEVICE);
+        } catch (...) {
+            delete param;
+            throw;
+        }
+        _param = param;
+    }
+
+    Recorder::~Recorder() {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (param) {
+            _worker_stop(param, false);
+            _pcm_close(param);
+            delete param;
+            _param = nullptr;
+        }
+    }
+
+    int Recorder::volume(int value) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (value >= 0) {
+            param->volume = value > 100 ? 100 : value;
+        }
+        return param->volume;
+    }
+
+    void Recorder::reset(bool start) {
+        audio_param_t *param = (audio_param_t *)_param;
+        _worker_stop(param, false);
+        if (start) {
+            _worker_start(param);
+        }
+    }
+
+    maix::Bytes *Recorder::record(int record_ms) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (record_ms < 0) {
+            return record_bytes(record_ms);
+        } else {
+            int record_frames = (int64_t)record_ms * param->sample_rate / 1000;
+            return record_bytes(record_frames * param->frame_bytes);
+        }
+    }
+
+    int Recorder::frame_size(int frame_count) {
+        audio_param_t *param = (audio_param_t *)_param;
+        frame_count = frame_count <= 0 ? 1 : frame_count;
+        return frame_count * param->frame_bytes;
+    }
+
+    int Recorder::get_remaining_frames() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->ring.readable() / param->frame_bytes;
+    }
+
+    int Recorder::period_size(int period_size) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (period_size > 0) {
+            bool running = param->running;
+            _worker_stop(param, false);
+            err::Err e = _pcm_config(param, period_size, param->period_count);
+            err::check_raise(e, "Set audio config failed");
+            if (running)
+                _worker_start(param);
+        }
+        return param->period_size;
+    }
+
+    int Recorder::period_count(int period_count) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (period_count > 0) {
+            bool running = param->running;
+            _worker_stop(param, false);
+            err::Err e = _pcm_config(param, param->period_size, period_count);
+            err::check_raise(e, "Set audio config failed");
+            if (running)
+                _worker_start(param);
+        }
+        return param->period_count;
+    }
+
+    maix::Bytes *Recorder::record_bytes(int record_size) {
+        audio_param_t *param = (audio_param_t *)_param;
+
+        if (param->file == nullptr && param->path.size() > 0) {
+            param->file = fopen(param->path.c_str(), "w+");
+            err::check_null_raise(param->file, "Open file failed!");
+
+            if (fs::splitext(param->path)[1] == ".wav") {
+                wav_header_t header = {
+                    .file_size = 44,
+                    .channel = param->channel,
+                    .sample_rate = param->sample_rate,
+                    .sample_bit = fmt_bits[param->format],
+                    .bitrate = param->frame_bytes * param->sample_rate,
+                    .data_size = 0,
+                };
+
+                uint8_t buffer[44];
+                if (0 != _create_wav_header(&header, buffer, sizeof(buffer))) {
+                    err::check_raise(err::ERR_RUNTIME, "create wav failed!");
+                }
+
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), param->file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav header failed!");
+                }
+            }
+        }
+
+        // capture starts on first read if reset() not called
+        _worker_start(param);
+
+        int remaining_bytes = get_remaining_frames() * param->frame_bytes;
+        if (record_size < 0) {
+            record_size = remaining_bytes;
+        } else {
+            record_size = record_size / param->frame_bytes * param->frame_bytes;
+            if (!param->block && record_size > remaining_bytes) {
+                record_size = remaining_bytes;
+            }
+        }
+        if (record_size == 0) {
+            return new Bytes();
+        }
+
+        auto out_bytes = new Bytes(nullptr, record_size);
+        err::check_null_raise(out_bytes, "Create new bytes failed!");
+        size_t read_len = 0;
+        while (read_len < (size_t)record_size && !app::need_exit()) {
+            read_len += param->ring.read(out_bytes->data + read_len, record_size - read_len);
+            if (read_len < (size_t)record_size) {
+                std::unique_lock<std::mutex> lock(param->wait_lock);
+                param->wait_cond.wait_for(lock, std::chrono::milliseconds(100), [param] {
+                    return param->ring.readable() > 0;
+                });
+            }
+        }
+        out_bytes->data_len = read_len;
+        _apply_volume(param, out_bytes->data, out_bytes->data_len);
+
+        if (param->file)
+            fwrite(out_bytes->data, 1, out_bytes->data_len, param->file);
+
+        return out_bytes;
+    }
+
+    bool Recorder::mute(int data) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (data >= 0) {
+            param->mute = data != 0;
+        }
+        return param->mute;
+    }
+
+    err::Err Recorder::finish() {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (param->file) {
+            if (fs::splitext(param->path)[1] == ".wav") {
+                int file_size = ftell(param->file);
+                int pcm_size = file_size - 44;
+                char buffer[4];
+                buffer[0] = (uint8_t)((file_size - 8) & 0xff);
+                buffer[1] = (uint8_t)(((file_size - 8) >> 8) & 0xff);
+                buffer[2] = (uint8_t)(((file_size - 8) >> 16) & 0xff);
+                buffer[3] = (uint8_t)(((file_size - 8) >> 24) & 0xff);
+
+                fseek(param->file, 4, 0);
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), param->file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav file size failed!");
+                }
+
+                buffer[0] = (uint8_t)((pcm_size) & 0xff);
+                buffer[1] = (uint8_t)(((pcm_size) >> 8) & 0xff);
+                buffer[2] = (uint8_t)(((pcm_size) >> 16) & 0xff);
+                buffer[3] = (uint8_t)(((pcm_size) >> 24) & 0xff);
+                fseek(param->file, 40, 0);
+                if (sizeof(buffer) != fwrite(buffer, 1, sizeof(buffer), param->file)) {
+                    err::check_raise(err::ERR_RUNTIME, "write wav data size failed!");
+                }
+            }
+
+            fflush(param->file);
+            fclose(param->file);
+            param->file = NULL;
+        }
+
+        return err::ERR_NONE;
+    }
+
+    int Recorder::sample_rate() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->sample_rate;
+    }
+
+    audio::Format Recorder::format() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->format;
+    }
+
+    int Recorder::channel() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->channel;
+    }
+
+    maix::Bytes *Player::NoneBytes = new maix::Bytes();
+
+    Player::Player(std::string path, int sample_rate, audio::Format format, int channel, bool block) {
+        if (path.size() > 0) {
+            if (fs::splitext(path)[1] != ".wav"
+                && fs::splitext(path)[1] != ".pcm") {
+                err::check_raise(err::ERR_RUNTIME, "Only files with the `.pcm` and `.wav` extensions are supported.");
+            }
+        }
+        FILE *new_file = nullptr;
+        wav_header_t wav_header = {};
+        if (path.size() > 0) {
+            new_file = fopen(path.c_str(), "rb");
+            err::check_null_raise(new_file, "Open file failed!");
+
+            if (fs::splitext(path)[1] == ".wav") {
+                uint8_t buffer[44];
+
+                if (sizeof(buffer) != fread(buffer, 1, sizeof(buffer), new_file)) {
+                    fclose(new_file);
+                    err::check_raise(err::ERR_RUNTIME, "read wav header failed!");
+                }
+
+                if (0 != _read_wav_header(&wav_header, buffer, sizeof(buffer))) {
+                    fclose(new_file);
+                    err::check_raise(err::ERR_RUNTIME, "parse wav header failed!");
+                }
+
+                sample_rate = wav_header.sample_rate;
+                channel = wav_header.channel;
+                format = _wav_sample_bit_to_format(wav_header.sample_bit);
+            }
+        }
+
+        audio_param_t *param = new audio_param_t();
+        err::check_null_raise(param, "malloc failed");
+        memcpy(&param->wav_header, &wav_header, sizeof(wav_header));
+        param->file = new_file;
+        param->path = path;
+        param->block = block;
+        param->sample_rate = sample_rate;
+        param->format = format;
+        param->channel = channel;
+        try {
+            _pcm_open(param, SND_PCM_STREAM_PLAYBACK, ENV_PLAYBACK_DEVICE);
+        } catch (...) {
+            if (param->file)
+                fclose(param->file);
+            delete param;
+            throw;
+        }
+        _worker_start(param);
+        _param = param;
+    }
+
+    Player::~Player() {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (param) {
+            // let queued audio finish like writing to device directly
+            _worker_stop(param, param->block);
+            _pcm_close(param);
+            delete param;
+            _param = nullptr;
+        }
+    }
+
+    int Player::volume(int value) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (value >= 0) {
+            param->volume = value > 100 ? 100 : value;
+        }
+        return param->volume;
+    }
+
+    // queue data to ring, block mode waits for free space,
+    // non-block mode queues all data or nothing and returns err::ERR_BUFF_FULL, so caller can retry the same data.
+    static err::Err _play_queue(audio_param_t *param, const uint8_t *data, size_t size)
+    {
+        uint8_t buffer[4096];
+        size = size / param->frame_bytes * param->frame_bytes;
+        // only play() writes ring, free space only grows after the check
+        if (!param->block && param->ring.writable() < size) {
+            return err::ERR_BUFF_FULL;
+        }
+        while (size > 0 && !app::need_exit()) {
+            size_t n = std::min(size, param->ring.writable() / param->frame_bytes * param->frame_bytes);
+            if (n == 0) {
+                if (!param->block) {
+                    return err::ERR_BUFF_FULL;
+                }
+                std::unique_lock<std::mutex> lock(param->wait_lock);
+                param->wait_cond.wait_for(lock, std::chrono::milliseconds(100), [param] {
+                    return param->ring.writable() >= (size_t)param->frame_bytes || !param->running;
+                });
+                continue;
+            }
+            if (param->volume != 100 || param->mute) {
+                n = std::min(n, sizeof(buffer) / param->frame_bytes * param->frame_bytes);
+                memcpy(buffer, data, n);
+                _apply_volume(param, buffer, n);
+                param->ring.write(buffer, n);
+            } else {
+                param->ring.write(data, n);
+            }
+            _notify(param);
+            data += n;
+            size -= n;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err Player::play(maix::Bytes *data) {
+        audio_param_t *param = (audio_param_t *)_param;
+        _worker_start(param);
+
+        if (!data || !data->data || !data->size()) {
+            if (param->path.size() == 0) {
+                return err::ERR_ARGS;
+            }
+            if (param->file == NULL) {
+                param->file = fopen(param->path.c_str(), "rb");
+                err::check_null_raise(param->file, "Open file failed!");
+            }
+            if (!param->file_playing) {
+                fseek(param->file, fs::splitext(param->path)[1] == ".wav" ? 44 : 0, 0);
+                param->file_playing = true;
+            }
+
+            int read_len = 0;
+            uint8_t buffer[4096];
+            size_t buffer_size = sizeof(buffer) / param->frame_bytes * param->frame_bytes;
+            while ((read_len = fread(buffer, 1, buffer_size, param->file)) > 0 && !app::need_exit()) {
+                err::Err e = _play_queue(param, buffer, read_len);
+                if (e != err::ERR_NONE) {
+                    // chunk not queued, next play() retries it, chunks queued before are not played again
+                    fseek(param->file, -read_len, SEEK_CUR);
+                    return e;
+                }
+            }
+            param->file_playing = false;
+            return err::ERR_NONE;
+        }
+        return _play_queue(param, data->data, data->data_len);
+    }
+
+    int Player::frame_size(int frame_count) {
+        audio_param_t *param = (audio_param_t *)_param;
+        frame_count = frame_count <= 0 ? 1 : frame_count;
+        return frame_count * param->frame_bytes;
+    }
+
+    int Player::get_remaining_frames() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->ring.writable() / param->frame_bytes;
+    }
+
+    int Player::period_size(int period_size) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (period_size > 0) {
+            _worker_stop(param, true);
+            err::Err e = _pcm_config(param, period_size, param->period_count);
+            err::check_raise(e, "Set audio config failed");
+            _worker_start(param);
+        }
+        return param->period_size;
+    }
+
+    int Player::period_count(int period_count) {
+        audio_param_t *param = (audio_param_t *)_param;
+        if (period_count > 0) {
+            _worker_stop(param, true);
+            err::Err e = _pcm_config(param, param->period_size, period_count);
+            err::check_raise(e, "Set audio config failed");
+            _worker_start(param);
+        }
+        return param->period_count;
+    }
+
+    void Player::reset(bool start) {
+        audio_param_t *param = (audio_param_t *)_param;
+        // drop queued data, playback starts automatically when new data queued, so start is not needed
+        (void)start;
+        _worker_stop(param, false);
+        _worker_start(param);
+    }
+
+    int Player::sample_rate() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->sample_rate;
+    }
+
+    audio::Format Player::format() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->format;
+    }
+
+    int Player::channel() {
+        audio_param_t *param = (audio_param_t *)_param;
+        return param->channel;
+    }
+} // namespace maix::audio
+#else // HAVE_ALSA
+// libasound not found when build, see CMakeLists.txt
 namespace maix::audio
 {
     Recorder::Recorder(std::string path, int sample_rate, audio::Format format, int channel, bool block) {
@@ -152,4 +1151,5 @@ namespace maix::audio
     int Player::channel() {
         return 0;
     }
-} // namespace maix::audio
\ No newline at end of file
+} // namespace maix::audio
+#endif // HAVE_ALSA
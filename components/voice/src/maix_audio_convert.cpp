@@ -0,0 +1,683 @@
+/**
+ * @author neucrack@sipeed
+ * @copyright Sipeed Ltd 2023-
+ * @license Apache 2.0
+ * @update 2026.10.18: Add sample format, channel conversion and streaming resampler, create this file.
+ */
+
+#include "maix_audio.hpp"
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace maix::audio
+{
+    static const int CONVERT_BLOCK = 256;       // samples converted on stack each time
+    static const int RESAMPLER_MAX_PHASES = 512; // more phases are interpolated from a table of this size
+    static const double KAISER_BETA = 8.6;      // about 80dB stop band attenuation
+    static const float RESAMPLER_ROLLOFF = 0.95f;
+
+    static inline uint16_t _bswap16(uint16_t v) { return __builtin_bswap16(v); }
+    static inline uint32_t _bswap32(uint32_t v) { return __builtin_bswap32(v); }
+
+    template <typename T>
+    static inline T _load(const uint8_t *p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    template <typename T>
+    static inline void _store(uint8_t *p, T v)
+    {
+        memcpy(p, &v, sizeof(T));
+    }
+
+    static inline int32_t _round_clamp(float v, float scale, int32_t min, int32_t max)
+    {
+        float x = v * scale;
+        if (x <= (float)min)
+            return min;
+        if (x >= (float)max)
+            return max;
+        return (int32_t)lrintf(x);
+    }
+
+    static void _s16_to_float(const uint8_t *src, float *dst, int n)
+    {
+        int i = 0;
+#if defined(__aarch64__)
+        const float32x4_t scale = vdupq_n_f32(1.0f / 32768);
+        for (; i + 8 <= n; i += 8)
+        {
+            int16x8_t v = vld1q_s16((const int16_t *)(src + i * 2));
+            vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+            vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+        }
+#endif
+        for (; i < n; ++i)
+            dst[i] = _load<int16_t>(src + i * 2) * (1.0f / 32768);
+    }
+
+    static void _float_to_s16(const float *src, uint8_t *dst, int n)
+    {
+        int i = 0;
+#if defined(__aarch64__)
+        const float32x4_t scale = vdupq_n_f32(32768.0f);
+        for (; i + 8 <= n; i += 8)
+        {
+            // saturating narrow clamps to int16 range
+            int32x4_t a = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(src + i), scale));
+            int32x4_t b = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(src + i + 4), scale));
+            vst1q_s16((int16_t *)(dst + i * 2), vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+        }
+#endif
+        for (; i < n; ++i)
+            _store<int16_t>(dst + i * 2, (int16_t)_round_clamp(src[i], 32768.0f, -32768, 32767));
+    }
+
+    err::Err to_float(const void *src, audio::Format format, float *dst, int samples)
+    {
+        const uint8_t *s = (const uint8_t *)src;
+        if (!src || !dst || samples < 0)
+            return err::ERR_ARGS;
+        switch (format)
+        {
+        case FMT_S8:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = (int8_t)s[i] * (1.0f / 128);
+            break;
+        case FMT_U8:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = ((int)s[i] - 128) * (1.0f / 128);
+            break;
+        case FMT_S16_LE:
+            _s16_to_float(s, dst, samples);
+            break;
+        case FMT_S16_BE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = (int16_t)_bswap16(_load<uint16_t>(s + i * 2)) * (1.0f / 32768);
+            break;
+        case FMT_U16_LE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = ((int)_load<uint16_t>(s + i * 2) - 32768) * (1.0f / 32768);
+            break;
+        case FMT_U16_BE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = ((int)_bswap16(_load<uint16_t>(s + i * 2)) - 32768) * (1.0f / 32768);
+            break;
+        case FMT_S24_LE:
+            for (int i = 0; i < samples; ++i)
+            {
+                const uint8_t *p = s + i * 3;
+                int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+                dst[i] = v * (1.0f / 8388608);
+            }
+            break;
+        case FMT_S32_LE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = _load<int32_t>(s + i * 4) * (1.0f / 2147483648.0f);
+            break;
+        case FMT_S32_BE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = (int32_t)_bswap32(_load<uint32_t>(s + i * 4)) * (1.0f / 2147483648.0f);
+            break;
+        case FMT_U32_LE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = (int32_t)(_load<uint32_t>(s + i * 4) ^ 0x80000000u) * (1.0f / 2147483648.0f);
+            break;
+        case FMT_U32_BE:
+            for (int i = 0; i < samples; ++i)
+                dst[i] = (int32_t)(_bswap32(_load<uint32_t>(s + i * 4)) ^ 0x80000000u) * (1.0f / 2147483648.0f);
+            break;
+        case FMT_F32_LE:
+            if ((const void *)dst != src)
+                memmove(dst, src, samples * sizeof(float));
+            break;
+        default:
+            return err::ERR_ARGS;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err from_float(const float *src, audio::Format format, void *dst, int samples)
+    {
+        uint8_t *d = (uint8_t *)dst;
+        if (!src || !dst || samples < 0)
+            return err::ERR_ARGS;
+        switch (format)
+        {
+        case FMT_S8:
+            for (int i = 0; i < samples; ++i)
+                d[i] = (uint8_t)(int8_t)_round_clamp(src[i], 128.0f, -128, 127);
+            break;
+        case FMT_U8:
+            for (int i = 0; i < samples; ++i)
+                d[i] = (uint8_t)(_round_clamp(src[i], 128.0f, -128, 127) + 128);
+            break;
+        case FMT_S16_LE:
+            _float_to_s16(src, d, samples);
+            break;
+        case FMT_S16_BE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint16_t>(d + i * 2, _bswap16((uint16_t)_round_clamp(src[i], 32768.0f, -32768, 32767)));
+            break;
+        case FMT_U16_LE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint16_t>(d + i * 2, (uint16_t)(_round_clamp(src[i], 32768.0f, -32768, 32767) + 32768));
+            break;
+        case FMT_U16_BE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint16_t>(d + i * 2, _bswap16((uint16_t)(_round_clamp(src[i], 32768.0f, -32768, 32767) + 32768)));
+            break;
+        case FMT_S24_LE:
+            for (int i = 0; i < samples; ++i)
+            {
+                int32_t v = _round_clamp(src[i], 8388608.0f, -8388608, 8388607);
+                uint8_t *p = d + i * 3;
+                p[0] = v & 0xFF;
+                p[1] = (v >> 8) & 0xFF;
+                p[2] = (v >> 16) & 0xFF;
+            }
+            break;
+        case FMT_S32_LE:
+            for (int i = 0; i < samples; ++i)
+                _store<int32_t>(d + i * 4, _round_clamp(src[i], 2147483648.0f, INT32_MIN, INT32_MAX));
+            break;
+        case FMT_S32_BE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint32_t>(d + i * 4, _bswap32((uint32_t)_round_clamp(src[i], 2147483648.0f, INT32_MIN, INT32_MAX)));
+            break;
+        case FMT_U32_LE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint32_t>(d + i * 4, (uint32_t)_round_clamp(src[i], 2147483648.0f, INT32_MIN, INT32_MAX) ^ 0x80000000u);
+            break;
+        case FMT_U32_BE:
+            for (int i = 0; i < samples; ++i)
+                _store<uint32_t>(d + i * 4, _bswap32((uint32_t)_round_clamp(src[i], 2147483648.0f, INT32_MIN, INT32_MAX) ^ 0x80000000u));
+            break;
+        case FMT_F32_LE:
+            for (int i = 0; i < samples; ++i)
+                _store<float>(d + i * 4, std::max(-1.0f, std::min(1.0f, src[i])));
+            break;
+        default:
+            return err::ERR_ARGS;
+        }
+        return err::ERR_NONE;
+    }
+
+    err::Err convert_format(const void *src, audio::Format src_format, void *dst, audio::Format dst_format, int samples)
+    {
+        if (src_format <= FMT_NONE || src_format >= (int)fmt_bits.size() || dst_format <= FMT_NONE || dst_format >= (int)fmt_bits.size())
+            return err::ERR_ARGS;
+        if (src_format == dst_format)
+        {
+            if (src != dst)
+                memmove(dst, src, (size_t)samples * fmt_bits[src_format] / 8);
+            return err::ERR_NONE;
+        }
+        // S16 <-> S32 are common for microphones, convert directly without precision loss
+        if (src_format == FMT_S32_LE && dst_format == FMT_S16_LE)
+        {
+            const uint8_t *s = (const uint8_t *)src;
+            uint8_t *d = (uint8_t *)dst;
+            for (int i = 0; i < samples; ++i)
+            {
+                int32_t v = _load<int32_t>(s + i * 4);
+                int32_t r = (int32_t)(((int64_t)v + 0x8000) >> 16);
+                _store<int16_t>(d + i * 2, (int16_t)std::min(r, 32767));
+            }
+            return err::ERR_NONE;
+        }
+        int src_bytes = fmt_bits[src_format] / 8, dst_bytes = fmt_bits[dst_format] / 8;
+        if (src_format == FMT_S16_LE && dst_format == FMT_S32_LE && (src != dst))
+        {
+            const uint8_t *s = (const uint8_t *)src;
+            uint8_t *d = (uint8_t *)dst;
+            for (int i = 0; i < samples; ++i)
+                _store<int32_t>(d + i * 4, (int32_t)_load<int16_t>(s + i * 2) * 65536);
+            return err::ERR_NONE;
+        }
+        if (src == dst && dst_bytes > src_bytes)
+            return err::ERR_ARGS;
+        float buf[CONVERT_BLOCK];
+        for (int i = 0; i < samples; i += CONVERT_BLOCK)
+        {
+            int n = std::min(CONVERT_BLOCK, samples - i);
+            err::Err e = to_float((const uint8_t *)src + (size_t)i * src_bytes, src_format, buf, n);
+            if (e != err::ERR_NONE)
+                return e;
+            e = from_float(buf, dst_format, (uint8_t *)dst + (size_t)i * dst_bytes, n);
+            if (e != err::ERR_NONE)
+                return e;
+        }
+        return err::ERR_NONE;
+    }
+
+    void mix_channels(const float *src, int src_channels, float *dst, int dst_channels, int frames)
+    {
+        if (src_channels == dst_channels)
+        {
+            memcpy(dst, src, (size_t)frames * src_channels * sizeof(float));
+        }
+        else if (dst_channels == 1)
+        {
+            float scale = 1.0f / src_channels;
+            if (src_channels == 2)
+            {
+                for (int i = 0; i < frames; ++i)
+                    dst[i] = (src[i * 2] + src[i * 2 + 1]) * 0.5f;
+                return;
+            }
+            for (int i = 0; i < frames; ++i)
+            {
+                const float *s = src + i * src_channels;
+                float sum = 0;
+                for (int c = 0; c < src_channels; ++c)
+                    sum += s[c];
+                dst[i] = sum * scale;
+            }
+        }
+        else if (dst_channels < src_channels)
+        {
+            for (int i = 0; i < frames; ++i)
+            {
+                const float *s = src + i * src_channels;
+                float *d = dst + i * dst_channels;
+                for (int c = 0; c < dst_channels; ++c)
+                {
+                    float sum = 0;
+                    int n = 0;
+                    for (int k = c; k < src_channels; k += dst_channels, ++n)
+                        sum += s[k];
+                    d[c] = sum / n;
+                }
+            }
+        }
+        else
+        {
+            for (int i = 0; i < frames; ++i)
+            {
+                const float *s = src + i * src_channels;
+                float *d = dst + i * dst_channels;
+                for (int c = 0; c < dst_channels; ++c)
+                    d[c] = s[c % src_channels];
+            }
+        }
+    }
+
+    static inline float _dot(const float *a, const float *b, int n)
+    {
+        int i = 0;
+#if defined(__aarch64__)
+        float32x4_t acc0 = vdupq_n_f32(0), acc1 = vdupq_n_f32(0);
+        for (; i + 8 <= n; i += 8)
+        {
+            acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+            acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#else
+        // 4 accumulators let compiler vectorize and hide FMA latency
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            s0 += a[i] * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+        float sum = (s0 + s1) + (s2 + s3);
+#endif
+        for (; i < n; ++i)
+            sum += a[i] * b[i];
+        return sum;
+    }
+
+    static double _bessel_i0(double x)
+    {
+        double sum = 1, term = 1, y = x * x / 4;
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= y / ((double)k * k);
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    struct ResamplerImpl
+    {
+        int channels;
+        int up;         // output rate / gcd
+        int down;       // input rate / gcd
+        int half;       // filter half length in input samples
+        int taps;       // 2 * half
+        int phases;     // rows in table
+        bool interp;    // phases < up, interpolate between rows
+        std::vector<float> table;           // (phases + 1) * taps, row p is filter for fraction p / phases
+        std::vector<float> row;             // interpolated row
+        std::vector<std::vector<float>> buf;// input history per channel, planar
+        int64_t pos;    // index in buf of current output's integer input position
+        int phase;      // fraction of current output position, phase / up
+        int64_t in_total;
+        int64_t out_total;
+
+        void reset()
+        {
+            buf.assign(channels, std::vector<float>(half - 1, 0.0f));
+            pos = half - 1;
+            phase = 0;
+            in_total = 0;
+            out_total = 0;
+        }
+
+        const float *get_row(int p)
+        {
+            if (!interp)
+                return &table[(size_t)p * taps];
+            double f = (double)p * phases / up;
+            int idx = (int)f;
+            float a = (float)(f - idx);
+            const float *r0 = &table[(size_t)idx * taps];
+            const float *r1 = r0 + taps;
+            for (int j = 0; j < taps; ++j)
+                row[j] = r0[j] + (r1[j] - r0[j]) * a;
+            return row.data();
+        }
+
+        int run(const float *in, int frames, std::vector<float> &out, int64_t max_out = -1)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                std::vector<float> &b = buf[c];
+                size_t old = b.size();
+                b.resize(old + frames);
+                for (int i = 0; i < frames; ++i)
+                    b[old + i] = in[(size_t)i * channels + c];
+            }
+            int64_t avail = (int64_t)buf[0].size();
+
+            // count outputs first, so output buffer is allocated once
+            int64_t n = 0;
+            {
+                int64_t p = pos;
+                int ph = phase;
+                while (p + half < avail)
+                {
+                    ++n;
+                    ph += down;
+                    p += ph / up;
+                    ph %= up;
+                }
+            }
+            if (max_out >= 0)
+                n = std::min(n, max_out);
+            out.resize((size_t)n * channels);
+            for (int64_t k = 0; k < n; ++k)
+            {
+                const float *h = get_row(phase);
+                int64_t start = pos - half + 1;
+                for (int c = 0; c < channels; ++c)
+                    out[(size_t)k * channels + c] = _dot(&buf[c][start], h, taps);
+                phase += down;
+                pos += phase / up;
+                phase %= up;
+            }
+            // drop history not needed any more
+            int64_t keep_from = std::min(pos - half + 1, avail);
+            if (keep_from > 0)
+            {
+                for (int c = 0; c < channels; ++c)
+                    buf[c].erase(buf[c].begin(), buf[c].begin() + keep_from);
+                pos -= keep_from;
+            }
+            out_total += n;
+            return (int)n;
+        }
+    };
+
+    Resampler::Resampler(int in_rate, int out_rate, int channels, int quality)
+    {
+        if (in_rate <= 0 || out_rate <= 0 || channels <= 0 || quality <= 0)
+            throw err::Exception(err::ERR_ARGS, "resampler args invalid");
+        ResamplerImpl *impl = new ResamplerImpl();
+        int g = std::gcd(in_rate, out_rate);
+        impl->channels = channels;
+        impl->up = out_rate / g;
+        impl->down = in_rate / g;
+        // cutoff relative to input nyquist, lower than output nyquist when down sampling
+        double fc = std::min(1.0, (double)impl->up / impl->down) * RESAMPLER_ROLLOFF;
+        impl->half = std::max(2, (int)ceil(quality / fc));
+        impl->taps = impl->half * 2;
+        impl->interp = impl->up > RESAMPLER_MAX_PHASES;
+        impl->phases = impl->interp ? RESAMPLER_MAX_PHASES : impl->up;
+        impl->table.resize((size_t)(impl->phases + 1) * impl->taps);
+        impl->row.resize(impl->taps);
+        double i0_beta = _bessel_i0(KAISER_BETA);
+        for (int p = 0; p <= impl->phases; ++p)
+        {
+            double frac = (double)p / impl->phases;
+            float *r = &impl->table[(size_t)p * impl->taps];
+            double sum = 0;
+            for (int j = 0; j < impl->taps; ++j)
+            {
+                // distance from output position to input sample start + j, in input samples
+                double x = frac + impl->half - 1 - j;
+                double sinc = x == 0 ? 1.0 : sin(M_PI * fc * x) / (M_PI * fc * x);
+                double w = x / impl->half;
+                double win = fabs(w) >= 1 ? 0 : _bessel_i0(KAISER_BETA * sqrt(1 - w * w)) / i0_beta;
+                r[j] = (float)(fc * sinc * win);
+                sum += r[j];
+            }
+            // unity DC gain for every phase
+            for (int j = 0; j < impl->taps; ++j)
+                r[j] = (float)(r[j] / sum);
+        }
+        impl->reset();
+        _impl = impl;
+    }
+
+    Resampler::~Resampler()
+    {
+        delete (ResamplerImpl *)_impl;
+    }
+
+    int Resampler::process(const float *in, int frames, std::vector<float> &out)
+    {
+        ResamplerImpl *impl = (ResamplerImpl *)_impl;
+        if (!in || frames <= 0)
+        {
+            out.clear();
+            return 0;
+        }
+        impl->in_total += frames;
+        return impl->run(in, frames, out);
+    }
+
+    int Resampler::flush(std::vector<float> &out)
+    {
+        ResamplerImpl *impl = (ResamplerImpl *)_impl;
+        // total output of a stream is ceil(in_total * up / down)
+        int64_t expect = (impl->in_total * impl->up + impl->down - 1) / impl->down;
+        std::vector<float> zeros((size_t)(impl->half + 1) * impl->channels, 0.0f);
+        int n = impl->run(zeros.data(), impl->half + 1, out, std::max((int64_t)0, expect - impl->out_total));
+        impl->reset();
+        return n;
+    }
+
+    void Resampler::reset()
+    {
+        ((ResamplerImpl *)_impl)->reset();
+    }
+
+    int Resampler::latency()
+    {
+        return ((ResamplerImpl *)_impl)->half;
+    }
+
+    struct ConverterImpl
+    {
+        int in_rate, out_rate;
+        audio::Format in_format, out_format;
+        int in_channels, out_channels;
+        int in_frame_bytes;
+        Resampler *resampler = nullptr;
+        std::vector<uint8_t> carry;     // partial input frame
+        std::vector<float> in_f;        // input as float
+        std::vector<float> mixed;
+        std::vector<float> resampled;
+        std::vector<float> out_f;
+
+        // channel conversion before resample if it reduces channels, after resample otherwise
+        int mix_channels_first() { return out_channels <= in_channels; }
+
+        int run(const void *in, int in_bytes, std::vector<float> &out)
+        {
+            const uint8_t *p = (const uint8_t *)in;
+            int frames = ((int)carry.size() + in_bytes) / in_frame_bytes;
+            in_f.resize((size_t)frames * in_channels);
+            int done = 0;
+            if (!carry.empty() && frames > 0)
+            {
+                int need = in_frame_bytes - (int)carry.size();
+                carry.insert(carry.end(), p, p + need);
+                to_float(carry.data(), in_format, in_f.data(), in_channels);
+                carry.clear();
+                p += need;
+                in_bytes -= need;
+                done = 1;
+            }
+            err::Err e = to_float(p, in_format, in_f.data() + (size_t)done * in_channels, (frames - done) * in_channels);
+            if (e != err::ERR_NONE)
+                return -e;
+            int used = (frames - done) * in_frame_bytes;
+            carry.insert(carry.end(), p + used, p + in_bytes);
+
+            const float *cur = in_f.data();
+            int ch = in_channels;
+            if (ch != out_channels && mix_channels_first())
+            {
+                mixed.resize((size_t)frames * out_channels);
+                mix_channels(cur, ch, mixed.data(), out_channels, frames);
+                cur = mixed.data();
+                ch = out_channels;
+            }
+            if (resampler)
+            {
+                frames = resampler->process(cur, frames, resampled);
+                cur = resampled.data();
+            }
+            if (ch != out_channels)
+            {
+                out.resize((size_t)frames * out_channels);
+                mix_channels(cur, ch, out.data(), out_channels, frames);
+            }
+            else
+                out.assign(cur, cur + (size_t)frames * ch);
+            return frames;
+        }
+
+        int flush(std::vector<float> &out)
+        {
+            carry.clear();
+            if (!resampler)
+            {
+                out.clear();
+                return 0;
+            }
+            int ch = mix_channels_first() ? out_channels : in_channels;
+            int frames = resampler->flush(resampled);
+            if (ch != out_channels)
+            {
+                out.resize((size_t)frames * out_channels);
+                mix_channels(resampled.data(), ch, out.data(), out_channels, frames);
+            }
+            else
+                out.assign(resampled.begin(), resampled.begin() + (size_t)frames * ch);
+            return frames;
+        }
+    };
+
+    Converter::Converter(int in_rate, audio::Format in_format, int in_channels, int out_rate, audio::Format out_format, int out_channels, int quality)
+    {
+        if (in_rate <= 0 || out_rate <= 0 || in_channels <= 0 || out_channels <= 0 ||
+            in_format <= FMT_NONE || in_format >= (int)fmt_bits.size() || out_format <= FMT_NONE || out_format >= (int)fmt_bits.size())
+            throw err::Exception(err::ERR_ARGS, "audio converter args invalid");
+        ConverterImpl *impl = new ConverterImpl();
+        impl->in_rate = in_rate;
+        impl->out_rate = out_rate;
+        impl->in_format = in_format;
+        impl->out_format = out_format;
+        impl->in_channels = in_channels;
+        impl->out_channels = out_channels;
+        impl->in_frame_bytes = fmt_bits[in_format] / 8 * in_channels;
+        if (in_rate != out_rate)
+            impl->resampler = new Resampler(in_rate, out_rate, impl->mix_channels_first() ? out_channels : in_channels, quality);
+        _impl = impl;
+    }
+
+    Converter::~Converter()
+    {
+        ConverterImpl *impl = (ConverterImpl *)_impl;
+        delete impl->resampler;
+        delete impl;
+    }
+
+    int Converter::process_float(const void *in, int in_bytes, std::vector<float> &out)
+    {
+        if (!in || in_bytes < 0)
+            return -err::ERR_ARGS;
+        return ((ConverterImpl *)_impl)->run(in, in_bytes, out);
+    }
+
+    int Converter::process(const void *in, int in_bytes, std::vector<uint8_t> &out)
+    {
+        ConverterImpl *impl = (ConverterImpl *)_impl;
+        int frames = process_float(in, in_bytes, impl->out_f);
+        if (frames < 0)
+            return frames;
+        int samples = frames * impl->out_channels;
+        out.resize((size_t)samples * fmt_bits[impl->out_format] / 8);
+        from_float(impl->out_f.data(), impl->out_format, out.data(), samples);
+        return frames;
+    }
+
+    maix::Bytes *Converter::process(maix::Bytes *in)
+    {
+        if (!in)
+            return nullptr;
+        std::vector<uint8_t> out;
+        if (process(in->data, in->data_len, out) < 0)
+            return nullptr;
+        return new maix::Bytes(out.data(), out.size());
+    }
+
+    int Converter::flush_float(std::vector<float> &out)
+    {
+        return ((ConverterImpl *)_impl)->flush(out);
+    }
+
+    int Converter::flush(std::vector<uint8_t> &out)
+    {
+        ConverterImpl *impl = (ConverterImpl *)_impl;
+        int frames = impl->flush(impl->out_f);
+        int samples = frames * impl->out_channels;
+        out.resize((size_t)samples * fmt_bits[impl->out_format] / 8);
+        from_float(impl->out_f.data(), impl->out_format, out.data(), samples);
+        return frames;
+    }
+
+    void Converter::reset()
+    {
+        ConverterImpl *impl = (ConverterImpl *)_impl;
+        impl->carry.clear();
+        if (impl->resampler)
+            impl->resampler->reset();
+    }
+} // namespace maix::audio
@@ -24,6 +24,7 @@ extern "C" {
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 static void helper(void)
 {
@@ -36,6 +37,9 @@ static void helper(void)
     "3 [path] [sample_rate] [channel] [format]: playback block, ./audio_demo 3 output.pcm\r\n"
     "4 [path] [sample_rate] [channel] [format]: playback nonblock, ./audio_demo 4 output.pcm 48000 1 2\r\n"
     "5 [volumn]: set player volume(0 ~ 100), ./audio_demo 5 12\r\n"
+    "6 [seconds] [period_size] [period_count]: play 1kHz tone and record at the same time, ./audio_demo 6 5 256 4\r\n"
+    "   on linux, test with snd-aloop: modprobe snd-aloop, then set env\r\n"
+    "   MAIX_AUDIO_PLAYBACK_DEVICE=hw:Loopback,0,0 MAIX_AUDIO_CAPTURE_DEVICE=hw:Loopback,1,0\r\n"
     "\r\n"
     "Note: format = 2, means FMT_S16_LE\r\n"
     "==================================\r\n");
@@ -44,10 +48,6 @@ static void helper(void)
 
 int _main(int argc, char* argv[])
 {
-#if PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2
-// FIXME: only for maixcam/maixcam2, this is a ugly example
-// comment for linux platform for now to make CI pass
-
     int cmd = 0;
     if (argc > 1) {
         if (!strcmp("-h", argv[1])) {
@@ -274,12 +274,48 @@ int _main(int argc, char* argv[])
         log::info("Get player volume:%d\r\n", new_volume);
         break;
     }
+    case 6:
+    {
+        int seconds = 5, period_size = 256, period_count = 4;
+        int sample_rate = 48000;
+        if (argc > 2) seconds = atoi(argv[2]);
+        if (argc > 3) period_size = atoi(argv[3]);
+        if (argc > 4) period_count = atoi(argv[4]);
+
+        audio::Player p = audio::Player("", sample_rate, audio::Format::FMT_S16_LE, 1);
+        audio::Recorder r = audio::Recorder("", sample_rate, audio::Format::FMT_S16_LE, 1, false);
+        log::info("player period size:%d count:%d", p.period_size(period_size), p.period_count(period_count));
+        log::info("recorder period size:%d count:%d", r.period_size(period_size), r.period_count(period_count));
+        r.reset(true);
+
+        int chunk_frames = sample_rate / 100;  // 10ms
+        Bytes tone(nullptr, chunk_frames * 2);
+        int16_t *samples = (int16_t *)tone.data;
+        uint64_t phase = 0, recorded = 0;
+        uint64_t t = time::ticks_ms();
+        while (!app::need_exit() && time::ticks_ms() - t < (uint64_t)seconds * 1000) {
+            for (int i = 0; i < chunk_frames; i ++, phase ++) {
+                samples[i] = (int16_t)(16000 * sin(2 * M_PI * 1000 * phase / sample_rate));
+            }
+            p.play(&tone);
+            Bytes *data = r.record();   // non-block, return what captured
+            int16_t *in = (int16_t *)data->data;
+            int peak = 0;
+            for (size_t i = 0; i < data->data_len / 2; i ++) {
+                peak = abs(in[i]) > peak ? abs(in[i]) : peak;
+            }
+            recorded += data->data_len / 2;
+            if (data->data_len > 0 && phase % sample_rate < (uint64_t)chunk_frames)
+                log::info("played %llu frames, recorded %llu frames, peak %d", phase, recorded, peak);
+            delete data;
+        }
+        break;
+    }
     default:
         helper();
         return 0;
     }
 
-#endif // PLATFORM_MAIXCAM || PLATFORM_MAIXCAM2
     return 0;
 }
 
@@ -0,0 +1,140 @@
+
+#include "maix_basic.hpp"
+#include "main.h"
+#include "maix_modbus.hpp"
+#include <atomic>   // std::atomic
+#include <thread>   // std::thread
+#include <vector>   // std::vector
+
+using namespace maix;
+using namespace maix::comm;
+
+/* slave cfg */
+constexpr uint32_t REGISTERS_START_ADDRESS = 0x00;
+constexpr uint32_t REGISTERS_NUMBER = 32;
+constexpr int TCP_PORT = 5020;
+
+/* master cfg */
+constexpr int MASTER_NUMBER = 4;
+
+static std::atomic<uint64_t> g_requests{0};
+static std::atomic<uint64_t> g_errors{0};
+static std::atomic<uint64_t> g_writes{0};
+
+// input register 0 and 1 are high and low 16 bits of a counter, register 2 is a copy of low 16 bits,
+// all of them are updated in one commit, so masters should always read them consistently.
+void app_update_thread(modbus::SlaveTCP& slave)
+{
+    uint32_t counter = 0;
+    while (!app::need_exit()) {
+        ++counter;
+        slave.update([counter](modbus::RegisterMap& regs) {
+            regs.input_registers[0] = counter >> 16;
+            regs.input_registers[1] = counter & 0xFFFF;
+            regs.input_registers[2] = counter & 0xFFFF;
+        });
+        time::sleep_us(100);
+    }
+}
+
+void master_thread(int id)
+{
+    modbus_t* ctx = ::modbus_new_tcp("127.0.0.1", TCP_PORT);
+    if (ctx == nullptr || ::modbus_connect(ctx) < 0) {
+        log::error("master %d connect failed: %s", id, ::modbus_strerror(errno));
+        if (ctx)
+            ::modbus_free(ctx);
+        return;
+    }
+
+    uint16_t regs[REGISTERS_NUMBER];
+    uint16_t value = 0;
+    while (!app::need_exit()) {
+        // every master writes its own holding register, and reads it back
+        ++value;
+        if (::modbus_write_register(ctx, REGISTERS_START_ADDRESS + id, value) < 0
+            || ::modbus_read_registers(ctx, REGISTERS_START_ADDRESS + id, 1, regs) < 0
+            || regs[0] != value) {
+            g_errors++;
+        }
+        if (::modbus_read_input_registers(ctx, REGISTERS_START_ADDRESS, REGISTERS_NUMBER, regs) < 0
+            || regs[1] != regs[2]) {
+            g_errors++;
+        }
+        g_requests += 3;
+    }
+
+    ::modbus_close(ctx);
+    ::modbus_free(ctx);
+}
+
+// scan list master, poll counter every 100ms and all holding registers every 500ms in background,
+// ranges are merged into as few requests as possible and pipelined on one connection.
+void scanner_thread()
+{
+    modbus::Scanner scanner(modbus::Mode::TCP, "127.0.0.1", TCP_PORT, 1000);
+    scanner.add(1, modbus::RequestType::READ_INPUT_REGISTERS, REGISTERS_START_ADDRESS, 2, 100);
+    scanner.add(1, modbus::RequestType::READ_INPUT_REGISTERS, REGISTERS_START_ADDRESS + 2, 1, 100);
+    scanner.add(1, modbus::RequestType::READ_HOLDING_REGISTERS, REGISTERS_START_ADDRESS, REGISTERS_NUMBER, 500);
+    log::info("scanner requests: %d", scanner.request_num());
+    scanner.start();
+
+    while (!app::need_exit()) {
+        time::sleep_ms(1000);
+        uint32_t counter = 0;
+        uint64_t timestamp_us = 0;
+        if (scanner.get(1, modbus::RequestType::READ_INPUT_REGISTERS, REGISTERS_START_ADDRESS, counter, false, &timestamp_us) != err::Err::ERR_NONE)
+            continue;
+        auto stats = scanner.stats();
+        log::info("scanner counter: %u, age: %llu ms, requests: %llu, failed: %llu", counter,
+            (unsigned long long)((time::ticks_us() - timestamp_us) / 1000),
+            (unsigned long long)stats.first, (unsigned long long)stats.second);
+    }
+}
+
+int _main(int argc, char* argv[])
+{
+    modbus::Registers cfg;
+    cfg.holding_registers.start_address = REGISTERS_START_ADDRESS;
+    cfg.holding_registers.size          = REGISTERS_NUMBER;
+    cfg.input_registers.start_address   = REGISTERS_START_ADDRESS;
+    cfg.input_registers.size            = REGISTERS_NUMBER;
+
+    modbus::SlaveTCP slave(cfg, TCP_PORT, "", MASTER_NUMBER + 1);
+    slave.set_write_callback([](modbus::RequestType type, uint32_t addr, uint32_t size) {
+        // called in slave event loop thread, keep it short
+        g_writes += size;
+    });
+
+    std::thread update_th(app_update_thread, std::ref(slave));
+    time::sleep_ms(100);
+    std::vector<std::thread> masters;
+    for (int i = 0; i < MASTER_NUMBER; ++i)
+        masters.emplace_back(master_thread, i);
+    masters.emplace_back(scanner_thread);
+
+    uint64_t last = 0;
+    while (!app::need_exit()) {
+        time::sleep(1);
+        uint64_t curr = g_requests.load();
+        log::info("clients: %d, requests: %llu/s, written registers: %llu, errors: %llu", slave.client_num(),
+            (unsigned long long)(curr - last), (unsigned long long)g_writes.load(), (unsigned long long)g_errors.load());
+        last = curr;
+    }
+
+    for (auto& th : masters)
+        th.join();
+    update_th.join();
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,142 @@
+
+#include "maix_basic.hpp"
+#include "maix_uart.hpp"
+#include "main.h"
+#include <atomic>
+#include <memory>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace maix;
+using namespace maix::peripheral;
+
+struct Port
+{
+    int master = -1;
+    std::string path;
+    std::unique_ptr<uart::UART> serial;
+    uint8_t expect = 0;
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+static int open_pty(std::string &path)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+    if (grantpt(fd) < 0 || unlockpt(fd) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    path = ptsname(fd);
+    return fd;
+}
+
+int _main(int argc, char* argv[])
+{
+    int num = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 5;
+
+    std::vector<std::unique_ptr<Port>> ports;
+    for (int i = 0; i < num; ++i)
+    {
+        std::unique_ptr<Port> p(new Port());
+        p->master = open_pty(p->path);
+        if (p->master < 0)
+        {
+            log::error("open pty failed");
+            return -1;
+        }
+        p->serial.reset(new uart::UART(p->path, 115200));
+        Port *port = p.get();
+        // data wraps reactor's receive buffer, no allocation every time
+        p->serial->set_received_callback([port](uart::UART &serial, Bytes &data) {
+            for (size_t i = 0; i < data.data_len; ++i)
+            {
+                if (data.data[i] != port->expect)
+                {
+                    port->errors += 1;
+                    port->expect = data.data[i];
+                }
+                ++port->expect;
+            }
+            port->received += data.data_len;
+        });
+        log::info("uart %d: %s\n", i, p->path.c_str());
+        ports.push_back(std::move(p));
+    }
+
+    uint64_t last_total = 0;
+    int timer = io::Reactor::global().add_timer(1000, [&ports, &last_total]() {
+        uint64_t total = 0, errors = 0;
+        for (auto &p : ports)
+        {
+            total += p->received;
+            errors += p->errors;
+        }
+        log::info("received %.1f KB/s, errors: %llu, reactor fds: %d\n",
+                  (total - last_total) / 1024.0, (unsigned long long)errors, io::Reactor::global().size());
+        last_total = total;
+    });
+
+    // send sequenced data from master side of every pty
+    std::vector<uint8_t> seq(num, 0);
+    uint8_t buff[256];
+    uint64_t sent = 0;
+    uint64_t t = time::ticks_ms();
+    while (!app::need_exit() && time::ticks_ms() - t < (uint64_t)seconds * 1000)
+    {
+        std::vector<struct pollfd> fds(num);
+        for (int i = 0; i < num; ++i)
+        {
+            fds[i].fd = ports[i]->master;
+            fds[i].events = POLLOUT;
+        }
+        if (poll(fds.data(), num, 100) <= 0)
+            continue;
+        for (int i = 0; i < num; ++i)
+        {
+            if (!(fds[i].revents & POLLOUT))
+                continue;
+            for (size_t j = 0; j < sizeof(buff); ++j)
+                buff[j] = seq[i] + j;
+            int len = write(ports[i]->master, buff, sizeof(buff));
+            if (len > 0)
+            {
+                seq[i] += len;
+                sent += len;
+            }
+        }
+    }
+    time::sleep_ms(200);
+    io::Reactor::global().remove_timer(timer);
+
+    uint64_t total = 0, errors = 0;
+    for (auto &p : ports)
+    {
+        total += p->received;
+        errors += p->errors;
+    }
+    log::info("sent %llu, received %llu, errors %llu\n", (unsigned long long)sent, (unsigned long long)total, (unsigned long long)errors);
+    for (auto &p : ports)
+    {
+        p->serial->close();
+        close(p->master);
+    }
+    log::info("reactor fds after close: %d\n", io::Reactor::global().size());
+    return (total == sent && errors == 0) ? 0 : -1;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,199 @@
+
+#include "maix_basic.hpp"
+#include "main.h"
+#include "maix_http_server.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace maix;
+
+static const char *index_html =
+"<html>\n"
+"<body>\n"
+"<h1>MaixCDK HTTP Server</h1>\n"
+"<p><a href='/api/time'>/api/time</a></p>\n"
+"<p><a href='/api/counter'>/api/counter</a> chunked stream</p>\n"
+"</body>\n"
+"</html>";
+
+static void add_routes(http::Server &server)
+{
+    server.get("/", [](const http::Request &req, http::Response &res) {
+        res.set_content(index_html, "text/html");
+    });
+    server.get("/api/time", [](const http::Request &req, http::Response &res) {
+        res.set_content("{\"time_ms\": " + std::to_string(time::time_ms()) + "}", "application/json");
+    });
+    server.get("/api/counter", [](const http::Request &req, http::Response &res) {
+        auto count = std::make_shared<int>(0);
+        res.set_chunked_provider("text/plain", [count](http::Stream &stream) {
+            if (*count >= 10)
+                return false;
+            std::string line = std::to_string((*count)++) + "\n";
+            stream.write((const uint8_t *)line.data(), line.size());
+            time::sleep_ms(100);
+            return true;
+        });
+    });
+    server.post("/api/echo", [](const http::Request &req, http::Response &res) {
+        res.set_content(req.body, req.header("content-type", "application/octet-stream"));
+    });
+    // static bytes body, sent without copy
+    static uint8_t payload[1024];
+    static Bytes payload_bytes(payload, sizeof(payload), false, false);
+    server.get("/bench", [](const http::Request &req, http::Response &res) {
+        res.set_content(&payload_bytes, "application/octet-stream");
+    });
+}
+
+static int connect_to(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    return fd;
+}
+
+// read one response, return false if failed
+static bool read_response(int fd, std::string &buf)
+{
+    char tmp[4096];
+    while (1)
+    {
+        size_t header_end = buf.find("\r\n\r\n");
+        if (header_end != std::string::npos)
+        {
+            size_t pos = buf.find("Content-Length: ");
+            if (pos == std::string::npos || pos > header_end)
+                return false;
+            size_t len = strtoul(buf.c_str() + pos + 16, NULL, 10);
+            if (buf.size() >= header_end + 4 + len)
+            {
+                buf.erase(0, header_end + 4 + len);
+                return true;
+            }
+        }
+        ssize_t n = read(fd, tmp, sizeof(tmp));
+        if (n <= 0)
+            return false;
+        buf.append(tmp, n);
+    }
+}
+
+static int bench(int connections, int seconds)
+{
+    http::Server server("127.0.0.1", 0, 4);
+    add_routes(server);
+    err::check_raise(server.start(), "start http server failed");
+    int port = server.port();
+    log::info("bench server on port %d, %d connections, %d seconds", port, connections, seconds);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::vector<uint32_t>> latencies(connections);
+    std::vector<std::thread> threads;
+    std::atomic<int> errors(0);
+    for (int i = 0; i < connections; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            int fd = connect_to(port);
+            if (fd < 0)
+            {
+                errors++;
+                return;
+            }
+            const char *req = "GET /bench HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+            size_t req_len = strlen(req);
+            std::string buf;
+            while (!stop)
+            {
+                uint64_t t = time::ticks_us();
+                if (write(fd, req, req_len) != (ssize_t)req_len || !read_response(fd, buf))
+                {
+                    // server closes connection after max keep-alive requests, reconnect
+                    close(fd);
+                    buf.clear();
+                    fd = connect_to(port);
+                    if (fd < 0)
+                    {
+                        errors++;
+                        return;
+                    }
+                    continue;
+                }
+                latencies[i].push_back((uint32_t)(time::ticks_us() - t));
+            }
+            close(fd);
+        });
+    }
+    time::sleep(seconds);
+    stop = true;
+    for (auto &t : threads)
+        t.join();
+    server.stop();
+
+    std::vector<uint32_t> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    if (all.empty())
+    {
+        log::error("no request finished, errors: %d", errors.load());
+        return -1;
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[std::min(all.size() - 1, (size_t)(all.size() * p))]; };
+    log::info("requests: %zu, errors: %d, %.1f req/s", all.size(), errors.load(), all.size() / (double)seconds);
+    log::info("latency us: p50 %u, p90 %u, p99 %u, max %u", pct(0.5), pct(0.9), pct(0.99), all.back());
+    return 0;
+}
+
+int _main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+        int connections = argc > 2 ? atoi(argv[2]) : 8;
+        int seconds = argc > 3 ? atoi(argv[3]) : 5;
+        return bench(connections, seconds);
+    }
+
+    http::Server server("", 8080, 4);
+    add_routes(server);
+    if (fs::isdir("/maixapp/share"))
+        server.mount("/share", "/maixapp/share");
+    err::check_raise(server.start(), "start http server failed");
+    log::info("http server started on port %d", server.port());
+    while (!app::need_exit())
+    {
+        time::sleep_ms(100);
+    }
+    server.stop();
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
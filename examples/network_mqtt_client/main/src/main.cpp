@@ -0,0 +1,366 @@
+
+#include "maix_basic.hpp"
+#include "main.h"
+#include "maix_mqtt_client.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <poll.h>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <algorithm>
+
+using namespace maix;
+using namespace maix::network;
+
+/**
+ * Minimal broker stand-in for testing, accepts one connection at a time,
+ * acks CONNECT, SUBSCRIBE, PINGREQ and QoS1 PUBLISH, records received payloads.
+ * Payload format: 8 bytes publish time(ticks_us) + 4 bytes sequence number.
+ */
+class LocalBroker
+{
+public:
+    LocalBroker()
+        : drop_after(0), _listen_fd(-1), _port(0), _running(false)
+    {
+    }
+
+    ~LocalBroker()
+    {
+        stop();
+    }
+
+    int start(int port = 0)
+    {
+        _listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(_listen_fd, 4) < 0)
+        {
+            close(_listen_fd);
+            return -1;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(_listen_fd, (struct sockaddr *)&addr, &len);
+        _port = ntohs(addr.sin_port);
+        _running = true;
+        _thread = std::thread(&LocalBroker::_loop, this);
+        return _port;
+    }
+
+    void stop()
+    {
+        if (!_running)
+            return;
+        _running = false;
+        _thread.join();
+        close(_listen_fd);
+    }
+
+    size_t received()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _latencies.size();
+    }
+
+    size_t unique()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _seqs.size();
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _latencies.clear();
+        _seqs.clear();
+    }
+
+    void print_latency(const char *name)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_latencies.empty())
+            return;
+        std::vector<uint32_t> l = _latencies;
+        std::sort(l.begin(), l.end());
+        auto pct = [&](double p) { return l[std::min(l.size() - 1, (size_t)(l.size() * p))]; };
+        log::info("[%s] latency us: p50 %u, p90 %u, p99 %u, max %u", name, pct(0.5), pct(0.9), pct(0.99), l.back());
+    }
+
+    int drop_after; // close connection after received this number of publish, 0 to disable
+
+private:
+    int _listen_fd;
+    int _port;
+    std::atomic<bool> _running;
+    std::thread _thread;
+    std::mutex _lock;
+    std::vector<uint32_t> _latencies;
+    std::set<uint32_t> _seqs;
+
+    void _loop()
+    {
+        while (_running)
+        {
+            struct pollfd pfd = {_listen_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 100) <= 0)
+                continue;
+            int fd = accept(_listen_fd, NULL, NULL);
+            if (fd < 0)
+                continue;
+            _serve(fd);
+            close(fd);
+        }
+    }
+
+    void _serve(int fd)
+    {
+        std::string in;
+        char buf[16384];
+        int count = 0;
+        while (_running)
+        {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 100) <= 0)
+                continue;
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0)
+                return;
+            in.append(buf, n);
+            std::string out;
+            size_t pos = 0;
+            while (in.size() - pos >= 2)
+            {
+                const uint8_t *p = (const uint8_t *)in.data() + pos;
+                size_t remaining = 0, i = 1;
+                int shift = 0;
+                while (i < in.size() - pos && (p[i] & 0x80))
+                {
+                    remaining |= (size_t)(p[i] & 0x7f) << shift;
+                    shift += 7;
+                    ++i;
+                }
+                if (i >= in.size() - pos)
+                    break;
+                remaining |= (size_t)(p[i] & 0x7f) << shift;
+                ++i;
+                if (in.size() - pos < i + remaining)
+                    break;
+                const uint8_t *body = p + i;
+                uint8_t type = p[0] >> 4;
+                if (type == 1) // CONNECT
+                    out.append("\x20\x02\x00\x00", 4);
+                else if (type == 8) // SUBSCRIBE
+                {
+                    out.append("\x90\x03", 2);
+                    out.append((const char *)body, 2);
+                    out.push_back(0);
+                }
+                else if (type == 12) // PINGREQ
+                    out.append("\xd0\x00", 2);
+                else if (type == 3) // PUBLISH
+                {
+                    uint8_t qos = (p[0] >> 1) & 3;
+                    uint16_t topic_len = (body[0] << 8) | body[1];
+                    const uint8_t *payload = body + 2 + topic_len + (qos ? 2 : 0);
+                    if (qos)
+                    {
+                        out.append("\x40\x02", 2);
+                        out.append((const char *)body + 2 + topic_len, 2);
+                    }
+                    uint64_t t;
+                    uint32_t seq;
+                    memcpy(&t, payload, sizeof(t));
+                    memcpy(&seq, payload + 8, sizeof(seq));
+                    {
+                        std::lock_guard<std::mutex> lock(_lock);
+                        _latencies.push_back((uint32_t)(time::ticks_us() - t));
+                        _seqs.insert(seq);
+                    }
+                    if (drop_after > 0 && ++count >= drop_after)
+                        return; // simulate network broken, acks not sent
+                }
+                pos += i + remaining;
+            }
+            in.erase(0, pos);
+            if (!out.empty() && write(fd, out.data(), out.size()) < 0)
+                return;
+        }
+    }
+};
+
+static void make_payload(uint8_t *payload, uint32_t seq)
+{
+    uint64_t t = time::ticks_us();
+    memcpy(payload, &t, sizeof(t));
+    memcpy(payload + 8, &seq, sizeof(seq));
+}
+
+static void print_stats(const char *name, mqtt::Client &client)
+{
+    mqtt::Stats s = client.stats();
+    log::info("[%s] published: %llu, acked: %llu, coalesced: %llu, dropped: %llu, spooled: %llu, reconnects: %llu, batches: %llu",
+              name, (unsigned long long)s.published, (unsigned long long)s.acked, (unsigned long long)s.coalesced,
+              (unsigned long long)s.dropped, (unsigned long long)s.spooled, (unsigned long long)s.reconnects,
+              (unsigned long long)s.batches);
+}
+
+static bool throughput_test(LocalBroker &broker, int port, int qos, uint32_t count)
+{
+    broker.reset();
+    mqtt::Config cfg;
+    cfg.port = port;
+    cfg.queue_max = 4096;
+    mqtt::Client client(cfg);
+    client.start();
+    uint8_t payload[64] = {0};
+    uint64_t t = time::ticks_us();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        make_payload(payload, i);
+        while (client.publish("maix/bench", payload, sizeof(payload), qos) == err::ERR_BUFF_FULL)
+            time::sleep_us(50);
+    }
+    client.flush(10000);
+    while (broker.received() < count && time::ticks_us() - t < 10000000)
+        time::sleep_ms(1);
+    double s = (time::ticks_us() - t) / 1000000.0;
+    std::string name = "qos" + std::to_string(qos);
+    log::info("[%s] %u messages in %.3fs, %.0f msg/s", name.c_str(), (unsigned)broker.received(), s, broker.received() / s);
+    broker.print_latency(name.c_str());
+    print_stats(name.c_str(), client);
+    return broker.unique() == count;
+}
+
+static bool reconnect_test(LocalBroker &broker, int port, uint32_t count)
+{
+    broker.reset();
+    broker.drop_after = count / 4;
+    mqtt::Config cfg;
+    cfg.port = port;
+    cfg.reconnect_min_ms = 50;
+    mqtt::Client client(cfg);
+    client.start();
+    uint8_t payload[32] = {0};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        make_payload(payload, i);
+        while (client.publish("maix/reconnect", payload, sizeof(payload), 1) == err::ERR_BUFF_FULL)
+            time::sleep_us(50);
+    }
+    err::Err e = client.flush(20000);
+    broker.drop_after = 0;
+    print_stats("reconnect", client);
+    log::info("[reconnect] unique received %zu / %u", broker.unique(), count);
+    return e == err::ERR_NONE && broker.unique() == count;
+}
+
+static bool spool_test(const std::string &spool_path, uint32_t count)
+{
+    // reserve a port then close it, broker not running when publishing
+    LocalBroker broker;
+    int port = broker.start();
+    broker.stop();
+    fs::remove(spool_path);
+
+    mqtt::Config cfg;
+    cfg.port = port;
+    cfg.reconnect_min_ms = 50;
+    cfg.reconnect_max_ms = 200;
+    cfg.queue_max = 16;
+    cfg.spool_path = spool_path;
+    uint8_t payload[32] = {0};
+    {
+        mqtt::Client client(cfg);
+        client.start();
+        for (uint32_t i = 0; i < count / 2; ++i)
+        {
+            make_payload(payload, i);
+            client.publish("maix/spool", payload, sizeof(payload), 1);
+        }
+        print_stats("spool offline", client);
+        // stop persists queued messages to spool
+    }
+    LocalBroker broker2;
+    if (broker2.start(port) < 0)
+    {
+        log::error("restart broker on port %d failed", port);
+        return false;
+    }
+    mqtt::Client client(cfg);
+    client.start();
+    for (uint32_t i = count / 2; i < count; ++i)
+    {
+        make_payload(payload, i);
+        client.publish("maix/spool", payload, sizeof(payload), 1);
+    }
+    err::Err e = client.flush(10000);
+    print_stats("spool online", client);
+    log::info("[spool] unique received %zu / %u", broker2.unique(), count);
+    return e == err::ERR_NONE && broker2.unique() == count;
+}
+
+static int run_local_tests()
+{
+    LocalBroker broker;
+    int port = broker.start();
+    if (port < 0)
+    {
+        log::error("start local broker failed");
+        return -1;
+    }
+    log::info("local broker on port %d", port);
+    bool ok = true;
+    ok &= throughput_test(broker, port, 0, 50000);
+    ok &= throughput_test(broker, port, 1, 50000);
+    ok &= reconnect_test(broker, port, 2000);
+    broker.stop();
+    ok &= spool_test("/tmp/maix_mqtt_spool.bin", 2000);
+    log::info("mqtt tests %s", ok ? "passed" : "failed");
+    return ok ? 0 : -1;
+}
+
+int _main(int argc, char* argv[])
+{
+    if (argc < 2)
+        return run_local_tests();
+
+    mqtt::Config cfg;
+    cfg.host = argv[1];
+    cfg.port = argc > 2 ? atoi(argv[2]) : 1883;
+    cfg.coalesce = true;
+    cfg.spool_path = "/tmp/maix_mqtt_spool.bin";
+    mqtt::Client client(cfg);
+    client.subscribe("maix/cmd/#", 1, [](const std::string &topic, const std::string &payload) {
+        log::info("recv %s: %s", topic.c_str(), payload.c_str());
+    });
+    client.start();
+    while (!app::need_exit())
+    {
+        std::string msg = "{\"time\": " + std::to_string(time::time_ms()) + "}";
+        client.publish("maix/telemetry", msg, 1);
+        time::sleep(1);
+    }
+    client.stop();
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
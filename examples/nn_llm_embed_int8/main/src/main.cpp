@@ -0,0 +1,133 @@
+
+#include "maix_basic.hpp"
+#include "maix_llm_qwen.hpp"
+#include "main.h"
+#include <fstream>
+#include <random>
+#include <cmath>
+#include <cstring>
+
+using namespace maix;
+
+static uint16_t float_to_bf16(float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return (uint16_t)(bits >> 16);
+}
+
+static float bf16_to_float(uint16_t v)
+{
+    uint32_t bits = (uint32_t)v << 16;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open())
+        return false;
+    data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int _main(int argc, char* argv[])
+{
+    std::string bf16_path = argc > 1 ? argv[1] : "/tmp/embed_test.bf16";
+    int token_num = argc > 2 ? atoi(argv[2]) : 1000;
+    int embed_size = argc > 3 ? atoi(argv[3]) : 896;
+
+    // no table given, generate random bf16 table, row 0 all zero
+    if (argc < 2)
+    {
+        std::mt19937 rng(0);
+        std::normal_distribution<float> dist(0, 0.05f);
+        std::vector<uint16_t> rows((size_t)token_num * embed_size);
+        for (size_t i = embed_size; i < rows.size(); i++)
+            rows[i] = float_to_bf16(dist(rng));
+        std::ofstream f(bf16_path, std::ios::binary);
+        f.write((const char *)rows.data(), rows.size() * sizeof(uint16_t));
+        if (!f)
+        {
+            log::error("write %s failed", bf16_path.c_str());
+            return -1;
+        }
+        remove((bf16_path + ".int8").c_str());
+    }
+
+    uint64_t t = time::ticks_ms();
+    err::Err e = nn::Qwen::convert_embed_int8(bf16_path, token_num, embed_size);
+    if (e == err::ERR_NOT_IMPL)
+    {
+        log::warn("convert_embed_int8 not support on this platform");
+        return 0;
+    }
+    if (e != err::ERR_NONE)
+    {
+        log::error("convert %s failed: %s", bf16_path.c_str(), err::to_str(e).c_str());
+        return -1;
+    }
+    log::info("convert %s cost %llu ms", bf16_path.c_str(), (unsigned long long)(time::ticks_ms() - t));
+
+    // table exists and up to date, not convert again
+    t = time::ticks_ms();
+    e = nn::Qwen::convert_embed_int8(bf16_path, token_num, embed_size);
+    log::info("convert again: %s, cost %llu ms", err::to_str(e).c_str(), (unsigned long long)(time::ticks_ms() - t));
+
+    std::vector<uint8_t> bf16, int8;
+    if (!read_file(bf16_path, bf16) || !read_file(bf16_path + ".int8", int8))
+    {
+        log::error("read table failed");
+        return -1;
+    }
+    size_t int8_size = (size_t)token_num * (embed_size + sizeof(float));
+    if (int8.size() != int8_size)
+    {
+        log::error("int8 table size %d, should be %d", (int)int8.size(), (int)int8_size);
+        return -1;
+    }
+    log::info("bf16 table %d bytes, int8 table %d bytes", (int)bf16.size(), (int)int8.size());
+
+    // int8 table: token_num float row scales, then token_num * embed_size int8 rows,
+    // dequantized value error should <= scale / 2 plus bf16 rounding error
+    const uint16_t *src = (const uint16_t *)bf16.data();
+    const float *scales = (const float *)int8.data();
+    const int8_t *q = (const int8_t *)(int8.data() + (size_t)token_num * sizeof(float));
+    float max_err = 0;
+    int bad = 0;
+    for (int k = 0; k < token_num; k++)
+    {
+        for (int i = 0; i < embed_size; i++)
+        {
+            size_t idx = (size_t)k * embed_size + i;
+            float v = bf16_to_float(src[idx]);
+            float d = bf16_to_float(float_to_bf16(q[idx] * scales[k]));
+            float diff = fabsf(d - v);
+            max_err = fmaxf(max_err, diff);
+            if (diff > scales[k] * 0.5f + fabsf(v) / 128 + 1e-6f)
+                ++bad;
+        }
+    }
+    log::info("max error %f, %d values out of bound", max_err, bad);
+    if (bad)
+    {
+        log::error("test failed");
+        return -1;
+    }
+    log::info("test pass");
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -1,6 +1,7 @@
 
 #include "maix_basic.hpp"
 #include "maix_nn_melotts.hpp"
+#include "maix_audio.hpp"
 #include "main.h"
 #include "maix_image.hpp"
 using namespace maix;
@@ -12,6 +13,8 @@ int _main(int argc, char *argv[])
     err::Err e;
     std::string help = "Usage: " + std::string(argv[0]) + " <mud_model_path> <text> <wav_path> <language> <output_pcm> <speed> <noise_scale> <noise_scale_w> <sdp_ratio>\n";
     // ./nn_melotts /root/models/melotts/melotts-zh.mud "端侧视觉，快速部署" output.wav zh  0.8 0.3 0.6 0.2 0
+    // set wav_path to `play` to play audio while synthesizing:
+    // ./nn_melotts /root/models/melotts/melotts-zh.mud "端侧视觉，快速部署。多种模型，开箱即用。" play
 
     if (argc < 3)
     {
@@ -46,6 +49,20 @@ int _main(int argc, char *argv[])
 
     log::info("melotts start now");
     auto t = time::ticks_ms();
+    if (wav_path == "play") {
+        audio::Player player("", melotts.samplerate(), audio::Format::FMT_S16_LE, 1);
+        uint64_t first_audio = 0;
+        e = melotts.infer_stream(text, [&](Bytes *pcm) {
+            if (first_audio == 0) {
+                first_audio = time::ticks_ms();
+                log::info("first audio after %d ms", (int)(first_audio - t));
+            }
+            player.play(pcm);
+            return !app::need_exit();
+        });
+        log::info("melotts stream infer finish, ret: %d, cost %d ms", e, (int)(time::ticks_ms() - t));
+        return ret;
+    }
     auto pcm = melotts.infer(text, wav_path, output_pcm);
     auto t2 = time::ticks_ms();
     log::info("melotts infer cost %d ms", t2 - t);
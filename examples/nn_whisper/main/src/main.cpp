@@ -1,6 +1,7 @@
 
 #include "maix_basic.hpp"
 #include "maix_nn_whisper.hpp"
+#include "maix_audio.hpp"
 #include "main.h"
 using namespace maix;
 
@@ -10,7 +11,7 @@ int _main(int argc, char *argv[])
 
     int ret = 0;
     err::Err e;
-    std::string help = "Usage: " + std::string(argv[0]) + " <mud_model_path> <wav_path> [<language>]";
+    std::string help = "Usage: " + std::string(argv[0]) + " <mud_model_path> <wav_path|mic> [<language>]";
 
     if (argc < 2 || !strcmp(argv[1], "--help") || !strcmp(argv[1], "-h"))
     {
@@ -31,7 +32,26 @@ int _main(int argc, char *argv[])
     err::check_raise(e, "load model failed");
     log::info("load whisper model %s success", model_path);
 
-    if (argc >= 3)
+    if (argc >= 3 && !strcmp(argv[2], "mic"))
+    {
+        // stream from microphone, text of each utterance is printed after speaking
+        audio::Recorder r("", whisper.input_pcm_samplerate(), audio::Format::FMT_S16_LE, 1, true);
+        e = whisper.stream_start([](std::string text, bool is_final) {
+            log::info("whisper %s: %s", is_final ? "result" : "partial", text.c_str());
+        }, whisper.input_pcm_samplerate(), 1, 16);
+        err::check_raise(e, "start stream failed");
+        log::info("speak now, press Ctrl+C to exit");
+        while (!app::need_exit())
+        {
+            Bytes *data = r.record(100);
+            if (!data)
+                continue;
+            whisper.stream_feed(data);
+            delete data;
+        }
+        whisper.stream_stop();
+    }
+    else if (argc >= 3)
     {
         std::string wav_path = argv[2];
         log::info("start converting now");
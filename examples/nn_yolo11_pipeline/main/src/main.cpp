@@ -0,0 +1,86 @@
+
+#include "maix_basic.hpp"
+#include "maix_vision.hpp"
+#include "maix_nn_yolo11.hpp"
+#include "maix_jpg_stream.hpp"
+#include "maix_pipeline_graph.hpp"
+#include "main.h"
+
+using namespace maix;
+
+int _main(int argc, char *argv[])
+{
+    log::info("Program start");
+    std::string help = "Usage: " + std::string(argv[0]) + " mud_model_path [jpeg_stream_port]";
+
+    if (argc < 2)
+    {
+        log::info(help.c_str());
+        return -1;
+    }
+
+    const char *model_path = argv[1];
+    int stream_port = argc >= 3 ? atoi(argv[2]) : 0;
+    float conf_threshold = 0.5;
+    float iou_threshold = 0.45;
+
+    // stages run in their own threads already, so NN dual_buff is not needed
+    nn::YOLO11 detector("", false);
+    err::Err e = detector.load(model_path);
+    err::check_raise(e, "load model failed");
+    log::info("load yolo11 model %s success", model_path);
+
+    maix::image::Size input_size = detector.input_size();
+    camera::Camera cam = camera::Camera(input_size.width(), input_size.height(), detector.input_format());
+    display::Display disp = display::Display();
+    http::JpegStreamer *streamer = nullptr;
+    if (stream_port > 0)
+    {
+        streamer = new http::JpegStreamer("", stream_port);
+        err::check_raise(streamer->start(), "start jpeg streamer failed");
+        log::info("jpeg stream at http://%s:%d/stream", streamer->host().c_str(), stream_port);
+    }
+
+    pipeline::Graph graph("yolo11");
+    graph.source("camera", pipeline::camera_source(cam))
+        // camera always gets the newest frame, detect the latest one and drop old frames
+        .stage("detect", [&](pipeline::Packet &p) {
+            p.set(detector.detect(*p.img, conf_threshold, iou_threshold));
+            return true;
+        }, 1, pipeline::DropPolicy::LATEST)
+        .stage("draw", [&](pipeline::Packet &p) {
+            nn::Objects *result = p.get<nn::Objects>();
+            for (auto &r : *result)
+            {
+                p.img->draw_rect(r->x, r->y, r->w, r->h, maix::image::Color::from_rgb(255, 0, 0));
+                p.img->draw_string(r->x, r->y, detector.labels[r->class_id], maix::image::Color::from_rgb(255, 0, 0));
+            }
+            return true;
+        })
+        .sink("display", pipeline::display_sink(disp), 1, pipeline::DropPolicy::LATEST);
+    if (streamer)
+        graph.sink("stream", pipeline::jpeg_streamer_sink(*streamer), 1, pipeline::DropPolicy::LATEST);
+    err::check_raise(graph.start(), "start pipeline failed");
+
+    while (!graph.wait(5000))
+    {
+        log::info("pipeline stats:\n%s", graph.stats_str().c_str());
+    }
+    graph.stop();
+    delete streamer;
+
+    log::info("Program exit");
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch SIGINT signal(e.g. Ctrl + C), and set exit flag to true.
+    signal(SIGINT, [](int sig)
+           { app::set_exit_flag(true); });
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,90 @@
+
+#include "maix_basic.hpp"
+#include "maix_gpio.hpp"
+#include "main.h"
+#include <atomic>
+#include <fstream>
+
+using namespace maix;
+using namespace maix::peripheral;
+
+static int sim_pulses(const std::string &pull_path, int pulses, gpio::GPIO &pin)
+{
+    std::atomic<int> rising{0}, falling{0}, errors{0};
+    std::atomic<uint32_t> last_seq{0};
+    err::Err e = pin.enable_events(gpio::Edge::EDGE_BOTH, 0, [&](gpio::GPIO &, const gpio::Event &ev) {
+        if (ev.seqno != last_seq + 1)
+            errors += 1;
+        last_seq = ev.seqno;
+        if (ev.edge == gpio::Edge::EDGE_RISING)
+            rising += 1;
+        else
+            falling += 1;
+    });
+    if (e != err::ERR_NONE)
+    {
+        log::error("enable events failed: %s\n", err::to_str(e).c_str());
+        return -1;
+    }
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < pulses && !app::need_exit(); ++i)
+    {
+        std::ofstream(pull_path) << "pull-up";
+        std::ofstream(pull_path) << "pull-down";
+    }
+    time::sleep_ms(200);
+    uint64_t cost = time::ticks_us() - t;
+    log::info("pulses %d, rising %d, falling %d, seq errors %d, %.1f us per pulse\n",
+              pulses, rising.load(), falling.load(), errors.load(), (float)cost / pulses);
+    pin.disable_events();
+    return (rising == pulses && falling == pulses && errors == 0) ? 0 : -1;
+}
+
+int _main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        log::info("usage: %s <pin> [debounce_us] [sim_pull_path] [pulses]\n", argv[0]);
+        return -1;
+    }
+    std::string pin_name = argv[1];
+    int debounce_us = argc > 2 ? atoi(argv[2]) : 0;
+    gpio::GPIO pin(pin_name, gpio::Mode::IN, gpio::Pull::PULL_NONE);
+
+    if (argc > 3)
+        return sim_pulses(argv[3], argc > 4 ? atoi(argv[4]) : 1000, pin);
+
+    // queue mode, read events in main thread
+    err::Err e = pin.enable_events(gpio::Edge::EDGE_BOTH, debounce_us);
+    if (e != err::ERR_NONE)
+    {
+        log::error("enable events failed: %s\n", err::to_str(e).c_str());
+        return -1;
+    }
+    uint64_t last_ns = 0;
+    while (!app::need_exit())
+    {
+        std::vector<gpio::Event> events = pin.read_events(1000);
+        for (auto &ev : events)
+        {
+            log::info("%s seq %u, %.3f ms since last edge, value now %d\n",
+                      ev.edge == gpio::Edge::EDGE_RISING ? "rising " : "falling", ev.seqno,
+                      last_ns ? (ev.timestamp_ns - last_ns) / 1e6 : 0.0, pin.value());
+            last_ns = ev.timestamp_ns;
+        }
+        if (pin.events_dropped())
+            log::warn("dropped events: %llu\n", (unsigned long long)pin.events_dropped());
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,124 @@
+
+#include "maix_basic.hpp"
+#include "maix_i2c.hpp"
+#include "main.h"
+
+using namespace maix;
+using namespace maix::peripheral;
+
+#define REG_NUM 16
+
+static int check(const char *name, const uint8_t *data, const uint8_t *expect, int len)
+{
+    for (int i = 0; i < len; ++i)
+    {
+        if (data[i] != expect[i])
+        {
+            log::error("%s: data[%d] 0x%02x != 0x%02x\n", name, i, data[i], expect[i]);
+            return -1;
+        }
+    }
+    log::info("%s: ok\n", name);
+    return 0;
+}
+
+int _main(int argc, char* argv[])
+{
+    int bus = argc > 1 ? atoi(argv[1]) : 1;
+    int addr = argc > 2 ? strtol(argv[2], NULL, 0) : 0x50;
+    int loops = argc > 3 ? atoi(argv[3]) : 200;
+
+    i2c::I2C dev(bus, i2c::Mode::MASTER);
+
+    // write test pattern byte by byte, works on EEPROM and i2c-stub
+    uint8_t expect[REG_NUM];
+    for (int i = 0; i < REG_NUM; ++i)
+    {
+        expect[i] = (uint8_t)(0xA0 + i * 3);
+        if (dev.writeto_mem(addr, i, &expect[i], 1) < 0)
+        {
+            log::error("write reg 0x%02x failed\n", i);
+            return -1;
+        }
+        time::sleep_ms(5); // EEPROM write cycle
+    }
+
+    int ret = 0;
+    uint8_t buff[REG_NUM];
+
+    // one register block read with repeated start
+    memset(buff, 0, sizeof(buff));
+    if (dev.readfrom_mem_into(addr, 0, buff, REG_NUM) != REG_NUM)
+    {
+        log::error("readfrom_mem_into failed\n");
+        return -1;
+    }
+    ret |= check("readfrom_mem_into", buff, expect, REG_NUM);
+
+    // batch of discontinuous registers in one call
+    uint8_t a[2], b[3], c[1];
+    i2c::MemRead reads[] = {{1, a, 2}, {6, b, 3}, {15, c, 1}};
+    if (dev.readfrom_mems(addr, reads, 3) != 3)
+    {
+        log::error("readfrom_mems failed\n");
+        return -1;
+    }
+    ret |= check("readfrom_mems 0", a, expect + 1, 2);
+    ret |= check("readfrom_mems 1", b, expect + 6, 3);
+    ret |= check("readfrom_mems 2", c, expect + 15, 1);
+
+    // raw messages, write register address then read
+    uint8_t reg = 4;
+    uint8_t d[4];
+    i2c::Msg msgs[] = {{addr, false, &reg, 1}, {addr, true, d, 4}};
+    if (dev.transfer(msgs, 2) != 2)
+    {
+        log::error("transfer failed\n");
+        return -1;
+    }
+    ret |= check("transfer", d, expect + 4, 4);
+
+    // benchmark, read all registers one by one
+    uint64_t t = time::ticks_us();
+    for (int n = 0; n < loops && !app::need_exit(); ++n)
+    {
+        for (int i = 0; i < REG_NUM; ++i)
+        {
+            Bytes *data = dev.readfrom_mem(addr, i, 1);
+            if (!data)
+                return -1;
+            buff[i] = data->data[0];
+            delete data;
+        }
+    }
+    uint64_t t_old = time::ticks_us() - t;
+    ret |= check("readfrom_mem", buff, expect, REG_NUM);
+
+    i2c::MemRead all[REG_NUM];
+    for (int i = 0; i < REG_NUM; ++i)
+        all[i] = {i, &buff[i], 1};
+    memset(buff, 0, sizeof(buff));
+    t = time::ticks_us();
+    for (int n = 0; n < loops && !app::need_exit(); ++n)
+    {
+        if (dev.readfrom_mems(addr, all, REG_NUM) != REG_NUM)
+            return -1;
+    }
+    uint64_t t_new = time::ticks_us() - t;
+    ret |= check("readfrom_mems all", buff, expect, REG_NUM);
+
+    log::info("%d registers x %d loops, readfrom_mem: %llu us, readfrom_mems: %llu us\n", REG_NUM, loops,
+              (unsigned long long)t_old, (unsigned long long)t_new);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
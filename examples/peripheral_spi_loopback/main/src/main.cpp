@@ -0,0 +1,155 @@
+
+#include "maix_basic.hpp"
+#include "maix_spi.hpp"
+#include "main.h"
+#include <atomic>
+
+using namespace maix;
+using namespace maix::peripheral;
+
+#define CHUNK_SIZE 4096
+
+static int check(const char *name, const uint8_t *data, const uint8_t *expect, int len)
+{
+    for (int i = 0; i < len; ++i)
+    {
+        if (data[i] != expect[i])
+        {
+            log::error("%s: data[%d] 0x%02x != 0x%02x\n", name, i, data[i], expect[i]);
+            return -1;
+        }
+    }
+    log::info("%s: ok\n", name);
+    return 0;
+}
+
+static void fill(std::vector<uint8_t> &buff, int seed)
+{
+    for (size_t i = 0; i < buff.size(); ++i)
+        buff[i] = (uint8_t)(i * 7 + seed);
+}
+
+int _main(int argc, char* argv[])
+{
+    int bus = argc > 1 ? atoi(argv[1]) : 4;
+    int cs = argc > 2 ? atoi(argv[2]) : 0;
+    int freq = argc > 3 ? atoi(argv[3]) : 10000000;
+    int chunks = argc > 4 ? atoi(argv[4]) : 64;
+    int ret = 0;
+
+    spi::SPI dev(bus, spi::Mode::MASTER, freq, 0, 0, 8, cs);
+
+    // command, address and data segments in one message, command at lower speed, delay after address
+    {
+        uint8_t cmd[1] = {0x0B}, cmd_rx[1];
+        uint8_t addr[3] = {0x12, 0x34, 0x56}, addr_rx[3];
+        std::vector<uint8_t> data(200), expect(200), data_rx(200);
+        fill(data, 1);
+        expect = data;
+        spi::Transfer xfers[3];
+        xfers[0].tx = cmd;
+        xfers[0].rx = cmd_rx;
+        xfers[0].len = 1;
+        xfers[0].speed_hz = freq / 4;
+        xfers[1].tx = addr;
+        xfers[1].rx = addr_rx;
+        xfers[1].len = 3;
+        xfers[1].delay_us = 10;
+        xfers[2].tx = data.data();
+        xfers[2].rx = data_rx.data();
+        xfers[2].len = data.size();
+        int n = dev.transfer(xfers, 3);
+        if (n != 204)
+        {
+            log::error("transfer failed: %d\n", n);
+            return -1;
+        }
+        ret |= check("segment cmd", cmd_rx, cmd, 1);
+        ret |= check("segment addr", addr_rx, addr, 3);
+        ret |= check("segment tx unchanged", data.data(), expect.data(), data.size());
+        ret |= check("segment data", data_rx.data(), expect.data(), data.size());
+    }
+
+    // longer than bufsiz, full duplex in place
+    {
+        std::vector<uint8_t> buff(CHUNK_SIZE * 3 + 100), expect;
+        fill(buff, 3);
+        expect = buff;
+        spi::Transfer t;
+        t.tx = buff.data();
+        t.rx = buff.data();
+        t.len = buff.size();
+        int n = dev.transfer(&t, 1);
+        if (n != (int)buff.size())
+        {
+            log::error("long transfer failed: %d\n", n);
+            return -1;
+        }
+        ret |= check("long in place", buff.data(), expect.data(), buff.size());
+    }
+
+    // push chunks, old API vs async queue
+    std::vector<std::vector<uint8_t>> frame(chunks, std::vector<uint8_t>(CHUNK_SIZE));
+    std::vector<std::vector<uint8_t>> rx(chunks, std::vector<uint8_t>(CHUNK_SIZE));
+    for (int i = 0; i < chunks; ++i)
+        fill(frame[i], i);
+
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < chunks; ++i)
+    {
+        if (dev.write(frame[i]) < 0)
+            return -1;
+    }
+    uint64_t t_old = time::ticks_us() - t;
+
+    std::atomic<int> done{0}, failed{0};
+    t = time::ticks_us();
+    for (int i = 0; i < chunks; ++i)
+    {
+        spi::Transfer x;
+        x.tx = frame[i].data();
+        x.rx = rx[i].data();
+        x.len = CHUNK_SIZE;
+        err::Err e = dev.submit(&x, 1, [&](int n) {
+            if (n != CHUNK_SIZE)
+                ++failed;
+            ++done;
+        });
+        if (e != err::ERR_NONE)
+        {
+            log::error("submit failed: %s\n", err::to_str(e).c_str());
+            return -1;
+        }
+    }
+    uint64_t t_submit = time::ticks_us() - t;
+    dev.wait();
+    uint64_t t_new = time::ticks_us() - t;
+    if (done != chunks || failed != 0)
+    {
+        log::error("async done %d, failed %d\n", (int)done, (int)failed);
+        ret = -1;
+    }
+    for (int i = 0; i < chunks; ++i)
+    {
+        if (memcmp(rx[i].data(), frame[i].data(), CHUNK_SIZE) != 0)
+        {
+            log::error("async chunk %d data error\n", i);
+            ret = -1;
+            break;
+        }
+    }
+    log::info("%d x %d bytes, write: %llu us, submit: %llu us(return after %llu us)\n", chunks, CHUNK_SIZE,
+              (unsigned long long)t_old, (unsigned long long)t_new, (unsigned long long)t_submit);
+    return ret;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,122 @@
+
+#include "maix_basic.hpp"
+#include "maix_protocol.hpp"
+#include "main.h"
+#include <vector>
+
+using namespace maix;
+
+static uint16_t crc16_bitwise(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+    while (len--)
+    {
+        crc ^= *data++;
+        for (int i = 0; i < 8; ++i)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+    }
+    return crc;
+}
+
+static double mb_per_s(size_t bytes, uint64_t us)
+{
+    return us ? bytes / (double)us : 0;
+}
+
+int _main(int argc, char *argv[])
+{
+    const int body_len = argc > 1 ? atoi(argv[1]) : 64;
+    const int frame_num = argc > 2 ? atoi(argv[2]) : 100000;
+    const int chunk_size = 4096;
+
+    // make stream: frames with garbage between some of them
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> frame(body_len + 12);
+    std::vector<uint8_t> body(body_len);
+    uint32_t seed = 1;
+    for (int i = 0; i < frame_num; ++i)
+    {
+        for (int j = 0; j < body_len; ++j)
+        {
+            seed = seed * 1103515245 + 12345;
+            body[j] = seed >> 16;
+        }
+        if (body_len >= 4)
+            memcpy(body.data(), &i, 4);
+        int len = protocol::encode(frame.data(), frame.size(), i % protocol::CMD_APP_MAX, protocol::FLAG_REPORT, body.data(), body_len);
+        stream.insert(stream.end(), frame.begin(), frame.begin() + len);
+        if (i % 16 == 0)
+        {
+            uint8_t garbage[] = {0xAA, 0xCA, 0x00, 0x12};
+            stream.insert(stream.end(), garbage, garbage + sizeof(garbage));
+        }
+    }
+    log::info("body: %d bytes, frames: %d, stream: %.2f MB", body_len, frame_num, stream.size() / 1e6);
+
+    // CRC16
+    uint64_t t = time::ticks_us();
+    uint16_t crc_ref = crc16_bitwise(stream.data(), stream.size());
+    uint64_t t_ref = time::ticks_us() - t;
+    t = time::ticks_us();
+    uint16_t crc = protocol::crc16_IBM(stream.data(), stream.size());
+    uint64_t t_table = time::ticks_us() - t;
+    log::info("crc16 bitwise: %.1f MB/s, slice-by-8: %.1f MB/s, result %s",
+              mb_per_s(stream.size(), t_ref), mb_per_s(stream.size(), t_table), crc == crc_ref ? "match" : "MISMATCH");
+
+    const int buff_size = std::max(chunk_size * 2, body_len * 2 + 64);
+
+    // decode one by one
+    {
+        protocol::Protocol p(buff_size);
+        int count = 0, errors = 0;
+        t = time::ticks_us();
+        for (size_t off = 0; off < stream.size(); off += chunk_size)
+        {
+            int n = std::min((size_t)chunk_size, stream.size() - off);
+            if (p.push_data(stream.data() + off, n) != err::ERR_NONE)
+                ++errors;
+            protocol::MSG *msg;
+            while ((msg = p.decode(nullptr, 0)) != nullptr)
+            {
+                if (msg->body_len != body_len || (body_len >= 4 && memcmp(msg->body, &count, 4) != 0))
+                    ++errors;
+                ++count;
+                delete msg;
+            }
+        }
+        uint64_t us = time::ticks_us() - t;
+        log::info("decode:     %.1f MB/s, %.0f msg/s, messages: %d, errors: %d",
+                  mb_per_s(stream.size(), us), count * 1e6 / us, count, errors);
+    }
+
+    // decode all in one call without copy
+    {
+        protocol::Protocol p(buff_size);
+        int count = 0, errors = 0;
+        t = time::ticks_us();
+        for (size_t off = 0; off < stream.size(); off += chunk_size)
+        {
+            int n = std::min((size_t)chunk_size, stream.size() - off);
+            p.decode_all([&](protocol::MSG &msg) {
+                if (msg.body_len != body_len || (body_len >= 4 && memcmp(msg.body, &count, 4) != 0))
+                    ++errors;
+                ++count;
+            }, stream.data() + off, n);
+        }
+        uint64_t us = time::ticks_us() - t;
+        log::info("decode_all: %.1f MB/s, %.0f msg/s, messages: %d, errors: %d",
+                  mb_per_s(stream.size(), us), count * 1e6 / us, count, errors);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -140,6 +140,8 @@ static int cmd_init(int argc, char* argv[])
     priv.method_list.push_back(image_method_t{"find_lines", test_find_lines});
     priv.method_list.push_back(image_method_t{"tracking line", test_tracking_line});
     priv.method_list.push_back(image_method_t{"find_barcode", test_find_barcode});
+    priv.method_list.push_back(image_method_t{"qrcode_scanner", test_qrcode_scanner});
+    priv.method_list.push_back(image_method_t{"barcode_scanner", test_barcode_scanner});
     priv.method_list.push_back(image_method_t{"to_format", test_to_format});
     priv.method_list.push_back(image_method_t{"draw_image", test_draw_image});
     priv.method_list.push_back(image_method_t{"find_apriltags", test_find_apriltags});
@@ -0,0 +1,34 @@
+#include "test_image.hpp"
+#include "maix_image_scanner.hpp"
+
+int test_qrcode_scanner(image::Image *img) {
+    static image::QRCodeScanner scanner;
+
+    uint64_t t = time::ticks_ms();
+    auto res = scanner.scan(*img);
+    log::info("qrcode scanner use %lld ms, tracked:%d, full searches:%lld", time::ticks_ms() - t, scanner.tracked(), scanner.full_searches());
+    for (auto &i : res)
+    {
+        log::info("qrcode scanner result: %s", i.payload().c_str());
+        std::vector<std::vector<int>> corners = i.corners();
+        for (int i = 0; i < 4; i ++) {
+            img->draw_line(corners[i][0], corners[i][1], corners[(i + 1) % 4][0], corners[(i + 1) % 4][1], maix::image::Color::from_rgb(0, 255, 0), 2);
+        }
+    }
+    return 0;
+}
+
+int test_barcode_scanner(image::Image *img) {
+    static image::BarcodeScanner scanner;
+
+    uint64_t t = time::ticks_ms();
+    auto res = scanner.scan(*img);
+    log::info("barcode scanner use %lld ms, tracked:%d, full searches:%lld", time::ticks_ms() - t, scanner.tracked(), scanner.full_searches());
+    for (auto &i : res)
+    {
+        log::info("barcode scanner result: %s", i.payload().c_str());
+        auto rect = i.rect();
+        img->draw_rect(rect[0], rect[1], rect[2], rect[3], maix::image::Color::from_rgb(255, 0, 0));
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static double run(image::Image &src, int frames)
+{
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < frames && !app::need_exit(); ++i)
+    {
+        image::Image *small = src.resize(640, 360);
+        image::Image *gray = small->to_format(image::FMT_GRAYSCALE);
+        image::Image *roi = src.crop(0, 0, src.width() / 2, src.height() / 2);
+        image::Image *copy = src.copy();
+        delete copy;
+        delete roi;
+        delete gray;
+        delete small;
+    }
+    return (time::ticks_us() - t) / 1000.0 / frames;
+}
+
+int _main(int argc, char* argv[])
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 100;
+    int width = argc > 2 ? atoi(argv[2]) : 1920;
+    int height = argc > 3 ? atoi(argv[3]) : 1080;
+    image::BufferPool &pool = image::BufferPool::global();
+
+    image::Image src(width, height, image::FMT_RGB888, image::COLOR_GRAY);
+
+    // no cache, every image maps and faults new pages
+    pool.trim();
+    pool.set_max_cached(0);
+    pool.reset_stats();
+    double t_no_cache = run(src, frames);
+    log::info("no cache: %.2f ms/frame\n  %s\n", t_no_cache, pool.stats_str().c_str());
+
+    // pre-warm pool for pipeline resolutions
+    pool.set_max_cached(32 * 1024 * 1024);
+    pool.prewarm(width, height, image::FMT_RGB888, 1);
+    pool.prewarm(width / 2, height / 2, image::FMT_RGB888, 1);
+    pool.prewarm(640, 360, image::FMT_RGB888, 1);
+    pool.prewarm(640, 360, image::FMT_GRAYSCALE, 1);
+    pool.reset_stats();
+    double t_pool = run(src, frames);
+    log::info("pool: %.2f ms/frame\n  %s\n", t_pool, pool.stats_str().c_str());
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}
@@ -0,0 +1,80 @@
+
+#include "maix_basic.hpp"
+#include "maix_image.hpp"
+#include "main.h"
+
+using namespace maix;
+
+static double run(image::Image &img, image::Image &templ, int frames, bool share_views)
+{
+    uint64_t t = time::ticks_us();
+    for (int i = 0; i < frames && !app::need_exit(); ++i)
+    {
+        // a new frame, views built for last frame are invalid
+        img.mark_modified();
+        img.find_qrcodes();
+        if (!share_views)
+            img.mark_modified();
+        img.find_apriltags();
+        if (!share_views)
+            img.mark_modified();
+        img.find_line_segments();
+        if (!share_views)
+            img.mark_modified();
+        img.find_template(templ, 0.7, std::vector<int>(), 4, image::SEARCH_EX);
+        if (!share_views)
+            img.mark_modified();
+        img.find_template(templ, 0.7, std::vector<int>(), 2, image::SEARCH_DS);
+    }
+    return (time::ticks_us() - t) / 1000.0 / frames;
+}
+
+int _main(int argc, char* argv[])
+{
+    int frames = argc > 2 ? atoi(argv[2]) : 20;
+    image::Image *img = nullptr;
+    if (argc > 1)
+    {
+        img = image::load(argv[1], image::FMT_RGB888);
+        if (!img)
+        {
+            log::error("load %s failed", argv[1]);
+            return -1;
+        }
+    }
+    else
+    {
+        img = new image::Image(320, 240, image::FMT_RGB888, image::COLOR_WHITE);
+        img->draw_rect(40, 40, 80, 60, image::COLOR_BLACK, -1);
+        img->draw_circle(220, 150, 40, image::COLOR_RED, -1);
+        img->draw_line(0, 239, 319, 0, image::COLOR_BLUE, 3);
+    }
+    image::Image *templ = img->crop(img->width() / 8, img->height() / 8, img->width() / 4, img->height() / 4);
+
+    // views are rebuilt after image modified
+    uint64_t gen = img->generation();
+    image::Image *gray = img->gray_view();
+    log::info("gray view %dx%d, pyramid level 2 %dx%d", gray->width(), gray->height(),
+              img->pyramid_view(2)->width(), img->pyramid_view(2)->height());
+    img->draw_cross(10, 10, image::COLOR_GREEN);
+    log::info("generation %llu -> %llu after draw", (unsigned long long)gen, (unsigned long long)img->generation());
+
+    double t_no_share = run(*img, *templ, frames, false);
+    double t_share = run(*img, *templ, frames, true);
+    log::info("convert every call: %.2f ms/frame, shared views: %.2f ms/frame", t_no_share, t_share);
+
+    delete templ;
+    delete img;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    // Catch signal and process
+    sys::register_default_signal_handle();
+
+    // Use CATCH_EXCEPTION_RUN_RETURN to catch exception,
+    // if we don't catch exception, when program throw exception, the objects will not be destructed.
+    // So we catch exception here to let resources be released(call objects' destructor) before exit.
+    CATCH_EXCEPTION_RUN_RETURN(_main, -1, argc, argv);
+}